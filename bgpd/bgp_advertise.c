@@ -241,6 +241,7 @@ bgp_adj_out_set (struct bgp_node *rn, struct peer *peer, struct prefix *p,
         {
           BGP_ADJ_OUT_ADD (rn, adj);
           bgp_lock_node (rn);
+          bgp_peer_index_add (peer, rn);
         }
     }
 
@@ -351,6 +352,7 @@ bgp_adj_in_set (struct bgp_node *rn, struct peer *peer, struct attr *attr)
   adj->attr = bgp_attr_intern (attr);
   BGP_ADJ_IN_ADD (rn, adj);
   bgp_lock_node (rn);
+  bgp_peer_index_add (peer, rn);
 }
 
 void
@@ -97,6 +97,7 @@ cluster_hash_alloc (void *p)
     cluster->list = NULL;
 
   cluster->refcnt = 0;
+  cluster->key = jhash (cluster->list, cluster->length, 0);
 
   return cluster;
 }
@@ -108,6 +109,7 @@ cluster_parse (struct in_addr * pnt, int length)
   struct cluster_list tmp;
   struct cluster_list *cluster;
 
+  tmp.refcnt = 0;
   tmp.length = length;
   tmp.list = pnt;
 
@@ -132,6 +134,9 @@ cluster_hash_key_make (void *p)
 {
   const struct cluster_list *cluster = p;
 
+  /* Interned values do not change.  */
+  if (cluster->refcnt)
+    return cluster->key;
   return jhash(cluster->list, cluster->length, 0);
 }
 
@@ -338,6 +343,8 @@ transit_intern (struct transit *transit)
   find = hash_get (transit_hash, transit, transit_hash_alloc);
   if (find != transit)
     transit_free (transit);
+  else
+    transit->key = jhash (transit->val, transit->length, 0);
   find->refcnt++;
 
   return find;
@@ -361,6 +368,9 @@ transit_hash_key_make (void *p)
 {
   const struct transit * transit = p;
 
+  /* Interned values do not change.  */
+  if (transit->refcnt)
+    return transit->key;
   return jhash(transit->val, transit->length, 0);
 }
 
@@ -128,6 +128,9 @@ struct cluster_list
   unsigned long refcnt;
   int length;
   struct in_addr *list;
+
+  /* Hash key, made once when interned.  */
+  unsigned int key;
 };
 
 /* Unknown transit attribute. */
@@ -136,6 +139,9 @@ struct transit
   unsigned long refcnt;
   int length;
   u_char *val;
+
+  /* Hash key, made once when interned.  */
+  unsigned int key;
 };
 
 #define ATTR_FLAG_BIT(X)  (1 << ((X) - 1))
@@ -28,6 +28,37 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 /* Hash of community attribute. */
 static struct hash *comhash;
 
+/* Bit of the mask of a community for a value.  */
+#define COMMUNITY_MASK_BIT(mix)  ((u_int64_t) 1 << ((mix) >> 58))
+
+/* 64 bits mix of a community value, as stored.  */
+static inline u_int64_t
+community_val_mix (u_int32_t val)
+{
+  u_int64_t x = val + 0x9e3779b97f4a7c15ULL;
+
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/* Compute the fingerprint and the mask of a community.  */
+static void
+community_fp_make (struct community *com)
+{
+  u_int64_t mix;
+  int i;
+
+  com->fp = 0;
+  com->mask = 0;
+  for (i = 0; i < com->size; i++)
+    {
+      mix = community_val_mix (com->val[i]);
+      com->fp += mix;
+      com->mask |= COMMUNITY_MASK_BIT (mix);
+    }
+}
+
 /* Allocate a new communities value.  */
 static struct community *
 community_new (void)
@@ -51,6 +82,8 @@ community_free (struct community *com)
 static void
 community_add_val (struct community *com, u_int32_t val)
 {
+  u_int64_t mix;
+
   com->size++;
   if (com->val)
     com->val = XREALLOC (MTYPE_COMMUNITY_VAL, com->val, com_length (com));
@@ -59,6 +92,10 @@ community_add_val (struct community *com, u_int32_t val)
 
   val = htonl (val);
   memcpy (com_lastval (com), &val, sizeof (u_int32_t));
+
+  mix = community_val_mix (val);
+  com->fp += mix;
+  com->mask |= COMMUNITY_MASK_BIT (mix);
 }
 
 /* Delete one community. */
@@ -90,6 +127,7 @@ community_del_val (struct community *com, u_int32_t *val)
 	      XFREE (MTYPE_COMMUNITY_VAL, com->val);
 	      com->val = NULL;
 	    }
+	  community_fp_make (com);
 	  return;
 	}
       i++;
@@ -111,17 +149,12 @@ community_delete (struct community *com1, struct community *com2)
   return com1;
 }
 
-/* Callback function from qsort(). */
+/* Callback function from qsort(), on values in host byte order. */
 static int
 community_compare (const void *a1, const void *a2)
 {
-  u_int32_t v1;
-  u_int32_t v2;
-
-  memcpy (&v1, a1, sizeof (u_int32_t));
-  memcpy (&v2, a2, sizeof (u_int32_t));
-  v1 = ntohl (v1);
-  v2 = ntohl (v2);
+  u_int32_t v1 = *(const u_int32_t *) a1;
+  u_int32_t v2 = *(const u_int32_t *) a2;
 
   if (v1 < v2)
     return -1;
@@ -130,18 +163,36 @@ community_compare (const void *a1, const void *a2)
   return 0;
 }
 
+/* Index of the first value of com, from index i on, which is not lower
+   than val (in host byte order).  */
+static int
+community_lower_bound (const struct community *com, int i, u_int32_t val)
+{
+  int high = com->size;
+  int mid;
+
+  while (i < high)
+    {
+      mid = i + (high - i) / 2;
+      if (ntohl (com->val[mid]) < val)
+	i = mid + 1;
+      else
+	high = mid;
+    }
+  return i;
+}
+
 int
-community_include (struct community *com, u_int32_t val)
+community_include (const struct community *com, u_int32_t val)
 {
+  u_int32_t nval = htonl (val);
   int i;
 
-  val = htonl (val);
-
-  for (i = 0; i < com->size; i++)
-    if (memcmp (&val, com_nthval (com, i), sizeof (u_int32_t)) == 0)
-      return 1;
+  if (! (com->mask & COMMUNITY_MASK_BIT (community_val_mix (nval))))
+    return 0;
 
-  return 0;
+  i = community_lower_bound (com, 0, val);
+  return i < com->size && com->val[i] == nval;
 }
 
 u_int32_t
@@ -169,17 +220,29 @@ community_uniq_sort (struct community *com)
   if (! com)
     return NULL;
   
-  new = community_new ();;
-  
+  new = community_new ();
+
+  if (com->size == 0)
+    return new;
+
+  /* The values may not be aligned when they are read from a packet.  */
+  new->val = XMALLOC (MTYPE_COMMUNITY_VAL, com_length (com));
   for (i = 0; i < com->size; i++)
-    {
-      val = community_val_get (com, i);
+    new->val[i] = community_val_get (com, i);
 
-      if (! community_include (new, val))
-	community_add_val (new, val);
+  qsort (new->val, com->size, sizeof (u_int32_t), community_compare);
+
+  for (i = 0; i < com->size; i++)
+    {
+      val = new->val[i];
+      if (new->size == 0 || val != ntohl (new->val[new->size - 1]))
+	new->val[new->size++] = htonl (val);
     }
 
-  qsort (new->val, new->size, sizeof (u_int32_t), community_compare);
+  if (new->size < com->size)
+    new->val = XREALLOC (MTYPE_COMMUNITY_VAL, new->val, com_length (new));
+
+  community_fp_make (new);
 
   return new;
 }
@@ -367,6 +430,8 @@ community_dup (struct community *com)
 
   new = XCALLOC (MTYPE_COMMUNITY, sizeof (struct community));
   new->size = com->size;
+  new->fp = com->fp;
+  new->mask = com->mask;
   if (new->size)
     {
       new->val = XMALLOC (MTYPE_COMMUNITY_VAL, com->size * 4);
@@ -394,20 +459,7 @@ community_str (struct community *com)
 unsigned int
 community_hash_make (struct community *com)
 {
-  unsigned char *pnt = (unsigned char *)com->val;
-  int size = com->size * 4;
-  unsigned int key = 0;
-  int c;
-
-  for (c = 0; c < size; c += 4)
-    {
-      key += pnt[c];
-      key += pnt[c + 1];
-      key += pnt[c + 2];
-      key += pnt[c + 3];
-    }
-
-  return key;
+  return (unsigned int) (com->fp ^ (com->fp >> 32));
 }
 
 int
@@ -415,6 +467,8 @@ community_match (const struct community *com1, const struct community *com2)
 {
   int i = 0;
   int j = 0;
+  u_int32_t v1;
+  u_int32_t v2;
 
   if (com1 == NULL && com2 == NULL)
     return 1;
@@ -425,10 +479,30 @@ community_match (const struct community *com1, const struct community *com2)
   if (com1->size < com2->size)
     return 0;
 
-  /* Every community on com2 needs to be on com1 for this to match */
+  if (com2->mask & ~com1->mask)
+    return 0;
+
+  /* Every community on com2 needs to be on com1 for this to match.
+     Both are sorted: search com1 for each of them when it is much
+     longer, else walk both at once.  */
+  if (com1->size > 4 * com2->size)
+    {
+      for (j = 0; j < com2->size; j++, i++)
+	{
+	  i = community_lower_bound (com1, i, ntohl (com2->val[j]));
+	  if (i == com1->size || com1->val[i] != com2->val[j])
+	    return 0;
+	}
+      return 1;
+    }
+
   while (i < com1->size && j < com2->size)
     {
-      if (memcmp (com1->val + i, com2->val + j, sizeof (u_int32_t)) == 0)
+      v1 = ntohl (com1->val[i]);
+      v2 = ntohl (com2->val[j]);
+      if (v1 > v2)
+	return 0;
+      if (v1 == v2)
 	j++;
       i++;
     }
@@ -449,7 +523,7 @@ community_cmp (const struct community *com1, const struct community *com2)
   if (com1 == NULL || com2 == NULL)
     return 0;
 
-  if (com1->size == com2->size)
+  if (com1->size == com2->size && com1->fp == com2->fp)
     if (memcmp (com1->val, com2->val, com1->size * 4) == 0)
       return 1;
   return 0;
@@ -467,10 +541,56 @@ community_merge (struct community *com1, struct community *com2)
 
   memcpy (com1->val + com1->size, com2->val, com2->size * 4);
   com1->size += com2->size;
+  com1->fp += com2->fp;
+  com1->mask |= com2->mask;
 
   return com1;
 }
 
+/* Return a new community with the values of both com1 and com2, sorted
+   and uniq, in one pass.  */
+struct community *
+community_union (const struct community *com1, const struct community *com2)
+{
+  struct community *new;
+  int i = 0;
+  int j = 0;
+  u_int32_t v1;
+  u_int32_t v2;
+
+  new = community_new ();
+
+  if (com1->size + com2->size == 0)
+    return new;
+
+  new->val = XMALLOC (MTYPE_COMMUNITY_VAL, (com1->size + com2->size) * 4);
+
+  while (i < com1->size && j < com2->size)
+    {
+      v1 = ntohl (com1->val[i]);
+      v2 = ntohl (com2->val[j]);
+      if (v1 <= v2)
+	{
+	  new->val[new->size++] = com1->val[i++];
+	  if (v1 == v2)
+	    j++;
+	}
+      else
+	new->val[new->size++] = com2->val[j++];
+    }
+  while (i < com1->size)
+    new->val[new->size++] = com1->val[i++];
+  while (j < com2->size)
+    new->val[new->size++] = com2->val[j++];
+
+  if (new->size < com1->size + com2->size)
+    new->val = XREALLOC (MTYPE_COMMUNITY_VAL, new->val, com_length (new));
+
+  community_fp_make (new);
+
+  return new;
+}
+
 /* Community token enum. */
 enum community_token
 {
@@ -30,12 +30,23 @@ struct community
   /* Communities value size.  */
   int size;
 
-  /* Communities value.  */
+  /* Communities value, in network byte order.  Kept sorted and
+     without duplicates, except in the result of community_merge()
+     until it is passed to community_uniq_sort().  */
   u_int32_t *val;
 
   /* String of community attribute.  This sring is used by vty output
      and expanded community-list for regular expression match.  */
   char *str;
+
+  /* Fingerprint of the values: the sum of a 64 bits mix of each, kept
+     up to date as values are added and removed.  Equal communities
+     have equal fingerprints; it is their hash key.  */
+  u_int64_t fp;
+
+  /* One bit of the mix of each value, to tell at once that a value or
+     a set of values is not included.  */
+  u_int64_t mask;
 };
 
 /* Well-known communities value.  */
@@ -64,9 +75,11 @@ extern struct community *community_str2com (const char *);
 extern int community_match (const struct community *, const struct community *);
 extern int community_cmp (const struct community *, const struct community *);
 extern struct community *community_merge (struct community *, struct community *);
+extern struct community *community_union (const struct community *,
+                                          const struct community *);
 extern struct community *community_delete (struct community *, struct community *);
 extern struct community *community_dup (struct community *);
-extern int community_include (struct community *, u_int32_t);
+extern int community_include (const struct community *, u_int32_t);
 extern void community_del_val (struct community *, u_int32_t *);
 extern unsigned long community_count (void);
 extern struct hash *community_hash (void);
@@ -33,143 +33,272 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "bgpd/bgp_table.h"
 #include "bgpd/bgp_route.h"
 #include "bgpd/bgp_attr.h" 
-#include "bgpd/bgp_advertise.h"
 
 /* Global variable to access damping configuration */
 struct bgp_damp_config bgp_damp_cfg;
 static struct bgp_damp_config *damp = &bgp_damp_cfg;
 
-/* Utility macro to add and delete BGP dampening information to no
-   used list.  */
-#define BGP_DAMP_LIST_ADD(N,A)  BGP_INFO_ADD(N,A,no_reuse_list)
-#define BGP_DAMP_LIST_DEL(N,A)  BGP_INFO_DEL(N,A,no_reuse_list)
-
-/* Calculate reuse list index by penalty value.  */
-static int
-bgp_reuse_index (int penalty)
+/* Return decayed penalty value.  */
+int 
+bgp_damp_decay (time_t tdiff, int penalty)
 {
   unsigned int i;
-  int index;
 
-  i = (int)(((double) penalty / damp->reuse_limit - 1.0) * damp->scale_factor);
+  i = (int) ((double) tdiff / DELTA_T);
+
+  if (i == 0)
+    return penalty; 
   
-  if ( i >= damp->reuse_index_size )
-    i = damp->reuse_index_size - 1;
+  if (i >= damp->decay_array_size)
+    return 0;
+
+  return (int) (penalty * damp->decay_array[i]);
+}
+
+/* Number of DELTA_T periods after which the penalty has decayed below
+   limit.  */
+static unsigned int
+bgp_damp_decay_index (unsigned int penalty, unsigned int limit)
+{
+  unsigned int i;
+
+  if (penalty < limit)
+    return 0;
+
+  /* decay_array[i] is decay_array[1] to the i: start from the log and
+     settle on the array itself, rounding included.  */
+  i = ceil (log ((double) limit / penalty) / log (damp->decay_array[1]));
+  if (i < 1)
+    i = 1;
+  if (i > damp->decay_array_size)
+    i = damp->decay_array_size;
+
+  while (i > 1
+	 && (unsigned int) bgp_damp_decay ((i - 1) * DELTA_T, penalty) < limit)
+    i--;
+  while (i < damp->decay_array_size
+	 && (unsigned int) bgp_damp_decay (i * DELTA_T, penalty) >= limit)
+    i++;
+
+  return i;
+}
 
-  index = damp->reuse_index[i] - damp->reuse_index[0];
+static int bgp_reuse_timer (struct thread *);
 
-  return (damp->reuse_offset + index) % damp->reuse_list_size;  
+/* Set the reuse timer for the first second of the calendar with
+   events.  */
+static void
+bgp_damp_timer_set (time_t t_now)
+{
+  unsigned int i;
+  time_t t;
+
+  if (damp->t_reuse)
+    thread_cancel (damp->t_reuse);
+  damp->t_reuse = NULL;
+
+  if (! damp->count)
+    return;
+
+  for (i = 0, t = damp->calendar_time; i < damp->calendar_size; i++, t++)
+    if (damp->calendar[t & (damp->calendar_size - 1)])
+      break;
+
+  damp->t_next = t;
+  damp->t_reuse = thread_add_timer (bm->master, bgp_reuse_timer, NULL,
+				    t > t_now ? t - t_now : 0);
 }
 
-/* Add BGP dampening information to reuse list.  */
-static void 
-bgp_reuse_list_add (struct bgp_damp_info *bdi)
+/* Add BGP dampening information to the calendar queue.  */
+static void
+bgp_damp_calendar_add (struct bgp_damp_info *bdi, time_t t_event)
 {
-  int index;
+  unsigned int bucket;
 
-  index = bdi->index = bgp_reuse_index (bdi->penalty);
+  if (t_event < damp->calendar_time)
+    t_event = damp->calendar_time;
+
+  bdi->t_event = t_event;
+  bucket = t_event & (damp->calendar_size - 1);
 
   bdi->prev = NULL;
-  bdi->next = damp->reuse_list[index];
-  if (damp->reuse_list[index])
-    damp->reuse_list[index]->prev = bdi;
-  damp->reuse_list[index] = bdi;
+  bdi->next = damp->calendar[bucket];
+  if (damp->calendar[bucket])
+    damp->calendar[bucket]->prev = bdi;
+  damp->calendar[bucket] = bdi;
+  damp->count++;
+
+  /* Sooner than any other event: set the timer for it.  */
+  if (! damp->t_reuse || t_event < damp->t_next)
+    {
+      time_t t_now = bgp_clock ();
+
+      if (damp->t_reuse)
+	thread_cancel (damp->t_reuse);
+      damp->t_next = t_event;
+      damp->t_reuse = thread_add_timer (bm->master, bgp_reuse_timer, NULL,
+					t_event > t_now ? t_event - t_now : 0);
+    }
 }
 
-/* Delete BGP dampening information from reuse list.  */
+/* Delete BGP dampening information from the calendar queue.  */
 static void
-bgp_reuse_list_delete (struct bgp_damp_info *bdi)
+bgp_damp_calendar_delete (struct bgp_damp_info *bdi)
 {
   if (bdi->next)
     bdi->next->prev = bdi->prev;
   if (bdi->prev)
     bdi->prev->next = bdi->next;
   else
-    damp->reuse_list[bdi->index] = bdi->next;
-}   
+    damp->calendar[bdi->t_event & (damp->calendar_size - 1)] = bdi->next;
+  damp->count--;
+}
 
-/* Return decayed penalty value.  */
-int 
-bgp_damp_decay (time_t tdiff, int penalty)
+/* Queue BGP dampening information for its next event: the reuse of a
+   suppressed route, when its penalty decays below the reuse limit or
+   it reaches the max suppress time, else the release of the
+   information, when its penalty decays to half the reuse limit.  The
+   penalty itself is decayed when it is next used.  */
+static void
+bgp_damp_schedule (struct bgp_damp_info *bdi)
 {
-  unsigned int i;
+  time_t t_event;
 
-  i = (int) ((double) tdiff / DELTA_T);
-
-  if (i == 0)
-    return penalty; 
-  
-  if (i >= damp->decay_array_size)
-    return 0;
+  if (CHECK_FLAG (bdi->binfo->flags, BGP_INFO_DAMPED))
+    {
+      t_event = bdi->t_updated
+	+ DELTA_T * bgp_damp_decay_index (bdi->penalty, damp->reuse_limit);
+      if (t_event > bdi->suppress_time + damp->max_suppress_time)
+	t_event = bdi->suppress_time + damp->max_suppress_time;
+    }
+  else
+    t_event = bdi->t_updated
+      + DELTA_T * bgp_damp_decay_index (bdi->penalty,
+					damp->reuse_limit / 2 + 1);
 
-  return (int) (penalty * damp->decay_array[i]);
+  bgp_damp_calendar_add (bdi, t_event);
 }
 
-/* Handler of reuse timer event.  Each route in the current reuse-list
-   is evaluated.  RFC2439 Section 4.8.7.  */
-static int
-bgp_reuse_timer (struct thread *t)
+static void
+bgp_damp_reschedule (struct bgp_damp_info *bdi)
 {
-  struct bgp_damp_info *bdi;
-  struct bgp_damp_info *next;
-  time_t t_now, t_diff;
-    
-  damp->t_reuse = NULL;
-  damp->t_reuse =
-    thread_add_timer (bm->master, bgp_reuse_timer, NULL, DELTA_REUSE);
+  bgp_damp_calendar_delete (bdi);
+  bgp_damp_schedule (bdi);
+}
 
-  t_now = bgp_clock ();
+/* Suppress the route.  */
+static void
+bgp_damp_suppress (struct bgp_damp_info *bdi, time_t t_now)
+{
+  struct peer_damp_stats *stats;
 
-  /* 1.  save a pointer to the current zeroth queue head and zero the
-     list head entry.  */
-  bdi = damp->reuse_list[damp->reuse_offset];
-  damp->reuse_list[damp->reuse_offset] = NULL;
+  stats = &bdi->binfo->peer->damp[bdi->afi][bdi->safi];
+  stats->suppressed++;
+  stats->suppress++;
 
-  /* 2.  set offset = modulo reuse-list-size ( offset + 1 ), thereby
-     rotating the circular queue of list-heads.  */
-  damp->reuse_offset = (damp->reuse_offset + 1) % damp->reuse_list_size;
+  bgp_info_set_flag (bdi->rn, bdi->binfo, BGP_INFO_DAMPED);
+  bdi->suppress_time = t_now;
+}
 
-  /* 3. if ( the saved list head pointer is non-empty ) */
-  for (; bdi; bdi = next)
-    {
-      struct bgp *bgp = bdi->binfo->peer->bgp;
-      
-      next = bdi->next;
+/* Reuse the route.  */
+static void
+bgp_damp_reuse (struct bgp_damp_info *bdi)
+{
+  struct peer_damp_stats *stats;
 
-      /* Set t-diff = t-now - t-updated.  */
-      t_diff = t_now - bdi->t_updated;
+  stats = &bdi->binfo->peer->damp[bdi->afi][bdi->safi];
+  stats->suppressed--;
+  stats->reuse++;
 
-      /* Set figure-of-merit = figure-of-merit * decay-array-ok [t-diff] */
-      bdi->penalty = bgp_damp_decay (t_diff, bdi->penalty);   
+  bgp_info_unset_flag (bdi->rn, bdi->binfo, BGP_INFO_DAMPED);
+  bdi->suppress_time = 0;
+}
 
-      /* Set t-updated = t-now.  */
-      bdi->t_updated = t_now;
+/* The next event of BGP dampening information is due.  RFC2439
+   Section 4.8.7.  */
+static void
+bgp_damp_event (struct bgp_damp_info *bdi, time_t t_now)
+{
+  struct bgp_node *rn = bdi->rn;
+  struct bgp_info *binfo = bdi->binfo;
+  struct bgp *bgp = binfo->peer->bgp;
+  afi_t afi = bdi->afi;
+  safi_t safi = bdi->safi;
+  int withdrawn;
+
+  /* Set figure-of-merit = figure-of-merit * decay-array-ok [t-diff] */
+  bdi->penalty = bgp_damp_decay (t_now - bdi->t_updated, bdi->penalty);
+  bdi->t_updated = t_now;
 
-      /* if (figure-of-merit < reuse).  */
-      if (bdi->penalty < damp->reuse_limit)
+  if (CHECK_FLAG (binfo->flags, BGP_INFO_DAMPED))
+    {
+      if (bdi->penalty >= damp->reuse_limit)
 	{
-	  /* Reuse the route.  */
-	  bgp_info_unset_flag (bdi->rn, bdi->binfo, BGP_INFO_DAMPED);
-	  bdi->suppress_time = 0;
-
-	  if (bdi->lastrecord == BGP_RECORD_UPDATE)
+	  if (t_now - bdi->suppress_time < damp->max_suppress_time)
 	    {
-	      bgp_info_unset_flag (bdi->rn, bdi->binfo, BGP_INFO_HISTORY);
-	      bgp_aggregate_increment (bgp, &bdi->rn->p, bdi->binfo,
-				       bdi->afi, bdi->safi);   
-	      bgp_process (bgp, bdi->rn, bdi->afi, bdi->safi);
+	      bgp_damp_reschedule (bdi);
+	      return;
 	    }
+	  /* Suppressed for the max suppress time.  */
+	  bdi->penalty = damp->reuse_limit;
+	}
 
-	  if (bdi->penalty <= damp->reuse_limit / 2.0)
-	    bgp_damp_info_free (bdi, 1);
-	  else
-	    BGP_DAMP_LIST_ADD (damp, bdi);
+      bgp_damp_reuse (bdi);
+
+      if (bdi->lastrecord == BGP_RECORD_UPDATE)
+	{
+	  bgp_info_unset_flag (rn, binfo, BGP_INFO_HISTORY);
+	  bgp_aggregate_increment (bgp, &rn->p, binfo, afi, safi);
+	  bgp_process (bgp, rn, afi, safi);
 	}
-      else
-	/* Re-insert into another list (See RFC2439 Section 4.8.6).  */
-	bgp_reuse_list_add (bdi);
     }
 
+  if (bdi->penalty <= damp->reuse_limit / 2.0)
+    {
+      /* Release the information, and the route if it is history.  */
+      withdrawn = (bdi->lastrecord == BGP_RECORD_WITHDRAW);
+      bgp_damp_info_free (bdi, 1);
+      if (withdrawn)
+	bgp_process (bgp, rn, afi, safi);
+    }
+  else
+    bgp_damp_reschedule (bdi);
+}
+
+/* Handler of reuse timer event.  The events of each second of the
+   calendar up to now are processed.  */
+static int
+bgp_reuse_timer (struct thread *t)
+{
+  struct bgp_damp_info *bdi;
+  struct bgp_damp_info *next;
+  time_t t_now;
+  unsigned int i;
+  unsigned int bucket;
+
+  damp->t_reuse = NULL;
+
+  t_now = bgp_clock ();
+
+  /* Once around the calendar at most, after a stall.  Events queued
+     meanwhile go to the next second on.  */
+  for (i = 0; damp->calendar_time <= t_now && i < damp->calendar_size; i++)
+    {
+      bucket = damp->calendar_time & (damp->calendar_size - 1);
+      damp->calendar_time++;
+
+      for (bdi = damp->calendar[bucket]; bdi; bdi = next)
+	{
+	  next = bdi->next;
+	  if (bdi->t_event <= t_now)
+	    bgp_damp_event (bdi, t_now);
+	}
+    }
+  if (damp->calendar_time <= t_now)
+    damp->calendar_time = t_now + 1;
+
+  bgp_damp_timer_set (t_now);
+
   return 0;
 }
 
@@ -180,7 +309,6 @@ bgp_damp_withdraw (struct bgp_info *binfo, struct bgp_node *rn,
 {
   time_t t_now;
   struct bgp_damp_info *bdi = NULL;
-  double last_penalty = 0;
   
   t_now = bgp_clock ();
 
@@ -204,15 +332,13 @@ bgp_damp_withdraw (struct bgp_info *binfo, struct bgp_node *rn,
       bdi->flap = 1;
       bdi->start_time = t_now;
       bdi->suppress_time = 0;
-      bdi->index = -1;
       bdi->afi = afi;
       bdi->safi = safi;
       (bgp_info_extra_get (binfo))->damp_info = bdi;
-      BGP_DAMP_LIST_ADD (damp, bdi);
     }
   else
     {
-      last_penalty = bdi->penalty;
+      bgp_damp_calendar_delete (bdi);
 
       /* 1. Set t-diff = t-now - t-updated.  */
       bdi->penalty = 
@@ -229,31 +355,24 @@ bgp_damp_withdraw (struct bgp_info *binfo, struct bgp_node *rn,
   
   bdi->lastrecord = BGP_RECORD_WITHDRAW;
   bdi->t_updated = t_now;
+  binfo->peer->damp[afi][safi].flaps++;
 
   /* Make this route as historical status.  */
   bgp_info_set_flag (rn, binfo, BGP_INFO_HISTORY);
 
-  /* Remove the route from a reuse list if it is on one.  */
+  /* Still suppressed: its reuse time moves with the penalty.  */
   if (CHECK_FLAG (bdi->binfo->flags, BGP_INFO_DAMPED))
     {
-      /* If decay rate isn't equal to 0, reinsert brn. */  
-      if (bdi->penalty != last_penalty)
-	{
-	  bgp_reuse_list_delete (bdi);
-	  bgp_reuse_list_add (bdi);  
-	}
+      bgp_damp_schedule (bdi);
       return BGP_DAMP_SUPPRESSED; 
     }
 
   /* If not suppressed before, do annonunce this withdraw and
-     insert into reuse_list.  */
+     suppress it from now on.  */
   if (bdi->penalty >= damp->suppress_value)
-    {
-      bgp_info_set_flag (rn, binfo, BGP_INFO_DAMPED);
-      bdi->suppress_time = t_now;
-      BGP_DAMP_LIST_DEL (damp, bdi);
-      bgp_reuse_list_add (bdi);
-    }
+    bgp_damp_suppress (bdi, t_now);
+
+  bgp_damp_schedule (bdi);
 
   return BGP_DAMP_USED;
 }
@@ -281,72 +400,23 @@ bgp_damp_update (struct bgp_info *binfo, struct bgp_node *rn,
   else if (CHECK_FLAG (bdi->binfo->flags, BGP_INFO_DAMPED)
 	   && (bdi->penalty < damp->reuse_limit) )
     {
-      bgp_info_unset_flag (rn, binfo, BGP_INFO_DAMPED);
-      bgp_reuse_list_delete (bdi);
-      BGP_DAMP_LIST_ADD (damp, bdi);
-      bdi->suppress_time = 0;
+      bgp_damp_reuse (bdi);
       status = BGP_DAMP_USED;
     }
   else
     status = BGP_DAMP_SUPPRESSED;  
 
   if (bdi->penalty > damp->reuse_limit / 2.0)
-    bdi->t_updated = t_now;
+    {
+      bdi->t_updated = t_now;
+      bgp_damp_reschedule (bdi);
+    }
   else
     bgp_damp_info_free (bdi, 0);
 	
   return status;
 }
 
-/* Remove dampening information and history route.  */
-int 
-bgp_damp_scan (struct bgp_info *binfo, afi_t afi, safi_t safi)
-{
-  time_t t_now, t_diff;
-  struct bgp_damp_info *bdi;
-  
-  assert (binfo->extra && binfo->extra->damp_info);
-  
-  t_now = bgp_clock ();
-  bdi = binfo->extra->damp_info;
- 
-  if (CHECK_FLAG (binfo->flags, BGP_INFO_DAMPED))
-    {
-      t_diff = t_now - bdi->suppress_time;
-
-      if (t_diff >= damp->max_suppress_time)
-        {
-          bgp_info_unset_flag (bdi->rn, binfo, BGP_INFO_DAMPED);
-          bgp_reuse_list_delete (bdi);
-	  BGP_DAMP_LIST_ADD (damp, bdi);
-          bdi->penalty = damp->reuse_limit;
-          bdi->suppress_time = 0;
-          bdi->t_updated = t_now;
-          
-          /* Need to announce UPDATE once this binfo is usable again. */
-          if (bdi->lastrecord == BGP_RECORD_UPDATE)
-            return 1;
-          else
-            return 0;
-        }
-    }
-  else
-    {
-      t_diff = t_now - bdi->t_updated;
-      bdi->penalty = bgp_damp_decay (t_diff, bdi->penalty);
-
-      if (bdi->penalty <= damp->reuse_limit / 2.0)
-        {
-          /* release the bdi, bdi->binfo. */  
-          bgp_damp_info_free (bdi, 1);
-          return 0;
-        }            
-      else
-        bdi->t_updated = t_now;
-    }       
-  return 0;
-}
-
 void
 bgp_damp_info_free (struct bgp_damp_info *bdi, int withdraw)
 {
@@ -358,10 +428,10 @@ bgp_damp_info_free (struct bgp_damp_info *bdi, int withdraw)
   binfo = bdi->binfo;
   binfo->extra->damp_info = NULL;
 
+  bgp_damp_calendar_delete (bdi);
+
   if (CHECK_FLAG (binfo->flags, BGP_INFO_DAMPED))
-    bgp_reuse_list_delete (bdi);
-  else
-    BGP_DAMP_LIST_DEL (damp, bdi);
+    binfo->peer->damp[bdi->afi][bdi->safi].suppressed--;
 
   bgp_info_unset_flag (bdi->rn, binfo, BGP_INFO_HISTORY|BGP_INFO_DAMPED);
 
@@ -374,18 +444,13 @@ bgp_damp_info_free (struct bgp_damp_info *bdi, int withdraw)
 static void
 bgp_damp_parameter_set (int hlife, int reuse, int sup, int maxsup)
 {
-  double reuse_max_ratio;
   unsigned int i;
-  double j;
 	
   damp->suppress_value = sup;
   damp->half_life = hlife;
   damp->reuse_limit = reuse;
   damp->max_suppress_time = maxsup;
 
-  /* Initialize params per bgp_damp_config. */
-  damp->reuse_index_size = REUSE_ARRAY_SIZE;
-
   damp->ceiling = (int)(damp->reuse_limit * (pow(2, (double)damp->max_suppress_time/damp->half_life))); 
 
   /* Decay-array computations */
@@ -399,33 +464,15 @@ bgp_damp_parameter_set (int hlife, int reuse, int sup, int maxsup)
   for (i = 2; i < damp->decay_array_size; i++)
     damp->decay_array[i] = damp->decay_array[i-1] * damp->decay_array[1];
 	
-  /* Reuse-list computations */
-  i = ceil ((double)damp->max_suppress_time / DELTA_REUSE) + 1;
-  if (i > REUSE_LIST_SIZE || i == 0)
-    i = REUSE_LIST_SIZE;
-  damp->reuse_list_size = i; 
-
-  damp->reuse_list = XCALLOC (MTYPE_BGP_DAMP_ARRAY, 
-			      damp->reuse_list_size 
-			      * sizeof (struct bgp_reuse_node *));
-
-  /* Reuse-array computations */
-  damp->reuse_index = XCALLOC (MTYPE_BGP_DAMP_ARRAY,
-			       sizeof(int) * damp->reuse_index_size);
-
-  reuse_max_ratio = (double)damp->ceiling/damp->reuse_limit;
-  j = (exp((double)damp->max_suppress_time/damp->half_life) * log10(2.0));
-  if ( reuse_max_ratio > j && j != 0 )
-    reuse_max_ratio = j;
-
-  damp->scale_factor = (double)damp->reuse_index_size/(reuse_max_ratio - 1);
-
-  for (i = 0; i < damp->reuse_index_size; i++)
-    {
-      damp->reuse_index[i] = 
-	(int)(((double)damp->half_life / DELTA_REUSE)
-	      * log10 (1.0 / (damp->reuse_limit * ( 1.0 + ((double)i/damp->scale_factor)))) / log10(0.5));
-    }
+  /* Calendar computations */
+  for (i = 1; i <= damp->max_suppress_time + DELTA_T; i <<= 1)
+    ;
+  damp->calendar_size = i;
+  damp->calendar = XCALLOC (MTYPE_BGP_DAMP_ARRAY,
+			    damp->calendar_size
+			    * sizeof (struct bgp_damp_info *));
+  damp->count = 0;
+  damp->calendar_time = bgp_clock ();
 }
 
 int
@@ -445,11 +492,7 @@ bgp_damp_enable (struct bgp *bgp, afi_t afi, safi_t safi, time_t half,
   SET_FLAG (bgp->af_flags[afi][safi], BGP_CONFIG_DAMPENING);
   bgp_damp_parameter_set (half, reuse, suppress, max);
 
-  /* Register reuse timer.  */
-  if (! damp->t_reuse)
-    damp->t_reuse = 
-      thread_add_timer (bm->master, bgp_reuse_timer, NULL, DELTA_REUSE);
-
+  /* The reuse timer is set by the first event queued.  */
   return 0;
 }
 
@@ -459,41 +502,19 @@ bgp_damp_config_clean (struct bgp_damp_config *damp)
   /* Free decay array */
   XFREE (MTYPE_BGP_DAMP_ARRAY, damp->decay_array);
 
-  /* Free reuse index array */
-  XFREE (MTYPE_BGP_DAMP_ARRAY, damp->reuse_index);
-
-  /* Free reuse list array. */
-  XFREE (MTYPE_BGP_DAMP_ARRAY, damp->reuse_list);
+  /* Free calendar queue. */
+  XFREE (MTYPE_BGP_DAMP_ARRAY, damp->calendar);
 }
 
-/* Clean all the bgp_damp_info stored in reuse_list. */
+/* Clean all the bgp_damp_info stored in the calendar queue. */
 void
 bgp_damp_info_clean (void)
 {
   unsigned int i;
-  struct bgp_damp_info *bdi, *next;
 
-  damp->reuse_offset = 0;
-
-  for (i = 0; i < damp->reuse_list_size; i++)
-    {
-      if (! damp->reuse_list[i])
-	continue;
-
-      for (bdi = damp->reuse_list[i]; bdi; bdi = next)
-	{
-	  next = bdi->next;
-	  bgp_damp_info_free (bdi, 1);
-	}
-      damp->reuse_list[i] = NULL;
-    }
-
-  for (bdi = damp->no_reuse_list; bdi; bdi = next)
-    {
-      next = bdi->next;
-      bgp_damp_info_free (bdi, 1);
-    }
-  damp->no_reuse_list = NULL;
+  for (i = 0; i < damp->calendar_size; i++)
+    while (damp->calendar[i])
+      bgp_damp_info_free (damp->calendar[i], 1);
 }
 
 int
@@ -543,20 +564,17 @@ bgp_config_write_damp (struct vty *vty)
 }
 
 static const char *
-bgp_get_reuse_time (unsigned int penalty, char *buf, size_t len)
+bgp_get_reuse_time (struct bgp_damp_info *bdi, char *buf, size_t len)
 {
   time_t reuse_time = 0;
   struct tm *tm = NULL;
 
-  if (penalty > damp->reuse_limit)
-    {
-      reuse_time = (int) (DELTA_T * ((log((double)damp->reuse_limit/penalty))/(log(damp->decay_array[1])))); 
-
-      if (reuse_time > damp->max_suppress_time)
-	reuse_time = damp->max_suppress_time;
+  /* The next event of a suppressed route is its reuse.  */
+  if (CHECK_FLAG (bdi->binfo->flags, BGP_INFO_DAMPED))
+    reuse_time = bdi->t_event - bgp_clock ();
 
-      tm = gmtime (&reuse_time);
-    }
+  if (reuse_time > 0)
+    tm = gmtime (&reuse_time);
   else 
     reuse_time = 0;
 
@@ -609,7 +627,7 @@ bgp_damp_info_vty (struct vty *vty, struct bgp_info *binfo)
   if (CHECK_FLAG (binfo->flags, BGP_INFO_DAMPED)
       && ! CHECK_FLAG (binfo->flags, BGP_INFO_HISTORY))
     vty_out (vty, ", reuse in %s",
-	     bgp_get_reuse_time (penalty, timebuf, BGP_UPTIME_LEN));
+	     bgp_get_reuse_time (bdi, timebuf, BGP_UPTIME_LEN));
 
   vty_out (vty, "%s", VTY_NEWLINE);
 }
@@ -619,8 +637,6 @@ bgp_damp_reuse_time_vty (struct vty *vty, struct bgp_info *binfo,
                          char *timebuf, size_t len)
 {
   struct bgp_damp_info *bdi;
-  time_t t_now, t_diff;
-  int penalty;
   
   if (!binfo->extra)
     return NULL;
@@ -633,12 +649,7 @@ bgp_damp_reuse_time_vty (struct vty *vty, struct bgp_info *binfo,
   if (! damp || ! bdi)
     return NULL;
 
-  /* Calculate new penalty.  */
-  t_now = bgp_clock ();
-  t_diff = t_now - bdi->t_updated;
-  penalty = bgp_damp_decay (t_diff, bdi->penalty);
-
-  return  bgp_get_reuse_time (penalty, timebuf, len);
+  return  bgp_get_reuse_time (bdi, timebuf, len);
 }
 
 int
@@ -24,8 +24,8 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 /* Structure maintained on a per-route basis. */
 struct bgp_damp_info
 {
-  /* Doubly linked list.  This information must be linked to
-     reuse_list or no_reuse_list.  */
+  /* Doubly linked list of the calendar queue bucket of its next
+     event.  */
   struct bgp_damp_info *next;
   struct bgp_damp_info *prev;
 
@@ -50,8 +50,9 @@ struct bgp_damp_info
   /* Back reference to bgp_node. */
   struct bgp_node *rn;
 
-  /* Current index in the reuse_list. */
-  int index;
+  /* Time of its next event: the reuse of the route when suppressed,
+     else the release of this information.  */
+  time_t t_event;
 
   /* Last time message type. */
   u_char lastrecord;
@@ -81,42 +82,36 @@ struct bgp_damp_config
    * To change this values, init_bgp_damp() should be modified.
    */
   time_t tmax;			 /* Max time previous instability retained */
-  unsigned int reuse_list_size;	 /* Number of reuse lists */
-  unsigned int reuse_index_size; /* Size of reuse index array */
 
   /* Non-configurable parameters.  Most of these are calculated from
    * the configurable parameters above.
    */
   unsigned int ceiling;			/* Max value a penalty can attain */
-  unsigned int decay_rate_per_tick;	/* Calculated from half-life */
   unsigned int decay_array_size; /* Calculated using config parameters */
-  double scale_factor;
-  unsigned int reuse_scale_factor; 
          
   /* Decay array per-set based. */ 
   double *decay_array;	
 
-  /* Reuse index array per-set based. */ 
-  int *reuse_index;
+  /* Calendar queue of all the dampening information, by the time of
+     their next event, one bucket per second.  No event is further
+     ahead than max_suppress_time and a DELTA_T, which calendar_size
+     (a power of 2) covers.  */
+  struct bgp_damp_info **calendar;
+  unsigned int calendar_size;
+  unsigned long count;
 
-  /* Reuse list array per-set based. */  
-  struct bgp_damp_info **reuse_list;
-  int reuse_offset;
-        
-  /* All dampening information which is not on reuse list.  */
-  struct bgp_damp_info *no_reuse_list;
+  /* Next second of the calendar to process.  */
+  time_t calendar_time;
 
-  /* Reuse timer thread per-set base. */
+  /* Reuse timer thread per-set base, and the time it is set for.  */
   struct thread* t_reuse;
+  time_t t_next;
 };
 
 #define BGP_DAMP_NONE           0
 #define BGP_DAMP_USED		1
 #define BGP_DAMP_SUPPRESSED	2
 
-/* Time granularity for reuse lists */
-#define DELTA_REUSE	          10
-
 /* Time granularity for decay arrays */
 #define DELTA_T 	           5
 
@@ -126,16 +121,12 @@ struct bgp_damp_config
 #define DEFAULT_REUSE 	       	 750
 #define DEFAULT_SUPPRESS 	2000
 
-#define REUSE_LIST_SIZE          256
-#define REUSE_ARRAY_SIZE        1024
-
 extern int bgp_damp_enable (struct bgp *, afi_t, safi_t, time_t, unsigned int, 
                      unsigned int, time_t);
 extern int bgp_damp_disable (struct bgp *, afi_t, safi_t);
 extern int bgp_damp_withdraw (struct bgp_info *, struct bgp_node *,
 		       afi_t, safi_t, int);
 extern int bgp_damp_update (struct bgp_info *, struct bgp_node *, afi_t, safi_t);
-extern int bgp_damp_scan (struct bgp_info *, afi_t, safi_t);
 extern void bgp_damp_info_free (struct bgp_damp_info *, int);
 extern void bgp_damp_info_clean (void);
 extern int bgp_damp_decay (time_t, int);
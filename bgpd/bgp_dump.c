@@ -377,9 +377,9 @@ bgp_dump_routes_func (int afi, int first_run, unsigned int seq)
 
           /* Originated */
 #ifdef HAVE_CLOCK_MONOTONIC
-          stream_putl (obuf, time(NULL) - (bgp_clock() - info->uptime));
+          stream_putl (obuf, time(NULL) - (bgp_clock() - BGP_INFO_UPTIME (info)));
 #else
-          stream_putl (obuf, info->uptime);
+          stream_putl (obuf, BGP_INFO_UPTIME (info));
 #endif /* HAVE_CLOCK_MONOTONIC */
 
           /* Dump attribute. */
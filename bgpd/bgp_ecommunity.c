@@ -21,6 +21,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include <zebra.h>
 
 #include "hash.h"
+#include "jhash.h"
 #include "memory.h"
 #include "prefix.h"
 #include "command.h"
@@ -200,6 +201,8 @@ ecommunity_intern (struct ecommunity *ecom)
 
   if (find != ecom)
     ecommunity_free (&ecom);
+  else
+    ecom->key = jhash (ecom->val, ecom_length (ecom), 0);
 
   find->refcnt++;
 
@@ -234,24 +237,11 @@ unsigned int
 ecommunity_hash_make (void *arg)
 {
   const struct ecommunity *ecom = arg;
-  int size = ecom->size * ECOMMUNITY_SIZE;
-  u_int8_t *pnt = ecom->val;
-  unsigned int key = 0;
-  int c;
-
-  for (c = 0; c < size; c += ECOMMUNITY_SIZE)
-    {
-      key += pnt[c];
-      key += pnt[c + 1];
-      key += pnt[c + 2];
-      key += pnt[c + 3];
-      key += pnt[c + 4];
-      key += pnt[c + 5];
-      key += pnt[c + 6];
-      key += pnt[c + 7];
-    }
 
-  return key;
+  /* Interned values do not change.  */
+  if (ecom->refcnt)
+    return ecom->key;
+  return jhash (ecom->val, ecom_length (ecom), 0);
 }
 
 /* Compare two Extended Communities Attribute structure.  */
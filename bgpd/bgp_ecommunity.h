@@ -59,6 +59,9 @@ struct ecommunity
 
   /* Human readable format string.  */
   char *str;
+
+  /* Hash key, made once when interned.  */
+  unsigned int key;
 };
 
 /* Extended community value is eight octet.  */
@@ -42,6 +42,8 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "bgpd/bgp_route.h"
 #include "bgpd/bgp_dump.h"
 #include "bgpd/bgp_open.h"
+#include "bgpd/bgp_pathlist.h"
+#include "bgpd/bgp_gr.h"
 #ifdef HAVE_SNMP
 #include "bgpd/bgp_snmp.h"
 #endif /* HAVE_SNMP */
@@ -494,6 +496,9 @@ bgp_stop (struct peer *peer)
 	  for (afi = AFI_IP ; afi < AFI_MAX ; afi++)
 	    for (safi = SAFI_UNICAST ; safi < SAFI_RESERVED_3 ; safi++)
 	      peer->nsf[afi][safi] = 0;
+
+	  /* Move forwarding off the peer before its routes are cleared. */
+	  bgp_pathlist_peer_down (peer);
 	}
 
       /* set last reset time */
@@ -507,9 +512,13 @@ bgp_stop (struct peer *peer)
       peer->synctime = 0;
     }
 
+  /* Stop sending the table, before the write thread it may schedule. */
+  bgp_announce_peer_down (peer);
+
   /* Stop read and write threads when exists. */
   BGP_READ_OFF (peer->t_read);
   BGP_WRITE_OFF (peer->t_write);
+  UNSET_FLAG (peer->sflags, PEER_STATUS_INPUT_HOLD);
 
   /* Stop all timers. */
   BGP_TIMER_OFF (peer->t_start);
@@ -908,6 +917,8 @@ bgp_establish (struct peer *peer)
 
   BGP_TIMER_ON (peer->t_routeadv, bgp_routeadv_timer, 1);
 
+  bgp_gr_peer_change (peer);
+
   return 0;
 }
 
@@ -0,0 +1,362 @@
+/* BGP graceful restart, restarting speaker, RFC 4724
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "command.h"
+#include "vty.h"
+#include "log.h"
+#include "linklist.h"
+#include "prefix.h"
+#include "thread.h"
+#include "workqueue.h"
+#include "zclient.h"
+#include "filter.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_zebra.h"
+#include "bgpd/bgp_vty.h"
+#include "bgpd/bgp_gr.h"
+
+extern struct zclient *zclient;
+
+/* End of the restart time of the restart in progress, wall clock, read
+   from the state file written before the restart. */
+static time_t gr_restart_end;
+
+/* The routes are preserved in zebra for a restart. */
+static int gr_prepared;
+
+static void
+bgp_gr_state_write (u_int32_t period)
+{
+  FILE *fp;
+
+  if ((fp = fopen (PATH_BGPD_GR_STATE, "w")) == NULL)
+    {
+      zlog_warn ("BGP-GR: can't write %s: %s", PATH_BGPD_GR_STATE,
+                 safe_strerror (errno));
+      return;
+    }
+  fprintf (fp, "%ld\n", (long) (time (NULL) + period));
+  fclose (fp);
+}
+
+static void
+bgp_gr_state_read (void)
+{
+  FILE *fp;
+  long end;
+
+  if ((fp = fopen (PATH_BGPD_GR_STATE, "r")) == NULL)
+    return;
+
+  if (fscanf (fp, "%ld", &end) == 1 && end > time (NULL))
+    gr_restart_end = end;
+  fclose (fp);
+
+  /* The state is only valid for the first start after the prepare */
+  unlink (PATH_BGPD_GR_STATE);
+}
+
+int
+bgp_gr_prepared (void)
+{
+  return gr_prepared;
+}
+
+/* Have zebra remove the routes we did not refresh, once no instance is
+   restarting any more. */
+static void
+bgp_gr_sweep (void)
+{
+  struct bgp *bgp;
+  struct listnode *node;
+
+  for (ALL_LIST_ELEMENTS_RO (bm->bgp, node, bgp))
+    if (bgp->gr_restarting)
+      return;
+
+  gr_restart_end = 0;
+  if (zclient && zclient->sock >= 0)
+    zebra_route_sweep_send (zclient, ZEBRA_ROUTE_BGP);
+}
+
+/* Called for each new instance: restart gracefully if the state file
+   says we are within the restart time.  The deferral ends at the latest
+   with the startup timer. */
+void
+bgp_gr_restart_init (struct bgp *bgp)
+{
+  time_t now = time (NULL);
+
+  if (gr_restart_end <= now)
+    return;
+
+  bgp->gr_restarting = 1;
+  zlog_notice ("BGP-GR: restarting, deferring the routes for %u seconds",
+               bgp->restart_time);
+}
+
+/* Install the routes selected while restarting, announce them to the
+   peers and sweep those zebra kept from before the restart. */
+void
+bgp_gr_restart_end (struct bgp *bgp, const char *why)
+{
+  struct bgp_node *rn;
+  struct bgp_info *ri;
+  struct peer *peer;
+  struct listnode *node;
+  afi_t afi;
+  safi_t safi;
+
+  if (! bgp->gr_restarting)
+    return;
+
+  bgp->gr_restarting = 0;
+  THREAD_OFF (bgp->t_gr_check);
+  zlog_notice ("BGP-GR: restart done: %s", why);
+
+  if (! bgp->name && ! bgp_option_check (BGP_OPT_NO_FIB))
+    for (afi = AFI_IP; afi < AFI_MAX; afi++)
+      for (safi = SAFI_UNICAST; safi <= SAFI_MULTICAST; safi++)
+        for (rn = bgp_table_top (bgp->rib[afi][safi]); rn;
+             rn = bgp_route_next (rn))
+          for (ri = rn->info; ri; ri = ri->next)
+            if (CHECK_FLAG (ri->flags, BGP_INFO_SELECTED))
+              {
+                if (ri->type == ZEBRA_ROUTE_BGP
+                    && ri->sub_type == BGP_ROUTE_NORMAL)
+                  bgp_zebra_announce (rn, ri, bgp, safi);
+                break;
+              }
+
+  for (ALL_LIST_ELEMENTS_RO (bgp->peer, node, peer))
+    bgp_announce_route_all (peer);
+
+  bgp_gr_sweep ();
+}
+
+void
+bgp_gr_delete (struct bgp *bgp)
+{
+  THREAD_OFF (bgp->t_gr_check);
+  if (! bgp->gr_restarting)
+    return;
+
+  bgp->gr_restarting = 0;
+  bgp_gr_sweep ();
+}
+
+/* Are the input and process queues drained of what the peers sent? */
+static int
+bgp_gr_rib_busy (void)
+{
+  return ! list_isempty (bm->input_peers) || bm->t_input
+         || (bm->process_main_queue
+             && work_queue_is_scheduled (bm->process_main_queue));
+}
+
+/*
+ * The restart is done when every active peer is up and sent End-of-RIB
+ * for each family negotiated, if it does graceful restart, and the RIB
+ * processed all that came before.  A peer not up yet is waited for
+ * until the startup timer expires.
+ */
+static int
+bgp_gr_check (struct thread *thread)
+{
+  struct bgp *bgp = THREAD_ARG (thread);
+  struct peer *peer;
+  struct listnode *node;
+  afi_t afi;
+  safi_t safi;
+
+  bgp->t_gr_check = NULL;
+  if (! bgp->gr_restarting)
+    return 0;
+
+  for (ALL_LIST_ELEMENTS_RO (bgp->peer, node, peer))
+    {
+      if (CHECK_FLAG (peer->flags, PEER_FLAG_SHUTDOWN) || ! peer_active (peer))
+        continue;
+      if (peer->status != Established)
+        return 0;
+      if (! CHECK_FLAG (peer->cap, PEER_CAP_RESTART_RCV))
+        continue;
+      for (afi = AFI_IP; afi < AFI_MAX; afi++)
+        for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
+          if (peer->afc_nego[afi][safi]
+              && ! CHECK_FLAG (peer->af_sflags[afi][safi],
+                               PEER_STATUS_EOR_RECEIVED))
+            return 0;
+    }
+
+  if (bgp_gr_rib_busy ())
+    {
+      THREAD_TIMER_ON (bm->master, bgp->t_gr_check, bgp_gr_check, bgp, 1);
+      return 0;
+    }
+
+  bgp_gr_restart_end (bgp, "End-of-RIB received from all peers");
+  return 0;
+}
+
+/* The peer came up, sent End-of-RIB, was shut down or deleted: see
+   whether the restart is done. */
+void
+bgp_gr_peer_change (struct peer *peer)
+{
+  struct bgp *bgp = peer->bgp;
+
+  if (bgp->gr_restarting && ! bgp->t_gr_check)
+    bgp->t_gr_check = thread_add_event (bm->master, bgp_gr_check, bgp, 0);
+}
+
+DEFUN (graceful_restart_prepare_bgp,
+       graceful_restart_prepare_bgp_cmd,
+       "graceful-restart prepare ip bgp",
+       "Graceful restart\n"
+       "Prepare a planned restart\n"
+       IP_STR
+       BGP_STR)
+{
+  struct bgp *bgp;
+  struct listnode *node;
+  u_int32_t period = 0;
+
+  for (ALL_LIST_ELEMENTS_RO (bm->bgp, node, bgp))
+    {
+      if (bgp->gr_restarting)
+        {
+          vty_out (vty, "%% Restart in progress%s", VTY_NEWLINE);
+          return CMD_WARNING;
+        }
+      if (bgp_flag_check (bgp, BGP_FLAG_GRACEFUL_RESTART)
+          && bgp->restart_time > period)
+        period = bgp->restart_time;
+    }
+
+  if (period == 0)
+    {
+      vty_out (vty, "%% Graceful restart is not enabled%s", VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+
+  /* Zebra keeps the routes for the restart and the deferral after it */
+  if (! zclient || zclient->sock < 0
+      || zebra_route_preserve_send (zclient, ZEBRA_ROUTE_BGP,
+                                    2 * period + BGP_GR_STALE_SLACK) < 0)
+    {
+      vty_out (vty, "%% Can't ask zebra to preserve the routes%s",
+               VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+  bgp_gr_state_write (period);
+  gr_prepared = 1;
+
+  vty_out (vty, "Routes preserved, restart bgpd within %u seconds%s",
+           period, VTY_NEWLINE);
+
+  return CMD_SUCCESS;
+}
+
+static void
+bgp_gr_show_peer (struct vty *vty, struct peer *peer)
+{
+  struct bgp_peer_index *index;
+  afi_t afi;
+  safi_t safi;
+
+  vty_out (vty, "  %s%s%s", peer->host,
+           CHECK_FLAG (peer->cap, PEER_CAP_RESTART_RCV)
+           ? "" : ", no graceful restart", VTY_NEWLINE);
+
+  for (afi = AFI_IP; afi < AFI_MAX; afi++)
+    for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
+      {
+        index = peer->rib_index[afi][safi];
+        if (! peer->afc_nego[afi][safi]
+            && ! (index && index->stale_count))
+          continue;
+
+        vty_out (vty, "    %-20s End-of-RIB %s, %s", afi_safi_print (afi, safi),
+                 CHECK_FLAG (peer->af_sflags[afi][safi],
+                             PEER_STATUS_EOR_RECEIVED)
+                 ? "received" : "not received",
+                 CHECK_FLAG (peer->af_sflags[afi][safi],
+                             PEER_STATUS_EOR_SEND)
+                 ? "sent" : "not sent");
+        if (index && index->stale_count)
+          vty_out (vty, ", %u stale", index->stale_count);
+        vty_out (vty, "%s", VTY_NEWLINE);
+      }
+}
+
+DEFUN (show_ip_bgp_graceful_restart,
+       show_ip_bgp_graceful_restart_cmd,
+       "show ip bgp graceful-restart",
+       SHOW_STR
+       IP_STR
+       BGP_STR
+       "Graceful restart (RFC 4724)\n")
+{
+  struct bgp *bgp;
+  struct peer *peer;
+  struct listnode *node, *pnode;
+
+  for (ALL_LIST_ELEMENTS_RO (bm->bgp, node, bgp))
+    {
+      vty_out (vty, "BGP instance %s, AS %u:%s",
+               bgp->name ? bgp->name : "default", bgp->as, VTY_NEWLINE);
+
+      if (bgp_flag_check (bgp, BGP_FLAG_GRACEFUL_RESTART))
+        vty_out (vty, " Graceful restart enabled, restart time %u seconds, "
+                 "stale path time %u seconds%s", bgp->restart_time,
+                 bgp->stalepath_time, VTY_NEWLINE);
+      else
+        vty_out (vty, " Graceful restart disabled%s", VTY_NEWLINE);
+
+      if (bgp->gr_restarting)
+        vty_out (vty, " Restarting, routes deferred for %lu more seconds%s",
+                 bgp->t_startup ? thread_timer_remain_second (bgp->t_startup)
+                 : 0, VTY_NEWLINE);
+      else if (gr_prepared)
+        vty_out (vty, " Prepared to restart%s", VTY_NEWLINE);
+
+      for (ALL_LIST_ELEMENTS_RO (bgp->peer, pnode, peer))
+        bgp_gr_show_peer (vty, peer);
+      vty_out (vty, "%s", VTY_NEWLINE);
+    }
+
+  return CMD_SUCCESS;
+}
+
+void
+bgp_gr_init (void)
+{
+  bgp_gr_state_read ();
+
+  install_element (ENABLE_NODE, &graceful_restart_prepare_bgp_cmd);
+  install_element (VIEW_NODE, &show_ip_bgp_graceful_restart_cmd);
+  install_element (ENABLE_NODE, &show_ip_bgp_graceful_restart_cmd);
+}
@@ -0,0 +1,46 @@
+/* BGP graceful restart, restarting speaker
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _QUAGGA_BGP_GR_H
+#define _QUAGGA_BGP_GR_H
+
+/*
+ * Before a planned restart, bgpd asks zebra to keep its routes in the
+ * FIB and exits without a NOTIFICATION, so that the peers keep our
+ * routes as stale, RFC 4724.  After the restart, it sets the R and F
+ * bits in the graceful restart capability of its OPENs, and defers the
+ * FIB update and the advertisement of its routes until every peer sent
+ * End-of-RIB, or the restart time expires.  It then installs the routes
+ * it selected, announces them and has zebra remove the routes it did
+ * not refresh.
+ */
+
+/* Extra time zebra keeps the routes, for the deferred update to
+   complete, seconds */
+#define BGP_GR_STALE_SLACK	30
+
+extern void bgp_gr_init (void);
+extern void bgp_gr_restart_init (struct bgp *);
+extern void bgp_gr_restart_end (struct bgp *, const char *);
+extern void bgp_gr_delete (struct bgp *);
+extern void bgp_gr_peer_change (struct peer *);
+extern int bgp_gr_prepared (void);
+
+#endif /* _QUAGGA_BGP_GR_H */
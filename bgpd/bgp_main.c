@@ -51,6 +51,8 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "bgpd/bgp_debug.h"
 #include "bgpd/bgp_filter.h"
 #include "bgpd/bgp_zebra.h"
+#include "bgpd/bgp_pathlist.h"
+#include "bgpd/bgp_gr.h"
 
 /* bgpd options, we use GNU getopt library. */
 static const struct option longopts[] = 
@@ -197,6 +199,14 @@ sigint (void)
 {
   zlog_notice ("Terminating on signal");
 
+  /* Leave the sessions to time out and the routes to zebra, for the
+     peers and zebra to keep them while we restart */
+  if (bgp_gr_prepared ())
+    {
+      zlog_notice ("Graceful restart prepared, leaving routes in place");
+      exit (0);
+    }
+
   if (! retain_mode) 
     {
       bgp_terminate ();
@@ -256,6 +266,9 @@ bgp_exit (int status)
       work_queue_free (bm->process_rsclient_queue);
       bm->process_rsclient_queue = NULL;
     }
+  THREAD_OFF (bm->t_input);
+  list_delete (bm->input_peers);
+  bm->input_peers = NULL;
   
   /* reverse bgp_master_init */
   for (ALL_LIST_ELEMENTS_RO(bm->listen_sockets, node, socket))
@@ -292,6 +305,9 @@ bgp_exit (int status)
   /* reverse bgp_scan_init */
   bgp_scan_finish ();
 
+  /* reverse bgp_pathlist_init */
+  bgp_pathlist_finish ();
+
   /* reverse access_list_init */
   access_list_add_hook (NULL);
   access_list_delete_hook (NULL);
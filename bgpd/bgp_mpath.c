@@ -272,15 +272,15 @@ static struct bgp_info_mpath *
 bgp_info_mpath_get (struct bgp_info *binfo)
 {
   struct bgp_info_mpath *mpath;
-  if (!binfo->mpath)
+  if (!BGP_INFO_MPATH (binfo))
     {
       mpath = bgp_info_mpath_new();
       if (!mpath)
         return NULL;
-      binfo->mpath = mpath;
+      bgp_info_extra_get (binfo)->mpath = mpath;
       mpath->mp_info = binfo;
     }
-  return binfo->mpath;
+  return binfo->extra->mpath;
 }
 
 /*
@@ -316,7 +316,7 @@ bgp_info_mpath_enqueue (struct bgp_info *prev_info, struct bgp_info *binfo)
 void
 bgp_info_mpath_dequeue (struct bgp_info *binfo)
 {
-  struct bgp_info_mpath *mpath = binfo->mpath;
+  struct bgp_info_mpath *mpath = BGP_INFO_MPATH (binfo);
   if (!mpath)
     return;
   if (mpath->mp_prev)
@@ -335,9 +335,10 @@ bgp_info_mpath_dequeue (struct bgp_info *binfo)
 struct bgp_info *
 bgp_info_mpath_next (struct bgp_info *binfo)
 {
-  if (!binfo->mpath || !binfo->mpath->mp_next)
+  struct bgp_info_mpath *mpath = BGP_INFO_MPATH (binfo);
+  if (!mpath || !mpath->mp_next)
     return NULL;
-  return binfo->mpath->mp_next->mp_info;
+  return mpath->mp_next->mp_info;
 }
 
 /*
@@ -359,9 +360,9 @@ bgp_info_mpath_first (struct bgp_info *binfo)
 u_int32_t
 bgp_info_mpath_count (struct bgp_info *binfo)
 {
-  if (!binfo->mpath)
+  if (!BGP_INFO_MPATH (binfo))
     return 0;
-  return binfo->mpath->mp_count;
+  return binfo->extra->mpath->mp_count;
 }
 
 /*
@@ -373,7 +374,7 @@ static void
 bgp_info_mpath_count_set (struct bgp_info *binfo, u_int32_t count)
 {
   struct bgp_info_mpath *mpath;
-  if (!count && !binfo->mpath)
+  if (!count && !BGP_INFO_MPATH (binfo))
     return;
   mpath = bgp_info_mpath_get (binfo);
   if (!mpath)
@@ -390,9 +391,9 @@ bgp_info_mpath_count_set (struct bgp_info *binfo, u_int32_t count)
 struct attr *
 bgp_info_mpath_attr (struct bgp_info *binfo)
 {
-  if (!binfo->mpath)
+  if (!BGP_INFO_MPATH (binfo))
     return NULL;
-  return binfo->mpath->mp_attr;
+  return binfo->extra->mpath->mp_attr;
 }
 
 /*
@@ -404,7 +405,7 @@ static void
 bgp_info_mpath_attr_set (struct bgp_info *binfo, struct attr *attr)
 {
   struct bgp_info_mpath *mpath;
-  if (!attr && !binfo->mpath)
+  if (!attr && !BGP_INFO_MPATH (binfo))
     return;
   mpath = bgp_info_mpath_get (binfo);
   if (!mpath)
@@ -706,9 +707,9 @@ bgp_info_mpath_aggregate_update (struct bgp_info *new_best,
         {
           if (community)
             {
-              commerge = community_merge (community, mpinfo->attr->community);
-              community = community_uniq_sort (commerge);
-              community_free (commerge);
+              commerge = community_union (community, mpinfo->attr->community);
+              community_free (community);
+              community = commerge;
             }
           else
             community = community_dup (mpinfo->attr->community);
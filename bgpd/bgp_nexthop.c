@@ -38,7 +38,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "bgpd/bgp_attr.h"
 #include "bgpd/bgp_nexthop.h"
 #include "bgpd/bgp_debug.h"
-#include "bgpd/bgp_damp.h"
+#include "bgpd/bgp_pathlist.h"
 #include "zebra/rib.h"
 #include "zebra/zserv.h"	/* For ZEBRA_SERV_PATH. */
 
@@ -467,6 +467,7 @@ bgp_scan (afi_t afi, safi_t safi)
 		{
 		  if (CHECK_FLAG (bi->flags, BGP_INFO_VALID))
 		    {
+		      bgp_pathlist_path_down (rn, bi);
 		      bgp_aggregate_decrement (bgp, &rn->p, bi,
 					       afi, SAFI_UNICAST);
 		      bgp_info_unset_flag (rn, bi, BGP_INFO_VALID);
@@ -478,13 +479,6 @@ bgp_scan (afi_t afi, safi_t safi)
 					       afi, SAFI_UNICAST);
 		    }
 		}
-
-              if (CHECK_FLAG (bgp->af_flags[afi][SAFI_UNICAST],
-		  BGP_CONFIG_DAMPENING)
-                  &&  bi->extra && bi->extra->damp_info )
-                if (bgp_damp_scan (bi, afi, SAFI_UNICAST))
-		  bgp_aggregate_increment (bgp, &rn->p, bi,
-					   afi, SAFI_UNICAST);
 	    }
 	}
       if (rn->info)
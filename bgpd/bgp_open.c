@@ -1124,7 +1124,8 @@ bgp_open_capability (struct stream *s, struct peer *peer)
             {
               stream_putw (s, afi);
               stream_putc (s, safi);
-              stream_putc (s, 0); //Forwarding is not retained as of now.
+              /* zebra kept the routes in the FIB while we restarted */
+              stream_putc (s, peer->bgp->gr_restarting ? RESTART_F_BIT : 0);
             }
     }
 
@@ -50,6 +50,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "bgpd/bgp_encap.h"
 #include "bgpd/bgp_advertise.h"
 #include "bgpd/bgp_vty.h"
+#include "bgpd/bgp_gr.h"
 
 int stream_put_prefix (struct stream *, struct prefix *);
 
@@ -607,7 +608,7 @@ bgp_write_packet (struct peer *peer)
 	adv = BGP_ADV_FIFO_HEAD (&peer->sync[afi][safi]->update);
 	if (adv)
 	  {
-            if (adv->binfo && adv->binfo->uptime < peer->synctime)
+            if (adv->binfo && BGP_INFO_UPTIME (adv->binfo) < peer->synctime)
 	      {
 		if (CHECK_FLAG (adv->binfo->peer->cap, PEER_CAP_RESTART_RCV)
 		    && CHECK_FLAG (adv->binfo->peer->cap, PEER_CAP_RESTART_ADV)
@@ -630,10 +631,12 @@ bgp_write_packet (struct peer *peer)
 	      return s;
 	  }
 
-	if (CHECK_FLAG (peer->cap, PEER_CAP_RESTART_RCV))
+	if (CHECK_FLAG (peer->cap, PEER_CAP_RESTART_RCV)
+	    && ! peer->bgp->gr_restarting)
 	  {
 	    if (peer->afc_nego[afi][safi] && peer->synctime
 		&& ! CHECK_FLAG (peer->af_sflags[afi][safi], PEER_STATUS_EOR_SEND)
+		&& ! CHECK_FLAG (peer->af_sflags[afi][safi], PEER_STATUS_ANNOUNCE)
 		&& safi != SAFI_MPLS_VPN)
 	      {
 		SET_FLAG (peer->af_sflags[afi][safi], PEER_STATUS_EOR_SEND);
@@ -665,7 +668,7 @@ bgp_write_proceed (struct peer *peer)
   for (afi = AFI_IP; afi < AFI_MAX; afi++)
     for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
       if ((adv = BGP_ADV_FIFO_HEAD (&peer->sync[afi][safi]->update)) != NULL)
-	if (adv->binfo->uptime < peer->synctime)
+	if (BGP_INFO_UPTIME (adv->binfo) < peer->synctime)
 	  return 1;
 
   return 0;
@@ -1882,6 +1885,8 @@ bgp_update_receive (struct peer *peer, bgp_size_t size)
 	  if (peer->nsf[afi][safi])
 	    bgp_clear_stale_route (peer, afi, safi);
 
+	  bgp_gr_peer_change (peer);
+
 	  if (BGP_DEBUG (normal, NORMAL))
 	    zlog (peer->log, LOG_DEBUG, "rcvd End-of-RIB for %s from %s",
 		  peer->host, afi_safi_print (afi, safi));
@@ -2572,6 +2577,7 @@ bgp_read (struct thread *thread)
     case BGP_MSG_UPDATE:
       peer->readtime = bgp_recent_clock ();
       bgp_update_receive (peer, size);
+      bgp_input_throttle (peer);
       break;
     case BGP_MSG_NOTIFY:
       bgp_notify_receive (peer, size);
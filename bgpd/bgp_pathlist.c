@@ -0,0 +1,542 @@
+/* BGP prefix independent convergence: shared path-lists
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "command.h"
+#include "hash.h"
+#include "jhash.h"
+#include "log.h"
+#include "memory.h"
+#include "prefix.h"
+#include "stream.h"
+#include "zclient.h"
+#include "filter.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_mpath.h"
+#include "bgpd/bgp_zebra.h"
+#include "bgpd/bgp_debug.h"
+#include "bgpd/bgp_pathlist.h"
+
+extern struct zclient *zclient;
+
+static struct hash *bgp_pathlist_hash;
+static u_int32_t bgp_pathlist_next_id;
+
+#define BGP_PATHLIST_PATHS(PL)  ((PL)->primary_num + (PL)->backup_num)
+
+static unsigned int
+bgp_pathlist_hash_key (void *arg)
+{
+  struct bgp_pathlist *pl = arg;
+  unsigned int key;
+  int i;
+
+  key = jhash_2words (pl->afi, (pl->primary_num << 8) | pl->backup_num, 0);
+  for (i = 0; i < BGP_PATHLIST_PATHS (pl); i++)
+    {
+      key = jhash_1word ((u_int32_t) (uintptr_t) pl->path[i].peer, key);
+      key = jhash (&pl->path[i].nexthop, sizeof (pl->path[i].nexthop), key);
+    }
+
+  return key;
+}
+
+static int
+bgp_pathlist_path_same (struct bgp_pathlist_path *p1,
+                        struct bgp_pathlist_path *p2)
+{
+  return p1->ifindex == p2->ifindex
+    && ! memcmp (&p1->nexthop, &p2->nexthop, sizeof (p1->nexthop));
+}
+
+static int
+bgp_pathlist_hash_cmp (const void *arg1, const void *arg2)
+{
+  const struct bgp_pathlist *pl1 = arg1;
+  const struct bgp_pathlist *pl2 = arg2;
+  int i;
+
+  if (pl1->afi != pl2->afi
+      || pl1->primary_num != pl2->primary_num
+      || pl1->backup_num != pl2->backup_num)
+    return 0;
+
+  for (i = 0; i < BGP_PATHLIST_PATHS (pl1); i++)
+    if (pl1->path[i].peer != pl2->path[i].peer
+        || ! bgp_pathlist_path_same (&pl1->path[i], &pl2->path[i]))
+      return 0;
+
+  return 1;
+}
+
+static void *
+bgp_pathlist_alloc (void *arg)
+{
+  struct bgp_pathlist *key = arg;
+  struct bgp_pathlist *pl;
+  int i;
+
+  pl = XCALLOC (MTYPE_BGP_PATHLIST, sizeof (struct bgp_pathlist));
+  pl->afi = key->afi;
+  pl->primary_num = key->primary_num;
+  pl->backup_num = key->backup_num;
+  pl->path = XCALLOC (MTYPE_BGP_PATHLIST,
+                      sizeof (struct bgp_pathlist_path)
+                      * BGP_PATHLIST_PATHS (pl));
+  for (i = 0; i < BGP_PATHLIST_PATHS (pl); i++)
+    {
+      pl->path[i] = key->path[i];
+      pl->path[i].flags = 0;
+      peer_lock (pl->path[i].peer);
+    }
+
+  if (++bgp_pathlist_next_id == 0)
+    bgp_pathlist_next_id = 1;
+  pl->id = bgp_pathlist_next_id;
+
+  return pl;
+}
+
+static void
+bgp_pathlist_free (struct bgp_pathlist *pl)
+{
+  int i;
+
+  for (i = 0; i < BGP_PATHLIST_PATHS (pl); i++)
+    peer_unlock (pl->path[i].peer);
+  XFREE (MTYPE_BGP_PATHLIST, pl->path);
+  XFREE (MTYPE_BGP_PATHLIST, pl);
+}
+
+/* Forward on the installed paths which are up, or else on the backup
+   path. Returns whether the forwarding paths changed. */
+static int
+bgp_pathlist_activate (struct bgp_pathlist *pl)
+{
+  struct bgp_pathlist_path *path;
+  int i, up = 0, changed = 0;
+  int active;
+
+  for (i = 0; i < pl->primary_num; i++)
+    if (! CHECK_FLAG (pl->path[i].flags, BGP_PATHLIST_PATH_DOWN))
+      up++;
+
+  for (i = 0; i < BGP_PATHLIST_PATHS (pl); i++)
+    {
+      path = &pl->path[i];
+      active = ! CHECK_FLAG (path->flags, BGP_PATHLIST_PATH_DOWN)
+        && (i < pl->primary_num || up == 0);
+
+      if (active != !! CHECK_FLAG (path->flags, BGP_PATHLIST_PATH_ACTIVE))
+        {
+          changed = 1;
+          if (active)
+            SET_FLAG (path->flags, BGP_PATHLIST_PATH_ACTIVE);
+          else
+            UNSET_FLAG (path->flags, BGP_PATHLIST_PATH_ACTIVE);
+        }
+    }
+
+  return changed;
+}
+
+static void
+bgp_pathlist_send (int cmd, struct bgp_pathlist *pl)
+{
+  struct zapi_pathlist api;
+  struct prefix nexthop[MULTIPATH_NUM + 1];
+  ifindex_t ifindex[MULTIPATH_NUM + 1];
+  struct bgp_pathlist_path *path;
+  char buf[INET6_ADDRSTRLEN];
+  int i;
+
+  if (zclient->sock < 0)
+    return;
+
+  memset (&api, 0, sizeof (api));
+  memset (nexthop, 0, sizeof (nexthop));
+  api.type = ZEBRA_ROUTE_BGP;
+  api.id = pl->id;
+  api.nexthop = nexthop;
+  api.ifindex = ifindex;
+
+  if (cmd == ZEBRA_PATHLIST_ADD)
+    for (i = 0; i < BGP_PATHLIST_PATHS (pl); i++)
+      {
+        path = &pl->path[i];
+        if (! CHECK_FLAG (path->flags, BGP_PATHLIST_PATH_ACTIVE))
+          continue;
+
+        if (pl->afi == AFI_IP)
+          {
+            nexthop[api.nexthop_num].family = AF_INET;
+            nexthop[api.nexthop_num].prefixlen = IPV4_MAX_BITLEN;
+            nexthop[api.nexthop_num].u.prefix4 = path->nexthop.ipv4;
+          }
+        else
+          {
+            nexthop[api.nexthop_num].family = AF_INET6;
+            nexthop[api.nexthop_num].prefixlen = IPV6_MAX_BITLEN;
+            nexthop[api.nexthop_num].u.prefix6 = path->nexthop.ipv6;
+          }
+        ifindex[api.nexthop_num] = path->ifindex;
+
+        if (BGP_DEBUG (zebra, ZEBRA))
+          zlog_debug ("Zebra send: path-list %u nexthop %s%s", pl->id,
+                      inet_ntop (afi2family (pl->afi), &path->nexthop,
+                                 buf, sizeof (buf)),
+                      i < pl->primary_num ? "" : " (backup)");
+        api.nexthop_num++;
+      }
+  else if (BGP_DEBUG (zebra, ZEBRA))
+    zlog_debug ("Zebra send: path-list %u delete", pl->id);
+
+  zapi_pathlist (cmd, zclient, &api);
+}
+
+static struct bgp_pathlist *
+bgp_pathlist_get (afi_t afi, struct bgp_pathlist_path *path,
+                  int primary_num, int backup_num)
+{
+  struct bgp_pathlist key;
+  struct bgp_pathlist *pl;
+  int i;
+
+  key.afi = afi;
+  key.primary_num = primary_num;
+  key.backup_num = backup_num;
+  key.path = path;
+
+  pl = hash_get (bgp_pathlist_hash, &key, bgp_pathlist_alloc);
+
+  /* A prefix selected these paths again: they are up. */
+  for (i = 0; i < BGP_PATHLIST_PATHS (pl); i++)
+    UNSET_FLAG (pl->path[i].flags, BGP_PATHLIST_PATH_DOWN);
+  if (bgp_pathlist_activate (pl))
+    bgp_pathlist_send (ZEBRA_PATHLIST_ADD, pl);
+
+  pl->refcnt++;
+  return pl;
+}
+
+void
+bgp_pathlist_unlock (struct bgp_pathlist *pl)
+{
+  assert (pl->refcnt > 0);
+  if (--pl->refcnt > 0)
+    return;
+
+  bgp_pathlist_send (ZEBRA_PATHLIST_DELETE, pl);
+  hash_release (bgp_pathlist_hash, pl);
+  bgp_pathlist_free (pl);
+}
+
+/* Path-list entry for the nexthop installed for a path, as sent by
+   bgp_zebra_announce(). */
+static int
+bgp_pathlist_path_set (afi_t afi, struct bgp_pathlist_path *path,
+                       struct bgp_info *info)
+{
+  struct in6_addr *nexthop;
+
+  memset (path, 0, sizeof (struct bgp_pathlist_path));
+  path->peer = info->peer;
+
+  if (afi == AFI_IP)
+    {
+      path->nexthop.ipv4 = info->attr->nexthop;
+      return 1;
+    }
+
+  nexthop = bgp_info_to_ipv6_nexthop (info, &path->ifindex);
+  if (nexthop == NULL)
+    return 0;
+  path->nexthop.ipv6 = *nexthop;
+  return 1;
+}
+
+/* Set path[n] to the backup of the n installed paths of the prefix:
+   the best path among the others whose nexthop differs. */
+static int
+bgp_pathlist_backup (struct bgp *bgp, struct bgp_node *rn,
+                     struct bgp_info *info, afi_t afi, safi_t safi,
+                     struct bgp_pathlist_path *path, int n)
+{
+  struct bgp_info *backup;
+  int i;
+
+  backup = bgp_info_backup (bgp, rn, info, afi, safi);
+  if (! backup || ! bgp_pathlist_path_set (afi, &path[n], backup))
+    return 0;
+
+  for (i = 0; i < n; i++)
+    if (bgp_pathlist_path_same (&path[i], &path[n]))
+      return 0;
+
+  return 1;
+}
+
+/* Path-list of the paths installed for a prefix, and of its backup. */
+struct bgp_pathlist *
+bgp_pathlist_select (struct bgp *bgp, struct bgp_node *rn,
+                     struct bgp_info *info, safi_t safi)
+{
+  struct bgp_pathlist_path path[MULTIPATH_NUM + 1];
+  struct bgp_info *mpinfo;
+  afi_t afi;
+  int n;
+
+  afi = family2afi (rn->p.family);
+  if (! bgp_pathlist_path_set (afi, &path[0], info))
+    return NULL;
+  n = 1;
+
+  /* IPv6 routes are installed with the best path only. */
+  if (afi == AFI_IP)
+    for (mpinfo = bgp_info_mpath_first (info);
+         mpinfo && n < MULTIPATH_NUM;
+         mpinfo = bgp_info_mpath_next (mpinfo))
+      if (bgp_pathlist_path_set (afi, &path[n], mpinfo))
+        n++;
+
+  if (bgp_pathlist_backup (bgp, rn, info, afi, safi, path, n))
+    return bgp_pathlist_get (afi, path, n, 1);
+
+  return bgp_pathlist_get (afi, path, n, 0);
+}
+
+/* Whether the backup of the installed paths of the prefix changed
+   while they stayed the same, so that it must be installed again. */
+int
+bgp_pathlist_backup_changed (struct bgp *bgp, struct bgp_node *rn,
+                             struct bgp_info *info, safi_t safi)
+{
+  struct bgp_pathlist *pl = rn->pathlist;
+  struct bgp_pathlist_path path[MULTIPATH_NUM + 1];
+  int n;
+
+  if (pl == NULL)
+    return 0;
+
+  n = pl->primary_num;
+  memcpy (path, pl->path, sizeof (struct bgp_pathlist_path) * n);
+  if (! bgp_pathlist_backup (bgp, rn, info, pl->afi, safi, path, n))
+    return pl->backup_num != 0;
+
+  return pl->backup_num == 0
+    || pl->path[n].peer != path[n].peer
+    || ! bgp_pathlist_path_same (&pl->path[n], &path[n]);
+}
+
+static void
+bgp_pathlist_peer_down_walk (struct hash_backet *backet, void *arg)
+{
+  struct bgp_pathlist *pl = backet->data;
+  struct peer *peer = arg;
+  int i;
+
+  for (i = 0; i < BGP_PATHLIST_PATHS (pl); i++)
+    if (pl->path[i].peer == peer)
+      SET_FLAG (pl->path[i].flags, BGP_PATHLIST_PATH_DOWN);
+
+  if (bgp_pathlist_activate (pl))
+    {
+      pl->switches++;
+      bgp_pathlist_send (ZEBRA_PATHLIST_ADD, pl);
+    }
+}
+
+/* The peer went down: switch forwarding away from its paths before
+   its routes are cleared one by one. */
+void
+bgp_pathlist_peer_down (struct peer *peer)
+{
+  if (bgp_pathlist_hash->count == 0)
+    return;
+
+  if (BGP_DEBUG (zebra, ZEBRA))
+    zlog_debug ("%s down, switching path-lists", peer->host);
+  hash_iterate (bgp_pathlist_hash, bgp_pathlist_peer_down_walk, peer);
+}
+
+struct bgp_pathlist_nexthop
+{
+  afi_t afi;
+  struct bgp_pathlist_path *path;
+};
+
+static void
+bgp_pathlist_nexthop_down_walk (struct hash_backet *backet, void *arg)
+{
+  struct bgp_pathlist *pl = backet->data;
+  struct bgp_pathlist_nexthop *down = arg;
+  int i;
+
+  if (pl->afi != down->afi)
+    return;
+
+  for (i = 0; i < BGP_PATHLIST_PATHS (pl); i++)
+    if (bgp_pathlist_path_same (&pl->path[i], down->path))
+      SET_FLAG (pl->path[i].flags, BGP_PATHLIST_PATH_DOWN);
+
+  if (bgp_pathlist_activate (pl))
+    {
+      pl->switches++;
+      bgp_pathlist_send (ZEBRA_PATHLIST_ADD, pl);
+    }
+}
+
+/* The nexthop of a path of the prefix became unreachable: switch all
+   path-lists away from it. Only the first prefix which finds its
+   path-list using the nexthop walks them. */
+void
+bgp_pathlist_path_down (struct bgp_node *rn, struct bgp_info *info)
+{
+  struct bgp_pathlist *pl = rn->pathlist;
+  struct bgp_pathlist_path path;
+  struct bgp_pathlist_nexthop down;
+  int i;
+
+  if (pl == NULL || ! bgp_pathlist_path_set (pl->afi, &path, info))
+    return;
+
+  for (i = 0; i < BGP_PATHLIST_PATHS (pl); i++)
+    if (bgp_pathlist_path_same (&pl->path[i], &path))
+      break;
+  if (i == BGP_PATHLIST_PATHS (pl)
+      || CHECK_FLAG (pl->path[i].flags, BGP_PATHLIST_PATH_DOWN))
+    return;
+
+  down.afi = pl->afi;
+  down.path = &path;
+  hash_iterate (bgp_pathlist_hash, bgp_pathlist_nexthop_down_walk, &down);
+}
+
+static void
+bgp_pathlist_resend (struct hash_backet *backet, void *arg)
+{
+  bgp_pathlist_send (ZEBRA_PATHLIST_ADD, backet->data);
+}
+
+/* Zebra (re)connected: it knows none of the path-lists. */
+void
+bgp_pathlist_zebra_connected (void)
+{
+  hash_iterate (bgp_pathlist_hash, bgp_pathlist_resend, NULL);
+}
+
+/* Install the routes again, with or without path-lists after a
+   configuration change. */
+void
+bgp_pathlist_reset (struct bgp *bgp)
+{
+  struct bgp_node *rn;
+  struct bgp_info *ri;
+  afi_t afi;
+  safi_t safi;
+
+  if (bgp->name || bgp_option_check (BGP_OPT_NO_FIB))
+    return;
+
+  for (afi = AFI_IP; afi < AFI_MAX; afi++)
+    for (safi = SAFI_UNICAST; safi <= SAFI_MULTICAST; safi++)
+      for (rn = bgp_table_top (bgp->rib[afi][safi]); rn;
+           rn = bgp_route_next (rn))
+        for (ri = rn->info; ri; ri = ri->next)
+          if (CHECK_FLAG (ri->flags, BGP_INFO_SELECTED)
+              && ri->type == ZEBRA_ROUTE_BGP
+              && ri->sub_type == BGP_ROUTE_NORMAL)
+            {
+              bgp_zebra_announce (rn, ri, bgp, safi);
+              break;
+            }
+}
+
+/* show ip bgp path-list */
+static void
+bgp_pathlist_show (struct hash_backet *backet, void *arg)
+{
+  struct bgp_pathlist *pl = backet->data;
+  struct bgp_pathlist_path *path;
+  struct vty *vty = arg;
+  char buf[INET6_ADDRSTRLEN];
+  int i;
+
+  vty_out (vty, "Path-list %u, %s, %lu prefixes, %u switches%s",
+           pl->id, pl->afi == AFI_IP ? "IPv4" : "IPv6", pl->refcnt,
+           pl->switches, VTY_NEWLINE);
+
+  for (i = 0; i < BGP_PATHLIST_PATHS (pl); i++)
+    {
+      path = &pl->path[i];
+      vty_out (vty, "  %s %s from %s%s%s%s",
+               i < pl->primary_num ? "path  " : "backup",
+               inet_ntop (afi2family (pl->afi), &path->nexthop,
+                          buf, sizeof (buf)),
+               path->peer->host,
+               CHECK_FLAG (path->flags, BGP_PATHLIST_PATH_ACTIVE)
+               ? ", forwarding" : "",
+               CHECK_FLAG (path->flags, BGP_PATHLIST_PATH_DOWN)
+               ? ", down" : "",
+               VTY_NEWLINE);
+    }
+}
+
+DEFUN (show_ip_bgp_path_list,
+       show_ip_bgp_path_list_cmd,
+       "show ip bgp path-list",
+       SHOW_STR
+       IP_STR
+       BGP_STR
+       "Path-lists shared by the installed routes\n")
+{
+  vty_out (vty, "%lu path-lists%s", bgp_pathlist_hash->count, VTY_NEWLINE);
+  hash_iterate (bgp_pathlist_hash, bgp_pathlist_show, vty);
+  return CMD_SUCCESS;
+}
+
+void
+bgp_pathlist_init (void)
+{
+  bgp_pathlist_hash = hash_create (bgp_pathlist_hash_key,
+                                   bgp_pathlist_hash_cmp);
+
+  install_element (VIEW_NODE, &show_ip_bgp_path_list_cmd);
+  install_element (ENABLE_NODE, &show_ip_bgp_path_list_cmd);
+}
+
+static void
+bgp_pathlist_hash_free (void *arg)
+{
+  bgp_pathlist_free (arg);
+}
+
+void
+bgp_pathlist_finish (void)
+{
+  hash_clean (bgp_pathlist_hash, bgp_pathlist_hash_free);
+  hash_free (bgp_pathlist_hash);
+  bgp_pathlist_hash = NULL;
+}
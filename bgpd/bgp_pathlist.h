@@ -0,0 +1,81 @@
+/* BGP prefix independent convergence: shared path-lists
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _QUAGGA_BGP_PATHLIST_H
+#define _QUAGGA_BGP_PATHLIST_H
+
+/* Prefixes whose installed paths and backup path are the same share a
+ * path-list, installed in zebra once and referenced by their routes.
+ * When a peer goes down or a nexthop becomes unreachable, the path-lists
+ * which use it fall back on their remaining paths, or on their backup
+ * path, and zebra moves the routes which reference them: forwarding is
+ * repaired in O(path-lists) messages, before the best path of each
+ * prefix is selected again.
+ */
+
+struct bgp_pathlist_path
+{
+  struct peer *peer;
+
+  union
+  {
+    struct in_addr ipv4;
+    struct in6_addr ipv6;
+  } nexthop;
+  ifindex_t ifindex;
+
+  u_char flags;
+#define BGP_PATHLIST_PATH_DOWN     (1 << 0)
+#define BGP_PATHLIST_PATH_ACTIVE   (1 << 1)
+};
+
+struct bgp_pathlist
+{
+  /* Identifier in zebra. */
+  u_int32_t id;
+
+  afi_t afi;
+
+  /* Number of prefixes which use it. */
+  unsigned long refcnt;
+
+  /* Installed paths, followed by the backup path if any. */
+  u_char primary_num;
+  u_char backup_num;
+  struct bgp_pathlist_path *path;
+
+  /* Times the forwarding paths were switched. */
+  u_int32_t switches;
+};
+
+extern void bgp_pathlist_init (void);
+extern void bgp_pathlist_finish (void);
+extern struct bgp_pathlist *bgp_pathlist_select (struct bgp *,
+                                                 struct bgp_node *,
+                                                 struct bgp_info *, safi_t);
+extern int bgp_pathlist_backup_changed (struct bgp *, struct bgp_node *,
+                                        struct bgp_info *, safi_t);
+extern void bgp_pathlist_unlock (struct bgp_pathlist *);
+extern void bgp_pathlist_peer_down (struct peer *);
+extern void bgp_pathlist_path_down (struct bgp_node *, struct bgp_info *);
+extern void bgp_pathlist_zebra_connected (void);
+extern void bgp_pathlist_reset (struct bgp *);
+
+#endif /* _QUAGGA_BGP_PATHLIST_H */
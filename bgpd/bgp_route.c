@@ -55,6 +55,8 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "bgpd/bgp_zebra.h"
 #include "bgpd/bgp_vty.h"
 #include "bgpd/bgp_mpath.h"
+#include "bgpd/bgp_pathlist.h"
+#include "bgpd/bgp_rsview.h"
 
 /* Extern from bgp_dump.c */
 extern const char *bgp_origin_str[];
@@ -108,6 +110,8 @@ bgp_info_extra_free (struct bgp_info_extra **extra)
         bgp_damp_info_free ((*extra)->damp_info, 0);
       
       (*extra)->damp_info = NULL;
+
+      bgp_info_mpath_free (&(*extra)->mpath);
       
       XFREE (MTYPE_BGP_ROUTE_EXTRA, *extra);
       
@@ -141,7 +145,6 @@ bgp_info_free (struct bgp_info *binfo)
     bgp_attr_unintern (&binfo->attr);
   
   bgp_info_extra_free (&binfo->extra);
-  bgp_info_mpath_free (&binfo->mpath);
 
   peer_unlock (binfo->peer); /* bgp_info peer reference */
 
@@ -185,19 +188,13 @@ bgp_info_unlock (struct bgp_info *binfo)
 void
 bgp_info_add (struct bgp_node *rn, struct bgp_info *ri)
 {
-  struct bgp_info *top;
-
-  top = rn->info;
-  
   ri->next = rn->info;
-  ri->prev = NULL;
-  if (top)
-    top->prev = ri;
   rn->info = ri;
   
   bgp_info_lock (ri);
   bgp_lock_node (rn);
   peer_lock (ri->peer); /* bgp_info peer reference */
+  bgp_peer_index_add (ri->peer, rn);
 }
 
 /* Do the actual removal of info from RIB, for use by bgp_process 
@@ -205,12 +202,12 @@ bgp_info_add (struct bgp_node *rn, struct bgp_info *ri)
 static void
 bgp_info_reap (struct bgp_node *rn, struct bgp_info *ri)
 {
-  if (ri->next)
-    ri->next->prev = ri->prev;
-  if (ri->prev)
-    ri->prev->next = ri->next;
-  else
-    rn->info = ri->next;
+  struct bgp_info **prev;
+
+  for (prev = (struct bgp_info **) &rn->info; *prev != ri;
+       prev = &(*prev)->next)
+    assert (*prev);
+  *prev = ri->next;
   
   bgp_info_mpath_dequeue (ri);
   bgp_info_unlock (ri);
@@ -234,6 +231,8 @@ bgp_info_restore (struct bgp_node *rn, struct bgp_info *ri)
   bgp_info_unset_flag (rn, ri, BGP_INFO_REMOVED);
   /* unset of previous already took care of pcount */
   SET_FLAG (ri->flags, BGP_INFO_VALID);
+  /* the index may have dropped the node since the deletion */
+  bgp_peer_index_add (ri->peer, rn);
 }
 
 /* Adjust pcount as required */   
@@ -321,10 +320,54 @@ bgp_med_value (struct attr *attr, struct bgp *bgp)
     }
 }
 
+/* Pack the local preference, local route, AS path length and origin
+ * of a path in its decision key, the greater key being preferred.  The
+ * key stays valid until the attribute of the path or the bestpath
+ * configuration of the instance changes. */
+static void
+bgp_info_key_update (struct bgp *bgp, struct bgp_info *ri)
+{
+  struct attr *attr = ri->attr;
+  u_int32_t pref;
+  u_int32_t len;
+
+  if (CHECK_FLAG (ri->flags, BGP_INFO_KEY_VALID)
+      && ri->key_version == bgp->key_version)
+    return;
+
+  pref = bgp->default_local_pref;
+  if (attr->flag & ATTR_FLAG_BIT (BGP_ATTR_LOCAL_PREF))
+    pref = attr->local_pref;
+
+  len = 0;
+  if (! bgp_flag_check (bgp, BGP_FLAG_ASPATH_IGNORE))
+    {
+      len = aspath_count_hops (attr->aspath);
+      if (bgp_flag_check (bgp, BGP_FLAG_ASPATH_CONFED))
+        len += aspath_count_confeds (attr->aspath);
+      if (len > BGP_INFO_KEY_LEN_MAX)
+        len = BGP_INFO_KEY_LEN_MAX;
+    }
+
+  ri->key = ((u_int64_t) pref << 32)
+            | ((BGP_INFO_KEY_LEN_MAX - len) << 8) | (255 - attr->origin);
+  if (ri->sub_type != BGP_ROUTE_NORMAL)
+    ri->key |= BGP_INFO_KEY_LOCAL;
+
+  /* Weight is most often 0, compare it on the attributes otherwise. */
+  if (attr->extra && attr->extra->weight)
+    SET_FLAG (ri->flags, BGP_INFO_KEY_WEIGHT);
+  else
+    UNSET_FLAG (ri->flags, BGP_INFO_KEY_WEIGHT);
+
+  SET_FLAG (ri->flags, BGP_INFO_KEY_VALID);
+  ri->key_version = bgp->key_version;
+}
+
 /* Compare two bgp route entity.  Return -1 if new is preferred, 1 if exist
  * is preferred, or 0 if they are the same (usually will only occur if
  * multipath is enabled */
-static int
+int
 bgp_info_cmp (struct bgp *bgp, struct bgp_info *new, struct bgp_info *exist,
               afi_t afi, safi_t safi)
 {
@@ -332,12 +375,8 @@ bgp_info_cmp (struct bgp *bgp, struct bgp_info *new, struct bgp_info *exist,
   struct attr_extra *newattre, *existattre;
   bgp_peer_sort_t new_sort;
   bgp_peer_sort_t exist_sort;
-  u_int32_t new_pref;
-  u_int32_t exist_pref;
   u_int32_t new_med;
   u_int32_t exist_med;
-  u_int32_t new_weight;
-  u_int32_t exist_weight;
   uint32_t newm, existm;
   struct in_addr new_id;
   struct in_addr exist_id;
@@ -353,80 +392,41 @@ bgp_info_cmp (struct bgp *bgp, struct bgp_info *new, struct bgp_info *exist,
   if (exist == NULL)
     return -1;
 
+  bgp_info_key_update (bgp, new);
+  bgp_info_key_update (bgp, exist);
+
   newattr = new->attr;
   existattr = exist->attr;
   newattre = newattr->extra;
   existattre = existattr->extra;
 
   /* 1. Weight check. */
-  new_weight = exist_weight = 0;
-
-  if (newattre)
-    new_weight = newattre->weight;
-  if (existattre)
-    exist_weight = existattre->weight;
-
-  if (new_weight > exist_weight)
-    return -1;
-  if (new_weight < exist_weight)
-    return 1;
-
-  /* 2. Local preference check. */
-  new_pref = exist_pref = bgp->default_local_pref;
-
-  if (newattr->flag & ATTR_FLAG_BIT (BGP_ATTR_LOCAL_PREF))
-    new_pref = newattr->local_pref;
-  if (existattr->flag & ATTR_FLAG_BIT (BGP_ATTR_LOCAL_PREF))
-    exist_pref = existattr->local_pref;
+  if (CHECK_FLAG (new->flags | exist->flags, BGP_INFO_KEY_WEIGHT))
+    {
+      u_int32_t new_weight = newattre ? newattre->weight : 0;
+      u_int32_t exist_weight = existattre ? existattre->weight : 0;
 
-  if (new_pref > exist_pref)
-    return -1;
-  if (new_pref < exist_pref)
-    return 1;
+      if (new_weight > exist_weight)
+        return -1;
+      if (new_weight < exist_weight)
+        return 1;
+    }
 
-  /* 3. Local route check. We prefer:
+  /* 2. Local preference check.
+   * 3. Local route check. We prefer:
    *  - BGP_ROUTE_STATIC
    *  - BGP_ROUTE_AGGREGATE
    *  - BGP_ROUTE_REDISTRIBUTE
+   * 4. AS path length check.
+   * 5. Origin check.
+   * The new local route is preferred when both are local.
    */
-  if (! (new->sub_type == BGP_ROUTE_NORMAL))
-     return -1;
-  if (! (exist->sub_type == BGP_ROUTE_NORMAL))
-     return 1;
-
-  /* 4. AS path length check. */
-  if (! bgp_flag_check (bgp, BGP_FLAG_ASPATH_IGNORE))
-    {
-      int exist_hops = aspath_count_hops (existattr->aspath);
-      int exist_confeds = aspath_count_confeds (existattr->aspath);
-      
-      if (bgp_flag_check (bgp, BGP_FLAG_ASPATH_CONFED))
-	{
-	  int aspath_hops;
-	  
-	  aspath_hops = aspath_count_hops (newattr->aspath);
-          aspath_hops += aspath_count_confeds (newattr->aspath);
-          
-	  if ( aspath_hops < (exist_hops + exist_confeds))
-	    return -1;
-	  if ( aspath_hops > (exist_hops + exist_confeds))
-	    return 1;
-	}
-      else
-	{
-	  int newhops = aspath_count_hops (newattr->aspath);
-	  
-	  if (newhops < exist_hops)
-	    return -1;
-          if (newhops > exist_hops)
-	    return 1;
-	}
-    }
-
-  /* 5. Origin check. */
-  if (newattr->origin < existattr->origin)
+  if ((new->key >> 32) == (exist->key >> 32)
+      && (new->key & exist->key & BGP_INFO_KEY_LOCAL))
     return -1;
-  if (newattr->origin > existattr->origin)
+  if (new->key > exist->key)
+    return -1;
+  if (new->key < exist->key)
     return 1;
 
   /* 6. MED check. */
@@ -1298,13 +1298,7 @@ bgp_announce_check_rsclient (struct bgp_info *ri, struct peer *rsclient,
   return 1;
 }
 
-struct bgp_info_pair
-{
-  struct bgp_info *old;
-  struct bgp_info *new;
-};
-
-static void
+void
 bgp_best_selection (struct bgp *bgp, struct bgp_node *rn,
 		    struct bgp_info_pair *result,
 		    afi_t afi, safi_t safi)
@@ -1462,6 +1456,114 @@ bgp_best_selection (struct bgp *bgp, struct bgp_node *rn,
   return;
 }
 
+/* Backup path to fall back on when the selected path fails (BGP PIC):
+ * the best among the other usable paths, from another peer and, for
+ * IPv4, through another nexthop. Multipaths are installed with the
+ * selected path, they can't back it up.
+ */
+struct bgp_info *
+bgp_info_backup (struct bgp *bgp, struct bgp_node *rn,
+                 struct bgp_info *selected, afi_t afi, safi_t safi)
+{
+  struct bgp_info *ri;
+  struct bgp_info *backup = NULL;
+
+  for (ri = rn->info; ri; ri = ri->next)
+    {
+      if (ri == selected
+          || CHECK_FLAG (ri->flags, BGP_INFO_MULTIPATH)
+          || BGP_INFO_HOLDDOWN (ri))
+        continue;
+      if (ri->type != ZEBRA_ROUTE_BGP || ri->sub_type != BGP_ROUTE_NORMAL)
+        continue;
+      if (ri->peer == selected->peer || ri->peer->status != Established)
+        continue;
+      if (afi == AFI_IP
+          && IPV4_ADDR_SAME (&ri->attr->nexthop, &selected->attr->nexthop))
+        continue;
+
+      if (bgp_info_cmp (bgp, ri, backup, afi, safi) == -1)
+        backup = ri;
+    }
+
+  return backup;
+}
+
+/* Can the path of a table shared by route server clients, a view or a
+ * peer-group, be sent to the client?  These are the checks done on
+ * insertion into the table of a client of its own.
+ */
+static int
+bgp_rsclient_accept (struct bgp_info *ri, struct peer *rsclient,
+                     afi_t afi, safi_t safi)
+{
+  struct attr *attr = ri->attr;
+
+  if (ri->peer == rsclient)
+    return 0;
+
+  if (aspath_loop_check (attr->aspath, rsclient->as)
+      > rsclient->allowas_in[afi][safi])
+    return 0;
+
+  if ((attr->flag & ATTR_FLAG_BIT (BGP_ATTR_ORIGINATOR_ID))
+      && IPV4_ADDR_SAME (&rsclient->remote_id, &attr->extra->originator_id))
+    return 0;
+
+  return 1;
+}
+
+/* Best path of a shared table among those which can be sent to the
+ * client, when the selected one can't.
+ */
+static struct bgp_info *
+bgp_rsclient_select (struct bgp *bgp, struct bgp_node *rn,
+                     struct peer *rsclient, afi_t afi, safi_t safi)
+{
+  struct bgp_info *ri;
+  struct bgp_info *best = NULL;
+
+  for (ri = rn->info; ri; ri = ri->next)
+    {
+      if (BGP_INFO_HOLDDOWN (ri))
+        continue;
+      if (ri->peer &&
+          ri->peer != bgp->peer_self &&
+          !CHECK_FLAG (ri->peer->sflags, PEER_STATUS_NSF_WAIT))
+        if (ri->peer->status != Established)
+          continue;
+      if (! bgp_rsclient_accept (ri, rsclient, afi, safi))
+        continue;
+
+      if (bgp_info_cmp (bgp, ri, best, afi, safi) == -1)
+        best = ri;
+    }
+
+  return best;
+}
+
+/* Path of a shared table to send to a member: the selected one, or the
+ * one cached for the member, picked when first needed.
+ */
+static struct bgp_info *
+bgp_rsclient_best (struct peer_group *group, struct bgp_node *rn,
+                   struct peer *rsclient, struct bgp_info *selected,
+                   afi_t afi, safi_t safi)
+{
+  struct bgp_info *ri;
+
+  if (selected == NULL || bgp_rsclient_accept (selected, rsclient, afi, safi))
+    return selected;
+
+  if (bgp_rsview_delta_get (group, rn, rsclient, &ri)
+      && ! (ri && CHECK_FLAG (ri->flags, BGP_INFO_REMOVED)))
+    return ri;
+
+  ri = bgp_rsclient_select (group->bgp, rn, rsclient, afi, safi);
+  bgp_rsview_delta_set (group, rn, rsclient, ri);
+  return ri;
+}
+
 static int
 bgp_process_announce_selected (struct peer *peer, struct bgp_info *selected,
                                struct bgp_node *rn, afi_t afi, safi_t safi)
@@ -1522,8 +1624,66 @@ struct bgp_process_queue
   struct bgp_node *rn;
   afi_t afi;
   safi_t safi;
+
+  /* Peer whose update changed the node, and when. */
+  struct peer *peer;
+  struct timeval queued;
 };
 
+/* Announce the node of a table shared by route server clients to its
+ * members: the selected path to those it can be sent to, and to the
+ * others the best path they can be sent, kept as a delta of the member.
+ * A member is only sent what changed for it.
+ */
+static void
+bgp_process_rsclient_group (struct peer_group *group, struct bgp_node *rn,
+                            struct bgp_info *old_select,
+                            struct bgp_info *new_select, int attr_changed,
+                            afi_t afi, safi_t safi)
+{
+  struct peer *rsclient;
+  struct listnode *node, *nnode;
+  struct bgp_info *prev;
+  struct bgp_info *best;
+  int cached, same;
+
+  for (ALL_LIST_ELEMENTS (group->peer, node, nnode, rsclient))
+    {
+      /* Sent the table when it comes up. */
+      if (rsclient->status != Established)
+        continue;
+
+      cached = bgp_rsview_delta_get (group, rn, rsclient, &prev);
+      if (! cached)
+        prev = old_select;
+
+      if (new_select == NULL
+          || bgp_rsclient_accept (new_select, rsclient, afi, safi))
+        {
+          best = new_select;
+          same = (best == prev && ! attr_changed);
+          if (cached)
+            bgp_rsview_delta_unset (group, rn, rsclient);
+        }
+      else
+        {
+          best = bgp_rsclient_select (group->bgp, rn, rsclient, afi, safi);
+          same = (best == prev
+                  && ! (best && CHECK_FLAG (best->flags,
+                                            BGP_INFO_ATTR_CHANGED)));
+          bgp_rsview_delta_set (group, rn, rsclient, best);
+        }
+
+      /* Nothing to do. */
+      if (same)
+        continue;
+
+      bgp_process_announce_selected (rsclient, best, rn, afi, safi);
+    }
+
+  bgp_rsview_delta_done (group, rn);
+}
+
 static wq_item_status
 bgp_process_rsclient (struct work_queue *wq, void *data)
 {
@@ -1535,36 +1695,46 @@ bgp_process_rsclient (struct work_queue *wq, void *data)
   struct bgp_info *new_select;
   struct bgp_info *old_select;
   struct bgp_info_pair old_and_new;
-  struct listnode *node, *nnode;
   struct peer *rsclient = bgp_node_table (rn)->owner;
+  int attr_changed;
   
   /* Best path selection. */
   bgp_best_selection (bgp, rn, &old_and_new, afi, safi);
   new_select = old_and_new.new;
   old_select = old_and_new.old;
 
-  if (CHECK_FLAG (rsclient->sflags, PEER_STATUS_GROUP))
+  /* Restarting: selected now, announced when the restart is done */
+  if (bgp->gr_restarting)
     {
-      if (rsclient->group)
-        for (ALL_LIST_ELEMENTS (rsclient->group->peer, node, nnode, rsclient))
-          {
-            /* Nothing to do. */
-            if (old_select && old_select == new_select)
-              if (!CHECK_FLAG (old_select->flags, BGP_INFO_ATTR_CHANGED))
-                continue;
-
-            if (old_select)
-              bgp_info_unset_flag (rn, old_select, BGP_INFO_SELECTED);
-            if (new_select)
-              {
-                bgp_info_set_flag (rn, new_select, BGP_INFO_SELECTED);
-                bgp_info_unset_flag (rn, new_select, BGP_INFO_ATTR_CHANGED);
-		UNSET_FLAG (new_select->flags, BGP_INFO_MULTIPATH_CHG);
-             }
+      if (old_select)
+        bgp_info_unset_flag (rn, old_select, BGP_INFO_SELECTED);
+      if (new_select)
+        {
+          bgp_info_set_flag (rn, new_select, BGP_INFO_SELECTED);
+          bgp_info_unset_flag (rn, new_select, BGP_INFO_ATTR_CHANGED);
+          UNSET_FLAG (new_select->flags, BGP_INFO_MULTIPATH_CHG);
+        }
+      /* The paths for the members are picked again then */
+      if (CHECK_FLAG (rsclient->sflags, PEER_STATUS_GROUP) && rsclient->group)
+        bgp_rsview_delta_flush (rsclient->group, rn);
+    }
+  else if (CHECK_FLAG (rsclient->sflags, PEER_STATUS_GROUP))
+    {
+      attr_changed = (new_select && old_select == new_select
+                      && CHECK_FLAG (new_select->flags,
+                                     BGP_INFO_ATTR_CHANGED));
+      if (old_select)
+        bgp_info_unset_flag (rn, old_select, BGP_INFO_SELECTED);
+      if (new_select)
+        {
+          bgp_info_set_flag (rn, new_select, BGP_INFO_SELECTED);
+          bgp_info_unset_flag (rn, new_select, BGP_INFO_ATTR_CHANGED);
+          UNSET_FLAG (new_select->flags, BGP_INFO_MULTIPATH_CHG);
+        }
 
-            bgp_process_announce_selected (rsclient, new_select, rn,
-                                           afi, safi);
-          }
+      if (rsclient->group)
+        bgp_process_rsclient_group (rsclient->group, rn, old_select,
+                                    new_select, attr_changed, afi, safi);
     }
   else
     {
@@ -1594,7 +1764,6 @@ bgp_process_main (struct work_queue *wq, void *data)
   struct bgp_node *rn = pq->rn;
   afi_t afi = pq->afi;
   safi_t safi = pq->safi;
-  struct prefix *p = &rn->p;
   struct bgp_info *new_select;
   struct bgp_info *old_select;
   struct bgp_info_pair old_and_new;
@@ -1611,9 +1780,11 @@ bgp_process_main (struct work_queue *wq, void *data)
     {
       if (! CHECK_FLAG (old_select->flags, BGP_INFO_ATTR_CHANGED))
         {
-          if (CHECK_FLAG (old_select->flags, BGP_INFO_IGP_CHANGED) ||
-	      CHECK_FLAG (old_select->flags, BGP_INFO_MULTIPATH_CHG))
-            bgp_zebra_announce (p, old_select, bgp, safi);
+          if (! bgp->gr_restarting
+              && (CHECK_FLAG (old_select->flags, BGP_INFO_IGP_CHANGED) ||
+	          CHECK_FLAG (old_select->flags, BGP_INFO_MULTIPATH_CHG) ||
+	          bgp_pathlist_backup_changed (bgp, rn, old_select, safi)))
+            bgp_zebra_announce (rn, old_select, bgp, safi);
           
 	  UNSET_FLAG (old_select->flags, BGP_INFO_MULTIPATH_CHG);
           UNSET_FLAG (rn->flags, BGP_NODE_PROCESS_SCHEDULED);
@@ -1630,6 +1801,10 @@ bgp_process_main (struct work_queue *wq, void *data)
       UNSET_FLAG (new_select->flags, BGP_INFO_MULTIPATH_CHG);
     }
 
+  /* Restarting: selected now, installed and announced when the restart
+     is done, see bgp_gr_restart_end () */
+  if (bgp->gr_restarting)
+    goto reap;
 
   /* Check each BGP peer. */
   for (ALL_LIST_ELEMENTS (bgp->peer, node, nnode, peer))
@@ -1644,17 +1819,18 @@ bgp_process_main (struct work_queue *wq, void *data)
       if (new_select 
 	  && new_select->type == ZEBRA_ROUTE_BGP 
 	  && new_select->sub_type == BGP_ROUTE_NORMAL)
-	bgp_zebra_announce (p, new_select, bgp, safi);
+	bgp_zebra_announce (rn, new_select, bgp, safi);
       else
 	{
 	  /* Withdraw the route from the kernel. */
 	  if (old_select 
 	      && old_select->type == ZEBRA_ROUTE_BGP
 	      && old_select->sub_type == BGP_ROUTE_NORMAL)
-	    bgp_zebra_withdraw (p, old_select, safi);
+	    bgp_zebra_withdraw (rn, old_select, safi);
 	}
     }
     
+ reap:
   /* Reap old select bgp_info, if it has been removed */
   if (old_select && CHECK_FLAG (old_select->flags, BGP_INFO_REMOVED))
     bgp_info_reap (rn, old_select);
@@ -1663,12 +1839,54 @@ bgp_process_main (struct work_queue *wq, void *data)
   return WQ_SUCCESS;
 }
 
+static void bgp_input_refill (void);
+
+/* A node changed by a peer has been processed: account for the latency,
+ * and resume reading from the peer once its backlog has drained.
+ */
+static void
+bgp_input_done (struct bgp_process_queue *pq)
+{
+  struct peer *peer = pq->peer;
+  unsigned long latency;
+
+  latency = timeval_elapsed (recent_relative_time (), pq->queued) / 1000;
+  peer->input_latency_last = latency;
+  peer->input_latency_avg = (peer->input_latency_avg * 7 + latency) / 8;
+  if (latency > peer->input_latency_max)
+    peer->input_latency_max = latency;
+
+  peer->input_pending--;
+  if (CHECK_FLAG (peer->sflags, PEER_STATUS_INPUT_HOLD)
+      && peer->input_pending <= BGP_INPUT_RESUME)
+    {
+      UNSET_FLAG (peer->sflags, PEER_STATUS_INPUT_HOLD);
+      if (BGP_DEBUG (events, EVENTS))
+        zlog_debug ("%s input queue drained to %lu, resume reading",
+                    peer->host, peer->input_pending);
+      if (peer->status == Established && peer->fd >= 0)
+        BGP_READ_ON (peer->t_read, bgp_read, peer->fd);
+    }
+
+  peer_unlock (peer);
+}
+
 static void
 bgp_processq_del (struct work_queue *wq, void *data)
 {
   struct bgp_process_queue *pq = data;
   struct bgp_table *table = bgp_node_table (pq->rn);
   
+  if (pq->peer)
+    bgp_input_done (pq);
+
+  /* Refill the process queue from the peers' input queues, within the
+     run, which goes on without waiting for the hold again.  Done as any
+     node goes, as nodes changed by no peer may fill the queue too. */
+  if (! list_isempty (bm->input_peers)
+      && bm->process_main_queue->items->count <= BGP_INPUT_BATCH / 2)
+    bgp_input_refill ();
+
   bgp_unlock (pq->bgp);
   bgp_unlock_node (pq->rn);
   bgp_table_unlock (table);
@@ -1700,8 +1918,119 @@ bgp_process_queue_init (void)
   bm->process_rsclient_queue->spec.hold = 50;
 }
 
-void
-bgp_process (struct bgp *bgp, struct bgp_node *rn, afi_t afi, safi_t safi)
+static void
+bgp_process_queue_add (struct bgp_process_queue *pqnode)
+{
+  if ( (bm->process_main_queue == NULL) ||
+       (bm->process_rsclient_queue == NULL) )
+    bgp_process_queue_init ();
+
+  switch (bgp_node_table (pqnode->rn)->type)
+    {
+      case BGP_TABLE_MAIN:
+        work_queue_add (bm->process_main_queue, pqnode);
+        break;
+      case BGP_TABLE_RSCLIENT:
+        work_queue_add (bm->process_rsclient_queue, pqnode);
+        break;
+    }
+}
+
+/* Cost of processing a node, in paths to compare. */
+static int
+bgp_process_cost (struct bgp_node *rn)
+{
+  struct bgp_info *ri;
+  int cost = 0;
+
+  for (ri = rn->info; ri; ri = ri->next)
+    cost++;
+
+  return cost ? cost : 1;
+}
+
+/* Move nodes from the peers' input queues to the process queue, in
+ * deficit round robin: each round, a peer may dispatch nodes up to its
+ * quantum of paths plus what it did not use in the previous rounds, so
+ * that a peer sending a full table can't starve the others.  Only a
+ * batch is kept in the process queue, refilled as it is processed.
+ */
+static void
+bgp_input_refill (void)
+{
+  struct peer *peer;
+  struct listnode *node;
+  struct bgp_process_queue *pq;
+  int cost;
+
+  if (bm->process_main_queue == NULL)
+    bgp_process_queue_init ();
+
+  while (! list_isempty (bm->input_peers)
+         && bm->process_main_queue->items->count < BGP_INPUT_BATCH)
+    {
+      peer = listgetdata (listhead (bm->input_peers));
+      listnode_delete (bm->input_peers, peer);
+
+      peer->input_deficit += BGP_INPUT_QUANTUM;
+      while ((node = listhead (peer->input_queue)) != NULL)
+        {
+          pq = listgetdata (node);
+          cost = bgp_process_cost (pq->rn);
+          if (cost > peer->input_deficit)
+            break;
+
+          peer->input_deficit -= cost;
+          list_delete_node (peer->input_queue, node);
+          bgp_process_queue_add (pq);
+        }
+
+      if (list_isempty (peer->input_queue))
+        peer->input_deficit = 0;
+      else
+        listnode_add (bm->input_peers, peer);
+    }
+}
+
+static int
+bgp_input_dispatch (struct thread *thread)
+{
+  bm->t_input = NULL;
+  bgp_input_refill ();
+  return 0;
+}
+
+static void
+bgp_input_schedule (void)
+{
+  if (! bm->t_input)
+    bm->t_input = thread_add_event (bm->master, bgp_input_dispatch, NULL, 0);
+}
+
+/* Dispatch all input queues at once, ignoring fairness. */
+static void
+bgp_input_flush (void)
+{
+  struct peer *peer;
+  struct listnode *node;
+
+  while (! list_isempty (bm->input_peers))
+    {
+      peer = listgetdata (listhead (bm->input_peers));
+      listnode_delete (bm->input_peers, peer);
+
+      while ((node = listhead (peer->input_queue)) != NULL)
+        {
+          bgp_process_queue_add (listgetdata (node));
+          list_delete_node (peer->input_queue, node);
+        }
+      peer->input_deficit = 0;
+    }
+}
+
+static void
+bgp_process_enqueue (struct bgp *bgp, struct bgp_node *rn, afi_t afi,
+                     safi_t safi, struct peer *peer)
 {
   struct bgp_process_queue *pqnode;
   
@@ -1722,10 +2051,6 @@ bgp_process (struct bgp *bgp, struct bgp_node *rn, afi_t afi, safi_t safi)
       return;
     }
   
-  if ( (bm->process_main_queue == NULL) ||
-       (bm->process_rsclient_queue == NULL) )
-    bgp_process_queue_init ();
-  
   pqnode = XCALLOC (MTYPE_BGP_PROCESS_QUEUE, 
                     sizeof (struct bgp_process_queue));
   if (!pqnode)
@@ -1739,18 +2064,63 @@ bgp_process (struct bgp *bgp, struct bgp_node *rn, afi_t afi, safi_t safi)
   pqnode->afi = afi;
   pqnode->safi = safi;
   
-  switch (bgp_node_table (rn)->type)
+  SET_FLAG (rn->flags, BGP_NODE_PROCESS_SCHEDULED);
+
+  /* Changes to the main RIB made by a peer wait in its input queue. */
+  if (peer == NULL || bgp_node_table (rn)->type != BGP_TABLE_MAIN)
     {
-      case BGP_TABLE_MAIN:
-        work_queue_add (bm->process_main_queue, pqnode);
-        break;
-      case BGP_TABLE_RSCLIENT:
-        work_queue_add (bm->process_rsclient_queue, pqnode);
-        break;
+      bgp_process_queue_add (pqnode);
+      return;
     }
-  
-  SET_FLAG (rn->flags, BGP_NODE_PROCESS_SCHEDULED);
-  return;
+
+  pqnode->peer = peer_lock (peer);
+  pqnode->queued = recent_relative_time ();
+
+  if (! peer->input_queue)
+    peer->input_queue = list_new ();
+  if (list_isempty (peer->input_queue))
+    listnode_add (bm->input_peers, peer);
+  listnode_add (peer->input_queue, pqnode);
+
+  peer->input_pending++;
+  if (peer->input_pending > peer->input_pending_max)
+    peer->input_pending_max = peer->input_pending;
+
+  bgp_input_schedule ();
+}
+
+void
+bgp_process (struct bgp *bgp, struct bgp_node *rn, afi_t afi, safi_t safi)
+{
+  bgp_process_enqueue (bgp, rn, afi, safi, NULL);
+}
+
+/* Process a node changed by an update from, or clearing of, a peer. */
+static void
+bgp_process_input (struct peer *peer, struct bgp_node *rn,
+                   afi_t afi, safi_t safi)
+{
+  bgp_process_enqueue (peer->bgp, rn, afi, safi, peer);
+}
+
+/* Stop reading from a peer whose changes wait for processing beyond its
+ * budget, until bgp_input_done() finds its backlog drained.
+ */
+void
+bgp_input_throttle (struct peer *peer)
+{
+  if (peer->input_pending <= BGP_INPUT_BUDGET
+      || peer->status != Established
+      || CHECK_FLAG (peer->sflags, PEER_STATUS_INPUT_HOLD))
+    return;
+
+  if (BGP_DEBUG (events, EVENTS))
+    zlog_debug ("%s input queue over budget (%lu nodes), hold reading",
+                peer->host, peer->input_pending);
+
+  SET_FLAG (peer->sflags, PEER_STATUS_INPUT_HOLD);
+  peer->input_holds++;
+  BGP_READ_OFF (peer->t_read);
 }
 
 static int
@@ -1858,7 +2228,7 @@ bgp_rib_remove (struct bgp_node *rn, struct bgp_info *ri, struct peer *peer,
   if (!CHECK_FLAG (ri->flags, BGP_INFO_HISTORY))
     bgp_info_delete (rn, ri); /* keep historical info */
     
-  bgp_process (peer->bgp, rn, afi, safi);
+  bgp_process_input (peer, rn, afi, safi);
 }
 
 static void
@@ -1967,7 +2337,7 @@ bgp_update_rsclient (struct peer *rsclient, afi_t afi, safi_t safi,
   /* If the update is implicit withdraw. */
   if (ri)
     {
-      ri->uptime = bgp_clock ();
+      BGP_INFO_UPTIME_SET (ri);
 
       /* Same attribute comes in. */
       if (!CHECK_FLAG(ri->flags, BGP_INFO_REMOVED)
@@ -2006,6 +2376,7 @@ bgp_update_rsclient (struct peer *rsclient, afi_t afi, safi_t safi,
       /* Update to new attribute.  */
       bgp_attr_unintern (&ri->attr);
       ri->attr = attr_new;
+      UNSET_FLAG (ri->flags, BGP_INFO_KEY_VALID);
 
       /* Update MPLS tag.  */
       if (safi == SAFI_MPLS_VPN)
@@ -2035,7 +2406,7 @@ bgp_update_rsclient (struct peer *rsclient, afi_t afi, safi_t safi,
   new->sub_type = sub_type;
   new->peer = peer;
   new->attr = attr_new;
-  new->uptime = bgp_clock ();
+  BGP_INFO_UPTIME_SET (new);
 
   /* Update MPLS tag. */
   if (safi == SAFI_MPLS_VPN)
@@ -2228,7 +2599,7 @@ bgp_update_main (struct peer *peer, struct prefix *p, struct attr *attr,
   /* If the update is implicit withdraw. */
   if (ri)
     {
-      ri->uptime = bgp_clock ();
+      BGP_INFO_UPTIME_SET (ri);
 
       /* Same attribute comes in. */
       if (!CHECK_FLAG (ri->flags, BGP_INFO_REMOVED) 
@@ -2249,7 +2620,7 @@ bgp_update_main (struct peer *peer, struct prefix *p, struct attr *attr,
 	      if (bgp_damp_update (ri, rn, afi, safi) != BGP_DAMP_SUPPRESSED)
 	        {
                   bgp_aggregate_increment (bgp, p, ri, afi, safi);
-                  bgp_process (bgp, rn, afi, safi);
+                  bgp_process_input (peer, rn, afi, safi);
                 }
 	    }
           else /* Duplicate - odd */
@@ -2265,7 +2636,7 @@ bgp_update_main (struct peer *peer, struct prefix *p, struct attr *attr,
 	      if (CHECK_FLAG (ri->flags, BGP_INFO_STALE))
 		{
 		  bgp_info_unset_flag (rn, ri, BGP_INFO_STALE);
-		  bgp_process (bgp, rn, afi, safi);
+		  bgp_process_input (peer, rn, afi, safi);
 		}
 	    }
 
@@ -2319,6 +2690,7 @@ bgp_update_main (struct peer *peer, struct prefix *p, struct attr *attr,
       /* Update to new attribute.  */
       bgp_attr_unintern (&ri->attr);
       ri->attr = attr_new;
+      UNSET_FLAG (ri->flags, BGP_INFO_KEY_VALID);
 
       /* Update MPLS tag.  */
       if (safi == SAFI_MPLS_VPN)
@@ -2360,7 +2732,7 @@ bgp_update_main (struct peer *peer, struct prefix *p, struct attr *attr,
       /* Process change. */
       bgp_aggregate_increment (bgp, p, ri, afi, safi);
 
-      bgp_process (bgp, rn, afi, safi);
+      bgp_process_input (peer, rn, afi, safi);
       bgp_unlock_node (rn);
 
       return 0;
@@ -2381,7 +2753,7 @@ bgp_update_main (struct peer *peer, struct prefix *p, struct attr *attr,
   new->sub_type = sub_type;
   new->peer = peer;
   new->attr = attr_new;
-  new->uptime = bgp_clock ();
+  BGP_INFO_UPTIME_SET (new);
 
   /* Update MPLS tag. */
   if (safi == SAFI_MPLS_VPN)
@@ -2420,7 +2792,7 @@ bgp_update_main (struct peer *peer, struct prefix *p, struct attr *attr,
     return -1;
 
   /* Process change. */
-  bgp_process (bgp, rn, afi, safi);
+  bgp_process_input (peer, rn, afi, safi);
 
   return 0;
 
@@ -2628,51 +3000,269 @@ bgp_default_originate (struct peer *peer, afi_t afi, safi_t safi, int withdraw)
     }
   else
     {
-      if (! CHECK_FLAG (peer->af_sflags[afi][safi], PEER_STATUS_DEFAULT_ORIGINATE))
+      if (! CHECK_FLAG (peer->af_sflags[afi][safi], PEER_STATUS_DEFAULT_ORIGINATE))
+        {
+          SET_FLAG (peer->af_sflags[afi][safi], PEER_STATUS_DEFAULT_ORIGINATE);
+          bgp_default_update_send (peer, &attr, afi, safi, from);
+        }
+    }
+  
+  bgp_attr_extra_free (&attr);
+  aspath_unintern (&aspath);
+}
+
+static void
+bgp_announce_table (struct peer *peer, afi_t afi, safi_t safi,
+                   struct bgp_table *table, int rsclient)
+{
+  struct bgp_node *rn;
+  struct bgp_info *ri;
+  struct peer_group *group = NULL;
+  struct attr attr;
+  struct attr_extra extra;
+
+  memset(&extra, 0, sizeof(extra));
+
+  if (! table)
+    table = (rsclient) ? peer->rib[afi][safi] : peer->bgp->rib[afi][safi];
+
+  if ((safi != SAFI_MPLS_VPN) && (safi != SAFI_ENCAP)
+      && CHECK_FLAG (peer->af_flags[afi][safi], PEER_FLAG_DEFAULT_ORIGINATE))
+    bgp_default_originate (peer, afi, safi, 0);
+
+  /* It's initialized in bgp_announce_[check|check_rsclient]() */
+  attr.extra = &extra;
+
+  /* A table shared with other clients */
+  if (rsclient && CHECK_FLAG (table->owner->sflags, PEER_STATUS_GROUP))
+    group = table->owner->group;
+
+  for (rn = bgp_table_top (table); rn; rn = bgp_route_next(rn))
+    for (ri = rn->info; ri; ri = ri->next)
+      if (CHECK_FLAG (ri->flags, BGP_INFO_SELECTED))
+	{
+	  if (group)
+	    ri = bgp_rsclient_best (group, rn, peer, ri, afi, safi);
+	  else if (ri->peer == peer)
+	    break;
+
+         if (ri && ( (rsclient) ?
+              (bgp_announce_check_rsclient (ri, peer, &rn->p, &attr, afi, safi))
+              : (bgp_announce_check (ri, peer, &rn->p, &attr, afi, safi))))
+	    bgp_adj_out_set (rn, peer, &rn->p, &attr, afi, safi, ri);
+	  else
+	    bgp_adj_out_unset (rn, peer, &rn->p, afi, safi);
+	  break;
+	}
+
+  bgp_attr_flush_encap(&attr);
+}
+
+/* Table announcement.  A peer which comes up, or asks for the table
+ * again, is sent it from a walk of the RIB run in slices of about
+ * BGP_ANNOUNCE_SLICE routes checked, so that the other peers are still
+ * read and kept alive meanwhile.  The peers which ask while a walk is running
+ * join it at its current node, and the walk wraps around the table
+ * until it comes back to the node each of them joined at: a burst of
+ * peers coming up shares one walk, and the policy evaluation of a node
+ * for all of them.
+ */
+struct bgp_announce_peer
+{
+  struct peer *peer;
+
+  /* Node the peer joined the walk at, locked, and whether the walk
+     wrapped around the table since. */
+  struct bgp_node *start;
+  int wrapped;
+};
+
+struct bgp_announce_job
+{
+  struct bgp *bgp;
+  afi_t afi;
+  safi_t safi;
+
+  /* Next node of the walk, locked. */
+  struct bgp_node *rn;
+
+  /* struct bgp_announce_peer */
+  struct list *peers;
+
+  struct thread *t_walk;
+};
+
+static void
+bgp_announce_job_free (struct bgp_announce_job *job)
+{
+  THREAD_OFF (job->t_walk);
+  if (job->rn)
+    bgp_unlock_node (job->rn);
+  list_delete (job->peers);
+  job->bgp->announce[job->afi][job->safi] = NULL;
+  XFREE (MTYPE_BGP_ANNOUNCE, job);
+}
+
+static void
+bgp_announce_peer_done (struct bgp_announce_job *job,
+                        struct bgp_announce_peer *ap)
+{
+  struct peer *peer = ap->peer;
+
+  if (BGP_DEBUG (events, EVENTS))
+    zlog_debug ("%s %s table announced", peer->host,
+                afi_safi_print (job->afi, job->safi));
+
+  UNSET_FLAG (peer->af_sflags[job->afi][job->safi], PEER_STATUS_ANNOUNCE);
+  listnode_delete (job->peers, ap);
+  bgp_unlock_node (ap->start);
+  XFREE (MTYPE_BGP_ANNOUNCE, ap);
+
+  /* End-of-RIB was held back for the announcement */
+  if (peer->status == Established && peer->fd >= 0)
+    BGP_WRITE_ON (peer->t_write, bgp_write, peer->fd);
+  peer_unlock (peer); /* announce job reference */
+}
+
+static int
+bgp_announce_walk (struct thread *thread)
+{
+  struct bgp_announce_job *job;
+  struct bgp_announce_peer *ap;
+  struct listnode *node, *nnode;
+  struct bgp_node *rn;
+  struct bgp_info *ri;
+  struct attr attr;
+  struct attr_extra extra;
+  afi_t afi;
+  safi_t safi;
+  int budget;
+
+  job = THREAD_ARG (thread);
+  job->t_walk = NULL;
+  afi = job->afi;
+  safi = job->safi;
+
+  /* It's initialized in bgp_announce_check() */
+  memset (&extra, 0, sizeof (extra));
+  attr.extra = &extra;
+
+  for (budget = BGP_ANNOUNCE_SLICE; budget > 0;
+       budget -= listcount (job->peers))
+    {
+      rn = job->rn;
+
+      for (ALL_LIST_ELEMENTS (job->peers, node, nnode, ap))
+        if (ap->wrapped && ap->start == rn)
+          bgp_announce_peer_done (job, ap);
+      if (list_isempty (job->peers))
+        break;
+
+      for (ri = rn->info; ri; ri = ri->next)
+        if (CHECK_FLAG (ri->flags, BGP_INFO_SELECTED))
+          for (ALL_LIST_ELEMENTS_RO (job->peers, node, ap))
+            {
+              if (ri->peer == ap->peer)
+                continue;
+              if (bgp_announce_check (ri, ap->peer, &rn->p, &attr, afi, safi))
+                bgp_adj_out_set (rn, ap->peer, &rn->p, &attr, afi, safi, ri);
+              else
+                bgp_adj_out_unset (rn, ap->peer, &rn->p, afi, safi);
+            }
+
+      job->rn = bgp_route_next (rn);
+      if (job->rn == NULL)
         {
-          SET_FLAG (peer->af_sflags[afi][safi], PEER_STATUS_DEFAULT_ORIGINATE);
-          bgp_default_update_send (peer, &attr, afi, safi, from);
+          /* The start nodes keep the table from being empty. */
+          for (ALL_LIST_ELEMENTS_RO (job->peers, node, ap))
+            ap->wrapped = 1;
+          job->rn = bgp_table_top (job->bgp->rib[afi][safi]);
         }
     }
-  
-  bgp_attr_extra_free (&attr);
-  aspath_unintern (&aspath);
+
+  bgp_attr_flush_encap (&attr);
+
+  if (list_isempty (job->peers))
+    bgp_announce_job_free (job);
+  else
+    job->t_walk = thread_add_event (bm->master, bgp_announce_walk, job, 0);
+
+  return 0;
 }
 
 static void
-bgp_announce_table (struct peer *peer, afi_t afi, safi_t safi,
-                   struct bgp_table *table, int rsclient)
+bgp_announce_table_start (struct peer *peer, afi_t afi, safi_t safi)
 {
+  struct bgp *bgp = peer->bgp;
+  struct bgp_announce_job *job;
+  struct bgp_announce_peer *ap;
   struct bgp_node *rn;
-  struct bgp_info *ri;
-  struct attr attr;
-  struct attr_extra extra;
+  struct listnode *node;
 
-  memset(&extra, 0, sizeof(extra));
+  if (CHECK_FLAG (peer->af_flags[afi][safi], PEER_FLAG_DEFAULT_ORIGINATE))
+    bgp_default_originate (peer, afi, safi, 0);
 
-  if (! table)
-    table = (rsclient) ? peer->rib[afi][safi] : peer->bgp->rib[afi][safi];
+  job = bgp->announce[afi][safi];
+  if (job == NULL)
+    {
+      if ((rn = bgp_table_top (bgp->rib[afi][safi])) == NULL)
+        return;
 
-  if ((safi != SAFI_MPLS_VPN) && (safi != SAFI_ENCAP)
-      && CHECK_FLAG (peer->af_flags[afi][safi], PEER_FLAG_DEFAULT_ORIGINATE))
-    bgp_default_originate (peer, afi, safi, 0);
+      job = XCALLOC (MTYPE_BGP_ANNOUNCE, sizeof (struct bgp_announce_job));
+      job->bgp = bgp;
+      job->afi = afi;
+      job->safi = safi;
+      job->rn = rn;
+      job->peers = list_new ();
+      job->t_walk = thread_add_event (bm->master, bgp_announce_walk, job, 0);
+      bgp->announce[afi][safi] = job;
+    }
 
-  /* It's initialized in bgp_announce_[check|check_rsclient]() */
-  attr.extra = &extra;
+  /* A peer asking again is sent the whole table from the current node. */
+  for (ALL_LIST_ELEMENTS_RO (job->peers, node, ap))
+    if (ap->peer == peer)
+      break;
+  if (node == NULL)
+    {
+      ap = XCALLOC (MTYPE_BGP_ANNOUNCE, sizeof (struct bgp_announce_peer));
+      ap->peer = peer_lock (peer); /* announce job reference */
+      listnode_add (job->peers, ap);
+    }
+  else
+    bgp_unlock_node (ap->start);
 
-  for (rn = bgp_table_top (table); rn; rn = bgp_route_next(rn))
-    for (ri = rn->info; ri; ri = ri->next)
-      if (CHECK_FLAG (ri->flags, BGP_INFO_SELECTED) && ri->peer != peer)
-	{
-         if ( (rsclient) ?
-              (bgp_announce_check_rsclient (ri, peer, &rn->p, &attr, afi, safi))
-              : (bgp_announce_check (ri, peer, &rn->p, &attr, afi, safi)))
-	    bgp_adj_out_set (rn, peer, &rn->p, &attr, afi, safi, ri);
-	  else
-	    bgp_adj_out_unset (rn, peer, &rn->p, afi, safi);
-	}
+  ap->start = bgp_lock_node (job->rn);
+  ap->wrapped = 0;
+  SET_FLAG (peer->af_sflags[afi][safi], PEER_STATUS_ANNOUNCE);
+}
 
-  bgp_attr_flush_encap(&attr);
+/* Stop sending the tables to a peer going down.  The jobs are looked
+ * through, as PEER_STATUS_ANNOUNCE is cleared along with the other
+ * sflags of a family deactivated before the peer is stopped. */
+void
+bgp_announce_peer_down (struct peer *peer)
+{
+  struct bgp_announce_job *job;
+  struct bgp_announce_peer *ap;
+  struct listnode *node;
+  afi_t afi;
+  safi_t safi;
+
+  for (afi = AFI_IP; afi < AFI_MAX; afi++)
+    for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
+      {
+        if ((job = peer->bgp->announce[afi][safi]) == NULL)
+          continue;
+
+        for (ALL_LIST_ELEMENTS_RO (job->peers, node, ap))
+          if (ap->peer == peer)
+            {
+              bgp_announce_peer_done (job, ap);
+              break;
+            }
+        if (list_isempty (job->peers))
+          bgp_announce_job_free (job);
+      }
 }
 
 void
@@ -2687,12 +3277,16 @@ bgp_announce_route (struct peer *peer, afi_t afi, safi_t safi)
   if (! peer->afc_nego[afi][safi])
     return;
 
+  /* Restarting: the table is sent once the restart is done */
+  if (peer->bgp->gr_restarting)
+    return;
+
   /* First update is deferred until ORF or ROUTE-REFRESH is received */
   if (CHECK_FLAG (peer->af_sflags[afi][safi], PEER_STATUS_ORF_WAIT_REFRESH))
     return;
 
   if ((safi != SAFI_MPLS_VPN) && (safi != SAFI_ENCAP))
-    bgp_announce_table (peer, afi, safi, NULL, 0);
+    bgp_announce_table_start (peer, afi, safi);
   else
     for (rn = bgp_table_top (peer->bgp->rib[afi][safi]); rn;
 	 rn = bgp_route_next(rn))
@@ -2817,37 +3411,288 @@ bgp_soft_reconfig_in (struct peer *peer, afi_t afi, safi_t safi)
 }
 
 
+/* Drop an entry of a peer index. */
+static void
+bgp_peer_index_unlock (struct bgp_node *rn)
+{
+  struct bgp_table *table = bgp_node_table (rn);
+
+  bgp_unlock_node (rn);
+  bgp_table_unlock (table);
+}
+
+/* Whether the peer still has a route, an adj-in or an adj-out in the
+ * node.  Removed routes go with the processing of the node.
+ */
+static int
+bgp_peer_index_live (struct peer *peer, struct bgp_node *rn)
+{
+  struct bgp_info *ri;
+  struct bgp_adj_in *ain;
+  struct bgp_adj_out *aout;
+
+  for (ri = rn->info; ri; ri = ri->next)
+    if (ri->peer == peer && ! CHECK_FLAG (ri->flags, BGP_INFO_REMOVED))
+      return 1;
+  for (ain = rn->adj_in; ain; ain = ain->next)
+    if (ain->peer == peer)
+      return 1;
+  for (aout = rn->adj_out; aout; aout = aout->next)
+    if (aout->peer == peer)
+      return 1;
+  return 0;
+}
+
+/* Drop the entries of nodes the peer has nothing left in, and the
+ * duplicates, and release the array once empty.
+ */
+static void
+bgp_peer_index_compact (struct peer *peer, struct bgp_peer_index *index)
+{
+  struct bgp_node *rn;
+  unsigned int i, count = 0;
+
+  for (i = 0; i < index->count; i++)
+    {
+      rn = index->node[i];
+      if (! CHECK_FLAG (rn->flags, BGP_NODE_INDEXED)
+          && bgp_peer_index_live (peer, rn))
+        {
+          SET_FLAG (rn->flags, BGP_NODE_INDEXED);
+          index->node[count++] = rn;
+        }
+      else
+        bgp_peer_index_unlock (rn);
+    }
+  for (i = 0; i < count; i++)
+    UNSET_FLAG (index->node[i]->flags, BGP_NODE_INDEXED);
+  index->count = count;
+
+  if (count == 0 && index->node)
+    {
+      XFREE (MTYPE_BGP_PEER_INDEX_NODE, index->node);
+      index->size = 0;
+    }
+}
+
+/* The index of the peer for a node, if the node is indexed. */
+static struct bgp_peer_index *
+bgp_peer_index_get (struct peer *peer, struct bgp_node *rn)
+{
+  struct bgp_table *table;
+
+  /* standalone nodes are not in any table */
+  if (bgp_node_to_rnode (rn)->table == NULL)
+    return NULL;
+
+  table = bgp_node_table (rn);
+  if (table->type != BGP_TABLE_MAIN || peer == peer->bgp->peer_self)
+    return NULL;
+
+  if (peer->rib_index[table->afi][table->safi] == NULL)
+    peer->rib_index[table->afi][table->safi]
+      = XCALLOC (MTYPE_BGP_PEER_INDEX, sizeof (struct bgp_peer_index));
+  return peer->rib_index[table->afi][table->safi];
+}
+
+/* Record that the peer added a route, an adj-in or an adj-out to a node
+ * of the main RIB.  A full array is compacted first, and grows when that
+ * does not free half of it, which keeps the cost of compaction constant
+ * per entry.
+ */
+void
+bgp_peer_index_add (struct peer *peer, struct bgp_node *rn)
+{
+  struct bgp_peer_index *index;
+
+  if ((index = bgp_peer_index_get (peer, rn)) == NULL)
+    return;
+
+  /* Routes and adjacencies of a node are mostly added one after the
+     other. */
+  if (index->count && index->node[index->count - 1] == rn)
+    return;
+
+  if (index->count == index->size)
+    {
+      /* not under the feet of the clearing */
+      if (! index->clearing)
+        bgp_peer_index_compact (peer, index);
+      if (index->count >= index->size / 2)
+        {
+          index->size = index->size ? index->size * 2 : BGP_PEER_INDEX_MIN;
+          index->node = XREALLOC (MTYPE_BGP_PEER_INDEX_NODE, index->node,
+                                  index->size * sizeof (struct bgp_node *));
+        }
+    }
+
+  bgp_table_lock (bgp_node_table (rn));
+  index->node[index->count++] = bgp_lock_node (rn);
+}
+
+/* Record that a route of the peer in the node was marked stale. */
+static void
+bgp_peer_index_stale (struct peer *peer, struct bgp_node *rn)
+{
+  struct bgp_peer_index *index;
+
+  if ((index = bgp_peer_index_get (peer, rn)) == NULL)
+    return;
+
+  if (index->stale_count == index->stale_size)
+    {
+      index->stale_size = index->stale_size ? index->stale_size * 2
+                                            : BGP_PEER_INDEX_MIN;
+      index->stale = XREALLOC (MTYPE_BGP_PEER_INDEX_NODE, index->stale,
+                               index->stale_size * sizeof (struct bgp_node *));
+    }
+
+  bgp_table_lock (bgp_node_table (rn));
+  index->stale[index->stale_count++] = bgp_lock_node (rn);
+}
+
+static void
+bgp_peer_index_stale_release (struct bgp_peer_index *index)
+{
+  while (index->stale_count)
+    bgp_peer_index_unlock (index->stale[--index->stale_count]);
+  if (index->stale)
+    XFREE (MTYPE_BGP_PEER_INDEX_NODE, index->stale);
+  index->stale_size = 0;
+}
+
+void
+bgp_peer_index_free (struct peer *peer)
+{
+  struct bgp_peer_index *index;
+  afi_t afi;
+  safi_t safi;
+
+  for (afi = AFI_IP; afi < AFI_MAX; afi++)
+    for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
+      if ((index = peer->rib_index[afi][safi]) != NULL)
+        {
+          while (index->count)
+            bgp_peer_index_unlock (index->node[--index->count]);
+          if (index->node)
+            XFREE (MTYPE_BGP_PEER_INDEX_NODE, index->node);
+          bgp_peer_index_stale_release (index);
+          XFREE (MTYPE_BGP_PEER_INDEX, index);
+          peer->rib_index[afi][safi] = NULL;
+        }
+}
+
 struct bgp_clear_node_queue
 {
   struct bgp_node *rn;
   enum bgp_clear_route_type purpose;
+
+  /* Without a node: clear the nodes of the peer index of afi/safi. */
+  afi_t afi;
+  safi_t safi;
 };
 
-static wq_item_status
-bgp_clear_route_node (struct work_queue *wq, void *data)
+/* Remove the adj-in and adj-out of the peer from the node. */
+static void
+bgp_clear_node_adj (struct peer *peer, struct bgp_node *rn, afi_t afi,
+                    safi_t safi, enum bgp_clear_route_type purpose)
+{
+  struct bgp_adj_in *ain;
+  struct bgp_adj_out *aout;
+
+  for (ain = rn->adj_in; ain; ain = ain->next)
+    if (ain->peer == peer || purpose == BGP_CLEAR_ROUTE_MY_RSCLIENT)
+      {
+        bgp_adj_in_remove (rn, ain);
+        bgp_unlock_node (rn);
+        break;
+      }
+  for (aout = rn->adj_out; aout; aout = aout->next)
+    if (aout->peer == peer || purpose == BGP_CLEAR_ROUTE_MY_RSCLIENT)
+      {
+        bgp_adj_out_remove (rn, aout, peer, afi, safi);
+        bgp_unlock_node (rn);
+        break;
+      }
+}
+
+/* Remove the route of the peer from the node, or mark it stale. */
+static void
+bgp_clear_node_route (struct peer *peer, struct bgp_node *rn,
+                      enum bgp_clear_route_type purpose)
 {
-  struct bgp_clear_node_queue *cnq = data;
-  struct bgp_node *rn = cnq->rn;
-  struct peer *peer = wq->spec.data;
   struct bgp_info *ri;
   afi_t afi = bgp_node_table (rn)->afi;
   safi_t safi = bgp_node_table (rn)->safi;
-  
-  assert (rn && peer);
-  
+
   for (ri = rn->info; ri; ri = ri->next)
-    if (ri->peer == peer || cnq->purpose == BGP_CLEAR_ROUTE_MY_RSCLIENT)
+    if (ri->peer == peer || purpose == BGP_CLEAR_ROUTE_MY_RSCLIENT)
       {
         /* graceful restart STALE flag set. */
         if (CHECK_FLAG (peer->sflags, PEER_STATUS_NSF_WAIT)
             && peer->nsf[afi][safi]
-            && ! CHECK_FLAG (ri->flags, BGP_INFO_STALE)
             && ! CHECK_FLAG (ri->flags, BGP_INFO_UNUSEABLE))
-          bgp_info_set_flag (rn, ri, BGP_INFO_STALE);
+          {
+            if (! CHECK_FLAG (ri->flags, BGP_INFO_STALE))
+              {
+                bgp_info_set_flag (rn, ri, BGP_INFO_STALE);
+                bgp_peer_index_stale (peer, rn);
+              }
+            /* A node of the main RIB may be indexed more than once, and
+               the stale routes of an earlier restart went when the
+               clearing started: a stale route there was marked by this
+               clearing. */
+            else if (bgp_node_table (rn)->type != BGP_TABLE_MAIN)
+              bgp_rib_remove (rn, ri, peer, afi, safi);
+          }
         else
           bgp_rib_remove (rn, ri, peer, afi, safi);
         break;
       }
+}
+
+/* Clear a slice of the nodes of the peer index, and requeue until all
+ * are cleared.
+ */
+static wq_item_status
+bgp_clear_route_index (struct peer *peer, afi_t afi, safi_t safi)
+{
+  struct bgp_peer_index *index = peer->rib_index[afi][safi];
+  struct bgp_node *rn;
+  unsigned int n;
+
+  for (n = 0; n < BGP_CLEAR_SLICE && index->clear < index->count; n++)
+    {
+      rn = index->node[index->clear++];
+      bgp_clear_node_adj (peer, rn, afi, safi, BGP_CLEAR_ROUTE_NORMAL);
+      bgp_clear_node_route (peer, rn, BGP_CLEAR_ROUTE_NORMAL);
+    }
+  if (index->clear < index->count)
+    return WQ_REQUEUE;
+
+  index->clearing = 0;
+  index->clear = 0;
+  bgp_peer_index_compact (peer, index);
+
+  /* Stale routes left over from an earlier restart went with the rest */
+  if (! CHECK_FLAG (peer->sflags, PEER_STATUS_NSF_WAIT)
+      || ! peer->nsf[afi][safi])
+    bgp_peer_index_stale_release (index);
+  return WQ_SUCCESS;
+}
+
+static wq_item_status
+bgp_clear_route_node (struct work_queue *wq, void *data)
+{
+  struct bgp_clear_node_queue *cnq = data;
+  struct peer *peer = wq->spec.data;
+  
+  assert (peer);
+
+  if (cnq->rn == NULL)
+    return bgp_clear_route_index (peer, cnq->afi, cnq->safi);
+
+  bgp_clear_node_route (peer, cnq->rn, cnq->purpose);
   return WQ_SUCCESS;
 }
 
@@ -2856,10 +3701,14 @@ bgp_clear_node_queue_del (struct work_queue *wq, void *data)
 {
   struct bgp_clear_node_queue *cnq = data;
   struct bgp_node *rn = cnq->rn;
-  struct bgp_table *table = bgp_node_table (rn);
+  struct bgp_table *table;
   
-  bgp_unlock_node (rn); 
-  bgp_table_unlock (table);
+  if (rn)
+    {
+      table = bgp_node_table (rn);
+      bgp_unlock_node (rn); 
+      bgp_table_unlock (table);
+    }
   XFREE (MTYPE_BGP_CLEAR_NODE_QUEUE, cnq);
 }
 
@@ -2912,57 +3761,15 @@ bgp_clear_route_table (struct peer *peer, afi_t afi, safi_t safi,
   if (! table)
     return;
   
+  /* The main RIB is cleared through the peer index, see
+   * bgp_clear_route_index_queue(); this walks the tables of the
+   * route server clients, every node queued for every clearing peer.
+   */
   for (rn = bgp_table_top (table); rn; rn = bgp_route_next (rn))
     {
       struct bgp_info *ri;
-      struct bgp_adj_in *ain;
-      struct bgp_adj_out *aout;
-
-      /* XXX:TODO: This is suboptimal, every non-empty route_node is
-       * queued for every clearing peer, regardless of whether it is
-       * relevant to the peer at hand.
-       *
-       * Overview: There are 3 different indices which need to be
-       * scrubbed, potentially, when a peer is removed:
-       *
-       * 1 peer's routes visible via the RIB (ie accepted routes)
-       * 2 peer's routes visible by the (optional) peer's adj-in index
-       * 3 other routes visible by the peer's adj-out index
-       *
-       * 3 there is no hurry in scrubbing, once the struct peer is
-       * removed from bgp->peer, we could just GC such deleted peer's
-       * adj-outs at our leisure.
-       *
-       * 1 and 2 must be 'scrubbed' in some way, at least made
-       * invisible via RIB index before peer session is allowed to be
-       * brought back up. So one needs to know when such a 'search' is
-       * complete.
-       *
-       * Ideally:
-       *
-       * - there'd be a single global queue or a single RIB walker
-       * - rather than tracking which route_nodes still need to be
-       *   examined on a peer basis, we'd track which peers still
-       *   aren't cleared
-       *
-       * Given that our per-peer prefix-counts now should be reliable,
-       * this may actually be achievable. It doesn't seem to be a huge
-       * problem at this time,
-       */
-      for (ain = rn->adj_in; ain; ain = ain->next)
-        if (ain->peer == peer || purpose == BGP_CLEAR_ROUTE_MY_RSCLIENT)
-          {
-            bgp_adj_in_remove (rn, ain);
-            bgp_unlock_node (rn);
-            break;
-          }
-      for (aout = rn->adj_out; aout; aout = aout->next)
-        if (aout->peer == peer || purpose == BGP_CLEAR_ROUTE_MY_RSCLIENT)
-          {
-            bgp_adj_out_remove (rn, aout, peer, afi, safi);
-            bgp_unlock_node (rn);
-            break;
-          }
+
+      bgp_clear_node_adj (peer, rn, afi, safi, purpose);
 
       for (ri = rn->info; ri; ri = ri->next)
         if (ri->peer == peer || purpose == BGP_CLEAR_ROUTE_MY_RSCLIENT)
@@ -2983,12 +3790,41 @@ bgp_clear_route_table (struct peer *peer, afi_t afi, safi_t safi,
   return;
 }
 
+/* Queue the clearing of the nodes of the peer index, as a single item
+ * walking them a slice at a time.  When already queued, the walk starts
+ * over, as the routes may have been marked stale since.
+ */
+static void
+bgp_clear_route_index_queue (struct peer *peer, afi_t afi, safi_t safi)
+{
+  struct bgp_peer_index *index = peer->rib_index[afi][safi];
+  struct bgp_clear_node_queue *cnq;
+
+  if (index == NULL || index->count == 0)
+    return;
+
+  index->clear = 0;
+  if (index->clearing)
+    return;
+
+  /* The peer went down again before it refreshed the routes kept from
+     its last restart: these go now */
+  if (index->stale_count)
+    bgp_clear_stale_route (peer, afi, safi);
+
+  index->clearing = 1;
+  cnq = XCALLOC (MTYPE_BGP_CLEAR_NODE_QUEUE,
+                 sizeof (struct bgp_clear_node_queue));
+  cnq->purpose = BGP_CLEAR_ROUTE_NORMAL;
+  cnq->afi = afi;
+  cnq->safi = safi;
+  work_queue_add (peer->clear_node_queue, cnq);
+}
+
 void
 bgp_clear_route (struct peer *peer, afi_t afi, safi_t safi,
                  enum bgp_clear_route_type purpose)
 {
-  struct bgp_node *rn;
-  struct bgp_table *table;
   struct peer *rsclient;
   struct listnode *node, *nnode;
 
@@ -3017,18 +3853,19 @@ bgp_clear_route (struct peer *peer, afi_t afi, safi_t safi,
   switch (purpose)
     {
     case BGP_CLEAR_ROUTE_NORMAL:
-      if ((safi != SAFI_MPLS_VPN) && (safi != SAFI_ENCAP))
-        bgp_clear_route_table (peer, afi, safi, NULL, NULL, purpose);
-      else
-        for (rn = bgp_table_top (peer->bgp->rib[afi][safi]); rn;
-             rn = bgp_route_next (rn))
-          if ((table = rn->info) != NULL)
-            bgp_clear_route_table (peer, afi, safi, table, NULL, purpose);
+      /* main RIB, VPN tables included */
+      bgp_clear_route_index_queue (peer, afi, safi);
 
       for (ALL_LIST_ELEMENTS (peer->bgp->rsclient, node, nnode, rsclient))
         if (CHECK_FLAG(rsclient->af_flags[afi][safi],
                        PEER_FLAG_RSERVER_CLIENT))
           bgp_clear_route_table (peer, afi, safi, NULL, rsclient, purpose);
+
+      /* What was picked for it in a shared table goes with the session. */
+      if (peer->rsview[afi][safi])
+        bgp_rsview_flush_peer (peer->rsview[afi][safi], peer);
+      else if (peer->group && peer->af_group[afi][safi])
+        bgp_rsview_flush_peer (peer->group, peer);
       break;
 
     case BGP_CLEAR_ROUTE_MY_RSCLIENT:
@@ -3109,6 +3946,7 @@ bgp_peer_clear_node_queue_drain_immediate(struct peer *peer)
 void
 bgp_process_queues_drain_immediate(void)
 {
+  bgp_input_flush ();
   bgp_drain_workqueue_immediate(bm->process_main_queue);
   bgp_drain_workqueue_immediate(bm->process_rsclient_queue);
 }
@@ -3116,14 +3954,16 @@ bgp_process_queues_drain_immediate(void)
 void
 bgp_clear_adj_in (struct peer *peer, afi_t afi, safi_t safi)
 {
-  struct bgp_table *table;
+  struct bgp_peer_index *index = peer->rib_index[afi][safi];
   struct bgp_node *rn;
   struct bgp_adj_in *ain;
+  unsigned int i;
 
-  table = peer->bgp->rib[afi][safi];
+  if (index == NULL)
+    return;
 
-  for (rn = bgp_table_top (table); rn; rn = bgp_route_next (rn))
-    for (ain = rn->adj_in; ain ; ain = ain->next)
+  for (i = 0; i < index->count; i++)
+    for (rn = index->node[i], ain = rn->adj_in; ain ; ain = ain->next)
       if (ain->peer == peer)
 	{
           bgp_adj_in_remove (rn, ain);
@@ -3135,14 +3975,22 @@ bgp_clear_adj_in (struct peer *peer, afi_t afi, safi_t safi)
 void
 bgp_clear_stale_route (struct peer *peer, afi_t afi, safi_t safi)
 {
+  struct bgp_peer_index *index = peer->rib_index[afi][safi];
   struct bgp_node *rn;
   struct bgp_info *ri;
-  struct bgp_table *table;
+  unsigned int i;
 
-  table = peer->bgp->rib[afi][safi];
+  if (index == NULL)
+    return;
 
-  for (rn = bgp_table_top (table); rn; rn = bgp_route_next (rn))
+  if (BGP_DEBUG (events, EVENTS))
+    zlog_debug ("%s sweeping %u stale routes", peer->host, index->stale_count);
+
+  /* Only the nodes where routes were marked stale, some of which the
+     peer has refreshed since */
+  for (i = 0; i < index->stale_count; i++)
     {
+      rn = index->stale[i];
       for (ri = rn->info; ri; ri = ri->next)
 	if (ri->peer == peer)
 	  {
@@ -3151,6 +3999,7 @@ bgp_clear_stale_route (struct peer *peer, afi_t afi, safi_t safi)
 	    break;
 	  }
     }
+  bgp_peer_index_stale_release (index);
 }
 
 static void
@@ -3167,7 +4016,7 @@ bgp_cleanup_table(struct bgp_table *table, safi_t safi)
         if (CHECK_FLAG (ri->flags, BGP_INFO_SELECTED)
             && ri->type == ZEBRA_ROUTE_BGP
             && ri->sub_type == BGP_ROUTE_NORMAL)
-          bgp_zebra_withdraw (&rn->p, ri, safi);
+          bgp_zebra_withdraw (rn, ri, safi);
       }
 }
 
@@ -3528,7 +4377,8 @@ bgp_static_update_rsclient (struct peer *rsclient, struct prefix *p,
 	    bgp_info_restore(rn, ri);
           bgp_attr_unintern (&ri->attr);
           ri->attr = attr_new;
-          ri->uptime = bgp_clock ();
+          UNSET_FLAG (ri->flags, BGP_INFO_KEY_VALID);
+          BGP_INFO_UPTIME_SET (ri);
 
           /* Process change. */
           bgp_process (bgp, rn, afi, safi);
@@ -3546,7 +4396,7 @@ bgp_static_update_rsclient (struct peer *rsclient, struct prefix *p,
   new->peer = bgp->peer_self;
   SET_FLAG (new->flags, BGP_INFO_VALID);
   new->attr = attr_new;
-  new->uptime = bgp_clock ();
+  BGP_INFO_UPTIME_SET (new);
 
   /* Register new BGP information. */
   bgp_info_add (rn, new);
@@ -3646,7 +4496,8 @@ bgp_static_update_main (struct bgp *bgp, struct prefix *p,
 	    bgp_aggregate_decrement (bgp, p, ri, afi, safi);
 	  bgp_attr_unintern (&ri->attr);
 	  ri->attr = attr_new;
-	  ri->uptime = bgp_clock ();
+	  UNSET_FLAG (ri->flags, BGP_INFO_KEY_VALID);
+	  BGP_INFO_UPTIME_SET (ri);
 
 	  /* Process change. */
 	  bgp_aggregate_increment (bgp, p, ri, afi, safi);
@@ -3665,7 +4516,7 @@ bgp_static_update_main (struct bgp *bgp, struct prefix *p,
   new->peer = bgp->peer_self;
   SET_FLAG (new->flags, BGP_INFO_VALID);
   new->attr = attr_new;
-  new->uptime = bgp_clock ();
+  BGP_INFO_UPTIME_SET (new);
 
   /* Aggregate address increment. */
   bgp_aggregate_increment (bgp, p, new, afi, safi);
@@ -3863,7 +4714,8 @@ bgp_static_update_safi (struct bgp *bgp, struct prefix *p,
             bgp_aggregate_decrement (bgp, p, ri, afi, safi);
           bgp_attr_unintern (&ri->attr);
           ri->attr = attr_new;
-          ri->uptime = bgp_clock ();
+          UNSET_FLAG (ri->flags, BGP_INFO_KEY_VALID);
+          BGP_INFO_UPTIME_SET (ri);
 
           /* Process change. */
           bgp_aggregate_increment (bgp, p, ri, afi, safi);
@@ -3883,7 +4735,7 @@ bgp_static_update_safi (struct bgp *bgp, struct prefix *p,
   new->peer = bgp->peer_self;
   new->attr = attr_new;
   SET_FLAG (new->flags, BGP_INFO_VALID);
-  new->uptime = bgp_clock ();
+  BGP_INFO_UPTIME_SET (new);
   new->extra = bgp_info_extra_new();
   memcpy (new->extra->tag, bgp_static->tag, 3);
 
@@ -4826,10 +5678,10 @@ bgp_aggregate_route (struct bgp *bgp, struct prefix *p, struct bgp_info *rinew,
 		      {
 			if (community)
 			  {
-			    commerge = community_merge (community,
+			    commerge = community_union (community,
 							ri->attr->community);
-			    community = community_uniq_sort (commerge);
-			    community_free (commerge);
+			    community_free (community);
+			    community = commerge;
 			  }
 			else
 			  community = community_dup (ri->attr->community);
@@ -4867,10 +5719,10 @@ bgp_aggregate_route (struct bgp *bgp, struct prefix *p, struct bgp_info *rinew,
 	    {
 	      if (community)
 		{
-		  commerge = community_merge (community,
+		  commerge = community_union (community,
 					      rinew->attr->community);
-		  community = community_uniq_sort (commerge);
-		  community_free (commerge);
+		  community_free (community);
+		  community = commerge;
 		}
 	      else
 		community = community_dup (rinew->attr->community);
@@ -4887,7 +5739,7 @@ bgp_aggregate_route (struct bgp *bgp, struct prefix *p, struct bgp_info *rinew,
       new->peer = bgp->peer_self;
       SET_FLAG (new->flags, BGP_INFO_VALID);
       new->attr = bgp_attr_aggregate_intern (bgp, origin, aspath, community, aggregate->as_set);
-      new->uptime = bgp_clock ();
+      BGP_INFO_UPTIME_SET (new);
 
       bgp_info_add (rn, new);
       bgp_unlock_node (rn);
@@ -5042,10 +5894,10 @@ bgp_aggregate_add (struct bgp *bgp, struct prefix *p, afi_t afi, safi_t safi,
 		      {
 			if (community)
 			  {
-			    commerge = community_merge (community,
+			    commerge = community_union (community,
 							ri->attr->community);
-			    community = community_uniq_sort (commerge);
-			    community_free (commerge);
+			    community_free (community);
+			    community = commerge;
 			  }
 			else
 			  community = community_dup (ri->attr->community);
@@ -5072,7 +5924,7 @@ bgp_aggregate_add (struct bgp *bgp, struct prefix *p, afi_t afi, safi_t safi,
       new->peer = bgp->peer_self;
       SET_FLAG (new->flags, BGP_INFO_VALID);
       new->attr = bgp_attr_aggregate_intern (bgp, origin, aspath, community, aggregate->as_set);
-      new->uptime = bgp_clock ();
+      BGP_INFO_UPTIME_SET (new);
 
       bgp_info_add (rn, new);
       bgp_unlock_node (rn);
@@ -5706,7 +6558,8 @@ bgp_redistribute_add (struct prefix *p, const struct in_addr *nexthop,
 		    bgp_aggregate_decrement (bgp, p, bi, afi, SAFI_UNICAST);
  		  bgp_attr_unintern (&bi->attr);
  		  bi->attr = new_attr;
- 		  bi->uptime = bgp_clock ();
+		  UNSET_FLAG (bi->flags, BGP_INFO_KEY_VALID);
+ 		  BGP_INFO_UPTIME_SET (bi);
  
  		  /* Process change. */
  		  bgp_aggregate_increment (bgp, p, bi, afi, SAFI_UNICAST);
@@ -5724,7 +6577,7 @@ bgp_redistribute_add (struct prefix *p, const struct in_addr *nexthop,
 	  new->peer = bgp->peer_self;
 	  SET_FLAG (new->flags, BGP_INFO_VALID);
 	  new->attr = new_attr;
-	  new->uptime = bgp_clock ();
+	  BGP_INFO_UPTIME_SET (new);
 
 	  bgp_aggregate_increment (bgp, p, new, afi, SAFI_UNICAST);
 	  bgp_info_add (bn, new);
@@ -6373,11 +7226,11 @@ route_vty_out_detail (struct vty *vty, struct bgp *bgp, struct prefix *p,
 
       /* Line 7 display Uptime */
 #ifdef HAVE_CLOCK_MONOTONIC
-      tbuf = time(NULL) - (bgp_clock() - binfo->uptime);
-      vty_out (vty, "      Last update: %s", ctime(&tbuf));
+      tbuf = time(NULL) - (bgp_clock() - BGP_INFO_UPTIME (binfo));
 #else
-      vty_out (vty, "      Last update: %s", ctime(&binfo->uptime));
+      tbuf = BGP_INFO_UPTIME (binfo);
 #endif /* HAVE_CLOCK_MONOTONIC */
+      vty_out (vty, "      Last update: %s", ctime(&tbuf));
     }
   vty_out (vty, "%s", VTY_NEWLINE);
 }
@@ -40,13 +40,19 @@ struct bgp_info_extra
 
   /* MPLS label.  */
   u_char tag[3];  
+
+  /* Multipath information */
+  struct bgp_info_mpath *mpath;
 };
 
+/* There is one of these for every path of every prefix from every peer,
+ * keep it small: rarely used information goes to the extra information,
+ * allocated on demand, and paths of a prefix are singly linked.
+ */
 struct bgp_info
 {
   /* For linked list. */
   struct bgp_info *next;
-  struct bgp_info *prev;
   
   /* Peer structure.  */
   struct peer *peer;
@@ -56,13 +62,15 @@ struct bgp_info
   
   /* Extra information */
   struct bgp_info_extra *extra;
-  
 
-  /* Multipath information */
-  struct bgp_info_mpath *mpath;
+  /* Decision key: local preference, local route, AS path length and
+     origin, see bgp_info_cmp ().  */
+  u_int64_t key;
+#define BGP_INFO_KEY_LOCAL      (1U << 31)
+#define BGP_INFO_KEY_LEN_MAX    0x7fffff
 
-  /* Uptime.  */
-  time_t uptime;
+  /* Uptime, in seconds since bgpd started, see BGP_INFO_UPTIME.  */
+  u_int32_t uptime;
 
   /* reference count */
   int lock;
@@ -82,6 +90,8 @@ struct bgp_info
 #define BGP_INFO_COUNTED	(1 << 10)
 #define BGP_INFO_MULTIPATH      (1 << 11)
 #define BGP_INFO_MULTIPATH_CHG  (1 << 12)
+#define BGP_INFO_KEY_VALID      (1 << 13)
+#define BGP_INFO_KEY_WEIGHT     (1 << 14)
 
   /* BGP route type.  This can be static, RIP, OSPF, BGP etc.  */
   u_char type;
@@ -93,8 +103,17 @@ struct bgp_info
 #define BGP_ROUTE_STATIC       1
 #define BGP_ROUTE_AGGREGATE    2
 #define BGP_ROUTE_REDISTRIBUTE 3 
+
+  /* Bestpath configuration the key was computed with.  */
+  u_int32_t key_version;
 };
 
+#define BGP_INFO_MPATH(BI) ((BI)->extra ? (BI)->extra->mpath : NULL)
+
+/* Set and get the uptime of a path, as bgp_clock() time. */
+#define BGP_INFO_UPTIME_SET(BI) ((BI)->uptime = bgp_clock () - bm->start_time)
+#define BGP_INFO_UPTIME(BI) ((time_t) (bm->start_time + (BI)->uptime))
+
 /* BGP static route configuration. */
 struct bgp_static
 {
@@ -172,12 +191,36 @@ enum bgp_clear_route_type
   BGP_CLEAR_ROUTE_MY_RSCLIENT
 };
 
+/* Nodes of the main RIB where a peer added a route, an adj-in or an
+ * adj-out, so that clearing the peer walks its own nodes rather than the
+ * whole table.  Entries lock their node and are only dropped when the
+ * array is compacted, so it may hold nodes the peer no longer has
+ * anything in, or a node more than once.
+ */
+struct bgp_peer_index
+{
+  struct bgp_node **node;
+  unsigned int count;
+  unsigned int size;
+
+  /* Next entry to clear, while clearing the peer.  */
+  unsigned int clear;
+  u_char clearing;
+
+  /* Nodes where routes of the peer were marked stale for a graceful
+     restart, swept at its end.  */
+  struct bgp_node **stale;
+  unsigned int stale_count;
+  unsigned int stale_size;
+};
+
 /* Prototypes. */
 extern void bgp_route_init (void);
 extern void bgp_route_finish (void);
 extern void bgp_cleanup_routes (void);
 extern void bgp_announce_route (struct peer *, afi_t, safi_t);
 extern void bgp_announce_route_all (struct peer *);
+extern void bgp_announce_peer_down (struct peer *);
 extern void bgp_default_originate (struct peer *, afi_t, safi_t, int);
 extern void bgp_soft_reconfig_in (struct peer *, afi_t, safi_t);
 extern void bgp_soft_reconfig_rsclient (struct peer *, afi_t, safi_t);
@@ -187,6 +230,8 @@ extern void bgp_clear_route (struct peer *, afi_t, safi_t,
 extern void bgp_clear_route_all (struct peer *);
 extern void bgp_clear_adj_in (struct peer *, afi_t, safi_t);
 extern void bgp_clear_stale_route (struct peer *, afi_t, safi_t);
+extern void bgp_peer_index_add (struct peer *, struct bgp_node *);
+extern void bgp_peer_index_free (struct peer *);
 
 extern struct bgp_info *bgp_info_lock (struct bgp_info *);
 extern struct bgp_info *bgp_info_unlock (struct bgp_info *);
@@ -225,7 +270,20 @@ extern int bgp_withdraw (struct peer *, struct prefix *, struct attr *,
 			 afi_t, safi_t, int, int, struct prefix_rd *, u_char *);
 
 /* for bgp_nexthop and bgp_damp */
+struct bgp_info_pair
+{
+  struct bgp_info *old;
+  struct bgp_info *new;
+};
+
 extern void bgp_process (struct bgp *, struct bgp_node *, afi_t, safi_t);
+extern void bgp_best_selection (struct bgp *, struct bgp_node *,
+                                struct bgp_info_pair *, afi_t, safi_t);
+extern int bgp_info_cmp (struct bgp *, struct bgp_info *, struct bgp_info *,
+                         afi_t, safi_t);
+extern void bgp_input_throttle (struct peer *);
+extern struct bgp_info *bgp_info_backup (struct bgp *, struct bgp_node *,
+                                         struct bgp_info *, afi_t, safi_t);
 extern int bgp_config_write_network (struct vty *, struct bgp *, afi_t, safi_t, int *);
 extern int bgp_config_write_distance (struct vty *, struct bgp *);
 
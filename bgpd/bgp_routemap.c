@@ -52,6 +52,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "bgpd/bgp_mplsvpn.h"
 #include "bgpd/bgp_ecommunity.h"
 #include "bgpd/bgp_vty.h"
+#include "bgpd/bgp_rsview.h"
 
 /* Memo of route-map commands.
 
@@ -1265,7 +1266,6 @@ route_set_community (void *rule, struct prefix *prefix,
   struct attr *attr;
   struct community *new = NULL;
   struct community *old;
-  struct community *merge;
   
   if (type == RMAP_BGP)
     {
@@ -1288,7 +1288,15 @@ route_set_community (void *rule, struct prefix *prefix,
       /* "additive" case.  */
       if (rcs->additive && old)
 	{
-	  merge = community_merge (community_dup (old), rcs->com);
+	  /* The route has all the communities already: keep its value,
+	     interned or not, rather than a copy of it.  */
+	  if (community_match (old, rcs->com))
+	    {
+	      attr->flag |= ATTR_FLAG_BIT (BGP_ATTR_COMMUNITIES);
+	      return RMAP_OKAY;
+	    }
+
+	  new = community_union (old, rcs->com);
 	  
 	  /* HACK: if the old community is not intern'd, 
            * we should free it here, or all reference to it may be lost.
@@ -1296,8 +1304,6 @@ route_set_community (void *rule, struct prefix *prefix,
            */
 	  if (old->refcnt == 0)
 	    community_free (old);
-	  new = community_uniq_sort (merge);
-	  community_free (merge);
 	}
       else
 	new = community_dup (rcs->com);
@@ -2276,6 +2282,21 @@ bgp_route_set_delete (struct vty *vty, struct route_map_index *index,
   return CMD_SUCCESS;
 }
 
+/* A rule of a route-map changed: the export route-maps naming route
+   server clients with "match peer" keep them off the shared views. */
+static void
+bgp_route_map_event (route_map_event_t event, const char *name)
+{
+  struct listnode *node, *nnode;
+  struct bgp *bgp;
+
+  if (bm->bgp == NULL)
+    return;
+
+  for (ALL_LIST_ELEMENTS (bm->bgp, node, nnode, bgp))
+    bgp_rsview_update_all (bgp);
+}
+
 /* Hook function for updating route_map assignment. */
 static void
 bgp_route_map_update (const char *unused)
@@ -2343,6 +2364,7 @@ bgp_route_map_update (const char *unused)
 		  filter->usmap.map = NULL;
 	      }
 	}
+      bgp_rsview_route_map_update (bgp);
     }
 
   /* For default-originate route-map updates. */
@@ -3865,6 +3887,7 @@ bgp_route_map_init (void)
   route_map_init_vty ();
   route_map_add_hook (bgp_route_map_update);
   route_map_delete_hook (bgp_route_map_update);
+  route_map_event_hook (bgp_route_map_event);
 
   route_map_install_match (&route_match_peer_cmd);
   route_map_install_match (&route_match_ip_address_cmd);
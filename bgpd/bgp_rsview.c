@@ -0,0 +1,752 @@
+/* BGP route server clients sharing a view
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "command.h"
+#include "vty.h"
+#include "log.h"
+#include "linklist.h"
+#include "memory.h"
+#include "hash.h"
+#include "jhash.h"
+#include "prefix.h"
+#include "sockunion.h"
+#include "routemap.h"
+#include "filter.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_advertise.h"
+#include "bgpd/bgp_packet.h"
+#include "bgpd/bgp_debug.h"
+#include "bgpd/bgp_vty.h"
+#include "bgpd/bgp_rsview.h"
+
+static unsigned int
+bgp_rsview_node_key (void *p)
+{
+  const struct bgp_rsview_node *node = p;
+
+  return jhash_1word ((u_int32_t) (uintptr_t) node->rn, 0);
+}
+
+static int
+bgp_rsview_node_cmp (const void *p1, const void *p2)
+{
+  const struct bgp_rsview_node *node1 = p1;
+  const struct bgp_rsview_node *node2 = p2;
+
+  return node1->rn == node2->rn;
+}
+
+static void *
+bgp_rsview_node_alloc (void *p)
+{
+  const struct bgp_rsview_node *ref = p;
+  struct bgp_rsview_node *node;
+
+  node = XCALLOC (MTYPE_BGP_RSVIEW_NODE, sizeof (struct bgp_rsview_node));
+  node->rn = bgp_lock_node (ref->rn);
+  return node;
+}
+
+static void
+bgp_rsview_node_free (void *p)
+{
+  struct bgp_rsview_node *node = p;
+  unsigned int i;
+
+  for (i = 0; i < node->count; i++)
+    {
+      node->delta[i].peer->rsview_deltas[bgp_node_table (node->rn)->afi]
+                                        [bgp_node_table (node->rn)->safi]--;
+      if (node->delta[i].ri)
+        bgp_info_unlock (node->delta[i].ri);
+    }
+  if (node->delta)
+    XFREE (MTYPE_BGP_RSVIEW_DELTA, node->delta);
+  bgp_unlock_node (node->rn);
+  XFREE (MTYPE_BGP_RSVIEW_NODE, node);
+}
+
+static struct bgp_rsview_node *
+bgp_rsview_node_lookup (struct peer_group *group, struct bgp_node *rn)
+{
+  struct bgp_rsview_node ref;
+
+  if (group->rsdelta == NULL)
+    return NULL;
+
+  ref.rn = rn;
+  return hash_lookup (group->rsdelta, &ref);
+}
+
+static struct bgp_rsview_delta *
+bgp_rsview_node_delta (struct bgp_rsview_node *node, struct peer *peer)
+{
+  unsigned int i;
+
+  for (i = 0; i < node->count; i++)
+    if (node->delta[i].peer == peer)
+      return &node->delta[i];
+  return NULL;
+}
+
+static void
+bgp_rsview_node_release (struct peer_group *group,
+                         struct bgp_rsview_node *node)
+{
+  hash_release (group->rsdelta, node);
+  bgp_rsview_node_free (node);
+}
+
+/* Path kept for the member, when there is one: it may be NULL, nothing
+   to send. */
+int
+bgp_rsview_delta_get (struct peer_group *group, struct bgp_node *rn,
+                      struct peer *peer, struct bgp_info **ri)
+{
+  struct bgp_rsview_node *node;
+  struct bgp_rsview_delta *delta;
+
+  if ((node = bgp_rsview_node_lookup (group, rn)) == NULL
+      || (delta = bgp_rsview_node_delta (node, peer)) == NULL)
+    return 0;
+
+  *ri = delta->ri;
+  return 1;
+}
+
+void
+bgp_rsview_delta_set (struct peer_group *group, struct bgp_node *rn,
+                      struct peer *peer, struct bgp_info *ri)
+{
+  struct bgp_rsview_node ref;
+  struct bgp_rsview_node *node;
+  struct bgp_rsview_delta *delta;
+
+  if (group->rsdelta == NULL)
+    group->rsdelta = hash_create (bgp_rsview_node_key, bgp_rsview_node_cmp);
+
+  ref.rn = rn;
+  node = hash_get (group->rsdelta, &ref, bgp_rsview_node_alloc);
+
+  if ((delta = bgp_rsview_node_delta (node, peer)) == NULL)
+    {
+      node->delta = XREALLOC (MTYPE_BGP_RSVIEW_DELTA, node->delta,
+                              (node->count + 1)
+                              * sizeof (struct bgp_rsview_delta));
+      delta = &node->delta[node->count++];
+      delta->peer = peer;
+      delta->ri = NULL;
+      peer->rsview_deltas[bgp_node_table (rn)->afi]
+                         [bgp_node_table (rn)->safi]++;
+    }
+
+  if (delta->ri == ri)
+    return;
+  if (delta->ri)
+    bgp_info_unlock (delta->ri);
+  delta->ri = ri ? bgp_info_lock (ri) : NULL;
+}
+
+void
+bgp_rsview_delta_unset (struct peer_group *group, struct bgp_node *rn,
+                        struct peer *peer)
+{
+  struct bgp_rsview_node *node;
+  struct bgp_rsview_delta *delta;
+
+  if ((node = bgp_rsview_node_lookup (group, rn)) == NULL
+      || (delta = bgp_rsview_node_delta (node, peer)) == NULL)
+    return;
+
+  peer->rsview_deltas[bgp_node_table (rn)->afi][bgp_node_table (rn)->safi]--;
+  if (delta->ri)
+    bgp_info_unlock (delta->ri);
+  *delta = node->delta[--node->count];
+
+  if (node->count == 0)
+    bgp_rsview_node_release (group, node);
+}
+
+/* The node was sent to the members: the changes of the paths kept for
+   them are sent as well. */
+void
+bgp_rsview_delta_done (struct peer_group *group, struct bgp_node *rn)
+{
+  struct bgp_rsview_node *node;
+  unsigned int i;
+
+  if ((node = bgp_rsview_node_lookup (group, rn)) == NULL)
+    return;
+
+  for (i = 0; i < node->count; i++)
+    if (node->delta[i].ri)
+      bgp_info_unset_flag (rn, node->delta[i].ri, BGP_INFO_ATTR_CHANGED);
+}
+
+/* Drop the deltas of the node, picked again when needed. */
+void
+bgp_rsview_delta_flush (struct peer_group *group, struct bgp_node *rn)
+{
+  struct bgp_rsview_node *node;
+
+  if ((node = bgp_rsview_node_lookup (group, rn)) != NULL)
+    bgp_rsview_node_release (group, node);
+}
+
+struct bgp_rsview_flush
+{
+  struct peer_group *group;
+  struct peer *peer;
+  struct bgp_table *table;
+};
+
+static void
+bgp_rsview_flush_node (struct hash_backet *backet, void *arg)
+{
+  struct bgp_rsview_node *node = backet->data;
+  struct bgp_rsview_flush *flush = arg;
+
+  if (flush->table && bgp_node_table (node->rn) != flush->table)
+    return;
+
+  if (flush->peer)
+    bgp_rsview_delta_unset (flush->group, node->rn, flush->peer);
+  else
+    bgp_rsview_node_release (flush->group, node);
+}
+
+/* Drop the deltas of a member leaving the group, or going down. */
+void
+bgp_rsview_flush_peer (struct peer_group *group, struct peer *peer)
+{
+  struct bgp_rsview_flush flush = { group, peer, NULL };
+
+  if (group->rsdelta)
+    hash_iterate (group->rsdelta, bgp_rsview_flush_node, &flush);
+}
+
+/* Drop the deltas of the table of the group, before it goes. */
+static void
+bgp_rsview_flush_table (struct peer_group *group, struct bgp_table *table)
+{
+  struct bgp_rsview_flush flush = { group, NULL, table };
+
+  if (group->rsdelta && table)
+    hash_iterate (group->rsdelta, bgp_rsview_flush_node, &flush);
+}
+
+void
+bgp_rsview_cache_free (struct peer_group *group)
+{
+  if (group->rsdelta == NULL)
+    return;
+
+  hash_clean (group->rsdelta, bgp_rsview_node_free);
+  hash_free (group->rsdelta);
+  group->rsdelta = NULL;
+}
+
+/* Keep the peer in the list of the route server clients while it has a
+   table of its own. */
+static void
+bgp_rsclient_list_update (struct peer *peer)
+{
+  struct bgp *bgp = peer->bgp;
+  struct listnode *pn;
+
+  pn = listnode_lookup (bgp->rsclient, peer);
+  if (peer_rsclient_active (peer) && ! pn)
+    {
+      peer = peer_lock (peer); /* rsclient peer list reference */
+      listnode_add_sort (bgp->rsclient, peer);
+    }
+  else if (! peer_rsclient_active (peer) && pn)
+    {
+      list_delete_node (bgp->rsclient, pn);
+      peer_unlock (peer); /* rsclient peer list reference */
+    }
+}
+
+/* Table of the client, or of the view, filled with the routes there
+   are already. */
+static void
+bgp_rsview_table_new (struct peer *peer, afi_t afi, safi_t safi)
+{
+  peer->rib[afi][safi] = bgp_table_init (afi, safi);
+  peer->rib[afi][safi]->type = BGP_TABLE_RSCLIENT;
+  /* RIB peer reference.  Released when table is free'd in bgp_table_free. */
+  peer->rib[afi][safi]->owner = peer_lock (peer);
+
+  bgp_rsclient_list_update (peer);
+
+  /* Check for existing 'network' and 'redistribute' routes. */
+  bgp_check_local_routes_rsclient (peer, afi, safi);
+
+  /* Check for routes for peers configured with 'soft-reconfiguration'. */
+  bgp_soft_reconfig_rsclient (peer, afi, safi);
+}
+
+static int
+bgp_rsview_match_peer (void *value, void *arg)
+{
+  struct peer *peer = arg;
+
+  return sockunion_same (value, &peer->su);
+}
+
+/* Whether the client can share a view.  The export route-maps of the
+   other peers are applied once for a view, with the view as the client,
+   so one naming the client with "match peer" keeps it on its own
+   table. */
+static int
+bgp_rsview_shareable (struct peer *peer, afi_t afi, safi_t safi)
+{
+  struct peer *other;
+  struct listnode *node;
+
+  if (CHECK_FLAG (peer->sflags, PEER_STATUS_GROUP)
+      || ! bgp_flag_check (peer->bgp, BGP_FLAG_RSERVER_SHARED))
+    return 0;
+
+  for (ALL_LIST_ELEMENTS_RO (peer->bgp->peer, node, other))
+    if (other != peer
+        && route_map_match_find (other->filter[afi][safi].map[RMAP_EXPORT].map,
+                                 "peer", bgp_rsview_match_peer, peer))
+      return 0;
+  return 1;
+}
+
+static int
+bgp_rsview_match (struct peer_group *view, afi_t afi, safi_t safi,
+                  const char *name)
+{
+  const char *vname;
+
+  if (view->conf->rib[afi][safi] == NULL)
+    return 0;
+
+  vname = view->conf->filter[afi][safi].map[RMAP_IMPORT].name;
+  if (vname == NULL || name == NULL)
+    return vname == name;
+  return strcmp (vname, name) == 0;
+}
+
+static struct peer_group *
+bgp_rsview_get (struct bgp *bgp, afi_t afi, safi_t safi, const char *name)
+{
+  struct peer_group *view;
+  struct peer *conf;
+  struct listnode *node;
+  char host[64];
+
+  for (ALL_LIST_ELEMENTS_RO (bgp->rsview, node, view))
+    if (bgp_rsview_match (view, afi, safi, name))
+      return view;
+
+  view = XCALLOC (MTYPE_PEER_GROUP, sizeof (struct peer_group));
+  view->bgp = bgp;
+  view->rsview = 1;
+  view->peer = list_new ();
+  snprintf (host, sizeof (host), "view %s", name ? name : "-");
+  view->conf = conf = peer_group_conf_new (view, host);
+  listnode_add (bgp->rsview, view);
+
+  conf->afc[afi][safi] = 1;
+  SET_FLAG (conf->af_flags[afi][safi], PEER_FLAG_RSERVER_CLIENT);
+  if (name)
+    {
+      conf->filter[afi][safi].map[RMAP_IMPORT].name = strdup (name);
+      conf->filter[afi][safi].map[RMAP_IMPORT].map =
+        route_map_lookup_by_name (name);
+    }
+
+  if (BGP_DEBUG (events, EVENTS))
+    zlog_debug ("route server %s created", host);
+
+  bgp_rsview_table_new (conf, afi, safi);
+  return view;
+}
+
+static void
+bgp_rsview_free (struct peer_group *view)
+{
+  struct bgp *bgp = view->bgp;
+
+  if (BGP_DEBUG (events, EVENTS))
+    zlog_debug ("route server %s deleted", view->conf->host);
+
+  listnode_delete (bgp->rsview, view);
+  bgp_rsview_cache_free (view);
+  list_delete (view->peer);
+
+  /* Leaves the list of the route server clients, and its table is
+     cleared. */
+  view->conf->group = NULL;
+  peer_delete (view->conf);
+
+  XFREE (MTYPE_PEER_GROUP, view);
+}
+
+/* Give the route server client its table: the shared view of its
+ * import policy, or a table of its own, and for a peer-group, the table
+ * of its members.
+ */
+void
+bgp_rsview_attach (struct peer *peer, afi_t afi, safi_t safi)
+{
+  struct peer_group *view;
+
+  if (! bgp_rsview_shareable (peer, afi, safi))
+    {
+      bgp_rsview_table_new (peer, afi, safi);
+      return;
+    }
+
+  view = bgp_rsview_get (peer->bgp, afi, safi,
+                         peer->filter[afi][safi].map[RMAP_IMPORT].name);
+  peer->rsview[afi][safi] = view;
+  peer->rib[afi][safi] = view->conf->rib[afi][safi];
+  bgp_table_lock (peer->rib[afi][safi]);
+  listnode_add (view->peer, peer_lock (peer)); /* view member reference */
+}
+
+/* Take the table of the route server client away, along with all that
+ * was advertised to it from a shared view.  Its session is reset by the
+ * callers, and sent the new table when it comes back up.
+ */
+void
+bgp_rsview_detach (struct peer *peer, afi_t afi, safi_t safi)
+{
+  struct peer_group *view = peer->rsview[afi][safi];
+  struct bgp_node *rn;
+  struct bgp_adj_out *adj;
+
+  if (view == NULL)
+    {
+      if (CHECK_FLAG (peer->sflags, PEER_STATUS_GROUP) && peer->group)
+        bgp_rsview_flush_table (peer->group, peer->rib[afi][safi]);
+      if (peer->rib[afi][safi])
+        bgp_clear_route (peer, afi, safi, BGP_CLEAR_ROUTE_MY_RSCLIENT);
+      bgp_table_finish (&peer->rib[afi][safi]);
+      bgp_rsclient_list_update (peer);
+      return;
+    }
+
+  for (rn = bgp_table_top (peer->rib[afi][safi]); rn; rn = bgp_route_next (rn))
+    for (adj = rn->adj_out; adj; adj = adj->next)
+      if (adj->peer == peer)
+        {
+          bgp_adj_out_remove (rn, adj, peer, afi, safi);
+          bgp_unlock_node (rn);
+          break;
+        }
+  bgp_rsview_flush_peer (view, peer);
+
+  listnode_delete (view->peer, peer);
+  peer_unlock (peer); /* view member reference */
+  peer->rsview[afi][safi] = NULL;
+  bgp_table_finish (&peer->rib[afi][safi]);
+
+  if (list_isempty (view->peer))
+    bgp_rsview_free (view);
+}
+
+/* The client moves to another table: the peer goes down, as when it
+   becomes a route server client. */
+static void
+bgp_rsview_move (struct peer *peer, afi_t afi, safi_t safi)
+{
+  if (peer->status == Established)
+    {
+      peer->last_reset = PEER_DOWN_RS_CLIENT_CHANGE;
+      bgp_notify_send (peer, BGP_NOTIFY_CEASE,
+                       BGP_NOTIFY_CEASE_CONFIG_CHANGE);
+    }
+
+  bgp_rsview_detach (peer, afi, safi);
+  bgp_rsview_attach (peer, afi, safi);
+}
+
+/* The policy of the route server client changed, move it to the view
+   of its import policy, or to a table of its own. */
+void
+bgp_rsview_update (struct peer *peer, afi_t afi, safi_t safi)
+{
+  struct peer_group *view = peer->rsview[afi][safi];
+
+  if (! CHECK_FLAG (peer->af_flags[afi][safi], PEER_FLAG_RSERVER_CLIENT)
+      || peer->af_group[afi][safi])
+    return;
+
+  if (! bgp_rsview_shareable (peer, afi, safi))
+    {
+      if (view)
+        bgp_rsview_move (peer, afi, safi);
+    }
+  else if (! view
+           || ! bgp_rsview_match (view, afi, safi,
+                                  peer->filter[afi][safi].map[RMAP_IMPORT].name))
+    bgp_rsview_move (peer, afi, safi);
+}
+
+/* An export policy changed, which may name clients with "match peer". */
+void
+bgp_rsview_update_all (struct bgp *bgp)
+{
+  struct peer *peer;
+  struct listnode *node, *nnode;
+  afi_t afi;
+  safi_t safi;
+
+  if (! bgp_flag_check (bgp, BGP_FLAG_RSERVER_SHARED))
+    return;
+
+  for (ALL_LIST_ELEMENTS (bgp->peer, node, nnode, peer))
+    for (afi = AFI_IP; afi < AFI_MAX; afi++)
+      for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
+        bgp_rsview_update (peer, afi, safi);
+}
+
+/* The views are not in the list of the peer-groups, their import
+   route-map is looked up here. */
+void
+bgp_rsview_route_map_update (struct bgp *bgp)
+{
+  struct peer_group *view;
+  struct listnode *node;
+  struct bgp_filter *filter;
+  afi_t afi;
+  safi_t safi;
+
+  for (ALL_LIST_ELEMENTS_RO (bgp->rsview, node, view))
+    for (afi = AFI_IP; afi < AFI_MAX; afi++)
+      for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
+        {
+          filter = &view->conf->filter[afi][safi];
+          if (filter->map[RMAP_IMPORT].name)
+            filter->map[RMAP_IMPORT].map =
+              route_map_lookup_by_name (filter->map[RMAP_IMPORT].name);
+        }
+
+  bgp_rsview_update_all (bgp);
+}
+
+/* Move all the route server clients, but members of a peer-group, to a
+   shared view or to a table of their own. */
+static void
+bgp_rsview_shared_set (struct bgp *bgp, int shared)
+{
+  struct peer *peer;
+  struct listnode *node, *nnode;
+  afi_t afi;
+  safi_t safi;
+
+  if (shared)
+    bgp_flag_set (bgp, BGP_FLAG_RSERVER_SHARED);
+  else
+    bgp_flag_unset (bgp, BGP_FLAG_RSERVER_SHARED);
+
+  for (ALL_LIST_ELEMENTS (bgp->peer, node, nnode, peer))
+    for (afi = AFI_IP; afi < AFI_MAX; afi++)
+      for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
+        if (CHECK_FLAG (peer->af_flags[afi][safi], PEER_FLAG_RSERVER_CLIENT)
+            && ! peer->af_group[afi][safi]
+            && (peer->rsview[afi][safi] != NULL) != shared)
+          bgp_rsview_move (peer, afi, safi);
+}
+
+DEFUN (bgp_route_server_shared_rib,
+       bgp_route_server_shared_rib_cmd,
+       "bgp route-server shared-rib",
+       "BGP specific commands\n"
+       "Route server\n"
+       "Share a table between the clients with the same import policy\n")
+{
+  struct bgp *bgp = vty->index;
+
+  if (! bgp_flag_check (bgp, BGP_FLAG_RSERVER_SHARED))
+    bgp_rsview_shared_set (bgp, 1);
+  return CMD_SUCCESS;
+}
+
+DEFUN (no_bgp_route_server_shared_rib,
+       no_bgp_route_server_shared_rib_cmd,
+       "no bgp route-server shared-rib",
+       NO_STR
+       "BGP specific commands\n"
+       "Route server\n"
+       "Share a table between the clients with the same import policy\n")
+{
+  struct bgp *bgp = vty->index;
+
+  if (bgp_flag_check (bgp, BGP_FLAG_RSERVER_SHARED))
+    bgp_rsview_shared_set (bgp, 0);
+  return CMD_SUCCESS;
+}
+
+/* Size of a route server client table. */
+struct bgp_rsview_size
+{
+  unsigned long nodes;
+  unsigned long paths;
+  unsigned long deltas;
+  unsigned long bytes;
+};
+
+static void
+bgp_rsview_table_size (struct peer *owner, afi_t afi, safi_t safi,
+                       struct bgp_rsview_size *size)
+{
+  struct bgp_node *rn;
+  struct bgp_info *ri;
+
+  memset (size, 0, sizeof (struct bgp_rsview_size));
+  for (rn = bgp_table_top (owner->rib[afi][safi]); rn;
+       rn = bgp_route_next (rn))
+    {
+      size->nodes++;
+      for (ri = rn->info; ri; ri = ri->next)
+        size->paths++;
+    }
+
+  size->bytes = size->nodes * sizeof (struct bgp_node)
+                + size->paths * sizeof (struct bgp_info);
+  if (owner->group && owner->group->rsdelta)
+    size->bytes += owner->group->rsdelta->count
+                   * sizeof (struct bgp_rsview_node);
+}
+
+static void
+bgp_rsview_show_client (struct vty *vty, struct peer *peer, const char *table,
+                        unsigned int clients, struct bgp_rsview_size *size,
+                        afi_t afi, safi_t safi)
+{
+  unsigned long deltas = peer->rsview_deltas[afi][safi];
+
+  vty_out (vty, "%-16s %-16s %7u %9lu %9lu %7lu %10lu%s", peer->host, table,
+           clients, size->nodes, size->paths, deltas,
+           size->bytes / clients + deltas * sizeof (struct bgp_rsview_delta),
+           VTY_NEWLINE);
+}
+
+/* Memory of the tables of the route server clients, a share of the
+ * table each client uses and the deltas it has.
+ */
+static int
+bgp_rsview_show_memory (struct vty *vty, afi_t afi, safi_t safi)
+{
+  struct bgp *bgp;
+  struct peer *owner, *peer;
+  struct listnode *node, *mnode;
+  struct bgp_rsview_size size;
+  unsigned long tables = 0, bytes = 0, clients = 0;
+  char table[64];
+
+  bgp = bgp_get_default ();
+  if (bgp == NULL)
+    return CMD_SUCCESS;
+
+  vty_out (vty, "Route server tables %s, %s%s", afi_safi_print (afi, safi),
+           bgp_flag_check (bgp, BGP_FLAG_RSERVER_SHARED)
+           ? "shared by the clients with the same import policy"
+           : "of their own for the clients", VTY_NEWLINE);
+  vty_out (vty, "%-16s %-16s %7s %9s %9s %7s %10s%s", "Neighbor", "Table",
+           "Clients", "Nodes", "Paths", "Deltas", "Bytes", VTY_NEWLINE);
+
+  for (ALL_LIST_ELEMENTS_RO (bgp->rsclient, node, owner))
+    {
+      if (! owner->rib[afi][safi] || owner->rsview[afi][safi]
+          || ! CHECK_FLAG (owner->af_flags[afi][safi],
+                           PEER_FLAG_RSERVER_CLIENT))
+        continue;
+
+      bgp_rsview_table_size (owner, afi, safi, &size);
+      tables++;
+      bytes += size.bytes;
+
+      if (! CHECK_FLAG (owner->sflags, PEER_STATUS_GROUP))
+        {
+          clients++;
+          bgp_rsview_show_client (vty, owner, "own", 1, &size, afi, safi);
+          continue;
+        }
+      if (! owner->group || list_isempty (owner->group->peer))
+        continue;
+
+      if (owner->group->rsview)
+        snprintf (table, sizeof (table), "%s", owner->host);
+      else
+        snprintf (table, sizeof (table), "group %s", owner->group->name);
+      for (ALL_LIST_ELEMENTS_RO (owner->group->peer, mnode, peer))
+        {
+          clients++;
+          bytes += peer->rsview_deltas[afi][safi]
+                   * sizeof (struct bgp_rsview_delta);
+          bgp_rsview_show_client (vty, peer, table,
+                                  listcount (owner->group->peer), &size,
+                                  afi, safi);
+        }
+    }
+
+  vty_out (vty, "%s%lu clients, %lu tables, %lu bytes%s", VTY_NEWLINE,
+           clients, tables, bytes, VTY_NEWLINE);
+  return CMD_SUCCESS;
+}
+
+DEFUN (show_ip_bgp_rsclient_memory,
+       show_ip_bgp_rsclient_memory_cmd,
+       "show ip bgp rsclient memory",
+       SHOW_STR
+       IP_STR
+       BGP_STR
+       "Information about Route Server Clients\n"
+       "Memory of the tables of the Route Server Clients\n")
+{
+  return bgp_rsview_show_memory (vty, AFI_IP, SAFI_UNICAST);
+}
+
+DEFUN (show_bgp_ipv6_rsclient_memory,
+       show_bgp_ipv6_rsclient_memory_cmd,
+       "show bgp ipv6 rsclient memory",
+       SHOW_STR
+       BGP_STR
+       "Address family\n"
+       "Information about Route Server Clients\n"
+       "Memory of the tables of the Route Server Clients\n")
+{
+  return bgp_rsview_show_memory (vty, AFI_IP6, SAFI_UNICAST);
+}
+
+void
+bgp_rsview_init (void)
+{
+  install_element (BGP_NODE, &bgp_route_server_shared_rib_cmd);
+  install_element (BGP_NODE, &no_bgp_route_server_shared_rib_cmd);
+
+  install_element (VIEW_NODE, &show_ip_bgp_rsclient_memory_cmd);
+  install_element (ENABLE_NODE, &show_ip_bgp_rsclient_memory_cmd);
+  install_element (VIEW_NODE, &show_bgp_ipv6_rsclient_memory_cmd);
+  install_element (ENABLE_NODE, &show_bgp_ipv6_rsclient_memory_cmd);
+}
@@ -0,0 +1,80 @@
+/* BGP route server clients sharing a view
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _QUAGGA_BGP_RSVIEW_H
+#define _QUAGGA_BGP_RSVIEW_H
+
+/*
+ * With "bgp route-server shared-rib", the route server clients with the
+ * same import policy share one table, a view, instead of a table each.
+ * The routes go into it once and the best path is selected once for
+ * all of them.  A view is kept as a peer-group which is not configured,
+ * and is in the list of the route server clients in place of its
+ * members, as a peer-group of route server clients is.
+ *
+ * A client named with "match peer" by the export route-map of another
+ * peer keeps a table of its own, as the map would be applied with the
+ * view and could not tell the members apart.
+ *
+ * The checks made on the insertion of a route in the table of a client
+ * of its own are made when a path of a shared table is sent: a member
+ * the selected path can't be sent to, as it is its own route or has
+ * its AS in the path, is sent the best path it can be sent.  That path
+ * is picked when first needed, and kept as a delta of the member from
+ * the selected path until the node is processed again.
+ */
+
+/* Path sent to a member instead of the selected one. */
+struct bgp_rsview_delta
+{
+  struct peer *peer;
+
+  /* Locked, NULL when there is no path to send to the member. */
+  struct bgp_info *ri;
+};
+
+/* Deltas of the members for a node of the table, locked. */
+struct bgp_rsview_node
+{
+  struct bgp_node *rn;
+
+  unsigned int count;
+  struct bgp_rsview_delta *delta;
+};
+
+extern void bgp_rsview_init (void);
+extern void bgp_rsview_attach (struct peer *, afi_t, safi_t);
+extern void bgp_rsview_detach (struct peer *, afi_t, safi_t);
+extern void bgp_rsview_update (struct peer *, afi_t, safi_t);
+extern void bgp_rsview_update_all (struct bgp *);
+extern void bgp_rsview_route_map_update (struct bgp *);
+
+extern int bgp_rsview_delta_get (struct peer_group *, struct bgp_node *,
+                                 struct peer *, struct bgp_info **);
+extern void bgp_rsview_delta_set (struct peer_group *, struct bgp_node *,
+                                  struct peer *, struct bgp_info *);
+extern void bgp_rsview_delta_unset (struct peer_group *, struct bgp_node *,
+                                    struct peer *);
+extern void bgp_rsview_delta_done (struct peer_group *, struct bgp_node *);
+extern void bgp_rsview_delta_flush (struct peer_group *, struct bgp_node *);
+extern void bgp_rsview_flush_peer (struct peer_group *, struct peer *);
+extern void bgp_rsview_cache_free (struct peer_group *);
+
+#endif /* _QUAGGA_BGP_RSVIEW_H */
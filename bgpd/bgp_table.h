@@ -63,8 +63,12 @@ struct bgp_node
 
   struct bgp_node *prn;
 
+  /* Path-list of the route installed in zebra, see bgp_pathlist.c */
+  struct bgp_pathlist *pathlist;
+
   u_char flags;
 #define BGP_NODE_PROCESS_SCHEDULED	(1 << 0)
+#define BGP_NODE_INDEXED		(1 << 1)
 };
 
 /*
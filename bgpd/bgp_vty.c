@@ -50,6 +50,8 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "bgpd/bgp_table.h"
 #include "bgpd/bgp_vty.h"
 #include "bgpd/bgp_mpath.h"
+#include "bgpd/bgp_pathlist.h"
+#include "bgpd/bgp_rsview.h"
 
 extern struct in_addr router_id_zebra;
 
@@ -996,6 +998,42 @@ DEFUN (no_bgp_deterministic_med,
   return CMD_SUCCESS;
 }
 
+/* "bgp pic" configuration. */
+DEFUN (bgp_pic,
+       bgp_pic_cmd,
+       "bgp pic",
+       "BGP specific commands\n"
+       "Install routes through shared path-lists with a backup path\n")
+{
+  struct bgp *bgp;
+
+  bgp = vty->index;
+  if (bgp_flag_check (bgp, BGP_FLAG_PIC))
+    return CMD_SUCCESS;
+
+  bgp_flag_set (bgp, BGP_FLAG_PIC);
+  bgp_pathlist_reset (bgp);
+  return CMD_SUCCESS;
+}
+
+DEFUN (no_bgp_pic,
+       no_bgp_pic_cmd,
+       "no bgp pic",
+       NO_STR
+       "BGP specific commands\n"
+       "Install routes through shared path-lists with a backup path\n")
+{
+  struct bgp *bgp;
+
+  bgp = vty->index;
+  if (! bgp_flag_check (bgp, BGP_FLAG_PIC))
+    return CMD_SUCCESS;
+
+  bgp_flag_unset (bgp, BGP_FLAG_PIC);
+  bgp_pathlist_reset (bgp);
+  return CMD_SUCCESS;
+}
+
 /* "bgp graceful-restart" configuration. */
 DEFUN (bgp_graceful_restart,
        bgp_graceful_restart_cmd,
@@ -2360,15 +2398,11 @@ peer_rsclient_set_vty (struct vty *vty, const char *peer_str,
                        int afi, int safi)
 {
   int ret;
-  struct bgp *bgp;
   struct peer *peer;
   struct peer_group *group;
   struct listnode *node, *nnode;
   struct bgp_filter *pfilter;
   struct bgp_filter *gfilter;
-  int locked_and_added = 0;
-
-  bgp = vty->index;
 
   peer = peer_and_group_lookup_vty (vty, peer_str);
   if ( ! peer )
@@ -2378,35 +2412,12 @@ peer_rsclient_set_vty (struct vty *vty, const char *peer_str,
   if ( CHECK_FLAG (peer->af_flags[afi][safi], PEER_FLAG_RSERVER_CLIENT) )
     return CMD_SUCCESS;
 
-  if ( ! peer_rsclient_active (peer) )
-    {
-      peer = peer_lock (peer); /* rsclient peer list reference */
-      listnode_add_sort (bgp->rsclient, peer);
-      locked_and_added = 1;
-    }
-
   ret = peer_af_flag_set (peer, afi, safi, PEER_FLAG_RSERVER_CLIENT);
   if (ret < 0)
-    {
-      if (locked_and_added)
-        {
-          listnode_delete (bgp->rsclient, peer);
-          peer_unlock (peer); /* rsclient peer list reference */
-        }
-
-      return bgp_vty_return (vty, ret);
-    }
-
-  peer->rib[afi][safi] = bgp_table_init (afi, safi);
-  peer->rib[afi][safi]->type = BGP_TABLE_RSCLIENT;
-  /* RIB peer reference.  Released when table is free'd in bgp_table_free. */
-  peer->rib[afi][safi]->owner = peer_lock (peer);
-
-  /* Check for existing 'network' and 'redistribute' routes. */
-  bgp_check_local_routes_rsclient (peer, afi, safi);
+    return bgp_vty_return (vty, ret);
 
-  /* Check for routes for peers configured with 'soft-reconfiguration'. */
-  bgp_soft_reconfig_rsclient (peer, afi, safi);
+  /* Its own table, or the shared view of its policy. */
+  bgp_rsview_attach (peer, afi, safi);
 
   if (CHECK_FLAG(peer->sflags, PEER_STATUS_GROUP))
     {
@@ -2456,13 +2467,10 @@ peer_rsclient_unset_vty (struct vty *vty, const char *peer_str,
                          int afi, int safi)
 {
   int ret;
-  struct bgp *bgp;
   struct peer *peer;
   struct peer_group *group;
   struct listnode *node, *nnode;
 
-  bgp = vty->index;
-
   peer = peer_and_group_lookup_vty (vty, peer_str);
   if ( ! peer )
     return CMD_WARNING;
@@ -2491,14 +2499,7 @@ peer_rsclient_unset_vty (struct vty *vty, const char *peer_str,
   if (ret < 0)
     return bgp_vty_return (vty, ret);
 
-  if ( ! peer_rsclient_active (peer) )
-    {
-      bgp_clear_route (peer, afi, safi, BGP_CLEAR_ROUTE_MY_RSCLIENT);
-      listnode_delete (bgp->rsclient, peer);
-      peer_unlock (peer); /* peer bgp rsclient reference */
-    }
-
-  bgp_table_finish (&peer->rib[bgp_node_afi(vty)][bgp_node_safi(vty)]);
+  bgp_rsview_detach (peer, afi, safi);
 
   return CMD_SUCCESS;
 }
@@ -7110,24 +7111,47 @@ DEFUN (show_bgp_memory,
 {
   char memstrbuf[MTYPE_MEMSTR_LEN];
   unsigned long count;
+  unsigned long nodes, paths;
+  unsigned long node_bytes, path_bytes;
   
   /* RIB related usage stats */
-  count = mtype_stats_alloc (MTYPE_BGP_NODE);
+  count = nodes = mtype_stats_alloc (MTYPE_BGP_NODE);
+  node_bytes = count * sizeof (struct bgp_node);
   vty_out (vty, "%ld RIB nodes, using %s of memory%s", count,
-           mtype_memstr (memstrbuf, sizeof (memstrbuf),
-                         count * sizeof (struct bgp_node)),
+           mtype_memstr (memstrbuf, sizeof (memstrbuf), node_bytes),
            VTY_NEWLINE);
   
-  count = mtype_stats_alloc (MTYPE_BGP_ROUTE);
+  count = paths = mtype_stats_alloc (MTYPE_BGP_ROUTE);
+  path_bytes = count * sizeof (struct bgp_info);
   vty_out (vty, "%ld BGP routes, using %s of memory%s", count,
            mtype_memstr (memstrbuf, sizeof (memstrbuf),
                          count * sizeof (struct bgp_info)),
            VTY_NEWLINE);
   if ((count = mtype_stats_alloc (MTYPE_BGP_ROUTE_EXTRA)))
-    vty_out (vty, "%ld BGP route ancillaries, using %s of memory%s", count,
-             mtype_memstr (memstrbuf, sizeof (memstrbuf),
-                           count * sizeof (struct bgp_info_extra)),
-             VTY_NEWLINE);
+    {
+      path_bytes += count * sizeof (struct bgp_info_extra);
+      vty_out (vty, "%ld BGP route ancillaries, using %s of memory%s", count,
+               mtype_memstr (memstrbuf, sizeof (memstrbuf),
+                             count * sizeof (struct bgp_info_extra)),
+               VTY_NEWLINE);
+    }
+  if ((count = mtype_stats_alloc (MTYPE_BGP_MPATH_INFO)))
+    {
+      path_bytes += count * sizeof (struct bgp_info_mpath);
+      vty_out (vty, "%ld BGP multipath entries, using %s of memory%s", count,
+               mtype_memstr (memstrbuf, sizeof (memstrbuf),
+                             count * sizeof (struct bgp_info_mpath)),
+               VTY_NEWLINE);
+    }
+
+  /* Footprint of the RIB itself, attributes apart. */
+  if (paths)
+    vty_out (vty, "%lu bytes per path, %lu bytes per prefix"
+             " (%lu-byte nodes, %lu-byte paths)%s",
+             path_bytes / paths,
+             nodes ? (node_bytes + path_bytes) / nodes : 0,
+             (unsigned long) sizeof (struct bgp_node),
+             (unsigned long) sizeof (struct bgp_info), VTY_NEWLINE);
   
   if ((count = mtype_stats_alloc (MTYPE_BGP_STATIC)))
     vty_out (vty, "%ld Static routes, using %s of memory%s", count,
@@ -7976,6 +8000,8 @@ bgp_show_peer_afi (struct vty *vty, struct peer *p, afi_t afi, safi_t safi)
     }
   if (CHECK_FLAG (p->af_sflags[afi][safi], PEER_STATUS_ORF_WAIT_REFRESH))
       vty_out (vty, "  First update is deferred until ORF or ROUTE-REFRESH is received%s", VTY_NEWLINE);
+  if (CHECK_FLAG (p->af_sflags[afi][safi], PEER_STATUS_ANNOUNCE))
+    vty_out (vty, "  Table announcement in progress%s", VTY_NEWLINE);
 
   if (CHECK_FLAG (p->af_flags[afi][safi], PEER_FLAG_REFLECTOR_CLIENT))
     vty_out (vty, "  Route-Reflector Client%s", VTY_NEWLINE);
@@ -8102,6 +8128,14 @@ bgp_show_peer_afi (struct vty *vty, struct peer *p, afi_t afi, safi_t safi)
   /* Receive prefix count */
   vty_out (vty, "  %ld accepted prefixes%s", p->pcount[afi][safi], VTY_NEWLINE);
 
+  /* Dampening */
+  if (p->damp[afi][safi].flaps)
+    vty_out (vty, "  Dampening: %u flaps, %u paths suppressed, "
+	     "%u suppressed and %u reused in total%s",
+	     p->damp[afi][safi].flaps, p->damp[afi][safi].suppressed,
+	     p->damp[afi][safi].suppress, p->damp[afi][safi].reuse,
+	     VTY_NEWLINE);
+
   /* Maximum prefix */
   if (CHECK_FLAG (p->af_flags[afi][safi], PEER_FLAG_MAX_PREFIX))
     {
@@ -8357,7 +8391,7 @@ bgp_show_peer (struct vty *vty, struct peer *p)
 
   /* Packet counts. */
   vty_out (vty, "  Message statistics:%s", VTY_NEWLINE);
-  vty_out (vty, "    Inq depth is 0%s", VTY_NEWLINE);
+  vty_out (vty, "    Inq depth is %lu%s", p->input_pending, VTY_NEWLINE);
   vty_out (vty, "    Outq depth is %lu%s", (unsigned long) p->obuf->count, VTY_NEWLINE);
   vty_out (vty, "                         Sent       Rcvd%s", VTY_NEWLINE);
   vty_out (vty, "    Opens:         %10d %10d%s", p->open_out, p->open_in, VTY_NEWLINE);
@@ -8371,6 +8405,18 @@ bgp_show_peer (struct vty *vty, struct peer *p)
 	   p->open_in + p->notify_in + p->update_in + p->keepalive_in + p->refresh_in +
 	   p->dynamic_cap_in, VTY_NEWLINE);
 
+  /* Input queue. */
+  vty_out (vty, "  Input queue: %lu nodes pending, %u waiting for dispatch,"
+	   " max %lu%s", p->input_pending,
+	   p->input_queue ? listcount (p->input_queue) : 0,
+	   p->input_pending_max, VTY_NEWLINE);
+  vty_out (vty, "    Processing latency: last %lu ms, average %lu ms,"
+	   " max %lu ms%s", p->input_latency_last, p->input_latency_avg,
+	   p->input_latency_max, VTY_NEWLINE);
+  vty_out (vty, "    Reading held %u times%s%s", p->input_holds,
+	   CHECK_FLAG (p->sflags, PEER_STATUS_INPUT_HOLD)
+	   ? ", held until the queue drains" : "", VTY_NEWLINE);
+
   /* advertisement-interval */
   vty_out (vty, "  Minimum time between advertisement runs is %d seconds%s",
 	   p->v_routeadv, VTY_NEWLINE);
@@ -9895,6 +9941,10 @@ bgp_vty_init (void)
   install_element (BGP_NODE, &bgp_deterministic_med_cmd);
   install_element (BGP_NODE, &no_bgp_deterministic_med_cmd);
 
+  /* "bgp pic" commands. */
+  install_element (BGP_NODE, &bgp_pic_cmd);
+  install_element (BGP_NODE, &no_bgp_pic_cmd);
+
   /* "bgp graceful-restart" commands */
   install_element (BGP_NODE, &bgp_graceful_restart_cmd);
   install_element (BGP_NODE, &no_bgp_graceful_restart_cmd);
@@ -39,6 +39,7 @@ Boston, MA 02111-1307, USA.  */
 #include "bgpd/bgp_fsm.h"
 #include "bgpd/bgp_debug.h"
 #include "bgpd/bgp_mpath.h"
+#include "bgpd/bgp_pathlist.h"
 
 /* All information about zebra. */
 struct zclient *zclient = NULL;
@@ -661,13 +662,61 @@ bgp_nexthop_set (union sockunion *local, union sockunion *remote,
   return ret;
 }
 
+/* IPv6 nexthop, and its interface, to install for a path. */
+struct in6_addr *
+bgp_info_to_ipv6_nexthop (struct bgp_info *info, ifindex_t *ifindex)
+{
+  struct in6_addr *nexthop;
+  struct peer *peer;
+
+  peer = info->peer;
+  *ifindex = 0;
+  nexthop = NULL;
+
+  assert (info->attr->extra);
+
+  /* Only global address nexthop exists. */
+  if (info->attr->extra->mp_nexthop_len == 16)
+    nexthop = &info->attr->extra->mp_nexthop_global;
+
+  /* If both global and link-local address present. */
+  if (info->attr->extra->mp_nexthop_len == 32)
+    {
+      /* Workaround for Cisco's nexthop bug.  */
+      if (IN6_IS_ADDR_UNSPECIFIED (&info->attr->extra->mp_nexthop_global)
+          && peer->su_remote->sa.sa_family == AF_INET6)
+        nexthop = &peer->su_remote->sin6.sin6_addr;
+      else
+        nexthop = &info->attr->extra->mp_nexthop_local;
+
+      if (peer->nexthop.ifp)
+        *ifindex = peer->nexthop.ifp->ifindex;
+    }
+
+  if (nexthop == NULL)
+    return NULL;
+
+  if (IN6_IS_ADDR_LINKLOCAL (nexthop) && ! *ifindex)
+    {
+      if (peer->ifname)
+        *ifindex = ifname2ifindex (peer->ifname);
+      else if (peer->nexthop.ifp)
+        *ifindex = peer->nexthop.ifp->ifindex;
+    }
+
+  return nexthop;
+}
+
 void
-bgp_zebra_announce (struct prefix *p, struct bgp_info *info, struct bgp *bgp, safi_t safi)
+bgp_zebra_announce (struct bgp_node *rn, struct bgp_info *info,
+                    struct bgp *bgp, safi_t safi)
 {
   int flags;
   u_char distance;
+  struct prefix *p;
   struct peer *peer;
   struct bgp_info *mpinfo;
+  struct bgp_pathlist *pathlist;
   size_t oldsize, newsize;
 
   if (zclient->sock < 0)
@@ -676,6 +725,8 @@ bgp_zebra_announce (struct prefix *p, struct bgp_info *info, struct bgp *bgp, sa
   if (! vrf_bitmap_check (zclient->redist[ZEBRA_ROUTE_BGP], VRF_DEFAULT))
     return;
 
+  p = &rn->p;
+
   flags = 0;
   peer = info->peer;
 
@@ -704,6 +755,12 @@ bgp_zebra_announce (struct prefix *p, struct bgp_info *info, struct bgp *bgp, sa
 
   stream_reset (bgp_nexthop_buf);
 
+  /* With prefix independent convergence, the route follows the
+     path-list of its paths and backup path, which is sent first. */
+  pathlist = NULL;
+  if (bgp_flag_check (bgp, BGP_FLAG_PIC))
+    pathlist = bgp_pathlist_select (bgp, rn, info, safi);
+
   if (p->family == AF_INET)
     {
       struct zapi_ipv4 api;
@@ -738,6 +795,12 @@ bgp_zebra_announce (struct prefix *p, struct bgp_info *info, struct bgp *bgp, sa
 	  api.distance = distance;
 	}
 
+      if (pathlist)
+	{
+	  SET_FLAG (api.message, ZAPI_MESSAGE_PATHLIST);
+	  api.pathlist = pathlist->id;
+	}
+
       if (BGP_DEBUG(zebra, ZEBRA))
 	{
 	  int i;
@@ -765,38 +828,13 @@ bgp_zebra_announce (struct prefix *p, struct bgp_info *info, struct bgp *bgp, sa
       struct in6_addr *nexthop;
       struct zapi_ipv6 api;
 
-      ifindex = 0;
-      nexthop = NULL;
-      
-      assert (info->attr->extra);
-      
-      /* Only global address nexthop exists. */
-      if (info->attr->extra->mp_nexthop_len == 16)
-	nexthop = &info->attr->extra->mp_nexthop_global;
-      
-      /* If both global and link-local address present. */
-      if (info->attr->extra->mp_nexthop_len == 32)
-	{
-	  /* Workaround for Cisco's nexthop bug.  */
-	  if (IN6_IS_ADDR_UNSPECIFIED (&info->attr->extra->mp_nexthop_global)
-	      && peer->su_remote->sa.sa_family == AF_INET6)
-	    nexthop = &peer->su_remote->sin6.sin6_addr;
-	  else
-	    nexthop = &info->attr->extra->mp_nexthop_local;
-
-	  if (info->peer->nexthop.ifp)
-	    ifindex = info->peer->nexthop.ifp->ifindex;
-	}
+      nexthop = bgp_info_to_ipv6_nexthop (info, &ifindex);
 
       if (nexthop == NULL)
-	return;
-
-      if (IN6_IS_ADDR_LINKLOCAL (nexthop) && ! ifindex)
 	{
-	  if (info->peer->ifname)
-	    ifindex = ifname2ifindex (info->peer->ifname);
-	  else if (info->peer->nexthop.ifp)
-	    ifindex = info->peer->nexthop.ifp->ifindex;
+	  if (pathlist)
+	    bgp_pathlist_unlock (pathlist);
+	  return;
 	}
 
       /* Make Zebra API structure. */
@@ -814,6 +852,12 @@ bgp_zebra_announce (struct prefix *p, struct bgp_info *info, struct bgp *bgp, sa
       SET_FLAG (api.message, ZAPI_MESSAGE_METRIC);
       api.metric = info->attr->med;
 
+      if (pathlist)
+	{
+	  SET_FLAG (api.message, ZAPI_MESSAGE_PATHLIST);
+	  api.pathlist = pathlist->id;
+	}
+
       if (BGP_DEBUG(zebra, ZEBRA))
 	{
 	  char buf[2][INET6_ADDRSTRLEN];
@@ -827,20 +871,34 @@ bgp_zebra_announce (struct prefix *p, struct bgp_info *info, struct bgp *bgp, sa
       zapi_ipv6_route (ZEBRA_IPV6_ROUTE_ADD, zclient, 
                        (struct prefix_ipv6 *) p, &api);
     }
+
+  /* The route now references the new path-list, if any. */
+  if (rn->pathlist)
+    bgp_pathlist_unlock (rn->pathlist);
+  rn->pathlist = pathlist;
 }
 
 void
-bgp_zebra_withdraw (struct prefix *p, struct bgp_info *info, safi_t safi)
+bgp_zebra_withdraw (struct bgp_node *rn, struct bgp_info *info, safi_t safi)
 {
   int flags;
+  struct prefix *p;
   struct peer *peer;
 
+  if (rn->pathlist)
+    {
+      bgp_pathlist_unlock (rn->pathlist);
+      rn->pathlist = NULL;
+    }
+
   if (zclient->sock < 0)
     return;
 
   if (! vrf_bitmap_check (zclient->redist[ZEBRA_ROUTE_BGP], VRF_DEFAULT))
     return;
 
+  p = &rn->p;
+
   peer = info->peer;
   flags = 0;
 
@@ -1048,6 +1106,7 @@ static void
 bgp_zebra_connected (struct zclient *zclient)
 {
   zclient_send_requests (zclient, VRF_DEFAULT);
+  bgp_pathlist_zebra_connected ();
 }
 
 void
@@ -32,8 +32,9 @@ extern int bgp_config_write_maxpaths (struct vty *, struct bgp *, afi_t,
 				      safi_t, int *);
 extern int bgp_config_write_redistribute (struct vty *, struct bgp *, afi_t, safi_t,
 				   int *);
-extern void bgp_zebra_announce (struct prefix *, struct bgp_info *, struct bgp *, safi_t);
-extern void bgp_zebra_withdraw (struct prefix *, struct bgp_info *, safi_t);
+extern void bgp_zebra_announce (struct bgp_node *, struct bgp_info *, struct bgp *, safi_t);
+extern void bgp_zebra_withdraw (struct bgp_node *, struct bgp_info *, safi_t);
+extern struct in6_addr *bgp_info_to_ipv6_nexthop (struct bgp_info *, ifindex_t *);
 
 extern int bgp_redistribute_set (struct bgp *, afi_t, int);
 extern int bgp_redistribute_rmap_set (struct bgp *, afi_t, int, const char *);
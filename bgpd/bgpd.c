@@ -61,6 +61,9 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "bgpd/bgp_network.h"
 #include "bgpd/bgp_vty.h"
 #include "bgpd/bgp_mpath.h"
+#include "bgpd/bgp_pathlist.h"
+#include "bgpd/bgp_gr.h"
+#include "bgpd/bgp_rsview.h"
 #ifdef HAVE_SNMP
 #include "bgpd/bgp_snmp.h"
 #endif /* HAVE_SNMP */
@@ -120,9 +123,13 @@ bgp_option_check (int flag)
 }
 
 /* BGP flag manipulation.  */
+#define BGP_FLAG_KEY (BGP_FLAG_ASPATH_IGNORE | BGP_FLAG_ASPATH_CONFED)
+
 int
 bgp_flag_set (struct bgp *bgp, int flag)
 {
+  if (flag & BGP_FLAG_KEY)
+    bgp->key_version++;
   SET_FLAG (bgp->flags, flag);
   return 0;
 }
@@ -130,6 +137,8 @@ bgp_flag_set (struct bgp *bgp, int flag)
 int
 bgp_flag_unset (struct bgp *bgp, int flag)
 {
+  if (flag & BGP_FLAG_KEY)
+    bgp->key_version++;
   UNSET_FLAG (bgp->flags, flag);
   return 0;
 }
@@ -497,6 +506,7 @@ bgp_default_local_preference_set (struct bgp *bgp, u_int32_t local_pref)
     return -1;
 
   bgp->default_local_pref = local_pref;
+  bgp->key_version++;
 
   return 0;
 }
@@ -508,12 +518,13 @@ bgp_default_local_preference_unset (struct bgp *bgp)
     return -1;
 
   bgp->default_local_pref = BGP_DEFAULT_LOCAL_PREF;
+  bgp->key_version++;
 
   return 0;
 }
 
 /* If peer is RSERVER_CLIENT in at least one address family and is not member
-    of a peer_group for that family, return 1.
+    of a peer_group or of a shared view for that family, return 1.
     Used to check wether the peer is included in list bgp->rsclient. */
 int
 peer_rsclient_active (struct peer *peer)
@@ -524,7 +535,7 @@ peer_rsclient_active (struct peer *peer)
   for (i=AFI_IP; i < AFI_MAX; i++)
     for (j=SAFI_UNICAST; j < SAFI_MAX; j++)
       if (CHECK_FLAG(peer->af_flags[i][j], PEER_FLAG_RSERVER_CLIENT)
-            && ! peer->af_group[i][j])
+            && ! peer->af_group[i][j] && ! peer->rsview[i][j])
         return 1;
   return 0;
 }
@@ -754,6 +765,14 @@ peer_free (struct peer *peer)
       work_queue_free(peer->clear_node_queue);
       peer->clear_node_queue = NULL;
     }
+
+  bgp_peer_index_free (peer);
+
+  if (peer->input_queue)
+    {
+      list_delete (peer->input_queue);
+      peer->input_queue = NULL;
+    }
   
   if (peer->notify.data)
     XFREE(MTYPE_TMP, peer->notify.data);
@@ -1239,6 +1258,7 @@ peer_delete (struct peer *peer)
      relationship.  */
   if (peer->group)
     {
+      bgp_rsview_flush_peer (peer->group, peer);
       if ((pn = listnode_lookup (peer->group->peer, peer)))
         {
           peer = peer_unlock (peer); /* group->peer list reference */
@@ -1271,10 +1291,17 @@ peer_delete (struct peer *peer)
   if (! CHECK_FLAG (peer->sflags, PEER_STATUS_GROUP)
       && (pn = listnode_lookup (bgp->peer, peer)))
     {
+      bgp_gr_peer_change (peer);
       peer_unlock (peer); /* bgp peer list reference */
       list_delete_node (bgp->peer, pn);
     }
       
+  /* Leave the shared views. */
+  for (afi = AFI_IP; afi < AFI_MAX; afi++)
+    for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
+      if (peer->rsview[afi][safi])
+        bgp_rsview_detach (peer, afi, safi);
+
   if (peer_rsclient_active (peer)
       && (pn = listnode_lookup (bgp->rsclient, peer)))
     {
@@ -1441,6 +1468,29 @@ peer_group_lookup (struct bgp *bgp, const char *name)
   return NULL;
 }
 
+/* Configuration peer of a group. */
+struct peer *
+peer_group_conf_new (struct peer_group *group, const char *host)
+{
+  struct peer *conf;
+
+  conf = peer_new (group->bgp);
+  conf->host = XSTRDUP (MTYPE_BGP_PEER_HOST, host);
+  conf->group = group;
+  conf->as = 0; 
+  conf->ttl = 1;
+  conf->gtsm_hops = 0;
+  conf->v_routeadv = BGP_DEFAULT_EBGP_ROUTEADV;
+  UNSET_FLAG (conf->config, PEER_CONFIG_TIMER);
+  UNSET_FLAG (conf->config, PEER_CONFIG_CONNECT);
+  conf->keepalive = 0;
+  conf->holdtime = 0;
+  conf->connect = 0;
+  SET_FLAG (conf->sflags, PEER_STATUS_GROUP);
+
+  return conf;
+}
+
 struct peer_group *
 peer_group_get (struct bgp *bgp, const char *name)
 {
@@ -1454,21 +1504,9 @@ peer_group_get (struct bgp *bgp, const char *name)
   group->bgp = bgp;
   group->name = strdup (name);
   group->peer = list_new ();
-  group->conf = peer_new (bgp);
+  group->conf = peer_group_conf_new (group, name);
   if (! bgp_flag_check (bgp, BGP_FLAG_NO_DEFAULT_IPV4))
     group->conf->afc[AFI_IP][SAFI_UNICAST] = 1;
-  group->conf->host = XSTRDUP (MTYPE_BGP_PEER_HOST, name);
-  group->conf->group = group;
-  group->conf->as = 0; 
-  group->conf->ttl = 1;
-  group->conf->gtsm_hops = 0;
-  group->conf->v_routeadv = BGP_DEFAULT_EBGP_ROUTEADV;
-  UNSET_FLAG (group->conf->config, PEER_CONFIG_TIMER);
-  UNSET_FLAG (group->conf->config, PEER_CONFIG_CONNECT);
-  group->conf->keepalive = 0;
-  group->conf->holdtime = 0;
-  group->conf->connect = 0;
-  SET_FLAG (group->conf->sflags, PEER_STATUS_GROUP);
   listnode_add_sort (bgp->group, group);
 
   return 0;
@@ -1778,6 +1816,8 @@ peer_group_delete (struct peer_group *group)
   free (group->name);
   group->name = NULL;
 
+  bgp_rsview_cache_free (group);
+
   group->conf->group = NULL;
   peer_delete (group->conf);
 
@@ -1908,6 +1948,9 @@ peer_group_bind (struct bgp *bgp, union sockunion *su,
   if (CHECK_FLAG(peer->af_flags[afi][safi], PEER_FLAG_RSERVER_CLIENT))
     {
       struct listnode *pn;
+
+      if (peer->rsview[afi][safi])
+        bgp_rsview_detach (peer, afi, safi);
       
       /* If it's not configured as RSERVER_CLIENT in any other address
           family, without being member of a peer_group, remove it from
@@ -1971,7 +2014,10 @@ peer_group_unbind (struct bgp *bgp, struct peer *peer,
   peer_af_flag_reset (peer, afi, safi);
 
   if (peer->rib[afi][safi])
-    peer->rib[afi][safi] = NULL;
+    {
+      bgp_rsview_flush_peer (group, peer);
+      peer->rib[afi][safi] = NULL;
+    }
 
   if (! peer_group_active (peer))
     {
@@ -2007,6 +2053,7 @@ bgp_startup_timer_expire (struct thread *thread)
 
   bgp = THREAD_ARG (thread);
   bgp->t_startup = NULL;
+  bgp_gr_restart_end (bgp, "restart time expired");
 
   return 0;
 }
@@ -2033,6 +2080,7 @@ bgp_create (as_t *as, const char *name)
   bgp->group->cmp = (int (*)(void *, void *)) peer_group_cmp;
 
   bgp->rsclient = list_new ();
+  bgp->rsview = list_new ();
   bgp->rsclient->cmp = (int (*)(void*, void*)) peer_cmp;
 
   for (afi = AFI_IP; afi < AFI_MAX; afi++)
@@ -2059,6 +2107,7 @@ bgp_create (as_t *as, const char *name)
 
   THREAD_TIMER_ON (bm->master, bgp->t_startup, bgp_startup_timer_expire,
                    bgp, bgp->restart_time);
+  bgp_gr_restart_init (bgp);
 
   return bgp;
 }
@@ -2179,6 +2228,7 @@ bgp_delete (struct bgp *bgp)
   SET_FLAG(bgp->flags, BGP_FLAG_DELETING);
 
   THREAD_OFF (bgp->t_startup);
+  bgp_gr_delete (bgp);
 
   /* Delete static route. */
   bgp_static_delete (bgp);
@@ -2266,6 +2316,7 @@ bgp_free (struct bgp *bgp)
   list_delete (bgp->group);
   list_delete (bgp->peer);
   list_delete (bgp->rsclient);
+  list_delete (bgp->rsview);
 
   if (bgp->name)
     free (bgp->name);
@@ -2543,6 +2594,8 @@ peer_flag_modify_action (struct peer *peer, u_int32_t flag)
 			     BGP_NOTIFY_CEASE_ADMIN_SHUTDOWN);
 	  else
 	    BGP_EVENT_ADD (peer, BGP_Stop);
+
+	  bgp_gr_peer_change (peer);
 	}
       else
 	{
@@ -4329,8 +4382,17 @@ peer_route_map_set (struct peer *peer, afi_t afi, safi_t safi, int direct,
   filter->map[direct].name = strdup (name);
   filter->map[direct].map = route_map_lookup_by_name (name);
 
+  /* The view of a route server client goes with its import policy */
+  if (direct == RMAP_IMPORT && peer->rsview[afi][safi])
+    bgp_rsview_update (peer, afi, safi);
+
   if (! CHECK_FLAG (peer->sflags, PEER_STATUS_GROUP))
-    return 0;
+    {
+      /* and with the export policies naming it */
+      if (direct == RMAP_EXPORT)
+        bgp_rsview_update_all (peer->bgp);
+      return 0;
+    }
 
   group = peer->group;
   for (ALL_LIST_ELEMENTS (group->peer, node, nnode, peer))
@@ -4345,6 +4407,8 @@ peer_route_map_set (struct peer *peer, afi_t afi, safi_t safi, int direct,
       filter->map[direct].name = strdup (name);
       filter->map[direct].map = route_map_lookup_by_name (name);
     }
+  if (direct == RMAP_EXPORT)
+    bgp_rsview_update_all (group->bgp);
   return 0;
 }
 
@@ -4390,8 +4454,15 @@ peer_route_map_unset (struct peer *peer, afi_t afi, safi_t safi, int direct)
   filter->map[direct].name = NULL;
   filter->map[direct].map = NULL;
 
+  if (direct == RMAP_IMPORT && peer->rsview[afi][safi])
+    bgp_rsview_update (peer, afi, safi);
+
   if (! CHECK_FLAG (peer->sflags, PEER_STATUS_GROUP))
-    return 0;
+    {
+      if (direct == RMAP_EXPORT)
+        bgp_rsview_update_all (peer->bgp);
+      return 0;
+    }
 
   group = peer->group;
   for (ALL_LIST_ELEMENTS (group->peer, node, nnode, peer))
@@ -4406,6 +4477,8 @@ peer_route_map_unset (struct peer *peer, afi_t afi, safi_t safi, int direct)
       filter->map[direct].name = NULL;
       filter->map[direct].map = NULL;
     }
+  if (direct == RMAP_EXPORT)
+    bgp_rsview_update_all (group->bgp);
   return 0;
 }
 
@@ -4761,10 +4834,15 @@ peer_clear_soft (struct peer *peer, afi_t afi, safi_t safi,
 
   if (stype == BGP_CLEAR_SOFT_RSCLIENT)
     {
+      struct peer *rsclient = peer;
+
       if (! CHECK_FLAG (peer->af_flags[afi][safi], PEER_FLAG_RSERVER_CLIENT))
         return 0;
-      bgp_check_local_routes_rsclient (peer, afi, safi);
-      bgp_soft_reconfig_rsclient (peer, afi, safi);
+      /* The table of a shared view is filled for all its clients */
+      if (peer->rsview[afi][safi])
+        rsclient = peer->rsview[afi][safi]->conf;
+      bgp_check_local_routes_rsclient (rsclient, afi, safi);
+      bgp_soft_reconfig_rsclient (rsclient, afi, safi);
     }
 
   if (stype == BGP_CLEAR_SOFT_OUT || stype == BGP_CLEAR_SOFT_BOTH)
@@ -5478,6 +5556,14 @@ bgp_config_write (struct vty *vty)
       if (bgp_flag_check (bgp, BGP_FLAG_DETERMINISTIC_MED))
 	vty_out (vty, " bgp deterministic-med%s", VTY_NEWLINE);
 
+      /* BGP prefix independent convergence. */
+      if (bgp_flag_check (bgp, BGP_FLAG_PIC))
+	vty_out (vty, " bgp pic%s", VTY_NEWLINE);
+
+      /* BGP route server views shared by the clients. */
+      if (bgp_flag_check (bgp, BGP_FLAG_RSERVER_SHARED))
+	vty_out (vty, " bgp route-server shared-rib%s", VTY_NEWLINE);
+
       /* BGP graceful-restart. */
       if (bgp->stalepath_time != BGP_DEFAULT_STALEPATH_TIME)
 	vty_out (vty, " bgp graceful-restart stalepath-time %d%s",
@@ -5589,6 +5675,7 @@ bgp_master_init (void)
   bm = &bgp_master;
   bm->bgp = list_new ();
   bm->listen_sockets = list_new ();
+  bm->input_peers = list_new ();
   bm->port = BGP_PORT_DEFAULT;
   bm->master = thread_master_create ();
   bm->start_time = bgp_clock ();
@@ -5612,8 +5699,11 @@ bgp_init (void)
   bgp_route_map_init ();
   bgp_address_init ();
   bgp_scan_init ();
+  bgp_pathlist_init ();
   bgp_mplsvpn_init ();
   bgp_encap_init ();
+  bgp_gr_init ();
+  bgp_rsview_init ();
 
   /* Access list initialize. */
   access_list_init ();
@@ -41,6 +41,11 @@ struct bgp_master
   /* work queues */
   struct work_queue *process_main_queue;
   struct work_queue *process_rsclient_queue;
+
+  /* Peers with nodes waiting in their input queue, served in deficit
+     round robin into process_main_queue. */
+  struct list *input_peers;
+  struct thread *t_input;
   
   /* Listening sockets */
   struct list *listen_sockets;
@@ -86,6 +91,9 @@ struct bgp
   /* BGP route-server-clients. */
   struct list *rsclient;
 
+  /* Route server views shared by clients, struct peer_group.  */
+  struct list *rsview;
+
   /* BGP configuration.  */
   u_int16_t config;
 #define BGP_CONFIG_ROUTER_ID              (1 << 0)
@@ -106,8 +114,13 @@ struct bgp
 
   struct thread *t_startup;
 
+  /* Restarting gracefully: the FIB update and the advertisement of the
+     routes are deferred until the peers sent End-of-RIB, see bgp_gr.c.  */
+  u_char gr_restarting;
+  struct thread *t_gr_check;
+
   /* BGP flags. */
-  u_int16_t flags;
+  u_int32_t flags;
 #define BGP_FLAG_ALWAYS_COMPARE_MED       (1 << 0)
 #define BGP_FLAG_DETERMINISTIC_MED        (1 << 1)
 #define BGP_FLAG_MED_MISSING_AS_WORST     (1 << 2)
@@ -124,6 +137,8 @@ struct bgp
 #define BGP_FLAG_ASPATH_CONFED            (1 << 13)
 #define BGP_FLAG_ASPATH_MULTIPATH_RELAX   (1 << 14)
 #define BGP_FLAG_DELETING                 (1 << 15)
+#define BGP_FLAG_PIC                      (1 << 16)
+#define BGP_FLAG_RSERVER_SHARED           (1 << 17)
 
   /* BGP Per AF flags */
   u_int16_t af_flags[AFI_MAX][SAFI_MAX];
@@ -138,6 +153,9 @@ struct bgp
   /* BGP routing information base.  */
   struct bgp_table *rib[AFI_MAX][SAFI_MAX];
 
+  /* Walks of the RIB sending it to peers, see bgp_announce_route ().  */
+  struct bgp_announce_job *announce[AFI_MAX][SAFI_MAX];
+
   /* BGP redistribute configuration. */
   u_char redist[AFI_MAX][ZEBRA_ROUTE_MAX];
 
@@ -160,6 +178,10 @@ struct bgp
   /* BGP default local-preference.  */
   u_int32_t default_local_pref;
 
+  /* Changed with the configuration the decision keys of the paths
+     depend on, see bgp_info_key_update ().  */
+  u_int32_t key_version;
+
   /* BGP default timer.  */
   u_int32_t default_holdtime;
   u_int32_t default_keepalive;
@@ -189,6 +211,14 @@ struct peer_group
 
   /* Peer-group config */
   struct peer *conf;
+
+  /* Shared view of route server clients, not configured, see
+     bgp_rsview.c.  */
+  u_char rsview;
+
+  /* Paths of the table sent to members the selected one can't be sent
+     to, per node, see bgp_rsview.c.  */
+  struct hash *rsdelta;
 };
 
 /* BGP Notify message format. */
@@ -272,6 +302,15 @@ typedef enum
   BGP_PEER_CONFED,
 } bgp_peer_sort_t;
 
+/* Route flap dampening statistics of a peer, per address family.  */
+struct peer_damp_stats
+{
+  u_int32_t flaps;		/* Withdrawals penalised */
+  u_int32_t suppressed;		/* Paths suppressed now */
+  u_int32_t suppress;		/* Paths suppressed in total */
+  u_int32_t reuse;		/* Suppressed paths reused */
+};
+
 /* BGP neighbor structure. */
 struct peer
 {
@@ -309,6 +348,11 @@ struct peer
   /* Peer specific RIB when configured as route-server-client. */
   struct bgp_table *rib[AFI_MAX][SAFI_MAX];
 
+  /* Shared view the RIB above belongs to, and number of its nodes the
+     peer is sent another path than the selected one.  */
+  struct peer_group *rsview[AFI_MAX][SAFI_MAX];
+  unsigned long rsview_deltas[AFI_MAX][SAFI_MAX];
+
   /* Packet receive and send buffer. */
   struct stream *ibuf;
   struct stream_fifo *obuf;
@@ -437,6 +481,7 @@ struct peer
 #define PEER_STATUS_GROUP             (1 << 4) /* peer-group conf */
 #define PEER_STATUS_NSF_MODE          (1 << 5) /* NSF aware peer */
 #define PEER_STATUS_NSF_WAIT          (1 << 6) /* wait comeback peer */
+#define PEER_STATUS_INPUT_HOLD        (1 << 7) /* input queue over budget */
 
   /* Peer status af flags (reset in bgp_stop) */
   u_int16_t af_sflags[AFI_MAX][SAFI_MAX];
@@ -447,6 +492,7 @@ struct peer
 #define PEER_STATUS_PREFIX_LIMIT      (1 << 4) /* exceed prefix-limit */
 #define PEER_STATUS_EOR_SEND          (1 << 5) /* end-of-rib send to peer */
 #define PEER_STATUS_EOR_RECEIVED      (1 << 6) /* end-of-rib received from peer */
+#define PEER_STATUS_ANNOUNCE          (1 << 7) /* table being announced */
 
   /* Default attribute value for the peer. */
   u_int32_t config;
@@ -483,6 +529,23 @@ struct peer
   
   /* workqueues */
   struct work_queue *clear_node_queue;
+
+  /* Nodes of the RIB with routes, adj-in or adj-out of the peer, walked
+     instead of the whole table when clearing the peer.  */
+  struct bgp_peer_index *rib_index[AFI_MAX][SAFI_MAX];
+
+  /* Nodes changed by this peer, waiting to be dispatched to the process
+     queue, and nodes changed but not yet processed. */
+  struct list *input_queue;
+  int input_deficit;
+  unsigned long input_pending;
+  unsigned long input_pending_max;
+  u_int32_t input_holds;
+
+  /* Time from update to processing, in milliseconds. */
+  unsigned long input_latency_last;
+  unsigned long input_latency_avg;
+  unsigned long input_latency_max;
   
   /* Statistics field */
   u_int32_t open_in;		/* Open message input count */
@@ -503,6 +566,9 @@ struct peer
   u_int32_t established;	/* Established */
   u_int32_t dropped;		/* Dropped */
 
+  /* Dampening statistics.  */
+  struct peer_damp_stats damp[AFI_MAX][SAFI_MAX];
+
   /* Syncronization list and time.  */
   struct bgp_synchronize *sync[AFI_MAX][SAFI_MAX];
   time_t synctime;
@@ -757,6 +823,22 @@ struct bgp_nlri
 #define BGP_DEFAULT_RESTART_TIME               120
 #define BGP_DEFAULT_STALEPATH_TIME             360
 
+/* Per-peer input queues: cost dispatched per peer and round, nodes kept
+   in the process queue, and nodes pending before reading is held.  */
+#define BGP_INPUT_QUANTUM                      100
+#define BGP_INPUT_BATCH                        1000
+#define BGP_INPUT_BUDGET                       10000
+#define BGP_INPUT_RESUME                       (BGP_INPUT_BUDGET / 2)
+
+/* Routes checked per event, for all the peers, when announcing the
+   table.  */
+#define BGP_ANNOUNCE_SLICE                     10000
+
+/* Nodes of a peer cleared per event, and nodes first indexed for a
+   peer.  */
+#define BGP_CLEAR_SLICE                        10000
+#define BGP_PEER_INDEX_MIN                     64
+
 /* RFC4364 */
 #define SAFI_MPLS_LABELED_VPN                  128
 
@@ -844,6 +926,7 @@ extern struct bgp *bgp_lookup_by_name (const char *);
 extern struct peer *peer_lookup (struct bgp *, union sockunion *);
 extern struct peer_group *peer_group_lookup (struct bgp *, const char *);
 extern struct peer_group *peer_group_get (struct bgp *, const char *);
+extern struct peer *peer_group_conf_new (struct peer_group *, const char *);
 extern struct peer *peer_lookup_with_open (union sockunion *, as_t, struct in_addr *,
 				    int *);
 
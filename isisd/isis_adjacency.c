@@ -32,7 +32,7 @@
 #include "if.h"
 #include "stream.h"
 
-#include "isisd/dict.h"
+#include "isisd/isis_lspdb.h"
 #include "isisd/include-netbsd/iso.h"
 #include "isisd/isis_constants.h"
 #include "isisd/isis_common.h"
@@ -222,6 +222,9 @@ isis_adj_state_change (struct isis_adjacency *adj, enum isis_adj_state new_state
         if (new_state == ISIS_ADJ_UP)
         {
           circuit->upadjcount[level - 1]++;
+          /* Queue the LSPs flagged meanwhile */
+          if (circuit->upadjcount[level - 1] == 1)
+            lsp_queue_rebuild (circuit);
           isis_event_adjacency_state_change (adj, new_state);
           /* update counter & timers for debugging purposes */
           adj->last_flap = time (NULL);
@@ -231,12 +234,9 @@ isis_adj_state_change (struct isis_adjacency *adj, enum isis_adj_state new_state
         {
           listnode_delete (circuit->u.bc.adjdb[level - 1], adj);
           circuit->upadjcount[level - 1]--;
+          /* Clean lsp_queue when no adj is up. */
           if (circuit->upadjcount[level - 1] == 0)
-            {
-              /* Clean lsp_queue when no adj is up. */
-              if (circuit->lsp_queue)
-                list_delete_all_node (circuit->lsp_queue);
-            }
+            lsp_queue_rebuild (circuit);
           isis_event_adjacency_state_change (adj, new_state);
           isis_delete_adj (adj);
         }
@@ -262,6 +262,9 @@ isis_adj_state_change (struct isis_adjacency *adj, enum isis_adj_state new_state
         if (new_state == ISIS_ADJ_UP)
         {
           circuit->upadjcount[level - 1]++;
+          /* Queue the LSPs flagged meanwhile */
+          if (circuit->upadjcount[level - 1] == 1)
+            lsp_queue_rebuild (circuit);
           isis_event_adjacency_state_change (adj, new_state);
 
           if (adj->sys_type == ISIS_SYSTYPE_UNKNOWN)
@@ -280,12 +283,9 @@ isis_adj_state_change (struct isis_adjacency *adj, enum isis_adj_state new_state
           if (adj->circuit->u.p2p.neighbor == adj)
             adj->circuit->u.p2p.neighbor = NULL;
           circuit->upadjcount[level - 1]--;
+          /* Clean lsp_queue when no adj is up. */
           if (circuit->upadjcount[level - 1] == 0)
-            {
-              /* Clean lsp_queue when no adj is up. */
-              if (circuit->lsp_queue)
-                list_delete_all_node (circuit->lsp_queue);
-            }
+            lsp_queue_rebuild (circuit);
           isis_event_adjacency_state_change (adj, new_state);
           isis_delete_adj (adj);
         }
@@ -418,6 +418,8 @@ isis_adj_print_vty (struct isis_adjacency *adj, struct vty *vty, char detail)
       vty_out (vty, "    Adjacency flaps: %u", adj->flaps);
       vty_out (vty, ", Last: %s ago", time2string (now - adj->last_flap));
       vty_out (vty, "%s", VTY_NEWLINE);
+      if (adj->gr_helping)
+	vty_out (vty, "    Restarting, helper mode%s", VTY_NEWLINE);
       vty_out (vty, "    Circuit type: %s", circuit_t2string (adj->circuit_t));
       vty_out (vty, ", Speaks: %s", nlpid2string (&adj->nlpids));
       vty_out (vty, "%s", VTY_NEWLINE);
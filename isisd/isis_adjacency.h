@@ -97,6 +97,7 @@ struct isis_adjacency
   u_int32_t last_upd;
   u_int32_t last_flap;		/* last time the adj flapped */
   int flaps;			/* number of adjacency flaps  */
+  u_char gr_helping;		/* neighbour restarting, see isis_gr.h */
   struct thread *t_expire;	/* expire after hold_time  */
   struct isis_circuit *circuit;	/* back pointer */
 };
@@ -41,7 +41,7 @@
 #include "prefix.h"
 #include "stream.h"
 
-#include "isisd/dict.h"
+#include "isisd/isis_lspdb.h"
 #include "isisd/include-netbsd/iso.h"
 #include "isisd/isis_constants.h"
 #include "isisd/isis_common.h"
@@ -59,6 +59,7 @@
 #include "isisd/isis_csm.h"
 #include "isisd/isis_events.h"
 #include "isisd/isis_te.h"
+#include "isisd/isis_flood.h"
 
 /*
  * Prototypes.
@@ -113,6 +114,9 @@ isis_circuit_del (struct isis_circuit *circuit)
 
   isis_circuit_if_unbind (circuit, circuit->interface);
 
+  if (circuit->mtc)
+    THREAD_OFF (circuit->mtc->t_hold);
+
   /* and lastly the circuit itself */
   XFREE (MTYPE_ISIS_CIRCUIT, circuit);
 
@@ -573,8 +577,8 @@ static void
 isis_circuit_update_all_srmflags (struct isis_circuit *circuit, int is_set)
 {
   struct isis_area *area;
+  struct lspdb_cursor cur;
   struct isis_lsp *lsp;
-  dnode_t *dnode, *dnode_next;
   int level;
 
   assert (circuit);
@@ -585,16 +589,13 @@ isis_circuit_update_all_srmflags (struct isis_circuit *circuit, int is_set)
       if (level & circuit->is_type)
         {
           if (area->lspdb[level - 1] &&
-              dict_count (area->lspdb[level - 1]) > 0)
+              lspdb_count (area->lspdb[level - 1]) > 0)
             {
-              for (dnode = dict_first (area->lspdb[level - 1]);
-                   dnode != NULL; dnode = dnode_next)
+              LSPDB_FOREACH (area->lspdb[level - 1], cur, lsp)
                 {
-                  dnode_next = dict_next (area->lspdb[level - 1], dnode);
-                  lsp = dnode_get (dnode);
                   if (is_set)
                     {
-                      ISIS_SET_FLAG (lsp->SRMflags, circuit);
+                      lsp_srm_set (lsp, circuit);
                     }
                   else
                     {
@@ -715,6 +716,18 @@ isis_circuit_up (struct isis_circuit *circuit)
        */
       circuit->u.p2p.neighbor = NULL;
       thread_add_event (master, send_p2p_hello, circuit, 0);
+
+      /* Flood until the next flooding topology computation; the CSNP
+       * timers only send when the circuit may miss LSPs */
+      circuit->flood_tree[0] = circuit->flood_tree[1] = 1;
+      if (circuit->is_type & IS_LEVEL_1)
+        THREAD_TIMER_ON (master, circuit->t_send_csnp[0], send_l1_csnp,
+                         circuit, isis_jitter (circuit->csnp_interval[0],
+                                               CSNP_JITTER));
+      if (circuit->is_type & IS_LEVEL_2)
+        THREAD_TIMER_ON (master, circuit->t_send_csnp[1], send_l2_csnp,
+                         circuit, isis_jitter (circuit->csnp_interval[1],
+                                               CSNP_JITTER));
     }
 
   /* initializing PSNP timers */
@@ -747,7 +760,9 @@ isis_circuit_up (struct isis_circuit *circuit)
 #endif
 
   circuit->lsp_queue = list_new ();
-  circuit->lsp_queue_last_cleared = time (NULL);
+  circuit->lsp_rxmt_queue = list_new ();
+  circuit->ssn_queue[0] = list_new ();
+  circuit->ssn_queue[1] = list_new ();
 
   return ISIS_OK;
 }
@@ -755,6 +770,8 @@ isis_circuit_up (struct isis_circuit *circuit)
 void
 isis_circuit_down (struct isis_circuit *circuit)
 {
+  int i;
+
   if (circuit->state != C_STATE_UP)
     return;
 
@@ -826,10 +843,20 @@ isis_circuit_down (struct isis_circuit *circuit)
 
   if (circuit->lsp_queue)
     {
-      circuit->lsp_queue->del = NULL;
+      lsp_queue_flush (circuit);
       list_delete (circuit->lsp_queue);
       circuit->lsp_queue = NULL;
+      list_delete (circuit->lsp_rxmt_queue);
+      circuit->lsp_rxmt_queue = NULL;
     }
+  for (i = 0; i < 2; i++)
+    if (circuit->ssn_queue[i])
+      {
+        THREAD_OFF (circuit->t_psnp_batch[i]);
+        lsp_ssn_flush (circuit, i + 1);
+        list_delete (circuit->ssn_queue[i]);
+        circuit->ssn_queue[i] = NULL;
+      }
 
   /* send one gratuitous hello to spead up convergence */
   if (circuit->is_type & IS_LEVEL_1)
@@ -917,6 +944,11 @@ isis_circuit_print_vty (struct isis_circuit *circuit, struct vty *vty,
       if (circuit->circ_type == CIRCUIT_T_BROADCAST)
         vty_out (vty, ", SNPA: %-10s", snpa_print (circuit->u.bc.snpa));
       vty_out (vty, "%s", VTY_NEWLINE);
+      if (circuit->mesh_blocked)
+        vty_out (vty, "    Mesh group: blocked%s", VTY_NEWLINE);
+      else if (circuit->mesh_group)
+        vty_out (vty, "    Mesh group: %u%s", circuit->mesh_group,
+                 VTY_NEWLINE);
       if (circuit->is_type & IS_LEVEL_1)
         {
           vty_out (vty, "    Level-1 Information:%s", VTY_NEWLINE);
@@ -939,6 +971,16 @@ isis_circuit_print_vty (struct isis_circuit *circuit, struct vty *vty,
                             "PSNP interval: %u%s",
                        circuit->csnp_interval[0],
                        circuit->psnp_interval[0], VTY_NEWLINE);
+              vty_out (vty, "      LSPs received: %u, redundant: %u%s%s",
+                       circuit->lsp_rxed[0], circuit->lsp_redundant[0],
+                       (isis_flood_circuit (circuit, NULL, 1) ?
+                        "" : ", not flooding"), VTY_NEWLINE);
+              vty_out (vty, "      PSNPs sent: %u, %u bytes for %u LSP entries%s",
+                       circuit->psnp_sent[0], circuit->psnp_bytes[0],
+                       circuit->psnp_entries[0], VTY_NEWLINE);
+              vty_out (vty, "      CSNPs sent: %u, %u bytes%s",
+                       circuit->csnp_sent[0], circuit->csnp_bytes[0],
+                       VTY_NEWLINE);
               if (circuit->circ_type == CIRCUIT_T_BROADCAST)
                 vty_out (vty, "      LAN Priority: %u, %s%s",
                          circuit->priority[0],
@@ -972,6 +1014,16 @@ isis_circuit_print_vty (struct isis_circuit *circuit, struct vty *vty,
                             "PSNP interval: %u%s",
                        circuit->csnp_interval[1],
                        circuit->psnp_interval[1], VTY_NEWLINE);
+              vty_out (vty, "      LSPs received: %u, redundant: %u%s%s",
+                       circuit->lsp_rxed[1], circuit->lsp_redundant[1],
+                       (isis_flood_circuit (circuit, NULL, 2) ?
+                        "" : ", not flooding"), VTY_NEWLINE);
+              vty_out (vty, "      PSNPs sent: %u, %u bytes for %u LSP entries%s",
+                       circuit->psnp_sent[1], circuit->psnp_bytes[1],
+                       circuit->psnp_entries[1], VTY_NEWLINE);
+              vty_out (vty, "      CSNPs sent: %u, %u bytes%s",
+                       circuit->csnp_sent[1], circuit->csnp_bytes[1],
+                       VTY_NEWLINE);
               if (circuit->circ_type == CIRCUIT_T_BROADCAST)
                 vty_out (vty, "      LAN Priority: %u, %s%s",
                          circuit->priority[1],
@@ -1137,6 +1189,19 @@ isis_interface_config_write (struct vty *vty)
               write++;
             }
 
+          /* ISIS - Mesh group */
+          if (circuit->mesh_blocked)
+            {
+              vty_out (vty, " isis mesh-group blocked%s", VTY_NEWLINE);
+              write++;
+            }
+          else if (circuit->mesh_group)
+            {
+              vty_out (vty, " isis mesh-group %u%s", circuit->mesh_group,
+                       VTY_NEWLINE);
+              write++;
+            }
+
           /* ISIS - Hello interval */
           if (circuit->hello_interval[0] == circuit->hello_interval[1])
             {
@@ -1624,6 +1689,7 @@ DEFUN (isis_passwd_md5,
   circuit->passwd.len = len;
   circuit->passwd.type = ISIS_PASSWD_TYPE_HMAC_MD5;
   strncpy ((char *)circuit->passwd.passwd, argv[0], 255);
+  hmac_md5_init (&circuit->passwd.hmac, circuit->passwd.passwd, len);
 
   return CMD_SUCCESS;
 }
@@ -2402,6 +2468,68 @@ DEFUN (no_isis_hello_padding,
   return CMD_SUCCESS;
 }
 
+DEFUN (isis_mesh_group,
+       isis_mesh_group_cmd,
+       "isis mesh-group <1-4294967295>",
+       "IS-IS commands\n"
+       "Set the mesh group of the circuit\n"
+       "Mesh group number\n")
+{
+  u_int32_t group;
+  struct isis_circuit *circuit = isis_circuit_lookup (vty);
+  if (!circuit)
+    return CMD_ERR_NO_MATCH;
+
+  VTY_GET_INTEGER_RANGE ("mesh group", group, argv[0], 1, 4294967295U);
+  circuit->mesh_group = group;
+  circuit->mesh_blocked = 0;
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (isis_mesh_group_blocked,
+       isis_mesh_group_blocked_cmd,
+       "isis mesh-group blocked",
+       "IS-IS commands\n"
+       "Set the mesh group of the circuit\n"
+       "Do not flood LSPs on the circuit\n")
+{
+  struct isis_circuit *circuit = isis_circuit_lookup (vty);
+  if (!circuit)
+    return CMD_ERR_NO_MATCH;
+
+  circuit->mesh_group = 0;
+  circuit->mesh_blocked = 1;
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (no_isis_mesh_group,
+       no_isis_mesh_group_cmd,
+       "no isis mesh-group",
+       NO_STR
+       "IS-IS commands\n"
+       "Set the mesh group of the circuit\n")
+{
+  struct isis_circuit *circuit = isis_circuit_lookup (vty);
+  if (!circuit)
+    return CMD_ERR_NO_MATCH;
+
+  circuit->mesh_group = 0;
+  circuit->mesh_blocked = 0;
+
+  return CMD_SUCCESS;
+}
+
+ALIAS (no_isis_mesh_group,
+       no_isis_mesh_group_arg_cmd,
+       "no isis mesh-group (<1-4294967295>|blocked)",
+       NO_STR
+       "IS-IS commands\n"
+       "Set the mesh group of the circuit\n"
+       "Mesh group number\n"
+       "Do not flood LSPs on the circuit\n")
+
 DEFUN (csnp_interval,
        csnp_interval_cmd,
        "isis csnp-interval <1-600>",
@@ -2913,6 +3041,11 @@ isis_circuit_init ()
   install_element (INTERFACE_NODE, &no_psnp_interval_l2_cmd);
   install_element (INTERFACE_NODE, &no_psnp_interval_l2_arg_cmd);
 
+  install_element (INTERFACE_NODE, &isis_mesh_group_cmd);
+  install_element (INTERFACE_NODE, &isis_mesh_group_blocked_cmd);
+  install_element (INTERFACE_NODE, &no_isis_mesh_group_cmd);
+  install_element (INTERFACE_NODE, &no_isis_mesh_group_arg_cmd);
+
   install_element (INTERFACE_NODE, &isis_network_cmd);
   install_element (INTERFACE_NODE, &no_isis_network_cmd);
 
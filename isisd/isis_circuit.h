@@ -78,10 +78,11 @@ struct isis_circuit
   struct thread *t_send_csnp[2];
   struct thread *t_send_psnp[2];
   struct list *lsp_queue;	/* LSPs to be txed (both levels) */
-  time_t lsp_queue_last_cleared;/* timestamp used to enforce transmit interval;
-                                 * for scalability, use one timestamp per 
-                                 * circuit, instead of one per lsp per circuit
-                                 */
+  struct list *lsp_rxmt_queue;	/* LSPs sent on P2P, awaiting ack */
+  struct thread *t_send_lsp;	/* paced lsp_queue transmission */
+  struct thread *t_lsp_rxmt;	/* lsp_rxmt_queue back to lsp_queue */
+  struct list *ssn_queue[2];	/* LSPs to acknowledge or request */
+  struct thread *t_psnp_batch[2];	/* sends ssn_queue, see isis_pdu.c */
   /* there is no real point in two streams, just for programming kicker */
   int (*rx) (struct isis_circuit * circuit, u_char * ssnpa);
   struct stream *rcv_stream;	/* Stream for receiving */
@@ -118,6 +119,8 @@ struct isis_circuit
   struct mpls_te_circuit *mtc; /* Support for MPLS-TE parameters - see isis_te.[c,h] */
   int ip_router;		/* Route IP ? */
   int is_passive;		/* Is Passive ? */
+  u_int32_t mesh_group;		/* RFC2973 mesh group, 0 for none */
+  u_char mesh_blocked;		/* no LSP flooding at all */
   struct list *ip_addrs;	/* our IP addresses */
 #ifdef HAVE_IPV6
   int ipv6_router;		/* Route IPv6 ? */
@@ -136,6 +139,18 @@ struct isis_circuit
   u_int32_t ctrl_pdus_txed;	/* controlPDUsSent */
   u_int32_t desig_changes[2];	/* lanLxDesignatedIntermediateSystemChanges */
   u_int32_t rej_adjacencies;	/* rejectedAdjacencies */
+  u_int32_t lsp_rxed[2];	/* LSPs received */
+  u_int32_t lsp_redundant[2];	/* of which not newer than ours */
+  u_int32_t psnp_sent[2];	/* PSNPs sent */
+  u_int32_t psnp_bytes[2];	/* and their size */
+  u_int32_t psnp_entries[2];	/* LSPs they acknowledged or requested */
+  u_int32_t csnp_sent[2];	/* CSNPs sent */
+  u_int32_t csnp_bytes[2];	/* and their size */
+  /* Neighbour on the flooding topology, see isis_flood.h */
+  u_char flood_tree[2];
+  /* Restart acknowledged and complete CSNP set received, see isis_gr.h */
+  u_char gr_ra[2];
+  u_char gr_csnp[2];
 };
 
 void isis_circuit_init (void);
@@ -24,6 +24,8 @@
 #ifndef ISIS_COMMON_H
 #define ISIS_COMMON_H
 
+#include "md5.h"
+
 /*
  * Area Address
  */
@@ -46,6 +48,8 @@ struct isis_passwd
 #define SNP_AUTH_RECV   0x02
   u_char snp_auth;
   u_char passwd[255];
+  /* HMAC-MD5 key pads, hashed when the password is set */
+  struct hmac_md5_ctx hmac;
 };
 
 /*
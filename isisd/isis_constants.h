@@ -44,6 +44,7 @@
 #define MAX_LSP_GEN_JITTER             5	/* % */
 #define CSNP_JITTER                   10	/* % */
 #define PSNP_JITTER                   10	/* % */
+#define PSNP_BATCH_DELAY              50	/* msec, see isis_psnp_schedule */
 
 #define RANDOM_SPREAD           100000.0
 
@@ -71,6 +72,8 @@
 #define DEFAULT_MIN_LSP_GEN_INTERVAL  30
 
 #define MIN_LSP_TRANS_INTERVAL        5
+#define LSP_TX_BURST                  10   /* LSPs per circuit and ...   */
+#define LSP_TX_PACING_MSEC            10   /* ... per pacing interval    */
 
 #define MIN_CSNP_INTERVAL             1
 #define MAX_CSNP_INTERVAL             600
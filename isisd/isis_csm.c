@@ -32,7 +32,7 @@
 #include "prefix.h"
 #include "stream.h"
 
-#include "isisd/dict.h"
+#include "isisd/isis_lspdb.h"
 #include "isisd/include-netbsd/iso.h"
 #include "isisd/isis_constants.h"
 #include "isisd/isis_common.h"
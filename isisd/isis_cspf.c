@@ -0,0 +1,990 @@
+/*
+ * IS-IS Rout(e)ing protocol - isis_cspf.c
+ *                             Constrained Shortest Path First over the
+ *                             TE topology
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+#include <sys/un.h>
+
+#include "linklist.h"
+#include "memory.h"
+#include "prefix.h"
+#include "command.h"
+#include "vty.h"
+#include "log.h"
+#include "if.h"
+#include "thread.h"
+#include "stream.h"
+#include "buffer.h"
+#include "network.h"
+#include "privs.h"
+#include "hash.h"
+#include "vector.h"
+#include "pqueue.h"
+#include "ted.h"
+
+#include "isisd/isis_lspdb.h"
+#include "isisd/isis_constants.h"
+#include "isisd/isis_common.h"
+#include "isisd/isis_flags.h"
+#include "isisd/isis_circuit.h"
+#include "isisd/isisd.h"
+#include "isisd/isis_tlv.h"
+#include "isisd/isis_lsp.h"
+#include "isisd/isis_misc.h"
+#include "isisd/isis_dynhn.h"
+#include "isisd/isis_te.h"
+#include "isisd/isis_ted.h"
+#include "isisd/isis_cspf.h"
+
+/*
+ * Per node working state of the path computation. The array is indexed
+ * by isis_ted_node->index and kept from one computation to the next:
+ * entries are lazily reset by comparing their run number, so that a
+ * request costs nothing proportional to the topology size apart from
+ * the visited part.
+ */
+struct cspf_vertex
+{
+  struct isis_ted_node *node;
+  u_int32_t run;
+
+  u_int32_t cost;
+  u_int32_t delay;
+  u_int32_t loss;
+  u_int16_t hops;
+
+  /* Previous vertex and link used to reach this vertex */
+  struct cspf_vertex *parent;
+  struct isis_ted_link *link;
+
+  /* Position in the candidate heap, -1 if not queued */
+  int pos;
+  u_char done;
+};
+
+/* Client of the local CSPF socket */
+struct cspf_client
+{
+  int fd;
+  struct stream *ibuf;
+  struct stream *obuf;
+  struct buffer *wb;
+  struct thread *t_read;
+  struct thread *t_write;
+};
+
+/* Requests read from a client in one go */
+#define CSPF_API_BATCH		64
+
+static struct
+{
+  struct cspf_vertex *vertices;
+  unsigned int size;
+  u_int32_t run;
+
+  struct pqueue *candidates;
+
+  /* Local socket */
+  int sock;
+  struct thread *t_accept;
+  struct list *clients;
+
+  /* Statistics */
+  u_int32_t requests;
+  u_int32_t success;
+  u_int32_t api_requests;
+  unsigned long time;		/* micro-seconds */
+} cspf;
+
+/* Heap related functions, for the management of the candidates. */
+static int
+cspf_cmp (void *node1, void *node2)
+{
+  struct cspf_vertex *v1 = node1;
+  struct cspf_vertex *v2 = node2;
+
+  if (v1->cost != v2->cost)
+    return (v1->cost < v2->cost) ? -1 : 1;
+  /* Prefer shortest hop count on tie for stable paths */
+  return (int) v1->hops - (int) v2->hops;
+}
+
+static void
+cspf_update_pos (void *node, int position)
+{
+  struct cspf_vertex *v = node;
+
+  v->pos = position;
+}
+
+static struct cspf_vertex *
+cspf_vertex_get (struct isis_ted_node *node)
+{
+  struct cspf_vertex *v;
+
+  v = &cspf.vertices[node->index];
+  if (v->run != cspf.run)
+    {
+      memset (v, 0, sizeof (struct cspf_vertex));
+      v->node = node;
+      v->run = cspf.run;
+      v->cost = UINT32_MAX;
+      v->pos = -1;
+    }
+  return v;
+}
+
+/* Make room for all topology nodes and start a new computation run. */
+static void
+cspf_prepare (void)
+{
+  unsigned int size = vector_active (IsisTED.vertices);
+
+  if (size > cspf.size)
+    {
+      XFREE (MTYPE_ISIS_CSPF, cspf.vertices);
+      cspf.size = size * 2;
+      cspf.vertices = XCALLOC (MTYPE_ISIS_CSPF,
+                               cspf.size * sizeof (struct cspf_vertex));
+      cspf.run = 0;
+    }
+
+  /* Run number 0 marks unused entries */
+  if (++cspf.run == 0)
+    {
+      memset (cspf.vertices, 0, cspf.size * sizeof (struct cspf_vertex));
+      cspf.run = 1;
+    }
+
+  cspf.candidates->size = 0;
+}
+
+/* Check link against bandwidth, admin group, delay and loss constraints. */
+static int
+cspf_link_eligible (struct isis_ted_link *link, struct cspf_constraints *cst)
+{
+  struct te_attr *attr = &link->te.attr;
+  u_int32_t grp;
+  float bw;
+
+  if (cst->bw > 0)
+    {
+      if (CHECK_FLAG (attr->flags, TED_ATTR_UNRSV_BW))
+        bw = attr->unrsv_bw[cst->class_type];
+      else if (CHECK_FLAG (attr->flags, TED_ATTR_MAX_RSV_BW))
+        bw = attr->max_rsv_bw;
+      else
+        return 0;
+      if (bw < cst->bw)
+        return 0;
+    }
+
+  grp = CHECK_FLAG (attr->flags, TED_ATTR_ADM_GRP) ? attr->admin_grp : 0;
+  if (grp & cst->exclude_any)
+    return 0;
+  if (cst->include_any && !(grp & cst->include_any))
+    return 0;
+  if ((grp & cst->include_all) != cst->include_all)
+    return 0;
+
+  /* Links with unknown delay or loss can not be proven to meet the bound */
+  if ((cst->max_delay || cst->metric == CSPF_METRIC_DELAY)
+      && !CHECK_FLAG (attr->flags, TED_ATTR_AV_DELAY | TED_ATTR_MM_DELAY))
+    return 0;
+  if ((cst->max_loss || cst->metric == CSPF_METRIC_LOSS)
+      && !CHECK_FLAG (attr->flags, TED_ATTR_PKT_LOSS))
+    return 0;
+
+  return 1;
+}
+
+static void
+cspf_relax (struct cspf_vertex *v, struct isis_ted_node *node,
+            struct isis_ted_link *link, u_int32_t weight, u_int32_t delay,
+            u_int32_t loss, struct cspf_constraints *cst)
+{
+  struct cspf_vertex *w;
+  u_int32_t cost;
+
+  if (weight > UINT32_MAX - v->cost || delay > UINT32_MAX - v->delay
+      || loss > UINT32_MAX - v->loss)
+    return;
+  cost = v->cost + weight;
+  delay = v->delay + delay;
+  loss = v->loss + loss;
+  if (cst->max_delay && delay > cst->max_delay)
+    return;
+  if (cst->max_loss && loss > cst->max_loss)
+    return;
+
+  w = cspf_vertex_get (node);
+  if (w->done)
+    return;
+  if (cost > w->cost || (cost == w->cost && v->hops + 1 >= w->hops))
+    return;
+
+  w->cost = cost;
+  w->delay = delay;
+  w->loss = loss;
+  w->hops = v->hops + 1;
+  w->parent = v;
+  w->link = link;
+
+  if (w->pos < 0)
+    pqueue_enqueue (w, cspf.candidates);
+  else
+    trickle_up (w->pos, cspf.candidates);
+}
+
+/* Dijkstra over the TE topology, pruned by the constraints. */
+static struct cspf_vertex *
+cspf_run (struct isis_ted_node *src, struct isis_ted_node *dst,
+          struct cspf_constraints *cst)
+{
+  struct cspf_vertex *v;
+  struct listnode *node;
+  struct isis_ted_link *link;
+  u_int32_t weight, delay, loss;
+
+  cspf_prepare ();
+
+  v = cspf_vertex_get (src);
+  v->cost = 0;
+  pqueue_enqueue (v, cspf.candidates);
+
+  while (cspf.candidates->size > 0)
+    {
+      v = pqueue_dequeue (cspf.candidates);
+      v->pos = -1;
+      v->done = 1;
+
+      if (v->node == dst)
+        return v;
+
+      /* Overloaded systems are not used for transit (RFC3787) */
+      if (v->node->overload && v->node != src)
+        continue;
+
+      for (ALL_LIST_ELEMENTS_RO (v->node->links, node, link))
+        {
+          /* Two-way connectivity check, as the SPF does */
+          if (isis_ted_link_reverse (link) == NULL)
+            continue;
+
+          if (LSP_PSEUDO_ID (v->node->id))
+            {
+              /* Pseudonode reaches attached systems at no cost */
+              cspf_relax (v, link->dst, link, 0, 0, 0, cst);
+              continue;
+            }
+
+          if (!cspf_link_eligible (link, cst))
+            continue;
+
+          delay = isis_ted_link_delay (link);
+          loss = link->te.attr.pkt_loss;
+          if (cst->metric == CSPF_METRIC_DELAY)
+            weight = delay;
+          else if (cst->metric == CSPF_METRIC_LOSS)
+            weight = loss;
+          else
+            weight = isis_ted_link_metric (link);
+
+          cspf_relax (v, link->dst, link, weight, delay, loss, cst);
+        }
+    }
+
+  return NULL;
+}
+
+/* Interface address of the remote end of a link, 0.0.0.0 if unknown. */
+static struct in_addr
+cspf_link_remote (struct isis_ted_link *link)
+{
+  struct isis_ted_link *rev;
+  struct in_addr addr;
+
+  addr.s_addr = INADDR_ANY;
+  if (CHECK_FLAG (link->te.attr.flags, TED_ATTR_REMOTE_ADDR))
+    addr = link->te.attr.remote;
+  else if ((rev = isis_ted_link_reverse (link)) != NULL
+           && CHECK_FLAG (rev->te.attr.flags, TED_ATTR_LOCAL_ADDR))
+    addr = rev->te.attr.local;
+  return addr;
+}
+
+/* Walk back from destination to source to fill the path hops. */
+static int
+cspf_build_path (struct cspf_vertex *dst, struct cspf_path *path)
+{
+  struct cspf_vertex *v;
+  struct cspf_hop *hop;
+  int n = 0;
+  int i;
+
+  path->cost = dst->cost;
+  path->delay = dst->delay;
+  path->loss = dst->loss;
+
+  /* Count real links (i.e. not the ones leaving a pseudonode) */
+  for (v = dst; v->parent != NULL; v = v->parent)
+    if (!LSP_PSEUDO_ID (v->parent->node->id))
+      n++;
+
+  if (n > CSPF_MAX_HOPS)
+    return CSPF_TOO_MANY_HOPS;
+
+  path->hop_count = n;
+  i = n;
+  for (v = dst; v->parent != NULL; v = v->parent)
+    {
+      if (LSP_PSEUDO_ID (v->parent->node->id))
+        {
+          /* v is reached through a LAN: its own link gives its address */
+          if (i > 0)
+            path->hops[i - 1].remote = cspf_link_remote (v->link);
+          continue;
+        }
+      hop = &path->hops[--i];
+      memcpy (hop->sysid, v->parent->node->id, ISIS_SYS_ID_LEN);
+      hop->router_id = v->parent->node->router_id;
+      if (CHECK_FLAG (v->link->te.attr.flags, TED_ATTR_LOCAL_ADDR))
+        hop->local = v->link->te.attr.local;
+      if (!LSP_PSEUDO_ID (v->node->id))
+        hop->remote = cspf_link_remote (v->link);
+    }
+
+  return CSPF_OK;
+}
+
+/*
+ * Compute a path from src to dst (System IDs) in the level topology.
+ * A NULL src stands for this system.
+ */
+int
+isis_cspf_compute (u_char *src_id, u_char *dst_id, int level,
+                   struct cspf_constraints *cst, struct cspf_path *path)
+{
+  u_char id[ISIS_SYS_ID_LEN + 1];
+  struct isis_ted_node *src, *dst;
+  struct cspf_vertex *v;
+  struct cspf_constraints relaxed;
+  struct timeval start, stop;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  memset (path, 0, sizeof (struct cspf_path));
+  cspf.requests++;
+
+  if (level < ISIS_LEVEL1 || level > ISIS_LEVEL2
+      || cst->class_type >= MAX_CLASS_TYPE || cst->metric > CSPF_METRIC_LOSS)
+    {
+      path->status = CSPF_BAD_REQUEST;
+      goto out;
+    }
+
+  if (src_id == NULL)
+    src_id = isis->sysid;
+
+  id[ISIS_SYS_ID_LEN] = 0;
+  memcpy (id, src_id, ISIS_SYS_ID_LEN);
+  if ((src = isis_ted_node_lookup (id, level)) == NULL)
+    {
+      path->status = CSPF_NO_SOURCE;
+      goto out;
+    }
+  memcpy (id, dst_id, ISIS_SYS_ID_LEN);
+  if ((dst = isis_ted_node_lookup (id, level)) == NULL)
+    {
+      path->status = CSPF_NO_DESTINATION;
+      goto out;
+    }
+
+  v = cspf_run (src, dst, cst);
+
+  /*
+   * The shortest path computed under a delay or loss bound may miss a
+   * feasible path, which the path minimizing the bounded value finds
+   * whenever one exists: fall back to it before giving up. With both
+   * bounds set this remains a heuristic.
+   */
+  if (v == NULL && cst->max_delay && cst->metric != CSPF_METRIC_DELAY)
+    {
+      relaxed = *cst;
+      relaxed.metric = CSPF_METRIC_DELAY;
+      v = cspf_run (src, dst, &relaxed);
+    }
+  if (v == NULL && cst->max_loss && cst->metric != CSPF_METRIC_LOSS)
+    {
+      relaxed = *cst;
+      relaxed.metric = CSPF_METRIC_LOSS;
+      v = cspf_run (src, dst, &relaxed);
+    }
+
+  if (v == NULL)
+    {
+      path->status = CSPF_NO_PATH;
+      goto out;
+    }
+
+  path->status = cspf_build_path (v, path);
+  if (path->status == CSPF_OK)
+    cspf.success++;
+
+out:
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &stop);
+  cspf.time += timeval_elapsed (stop, start);
+
+  if (IS_DEBUG_ISIS (DEBUG_TE))
+    zlog_debug ("ISIS-CSPF (L%d): Path to %s: %s", level,
+                sysid_print (dst_id), isis_cspf_status2str (path->status));
+
+  return path->status;
+}
+
+const char *
+isis_cspf_status2str (int status)
+{
+  switch (status)
+    {
+    case CSPF_OK:
+      return "Path found";
+    case CSPF_NO_SOURCE:
+      return "Unknown source";
+    case CSPF_NO_DESTINATION:
+      return "Unknown destination";
+    case CSPF_NO_PATH:
+      return "No path satisfies the constraints";
+    case CSPF_TOO_MANY_HOPS:
+      return "Path too long";
+    case CSPF_BAD_REQUEST:
+      return "Invalid request";
+    default:
+      return "Unknown";
+    }
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are local socket functions.
+ *------------------------------------------------------------------------*/
+
+static int cspf_client_read (struct thread *);
+static int cspf_client_write (struct thread *);
+
+static void
+cspf_client_free (struct cspf_client *client)
+{
+  THREAD_OFF (client->t_read);
+  THREAD_OFF (client->t_write);
+  close (client->fd);
+  stream_free (client->ibuf);
+  stream_free (client->obuf);
+  buffer_free (client->wb);
+  listnode_delete (cspf.clients, client);
+  XFREE (MTYPE_ISIS_CSPF, client);
+}
+
+/* Decode one request and queue its reply. */
+static void
+cspf_client_request (struct cspf_client *client)
+{
+  struct stream *s = client->ibuf;
+  struct stream *o = client->obuf;
+  struct cspf_constraints cst;
+  struct cspf_path path;
+  u_char src[ISIS_SYS_ID_LEN], dst[ISIS_SYS_ID_LEN];
+  u_char zero[ISIS_SYS_ID_LEN];
+  u_int32_t seqnum;
+  u_char version, level;
+  int i;
+
+  memset (&cst, 0, sizeof (struct cspf_constraints));
+  seqnum = stream_getl (s);
+  version = stream_getc (s);
+  level = stream_getc (s);
+  cst.metric = stream_getc (s);
+  cst.class_type = stream_getc (s);
+  stream_get (src, s, ISIS_SYS_ID_LEN);
+  stream_get (dst, s, ISIS_SYS_ID_LEN);
+  cst.bw = stream_getf (s);
+  cst.include_any = stream_getl (s);
+  cst.include_all = stream_getl (s);
+  cst.exclude_any = stream_getl (s);
+  cst.max_delay = stream_getl (s);
+  cst.max_loss = stream_getl (s);
+
+  cspf.api_requests++;
+  memset (zero, 0, ISIS_SYS_ID_LEN);
+  if (version != CSPF_API_VERSION)
+    {
+      memset (&path, 0, sizeof (struct cspf_path));
+      path.status = CSPF_BAD_REQUEST;
+    }
+  else
+    isis_cspf_compute (memcmp (src, zero, ISIS_SYS_ID_LEN) ? src : NULL,
+                       dst, level, &cst, &path);
+
+  stream_reset (o);
+  stream_putl (o, seqnum);
+  stream_putc (o, CSPF_API_VERSION);
+  stream_putc (o, path.status);
+  stream_putw (o, path.hop_count);
+  stream_putl (o, path.cost);
+  stream_putl (o, path.delay);
+  stream_putl (o, path.loss);
+  for (i = 0; i < path.hop_count; i++)
+    {
+      stream_put (o, path.hops[i].sysid, ISIS_SYS_ID_LEN);
+      stream_putw (o, 0);
+      stream_put_in_addr (o, &path.hops[i].local);
+      stream_put_in_addr (o, &path.hops[i].remote);
+    }
+  buffer_put (client->wb, STREAM_DATA (o), stream_get_endp (o));
+}
+
+/* Flush pending replies; reading resumes once they are all gone. */
+static int
+cspf_client_flush (struct cspf_client *client)
+{
+  switch (buffer_flush_available (client->wb, client->fd))
+    {
+    case BUFFER_ERROR:
+      zlog_warn ("ISIS-CSPF: write error on client fd %d, closing",
+                 client->fd);
+      cspf_client_free (client);
+      return -1;
+    case BUFFER_PENDING:
+      client->t_write = thread_add_write (master, cspf_client_write, client,
+                                          client->fd);
+      break;
+    case BUFFER_EMPTY:
+      client->t_read = thread_add_read (master, cspf_client_read, client,
+                                        client->fd);
+      break;
+    }
+  return 0;
+}
+
+static int
+cspf_client_write (struct thread *thread)
+{
+  struct cspf_client *client = THREAD_ARG (thread);
+
+  client->t_write = NULL;
+  return cspf_client_flush (client);
+}
+
+/*
+ * Read as many requests as available, up to CSPF_API_BATCH, and answer
+ * them all before going back to the event loop, so that pipelining
+ * clients cost one read and one write per batch.
+ */
+static int
+cspf_client_read (struct thread *thread)
+{
+  struct cspf_client *client = THREAD_ARG (thread);
+  struct stream *s = client->ibuf;
+  ssize_t nbytes;
+  size_t left;
+
+  client->t_read = NULL;
+
+  nbytes = stream_read_try (s, client->fd, STREAM_WRITEABLE (s));
+  if (nbytes == 0 || nbytes == -1)
+    {
+      cspf_client_free (client);
+      return -1;
+    }
+
+  while (STREAM_READABLE (s) >= CSPF_API_REQUEST_SIZE)
+    cspf_client_request (client);
+
+  /* Keep a partial request at the start of the buffer */
+  left = STREAM_READABLE (s);
+  memmove (STREAM_DATA (s), STREAM_PNT (s), left);
+  stream_set_getp (s, 0);
+  stream_set_endp (s, left);
+
+  return cspf_client_flush (client);
+}
+
+static int
+cspf_accept (struct thread *thread)
+{
+  struct cspf_client *client;
+  struct sockaddr_un addr;
+  socklen_t len;
+  int sock;
+
+  cspf.t_accept = thread_add_read (master, cspf_accept, NULL, cspf.sock);
+
+  len = sizeof (struct sockaddr_un);
+  sock = accept (cspf.sock, (struct sockaddr *) &addr, &len);
+  if (sock < 0)
+    {
+      zlog_warn ("ISIS-CSPF: accept failed: %s", safe_strerror (errno));
+      return -1;
+    }
+
+  if (set_nonblocking (sock) < 0)
+    {
+      zlog_warn ("ISIS-CSPF: could not set socket %d to non-blocking, %s",
+                 sock, safe_strerror (errno));
+      close (sock);
+      return -1;
+    }
+
+  client = XCALLOC (MTYPE_ISIS_CSPF, sizeof (struct cspf_client));
+  client->fd = sock;
+  client->ibuf = stream_new (CSPF_API_BATCH * CSPF_API_REQUEST_SIZE);
+  client->obuf = stream_new (CSPF_API_REPLY_SIZE
+                             + CSPF_MAX_HOPS * CSPF_API_HOP_SIZE);
+  client->wb = buffer_new (0);
+  client->t_read = thread_add_read (master, cspf_client_read, client, sock);
+  listnode_add (cspf.clients, client);
+
+  return 0;
+}
+
+/* Open the local CSPF socket, as vty_serv_un() does for vtysh. */
+void
+isis_cspf_serv_un (const char *path)
+{
+  struct sockaddr_un serv;
+  struct zprivs_ids_t ids;
+  mode_t old_mask;
+  int sock, len;
+
+  unlink (path);
+  old_mask = umask (0007);
+
+  sock = socket (AF_UNIX, SOCK_STREAM, 0);
+  if (sock < 0)
+    {
+      zlog_err ("ISIS-CSPF: Cannot create unix stream socket: %s",
+                safe_strerror (errno));
+      umask (old_mask);
+      return;
+    }
+
+  memset (&serv, 0, sizeof (struct sockaddr_un));
+  serv.sun_family = AF_UNIX;
+  strncpy (serv.sun_path, path, sizeof (serv.sun_path) - 1);
+#ifdef HAVE_STRUCT_SOCKADDR_UN_SUN_LEN
+  len = serv.sun_len = SUN_LEN (&serv);
+#else
+  len = sizeof (serv.sun_family) + strlen (serv.sun_path);
+#endif /* HAVE_STRUCT_SOCKADDR_UN_SUN_LEN */
+
+  if (bind (sock, (struct sockaddr *) &serv, len) < 0
+      || listen (sock, 5) < 0)
+    {
+      zlog_err ("ISIS-CSPF: Cannot listen on %s: %s", path,
+                safe_strerror (errno));
+      close (sock);
+      umask (old_mask);
+      return;
+    }
+
+  umask (old_mask);
+
+  zprivs_get_ids (&ids);
+  if (ids.gid_vty > 0 && chown (path, -1, ids.gid_vty))
+    zlog_err ("ISIS-CSPF: could not chown socket, %s", safe_strerror (errno));
+
+  cspf.sock = sock;
+  cspf.t_accept = thread_add_read (master, cspf_accept, NULL, sock);
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are vty command functions.
+ *------------------------------------------------------------------------*/
+
+/* System ID from a TE Router ID, a System ID or a hostname. */
+static int
+cspf_resolve (const char *str, int level, u_char *sysid)
+{
+  struct isis_ted_node *node;
+  struct isis_dynhn *dyn;
+  struct in_addr addr;
+
+  if (sysid2buff (sysid, str))
+    return 0;
+
+  if (inet_aton (str, &addr))
+    {
+      if ((node = isis_ted_router_lookup (addr, level)) == NULL)
+        return -1;
+      memcpy (sysid, node->id, ISIS_SYS_ID_LEN);
+      return 0;
+    }
+
+  if ((dyn = dynhn_find_by_name (str)) != NULL)
+    {
+      memcpy (sysid, dyn->id, ISIS_SYS_ID_LEN);
+      return 0;
+    }
+
+  if (strcmp (str, unix_hostname ()) == 0)
+    {
+      memcpy (sysid, isis->sysid, ISIS_SYS_ID_LEN);
+      return 0;
+    }
+
+  return -1;
+}
+
+static int
+cspf_parse_constraints (struct vty *vty, int argc, const char **argv,
+                        int *level, const char **src,
+                        struct cspf_constraints *cst)
+{
+  int i;
+  unsigned long val;
+  char *endptr;
+  float loss;
+
+  for (i = 0; i < argc; i++)
+    {
+      if (i + 1 >= argc)
+        goto error;
+
+      if (strcmp (argv[i], "metric") == 0)
+        {
+          i++;
+          if (strcmp (argv[i], "te") == 0)
+            cst->metric = CSPF_METRIC_TE;
+          else if (strcmp (argv[i], "delay") == 0)
+            cst->metric = CSPF_METRIC_DELAY;
+          else if (strcmp (argv[i], "loss") == 0)
+            cst->metric = CSPF_METRIC_LOSS;
+          else
+            goto error;
+          continue;
+        }
+
+      if (strcmp (argv[i], "source") == 0)
+        {
+          *src = argv[++i];
+          continue;
+        }
+
+      if (strcmp (argv[i], "bandwidth") == 0)
+        {
+          if (sscanf (argv[++i], "%g", &cst->bw) != 1 || cst->bw < 0)
+            goto error;
+          continue;
+        }
+
+      if (strcmp (argv[i], "max-loss") == 0)
+        {
+          if (sscanf (argv[++i], "%g", &loss) != 1 || loss < 0
+              || loss > MAX_PKT_LOSS)
+            goto error;
+          cst->max_loss = (u_int32_t) (loss / LOSS_PRECISION);
+          continue;
+        }
+
+      val = strtoul (argv[i + 1], &endptr, 0);
+      if (*endptr != '\0')
+        goto error;
+
+      if (strcmp (argv[i], "level") == 0
+          && (val == ISIS_LEVEL1 || val == ISIS_LEVEL2))
+        *level = val;
+      else if (strcmp (argv[i], "class-type") == 0 && val < MAX_CLASS_TYPE)
+        cst->class_type = val;
+      else if (strcmp (argv[i], "include-any") == 0)
+        cst->include_any = val;
+      else if (strcmp (argv[i], "include-all") == 0)
+        cst->include_all = val;
+      else if (strcmp (argv[i], "exclude-any") == 0)
+        cst->exclude_any = val;
+      else if (strcmp (argv[i], "max-delay") == 0 && val <= TE_EXT_MASK)
+        cst->max_delay = val;
+      else
+        goto error;
+      i++;
+    }
+
+  return 0;
+
+error:
+  vty_out (vty, "Invalid constraint '%s'%s", argv[i], VTY_NEWLINE);
+  return -1;
+}
+
+static void
+show_cspf_path (struct vty *vty, struct cspf_path *path)
+{
+  int i;
+
+  vty_out (vty, "  Metric %u, Delay %u (micro-sec), Loss %g (%%), %d hop(s)%s",
+           path->cost, path->delay, path->loss * LOSS_PRECISION,
+           path->hop_count, VTY_NEWLINE);
+
+  for (i = 0; i < path->hop_count; i++)
+    {
+      vty_out (vty, "    %2d: %-20s", i + 1,
+               print_sys_hostname (path->hops[i].sysid));
+      vty_out (vty, " Local %-15s", inet_ntoa (path->hops[i].local));
+      vty_out (vty, " Remote %s%s", inet_ntoa (path->hops[i].remote),
+               VTY_NEWLINE);
+    }
+}
+
+DEFUN (show_isis_mpls_te_cspf,
+       show_isis_mpls_te_cspf_cmd,
+       "show isis mpls-te cspf path WORD",
+       SHOW_STR
+       ISIS_STR
+       MPLS_TE_STR
+       "Constrained Shortest Path First\n"
+       "Compute a Constrained Shortest Path\n"
+       "Destination TE Router ID, System ID or hostname\n")
+{
+  u_char src[ISIS_SYS_ID_LEN], dst[ISIS_SYS_ID_LEN];
+  const char *src_str = NULL;
+  struct cspf_constraints cst;
+  struct cspf_path path;
+  int level = ISIS_LEVEL2;
+
+  if (isis == NULL || !isis->sysid_set)
+    {
+      vty_out (vty, "IS-IS is not running%s", VTY_NEWLINE);
+      return CMD_SUCCESS;
+    }
+
+  memset (&cst, 0, sizeof (struct cspf_constraints));
+  if (cspf_parse_constraints (vty, argc - 1, argv + 1, &level, &src_str,
+                              &cst) < 0)
+    return CMD_WARNING;
+
+  memcpy (src, isis->sysid, ISIS_SYS_ID_LEN);
+  if (src_str && cspf_resolve (src_str, level, src) < 0)
+    {
+      vty_out (vty, "Unknown source %s%s", src_str, VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+  if (cspf_resolve (argv[0], level, dst) < 0)
+    {
+      vty_out (vty, "Unknown destination %s%s", argv[0], VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+
+  vty_out (vty, "--- CSPF (Level-%d) from %s", level,
+           print_sys_hostname (src));
+  vty_out (vty, " to %s ---%s", print_sys_hostname (dst), VTY_NEWLINE);
+
+  if (isis_cspf_compute (src, dst, level, &cst, &path) != CSPF_OK)
+    {
+      vty_out (vty, "  %s%s", isis_cspf_status2str (path.status),
+               VTY_NEWLINE);
+      return CMD_SUCCESS;
+    }
+
+  show_cspf_path (vty, &path);
+  return CMD_SUCCESS;
+}
+
+ALIAS (show_isis_mpls_te_cspf,
+       show_isis_mpls_te_cspf_constraints_cmd,
+       "show isis mpls-te cspf path WORD .LINE",
+       SHOW_STR
+       ISIS_STR
+       MPLS_TE_STR
+       "Constrained Shortest Path First\n"
+       "Compute a Constrained Shortest Path\n"
+       "Destination TE Router ID, System ID or hostname\n"
+       "Constraints: [level (1|2)] [source WORD] [bandwidth BW] "
+       "[class-type <0-7>] [include-any MASK] [include-all MASK] "
+       "[exclude-any MASK] [max-delay <0-16777215>] [max-loss PERCENTAGE] "
+       "[metric (te|delay|loss)]\n")
+
+DEFUN (show_isis_mpls_te_cspf_statistics,
+       show_isis_mpls_te_cspf_statistics_cmd,
+       "show isis mpls-te cspf statistics",
+       SHOW_STR
+       ISIS_STR
+       MPLS_TE_STR
+       "Constrained Shortest Path First\n"
+       "CSPF statistics\n")
+{
+  vty_out (vty, "--- CSPF statistics ---%s", VTY_NEWLINE);
+  vty_out (vty, "  TE topology: %lu nodes, %u links, "
+           "%u LSP updates, %u LSP deletions%s",
+           IsisTED.nodes ? (u_long) IsisTED.nodes->count : 0, IsisTED.links,
+           IsisTED.lsp_update, IsisTED.lsp_delete, VTY_NEWLINE);
+  vty_out (vty, "  Requests: %u (%u from %d socket client(s)), "
+           "Path found: %u%s", cspf.requests, cspf.api_requests,
+           cspf.clients ? listcount (cspf.clients) : 0, cspf.success,
+           VTY_NEWLINE);
+  vty_out (vty, "  Total computation time: %lu usec", cspf.time);
+  if (cspf.requests)
+    vty_out (vty, ", Average: %lu usec", cspf.time / cspf.requests);
+  vty_out (vty, "%s", VTY_NEWLINE);
+
+  return CMD_SUCCESS;
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are initialize/terminate functions.
+ *------------------------------------------------------------------------*/
+
+void
+isis_cspf_init (void)
+{
+  memset (&cspf, 0, sizeof (cspf));
+  cspf.sock = -1;
+  cspf.clients = list_new ();
+  cspf.candidates = pqueue_create ();
+  cspf.candidates->cmp = cspf_cmp;
+  cspf.candidates->update = cspf_update_pos;
+
+  isis_ted_init ();
+
+  install_element (VIEW_NODE, &show_isis_mpls_te_cspf_cmd);
+  install_element (VIEW_NODE, &show_isis_mpls_te_cspf_constraints_cmd);
+  install_element (VIEW_NODE, &show_isis_mpls_te_cspf_statistics_cmd);
+  install_element (ENABLE_NODE, &show_isis_mpls_te_cspf_cmd);
+  install_element (ENABLE_NODE, &show_isis_mpls_te_cspf_constraints_cmd);
+  install_element (ENABLE_NODE, &show_isis_mpls_te_cspf_statistics_cmd);
+}
+
+void
+isis_cspf_term (void)
+{
+  while (cspf.clients && listcount (cspf.clients))
+    cspf_client_free (listgetdata (listhead (cspf.clients)));
+  if (cspf.clients)
+    list_delete (cspf.clients);
+  THREAD_OFF (cspf.t_accept);
+  if (cspf.sock >= 0)
+    close (cspf.sock);
+
+  isis_ted_term ();
+
+  XFREE (MTYPE_ISIS_CSPF, cspf.vertices);
+  if (cspf.candidates)
+    pqueue_delete (cspf.candidates);
+  memset (&cspf, 0, sizeof (cspf));
+  cspf.sock = -1;
+}
@@ -0,0 +1,115 @@
+/*
+ * IS-IS Rout(e)ing protocol - isis_cspf.h
+ *                             Constrained Shortest Path First over the
+ *                             TE topology
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _ZEBRA_ISIS_CSPF_H
+#define _ZEBRA_ISIS_CSPF_H
+
+/* Metric to minimize */
+#define CSPF_METRIC_TE		0
+#define CSPF_METRIC_DELAY	1
+#define CSPF_METRIC_LOSS	2
+
+/* Path computation result */
+#define CSPF_OK			0
+#define CSPF_NO_SOURCE		1
+#define CSPF_NO_DESTINATION	2
+#define CSPF_NO_PATH		3
+#define CSPF_TOO_MANY_HOPS	4
+#define CSPF_BAD_REQUEST	5
+
+#define CSPF_MAX_HOPS		64
+
+struct cspf_constraints
+{
+  /* Requested bandwidth in Bytes/sec, 0 for none */
+  float bw;
+  /* Class Type used to select the Unreserved Bandwidth: 0 - 7 */
+  u_char class_type;
+  /* CSPF_METRIC_XXX */
+  u_char metric;
+
+  /* Admin. Group (Resource Class/Color) affinities, 0 for none */
+  u_int32_t include_any;
+  u_int32_t include_all;
+  u_int32_t exclude_any;
+
+  /* Upper bound of the summed Min. link delay in micro-seconds */
+  u_int32_t max_delay;
+  /* Upper bound of the summed link loss, by 0.000003% steps */
+  u_int32_t max_loss;
+};
+
+struct cspf_hop
+{
+  /* System at the head of the hop and its outgoing interface */
+  u_char sysid[ISIS_SYS_ID_LEN];
+  struct in_addr router_id;
+  struct in_addr local;
+  /* Interface address of the next system, 0.0.0.0 if unknown */
+  struct in_addr remote;
+};
+
+struct cspf_path
+{
+  int status;
+
+  /* Accumulated metric, delay and loss along the path */
+  u_int32_t cost;
+  u_int32_t delay;
+  u_int32_t loss;
+
+  u_int16_t hop_count;
+  struct cspf_hop hops[CSPF_MAX_HOPS];
+};
+
+/*
+ * Local CSPF service, on the ISIS_CSPF_PATH unix stream socket. Clients
+ * may pipeline requests: replies come back in order. All fields are in
+ * network byte order, bandwidth as an IEEE 754 float.
+ *
+ * Request (44 bytes):
+ *   seqnum (4), version (1), level (1), metric (1), class type (1),
+ *   source System ID (6, all zero for this system), destination System
+ *   ID (6), bandwidth (4), include-any (4), include-all (4),
+ *   exclude-any (4), max-delay (4), max-loss (4)
+ *
+ * Reply (20 bytes, then 16 bytes per hop):
+ *   seqnum (4), version (1), status (1), hop count (2), cost (4),
+ *   delay (4), loss (4)
+ *   hop: System ID (6), reserved (2), local address (4),
+ *        remote address (4)
+ */
+#define CSPF_API_VERSION	1
+#define CSPF_API_REQUEST_SIZE	44
+#define CSPF_API_REPLY_SIZE	20
+#define CSPF_API_HOP_SIZE	16
+
+/* Prototypes. */
+extern void isis_cspf_init (void);
+extern void isis_cspf_term (void);
+extern void isis_cspf_serv_un (const char *);
+extern int isis_cspf_compute (u_char *, u_char *, int,
+                              struct cspf_constraints *, struct cspf_path *);
+extern const char *isis_cspf_status2str (int);
+
+#endif /* _ZEBRA_ISIS_CSPF_H */
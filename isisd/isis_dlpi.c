@@ -37,7 +37,7 @@
 #include "stream.h"
 #include "if.h"
 
-#include "isisd/dict.h"
+#include "isisd/isis_lspdb.h"
 #include "isisd/include-netbsd/iso.h"
 #include "isisd/isis_constants.h"
 #include "isisd/isis_common.h"
@@ -32,7 +32,7 @@
 #include "stream.h"
 #include "table.h"
 
-#include "isisd/dict.h"
+#include "isisd/isis_lspdb.h"
 #include "isisd/include-netbsd/iso.h"
 #include "isisd/isis_constants.h"
 #include "isisd/isis_common.h"
@@ -85,6 +85,7 @@ area_resign_level (struct isis_area *area, int level)
       lsp_db_destroy (area->lspdb[level - 1]);
       area->lspdb[level - 1] = NULL;
     }
+  isis_csnp_cache_flush (area, level);
   if (area->spftree[level - 1])
     {
       isis_spftree_del (area->spftree[level - 1]);
@@ -0,0 +1,247 @@
+/*
+ * IS-IS Rout(e)ing protocol - isis_flood.c
+ *                             Flooding scope reduction
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "linklist.h"
+#include "memory.h"
+#include "prefix.h"
+#include "vty.h"
+#include "log.h"
+#include "if.h"
+#include "hash.h"
+#include "vector.h"
+#include "stream.h"
+#include "ted.h"
+
+#include "isisd/isis_constants.h"
+#include "isisd/isis_common.h"
+#include "isisd/isis_flags.h"
+#include "isisd/isis_circuit.h"
+#include "isisd/isisd.h"
+#include "isisd/isis_adjacency.h"
+#include "isisd/isis_pdu.h"
+#include "isisd/isis_misc.h"
+#include "isisd/isis_ted.h"
+#include "isisd/isis_flood.h"
+
+/*
+ * Should an LSP received on rcv, NULL for a local one, be flooded on
+ * circuit ? ISO 10589 floods on all circuits but rcv.
+ */
+int
+isis_flood_circuit (struct isis_circuit *circuit, struct isis_circuit *rcv,
+                    int level)
+{
+  if (circuit == rcv)
+    return 0;
+
+  /* RFC2973: blocked circuits only see LSPs through CSNPs */
+  if (circuit->mesh_blocked)
+    return 0;
+
+  /* The other members of the mesh group got it from the same system */
+  if (rcv && rcv->mesh_group && rcv->mesh_group == circuit->mesh_group)
+    return 0;
+
+  /* Broadcast circuits always flood, the DIS then holds the flooding */
+  if (circuit->area->flood_reduction
+      && circuit->circ_type == CIRCUIT_T_P2P
+      && !circuit->flood_tree[level - 1])
+    return 0;
+
+  return 1;
+}
+
+/*
+ * Point-to-point circuits which may miss LSPs send periodic CSNPs,
+ * like a DIS does on a broadcast circuit.
+ */
+int
+isis_flood_reduced (struct isis_circuit *circuit, int level)
+{
+  if (circuit->circ_type != CIRCUIT_T_P2P
+      || circuit->upadjcount[level - 1] == 0)
+    return 0;
+
+  return (circuit->mesh_blocked || circuit->mesh_group
+          || (circuit->area->flood_reduction
+              && !circuit->flood_tree[level - 1]));
+}
+
+/*
+ * Breadth first search from root, over two-way links only. Among the
+ * systems one hop closer to root, a system picks the lowest System ID
+ * as parent, so that the tree only depends on the LSP database.
+ */
+static void
+isis_flood_tree (struct isis_ted_node *root, int *depth, int *parent,
+                 struct isis_ted_node **queue)
+{
+  struct isis_ted_node *node, *dst, *prev;
+  struct isis_ted_link *link;
+  struct listnode *ln;
+  int head = 0, tail = 0;
+  int i;
+
+  depth[root->index] = 0;
+  queue[tail++] = root;
+
+  while (head < tail)
+    {
+      node = queue[head++];
+      for (ALL_LIST_ELEMENTS_RO (node->links, ln, link))
+        {
+          dst = link->dst;
+          i = dst->index;
+          if (depth[i] >= 0)
+            {
+              if (depth[i] != depth[node->index] + 1)
+                continue;
+              prev = vector_slot (IsisTED.vertices, parent[i]);
+              if (memcmp (node->id, prev->id, ISIS_SYS_ID_LEN + 1) >= 0)
+                continue;
+            }
+
+          if (isis_ted_link_reverse (link) == NULL)
+            continue;
+
+          if (depth[i] < 0)
+            {
+              depth[i] = depth[node->index] + 1;
+              queue[tail++] = dst;
+            }
+          parent[i] = node->index;
+        }
+    }
+}
+
+/*
+ * Recompute the flooding topology of a level from the TE topology.
+ * Called after each full SPF run, since the trees only change with the
+ * adjacencies advertised in the LSPs.
+ */
+void
+isis_flood_update (struct isis_area *area, int level)
+{
+  struct isis_ted_node *node, *self, *nbr;
+  struct isis_ted_node *root[2] = { NULL, NULL };
+  struct isis_ted_node **queue = NULL;
+  struct isis_circuit *circuit;
+  struct isis_adjacency *adj;
+  struct listnode *ln;
+  int *depth = NULL, *parent = NULL;
+  u_char id[ISIS_SYS_ID_LEN + 1];
+  unsigned int i, n, t;
+  int on;
+
+  if (!area->flood_reduction || IsisTED.vertices == NULL)
+    return;
+
+  memcpy (id, isis->sysid, ISIS_SYS_ID_LEN);
+  id[ISIS_SYS_ID_LEN] = 0;
+  self = isis_ted_node_lookup (id, level);
+  n = vector_active (IsisTED.vertices);
+
+  /* Roots are the systems of the level with the extreme System IDs */
+  for (i = 0; i < n; i++)
+    {
+      node = vector_slot (IsisTED.vertices, i);
+      if (node == NULL || node->level != level
+          || node->id[ISIS_SYS_ID_LEN] != 0 || listcount (node->links) == 0)
+        continue;
+      if (!root[0] || memcmp (node->id, root[0]->id, ISIS_SYS_ID_LEN) < 0)
+        root[0] = node;
+      if (!root[1] || memcmp (node->id, root[1]->id, ISIS_SYS_ID_LEN) > 0)
+        root[1] = node;
+    }
+
+  /* Without our own LSP in the TE topology, flood on all circuits */
+  if (self && root[0])
+    {
+      depth = XCALLOC (MTYPE_TMP, n * sizeof (int));
+      parent = XCALLOC (MTYPE_TMP, 2 * n * sizeof (int));
+      queue = XCALLOC (MTYPE_TMP, n * sizeof (struct isis_ted_node *));
+      for (t = 0; t < 2; t++)
+        {
+          for (i = 0; i < n; i++)
+            {
+              depth[i] = -1;
+              parent[t * n + i] = -1;
+            }
+          isis_flood_tree (root[t], depth, parent + t * n, queue);
+        }
+    }
+
+  area->flood_circuits[level - 1] = 0;
+  for (ALL_LIST_ELEMENTS_RO (area->circuit_list, ln, circuit))
+    {
+      if (circuit->circ_type != CIRCUIT_T_P2P
+          || !(circuit->is_type & level))
+        continue;
+
+      /* Neighbours not in the TE topology yet are flooded to */
+      on = 1;
+      adj = circuit->u.p2p.neighbor;
+      if (parent && adj)
+        {
+          memcpy (id, adj->sysid, ISIS_SYS_ID_LEN);
+          nbr = isis_ted_node_lookup (id, level);
+          if (nbr)
+            {
+              on = 0;
+              for (t = 0; t < 2; t++)
+                if (parent[t * n + self->index] == nbr->index
+                    || parent[t * n + nbr->index] == self->index)
+                  on = 1;
+            }
+        }
+
+      /* Catch up with what was not flooded on the new tree link */
+      if (on && !circuit->flood_tree[level - 1]
+          && adj && adj->adj_state == ISIS_ADJ_UP)
+        send_csnp (circuit, level);
+
+      circuit->flood_tree[level - 1] = on;
+      if (on)
+        area->flood_circuits[level - 1]++;
+    }
+
+  if (isis->debugs & DEBUG_UPDATE_PACKETS)
+    {
+      char low[SYSID_STRLEN];
+
+      snprintf (low, sizeof (low), "%s",
+                root[0] ? sysid_print (root[0]->id) : "-");
+      zlog_debug ("ISIS-Upd (%s): L%d flooding topology rooted at %s and %s,"
+                  " %u circuits", area->area_tag, level, low,
+                  root[1] ? sysid_print (root[1]->id) : "-",
+                  area->flood_circuits[level - 1]);
+    }
+
+  if (parent)
+    {
+      XFREE (MTYPE_TMP, depth);
+      XFREE (MTYPE_TMP, parent);
+      XFREE (MTYPE_TMP, queue);
+    }
+}
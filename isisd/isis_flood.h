@@ -0,0 +1,45 @@
+/*
+ * IS-IS Rout(e)ing protocol - isis_flood.h
+ *                             Flooding scope reduction
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _ZEBRA_ISIS_FLOOD_H
+#define _ZEBRA_ISIS_FLOOD_H
+
+/*
+ * Flooding reduction. Each level has a flooding topology, made of the
+ * union of two shortest hop count trees rooted at the lowest and the
+ * highest System IDs of the level. All systems compute the same trees
+ * from the same LSP database, so both ends of a link agree on whether
+ * it is part of the flooding topology. LSPs are only flooded on the
+ * point-to-point circuits on the flooding topology; the other ones are
+ * kept synchronised by periodic CSNPs.
+ */
+
+struct isis_area;
+struct isis_circuit;
+
+/* Prototypes. */
+extern int isis_flood_circuit (struct isis_circuit *, struct isis_circuit *,
+                               int);
+extern int isis_flood_reduced (struct isis_circuit *, int);
+extern void isis_flood_update (struct isis_area *, int);
+
+#endif /* _ZEBRA_ISIS_FLOOD_H */
@@ -0,0 +1,708 @@
+/*
+ * IS-IS Rout(e)ing protocol - isis_gr.c
+ *                             Graceful restart, RFC 5306: restarting
+ *                             router and helper modes
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "linklist.h"
+#include "memory.h"
+#include "prefix.h"
+#include "command.h"
+#include "vty.h"
+#include "log.h"
+#include "if.h"
+#include "stream.h"
+#include "thread.h"
+#include "hash.h"
+#include "zclient.h"
+
+#include "isisd/isis_constants.h"
+#include "isisd/isis_common.h"
+#include "isisd/isis_flags.h"
+#include "isisd/isis_lspdb.h"
+#include "isisd/isis_circuit.h"
+#include "isisd/isis_csm.h"
+#include "isisd/isisd.h"
+#include "isisd/isis_tlv.h"
+#include "isisd/isis_lsp.h"
+#include "isisd/isis_pdu.h"
+#include "isisd/isis_misc.h"
+#include "isisd/isis_adjacency.h"
+#include "isisd/isis_spf.h"
+#include "isisd/isis_route.h"
+#include "isisd/isis_zebra.h"
+#include "isisd/isis_gr.h"
+
+/* End of the grace period of the restart in progress, wall clock, read
+   from the state file written before the restart. */
+static time_t gr_restart_end;
+
+/*------------------------------------------------------------------------*
+ * Followings are helper mode functions.
+ *------------------------------------------------------------------------*/
+
+static struct isis_adjacency *
+isis_gr_helped_adj (struct isis_circuit *circuit, int level)
+{
+  struct isis_adjacency *adj;
+  struct listnode *node;
+
+  if (circuit->circ_type == CIRCUIT_T_P2P)
+    {
+      adj = circuit->u.p2p.neighbor;
+      return (adj && adj->gr_helping) ? adj : NULL;
+    }
+
+  if (circuit->circ_type == CIRCUIT_T_BROADCAST
+      && circuit->u.bc.adjdb[level - 1])
+    for (ALL_LIST_ELEMENTS_RO (circuit->u.bc.adjdb[level - 1], node, adj))
+      if (adj->gr_helping)
+        return adj;
+
+  return NULL;
+}
+
+/* The neighbour sets RR: keep the adjacency up, acknowledge and send it
+   our LSDB summary at once, RFC 5306 3.2.2. */
+static void
+isis_gr_helper_enter (struct isis_adjacency *adj, int level)
+{
+  struct isis_circuit *circuit = adj->circuit;
+  int lvl;
+
+  adj->gr_helping = 1;
+  zlog_notice ("ISIS-GR (%s): helping %s restart on %s",
+               circuit->area->area_tag, sysid_print (adj->sysid),
+               circuit->interface->name);
+
+  send_hello (circuit, level);
+
+  for (lvl = IS_LEVEL_1; lvl <= IS_LEVEL_2; lvl++)
+    {
+      if (!(circuit->is_type & lvl))
+        continue;
+      if (circuit->circ_type == CIRCUIT_T_P2P ? (adj->level & lvl)
+          : (lvl == level && circuit->u.bc.is_dr[lvl - 1]))
+        send_csnp (circuit, lvl);
+    }
+}
+
+static void
+isis_gr_helper_exit (struct isis_adjacency *adj, const char *why)
+{
+  adj->gr_helping = 0;
+  zlog_notice ("ISIS-GR (%s): stop helping %s on %s: %s",
+               adj->circuit->area->area_tag, sysid_print (adj->sysid),
+               adj->circuit->interface->name, why);
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are restarting router functions.
+ *------------------------------------------------------------------------*/
+
+static void
+isis_gr_state_write (u_int32_t period)
+{
+  FILE *fp;
+
+  if ((fp = fopen (PATH_ISISD_GR_STATE, "w")) == NULL)
+    {
+      zlog_warn ("ISIS-GR: can't write %s: %s", PATH_ISISD_GR_STATE,
+                 safe_strerror (errno));
+      return;
+    }
+  fprintf (fp, "%ld\n", (long) (time (NULL) + period));
+  fclose (fp);
+}
+
+static void
+isis_gr_state_read (void)
+{
+  FILE *fp;
+  long end;
+
+  if ((fp = fopen (PATH_ISISD_GR_STATE, "r")) == NULL)
+    return;
+
+  if (fscanf (fp, "%ld", &end) == 1 && end > time (NULL))
+    gr_restart_end = end;
+  fclose (fp);
+
+  /* The state is only valid for the first start after the prepare */
+  unlink (PATH_ISISD_GR_STATE);
+}
+
+/*
+ * The LSDB of a level is synchronised when each circuit with an
+ * adjacency up got the restart acknowledged and a complete set of
+ * CSNPs, and the LSPs these CSNPs announced all came in. Without any
+ * adjacency yet, only T2 ends the wait.
+ */
+static int
+isis_gr_level_synced (struct isis_area *area, int level)
+{
+  struct isis_circuit *circuit;
+  struct isis_lsp *lsp;
+  struct lspdb_cursor cur;
+  struct listnode *node;
+  int up = 0;
+
+  for (ALL_LIST_ELEMENTS_RO (area->circuit_list, node, circuit))
+    {
+      if (!(circuit->is_type & level) || circuit->state != C_STATE_UP
+          || circuit->upadjcount[level - 1] == 0)
+        continue;
+      if (!circuit->gr_ra[level - 1] || !circuit->gr_csnp[level - 1])
+        return 0;
+      up++;
+    }
+
+  if (up == 0)
+    return 0;
+
+  /* Entries of the CSNPs not received yet have sequence number 0 */
+  LSPDB_FOREACH (area->lspdb[level - 1], cur, lsp)
+    if (lsp->lsp_header->seq_num == 0)
+      return 0;
+
+  return 1;
+}
+
+static void
+isis_gr_restart_exit (struct isis_area *area, const char *why)
+{
+  struct isis_circuit *circuit;
+  struct isis_area *other;
+  struct listnode *node;
+  int level;
+
+  zlog_notice ("ISIS-GR (%s): restart done: %s", area->area_tag, why);
+
+  area->gr_restarting = 0;
+  THREAD_TIMER_OFF (area->t_gr_grace);
+  THREAD_TIMER_OFF (area->t_gr_sync[0]);
+  THREAD_TIMER_OFF (area->t_gr_sync[1]);
+  THREAD_TIMER_OFF (area->t_gr_check);
+
+  for (ALL_LIST_ELEMENTS_RO (area->circuit_list, node, circuit))
+    {
+      circuit->gr_ra[0] = circuit->gr_ra[1] = 0;
+      circuit->gr_csnp[0] = circuit->gr_csnp[1] = 0;
+    }
+
+  /* Originate our LSPs, continuing the sequence of the instances the
+     neighbours kept, and those of the LANs we are DIS of. */
+  if (listcount (area->area_addrs) > 0)
+    for (level = IS_LEVEL_1; level <= IS_LEVEL_2; level++)
+      if (area->is_type & level)
+        {
+          lsp_generate (area, level);
+          for (ALL_LIST_ELEMENTS_RO (area->circuit_list, node, circuit))
+            if (circuit->circ_type == CIRCUIT_T_BROADCAST
+                && circuit->u.bc.is_dr[level - 1])
+              lsp_regenerate_schedule_pseudo (circuit, level);
+        }
+
+  /* Compute and install the routes, then remove those not refreshed */
+  isis_spf_run_all (area);
+
+  for (ALL_LIST_ELEMENTS_RO (isis->area_list, node, other))
+    if (other->gr_restarting)
+      return;
+  if (zclient && zclient->sock >= 0)
+    zebra_route_sweep_send (zclient, ZEBRA_ROUTE_ISIS);
+}
+
+static int
+isis_gr_grace_timer (struct thread *thread)
+{
+  struct isis_area *area = THREAD_ARG (thread);
+
+  area->t_gr_grace = NULL;
+  isis_gr_restart_exit (area, "grace period expired");
+
+  return ISIS_OK;
+}
+
+static void
+isis_gr_level_done (struct isis_area *area, int level, const char *why)
+{
+  int lvl;
+
+  area->gr_synced[level - 1] = 1;
+  THREAD_TIMER_OFF (area->t_gr_sync[level - 1]);
+  zlog_notice ("ISIS-GR (%s): L%d %s", area->area_tag, level, why);
+
+  for (lvl = IS_LEVEL_1; lvl <= IS_LEVEL_2; lvl++)
+    if ((area->is_type & lvl) && !area->gr_synced[lvl - 1])
+      return;
+
+  isis_gr_restart_exit (area, "LSDB synchronised");
+}
+
+static int
+isis_gr_sync_l1_timer (struct thread *thread)
+{
+  struct isis_area *area = THREAD_ARG (thread);
+
+  area->t_gr_sync[0] = NULL;
+  isis_gr_level_done (area, IS_LEVEL_1, "T2 expired");
+
+  return ISIS_OK;
+}
+
+static int
+isis_gr_sync_l2_timer (struct thread *thread)
+{
+  struct isis_area *area = THREAD_ARG (thread);
+
+  area->t_gr_sync[1] = NULL;
+  isis_gr_level_done (area, IS_LEVEL_2, "T2 expired");
+
+  return ISIS_OK;
+}
+
+static int
+isis_gr_check (struct thread *thread)
+{
+  struct isis_area *area = THREAD_ARG (thread);
+  int level;
+
+  area->t_gr_check = NULL;
+
+  for (level = IS_LEVEL_1; level <= IS_LEVEL_2; level++)
+    if ((area->is_type & level) && !area->gr_synced[level - 1]
+        && isis_gr_level_synced (area, level))
+      {
+        isis_gr_level_done (area, level, "LSDB synchronised");
+        if (!area->gr_restarting)
+          return ISIS_OK;
+      }
+
+  THREAD_TIMER_ON (master, area->t_gr_check, isis_gr_check, area, 1);
+
+  return ISIS_OK;
+}
+
+/* Called for each new area: restart gracefully if the state file says
+   we are within the grace period. */
+void
+isis_gr_restart_init (struct isis_area *area)
+{
+  time_t now = time (NULL);
+
+  if (gr_restart_end <= now)
+    return;
+
+  area->gr_restarting = 1;
+  THREAD_TIMER_ON (master, area->t_gr_grace, isis_gr_grace_timer, area,
+                   gr_restart_end - now);
+  THREAD_TIMER_ON (master, area->t_gr_sync[0], isis_gr_sync_l1_timer, area,
+                   ISIS_GR_T2);
+  THREAD_TIMER_ON (master, area->t_gr_sync[1], isis_gr_sync_l2_timer, area,
+                   ISIS_GR_T2);
+  THREAD_TIMER_ON (master, area->t_gr_check, isis_gr_check, area, 1);
+
+  zlog_notice ("ISIS-GR (%s): restarting, grace period ends in %lds",
+               area->area_tag, (long) (gr_restart_end - now));
+}
+
+void
+isis_gr_area_del (struct isis_area *area)
+{
+  area->gr_restarting = 0;
+  THREAD_TIMER_OFF (area->t_gr_grace);
+  THREAD_TIMER_OFF (area->t_gr_sync[0]);
+  THREAD_TIMER_OFF (area->t_gr_sync[1]);
+  THREAD_TIMER_OFF (area->t_gr_check);
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are the PDU hooks, for both modes.
+ *------------------------------------------------------------------------*/
+
+/* Restart TLV of an IIH received on an adjacency, level 1 for the
+   point-to-point IIHs which serve both levels */
+void
+isis_gr_hello_received (struct isis_adjacency *adj, int level,
+                        struct tlvs *tlvs, u_int32_t found)
+{
+  struct isis_circuit *circuit = adj->circuit;
+  struct isis_area *area = circuit->area;
+  struct restart_tlv *restart = NULL;
+  unsigned long remain;
+
+  if (found & TLVFLAG_GRACEFUL_RESTART)
+    restart = &tlvs->restart;
+
+  /* Restarting router: the neighbour acknowledges our restart */
+  if (area->gr_restarting && restart && (restart->flags & RESTART_RA)
+      && (!restart->neighbor_known
+          || !memcmp (restart->neighbor_id, isis->sysid, ISIS_SYS_ID_LEN)))
+    {
+      if (circuit->circ_type == CIRCUIT_T_P2P)
+        circuit->gr_ra[0] = circuit->gr_ra[1] = 1;
+      else
+        circuit->gr_ra[level - 1] = 1;
+
+      /* T3 is the shortest of the times the neighbours hold us */
+      remain = thread_timer_remain_second (area->t_gr_grace);
+      if (restart->remaining_time && restart->remaining_time < remain)
+        {
+          THREAD_TIMER_OFF (area->t_gr_grace);
+          THREAD_TIMER_ON (master, area->t_gr_grace, isis_gr_grace_timer,
+                           area, restart->remaining_time);
+        }
+
+      if (isis->debugs & DEBUG_ADJ_PACKETS)
+        zlog_debug ("ISIS-GR (%s): L%d restart acknowledged by %s on %s, "
+                    "remaining time %u", area->area_tag, level,
+                    sysid_print (adj->sysid), circuit->interface->name,
+                    restart->remaining_time);
+    }
+
+  /* Helper */
+  if (restart && (restart->flags & RESTART_RR))
+    {
+      if (!adj->gr_helping && !area->gr_helper_disable)
+        isis_gr_helper_enter (adj, level);
+    }
+  else if (adj->gr_helping)
+    isis_gr_helper_exit (adj, "restart done");
+}
+
+/* Restart TLV of the IIHs we send */
+int
+isis_gr_hello_tlv (struct isis_circuit *circuit, int level,
+                   struct stream *stream)
+{
+  struct isis_area *area = circuit->area;
+  struct isis_adjacency *adj;
+  struct restart_tlv restart;
+
+  memset (&restart, 0, sizeof (struct restart_tlv));
+
+  if (area->gr_restarting && !circuit->gr_ra[level - 1])
+    restart.flags |= RESTART_RR;
+
+  if ((adj = isis_gr_helped_adj (circuit, level)) != NULL)
+    {
+      restart.flags |= RESTART_RA;
+      restart.remaining_time = adj->t_expire
+        ? thread_timer_remain_second (adj->t_expire) : adj->hold_time;
+      restart.neighbor_known = 1;
+      memcpy (restart.neighbor_id, adj->sysid, ISIS_SYS_ID_LEN);
+    }
+
+  if (restart.flags == 0)
+    return ISIS_OK;
+
+  return tlv_add_restart (&restart, stream);
+}
+
+/* A CSNP reaching the end of the LSP ID space completes the set. */
+void
+isis_gr_csnp_received (struct isis_circuit *circuit, int level,
+                       u_char *stop_lsp_id)
+{
+  static const u_char last[ISIS_SYS_ID_LEN + 2] =
+    { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+
+  if (!circuit->area->gr_restarting)
+    return;
+
+  if (memcmp (stop_lsp_id, last, ISIS_SYS_ID_LEN + 2) == 0)
+    circuit->gr_csnp[level - 1] = 1;
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are vty command functions.
+ *------------------------------------------------------------------------*/
+
+int
+isis_gr_config_write (struct vty *vty, struct isis_area *area)
+{
+  int write = 0;
+
+  if (area->gr_grace_period == ISIS_GR_GRACE_PERIOD_DEFAULT)
+    {
+      vty_out (vty, " graceful-restart%s", VTY_NEWLINE);
+      write++;
+    }
+  else if (area->gr_grace_period)
+    {
+      vty_out (vty, " graceful-restart grace-period %u%s",
+               area->gr_grace_period, VTY_NEWLINE);
+      write++;
+    }
+
+  if (area->gr_helper_disable)
+    {
+      vty_out (vty, " graceful-restart helper-disable%s", VTY_NEWLINE);
+      write++;
+    }
+
+  return write;
+}
+
+DEFUN (isis_graceful_restart,
+       isis_graceful_restart_cmd,
+       "graceful-restart",
+       "Graceful restart (RFC 5306)\n")
+{
+  struct isis_area *area;
+
+  area = vty->index;
+  assert (area);
+
+  area->gr_grace_period = ISIS_GR_GRACE_PERIOD_DEFAULT;
+  if (argc == 1)
+    VTY_GET_INTEGER_RANGE ("grace period", area->gr_grace_period, argv[0],
+                           1, ISIS_GR_GRACE_PERIOD_MAX);
+
+  return CMD_SUCCESS;
+}
+
+ALIAS (isis_graceful_restart,
+       isis_graceful_restart_period_cmd,
+       "graceful-restart grace-period <1-1800>",
+       "Graceful restart (RFC 5306)\n"
+       "Time zebra keeps the routes while we restart\n"
+       "Seconds\n")
+
+DEFUN (no_isis_graceful_restart,
+       no_isis_graceful_restart_cmd,
+       "no graceful-restart",
+       NO_STR
+       "Graceful restart (RFC 5306)\n")
+{
+  struct isis_area *area;
+
+  area = vty->index;
+  assert (area);
+
+  area->gr_grace_period = 0;
+  area->gr_prepared = 0;
+
+  return CMD_SUCCESS;
+}
+
+ALIAS (no_isis_graceful_restart,
+       no_isis_graceful_restart_period_cmd,
+       "no graceful-restart grace-period <1-1800>",
+       NO_STR
+       "Graceful restart (RFC 5306)\n"
+       "Time zebra keeps the routes while we restart\n"
+       "Seconds\n")
+
+DEFUN (isis_graceful_restart_helper_disable,
+       isis_graceful_restart_helper_disable_cmd,
+       "graceful-restart helper-disable",
+       "Graceful restart (RFC 5306)\n"
+       "Don't help the neighbours restart\n")
+{
+  struct isis_area *area;
+  struct isis_circuit *circuit;
+  struct isis_adjacency *adj;
+  struct listnode *node, *anode;
+  int level;
+
+  area = vty->index;
+  assert (area);
+
+  area->gr_helper_disable = 1;
+
+  for (ALL_LIST_ELEMENTS_RO (area->circuit_list, node, circuit))
+    {
+      if (circuit->circ_type == CIRCUIT_T_P2P)
+        {
+          if ((adj = circuit->u.p2p.neighbor) && adj->gr_helping)
+            isis_gr_helper_exit (adj, "helper mode disabled");
+          continue;
+        }
+      if (circuit->circ_type != CIRCUIT_T_BROADCAST)
+        continue;
+      for (level = 0; level < ISIS_LEVELS; level++)
+        if (circuit->u.bc.adjdb[level])
+          for (ALL_LIST_ELEMENTS_RO (circuit->u.bc.adjdb[level], anode, adj))
+            if (adj->gr_helping)
+              isis_gr_helper_exit (adj, "helper mode disabled");
+    }
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (no_isis_graceful_restart_helper_disable,
+       no_isis_graceful_restart_helper_disable_cmd,
+       "no graceful-restart helper-disable",
+       NO_STR
+       "Graceful restart (RFC 5306)\n"
+       "Don't help the neighbours restart\n")
+{
+  struct isis_area *area;
+
+  area = vty->index;
+  assert (area);
+
+  area->gr_helper_disable = 0;
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (graceful_restart_prepare_isis,
+       graceful_restart_prepare_isis_cmd,
+       "graceful-restart prepare isis",
+       "Graceful restart\n"
+       "Prepare a planned restart\n"
+       "IS-IS information\n")
+{
+  struct isis_area *area;
+  struct listnode *node;
+  u_int16_t period = 0;
+
+  for (ALL_LIST_ELEMENTS_RO (isis->area_list, node, area))
+    {
+      if (area->gr_restarting)
+        {
+          vty_out (vty, "%% Restart in progress%s", VTY_NEWLINE);
+          return CMD_WARNING;
+        }
+      if (area->gr_grace_period > period)
+        period = area->gr_grace_period;
+    }
+
+  if (period == 0)
+    {
+      vty_out (vty, "%% Graceful restart is not enabled%s", VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+
+  isis_gr_state_write (period);
+  zebra_route_preserve_send (zclient, ZEBRA_ROUTE_ISIS,
+                             period + ISIS_GR_STALE_SLACK);
+  for (ALL_LIST_ELEMENTS_RO (isis->area_list, node, area))
+    area->gr_prepared = 1;
+
+  vty_out (vty, "Routes preserved, restart isisd within %u seconds%s",
+           period, VTY_NEWLINE);
+
+  return CMD_SUCCESS;
+}
+
+static void
+isis_gr_show_helping (struct vty *vty, struct isis_adjacency *adj)
+{
+  vty_out (vty, "    %-20s %-16s %lu seconds left%s",
+           sysid_print (adj->sysid), adj->circuit->interface->name,
+           adj->t_expire ? thread_timer_remain_second (adj->t_expire) : 0,
+           VTY_NEWLINE);
+}
+
+DEFUN (show_isis_graceful_restart,
+       show_isis_graceful_restart_cmd,
+       "show isis graceful-restart",
+       SHOW_STR
+       "IS-IS information\n"
+       "Graceful restart (RFC 5306)\n")
+{
+  struct isis_area *area;
+  struct isis_circuit *circuit;
+  struct isis_adjacency *adj;
+  struct listnode *node, *cnode, *anode;
+  int level;
+
+  if (!isis->area_list || isis->area_list->count == 0)
+    return CMD_SUCCESS;
+
+  for (ALL_LIST_ELEMENTS_RO (isis->area_list, node, area))
+    {
+      vty_out (vty, "Area %s:%s", area->area_tag ? area->area_tag : "null",
+               VTY_NEWLINE);
+
+      if (area->gr_grace_period)
+        vty_out (vty, "  Graceful restart enabled, grace period %u seconds%s",
+                 area->gr_grace_period, VTY_NEWLINE);
+      else
+        vty_out (vty, "  Graceful restart disabled%s", VTY_NEWLINE);
+      vty_out (vty, "  Helper mode %s%s",
+               area->gr_helper_disable ? "disabled" : "enabled", VTY_NEWLINE);
+
+      if (area->gr_restarting)
+        {
+          vty_out (vty, "  Restarting, grace period ends in %lu seconds%s",
+                   thread_timer_remain_second (area->t_gr_grace),
+                   VTY_NEWLINE);
+          for (level = IS_LEVEL_1; level <= IS_LEVEL_2; level++)
+            if (area->is_type & level)
+              {
+                if (area->gr_synced[level - 1])
+                  vty_out (vty, "    Level-%d: synchronised%s", level,
+                           VTY_NEWLINE);
+                else
+                  vty_out (vty, "    Level-%d: synchronising, T2 expires "
+                           "in %lu seconds%s", level,
+                           thread_timer_remain_second (area->t_gr_sync[level - 1]),
+                           VTY_NEWLINE);
+              }
+        }
+      else if (area->gr_prepared)
+        vty_out (vty, "  Prepared to restart%s", VTY_NEWLINE);
+
+      vty_out (vty, "  Helping:%s", VTY_NEWLINE);
+      for (ALL_LIST_ELEMENTS_RO (area->circuit_list, cnode, circuit))
+        {
+          if (circuit->circ_type == CIRCUIT_T_P2P)
+            {
+              if ((adj = circuit->u.p2p.neighbor) && adj->gr_helping)
+                isis_gr_show_helping (vty, adj);
+              continue;
+            }
+          if (circuit->circ_type != CIRCUIT_T_BROADCAST)
+            continue;
+          for (level = 0; level < ISIS_LEVELS; level++)
+            if (circuit->u.bc.adjdb[level])
+              for (ALL_LIST_ELEMENTS_RO (circuit->u.bc.adjdb[level], anode,
+                                         adj))
+                if (adj->gr_helping)
+                  isis_gr_show_helping (vty, adj);
+        }
+      vty_out (vty, "%s", VTY_NEWLINE);
+    }
+
+  return CMD_SUCCESS;
+}
+
+void
+isis_gr_init (void)
+{
+  isis_gr_state_read ();
+
+  install_element (ISIS_NODE, &isis_graceful_restart_cmd);
+  install_element (ISIS_NODE, &isis_graceful_restart_period_cmd);
+  install_element (ISIS_NODE, &no_isis_graceful_restart_cmd);
+  install_element (ISIS_NODE, &no_isis_graceful_restart_period_cmd);
+  install_element (ISIS_NODE, &isis_graceful_restart_helper_disable_cmd);
+  install_element (ISIS_NODE, &no_isis_graceful_restart_helper_disable_cmd);
+  install_element (ENABLE_NODE, &graceful_restart_prepare_isis_cmd);
+  install_element (VIEW_NODE, &show_isis_graceful_restart_cmd);
+  install_element (ENABLE_NODE, &show_isis_graceful_restart_cmd);
+}
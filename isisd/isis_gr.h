@@ -0,0 +1,64 @@
+/*
+ * IS-IS Rout(e)ing protocol - isis_gr.h
+ *                             Graceful restart, RFC 5306
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _ZEBRA_ISIS_GR_H
+#define _ZEBRA_ISIS_GR_H
+
+/*
+ * Before a planned restart, isisd asks zebra to keep its routes in the
+ * FIB. After the restart, it sets RR (restart request) in the restart
+ * TLV of its IIHs. Its neighbours, in helper mode, keep their adjacency
+ * up, answer with RA (restart acknowledgement) and send a complete set
+ * of CSNPs. Once the LSDB of each level is resynchronised, or T2 or the
+ * grace period (T3) expires, the restarting router originates its LSPs,
+ * runs the SPF and has zebra remove the routes it did not refresh.
+ *
+ * +-------+-------+-------+-------+-------+-------+-------+-------+
+ * |         Reserved                      |  SA   |  RA   |  RR   | 1
+ * +-------+-------+-------+-------+-------+-------+-------+-------+
+ * |                          Remaining Time                       | 2
+ * +---------------------------------------------------------------+
+ * |                Restarting Neighbor ID (If known)              | 0-8
+ * +---------------------------------------------------------------+
+ */
+
+/* Grace period (T3), seconds */
+#define ISIS_GR_GRACE_PERIOD_DEFAULT	120
+#define ISIS_GR_GRACE_PERIOD_MAX	1800
+
+/* Time a level waits for its LSDB synchronisation (T2), seconds */
+#define ISIS_GR_T2			60
+
+/* Extra time zebra keeps the routes, for the last SPF to complete */
+#define ISIS_GR_STALE_SLACK		30
+
+/* Prototypes. */
+extern void isis_gr_init (void);
+extern void isis_gr_restart_init (struct isis_area *);
+extern void isis_gr_area_del (struct isis_area *);
+extern int isis_gr_config_write (struct vty *, struct isis_area *);
+extern void isis_gr_hello_received (struct isis_adjacency *, int,
+                                    struct tlvs *, u_int32_t);
+extern int isis_gr_hello_tlv (struct isis_circuit *, int, struct stream *);
+extern void isis_gr_csnp_received (struct isis_circuit *, int, u_char *);
+
+#endif /* _ZEBRA_ISIS_GR_H */
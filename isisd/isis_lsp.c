@@ -37,8 +37,10 @@
 #include "checksum.h"
 #include "md5.h"
 #include "table.h"
+#include "pqueue.h"
+#include "ted.h"
 
-#include "isisd/dict.h"
+#include "isisd/isis_lspdb.h"
 #include "isisd/isis_constants.h"
 #include "isisd/isis_common.h"
 #include "isisd/isis_flags.h"
@@ -53,6 +55,7 @@
 #include "isisd/isis_adjacency.h"
 #include "isisd/isis_spf.h"
 #include "isisd/isis_te.h"
+#include "isisd/isis_flood.h"
 
 #ifdef TOPOLOGY_GENERATE
 #include "spgrid.h"
@@ -72,38 +75,36 @@ lsp_id_cmp (u_char * id1, u_char * id2)
   return memcmp (id1, id2, ISIS_SYS_ID_LEN + 2);
 }
 
-dict_t *
-lsp_db_init (void)
+void *
+lsp_tlv_first (struct isis_lsp *lsp, u_char type, struct tlv_iter *iter)
 {
-  dict_t *dict;
-
-  dict = dict_create (DICTCOUNT_T_MAX, (dict_comp_t) lsp_id_cmp);
+  return tlv_iter_first (iter, type, STREAM_DATA (lsp->pdu) +
+                         ISIS_FIXED_HDR_LEN + ISIS_LSP_HDR_LEN,
+                         ntohs (lsp->lsp_header->pdu_len) -
+                         ISIS_FIXED_HDR_LEN - ISIS_LSP_HDR_LEN);
+}
 
-  return dict;
+struct lspdb *
+lsp_db_init (void)
+{
+  return lspdb_new ();
 }
 
 struct isis_lsp *
-lsp_search (u_char * id, dict_t * lspdb)
+lsp_search (u_char * id, struct lspdb *lspdb)
 {
-  dnode_t *node;
-
 #ifdef EXTREME_DEBUG
-  dnode_t *dn;
+  struct lspdb_cursor cur;
+  struct isis_lsp *lsp;
 
   zlog_debug ("searching db");
-  for (dn = dict_first (lspdb); dn; dn = dict_next (lspdb, dn))
+  LSPDB_FOREACH (lspdb, cur, lsp)
     {
-      zlog_debug ("%s\t%pX", rawlspid_print ((u_char *) dnode_getkey (dn)),
-		  dnode_get (dn));
+      zlog_debug ("%s\t%pX", rawlspid_print (lsp->lsp_header->lsp_id), lsp);
     }
 #endif /* EXTREME DEBUG */
 
-  node = dict_lookup (lspdb, id);
-
-  if (node)
-    return (struct isis_lsp *) dnode_get (node);
-
-  return NULL;
+  return lspdb_lookup (lspdb, id);
 }
 
 static void
@@ -112,6 +113,8 @@ lsp_clear_data (struct isis_lsp *lsp)
   if (!lsp)
     return;
 
+  isis_te_lsp_export (lsp, TED_EVENT_DELETE);
+
   if (lsp->tlv_data.hostname)
     isis_dynhn_remove (lsp->lsp_header->lsp_id);
 
@@ -131,23 +134,36 @@ lsp_clear_data (struct isis_lsp *lsp)
 static void
 lsp_destroy (struct isis_lsp *lsp)
 {
-  struct listnode *cnode, *lnode, *lnnode;
-  struct isis_lsp *lsp_in_list;
+  struct listnode *cnode;
   struct isis_circuit *circuit;
 
   if (!lsp)
     return;
 
-  for (ALL_LIST_ELEMENTS_RO (lsp->area->circuit_list, cnode, circuit))
-    {
-      if (circuit->lsp_queue == NULL)
-        continue;
-      for (ALL_LIST_ELEMENTS (circuit->lsp_queue, lnode, lnnode, lsp_in_list))
-        if (lsp_in_list == lsp)
-          list_delete_node(circuit->lsp_queue, lnode);
-    }
+  if (flags_any_set (lsp->SRMqueued))
+    for (ALL_LIST_ELEMENTS_RO (lsp->area->circuit_list, cnode, circuit))
+      if (ISIS_CHECK_FLAG (lsp->SRMqueued, circuit))
+        {
+          if (circuit->lsp_queue)
+            listnode_delete (circuit->lsp_queue, lsp);
+          if (circuit->lsp_rxmt_queue)
+            listnode_delete (circuit->lsp_rxmt_queue, lsp);
+        }
+  if (flags_any_set (lsp->SSNqueued))
+    for (ALL_LIST_ELEMENTS_RO (lsp->area->circuit_list, cnode, circuit))
+      if (ISIS_CHECK_FLAG (lsp->SSNqueued, circuit)
+          && circuit->ssn_queue[lsp->level - 1])
+        listnode_delete (circuit->ssn_queue[lsp->level - 1], lsp);
   ISIS_FLAGS_CLEAR_ALL (lsp->SSNflags);
   ISIS_FLAGS_CLEAR_ALL (lsp->SRMflags);
+  ISIS_FLAGS_CLEAR_ALL (lsp->SRMqueued);
+  ISIS_FLAGS_CLEAR_ALL (lsp->SSNqueued);
+
+  if (lsp->aging_pos)
+    {
+      pqueue_remove_at (lsp->aging_pos - 1, lsp->area->lsp_aging);
+      lsp->aging_pos = 0;
+    }
 
   lsp_clear_data (lsp);
 
@@ -167,23 +183,122 @@ lsp_destroy (struct isis_lsp *lsp)
   XFREE (MTYPE_ISIS_LSP, lsp);
 }
 
+/*
+ * LSP aging. Rather than counting the remaining lifetime of every LSP
+ * down each second, the LSPs are kept in a heap ordered by the time
+ * their remaining lifetime, or their ZeroAgeLifetime once purged, runs
+ * out. The rem_lifetime of the PDU is only brought up to date when it
+ * is sent or shown, see lsp_set_time().
+ */
+static time_t
+lsp_clock (void)
+{
+  return recent_relative_time ().tv_sec;
+}
+
+static int
+lsp_aging_cmp (void *a, void *b)
+{
+  struct isis_lsp *lsp1 = a, *lsp2 = b;
+
+  if (lsp1->expires < lsp2->expires)
+    return -1;
+  return lsp1->expires > lsp2->expires;
+}
+
+static void
+lsp_aging_update (void *node, int pos)
+{
+  ((struct isis_lsp *) node)->aging_pos = pos + 1;
+}
+
+struct pqueue *
+lsp_aging_init (void)
+{
+  struct pqueue *queue;
+
+  queue = pqueue_create ();
+  queue->cmp = lsp_aging_cmp;
+  queue->update = lsp_aging_update;
+
+  return queue;
+}
+
+/* The SNP entry of the LSP changed, for the CSNPs built beforehand */
+static void
+lsp_touch (struct isis_lsp *lsp)
+{
+  struct lspdb *lspdb;
+
+  if (lsp->area && (lspdb = lsp->area->lspdb[lsp->level - 1]) != NULL)
+    lspdb_touch (lspdb, lsp->lsp_header->lsp_id);
+}
+
+/* Time the aging of an LSP from its rem_lifetime, or age_out if zero */
+static void
+lsp_aging_schedule (struct isis_lsp *lsp)
+{
+  struct isis_area *area = lsp->area;
+  time_t now = lsp_clock ();
+  u_int16_t rem_lifetime = ntohs (lsp->lsp_header->rem_lifetime);
+
+  /* Each new instance of an LSP is aged from here */
+  lsp_touch (lsp);
+
+  lsp->expires = now + (rem_lifetime ? rem_lifetime : lsp->age_out);
+
+  if (lsp->aging_pos)
+    {
+      trickle_up (lsp->aging_pos - 1, area->lsp_aging);
+      trickle_down (lsp->aging_pos - 1, area->lsp_aging);
+    }
+  else
+    pqueue_enqueue (lsp, area->lsp_aging);
+
+  /* The aging timer follows the earliest expiry */
+  if (lsp->aging_pos == 1 || area->t_tick == NULL)
+    {
+      THREAD_TIMER_OFF (area->t_tick);
+      THREAD_TIMER_ON (master, area->t_tick, lsp_tick, area,
+                       lsp->expires > now ? lsp->expires - now : 0);
+    }
+}
+
+/* Bring rem_lifetime, or age_out, up to date */
 void
-lsp_db_destroy (dict_t * lspdb)
+lsp_set_time (struct isis_lsp *lsp)
 {
-  dnode_t *dnode, *next;
-  struct isis_lsp *lsp;
+  time_t now;
+  u_int16_t left;
 
-  dnode = dict_first (lspdb);
-  while (dnode)
+  assert (lsp);
+
+  if (lsp->aging_pos == 0)
+    return;
+
+  now = lsp_clock ();
+  left = lsp->expires > now ? lsp->expires - now : 0;
+
+  if (lsp->lsp_header->rem_lifetime == 0)
     {
-      next = dict_next (lspdb, dnode);
-      lsp = dnode_get (dnode);
-      lsp_destroy (lsp);
-      dict_delete_free (lspdb, dnode);
-      dnode = next;
+      lsp->age_out = left;
+      return;
     }
 
-  dict_free (lspdb);
+  /* Reaches zero in lsp_tick() only */
+  lsp->lsp_header->rem_lifetime = htons (left ? left : 1);
+}
+
+void
+lsp_db_destroy (struct lspdb *lspdb)
+{
+  struct lspdb_cursor cur;
+  struct isis_lsp *lsp;
+
+  LSPDB_FOREACH (lspdb, cur, lsp)
+    lsp_destroy (lsp);
+
+  lspdb_free (lspdb);
 
   return;
 }
@@ -192,17 +307,16 @@ lsp_db_destroy (dict_t * lspdb)
  * Remove all the frags belonging to the given lsp
  */
 static void
-lsp_remove_frags (struct list *frags, dict_t * lspdb)
+lsp_remove_frags (struct list *frags, struct lspdb *lspdb)
 {
-  dnode_t *dnode;
   struct listnode *lnode, *lnnode;
   struct isis_lsp *lsp;
 
   for (ALL_LIST_ELEMENTS (frags, lnode, lnnode, lsp))
     {
-      dnode = dict_lookup (lspdb, lsp->lsp_header->lsp_id);
+      if (lspdb_lookup (lspdb, lsp->lsp_header->lsp_id) == lsp)
+        lspdb_delete (lspdb, lsp->lsp_header->lsp_id);
       lsp_destroy (lsp);
-      dnode_destroy (dict_delete (lspdb, dnode));
     }
 
   list_delete_all_node (frags);
@@ -211,16 +325,13 @@ lsp_remove_frags (struct list *frags, dict_t * lspdb)
 }
 
 void
-lsp_search_and_destroy (u_char * id, dict_t * lspdb)
+lsp_search_and_destroy (u_char * id, struct lspdb *lspdb)
 {
-  dnode_t *node;
   struct isis_lsp *lsp;
 
-  node = dict_lookup (lspdb, id);
-  if (node)
+  lsp = lspdb_delete (lspdb, id);
+  if (lsp)
     {
-      node = dict_delete (lspdb, node);
-      lsp = dnode_get (node);
       /*
        * If this is a zero lsp, remove all the frags now 
        */
@@ -238,7 +349,6 @@ lsp_search_and_destroy (u_char * id, dict_t * lspdb)
 	    listnode_delete (lsp->lspu.zero_lsp->lspu.frags, lsp);
 	}
       lsp_destroy (lsp);
-      dnode_destroy (node);
     }
 }
 
@@ -392,9 +502,8 @@ lsp_auth_update (struct isis_lsp *lsp)
   memset (STREAM_DATA (lsp->pdu) + lsp->auth_tlv_offset + 3,
           0, ISIS_AUTH_MD5_SIZE);
   /* Compute autentication value */
-  hmac_md5 (STREAM_DATA (lsp->pdu), stream_get_endp(lsp->pdu),
-            (unsigned char *) &passwd->passwd, passwd->len,
-            (unsigned char *) &hmac_md5_hash);
+  hmac_md5_digest (&passwd->hmac, STREAM_DATA (lsp->pdu),
+                   stream_get_endp(lsp->pdu), (unsigned char *) &hmac_md5_hash);
   /* Copy the hash into the stream */
   memcpy (STREAM_DATA (lsp->pdu) + lsp->auth_tlv_offset + 3,
           hmac_md5_hash, ISIS_AUTH_MD5_SIZE);
@@ -416,6 +525,7 @@ lsp_inc_seqnum (struct isis_lsp *lsp, u_int32_t seq_num)
     newseq = seq_num + 1;
 
   lsp->lsp_header->seq_num = htonl (newseq);
+  lsp_touch (lsp);
 
   /* Recompute authentication and checksum information */
   lsp_auth_update (lsp);
@@ -428,6 +538,8 @@ lsp_inc_seqnum (struct isis_lsp *lsp, u_int32_t seq_num)
   fletcher_checksum(STREAM_DATA (lsp->pdu) + 12,
                     ntohs (lsp->lsp_header->pdu_len) - 12, 12);
 
+  isis_te_lsp_export (lsp, TED_EVENT_UPDATE);
+
   isis_spf_schedule (lsp->area, lsp->level);
 #ifdef HAVE_IPV6
   isis_spf_schedule6 (lsp->area, lsp->level);
@@ -499,23 +611,17 @@ lsp_update_data (struct isis_lsp *lsp, struct stream *stream,
    */
   expected |= TLVFLAG_AUTH_INFO;
   expected |= TLVFLAG_AREA_ADDRS;
-  expected |= TLVFLAG_IS_NEIGHS;
   expected |= TLVFLAG_NLPID;
   if (area->dynhostname)
     expected |= TLVFLAG_DYN_HOSTNAME;
   if (area->newmetric)
-    {
-      expected |= TLVFLAG_TE_IS_NEIGHS;
-      expected |= TLVFLAG_TE_IPV4_REACHABILITY;
-      expected |= TLVFLAG_TE_ROUTER_ID;
-    }
+    expected |= TLVFLAG_TE_ROUTER_ID;
   expected |= TLVFLAG_IPV4_ADDR;
-  expected |= TLVFLAG_IPV4_INT_REACHABILITY;
-  expected |= TLVFLAG_IPV4_EXT_REACHABILITY;
 #ifdef HAVE_IPV6
   expected |= TLVFLAG_IPV6_ADDR;
-  expected |= TLVFLAG_IPV6_REACHABILITY;
 #endif /* HAVE_IPV6 */
+  /* Neighbours and reachability are read from the PDU when needed, see
+   * LSP_TLV_FOREACH */
 
   retval = parse_tlvs (area->area_tag, STREAM_DATA (lsp->pdu) +
                        ISIS_FIXED_HDR_LEN + ISIS_LSP_HDR_LEN,
@@ -536,27 +642,156 @@ lsp_update_data (struct isis_lsp *lsp, struct stream *stream,
                           IS_LEVEL_1_AND_2 ? IS_LEVEL_2 : IS_LEVEL_1);
     }
 
+  isis_te_lsp_export (lsp, TED_EVENT_UPDATE);
+
   return;
 }
 
+/*
+ * Whether a received instance carries the same TLVs as the stored one,
+ * the authentication value aside, as a periodic refresh does.
+ */
+static int
+lsp_same_content (struct isis_lsp *lsp, struct stream *stream)
+{
+  struct isis_link_state_hdr *hdr;
+  u_char *old, *new, *end;
+  u_int16_t pdu_len;
+
+  hdr = (struct isis_link_state_hdr *) (STREAM_DATA (stream) +
+                                        ISIS_FIXED_HDR_LEN);
+  pdu_len = ntohs (hdr->pdu_len);
+
+  if (lsp->own_lsp || lsp->lsp_header->seq_num == 0
+      || lsp->lsp_header->rem_lifetime == 0 || hdr->rem_lifetime == 0
+      || hdr->lsp_bits != lsp->lsp_header->lsp_bits
+      || pdu_len != ntohs (lsp->lsp_header->pdu_len)
+      || stream_get_endp (stream) > STREAM_SIZE (lsp->pdu)
+      || stream_get_endp (stream) < pdu_len)
+    return 0;
+
+  old = STREAM_DATA (lsp->pdu) + ISIS_FIXED_HDR_LEN + ISIS_LSP_HDR_LEN;
+  new = STREAM_DATA (stream) + ISIS_FIXED_HDR_LEN + ISIS_LSP_HDR_LEN;
+  end = STREAM_DATA (stream) + pdu_len;
+  while (new + 2 <= end)
+    {
+      if (new[0] != old[0] || new[1] != old[1] || new + 2 + new[1] > end)
+        return 0;
+      if (new[0] != AUTH_INFO && memcmp (new + 2, old + 2, new[1]))
+        return 0;
+      old += 2 + old[1];
+      new += 2 + new[1];
+    }
+  return new == end;
+}
+
+/*
+ * Whether the entries of the TLVs of a type match between the stored and
+ * a received instance, on their first len bytes or entirely if len is 0.
+ */
+static int
+lsp_same_entries (struct isis_lsp *lsp, struct stream *stream, u_char type,
+                  int len)
+{
+  struct tlv_iter old_iter, new_iter;
+  u_char *old, *new, *old_next, *new_next;
+  int pdu_len;
+
+  pdu_len = ntohs (((struct isis_link_state_hdr *)
+                    (STREAM_DATA (stream) + ISIS_FIXED_HDR_LEN))->pdu_len);
+  if (pdu_len > (int) stream_get_endp (stream))
+    return 0;
+
+  old = lsp_tlv_first (lsp, type, &old_iter);
+  new = tlv_iter_first (&new_iter, type, STREAM_DATA (stream) +
+                        ISIS_FIXED_HDR_LEN + ISIS_LSP_HDR_LEN,
+                        pdu_len - ISIS_FIXED_HDR_LEN - ISIS_LSP_HDR_LEN);
+  while (old && new)
+    {
+      old_next = old_iter.entry;
+      new_next = new_iter.entry;
+      if (len == 0 && old_next - old != new_next - new)
+        return 0;
+      if (memcmp (old, new, len ? len : old_next - old))
+        return 0;
+      old = tlv_iter_next (&old_iter);
+      new = tlv_iter_next (&new_iter);
+    }
+  return old == new;
+}
+
+/*
+ * Whether a received instance leaves the topology as it is: same
+ * protocols, overload bit and neighbours with the same metrics. Anything
+ * else it changes can only be prefixes, for a partial route calculation.
+ */
+static int
+lsp_same_topology (struct isis_lsp *lsp, struct stream *stream)
+{
+  struct isis_link_state_hdr *hdr;
+
+  hdr = (struct isis_link_state_hdr *) (STREAM_DATA (stream) +
+                                        ISIS_FIXED_HDR_LEN);
+
+  if (lsp->lsp_header->seq_num == 0 || hdr->seq_num == 0
+      || lsp->lsp_header->rem_lifetime == 0 || hdr->rem_lifetime == 0
+      || ISIS_MASK_LSP_OL_BIT (hdr->lsp_bits) !=
+         ISIS_MASK_LSP_OL_BIT (lsp->lsp_header->lsp_bits))
+    return 0;
+
+  return lsp_same_entries (lsp, stream, PROTOCOLS_SUPPORTED, 0)
+    && lsp_same_entries (lsp, stream, IS_NEIGHBOURS, IS_NEIGHBOURS_LEN)
+    && lsp_same_entries (lsp, stream, TE_IS_NEIGHBOURS,
+                         ISIS_SYS_ID_LEN + 1 + 3);
+}
+
 void
 lsp_update (struct isis_lsp *lsp, struct stream *stream,
             struct isis_area *area, int level)
 {
-  dnode_t *dnode = NULL;
+  int partial;
+
+  /* A refresh only brings a new header: overwrite the PDU, which leaves
+   * the parsed TLVs pointing at the same content, and skip SPF */
+  if (lsp_same_content (lsp, stream))
+    {
+      stream_copy (lsp->pdu, stream);
+      lsp->age_out = ZERO_AGE_LIFETIME;
+      lsp->installed = time (NULL);
+      if (lsp->tlv_data.hostname && area->dynhostname)
+        isis_dynhn_insert (lsp->lsp_header->lsp_id, lsp->tlv_data.hostname,
+                           (lsp->lsp_header->lsp_bits & LSPBIT_IST) ==
+                            IS_LEVEL_1_AND_2 ? IS_LEVEL_2 : IS_LEVEL_1);
+      lsp_aging_schedule (lsp);
+      return;
+    }
 
-  /* Remove old LSP from database. This is required since the
-   * lsp_update_data will free the lsp->pdu (which has the key, lsp_id)
-   * and will update it with the new data in the stream. */
-  dnode = dict_lookup (area->lspdb[level - 1], lsp->lsp_header->lsp_id);
-  if (dnode)
-    dnode_destroy (dict_delete (area->lspdb[level - 1], dnode));
+  partial = lsp_same_topology (lsp, stream);
 
   /* rebuild the lsp data */
   lsp_update_data (lsp, stream, area, level);
 
-  /* insert the lsp back into the database */
-  lsp_insert (lsp, area->lspdb[level - 1]);
+  /* the database keeps its own copy of the lsp_id, the entry is
+   * updated in place */
+  lspdb_insert (area->lspdb[level - 1], lsp->lsp_header->lsp_id, lsp);
+  lsp_aging_schedule (lsp);
+  if (lsp->lsp_header->seq_num == 0)
+    return;
+
+  if (partial)
+    {
+      isis_prc_schedule (area, level);
+#ifdef HAVE_IPV6
+      isis_prc_schedule6 (area, level);
+#endif
+    }
+  else
+    {
+      isis_spf_schedule (area, level);
+#ifdef HAVE_IPV6
+      isis_spf_schedule6 (area, level);
+#endif
+    }
 }
 
 /* creation of LSP directly from what we received */
@@ -634,9 +869,10 @@ lsp_new(struct isis_area *area, u_char * lsp_id,
 }
 
 void
-lsp_insert (struct isis_lsp *lsp, dict_t * lspdb)
+lsp_insert (struct isis_lsp *lsp, struct lspdb *lspdb)
 {
-  dict_alloc_insert (lspdb, lsp->lsp_header->lsp_id, lsp);
+  lspdb_insert (lspdb, lsp->lsp_header->lsp_id, lsp);
+  lsp_aging_schedule (lsp);
   if (lsp->lsp_header->seq_num != 0)
     {
       isis_spf_schedule (lsp->area, lsp->level);
@@ -651,30 +887,16 @@ lsp_insert (struct isis_lsp *lsp, dict_t * lspdb)
  */
 void
 lsp_build_list_nonzero_ht (u_char * start_id, u_char * stop_id,
-			   struct list *list, dict_t * lspdb)
+			   struct list *list, struct lspdb *lspdb)
 {
-  dnode_t *first, *last, *curr;
-
-  first = dict_lower_bound (lspdb, start_id);
-  if (!first)
-    return;
-
-  last = dict_upper_bound (lspdb, stop_id);
-
-  curr = first;
-
-  if (((struct isis_lsp *) (curr->dict_data))->lsp_header->rem_lifetime)
-    listnode_add (list, first->dict_data);
+  struct lspdb_cursor cur;
+  struct isis_lsp *lsp;
+  u_int64_t stop = lspdb_key (stop_id);
 
-  while (curr)
-    {
-      curr = dict_next (lspdb, curr);
-      if (curr &&
-	  ((struct isis_lsp *) (curr->dict_data))->lsp_header->rem_lifetime)
-	listnode_add (list, curr->dict_data);
-      if (curr == last)
-	break;
-    }
+  for (lsp = lspdb_seek (lspdb, start_id, &cur);
+       lsp && cur.key <= stop; lsp = lspdb_next (&cur))
+    if (lsp->lsp_header->rem_lifetime)
+      listnode_add (list, lsp);
 
   return;
 }
@@ -683,83 +905,54 @@ lsp_build_list_nonzero_ht (u_char * start_id, u_char * stop_id,
  * Build a list of num_lsps LSPs bounded by start_id and stop_id.
  */
 void
-lsp_build_list (u_char * start_id, u_char * stop_id, u_char num_lsps,
-		struct list *list, dict_t * lspdb)
+lsp_build_list (u_char * start_id, u_char * stop_id, u_int16_t num_lsps,
+		struct list *list, struct lspdb *lspdb)
 {
-  u_char count;
-  dnode_t *first, *last, *curr;
-
-  first = dict_lower_bound (lspdb, start_id);
-  if (!first)
-    return;
-
-  last = dict_upper_bound (lspdb, stop_id);
-
-  curr = first;
-
-  listnode_add (list, first->dict_data);
-  count = 1;
+  struct lspdb_cursor cur;
+  struct isis_lsp *lsp;
+  u_int64_t stop = lspdb_key (stop_id);
+  u_int16_t count = 0;
 
-  while (curr)
+  for (lsp = lspdb_seek (lspdb, start_id, &cur);
+       lsp && cur.key <= stop && count < num_lsps; lsp = lspdb_next (&cur))
     {
-      curr = dict_next (lspdb, curr);
-      if (curr)
-        {
-          listnode_add (list, curr->dict_data);
-          count++;
-        }
-      if (count == num_lsps || curr == last)
-        break;
+      listnode_add (list, lsp);
+      count++;
     }
 
   return;
 }
 
 /*
- * Build a list of LSPs with SSN flag set for the given circuit
+ * Build a list of the first num_lsps LSPs of the circuit ssn_queue for
+ * the level, dropping those whose SSN flag was cleared meanwhile.
  */
 void
-lsp_build_list_ssn (struct isis_circuit *circuit, u_char num_lsps,
-                    struct list *list, dict_t * lspdb)
+lsp_build_list_ssn (struct isis_circuit *circuit, int level,
+                    u_int16_t num_lsps, struct list *list)
 {
-  dnode_t *dnode, *next;
+  struct list *queue = circuit->ssn_queue[level - 1];
+  struct listnode *node, *next;
   struct isis_lsp *lsp;
-  u_char count = 0;
+  u_int16_t count = 0;
 
-  dnode = dict_first (lspdb);
-  while (dnode != NULL)
+  for (node = listhead (queue); node && count < num_lsps; node = next)
     {
-      next = dict_next (lspdb, dnode);
-      lsp = dnode_get (dnode);
-      if (ISIS_CHECK_FLAG (lsp->SSNflags, circuit))
+      next = listnextnode (node);
+      lsp = listgetdata (node);
+      if (!ISIS_CHECK_FLAG (lsp->SSNflags, circuit))
         {
-          listnode_add (list, lsp);
-          ++count;
+          ISIS_CLEAR_FLAG (lsp->SSNqueued, circuit);
+          list_delete_node (queue, node);
+          continue;
         }
-      if (count == num_lsps)
-        break;
-      dnode = next;
+      listnode_add (list, lsp);
+      count++;
     }
 
   return;
 }
 
-static void
-lsp_set_time (struct isis_lsp *lsp)
-{
-  assert (lsp);
-
-  if (lsp->lsp_header->rem_lifetime == 0)
-    {
-      if (lsp->age_out > 0)
-        lsp->age_out--;
-      return;
-    }
-
-  lsp->lsp_header->rem_lifetime =
-    htons (ntohs (lsp->lsp_header->rem_lifetime) - 1);
-}
-
 static void
 lspid_print (u_char * lsp_id, u_char * trg, char dynhost, char frag)
 {
@@ -814,6 +1007,7 @@ lsp_print (struct isis_lsp *lsp, struct vty *vty, char dynhost)
   u_char LSPid[255];
   char age_out[8];
 
+  lsp_set_time (lsp);
   lspid_print (lsp->lsp_header->lsp_id, LSPid, dynhost, 1);
   vty_out (vty, "%-21s%c  ", LSPid, lsp->own_lsp ? '*' : ' ');
   vty_out (vty, "%5u   ", ntohs (lsp->lsp_header->pdu_len));
@@ -847,6 +1041,7 @@ lsp_print_detail (struct isis_lsp *lsp, struct vty *vty, char dynhost)
   struct in6_addr in6;
   u_char buff[BUFSIZ];
 #endif
+  struct tlv_iter iter;
   u_char LSPid[255];
   u_char hostname[255];
   u_char ipv4_reach_prefix[20];
@@ -918,8 +1113,7 @@ lsp_print_detail (struct isis_lsp *lsp, struct vty *vty, char dynhost)
       }
 
   /* for the IS neighbor tlv */
-  if (lsp->tlv_data.is_neighs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.is_neighs, lnode, is_neigh))
+  LSP_TLV_FOREACH (lsp, IS_NEIGHBOURS, iter, is_neigh)
       {
 	lspid_print (is_neigh->neigh_id, LSPid, dynhost, 0);
 	vty_out (vty, "  Metric      : %-8d IS            : %s%s",
@@ -927,9 +1121,7 @@ lsp_print_detail (struct isis_lsp *lsp, struct vty *vty, char dynhost)
       }
   
   /* for the internal reachable tlv */
-  if (lsp->tlv_data.ipv4_int_reachs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.ipv4_int_reachs, lnode,
-			       ipv4_reach))
+  LSP_TLV_FOREACH (lsp, IPV4_INT_REACHABILITY, iter, ipv4_reach)
     {
       memcpy (ipv4_reach_prefix, inet_ntoa (ipv4_reach->prefix),
 	      sizeof (ipv4_reach_prefix));
@@ -941,9 +1133,7 @@ lsp_print_detail (struct isis_lsp *lsp, struct vty *vty, char dynhost)
     }
 
   /* for the external reachable tlv */
-  if (lsp->tlv_data.ipv4_ext_reachs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.ipv4_ext_reachs, lnode, 
-			       ipv4_reach))
+  LSP_TLV_FOREACH (lsp, IPV4_EXT_REACHABILITY, iter, ipv4_reach)
     {
       memcpy (ipv4_reach_prefix, inet_ntoa (ipv4_reach->prefix),
 	      sizeof (ipv4_reach_prefix));
@@ -956,8 +1146,7 @@ lsp_print_detail (struct isis_lsp *lsp, struct vty *vty, char dynhost)
   
   /* IPv6 tlv */
 #ifdef HAVE_IPV6
-  if (lsp->tlv_data.ipv6_reachs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.ipv6_reachs, lnode, ipv6_reach))
+  LSP_TLV_FOREACH (lsp, IPV6_REACHABILITY, iter, ipv6_reach)
     {
       memset (&in6, 0, sizeof (in6));
       memcpy (in6.s6_addr, ipv6_reach->prefix,
@@ -976,8 +1165,8 @@ lsp_print_detail (struct isis_lsp *lsp, struct vty *vty, char dynhost)
 #endif
 
   /* TE IS neighbor tlv */
-  if (lsp->tlv_data.te_is_neighs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.te_is_neighs, lnode, te_is_neigh))
+  if (lsp->area->newmetric)
+    LSP_TLV_FOREACH (lsp, TE_IS_NEIGHBOURS, iter, te_is_neigh)
     {
       lspid_print (te_is_neigh->neigh_id, LSPid, dynhost, 0);
       vty_out (vty, "  Metric      : %-8d IS-Extended   : %s%s",
@@ -987,9 +1176,8 @@ lsp_print_detail (struct isis_lsp *lsp, struct vty *vty, char dynhost)
     }
 
   /* TE IPv4 tlv */
-  if (lsp->tlv_data.te_ipv4_reachs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.te_ipv4_reachs, lnode,
-			       te_ipv4_reach))
+  if (lsp->area->newmetric)
+    LSP_TLV_FOREACH (lsp, TE_IPV4_REACHABILITY, iter, te_ipv4_reach)
     {
       /* FIXME: There should be better way to output this stuff. */
       vty_out (vty, "  Metric      : %-8d IPv4-Extended : %s/%d%s",
@@ -1005,31 +1193,26 @@ lsp_print_detail (struct isis_lsp *lsp, struct vty *vty, char dynhost)
 
 /* print all the lsps info in the local lspdb */
 int
-lsp_print_all (struct vty *vty, dict_t * lspdb, char detail, char dynhost)
+lsp_print_all (struct vty *vty, struct lspdb *lspdb, char detail,
+               char dynhost)
 {
-
-  dnode_t *node = dict_first (lspdb), *next;
+  struct lspdb_cursor cur;
+  struct isis_lsp *lsp;
   int lsp_count = 0;
 
   if (detail == ISIS_UI_LEVEL_BRIEF)
     {
-      while (node != NULL)
+      LSPDB_FOREACH (lspdb, cur, lsp)
 	{
-	  /* I think it is unnecessary, so I comment it out */
-	  /* dict_contains (lspdb, node); */
-	  next = dict_next (lspdb, node);
-	  lsp_print (dnode_get (node), vty, dynhost);
-	  node = next;
+	  lsp_print (lsp, vty, dynhost);
 	  lsp_count++;
 	}
     }
   else if (detail == ISIS_UI_LEVEL_DETAIL)
     {
-      while (node != NULL)
+      LSPDB_FOREACH (lspdb, cur, lsp)
 	{
-	  next = dict_next (lspdb, node);
-	  lsp_print_detail (dnode_get (node), vty, dynhost);
-	  node = next;
+	  lsp_print_detail (lsp, vty, dynhost);
 	  lsp_count++;
 	}
     }
@@ -1883,6 +2066,11 @@ lsp_generate (struct isis_area *area, int level)
   if ((area == NULL) || (area->is_type & level) != level)
     return ISIS_ERROR;
 
+  /* a restarting router originates its LSPs once synchronised,
+   * see isis_gr.h */
+  if (area->gr_restarting)
+    return ISIS_OK;
+
   memset (&lspid, 0, ISIS_SYS_ID_LEN + 2);
   memcpy (&lspid, isis->sysid, ISIS_SYS_ID_LEN);
 
@@ -1945,7 +2133,7 @@ lsp_generate (struct isis_area *area, int level)
 static int
 lsp_regenerate (struct isis_area *area, int level)
 {
-  dict_t *lspdb;
+  struct lspdb *lspdb;
   struct isis_lsp *lsp, *frag;
   struct listnode *node;
   u_char lspid[ISIS_SYS_ID_LEN + 2];
@@ -1954,6 +2142,10 @@ lsp_regenerate (struct isis_area *area, int level)
   if ((area == NULL) || (area->is_type & level) != level)
     return ISIS_ERROR;
 
+  /* nor refreshes them before, see isis_gr.h */
+  if (area->gr_restarting)
+    return ISIS_OK;
+
   lspdb = area->lspdb[level - 1];
 
   memset (lspid, 0, ISIS_SYS_ID_LEN + 2);
@@ -1974,6 +2166,7 @@ lsp_regenerate (struct isis_area *area, int level)
                                                  area->attached_bit);
   rem_lifetime = lsp_rem_lifetime (area, level);
   lsp->lsp_header->rem_lifetime = htons (rem_lifetime);
+  lsp_aging_schedule (lsp);
   lsp_seqnum_update (lsp);
 
   lsp->last_generated = time (NULL);
@@ -1987,6 +2180,7 @@ lsp_regenerate (struct isis_area *area, int level)
        * so that no fragment expires before the lsp is refreshed.
        */
       frag->lsp_header->rem_lifetime = htons (rem_lifetime);
+      lsp_aging_schedule (frag);
       lsp_set_all_srmflags (frag);
     }
 
@@ -2070,6 +2264,10 @@ lsp_regenerate_schedule (struct isis_area *area, int level, int all_pseudo)
   if (area == NULL)
     return ISIS_ERROR;
 
+  /* the LSPs are originated once the restart is done */
+  if (area->gr_restarting)
+    return ISIS_OK;
+
   sched_debug("ISIS (%s): Scheduling regeneration of %s LSPs, %sincluding PSNs",
             area->area_tag, circuit_t2string(level), all_pseudo ? "" : "not ");
 
@@ -2308,7 +2506,7 @@ lsp_build_pseudo (struct isis_lsp *lsp, struct isis_circuit *circuit,
 int
 lsp_generate_pseudo (struct isis_circuit *circuit, int level)
 {
-  dict_t *lspdb = circuit->area->lspdb[level - 1];
+  struct lspdb *lspdb = circuit->area->lspdb[level - 1];
   struct isis_lsp *lsp;
   u_char lsp_id[ISIS_SYS_ID_LEN + 2];
   u_int16_t rem_lifetime, refresh_time;
@@ -2340,6 +2538,7 @@ lsp_generate_pseudo (struct isis_circuit *circuit, int level)
 
   lsp->own_lsp = 1;
   lsp_insert (lsp, lspdb);
+  isis_te_lsp_export (lsp, TED_EVENT_UPDATE);
   lsp_set_all_srmflags (lsp);
 
   refresh_time = lsp_refresh_time (lsp, rem_lifetime);
@@ -2371,7 +2570,7 @@ lsp_generate_pseudo (struct isis_circuit *circuit, int level)
 static int
 lsp_regenerate_pseudo (struct isis_circuit *circuit, int level)
 {
-  dict_t *lspdb = circuit->area->lspdb[level - 1];
+  struct lspdb *lspdb = circuit->area->lspdb[level - 1];
   struct isis_lsp *lsp;
   u_char lsp_id[ISIS_SYS_ID_LEN + 2];
   u_int16_t rem_lifetime, refresh_time;
@@ -2403,6 +2602,7 @@ lsp_regenerate_pseudo (struct isis_circuit *circuit, int level)
                                                  circuit->area->attached_bit);
   rem_lifetime = lsp_rem_lifetime (circuit->area, level);
   lsp->lsp_header->rem_lifetime = htons (rem_lifetime);
+  lsp_aging_schedule (lsp);
   lsp_inc_seqnum (lsp, 0);
   lsp->last_generated = time (NULL);
   lsp_set_all_srmflags (lsp);
@@ -2497,6 +2697,10 @@ lsp_regenerate_schedule_pseudo (struct isis_circuit *circuit, int level)
       circuit->state != C_STATE_UP)
     return ISIS_OK;
 
+  /* the LSPs are originated once the restart is done */
+  if (area->gr_restarting)
+    return ISIS_OK;
+
   sched_debug("ISIS (%s): Scheduling regeneration of %s pseudo LSP for interface %s",
               area->area_tag, circuit_t2string(level), circuit->interface->name);
 
@@ -2582,120 +2786,72 @@ lsp_regenerate_schedule_pseudo (struct isis_circuit *circuit, int level)
 }
 
 /*
- * Walk through LSPs for an area
- *  - set remaining lifetime
- *  - set LSPs with SRMflag set for sending
+ * Age the LSPs of an area whose time is up
+ *  - the remaining lifetime runs out: purge (7.3.16.4)
+ *  - the ZeroAgeLifetime runs out: remove from the LSPDB
  */
 int
 lsp_tick (struct thread *thread)
 {
   struct isis_area *area;
-  struct isis_circuit *circuit;
   struct isis_lsp *lsp;
-  struct list *lsp_list;
-  struct listnode *lspnode, *cnode;
-  dnode_t *dnode, *dnode_next;
-  int level;
-  u_int16_t rem_lifetime;
-
-  lsp_list = list_new ();
+  struct lspdb *lspdb;
+  time_t now;
 
   area = THREAD_ARG (thread);
   assert (area);
   area->t_tick = NULL;
-  THREAD_TIMER_ON (master, area->t_tick, lsp_tick, area, 1);
 
-  /*
-   * Build a list of LSPs with (any) SRMflag set
-   * and removed the ones that have aged out
-   */
-  for (level = 0; level < ISIS_LEVELS; level++)
+  now = lsp_clock ();
+  while (area->lsp_aging->size > 0)
     {
-      if (area->lspdb[level] && dict_count (area->lspdb[level]) > 0)
-        {
-          for (dnode = dict_first (area->lspdb[level]);
-               dnode != NULL; dnode = dnode_next)
-            {
-              dnode_next = dict_next (area->lspdb[level], dnode);
-              lsp = dnode_get (dnode);
-
-              /*
-               * The lsp rem_lifetime is kept at 0 for MaxAge or
-               * ZeroAgeLifetime depending on explicit purge or
-               * natural age out. So schedule spf only once when
-               * the first time rem_lifetime becomes 0.
-               */
-              rem_lifetime = ntohs(lsp->lsp_header->rem_lifetime);
-              lsp_set_time (lsp);
-
-              /*
-               * Schedule may run spf which should be done only after
-               * the lsp rem_lifetime becomes 0 for the first time.
-               * ISO 10589 - 7.3.16.4 first paragraph.
-               */
-              if (rem_lifetime == 1 && lsp->lsp_header->seq_num != 0)
-                {
-                  /* 7.3.16.4 a) set SRM flags on all */
-                  lsp_set_all_srmflags (lsp);
-                  /* 7.3.16.4 b) retain only the header FIXME  */
-                  /* 7.3.16.4 c) record the time to purge FIXME */
-                  /* run/schedule spf */
-                  /* isis_spf_schedule is called inside lsp_destroy() below;
-                   * so it is not needed here. */
-                  /* isis_spf_schedule (lsp->area, lsp->level); */
-                }
-
-              if (lsp->age_out == 0)
-                {
-                  zlog_debug ("ISIS-Upd (%s): L%u LSP %s seq 0x%08x aged out",
-                              area->area_tag,
-                              lsp->level,
-                              rawlspid_print (lsp->lsp_header->lsp_id),
-                              ntohl (lsp->lsp_header->seq_num));
-#ifdef TOPOLOGY_GENERATE
-                  if (lsp->from_topology)
-                    THREAD_TIMER_OFF (lsp->t_lsp_top_ref);
-#endif /* TOPOLOGY_GENERATE */
-                  lsp_destroy (lsp);
-                  lsp = NULL;
-                  dict_delete_free (area->lspdb[level], dnode);
-                }
-              else if (flags_any_set (lsp->SRMflags))
-                listnode_add (lsp_list, lsp);
-            }
+      lsp = area->lsp_aging->array[0];
+      if (lsp->expires > now)
+        break;
 
+      if (lsp->lsp_header->rem_lifetime != 0)
+        {
           /*
-           * Send LSPs on circuits indicated by the SRMflags
+           * The lsp rem_lifetime is kept at 0 for MaxAge or
+           * ZeroAgeLifetime depending on explicit purge or
+           * natural age out. Spf runs when it is removed.
+           * ISO 10589 - 7.3.16.4 first paragraph.
            */
-          if (listcount (lsp_list) > 0)
+          lsp->lsp_header->rem_lifetime = 0;
+          lsp_touch (lsp);
+          if (lsp->lsp_header->seq_num != 0)
             {
-              for (ALL_LIST_ELEMENTS_RO (area->circuit_list, cnode, circuit))
-                {
-                  int diff = time (NULL) - circuit->lsp_queue_last_cleared;
-                  if (circuit->lsp_queue == NULL ||
-                      diff < MIN_LSP_TRANS_INTERVAL)
-                    continue;
-                  for (ALL_LIST_ELEMENTS_RO (lsp_list, lspnode, lsp))
-                    {
-                      if (circuit->upadjcount[lsp->level - 1] &&
-                          ISIS_CHECK_FLAG (lsp->SRMflags, circuit))
-                        {
-                          /* Add the lsp only if it is not already in lsp
-                           * queue */
-                          if (! listnode_lookup (circuit->lsp_queue, lsp))
-                            {
-                              listnode_add (circuit->lsp_queue, lsp);
-                              thread_add_event (master, send_lsp, circuit, 0);
-                            }
-                        }
-                    }
-                }
-              list_delete_all_node (lsp_list);
+              /* 7.3.16.4 a) set SRM flags on all */
+              lsp_set_all_srmflags (lsp);
+              /* 7.3.16.4 b) retain only the header FIXME  */
+              /* 7.3.16.4 c) record the time to purge */
             }
+          lsp->expires = now + lsp->age_out;
+          trickle_down (0, area->lsp_aging);
+          continue;
         }
+
+      zlog_debug ("ISIS-Upd (%s): L%u LSP %s seq 0x%08x aged out",
+                  area->area_tag,
+                  lsp->level,
+                  rawlspid_print (lsp->lsp_header->lsp_id),
+                  ntohl (lsp->lsp_header->seq_num));
+#ifdef TOPOLOGY_GENERATE
+      if (lsp->from_topology)
+        THREAD_TIMER_OFF (lsp->t_lsp_top_ref);
+#endif /* TOPOLOGY_GENERATE */
+      lspdb = area->lspdb[lsp->level - 1];
+      if (lspdb_lookup (lspdb, lsp->lsp_header->lsp_id) == lsp)
+        lspdb_delete (lspdb, lsp->lsp_header->lsp_id);
+      lsp_destroy (lsp);
     }
 
-  list_delete (lsp_list);
+  if (area->lsp_aging->size > 0)
+    {
+      lsp = area->lsp_aging->array[0];
+      THREAD_TIMER_ON (master, area->t_tick, lsp_tick, area,
+                       lsp->expires - now);
+    }
 
   return ISIS_OK;
 }
@@ -2728,6 +2884,7 @@ lsp_purge_pseudo (u_char * id, struct isis_circuit *circuit, int level)
   lsp->lsp_header->lsp_bits = lsp_bits;
   lsp->level = level;
   lsp->age_out = lsp->area->max_lsp_lifetime[level-1];
+  lsp_aging_schedule (lsp);
   stream_forward_endp (lsp->pdu, ISIS_FIXED_HDR_LEN + ISIS_LSP_HDR_LEN);
 
   /*
@@ -2771,9 +2928,10 @@ lsp_purge_non_exist (int level,
   stream_forward_endp (lsp->pdu, ISIS_FIXED_HDR_LEN + ISIS_LSP_HDR_LEN);
 
   /*
-   * Set the remaining lifetime to 0
+   * Set the remaining lifetime to 0, retain it for ZeroAgeLifetime
    */
   lsp->lsp_header->rem_lifetime = 0;
+  lsp->age_out = ZERO_AGE_LIFETIME;
 
   /*
    * Add and update the authentication info if its present
@@ -2800,6 +2958,16 @@ lsp_purge_non_exist (int level,
 }
 
 void lsp_set_all_srmflags (struct isis_lsp *lsp)
+{
+  lsp_flood (lsp, NULL);
+}
+
+/*
+ * Set the SRMflags of an LSP received on circuit rcv, NULL for one
+ * of ours, for the circuits it must be flooded on; see isis_flood.c.
+ */
+void
+lsp_flood (struct isis_lsp *lsp, struct isis_circuit *rcv)
 {
   struct listnode *node;
   struct isis_circuit *circuit;
@@ -2813,7 +2981,175 @@ void lsp_set_all_srmflags (struct isis_lsp *lsp)
       struct list *circuit_list = lsp->area->circuit_list;
       for (ALL_LIST_ELEMENTS_RO (circuit_list, node, circuit))
         {
-          ISIS_SET_FLAG(lsp->SRMflags, circuit);
+          if (isis_flood_circuit (circuit, rcv, lsp->level))
+            lsp_srm_set (lsp, circuit);
+        }
+    }
+}
+
+/*
+ * Transmission queues. Setting the SRMflag of an LSP for a circuit
+ * puts the LSP on the circuit lsp_queue, if it can be sent there, and
+ * send_lsp() drains the queue. An LSP is queued (SRMqueued) at most
+ * once per circuit; one whose SRMflag was cleared meanwhile is skipped.
+ */
+static void
+lsp_queue_add (struct isis_lsp *lsp, struct isis_circuit *circuit)
+{
+  if (circuit->lsp_queue == NULL
+      || circuit->upadjcount[lsp->level - 1] == 0
+      || ISIS_CHECK_FLAG (lsp->SRMqueued, circuit))
+    return;
+
+  ISIS_SET_FLAG (lsp->SRMqueued, circuit);
+  listnode_add (circuit->lsp_queue, lsp);
+  if (circuit->t_send_lsp == NULL)
+    circuit->t_send_lsp = thread_add_event (master, send_lsp, circuit, 0);
+}
+
+void
+lsp_srm_set (struct isis_lsp *lsp, struct isis_circuit *circuit)
+{
+  ISIS_SET_FLAG (lsp->SRMflags, circuit);
+  lsp_queue_add (lsp, circuit);
+}
+
+/* LSPs still unacknowledged go back to lsp_queue */
+static int
+lsp_rxmt_timer (struct thread *thread)
+{
+  struct isis_circuit *circuit;
+  struct isis_lsp *lsp;
+  struct listnode *node, *nnode;
+
+  circuit = THREAD_ARG (thread);
+  circuit->t_lsp_rxmt = NULL;
+
+  for (ALL_LIST_ELEMENTS (circuit->lsp_rxmt_queue, node, nnode, lsp))
+    {
+      list_delete_node (circuit->lsp_rxmt_queue, node);
+      ISIS_CLEAR_FLAG (lsp->SRMqueued, circuit);
+      if (ISIS_CHECK_FLAG (lsp->SRMflags, circuit))
+        lsp_queue_add (lsp, circuit);
+    }
+
+  return ISIS_OK;
+}
+
+/* An LSP sent on a P2P circuit is sent again until acknowledged */
+void
+lsp_srm_retransmit (struct isis_lsp *lsp, struct isis_circuit *circuit)
+{
+  if (circuit->lsp_rxmt_queue == NULL
+      || ISIS_CHECK_FLAG (lsp->SRMqueued, circuit))
+    return;
+
+  ISIS_SET_FLAG (lsp->SRMqueued, circuit);
+  listnode_add (circuit->lsp_rxmt_queue, lsp);
+  THREAD_TIMER_ON (master, circuit->t_lsp_rxmt, lsp_rxmt_timer, circuit,
+                   MIN_LSP_TRANS_INTERVAL);
+}
+
+/* Empty the circuit queues */
+void
+lsp_queue_flush (struct isis_circuit *circuit)
+{
+  struct isis_lsp *lsp;
+  struct listnode *node;
+
+  THREAD_OFF (circuit->t_send_lsp);
+  THREAD_TIMER_OFF (circuit->t_lsp_rxmt);
+
+  if (circuit->lsp_queue)
+    {
+      for (ALL_LIST_ELEMENTS_RO (circuit->lsp_queue, node, lsp))
+        ISIS_CLEAR_FLAG (lsp->SRMqueued, circuit);
+      list_delete_all_node (circuit->lsp_queue);
+    }
+  if (circuit->lsp_rxmt_queue)
+    {
+      for (ALL_LIST_ELEMENTS_RO (circuit->lsp_rxmt_queue, node, lsp))
+        ISIS_CLEAR_FLAG (lsp->SRMqueued, circuit);
+      list_delete_all_node (circuit->lsp_rxmt_queue);
+    }
+}
+
+/*
+ * Acknowledgements and requests. Setting the SSNflag of an LSP for a
+ * circuit puts the LSP on the circuit ssn_queue of its level, and the
+ * PSNPs are batched from there, see isis_psnp_schedule().
+ */
+void
+lsp_ssn_set (struct isis_lsp *lsp, struct isis_circuit *circuit)
+{
+  struct list *queue = circuit->ssn_queue[lsp->level - 1];
+
+  ISIS_SET_FLAG (lsp->SSNflags, circuit);
+  if (queue == NULL || ISIS_CHECK_FLAG (lsp->SSNqueued, circuit))
+    return;
+
+  ISIS_SET_FLAG (lsp->SSNqueued, circuit);
+  listnode_add (queue, lsp);
+  isis_psnp_schedule (circuit, lsp->level);
+}
+
+/* The LSPs of list, built by lsp_build_list_ssn(), were sent */
+void
+lsp_ssn_sent (struct isis_circuit *circuit, int level, struct list *list)
+{
+  struct list *queue = circuit->ssn_queue[level - 1];
+  struct listnode *node;
+  struct isis_lsp *lsp;
+
+  for (ALL_LIST_ELEMENTS_RO (list, node, lsp))
+    {
+      assert (listgetdata (listhead (queue)) == lsp);
+      list_delete_node (queue, listhead (queue));
+      ISIS_CLEAR_FLAG (lsp->SSNqueued, circuit);
+      ISIS_CLEAR_FLAG (lsp->SSNflags, circuit);
+    }
+}
+
+/* Drop the pending acknowledgements and requests of a level */
+void
+lsp_ssn_flush (struct isis_circuit *circuit, int level)
+{
+  struct list *queue = circuit->ssn_queue[level - 1];
+  struct listnode *node;
+  struct isis_lsp *lsp;
+
+  if (queue == NULL)
+    return;
+
+  for (ALL_LIST_ELEMENTS_RO (queue, node, lsp))
+    {
+      ISIS_CLEAR_FLAG (lsp->SSNqueued, circuit);
+      ISIS_CLEAR_FLAG (lsp->SSNflags, circuit);
+    }
+  list_delete_all_node (queue);
+}
+
+/* Requeue the LSPs flagged for the circuit, once its adjacencies
+ * changed: the levels with no adjacency up are left out. */
+void
+lsp_queue_rebuild (struct isis_circuit *circuit)
+{
+  struct lspdb_cursor cur;
+  struct isis_lsp *lsp;
+  int level;
+
+  lsp_queue_flush (circuit);
+
+  for (level = IS_LEVEL_1; level <= IS_LEVEL_2; level++)
+    {
+      if (circuit->upadjcount[level - 1] == 0
+          || circuit->area->lspdb[level - 1] == NULL)
+        continue;
+
+      LSPDB_FOREACH (circuit->area->lspdb[level - 1], cur, lsp)
+        {
+          if (ISIS_CHECK_FLAG (lsp->SRMflags, circuit))
+            lsp_queue_add (lsp, circuit);
         }
     }
 }
@@ -2847,6 +3183,7 @@ top_lsp_refresh (struct thread *thread)
                                                  lsp->area->attached_bit);
   rem_lifetime = lsp_rem_lifetime (lsp->area, IS_LEVEL_1);
   lsp->lsp_header->rem_lifetime = htons (rem_lifetime);
+  lsp_aging_schedule (lsp);
 
   /* refresh_time = lsp_refresh_time (lsp, rem_lifetime); */
   THREAD_TIMER_ON (master, lsp->t_lsp_top_ref, top_lsp_refresh, lsp,
@@ -2908,21 +3245,17 @@ generate_topology_lsps (struct isis_area *area)
 void
 remove_topology_lsps (struct isis_area *area)
 {
+  struct lspdb_cursor cur;
   struct isis_lsp *lsp;
-  dnode_t *dnode, *dnode_next;
 
-  dnode = dict_first (area->lspdb[0]);
-  while (dnode != NULL)
+  LSPDB_FOREACH (area->lspdb[0], cur, lsp)
     {
-      dnode_next = dict_next (area->lspdb[0], dnode);
-      lsp = dnode_get (dnode);
       if (lsp->from_topology)
 	{
 	  THREAD_TIMER_OFF (lsp->t_lsp_top_ref);
+	  lspdb_delete (area->lspdb[0], lsp->lsp_header->lsp_id);
 	  lsp_destroy (lsp);
-	  dict_delete (area->lspdb[0], dnode);
 	}
-      dnode = dnode_next;
     }
 }
 
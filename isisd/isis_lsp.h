@@ -41,6 +41,8 @@ struct isis_lsp
   u_int32_t auth_tlv_offset;    /* authentication TLV position in the pdu */
   u_int32_t SRMflags[ISIS_MAX_CIRCUITS];
   u_int32_t SSNflags[ISIS_MAX_CIRCUITS];
+  u_int32_t SRMqueued[ISIS_MAX_CIRCUITS];	/* on the circuit lsp_queue */
+  u_int32_t SSNqueued[ISIS_MAX_CIRCUITS];	/* on the circuit ssn_queue */
   int level;			/* L1 or L2? */
   int scheduled;		/* scheduled for sending */
   time_t installed;
@@ -52,13 +54,18 @@ struct isis_lsp
 #endif
   /* used for 60 second counting when rem_lifetime is zero */
   int age_out;
+  /* when rem_lifetime, or age_out once it is zero, runs out */
+  time_t expires;
+  int aging_pos;		/* area->lsp_aging position + 1, 0 if none */
   struct isis_area *area;
   struct tlvs tlv_data;		/* Simplifies TLV access */
 };
 
-dict_t *lsp_db_init (void);
-void lsp_db_destroy (dict_t * lspdb);
+struct lspdb *lsp_db_init (void);
+void lsp_db_destroy (struct lspdb *lspdb);
+struct pqueue *lsp_aging_init (void);
 int lsp_tick (struct thread *thread);
+void lsp_set_time (struct isis_lsp *lsp);
 
 int lsp_generate (struct isis_area *area, int level);
 int lsp_regenerate_schedule (struct isis_area *area, int level,
@@ -75,17 +82,19 @@ struct isis_lsp *lsp_new_from_stream_ptr (struct stream *stream,
 					  struct isis_lsp *lsp0,
 					  struct isis_area *area,
                                           int level);
-void lsp_insert (struct isis_lsp *lsp, dict_t * lspdb);
-struct isis_lsp *lsp_search (u_char * id, dict_t * lspdb);
+void lsp_insert (struct isis_lsp *lsp, struct lspdb *lspdb);
+struct isis_lsp *lsp_search (u_char * id, struct lspdb *lspdb);
+void *lsp_tlv_first (struct isis_lsp *lsp, u_char type,
+                     struct tlv_iter *iter);
 
-void lsp_build_list (u_char * start_id, u_char * stop_id, u_char num_lsps,
-		     struct list *list, dict_t * lspdb);
+void lsp_build_list (u_char * start_id, u_char * stop_id, u_int16_t num_lsps,
+		     struct list *list, struct lspdb *lspdb);
 void lsp_build_list_nonzero_ht (u_char * start_id, u_char * stop_id,
-				struct list *list, dict_t * lspdb);
-void lsp_build_list_ssn (struct isis_circuit *circuit, u_char num_lsps,
-                         struct list *list, dict_t * lspdb);
+				struct list *list, struct lspdb *lspdb);
+void lsp_build_list_ssn (struct isis_circuit *circuit, int level,
+                         u_int16_t num_lsps, struct list *list);
 
-void lsp_search_and_destroy (u_char * id, dict_t * lspdb);
+void lsp_search_and_destroy (u_char * id, struct lspdb *lspdb);
 void lsp_purge_pseudo (u_char * id, struct isis_circuit *circuit, int level);
 void lsp_purge_non_exist (int level,
 			  struct isis_link_state_hdr *lsp_hdr,
@@ -101,6 +110,9 @@ void lsp_purge_non_exist (int level,
         memcpy ((I), isis->sysid, ISIS_SYS_ID_LEN);\
         (I)[ISIS_SYS_ID_LEN] = 0;\
         (I)[ISIS_SYS_ID_LEN + 1] = 0
+/* Entries of the TLVs of one type, read from the LSP PDU */
+#define LSP_TLV_FOREACH(L, T, IT, E) \
+  for ((E) = lsp_tlv_first ((L), (T), &(IT)); (E); (E) = tlv_iter_next (&(IT)))
 int lsp_id_cmp (u_char * id1, u_char * id2);
 int lsp_compare (char *areatag, struct isis_lsp *lsp, u_int32_t seq_num,
 		 u_int16_t checksum, u_int16_t rem_lifetime);
@@ -109,12 +121,22 @@ void lsp_update (struct isis_lsp *lsp, struct stream *stream,
 void lsp_inc_seqnum (struct isis_lsp *lsp, u_int32_t seq_num);
 void lsp_print (struct isis_lsp *lsp, struct vty *vty, char dynhost);
 void lsp_print_detail (struct isis_lsp *lsp, struct vty *vty, char dynhost);
-int lsp_print_all (struct vty *vty, dict_t * lspdb, char detail,
+int lsp_print_all (struct vty *vty, struct lspdb *lspdb, char detail,
 		   char dynhost);
 const char *lsp_bits2string (u_char *);
 
 /* sets SRMflags for all active circuits of an lsp */
 void lsp_set_all_srmflags (struct isis_lsp *lsp);
+void lsp_flood (struct isis_lsp *lsp, struct isis_circuit *rcv);
+
+/* SRMflag setting and the circuit transmission queues */
+void lsp_srm_set (struct isis_lsp *lsp, struct isis_circuit *circuit);
+void lsp_srm_retransmit (struct isis_lsp *lsp, struct isis_circuit *circuit);
+void lsp_queue_rebuild (struct isis_circuit *circuit);
+void lsp_queue_flush (struct isis_circuit *circuit);
+void lsp_ssn_set (struct isis_lsp *lsp, struct isis_circuit *circuit);
+void lsp_ssn_sent (struct isis_circuit *circuit, int level, struct list *list);
+void lsp_ssn_flush (struct isis_circuit *circuit, int level);
 
 #ifdef TOPOLOGY_GENERATE
 void generate_topology_lsps (struct isis_area *area);
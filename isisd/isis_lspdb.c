@@ -0,0 +1,450 @@
+/*
+ * IS-IS Rout(e)ing protocol - isis_lspdb.c
+ *                             LSP database
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "memory.h"
+
+#include "isisd/isis_constants.h"
+#include "isisd/isis_lspdb.h"
+
+/* Entries per node; a node is split when full and rebalanced with a
+ * sibling when it falls under half of it. */
+#define LSPDB_FANOUT	32
+#define LSPDB_MIN	(LSPDB_FANOUT / 2)
+
+/*
+ * In a leaf, key[i] is the LSP ID of ptr[i], a struct isis_lsp. In an
+ * internal node, ptr[i] is a child whose keys are all greater than or
+ * equal to key[i] and lower than key[i + 1].
+ */
+struct lspdb_node
+{
+  unsigned int count;
+  int leaf;
+  struct lspdb_node *next;	/* leaves only, in key order */
+  u_int64_t key[LSPDB_FANOUT];
+  void *ptr[LSPDB_FANOUT];
+};
+
+static struct lspdb_node *
+lspdb_node_new (int leaf)
+{
+  struct lspdb_node *node;
+
+  node = XCALLOC (MTYPE_ISIS_LSPDB, sizeof (struct lspdb_node));
+  node->leaf = leaf;
+  return node;
+}
+
+static void
+lspdb_node_free (struct lspdb_node *node)
+{
+  unsigned int i;
+
+  if (!node->leaf)
+    for (i = 0; i < node->count; i++)
+      lspdb_node_free (node->ptr[i]);
+  XFREE (MTYPE_ISIS_LSPDB, node);
+}
+
+struct lspdb *
+lspdb_new (void)
+{
+  struct lspdb *db;
+
+  db = XCALLOC (MTYPE_ISIS_LSPDB, sizeof (struct lspdb));
+  db->root = lspdb_node_new (1);
+  return db;
+}
+
+/* Free the database, not the LSPs it holds. */
+void
+lspdb_free (struct lspdb *db)
+{
+  lspdb_node_free (db->root);
+  XFREE (MTYPE_ISIS_LSPDB, db);
+}
+
+u_int64_t
+lspdb_key (const u_char *id)
+{
+  u_int64_t key = 0;
+  int i;
+
+  for (i = 0; i < ISIS_SYS_ID_LEN + 2; i++)
+    key = (key << 8) | id[i];
+  return key;
+}
+
+/* Position of the first key greater than or equal to key. */
+static unsigned int
+lspdb_node_search (struct lspdb_node *node, u_int64_t key)
+{
+  unsigned int lo = 0, hi = node->count, mid;
+
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      if (node->key[mid] < key)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  return lo;
+}
+
+/* Child of an internal node which covers key. */
+static unsigned int
+lspdb_node_child (struct lspdb_node *node, u_int64_t key)
+{
+  unsigned int pos;
+
+  pos = lspdb_node_search (node, key);
+  if (pos < node->count && node->key[pos] == key)
+    return pos;
+  return pos ? pos - 1 : 0;
+}
+
+static struct lspdb_node *
+lspdb_leaf (struct lspdb *db, u_int64_t key)
+{
+  struct lspdb_node *node = db->root;
+
+  while (!node->leaf)
+    node = node->ptr[lspdb_node_child (node, key)];
+  return node;
+}
+
+static void
+lspdb_node_insert_at (struct lspdb_node *node, unsigned int pos,
+                      u_int64_t key, void *ptr)
+{
+  memmove (&node->key[pos + 1], &node->key[pos],
+           (node->count - pos) * sizeof (node->key[0]));
+  memmove (&node->ptr[pos + 1], &node->ptr[pos],
+           (node->count - pos) * sizeof (node->ptr[0]));
+  node->key[pos] = key;
+  node->ptr[pos] = ptr;
+  node->count++;
+}
+
+static void
+lspdb_node_remove_at (struct lspdb_node *node, unsigned int pos)
+{
+  node->count--;
+  memmove (&node->key[pos], &node->key[pos + 1],
+           (node->count - pos) * sizeof (node->key[0]));
+  memmove (&node->ptr[pos], &node->ptr[pos + 1],
+           (node->count - pos) * sizeof (node->ptr[0]));
+}
+
+/* Move the entries of src from pos on to the end of dst. */
+static void
+lspdb_node_move (struct lspdb_node *dst, struct lspdb_node *src,
+                 unsigned int pos)
+{
+  unsigned int n = src->count - pos;
+
+  memcpy (&dst->key[dst->count], &src->key[pos], n * sizeof (src->key[0]));
+  memcpy (&dst->ptr[dst->count], &src->ptr[pos], n * sizeof (src->ptr[0]));
+  dst->count += n;
+  src->count = pos;
+}
+
+/*
+ * Insert an entry at pos, splitting the node if it is full. Returns the
+ * new right hand node, if any.
+ */
+static struct lspdb_node *
+lspdb_node_add (struct lspdb_node *node, unsigned int pos,
+                u_int64_t key, void *ptr)
+{
+  struct lspdb_node *right;
+
+  if (node->count < LSPDB_FANOUT)
+    {
+      lspdb_node_insert_at (node, pos, key, ptr);
+      return NULL;
+    }
+
+  right = lspdb_node_new (node->leaf);
+  lspdb_node_move (right, node, LSPDB_MIN);
+  if (node->leaf)
+    {
+      right->next = node->next;
+      node->next = right;
+    }
+
+  if (pos <= LSPDB_MIN)
+    lspdb_node_insert_at (node, pos, key, ptr);
+  else
+    lspdb_node_insert_at (right, pos - LSPDB_MIN, key, ptr);
+  return right;
+}
+
+static struct lspdb_node *
+lspdb_node_insert (struct lspdb *db, struct lspdb_node *node,
+                   u_int64_t key, struct isis_lsp *lsp)
+{
+  struct lspdb_node *right;
+  unsigned int pos;
+
+  if (node->leaf)
+    {
+      pos = lspdb_node_search (node, key);
+      if (pos < node->count && node->key[pos] == key)
+        {
+          node->ptr[pos] = lsp;
+          return NULL;
+        }
+      db->count++;
+      db->gen++;
+      return lspdb_node_add (node, pos, key, lsp);
+    }
+
+  /* Only the leftmost children can see keys below their lower bound */
+  pos = lspdb_node_child (node, key);
+  if (key < node->key[pos])
+    node->key[pos] = key;
+  right = lspdb_node_insert (db, node->ptr[pos], key, lsp);
+  if (right == NULL)
+    return NULL;
+  return lspdb_node_add (node, pos + 1, right->key[0], right);
+}
+
+/* Insert an LSP, replacing the one with the same LSP ID if any. */
+void
+lspdb_insert (struct lspdb *db, const u_char *id, struct isis_lsp *lsp)
+{
+  struct lspdb_node *right, *root;
+
+  lspdb_touch (db, id);
+  right = lspdb_node_insert (db, db->root, lspdb_key (id), lsp);
+  if (right == NULL)
+    return;
+
+  root = lspdb_node_new (0);
+  lspdb_node_insert_at (root, 0, db->root->key[0], db->root);
+  lspdb_node_insert_at (root, 1, right->key[0], right);
+  db->root = root;
+}
+
+struct isis_lsp *
+lspdb_lookup (struct lspdb *db, const u_char *id)
+{
+  struct lspdb_node *node;
+  u_int64_t key = lspdb_key (id);
+  unsigned int pos;
+
+  node = lspdb_leaf (db, key);
+  pos = lspdb_node_search (node, key);
+  if (pos < node->count && node->key[pos] == key)
+    return node->ptr[pos];
+  return NULL;
+}
+
+/*
+ * Refill child pos of node, which fell under LSPDB_MIN entries, from a
+ * sibling, or merge it with one.
+ */
+static void
+lspdb_node_rebalance (struct lspdb_node *node, unsigned int pos)
+{
+  struct lspdb_node *child, *left, *right;
+
+  child = node->ptr[pos];
+  left = pos > 0 ? node->ptr[pos - 1] : NULL;
+  right = pos + 1 < node->count ? node->ptr[pos + 1] : NULL;
+
+  if (left && left->count > LSPDB_MIN)
+    {
+      lspdb_node_insert_at (child, 0, left->key[left->count - 1],
+                            left->ptr[left->count - 1]);
+      left->count--;
+      node->key[pos] = child->key[0];
+      return;
+    }
+  if (right && right->count > LSPDB_MIN)
+    {
+      lspdb_node_insert_at (child, child->count, right->key[0],
+                            right->ptr[0]);
+      lspdb_node_remove_at (right, 0);
+      node->key[pos + 1] = right->key[0];
+      return;
+    }
+
+  /* Merge with a sibling, which has exactly LSPDB_MIN entries */
+  if (left)
+    {
+      right = child;
+      pos--;
+    }
+  else if (right)
+    left = child;
+  else
+    return;
+
+  lspdb_node_move (left, right, 0);
+  if (left->leaf)
+    left->next = right->next;
+  XFREE (MTYPE_ISIS_LSPDB, right);
+  lspdb_node_remove_at (node, pos + 1);
+}
+
+static struct isis_lsp *
+lspdb_node_delete (struct lspdb *db, struct lspdb_node *node, u_int64_t key)
+{
+  struct lspdb_node *child;
+  struct isis_lsp *lsp;
+  unsigned int pos;
+
+  if (node->leaf)
+    {
+      pos = lspdb_node_search (node, key);
+      if (pos == node->count || node->key[pos] != key)
+        return NULL;
+      lsp = node->ptr[pos];
+      lspdb_node_remove_at (node, pos);
+      db->count--;
+      db->gen++;
+      return lsp;
+    }
+
+  pos = lspdb_node_child (node, key);
+  child = node->ptr[pos];
+  lsp = lspdb_node_delete (db, child, key);
+  if (lsp && child->count < LSPDB_MIN)
+    lspdb_node_rebalance (node, pos);
+  return lsp;
+}
+
+/* Remove an LSP from the database and return it, NULL if not found. */
+struct isis_lsp *
+lspdb_delete (struct lspdb *db, const u_char *id)
+{
+  struct lspdb_node *root = db->root;
+  struct isis_lsp *lsp;
+
+  lsp = lspdb_node_delete (db, root, lspdb_key (id));
+  if (!root->leaf && root->count == 1)
+    {
+      db->root = root->ptr[0];
+      XFREE (MTYPE_ISIS_LSPDB, root);
+    }
+  return lsp;
+}
+
+static struct isis_lsp *
+lspdb_cursor_set (struct lspdb_cursor *cur, struct lspdb_node *node,
+                  unsigned int pos)
+{
+  while (node && pos >= node->count)
+    {
+      node = node->next;
+      pos = 0;
+    }
+
+  cur->node = node;
+  cur->pos = pos;
+  if (node == NULL)
+    return NULL;
+  cur->gen = cur->db->gen;
+  cur->key = node->key[pos];
+  return node->ptr[pos];
+}
+
+static struct isis_lsp *
+lspdb_cursor_seek (struct lspdb *db, u_int64_t key, struct lspdb_cursor *cur)
+{
+  struct lspdb_node *node;
+
+  cur->db = db;
+  node = lspdb_leaf (db, key);
+  return lspdb_cursor_set (cur, node, lspdb_node_search (node, key));
+}
+
+struct isis_lsp *
+lspdb_first (struct lspdb *db, struct lspdb_cursor *cur)
+{
+  return lspdb_cursor_seek (db, 0, cur);
+}
+
+/* First LSP with an LSP ID greater than or equal to id. */
+struct isis_lsp *
+lspdb_seek (struct lspdb *db, const u_char *id, struct lspdb_cursor *cur)
+{
+  return lspdb_cursor_seek (db, lspdb_key (id), cur);
+}
+
+struct isis_lsp *
+lspdb_next (struct lspdb_cursor *cur)
+{
+  if (cur->node == NULL)
+    return NULL;
+
+  if (cur->gen == cur->db->gen)
+    return lspdb_cursor_set (cur, cur->node, cur->pos + 1);
+
+  /* The database changed, look the position up again */
+  if (cur->key == UINT64_MAX)
+    {
+      cur->node = NULL;
+      return NULL;
+    }
+  return lspdb_cursor_seek (cur->db, cur->key + 1, cur);
+}
+
+/*
+ * Record a change of the sequence number, checksum or remaining
+ * lifetime of an LSP, which its SNP entry carries.
+ */
+void
+lspdb_touch (struct lspdb *db, const u_char *id)
+{
+  db->version++;
+  db->log[db->version % LSPDB_LOG_SIZE] = lspdb_key (id);
+}
+
+/*
+ * Did an entry between start_id and stop_id change since version ?
+ * Answers yes when the changes since then are no longer all logged.
+ */
+int
+lspdb_changed (struct lspdb *db, unsigned int version,
+               const u_char *start_id, const u_char *stop_id)
+{
+  u_int64_t start = lspdb_key (start_id), stop = lspdb_key (stop_id);
+  u_int64_t key;
+
+  if (db->version - version >= LSPDB_LOG_SIZE)
+    return 1;
+
+  while (version != db->version)
+    {
+      version++;
+      key = db->log[version % LSPDB_LOG_SIZE];
+      if (key >= start && key <= stop)
+        return 1;
+    }
+  return 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * IS-IS Rout(e)ing protocol - isis_lspdb.h
+ *                             LSP database
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _ZEBRA_ISIS_LSPDB_H
+#define _ZEBRA_ISIS_LSPDB_H
+
+/*
+ * The LSP database is a B+tree keyed by the 8 byte LSP ID read as a big
+ * endian 64 bit integer, which orders LSPs as memcmp() does. Keys and
+ * LSP pointers are packed into arrays in the nodes and the leaves are
+ * chained, so that building a CSNP or PSNP walks consecutive memory
+ * rather than chasing tree pointers.
+ */
+struct lspdb_node;
+struct isis_lsp;
+
+/* Number of entry changes remembered, see lspdb_changed() */
+#define LSPDB_LOG_SIZE	64
+
+struct lspdb
+{
+  struct lspdb_node *root;
+  unsigned long count;
+  unsigned int gen;		/* bumped on each insertion or deletion */
+  unsigned int version;		/* bumped on each change of an entry */
+  u_int64_t log[LSPDB_LOG_SIZE];	/* keys of the last changes */
+};
+
+/*
+ * Position in the database. A cursor remains usable while the database
+ * is modified, including when its current LSP is deleted: the next step
+ * then looks up the LSP following the last key returned.
+ */
+struct lspdb_cursor
+{
+  struct lspdb *db;
+  struct lspdb_node *node;
+  unsigned int pos;
+  unsigned int gen;
+  u_int64_t key;
+};
+
+#define LSPDB_FOREACH(db, cur, lsp) \
+  for ((lsp) = lspdb_first ((db), &(cur)); (lsp); (lsp) = lspdb_next (&(cur)))
+
+/* Prototypes. */
+extern struct lspdb *lspdb_new (void);
+extern void lspdb_free (struct lspdb *);
+extern u_int64_t lspdb_key (const u_char *);
+extern void lspdb_insert (struct lspdb *, const u_char *, struct isis_lsp *);
+extern struct isis_lsp *lspdb_lookup (struct lspdb *, const u_char *);
+extern struct isis_lsp *lspdb_delete (struct lspdb *, const u_char *);
+extern struct isis_lsp *lspdb_first (struct lspdb *, struct lspdb_cursor *);
+extern struct isis_lsp *lspdb_seek (struct lspdb *, const u_char *,
+                                    struct lspdb_cursor *);
+extern struct isis_lsp *lspdb_next (struct lspdb_cursor *);
+extern void lspdb_touch (struct lspdb *, const u_char *);
+extern int lspdb_changed (struct lspdb *, unsigned int, const u_char *,
+                          const u_char *);
+
+#define lspdb_count(db) ((db)->count)
+
+#endif /* _ZEBRA_ISIS_LSPDB_H */
@@ -38,7 +38,7 @@
 #include "zclient.h"
 #include "vrf.h"
 
-#include "isisd/dict.h"
+#include "isisd/isis_lspdb.h"
 #include "include-netbsd/iso.h"
 #include "isisd/isis_constants.h"
 #include "isisd/isis_common.h"
@@ -52,6 +52,8 @@
 #include "isisd/isis_zebra.h"
 #include "isisd/isis_tlv.h"
 #include "isisd/isis_te.h"
+#include "isisd/isis_cspf.h"
+#include "isisd/isis_gr.h"
 
 /* Default configuration file name */
 #define ISISD_DEFAULT_CONFIG "isisd.conf"
@@ -343,6 +345,8 @@ main (int argc, char **argv, char **envp)
   isis_redist_init ();
   isis_route_map_init();
   isis_mpls_te_init();
+  isis_cspf_init ();
+  isis_gr_init ();
 
   /* create the global 'isis' instance */
   isis_new (1);
@@ -368,6 +372,9 @@ main (int argc, char **argv, char **envp)
   /* Make isis vty socket. */
   vty_serv_sock (vty_addr, vty_port, ISIS_VTYSH_PATH);
 
+  /* Make isis cspf socket. */
+  isis_cspf_serv_un (ISIS_CSPF_PATH);
+
   /* Print banner. */
   zlog_notice ("Quagga-ISISd %s starting: vty@%d", QUAGGA_VERSION, vty_port);
 
@@ -35,7 +35,7 @@
 #include "checksum.h"
 #include "md5.h"
 
-#include "isisd/dict.h"
+#include "isisd/isis_lspdb.h"
 #include "isisd/include-netbsd/iso.h"
 #include "isisd/isis_constants.h"
 #include "isisd/isis_common.h"
@@ -54,6 +54,8 @@
 #include "isisd/isis_csm.h"
 #include "isisd/isis_events.h"
 #include "isisd/isis_te.h"
+#include "isisd/isis_flood.h"
+#include "isisd/isis_gr.h"
 
 #define ISIS_MINIMUM_FIXED_HDR_LEN 15
 #define ISIS_MIN_PDU_LEN           13	/* partial seqnum pdu with id_len=2 */
@@ -203,9 +205,8 @@ authentication_check (struct isis_passwd *remote, struct isis_passwd *local,
       memset (STREAM_DATA (stream) + auth_tlv_offset + 3, 0,
               ISIS_AUTH_MD5_SIZE);
       /* Compute the digest */
-      hmac_md5 (STREAM_DATA (stream), stream_get_endp (stream),
-                (unsigned char *) &(local->passwd), local->len,
-                (unsigned char *) &digest);
+      hmac_md5_digest (&local->hmac, STREAM_DATA (stream),
+                       stream_get_endp (stream), (unsigned char *) &digest);
       /* Copy back the authentication value after the check */
       memcpy (STREAM_DATA (stream) + auth_tlv_offset + 3,
               remote->passwd, ISIS_AUTH_MD5_SIZE);
@@ -474,6 +475,7 @@ process_p2p_hello (struct isis_circuit *circuit)
   expected |= TLVFLAG_NLPID;
   expected |= TLVFLAG_IPV4_ADDR;
   expected |= TLVFLAG_IPV6_ADDR;
+  expected |= TLVFLAG_GRACEFUL_RESTART;
 
   auth_tlv_offset = stream_get_getp (circuit->rcv_stream);
   retval = parse_tlvs (circuit->area->area_tag,
@@ -650,6 +652,9 @@ process_p2p_hello (struct isis_circuit *circuit)
   THREAD_TIMER_ON (master, adj->t_expire, isis_adj_expire, adj,
 		   (long) adj->hold_time);
 
+  /* restart signalling, RFC 5306 */
+  isis_gr_hello_received (adj, IS_LEVEL_1, &tlvs, found);
+
   /* 8.2.5.2 a) a match was detected */
   if (area_match (circuit->area->area_addrs, tlvs.area_addrs))
     {
@@ -1033,6 +1038,7 @@ process_lan_hello (int level, struct isis_circuit *circuit, const u_char *ssnpa)
   expected |= TLVFLAG_NLPID;
   expected |= TLVFLAG_IPV4_ADDR;
   expected |= TLVFLAG_IPV6_ADDR;
+  expected |= TLVFLAG_GRACEFUL_RESTART;
 
   auth_tlv_offset = stream_get_getp (circuit->rcv_stream);
   retval = parse_tlvs (circuit->area->area_tag,
@@ -1249,9 +1255,14 @@ process_lan_hello (int level, struct isis_circuit *circuit, const u_char *ssnpa)
   THREAD_TIMER_ON (master, adj->t_expire, isis_adj_expire, adj,
                    (long) adj->hold_time);
 
+  /* restart signalling, RFC 5306 */
+  isis_gr_hello_received (adj, level, &tlvs, found);
+
   /*
    * If the snpa for this circuit is found from LAN Neighbours TLV
    * we have two-way communication -> adjacency can be put to state "up"
+   * A restarting neighbour, which does not list us yet, keeps its
+   * adjacency while we help it.
    */
 
   if (found & TLVFLAG_LAN_NEIGHS)
@@ -1276,12 +1287,12 @@ process_lan_hello (int level, struct isis_circuit *circuit, const u_char *ssnpa)
           found = 1;
           break;
         }
-      if (found == 0)
+      if (found == 0 && !adj->gr_helping)
         isis_adj_state_change (adj, ISIS_ADJ_INITIALIZING,
                                "own SNPA not found in LAN Neighbours TLV");
     }
   }
-  else if (adj->adj_state == ISIS_ADJ_UP)
+  else if (adj->adj_state == ISIS_ADJ_UP && !adj->gr_helping)
   {
     isis_adj_state_change (adj, ISIS_ADJ_INITIALIZING,
                            "no LAN Neighbours TLV found");
@@ -1319,7 +1330,7 @@ process_lsp (int level, struct isis_circuit *circuit, const u_char *ssnpa)
   u_char lspid[ISIS_SYS_ID_LEN + 2];
   struct isis_passwd *passwd;
   uint16_t pdu_len;
-  int lsp_confusion;
+  int lsp_confusion, own_lsp;
 
   if (isis->debugs & DEBUG_UPDATE_PACKETS)
     {
@@ -1488,12 +1499,25 @@ process_lsp (int level, struct isis_circuit *circuit, const u_char *ssnpa)
     }
 
 dontcheckadj:
+  circuit->lsp_rxed[level - 1]++;
+  circuit->area->lsp_rxed[level - 1]++;
+  if (lsp && comp != LSP_NEWER)
+    {
+      circuit->lsp_redundant[level - 1]++;
+      circuit->area->lsp_redundant[level - 1]++;
+    }
+
   /* 7.3.15.1 a) 7 - Passwords for level 1 - not implemented  */
 
   /* 7.3.15.1 a) 8 - Passwords for level 2 - not implemented  */
 
   /* 7.3.15.1 a) 9 - OriginatingLSPBufferSize - not implemented  FIXME: do it */
 
+  /* While we restart, our LSPs the neighbours kept are stored as they
+   * are, until we originate them again, see isis_gr.h */
+  own_lsp = !memcmp (hdr->lsp_id, isis->sysid, ISIS_SYS_ID_LEN)
+    && !circuit->area->gr_restarting;
+
   /* 7.3.16.2 - If this is an LSP from another IS with identical seq_num but
    *            wrong checksum, initiate a purge. */
   if (lsp
@@ -1522,28 +1546,28 @@ dontcheckadj:
 	}
       else
 	{
-	  if (memcmp (hdr->lsp_id, isis->sysid, ISIS_SYS_ID_LEN))
+	  if (!own_lsp)
 	    {
 	      /* LSP by some other system -> do 7.3.16.4 b) */
 	      /* 7.3.16.4 b) 1)  */
 	      if (comp == LSP_NEWER)
 		{
                   lsp_update (lsp, circuit->rcv_stream, circuit->area, level);
-		  /* ii */
-                  lsp_set_all_srmflags (lsp);
+		  /* ii, iii */
+                  lsp_flood (lsp, circuit);
 		  /* v */
 		  ISIS_FLAGS_CLEAR_ALL (lsp->SSNflags);	/* FIXME: OTHER than c */
 
 		  /* For the case of lsp confusion, flood the purge back to its
 		   * originator so that it can react. Otherwise, don't reflood
 		   * through incoming circuit as usual */
-		  if (!lsp_confusion)
+		  if (lsp_confusion)
+		    lsp_srm_set (lsp, circuit);
+		  else
 		    {
-		      /* iii */
-		      ISIS_CLEAR_FLAG (lsp->SRMflags, circuit);
 		      /* iv */
 		      if (circuit->circ_type != CIRCUIT_T_BROADCAST)
-		        ISIS_SET_FLAG (lsp->SSNflags, circuit);
+		        lsp_ssn_set (lsp, circuit);
 		    }
 		}		/* 7.3.16.4 b) 2) */
 	      else if (comp == LSP_EQUAL)
@@ -1552,11 +1576,11 @@ dontcheckadj:
 		  ISIS_CLEAR_FLAG (lsp->SRMflags, circuit);
 		  /* ii */
 		  if (circuit->circ_type != CIRCUIT_T_BROADCAST)
-		    ISIS_SET_FLAG (lsp->SSNflags, circuit);
+		    lsp_ssn_set (lsp, circuit);
 		}		/* 7.3.16.4 b) 3) */
 	      else
 		{
-		  ISIS_SET_FLAG (lsp->SRMflags, circuit);
+		  lsp_srm_set (lsp, circuit);
 		  ISIS_CLEAR_FLAG (lsp->SSNflags, circuit);
 		}
 	    }
@@ -1570,7 +1594,7 @@ dontcheckadj:
                 }
               else
                 {
-                  ISIS_SET_FLAG (lsp->SRMflags, circuit);
+                  lsp_srm_set (lsp, circuit);
                   ISIS_CLEAR_FLAG (lsp->SSNflags, circuit);
                 }
               if (isis->debugs & DEBUG_UPDATE_PACKETS)
@@ -1584,7 +1608,7 @@ dontcheckadj:
     }
   /* 7.3.15.1 c) - If this is our own lsp and we don't have it initiate a 
    * purge */
-  if (memcmp (hdr->lsp_id, isis->sysid, ISIS_SYS_ID_LEN) == 0)
+  if (own_lsp)
     {
       if (!lsp)
 	{
@@ -1611,6 +1635,7 @@ dontcheckadj:
       /* If the received LSP is older or equal,
        * resend the LSP which will act as ACK */
       lsp_set_all_srmflags (lsp);
+      lsp_srm_set (lsp, circuit);
     }
   else
     {
@@ -1645,14 +1670,12 @@ dontcheckadj:
             {
               lsp_update (lsp, circuit->rcv_stream, circuit->area, level);
             }
-	  /* ii */
-          lsp_set_all_srmflags (lsp);
-	  /* iii */
-	  ISIS_CLEAR_FLAG (lsp->SRMflags, circuit);
+	  /* ii, iii */
+          lsp_flood (lsp, circuit);
 
 	  /* iv */
 	  if (circuit->circ_type != CIRCUIT_T_BROADCAST)
-	    ISIS_SET_FLAG (lsp->SSNflags, circuit);
+	    lsp_ssn_set (lsp, circuit);
 	  /* FIXME: v) */
 	}
       /* 7.3.15.1 e) 2) LSP equal to the one in db */
@@ -1661,12 +1684,12 @@ dontcheckadj:
 	  ISIS_CLEAR_FLAG (lsp->SRMflags, circuit);
 	  lsp_update (lsp, circuit->rcv_stream, circuit->area, level);
 	  if (circuit->circ_type != CIRCUIT_T_BROADCAST)
-	    ISIS_SET_FLAG (lsp->SSNflags, circuit);
+	    lsp_ssn_set (lsp, circuit);
 	}
       /* 7.3.15.1 e) 3) LSP older than the one in db */
       else
 	{
-	  ISIS_SET_FLAG (lsp->SRMflags, circuit);
+	  lsp_srm_set (lsp, circuit);
 	  ISIS_CLEAR_FLAG (lsp->SSNflags, circuit);
 	}
     }
@@ -1886,7 +1909,8 @@ process_snp (int snp_type, int level, struct isis_circuit *circuit,
       for (ALL_LIST_ELEMENTS_RO (tlvs.lsp_entries, node, entry))
       {
 	lsp = lsp_search (entry->lsp_id, circuit->area->lspdb[level - 1]);
-	own_lsp = !memcmp (entry->lsp_id, isis->sysid, ISIS_SYS_ID_LEN);
+	own_lsp = !memcmp (entry->lsp_id, isis->sysid, ISIS_SYS_ID_LEN)
+	  && !circuit->area->gr_restarting;
 	if (lsp)
 	  {
 	    /* 7.3.15.2 b) 1) is this LSP newer */
@@ -1902,7 +1926,7 @@ process_snp (int snp_type, int level, struct isis_circuit *circuit,
 	    else if (cmp == LSP_OLDER)
 	      {
 		ISIS_CLEAR_FLAG (lsp->SSNflags, circuit);
-		ISIS_SET_FLAG (lsp->SRMflags, circuit);
+		lsp_srm_set (lsp, circuit);
 	      }
 	    /* 7.3.15.2 b) 4) if it is newer, set SSN and clear SRM on p2p */
 	    else
@@ -1910,11 +1934,11 @@ process_snp (int snp_type, int level, struct isis_circuit *circuit,
 		if (own_lsp)
 		  {
 		    lsp_inc_seqnum (lsp, ntohl (entry->seq_num));
-		    ISIS_SET_FLAG (lsp->SRMflags, circuit);
+		    lsp_srm_set (lsp, circuit);
 		  }
 		else
 		  {
-		    ISIS_SET_FLAG (lsp->SSNflags, circuit);
+		    lsp_ssn_set (lsp, circuit);
 		    /* if (circuit->circ_type != CIRCUIT_T_BROADCAST) */
 		    ISIS_CLEAR_FLAG (lsp->SRMflags, circuit);
 		  }
@@ -1925,14 +1949,14 @@ process_snp (int snp_type, int level, struct isis_circuit *circuit,
 	    /* 7.3.15.2 b) 5) if it was not found, and all of those are not 0, 
 	     * insert it and set SSN on it */
 	    if (entry->rem_lifetime && entry->checksum && entry->seq_num &&
-		memcmp (entry->lsp_id, isis->sysid, ISIS_SYS_ID_LEN))
+		!own_lsp)
 	      {
 		lsp = lsp_new(circuit->area, entry->lsp_id,
 			      ntohs(entry->rem_lifetime),
 			      0, 0, entry->checksum, level);
 		lsp_insert (lsp, circuit->area->lspdb[level - 1]);
 		ISIS_FLAGS_CLEAR_ALL (lsp->SRMflags);
-		ISIS_SET_FLAG (lsp->SSNflags, circuit);
+		lsp_ssn_set (lsp, circuit);
 	      }
 	  }
       }
@@ -1966,10 +1990,12 @@ process_snp (int snp_type, int level, struct isis_circuit *circuit,
 	}
       /* on remaining LSPs we set SRM (neighbor knew not of) */
       for (ALL_LIST_ELEMENTS_RO (lsp_list, node, lsp))
-	ISIS_SET_FLAG (lsp->SRMflags, circuit);
+	lsp_srm_set (lsp, circuit);
       /* lets free it */
       list_delete (lsp_list);
 
+      isis_gr_csnp_received (circuit, level, chdr->stop_lsp_id);
+
     }
 
   free_tlvs (&tlvs);
@@ -2412,6 +2438,10 @@ send_hello (struct isis_circuit *circuit, int level)
       return ISIS_WARNING;
 #endif /* HAVE_IPV6 */
 
+  /* Restart TLV */
+  if (isis_gr_hello_tlv (circuit, level, circuit->snd_stream))
+    return ISIS_WARNING;
+
   if (circuit->pad_hellos)
     if (tlv_add_padding (circuit->snd_stream))
       return ISIS_WARNING;
@@ -2423,10 +2453,9 @@ send_hello (struct isis_circuit *circuit, int level)
   /* For HMAC MD5 we need to compute the md5 hash and store it */
   if (circuit->passwd.type == ISIS_PASSWD_TYPE_HMAC_MD5)
     {
-      hmac_md5 (STREAM_DATA (circuit->snd_stream),
-                stream_get_endp (circuit->snd_stream),
-                (unsigned char *) &circuit->passwd.passwd, circuit->passwd.len,
-                (unsigned char *) &hmac_md5_hash);
+      hmac_md5_digest (&circuit->passwd.hmac, STREAM_DATA (circuit->snd_stream),
+                       stream_get_endp (circuit->snd_stream),
+                       (unsigned char *) &hmac_md5_hash);
       /* Copy the hash into the stream */
       memcpy (STREAM_DATA (circuit->snd_stream) + auth_tlv_offset + 3,
               hmac_md5_hash, ISIS_AUTH_MD5_SIZE);
@@ -2538,9 +2567,13 @@ send_p2p_hello (struct thread *thread)
   return ISIS_OK;
 }
 
+/*
+ * The CSNPs do not depend on the circuit, they are built for the area
+ * in a stream of their own, see send_csnp().
+ */
 static int
 build_csnp (int level, u_char * start, u_char * stop, struct list *lsps,
-	    struct isis_circuit *circuit)
+	    struct isis_area *area, struct stream *stream)
 {
   struct isis_fixed_hdr fixed_hdr;
   struct isis_passwd *passwd;
@@ -2550,36 +2583,34 @@ build_csnp (int level, u_char * start, u_char * stop, struct list *lsps,
   unsigned long auth_tlv_offset = 0;
   int retval = ISIS_OK;
 
-  isis_circuit_stream(circuit, &circuit->snd_stream);
+  stream_reset (stream);
 
   if (level == IS_LEVEL_1)
-    fill_fixed_hdr_andstream (&fixed_hdr, L1_COMPLETE_SEQ_NUM,
-			      circuit->snd_stream);
+    fill_fixed_hdr_andstream (&fixed_hdr, L1_COMPLETE_SEQ_NUM, stream);
   else
-    fill_fixed_hdr_andstream (&fixed_hdr, L2_COMPLETE_SEQ_NUM,
-			      circuit->snd_stream);
+    fill_fixed_hdr_andstream (&fixed_hdr, L2_COMPLETE_SEQ_NUM, stream);
 
   /*
    * Fill Level 1 or 2 Complete Sequence Numbers header
    */
 
-  lenp = stream_get_endp (circuit->snd_stream);
-  stream_putw (circuit->snd_stream, 0);	/* PDU length - when we know it */
+  lenp = stream_get_endp (stream);
+  stream_putw (stream, 0);	/* PDU length - when we know it */
   /* no need to send the source here, it is always us if we csnp */
-  stream_put (circuit->snd_stream, isis->sysid, ISIS_SYS_ID_LEN);
+  stream_put (stream, isis->sysid, ISIS_SYS_ID_LEN);
   /* with zero circuit id - ref 9.10, 9.11 */
-  stream_putc (circuit->snd_stream, 0x00);
+  stream_putc (stream, 0x00);
 
-  stream_put (circuit->snd_stream, start, ISIS_SYS_ID_LEN + 2);
-  stream_put (circuit->snd_stream, stop, ISIS_SYS_ID_LEN + 2);
+  stream_put (stream, start, ISIS_SYS_ID_LEN + 2);
+  stream_put (stream, stop, ISIS_SYS_ID_LEN + 2);
 
   /*
    * And TLVs
    */
   if (level == IS_LEVEL_1)
-    passwd = &circuit->area->area_passwd;
+    passwd = &area->area_passwd;
   else
-    passwd = &circuit->area->domain_passwd;
+    passwd = &area->domain_passwd;
 
   if (CHECK_FLAG(passwd->snp_auth, SNP_AUTH_SEND))
   {
@@ -2588,17 +2619,17 @@ build_csnp (int level, u_char * start, u_char * stop, struct list *lsps,
       /* Cleartext */
       case ISIS_PASSWD_TYPE_CLEARTXT:
         if (tlv_add_authinfo (ISIS_PASSWD_TYPE_CLEARTXT, passwd->len,
-                              passwd->passwd, circuit->snd_stream))
+                              passwd->passwd, stream))
           return ISIS_WARNING;
         break;
 
         /* HMAC MD5 */
       case ISIS_PASSWD_TYPE_HMAC_MD5:
         /* Remember where TLV is written so we can later overwrite the MD5 hash */
-        auth_tlv_offset = stream_get_endp (circuit->snd_stream);
+        auth_tlv_offset = stream_get_endp (stream);
         memset(&hmac_md5_hash, 0, ISIS_AUTH_MD5_SIZE);
         if (tlv_add_authinfo (ISIS_PASSWD_TYPE_HMAC_MD5, ISIS_AUTH_MD5_SIZE,
-                              hmac_md5_hash, circuit->snd_stream))
+                              hmac_md5_hash, stream))
           return ISIS_WARNING;
         break;
 
@@ -2607,24 +2638,23 @@ build_csnp (int level, u_char * start, u_char * stop, struct list *lsps,
     }
   }
 
-  retval = tlv_add_lsp_entries (lsps, circuit->snd_stream);
+  retval = tlv_add_lsp_entries (lsps, stream);
   if (retval != ISIS_OK)
     return retval;
 
-  length = (u_int16_t) stream_get_endp (circuit->snd_stream);
+  length = (u_int16_t) stream_get_endp (stream);
   /* Update PU length */
-  stream_putw_at (circuit->snd_stream, lenp, length);
+  stream_putw_at (stream, lenp, length);
 
   /* For HMAC MD5 we need to compute the md5 hash and store it */
   if (CHECK_FLAG(passwd->snp_auth, SNP_AUTH_SEND) &&
       passwd->type == ISIS_PASSWD_TYPE_HMAC_MD5)
     {
-      hmac_md5 (STREAM_DATA (circuit->snd_stream),
-                stream_get_endp(circuit->snd_stream),
-                (unsigned char *) &passwd->passwd, passwd->len,
-                (unsigned char *) &hmac_md5_hash);
+      hmac_md5_digest (&passwd->hmac, STREAM_DATA (stream),
+                       stream_get_endp(stream),
+                       (unsigned char *) &hmac_md5_hash);
       /* Copy the hash into the stream */
-      memcpy (STREAM_DATA (circuit->snd_stream) + auth_tlv_offset + 3,
+      memcpy (STREAM_DATA (stream) + auth_tlv_offset + 3,
               hmac_md5_hash, ISIS_AUTH_MD5_SIZE);
     }
 
@@ -2713,39 +2743,151 @@ max_lsps_per_snp (int snp_type, int level, struct isis_circuit *circuit)
   return lsp_count;
 }
 
+static void
+csnp_frag_free (void *arg)
+{
+  struct isis_csnp_frag *frag = arg;
+
+  stream_free (frag->pdu);
+  XFREE (MTYPE_ISIS_CSNP, frag);
+}
+
+static int
+csnp_passwd_same (struct isis_passwd *p1, struct isis_passwd *p2)
+{
+  return (p1->type == p2->type && p1->snp_auth == p2->snp_auth
+          && p1->len == p2->len && memcmp (p1->passwd, p2->passwd,
+                                           p1->len) == 0);
+}
+
 /*
- * FIXME: support multiple CSNPs
+ * CSNP cache of the area for the level and number of LSP entries per
+ * CSNP, emptied when an LSP was added or removed, or when the System ID
+ * or the SNP authentication changed.
  */
+static struct isis_csnp_cache *
+csnp_cache_get (struct isis_area *area, int level, u_int16_t num_lsps)
+{
+  struct isis_csnp_cache *cache;
+  struct isis_passwd *passwd;
+  struct listnode *node;
 
-int
-send_csnp (struct isis_circuit *circuit, int level)
+  if (level == IS_LEVEL_1)
+    passwd = &area->area_passwd;
+  else
+    passwd = &area->domain_passwd;
+
+  if (area->csnp_cache[level - 1] == NULL)
+    area->csnp_cache[level - 1] = list_new ();
+
+  for (ALL_LIST_ELEMENTS_RO (area->csnp_cache[level - 1], node, cache))
+    if (cache->num_lsps == num_lsps)
+      break;
+
+  if (cache == NULL)
+    {
+      cache = XCALLOC (MTYPE_ISIS_CSNP, sizeof (struct isis_csnp_cache));
+      cache->num_lsps = num_lsps;
+      cache->frags = list_new ();
+      cache->frags->del = csnp_frag_free;
+      listnode_add (area->csnp_cache[level - 1], cache);
+    }
+  else if (cache->gen != area->lspdb[level - 1]->gen
+           || memcmp (cache->sysid, isis->sysid, ISIS_SYS_ID_LEN)
+           || !csnp_passwd_same (&cache->passwd, passwd))
+    list_delete_all_node (cache->frags);
+
+  if (list_isempty (cache->frags))
+    {
+      cache->gen = area->lspdb[level - 1]->gen;
+      memcpy (cache->sysid, isis->sysid, ISIS_SYS_ID_LEN);
+      memcpy (&cache->passwd, passwd, sizeof (struct isis_passwd));
+    }
+
+  return cache;
+}
+
+void
+isis_csnp_cache_flush (struct isis_area *area, int level)
+{
+  struct isis_csnp_cache *cache;
+  struct listnode *node;
+
+  if (area->csnp_cache[level - 1] == NULL)
+    return;
+
+  for (ALL_LIST_ELEMENTS_RO (area->csnp_cache[level - 1], node, cache))
+    {
+      list_delete (cache->frags);
+      XFREE (MTYPE_ISIS_CSNP, cache);
+    }
+  list_delete (area->csnp_cache[level - 1]);
+  area->csnp_cache[level - 1] = NULL;
+}
+
+/* Encode the LSPs of a CSNP fragment, lsps being those in its range */
+static int
+csnp_frag_build (struct isis_csnp_frag *frag, struct list *lsps,
+                 struct isis_area *area, int level)
+{
+  struct listnode *node;
+  struct isis_lsp *lsp;
+  int retval;
+
+  retval = build_csnp (level, frag->start, frag->stop, lsps, area,
+                       frag->pdu);
+  if (retval != ISIS_OK)
+    return retval;
+
+  frag->version = area->lspdb[level - 1]->version;
+  area->csnp_built[level - 1]++;
+
+  if (isis->debugs & DEBUG_SNP_PACKETS)
+    {
+      zlog_debug ("ISIS-Snp (%s): Built L%d CSNP %s, length %zd",
+                  area->area_tag, level, rawlspid_print (frag->start),
+                  stream_get_endp (frag->pdu));
+      for (ALL_LIST_ELEMENTS_RO (lsps, node, lsp))
+        {
+          zlog_debug ("ISIS-Snp (%s):         CSNP entry %s, seq 0x%08x,"
+                      " cksum 0x%04x, lifetime %us",
+                      area->area_tag,
+                      rawlspid_print (lsp->lsp_header->lsp_id),
+                      ntohl (lsp->lsp_header->seq_num),
+                      ntohs (lsp->lsp_header->checksum),
+                      ntohs (lsp->lsp_header->rem_lifetime));
+        }
+    }
+
+  return ISIS_OK;
+}
+
+/* Split the LSP database in CSNPs of num_lsps entries at most */
+static int
+csnp_cache_build (struct isis_csnp_cache *cache, struct isis_area *area,
+                  int level, size_t size)
 {
   u_char start[ISIS_SYS_ID_LEN + 2];
   u_char stop[ISIS_SYS_ID_LEN + 2];
+  struct isis_csnp_frag *frag;
   struct list *list = NULL;
   struct listnode *node;
   struct isis_lsp *lsp;
-  u_char num_lsps, loop = 1;
-  int i, retval = ISIS_OK;
-
-  if (circuit->area->lspdb[level - 1] == NULL ||
-      dict_count (circuit->area->lspdb[level - 1]) == 0)
-    return retval;
+  int i, loop = 1;
+  int retval = ISIS_OK;
 
   memset (start, 0x00, ISIS_SYS_ID_LEN + 2);
   memset (stop, 0xff, ISIS_SYS_ID_LEN + 2);
 
-  num_lsps = max_lsps_per_snp (ISIS_SNP_CSNP_FLAG, level, circuit);
-
   while (loop)
     {
       list = list_new ();
-      lsp_build_list (start, stop, num_lsps, list,
-                      circuit->area->lspdb[level - 1]);
+      lsp_build_list (start, stop, cache->num_lsps, list,
+                      area->lspdb[level - 1]);
       /*
        * Update the stop lsp_id before encoding this CSNP.
        */
-      if (listcount (list) < num_lsps)
+      if (listcount (list) < cache->num_lsps)
         {
           memset (stop, 0xff, ISIS_SYS_ID_LEN + 2);
         }
@@ -2756,44 +2898,16 @@ send_csnp (struct isis_circuit *circuit, int level)
           memcpy (stop, lsp->lsp_header->lsp_id, ISIS_SYS_ID_LEN + 2);
         }
 
-      retval = build_csnp (level, start, stop, list, circuit);
-      if (retval != ISIS_OK)
-        {
-          zlog_err ("ISIS-Snp (%s): Build L%d CSNP on %s failed",
-                    circuit->area->area_tag, level, circuit->interface->name);
-          list_delete (list);
-          return retval;
-        }
+      frag = XCALLOC (MTYPE_ISIS_CSNP, sizeof (struct isis_csnp_frag));
+      memcpy (frag->start, start, ISIS_SYS_ID_LEN + 2);
+      memcpy (frag->stop, stop, ISIS_SYS_ID_LEN + 2);
+      frag->pdu = stream_new (size);
+      listnode_add (cache->frags, frag);
 
-      if (isis->debugs & DEBUG_SNP_PACKETS)
-        {
-          zlog_debug ("ISIS-Snp (%s): Sending L%d CSNP on %s, length %zd",
-                      circuit->area->area_tag, level, circuit->interface->name,
-                      stream_get_endp (circuit->snd_stream));
-          for (ALL_LIST_ELEMENTS_RO (list, node, lsp))
-            {
-              zlog_debug ("ISIS-Snp (%s):         CSNP entry %s, seq 0x%08x,"
-                          " cksum 0x%04x, lifetime %us",
-                          circuit->area->area_tag,
-                          rawlspid_print (lsp->lsp_header->lsp_id),
-                          ntohl (lsp->lsp_header->seq_num),
-                          ntohs (lsp->lsp_header->checksum),
-                          ntohs (lsp->lsp_header->rem_lifetime));
-            }
-          if (isis->debugs & DEBUG_PACKET_DUMP)
-            zlog_dump_data (STREAM_DATA (circuit->snd_stream),
-                            stream_get_endp (circuit->snd_stream));
-        }
-
-      retval = circuit->tx (circuit, level);
+      retval = csnp_frag_build (frag, list, area, level);
+      list_delete (list);
       if (retval != ISIS_OK)
-        {
-          zlog_err ("ISIS-Snp (%s): Send L%d CSNP on %s failed",
-                    circuit->area->area_tag, level,
-                    circuit->interface->name);
-          list_delete (list);
-          return retval;
-        }
+        return retval;
 
       /*
        * Start lsp_id of the next CSNP should be one plus the
@@ -2811,7 +2925,83 @@ send_csnp (struct isis_circuit *circuit, int level)
             }
         }
       memset (stop, 0xff, ISIS_SYS_ID_LEN + 2);
-      list_delete (list);
+    }
+
+  return retval;
+}
+
+int
+send_csnp (struct isis_circuit *circuit, int level)
+{
+  struct isis_area *area = circuit->area;
+  struct lspdb *lspdb = area->lspdb[level - 1];
+  struct isis_csnp_cache *cache;
+  struct isis_csnp_frag *frag;
+  struct list *list;
+  struct listnode *node;
+  u_int16_t num_lsps;
+  int retval = ISIS_OK;
+
+  if (lspdb == NULL || lspdb_count (lspdb) == 0)
+    return retval;
+
+  isis_circuit_stream (circuit, &circuit->snd_stream);
+  num_lsps = max_lsps_per_snp (ISIS_SNP_CSNP_FLAG, level, circuit);
+  cache = csnp_cache_get (area, level, num_lsps);
+
+  /* Rebuild the fragments whose entries changed since the last time */
+  if (list_isempty (cache->frags))
+    retval = csnp_cache_build (cache, area, level,
+                               stream_get_size (circuit->snd_stream));
+  else
+    for (ALL_LIST_ELEMENTS_RO (cache->frags, node, frag))
+      {
+        if (!lspdb_changed (lspdb, frag->version, frag->start, frag->stop))
+          {
+            area->csnp_reused[level - 1]++;
+            continue;
+          }
+        list = list_new ();
+        lsp_build_list (frag->start, frag->stop, num_lsps, list, lspdb);
+        retval = csnp_frag_build (frag, list, area, level);
+        list_delete (list);
+        if (retval != ISIS_OK)
+          break;
+      }
+
+  if (retval != ISIS_OK)
+    {
+      zlog_err ("ISIS-Snp (%s): Build L%d CSNP on %s failed",
+                area->area_tag, level, circuit->interface->name);
+      list_delete_all_node (cache->frags);
+      return retval;
+    }
+
+  for (ALL_LIST_ELEMENTS_RO (cache->frags, node, frag))
+    {
+      stream_reset (circuit->snd_stream);
+      stream_put (circuit->snd_stream, STREAM_DATA (frag->pdu),
+                  stream_get_endp (frag->pdu));
+
+      if (isis->debugs & DEBUG_SNP_PACKETS)
+        {
+          zlog_debug ("ISIS-Snp (%s): Sending L%d CSNP on %s, length %zd",
+                      area->area_tag, level, circuit->interface->name,
+                      stream_get_endp (circuit->snd_stream));
+          if (isis->debugs & DEBUG_PACKET_DUMP)
+            zlog_dump_data (STREAM_DATA (circuit->snd_stream),
+                            stream_get_endp (circuit->snd_stream));
+        }
+
+      retval = circuit->tx (circuit, level);
+      if (retval != ISIS_OK)
+        {
+          zlog_err ("ISIS-Snp (%s): Send L%d CSNP on %s failed",
+                    area->area_tag, level, circuit->interface->name);
+          return retval;
+        }
+      circuit->csnp_sent[level - 1]++;
+      circuit->csnp_bytes[level - 1] += stream_get_endp (frag->pdu);
     }
 
   return retval;
@@ -2828,7 +3018,8 @@ send_l1_csnp (struct thread *thread)
 
   circuit->t_send_csnp[0] = NULL;
 
-  if (circuit->circ_type == CIRCUIT_T_BROADCAST && circuit->u.bc.is_dr[0])
+  if ((circuit->circ_type == CIRCUIT_T_BROADCAST && circuit->u.bc.is_dr[0])
+      || isis_flood_reduced (circuit, 1))
     {
       send_csnp (circuit, 1);
     }
@@ -2850,7 +3041,8 @@ send_l2_csnp (struct thread *thread)
 
   circuit->t_send_csnp[1] = NULL;
 
-  if (circuit->circ_type == CIRCUIT_T_BROADCAST && circuit->u.bc.is_dr[1])
+  if ((circuit->circ_type == CIRCUIT_T_BROADCAST && circuit->u.bc.is_dr[1])
+      || isis_flood_reduced (circuit, 2))
     {
       send_csnp (circuit, 2);
     }
@@ -2952,10 +3144,9 @@ build_psnp (int level, struct isis_circuit *circuit, struct list *lsps)
   if (CHECK_FLAG(passwd->snp_auth, SNP_AUTH_SEND) &&
       passwd->type == ISIS_PASSWD_TYPE_HMAC_MD5)
     {
-      hmac_md5 (STREAM_DATA (circuit->snd_stream),
-                stream_get_endp(circuit->snd_stream),
-                (unsigned char *) &passwd->passwd, passwd->len,
-                (unsigned char *) &hmac_md5_hash);
+      hmac_md5_digest (&passwd->hmac, STREAM_DATA (circuit->snd_stream),
+                       stream_get_endp(circuit->snd_stream),
+                       (unsigned char *) &hmac_md5_hash);
       /* Copy the hash into the stream */
       memcpy (STREAM_DATA (circuit->snd_stream) + auth_tlv_offset + 3,
               hmac_md5_hash, ISIS_AUTH_MD5_SIZE);
@@ -2971,18 +3162,23 @@ build_psnp (int level, struct isis_circuit *circuit, struct list *lsps)
 static int
 send_psnp (int level, struct isis_circuit *circuit)
 {
-  struct isis_lsp *lsp;
   struct list *list = NULL;
-  struct listnode *node;
-  u_char num_lsps;
+  u_int16_t num_lsps;
   int retval = ISIS_OK;
 
+  if (circuit->ssn_queue[level - 1] == NULL)
+    return ISIS_OK;
+
+  /* The CSNPs of the DIS acknowledge and request for it */
   if (circuit->circ_type == CIRCUIT_T_BROADCAST &&
       circuit->u.bc.is_dr[level - 1])
-    return ISIS_OK;
+    {
+      lsp_ssn_flush (circuit, level);
+      return ISIS_OK;
+    }
 
   if (circuit->area->lspdb[level - 1] == NULL ||
-      dict_count (circuit->area->lspdb[level - 1]) == 0)
+      lspdb_count (circuit->area->lspdb[level - 1]) == 0)
     return ISIS_OK;
 
   if (! circuit->snd_stream)
@@ -2993,8 +3189,7 @@ send_psnp (int level, struct isis_circuit *circuit)
   while (1)
     {
       list = list_new ();
-      lsp_build_list_ssn (circuit, num_lsps, list,
-                          circuit->area->lspdb[level - 1]);
+      lsp_build_list_ssn (circuit, level, num_lsps, list);
 
       if (listcount (list) == 0)
         {
@@ -3032,12 +3227,15 @@ send_psnp (int level, struct isis_circuit *circuit)
           return retval;
         }
 
+      circuit->psnp_sent[level - 1]++;
+      circuit->psnp_bytes[level - 1] += stream_get_endp (circuit->snd_stream);
+      circuit->psnp_entries[level - 1] += listcount (list);
+
       /*
        * sending succeeded, we can clear SSN flags of this circuit
        * for the LSPs in list
        */
-      for (ALL_LIST_ELEMENTS_RO (list, node, lsp))
-        ISIS_CLEAR_FLAG (lsp->SSNflags, circuit);
+      lsp_ssn_sent (circuit, level, list);
       list_delete (list);
     }
 
@@ -3088,47 +3286,72 @@ send_l2_psnp (struct thread *thread)
   return retval;
 }
 
-/*
- * ISO 10589 - 7.3.14.3
- */
-int
-send_lsp (struct thread *thread)
+static int
+send_l1_psnp_batch (struct thread *thread)
 {
   struct isis_circuit *circuit;
-  struct isis_lsp *lsp;
-  struct listnode *node;
-  int clear_srm = 1;
-  int retval = ISIS_OK;
 
   circuit = THREAD_ARG (thread);
   assert (circuit);
 
-  if (!circuit->lsp_queue)
-    return ISIS_OK;
+  circuit->t_psnp_batch[0] = NULL;
+  send_psnp (1, circuit);
+
+  return ISIS_OK;
+}
 
-  node = listhead (circuit->lsp_queue);
+static int
+send_l2_psnp_batch (struct thread *thread)
+{
+  struct isis_circuit *circuit;
 
-  /*
-   * Handle case where there are no LSPs on the queue. This can
-   * happen, for instance, if an adjacency goes down before this
-   * thread gets a chance to run.
-   */
-  if (!node)
-    return ISIS_OK;
+  circuit = THREAD_ARG (thread);
+  assert (circuit);
 
-  /*
-   * Delete LSP from lsp_queue. If it's still in queue, it is assumed
-   * as 'transmit pending', but send_lsp may never be called again.
-   * Retry will happen because SRM flag will not be cleared.
-   */
-  lsp = listgetdata(node);
-  list_delete_node (circuit->lsp_queue, node);
+  circuit->t_psnp_batch[1] = NULL;
+  send_psnp (2, circuit);
+
+  return ISIS_OK;
+}
+
+/*
+ * An LSP was queued for acknowledgement or request on the circuit:
+ * send the queue once it fills a PSNP, or PSNP_BATCH_DELAY after its
+ * first entry, rather than waiting for the partial SNP interval.
+ */
+void
+isis_psnp_schedule (struct isis_circuit *circuit, int level)
+{
+  long delay = PSNP_BATCH_DELAY;
+
+  if (circuit->snd_stream == NULL)
+    return;
+
+  if (listcount (circuit->ssn_queue[level - 1])
+      >= max_lsps_per_snp (ISIS_SNP_PSNP_FLAG, level, circuit))
+    {
+      THREAD_OFF (circuit->t_psnp_batch[level - 1]);
+      delay = 0;
+    }
+  else if (circuit->t_psnp_batch[level - 1])
+    return;
 
-  /* Set the last-cleared time if the queue is empty. */
-  /* TODO: Is is possible that new lsps keep being added to the queue
-   * that the queue is never empty? */
-  if (list_isempty (circuit->lsp_queue))
-    circuit->lsp_queue_last_cleared = time (NULL);
+  if (level == IS_LEVEL_1)
+    THREAD_TIMER_MSEC_ON (master, circuit->t_psnp_batch[0],
+                          send_l1_psnp_batch, circuit, delay);
+  else
+    THREAD_TIMER_MSEC_ON (master, circuit->t_psnp_batch[1],
+                          send_l2_psnp_batch, circuit, delay);
+}
+
+/*
+ * ISO 10589 - 7.3.14.3
+ */
+static int
+send_lsp_one (struct isis_circuit *circuit, struct isis_lsp *lsp)
+{
+  int clear_srm = 1;
+  int retval = ISIS_OK;
 
   if (circuit->state != C_STATE_UP || circuit->is_passive == 1)
     goto out;
@@ -3167,6 +3390,7 @@ send_lsp (struct thread *thread)
     }
 
   /* copy our lsp to the send buffer */
+  lsp_set_time (lsp);
   stream_copy (circuit->snd_stream, lsp->pdu);
 
   if (isis->debugs & DEBUG_UPDATE_PACKETS)
@@ -3207,10 +3431,51 @@ out:
        */
       ISIS_CLEAR_FLAG (lsp->SRMflags, circuit);
     }
+  else
+    lsp_srm_retransmit (lsp, circuit);
 
   return retval;
 }
 
+/*
+ * Drain the circuit lsp_queue, LSP_TX_BURST LSPs at a time
+ */
+int
+send_lsp (struct thread *thread)
+{
+  struct isis_circuit *circuit;
+  struct isis_lsp *lsp;
+  struct listnode *node;
+  int sent = 0;
+
+  circuit = THREAD_ARG (thread);
+  assert (circuit);
+  circuit->t_send_lsp = NULL;
+
+  if (!circuit->lsp_queue)
+    return ISIS_OK;
+
+  while (sent < LSP_TX_BURST && (node = listhead (circuit->lsp_queue)))
+    {
+      lsp = listgetdata (node);
+      list_delete_node (circuit->lsp_queue, node);
+      ISIS_CLEAR_FLAG (lsp->SRMqueued, circuit);
+
+      /* Acknowledged or superseded since queued */
+      if (!ISIS_CHECK_FLAG (lsp->SRMflags, circuit))
+        continue;
+
+      send_lsp_one (circuit, lsp);
+      sent++;
+    }
+
+  if (!list_isempty (circuit->lsp_queue))
+    THREAD_TIMER_MSEC_ON (master, circuit->t_send_lsp, send_lsp, circuit,
+                          LSP_TX_PACING_MSEC);
+
+  return ISIS_OK;
+}
+
 int
 ack_lsp (struct isis_link_state_hdr *hdr, struct isis_circuit *circuit,
 	 int level)
@@ -3252,6 +3517,12 @@ ack_lsp (struct isis_link_state_hdr *hdr, struct isis_circuit *circuit,
     zlog_err ("ISIS-Upd (%s): Send L%d LSP PSNP on %s failed",
               circuit->area->area_tag, level,
               circuit->interface->name);
+  else
+    {
+      circuit->psnp_sent[level - 1]++;
+      circuit->psnp_bytes[level - 1] += length;
+      circuit->psnp_entries[level - 1]++;
+    }
 
   return retval;
 }
@@ -244,6 +244,8 @@ struct isis_partial_seqnum_hdr
 /*
  * Function for receiving IS-IS PDUs
  */
+struct isis_area;
+
 int isis_receive (struct thread *thread);
 
 /*
@@ -254,6 +256,29 @@ int isis_receive (struct thread *thread);
 
 #define ISIS_AUTH_MD5_SIZE       16U
 
+/*
+ * CSNPs built for a level of an area, reused by all of its circuits
+ * with the same number of LSP entries per CSNP. Each fragment is
+ * rebuilt once an LSP entry in its range changed, see lspdb_changed(),
+ * and all of them once an LSP was added or removed.
+ */
+struct isis_csnp_frag
+{
+  u_char start[ISIS_SYS_ID_LEN + 2];
+  u_char stop[ISIS_SYS_ID_LEN + 2];
+  unsigned int version;		/* lspdb version when built */
+  struct stream *pdu;
+};
+
+struct isis_csnp_cache
+{
+  u_int16_t num_lsps;
+  unsigned int gen;		/* lspdb gen when built */
+  u_char sysid[ISIS_SYS_ID_LEN];
+  struct isis_passwd passwd;
+  struct list *frags;
+};
+
 /*
  * Sending functions
  */
@@ -265,10 +290,12 @@ int send_l1_csnp (struct thread *thread);
 int send_l2_csnp (struct thread *thread);
 int send_l1_psnp (struct thread *thread);
 int send_l2_psnp (struct thread *thread);
+void isis_psnp_schedule (struct isis_circuit *circuit, int level);
 int send_lsp (struct thread *thread);
 int ack_lsp (struct isis_link_state_hdr *hdr,
 	     struct isis_circuit *circuit, int level);
 void fill_fixed_hdr (struct isis_fixed_hdr *hdr, u_char pdu_type);
+void isis_csnp_cache_flush (struct isis_area *area, int level);
 int send_hello (struct isis_circuit *circuit, int level);
 
 #endif /* _ZEBRA_ISIS_PDU_H */
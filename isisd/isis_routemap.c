@@ -37,7 +37,7 @@
 #include "isis_constants.h"
 #include "isis_common.h"
 #include "isis_flags.h"
-#include "dict.h"
+#include "isis_lspdb.h"
 #include "isisd.h"
 #include "isis_misc.h"
 #include "isis_adjacency.h"
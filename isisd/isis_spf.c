@@ -37,7 +37,7 @@
 #include "isis_constants.h"
 #include "isis_common.h"
 #include "isis_flags.h"
-#include "dict.h"
+#include "isis_lspdb.h"
 #include "isisd.h"
 #include "isis_misc.h"
 #include "isis_adjacency.h"
@@ -49,6 +49,7 @@
 #include "isis_spf.h"
 #include "isis_route.h"
 #include "isis_csm.h"
+#include "isis_flood.h"
 
 int isis_run_spf_l1 (struct thread *thread);
 int isis_run_spf_l2 (struct thread *thread);
@@ -273,6 +274,7 @@ isis_spftree_new (struct isis_area *area)
   tree->last_run_duration = 0;
   tree->runcount = 0;
   tree->pending = 0;
+  tree->full = 1;
   return tree;
 }
 
@@ -300,6 +302,8 @@ isis_spftree_adj_del (struct isis_spftree *spftree, struct isis_adjacency *adj)
   struct listnode *node;
   if (!adj)
     return;
+  /* The SPT no longer holds for a partial route calculation */
+  spftree->full = 1;
   for (node = listhead (spftree->tents); node; node = listnextnode (node))
     isis_vertex_adj_del (listgetdata (node), adj);
   for (node = listhead (spftree->paths); node; node = listnextnode (node))
@@ -492,6 +496,39 @@ isis_find_vertex (struct list *list, void *id, enum vertextype vtype)
   return NULL;
 }
 
+/*
+ * Both address families can share the topology as long as each system
+ * and circuit on the way carries both of them, or neither: note when
+ * one does not.
+ */
+static int
+spf_speaks (struct isis_spftree *spftree, struct nlpids *nlpids, int family)
+{
+  int ipv4 = speaks (nlpids, AF_INET);
+#ifdef HAVE_IPV6
+  int ipv6 = speaks (nlpids, AF_INET6);
+
+  if (ipv4 != ipv6)
+    spftree->split = 1;
+  if (family == AF_INET6)
+    return ipv6;
+#endif /* HAVE_IPV6 */
+  return ipv4;
+}
+
+static int
+spf_circuit_routes (struct isis_spftree *spftree,
+                    struct isis_circuit *circuit, int family)
+{
+#ifdef HAVE_IPV6
+  if (!circuit->ip_router != !circuit->ipv6_router)
+    spftree->split = 1;
+  if (family == AF_INET6)
+    return circuit->ipv6_router;
+#endif /* HAVE_IPV6 */
+  return circuit->ip_router;
+}
+
 /*
  * Add a vertex to TENT sorted by cost and by vertextype on tie break situation
  */
@@ -703,14 +740,17 @@ process_N (struct isis_spftree *spftree, enum vertextype vtype, void *id,
 }
 
 /*
- * C.2.6 Step 1
+ * C.2.6 Step 1, on the IS neighbours of the LSP for the topology, or on
+ * its prefixes once the topology is known
  */
 static int
 isis_spf_process_lsp (struct isis_spftree *spftree, struct isis_lsp *lsp,
 		      uint32_t cost, uint16_t depth, int family,
-		      u_char *root_sysid, struct isis_vertex *parent)
+		      u_char *root_sysid, struct isis_vertex *parent,
+		      int prefixes)
 {
-  struct listnode *node, *fragnode = NULL;
+  struct listnode *fragnode = NULL;
+  struct tlv_iter iter;
   uint32_t dist;
   struct is_neigh *is_neigh;
   struct te_is_neigh *te_is_neigh;
@@ -723,7 +763,7 @@ isis_spf_process_lsp (struct isis_spftree *spftree, struct isis_lsp *lsp,
 #endif /* HAVE_IPV6 */
   static const u_char null_sysid[ISIS_SYS_ID_LEN];
 
-  if (!speaks (lsp->tlv_data.nlpids, family))
+  if (!spf_speaks (spftree, lsp->tlv_data.nlpids, family))
     return ISIS_OK;
 
 lspfragloop:
@@ -737,29 +777,24 @@ lspfragloop:
       zlog_debug ("ISIS-Spf: process_lsp %s", print_sys_hostname(lsp->lsp_header->lsp_id));
 #endif /* EXTREME_DEBUG */
 
-  if (!ISIS_MASK_LSP_OL_BIT (lsp->lsp_header->lsp_bits))
+  if (!prefixes && !ISIS_MASK_LSP_OL_BIT (lsp->lsp_header->lsp_bits))
   {
-    if (lsp->tlv_data.is_neighs)
+    LSP_TLV_FOREACH (lsp, IS_NEIGHBOURS, iter, is_neigh)
     {
-      for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.is_neighs, node, is_neigh))
-      {
-        /* C.2.6 a) */
-        /* Two way connectivity */
-        if (!memcmp (is_neigh->neigh_id, root_sysid, ISIS_SYS_ID_LEN))
-          continue;
-        if (!memcmp (is_neigh->neigh_id, null_sysid, ISIS_SYS_ID_LEN))
-          continue;
-        dist = cost + is_neigh->metrics.metric_default;
-        vtype = LSP_PSEUDO_ID (is_neigh->neigh_id) ? VTYPE_PSEUDO_IS
-          : VTYPE_NONPSEUDO_IS;
-        process_N (spftree, vtype, (void *) is_neigh->neigh_id, dist,
-            depth + 1, family, parent);
-      }
+      /* C.2.6 a) */
+      /* Two way connectivity */
+      if (!memcmp (is_neigh->neigh_id, root_sysid, ISIS_SYS_ID_LEN))
+        continue;
+      if (!memcmp (is_neigh->neigh_id, null_sysid, ISIS_SYS_ID_LEN))
+        continue;
+      dist = cost + is_neigh->metrics.metric_default;
+      vtype = LSP_PSEUDO_ID (is_neigh->neigh_id) ? VTYPE_PSEUDO_IS
+        : VTYPE_NONPSEUDO_IS;
+      process_N (spftree, vtype, (void *) is_neigh->neigh_id, dist,
+          depth + 1, family, parent);
     }
-    if (lsp->tlv_data.te_is_neighs)
-    {
-      for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.te_is_neighs, node,
-            te_is_neigh))
+    if (spftree->area->newmetric)
+      LSP_TLV_FOREACH (lsp, TE_IS_NEIGHBOURS, iter, te_is_neigh)
       {
         if (!memcmp (te_is_neigh->neigh_id, root_sysid, ISIS_SYS_ID_LEN))
           continue;
@@ -771,13 +806,12 @@ lspfragloop:
         process_N (spftree, vtype, (void *) te_is_neigh->neigh_id, dist,
             depth + 1, family, parent);
       }
-    }
   }
 
-  if (family == AF_INET && lsp->tlv_data.ipv4_int_reachs)
+  if (prefixes && family == AF_INET)
   {
     prefix.family = AF_INET;
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.ipv4_int_reachs, node, ipreach))
+    LSP_TLV_FOREACH (lsp, IPV4_INT_REACHABILITY, iter, ipreach)
     {
       dist = cost + ipreach->metrics.metric_default;
       vtype = VTYPE_IPREACH_INTERNAL;
@@ -787,11 +821,7 @@ lspfragloop:
       process_N (spftree, vtype, (void *) &prefix, dist, depth + 1,
                  family, parent);
     }
-  }
-  if (family == AF_INET && lsp->tlv_data.ipv4_ext_reachs)
-  {
-    prefix.family = AF_INET;
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.ipv4_ext_reachs, node, ipreach))
+    LSP_TLV_FOREACH (lsp, IPV4_EXT_REACHABILITY, iter, ipreach)
     {
       dist = cost + ipreach->metrics.metric_default;
       vtype = VTYPE_IPREACH_EXTERNAL;
@@ -801,33 +831,25 @@ lspfragloop:
       process_N (spftree, vtype, (void *) &prefix, dist, depth + 1,
                  family, parent);
     }
-  }
-  if (family == AF_INET && lsp->tlv_data.te_ipv4_reachs)
-  {
-    prefix.family = AF_INET;
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.te_ipv4_reachs,
-                               node, te_ipv4_reach))
-    {
-      assert ((te_ipv4_reach->control & 0x3F) <= IPV4_MAX_BITLEN);
-
-      dist = cost + ntohl (te_ipv4_reach->te_metric);
-      vtype = VTYPE_IPREACH_TE;
-      prefix.u.prefix4 = newprefix2inaddr (&te_ipv4_reach->prefix_start,
-                                           te_ipv4_reach->control);
-      prefix.prefixlen = (te_ipv4_reach->control & 0x3F);
-      apply_mask (&prefix);
-      process_N (spftree, vtype, (void *) &prefix, dist, depth + 1,
-                 family, parent);
-    }
+    if (spftree->area->newmetric)
+      LSP_TLV_FOREACH (lsp, TE_IPV4_REACHABILITY, iter, te_ipv4_reach)
+      {
+        dist = cost + ntohl (te_ipv4_reach->te_metric);
+        vtype = VTYPE_IPREACH_TE;
+        prefix.u.prefix4 = newprefix2inaddr (&te_ipv4_reach->prefix_start,
+                                             te_ipv4_reach->control);
+        prefix.prefixlen = (te_ipv4_reach->control & 0x3F);
+        apply_mask (&prefix);
+        process_N (spftree, vtype, (void *) &prefix, dist, depth + 1,
+                   family, parent);
+      }
   }
 #ifdef HAVE_IPV6
-  if (family == AF_INET6 && lsp->tlv_data.ipv6_reachs)
+  if (prefixes && family == AF_INET6)
   {
     prefix.family = AF_INET6;
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.ipv6_reachs, node, ip6reach))
+    LSP_TLV_FOREACH (lsp, IPV6_REACHABILITY, iter, ip6reach)
     {
-      assert (ip6reach->prefix_len <= IPV6_MAX_BITLEN);
-
       dist = cost + ntohl(ip6reach->metric);
       vtype = (ip6reach->control_info & CTRL_INFO_DISTRIBUTION) ?
         VTYPE_IP6REACH_EXTERNAL : VTYPE_IP6REACH_INTERNAL;
@@ -862,7 +884,8 @@ isis_spf_process_pseudo_lsp (struct isis_spftree *spftree,
 			     u_char *root_sysid,
 			     struct isis_vertex *parent)
 {
-  struct listnode *node, *fragnode = NULL;
+  struct listnode *fragnode = NULL;
+  struct tlv_iter iter;
   struct is_neigh *is_neigh;
   struct te_is_neigh *te_is_neigh;
   enum vertextype vtype;
@@ -884,24 +907,23 @@ pseudofragloop:
 
   /* RFC3787 section 4 SHOULD ignore overload bit in pseudo LSPs */
 
-  if (lsp->tlv_data.is_neighs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.is_neighs, node, is_neigh))
-      {
-	/* Two way connectivity */
-	if (!memcmp (is_neigh->neigh_id, root_sysid, ISIS_SYS_ID_LEN))
-	  continue;
-        dist = cost + is_neigh->metrics.metric_default;
-        vtype = LSP_PSEUDO_ID (is_neigh->neigh_id) ? VTYPE_PSEUDO_IS
-          : VTYPE_NONPSEUDO_IS;
-        process_N (spftree, vtype, (void *) is_neigh->neigh_id, dist,
-            depth + 1, family, parent);
-      }
-  if (lsp->tlv_data.te_is_neighs)
-    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.te_is_neighs, node, te_is_neigh))
+  LSP_TLV_FOREACH (lsp, IS_NEIGHBOURS, iter, is_neigh)
+    {
+      /* Two way connectivity */
+      if (!memcmp (is_neigh->neigh_id, root_sysid, ISIS_SYS_ID_LEN))
+        continue;
+      dist = cost + is_neigh->metrics.metric_default;
+      vtype = LSP_PSEUDO_ID (is_neigh->neigh_id) ? VTYPE_PSEUDO_IS
+        : VTYPE_NONPSEUDO_IS;
+      process_N (spftree, vtype, (void *) is_neigh->neigh_id, dist,
+          depth + 1, family, parent);
+    }
+  if (spftree->area->newmetric)
+    LSP_TLV_FOREACH (lsp, TE_IS_NEIGHBOURS, iter, te_is_neigh)
       {
-	/* Two way connectivity */
-	if (!memcmp (te_is_neigh->neigh_id, root_sysid, ISIS_SYS_ID_LEN))
-	  continue;
+        /* Two way connectivity */
+        if (!memcmp (te_is_neigh->neigh_id, root_sysid, ISIS_SYS_ID_LEN))
+          continue;
         dist = cost + GET_TE_METRIC(te_is_neigh);
         vtype = LSP_PSEUDO_ID (te_is_neigh->neigh_id) ? VTYPE_PSEUDO_TE_IS
           : VTYPE_NONPSEUDO_TE_IS;
@@ -923,22 +945,17 @@ pseudofragloop:
   return ISIS_OK;
 }
 
-static int
-isis_spf_preload_tent (struct isis_spftree *spftree, int level,
-		       int family, u_char *root_sysid,
-		       struct isis_vertex *parent)
+/*
+ * Add IP(v6) addresses of our circuits
+ */
+static void
+isis_spf_preload_prefixes (struct isis_spftree *spftree, int level,
+			   int family, struct isis_vertex *parent)
 {
   struct isis_circuit *circuit;
-  struct listnode *cnode, *anode, *ipnode;
-  struct isis_adjacency *adj;
-  struct isis_lsp *lsp;
-  struct list *adj_list;
-  struct list *adjdb;
+  struct listnode *cnode, *ipnode;
   struct prefix_ipv4 *ipv4;
   struct prefix prefix;
-  int retval = ISIS_OK;
-  u_char lsp_id[ISIS_SYS_ID_LEN + 2];
-  static u_char null_lsp_id[ISIS_SYS_ID_LEN + 2];
 #ifdef HAVE_IPV6
   struct prefix_ipv6 *ipv6;
 #endif /* HAVE_IPV6 */
@@ -955,9 +972,6 @@ isis_spf_preload_tent (struct isis_spftree *spftree, int level,
       if (family == AF_INET6 && !circuit->ipv6_router)
 	continue;
 #endif /* HAVE_IPV6 */
-      /* 
-       * Add IP(v6) addresses of this circuit
-       */
       if (family == AF_INET)
 	{
 	  prefix.family = AF_INET;
@@ -984,6 +998,35 @@ isis_spf_preload_tent (struct isis_spftree *spftree, int level,
 	    }
 	}
 #endif /* HAVE_IPV6 */
+    }
+}
+
+/*
+ * Add the adjacencies of our circuits, and the pseudonodes we reach
+ */
+static int
+isis_spf_preload_tent (struct isis_spftree *spftree, int level,
+		       int family, u_char *root_sysid,
+		       struct isis_vertex *parent)
+{
+  struct isis_circuit *circuit;
+  struct listnode *cnode, *anode;
+  struct isis_adjacency *adj;
+  struct isis_lsp *lsp;
+  struct list *adj_list;
+  struct list *adjdb;
+  int retval = ISIS_OK;
+  u_char lsp_id[ISIS_SYS_ID_LEN + 2];
+  static u_char null_lsp_id[ISIS_SYS_ID_LEN + 2];
+
+  for (ALL_LIST_ELEMENTS_RO (spftree->area->circuit_list, cnode, circuit))
+    {
+      if (circuit->state != C_STATE_UP)
+	continue;
+      if (!(circuit->is_type & level))
+	continue;
+      if (!spf_circuit_routes (spftree, circuit, family))
+	continue;
       if (circuit->circ_type == CIRCUIT_T_BROADCAST)
 	{
 	  /*
@@ -1002,7 +1045,7 @@ isis_spf_preload_tent (struct isis_spftree *spftree, int level,
 	    }
           for (ALL_LIST_ELEMENTS_RO (adj_list, anode, adj))
 	    {
-	      if (!speaks (&adj->nlpids, family))
+	      if (!spf_speaks (spftree, &adj->nlpids, family))
 		  continue;
 	      switch (adj->sys_type)
 		{
@@ -1090,7 +1133,7 @@ isis_spf_preload_tent (struct isis_spftree *spftree, int level,
 	    case ISIS_SYSTYPE_IS:
 	    case ISIS_SYSTYPE_L1_IS:
 	    case ISIS_SYSTYPE_L2_IS:
-	      if (speaks (&adj->nlpids, family))
+	      if (spf_speaks (spftree, &adj->nlpids, family))
 		isis_spf_add_local (spftree,
 				    spftree->area->oldmetric ?
                                     VTYPE_NONPSEUDO_IS :
@@ -1164,48 +1207,26 @@ init_spt (struct isis_spftree *spftree)
   return;
 }
 
+/*
+ * C.2.5 Step 0 and C.2.7 Step 2 on the systems only: the topology part
+ * of the SPT, to which the prefixes are attached afterwards.
+ */
 static int
-isis_run_spf (struct isis_area *area, int level, int family, u_char *sysid)
+isis_spf_topology (struct isis_spftree *spftree, int level, int family,
+                   u_char *sysid)
 {
   int retval = ISIS_OK;
   struct listnode *node;
   struct isis_vertex *vertex;
   struct isis_vertex *root_vertex;
-  struct isis_spftree *spftree = NULL;
   u_char lsp_id[ISIS_SYS_ID_LEN + 2];
   struct isis_lsp *lsp;
-  struct route_table *table = NULL;
-  struct timeval time_now;
-  unsigned long long start_time, end_time;
-
-  /* Get time that can't roll backwards. */
-  quagga_gettime(QUAGGA_CLK_MONOTONIC, &time_now);
-  start_time = time_now.tv_sec;
-  start_time = (start_time * 1000000) + time_now.tv_usec;
-
-  if (family == AF_INET)
-    spftree = area->spftree[level - 1];
-#ifdef HAVE_IPV6
-  else if (family == AF_INET6)
-    spftree = area->spftree6[level - 1];
-#endif
-  assert (spftree);
-  assert (sysid);
-
-  /* Make all routes in current route table inactive. */
-  if (family == AF_INET)
-    table = area->route_table[level - 1];
-#ifdef HAVE_IPV6
-  else if (family == AF_INET6)
-    table = area->route_table6[level - 1];
-#endif
-
-  isis_route_invalidate_table (area, table);
 
   /*
    * C.2.5 Step 0
    */
   init_spt (spftree);
+  spftree->split = 0;
   /*              a) */
   root_vertex = isis_spf_add_root (spftree, level, sysid);
   /*              b) */
@@ -1213,17 +1234,15 @@ isis_run_spf (struct isis_area *area, int level, int family, u_char *sysid)
   if (retval != ISIS_OK)
     {
       zlog_warn ("ISIS-Spf: failed to load TENT SPF-root:%s", print_sys_hostname(sysid));
-      goto out;
+      return retval;
     }
 
   /*
    * C.2.7 Step 2
    */
-  if (listcount (spftree->tents) == 0)
-    {
-      zlog_warn ("ISIS-Spf: TENT is empty SPF-root:%s", print_sys_hostname(sysid));
-      goto out;
-    }
+  if (listcount (spftree->tents) == 0 && (isis->debugs & DEBUG_SPF_EVENTS))
+    zlog_debug ("ISIS-Spf: TENT is empty SPF-root:%s",
+                print_sys_hostname (sysid));
 
   while (listcount (spftree->tents) > 0)
     {
@@ -1247,7 +1266,7 @@ isis_run_spf (struct isis_area *area, int level, int family, u_char *sysid)
 	case VTYPE_NONPSEUDO_TE_IS:
 	  memcpy (lsp_id, vertex->N.id, ISIS_SYS_ID_LEN + 1);
 	  LSP_FRAGMENT (lsp_id) = 0;
-	  lsp = lsp_search (lsp_id, area->lspdb[level - 1]);
+	  lsp = lsp_search (lsp_id, spftree->area->lspdb[level - 1]);
 	  if (lsp && lsp->lsp_header->rem_lifetime != 0)
 	    {
 	      if (LSP_PSEUDO_ID (lsp_id))
@@ -1259,7 +1278,8 @@ isis_run_spf (struct isis_area *area, int level, int family, u_char *sysid)
 	      else
 		{
 		  isis_spf_process_lsp (spftree, lsp, vertex->d_N,
-					vertex->depth, family, sysid, vertex);
+					vertex->depth, family, sysid, vertex,
+					0);
 		}
 	    }
 	  else
@@ -1272,8 +1292,179 @@ isis_run_spf (struct isis_area *area, int level, int family, u_char *sysid)
 	}
     }
 
-out:
-  isis_route_validate (area);
+  return retval;
+}
+
+struct spf_vertex_copy
+{
+  struct isis_vertex *from;
+  struct isis_vertex *to;
+};
+
+static int
+spf_vertex_copy_cmp (const void *a, const void *b)
+{
+  const struct isis_vertex *v1 = ((const struct spf_vertex_copy *) a)->from;
+  const struct isis_vertex *v2 = ((const struct spf_vertex_copy *) b)->from;
+
+  return (v1 > v2) - (v1 < v2);
+}
+
+/*
+ * Copy the systems of an SPT just computed for the other address
+ * family, when both families share the topology.
+ */
+static void
+isis_spf_copy_topology (struct isis_spftree *spftree,
+                        struct isis_spftree *from)
+{
+  struct spf_vertex_copy *copies, key, *found;
+  struct listnode *node, *anode;
+  struct isis_vertex *vertex, *copy, *parent;
+  struct isis_adjacency *adj;
+  unsigned int count = 0, i;
+
+  init_spt (spftree);
+  copies = XMALLOC (MTYPE_TMP, sizeof (struct spf_vertex_copy)
+                               * (listcount (from->paths) + 1));
+
+  for (ALL_LIST_ELEMENTS_RO (from->paths, node, vertex))
+    {
+      if (vertex->type > VTYPE_ES)
+        continue;
+      copy = isis_vertex_new (vertex->N.id, vertex->type);
+      copy->d_N = vertex->d_N;
+      copy->depth = vertex->depth;
+      for (ALL_LIST_ELEMENTS_RO (vertex->Adj_N, anode, adj))
+        listnode_add (copy->Adj_N, adj);
+      listnode_add (spftree->paths, copy);
+      copies[count].from = vertex;
+      copies[count++].to = copy;
+    }
+
+  /* Parents come before their children in PATHS */
+  qsort (copies, count, sizeof (struct spf_vertex_copy), spf_vertex_copy_cmp);
+  for (i = 0; i < count; i++)
+    for (ALL_LIST_ELEMENTS_RO (copies[i].from->parents, node, parent))
+      {
+        key.from = parent;
+        found = bsearch (&key, copies, count, sizeof (struct spf_vertex_copy),
+                         spf_vertex_copy_cmp);
+        if (found == NULL)
+          continue;
+        listnode_add (copies[i].to->parents, found->to);
+        listnode_add (found->to->children, copies[i].to);
+      }
+
+  XFREE (MTYPE_TMP, copies);
+}
+
+/*
+ * Attach the prefixes to the systems of the SPT: after the topology
+ * changed, or alone as a partial route calculation for changes which
+ * only concern prefixes.
+ */
+static void
+isis_spf_reachability (struct isis_spftree *spftree, int level, int family,
+                       u_char *sysid)
+{
+  struct listnode *node, *nnode, *pnode;
+  struct isis_vertex *root, *vertex, *parent;
+  u_char lsp_id[ISIS_SYS_ID_LEN + 2];
+  struct isis_lsp *lsp;
+
+  root = listgetdata (listhead (spftree->paths));
+
+  /* Drop the prefixes of the previous run */
+  for (ALL_LIST_ELEMENTS (spftree->paths, node, nnode, vertex))
+    {
+      if (vertex->type <= VTYPE_ES)
+        continue;
+      for (ALL_LIST_ELEMENTS_RO (vertex->parents, pnode, parent))
+        listnode_delete (parent->children, vertex);
+      list_delete_node (spftree->paths, node);
+      isis_vertex_del (vertex);
+    }
+
+  isis_spf_preload_prefixes (spftree, level, family, root);
+
+  /* Step 1 from each system, on its prefixes only */
+  for (ALL_LIST_ELEMENTS_RO (spftree->paths, node, vertex))
+    {
+      if (vertex == root || (vertex->type != VTYPE_NONPSEUDO_IS
+                             && vertex->type != VTYPE_NONPSEUDO_TE_IS))
+        continue;
+      memcpy (lsp_id, vertex->N.id, ISIS_SYS_ID_LEN);
+      LSP_PSEUDO_ID (lsp_id) = 0;
+      LSP_FRAGMENT (lsp_id) = 0;
+      lsp = lsp_search (lsp_id, spftree->area->lspdb[level - 1]);
+      if (lsp && lsp->lsp_header->rem_lifetime != 0)
+        isis_spf_process_lsp (spftree, lsp, vertex->d_N, vertex->depth,
+                              family, sysid, vertex, 1);
+    }
+
+  /* Step 2, where only prefixes are left in TENT */
+  while (listcount (spftree->tents) > 0)
+    {
+      node = listhead (spftree->tents);
+      vertex = listgetdata (node);
+      list_delete_node (spftree->tents, node);
+      add_to_paths (spftree, vertex, level);
+    }
+}
+
+/*
+ * Route calculation of one address family of a level, on the topology
+ * of the tree from when given: the other family's, just computed.
+ */
+static int
+isis_spf_run_family (struct isis_area *area, int level, int family,
+                     u_char *sysid, struct isis_spftree *from)
+{
+  int retval = ISIS_OK;
+  struct isis_spftree *spftree = NULL;
+  struct route_table *table = NULL;
+  struct timeval time_now;
+  unsigned long long start_time, end_time;
+  struct isis_spf_log *log;
+  int partial;
+
+  /* Get time that can't roll backwards. */
+  quagga_gettime(QUAGGA_CLK_MONOTONIC, &time_now);
+  start_time = time_now.tv_sec;
+  start_time = (start_time * 1000000) + time_now.tv_usec;
+
+  if (family == AF_INET)
+    spftree = area->spftree[level - 1];
+#ifdef HAVE_IPV6
+  else if (family == AF_INET6)
+    spftree = area->spftree6[level - 1];
+#endif
+  assert (spftree);
+  assert (sysid);
+
+  /* Make all routes in current route table inactive. */
+  if (family == AF_INET)
+    table = area->route_table[level - 1];
+#ifdef HAVE_IPV6
+  else if (family == AF_INET6)
+    table = area->route_table6[level - 1];
+#endif
+
+  isis_route_invalidate_table (area, table);
+
+  partial = !spftree->full && listcount (spftree->paths) > 0;
+  spftree->full = 0;
+  if (partial)
+    from = NULL;
+  else if (from)
+    isis_spf_copy_topology (spftree, from);
+  else
+    retval = isis_spf_topology (spftree, level, family, sysid);
+
+  if (retval == ISIS_OK)
+    isis_spf_reachability (spftree, level, family, sysid);
+
   spftree->pending = 0;
   spftree->runcount++;
   spftree->last_run_timestamp = time (NULL);
@@ -1281,70 +1472,221 @@ out:
   end_time = time_now.tv_sec;
   end_time = (end_time * 1000000) + time_now.tv_usec;
   spftree->last_run_duration = end_time - start_time;
+  if (partial)
+    spftree->prc_runcount++;
+  if (from)
+    spftree->shared_runcount++;
+
+  log = &spftree->log[spftree->log_next];
+  spftree->log_next = (spftree->log_next + 1) % ISIS_SPF_LOG_SIZE;
+  log->timestamp = spftree->last_run_timestamp;
+  log->duration = spftree->last_run_duration;
+  log->triggers = spftree->triggers;
+  log->partial = partial;
+  log->shared = (from != NULL);
+  spftree->triggers = 0;
+
+  if (isis->debugs & DEBUG_SPF_STATS)
+    zlog_debug ("ISIS-Spf (%s) L%d %s %s run in %lu usec", area->area_tag,
+                level, family == AF_INET ? "IPv4" : "IPv6",
+                partial ? "partial" : (from ? "shared" : "full"),
+                log->duration);
+
+  return retval;
+}
 
+/*
+ * Route calculation of the address families of a level. In single
+ * topology IS-IS, the systems of the SPT are the same for IPv4 and
+ * IPv6 unless some system or circuit only carries one of them: the
+ * topology is then computed once, and both families attach their own
+ * prefixes to it.
+ */
+static int
+isis_spf_run_level (struct isis_area *area, int level, int families,
+                    u_char *sysid)
+{
+  struct isis_spftree *spftree, *from = NULL;
+  int retval = ISIS_OK, full = 0;
+
+  if (families & ISIS_SPF_IPV4)
+    {
+      spftree = area->spftree[level - 1];
+      if (spftree->full || listcount (spftree->paths) == 0)
+        {
+          full = 1;
+          from = spftree;
+        }
+      retval = isis_spf_run_family (area, level, AF_INET, sysid, NULL);
+      if (retval != ISIS_OK || spftree->split)
+        from = NULL;
+    }
+#ifdef HAVE_IPV6
+  if (families & ISIS_SPF_IPV6)
+    {
+      spftree = area->spftree6[level - 1];
+      if (spftree->full || listcount (spftree->paths) == 0)
+        full = 1;
+      if (isis_spf_run_family (area, level, AF_INET6, sysid, from)
+          != ISIS_OK)
+        retval = ISIS_WARNING;
+    }
+#endif /* HAVE_IPV6 */
+
+  /* The flooding topology follows the adjacencies */
+  if (full)
+    isis_flood_update (area, level);
 
   return retval;
 }
 
 int
-isis_run_spf_l1 (struct thread *thread)
+isis_run_spf_families (struct isis_area *area, int level, int families,
+                       u_char *sysid)
 {
-  struct isis_area *area;
-  int retval = ISIS_OK;
+  int retval;
 
-  area = THREAD_ARG (thread);
-  assert (area);
+  retval = isis_spf_run_level (area, level, families, sysid);
+  isis_route_validate (area);
 
-  area->spftree[0]->t_spf = NULL;
-  area->spftree[0]->pending = 0;
+  return retval;
+}
+
+int
+isis_run_spf (struct isis_area *area, int level, int family, u_char *sysid)
+{
+  return isis_run_spf_families (area, level, family == AF_INET ?
+                                ISIS_SPF_IPV4 : ISIS_SPF_IPV6, sysid);
+}
 
-  if (!(area->is_type & IS_LEVEL_1))
+/* Whether the SPF run requested on spftree is due now */
+static int
+isis_spf_due (struct isis_area *area, struct isis_spftree *spftree,
+              int level, time_t now)
+{
+  if (spftree == NULL || !spftree->pending)
+    return 0;
+  if (spftree->t_spf
+      && now - spftree->last_run_timestamp
+         < area->min_spf_interval[level - 1])
+    return 0;
+
+  THREAD_TIMER_OFF (spftree->t_spf);
+  spftree->pending = 0;
+  return 1;
+}
+
+/*
+ * Run all the SPF due in the area: when a change concerns both levels
+ * or both families, their requests get served together, and the routes
+ * reach zebra once for all of them.
+ */
+static int
+isis_spf_run_due (struct isis_area *area)
+{
+  time_t now = time (NULL);
+  int level, families, ran = 0, retval = ISIS_OK;
+
+  /* A restarting router keeps the routes of zebra until its LSDB is
+   * synchronised: the requests stay pending, see isis_gr.h */
+  if (area->gr_restarting)
+    return ISIS_OK;
+
+  for (level = IS_LEVEL_1; level <= IS_LEVEL_2; level++)
     {
+      families = 0;
+      if (isis_spf_due (area, area->spftree[level - 1], level, now)
+          && area->ip_circuits)
+        families |= ISIS_SPF_IPV4;
+#ifdef HAVE_IPV6
+      if (isis_spf_due (area, area->spftree6[level - 1], level, now)
+          && area->ipv6_circuits)
+        families |= ISIS_SPF_IPV6;
+#endif /* HAVE_IPV6 */
+      if (families == 0)
+        continue;
+
+      if (!(area->is_type & level))
+        {
+          if (isis->debugs & DEBUG_SPF_EVENTS)
+            zlog_warn ("ISIS-SPF (%s) area does not share level",
+                       area->area_tag);
+          retval = ISIS_WARNING;
+          continue;
+        }
+
       if (isis->debugs & DEBUG_SPF_EVENTS)
-	zlog_warn ("ISIS-SPF (%s) area does not share level",
-		   area->area_tag);
-      return ISIS_WARNING;
-    }
+        zlog_debug ("ISIS-Spf (%s) L%d SPF needed, periodic SPF",
+                    area->area_tag, level);
 
-  if (isis->debugs & DEBUG_SPF_EVENTS)
-    zlog_debug ("ISIS-Spf (%s) L1 SPF needed, periodic SPF", area->area_tag);
+      if (isis_spf_run_level (area, level, families, isis->sysid) != ISIS_OK)
+        retval = ISIS_WARNING;
+      ran = 1;
+    }
 
-  if (area->ip_circuits)
-    retval = isis_run_spf (area, 1, AF_INET, isis->sysid);
+  if (ran)
+    isis_route_validate (area);
 
   return retval;
 }
 
+/* Full SPF of all the levels and families of the area, at once */
 int
-isis_run_spf_l2 (struct thread *thread)
+isis_spf_run_all (struct isis_area *area)
+{
+  int level;
+
+  for (level = IS_LEVEL_1; level <= IS_LEVEL_2; level++)
+    {
+      if (!(area->is_type & level))
+        continue;
+      if (area->spftree[level - 1])
+        {
+          THREAD_TIMER_OFF (area->spftree[level - 1]->t_spf);
+          area->spftree[level - 1]->full = 1;
+          area->spftree[level - 1]->pending = 1;
+        }
+#ifdef HAVE_IPV6
+      if (area->spftree6[level - 1])
+        {
+          THREAD_TIMER_OFF (area->spftree6[level - 1]->t_spf);
+          area->spftree6[level - 1]->full = 1;
+          area->spftree6[level - 1]->pending = 1;
+        }
+#endif /* HAVE_IPV6 */
+    }
+
+  return isis_spf_run_due (area);
+}
+
+int
+isis_run_spf_l1 (struct thread *thread)
 {
   struct isis_area *area;
-  int retval = ISIS_OK;
 
   area = THREAD_ARG (thread);
   assert (area);
 
-  area->spftree[1]->t_spf = NULL;
-  area->spftree[1]->pending = 0;
+  area->spftree[0]->t_spf = NULL;
 
-  if (!(area->is_type & IS_LEVEL_2))
-    {
-      if (isis->debugs & DEBUG_SPF_EVENTS)
-	zlog_warn ("ISIS-SPF (%s) area does not share level", area->area_tag);
-      return ISIS_WARNING;
-    }
+  return isis_spf_run_due (area);
+}
 
-  if (isis->debugs & DEBUG_SPF_EVENTS)
-    zlog_debug ("ISIS-Spf (%s) L2 SPF needed, periodic SPF", area->area_tag);
+int
+isis_run_spf_l2 (struct thread *thread)
+{
+  struct isis_area *area;
 
-  if (area->ip_circuits)
-    retval = isis_run_spf (area, 2, AF_INET, isis->sysid);
+  area = THREAD_ARG (thread);
+  assert (area);
 
-  return retval;
+  area->spftree[1]->t_spf = NULL;
+
+  return isis_spf_run_due (area);
 }
 
-int
-isis_spf_schedule (struct isis_area *area, int level)
+static int
+isis_spf_schedule_run (struct isis_area *area, int level)
 {
   struct isis_spftree *spftree = area->spftree[level - 1];
   time_t now = time (NULL);
@@ -1353,6 +1695,8 @@ isis_spf_schedule (struct isis_area *area, int level)
   assert (diff >= 0);
   assert (area->is_type & level);
 
+  spftree->triggers++;
+
   if (isis->debugs & DEBUG_SPF_EVENTS)
     zlog_debug ("ISIS-Spf (%s) L%d SPF schedule called, lastrun %d sec ago",
                 area->area_tag, level, diff);
@@ -1362,9 +1706,11 @@ isis_spf_schedule (struct isis_area *area, int level)
 
   THREAD_TIMER_OFF (spftree->t_spf);
 
-  /* wait configured min_spf_interval before doing the SPF */
+  /* wait configured min_spf_interval before doing the SPF, and even
+   * when it elapsed run from the event loop, where the requests for the
+   * other family and level of the same change are served with it */
   if (diff >= area->min_spf_interval[level-1])
-      return isis_run_spf (area, level, AF_INET, isis->sysid);
+    diff = area->min_spf_interval[level-1];
 
   if (level == 1)
     THREAD_TIMER_ON (master, spftree->t_spf, isis_run_spf_l1, area,
@@ -1382,65 +1728,50 @@ isis_spf_schedule (struct isis_area *area, int level)
   return ISIS_OK;
 }
 
+int
+isis_spf_schedule (struct isis_area *area, int level)
+{
+  area->spftree[level - 1]->full = 1;
+  return isis_spf_schedule_run (area, level);
+}
+
+/* Only prefixes changed: a partial route calculation will do, unless a
+ * full SPF is already due. */
+int
+isis_prc_schedule (struct isis_area *area, int level)
+{
+  return isis_spf_schedule_run (area, level);
+}
+
 #ifdef HAVE_IPV6
 static int
 isis_run_spf6_l1 (struct thread *thread)
 {
   struct isis_area *area;
-  int retval = ISIS_OK;
 
   area = THREAD_ARG (thread);
   assert (area);
 
   area->spftree6[0]->t_spf = NULL;
-  area->spftree6[0]->pending = 0;
-
-  if (!(area->is_type & IS_LEVEL_1))
-    {
-      if (isis->debugs & DEBUG_SPF_EVENTS)
-        zlog_warn ("ISIS-SPF (%s) area does not share level", area->area_tag);
-      return ISIS_WARNING;
-    }
 
-  if (isis->debugs & DEBUG_SPF_EVENTS)
-    zlog_debug ("ISIS-Spf (%s) L1 SPF needed, periodic SPF", area->area_tag);
-
-  if (area->ipv6_circuits)
-    retval = isis_run_spf (area, 1, AF_INET6, isis->sysid);
-
-  return retval;
+  return isis_spf_run_due (area);
 }
 
 static int
 isis_run_spf6_l2 (struct thread *thread)
 {
   struct isis_area *area;
-  int retval = ISIS_OK;
 
   area = THREAD_ARG (thread);
   assert (area);
 
   area->spftree6[1]->t_spf = NULL;
-  area->spftree6[1]->pending = 0;
-
-  if (!(area->is_type & IS_LEVEL_2))
-    {
-      if (isis->debugs & DEBUG_SPF_EVENTS)
-        zlog_warn ("ISIS-SPF (%s) area does not share level", area->area_tag);
-      return ISIS_WARNING;
-    }
-
-  if (isis->debugs & DEBUG_SPF_EVENTS)
-    zlog_debug ("ISIS-Spf (%s) L2 SPF needed, periodic SPF.", area->area_tag);
 
-  if (area->ipv6_circuits)
-    retval = isis_run_spf (area, 2, AF_INET6, isis->sysid);
-
-  return retval;
+  return isis_spf_run_due (area);
 }
 
-int
-isis_spf_schedule6 (struct isis_area *area, int level)
+static int
+isis_spf_schedule6_run (struct isis_area *area, int level)
 {
   int retval = ISIS_OK;
   struct isis_spftree *spftree = area->spftree6[level - 1];
@@ -1450,6 +1781,8 @@ isis_spf_schedule6 (struct isis_area *area, int level)
   assert (diff >= 0);
   assert (area->is_type & level);
 
+  spftree->triggers++;
+
   if (isis->debugs & DEBUG_SPF_EVENTS)
     zlog_debug ("ISIS-Spf (%s) L%d SPF schedule called, lastrun %lld sec ago",
                 area->area_tag, level, (long long)diff);
@@ -1461,7 +1794,7 @@ isis_spf_schedule6 (struct isis_area *area, int level)
 
   /* wait configured min_spf_interval before doing the SPF */
   if (diff >= area->min_spf_interval[level-1])
-      return isis_run_spf (area, level, AF_INET6, isis->sysid);
+    diff = area->min_spf_interval[level-1];
 
   if (level == 1)
     THREAD_TIMER_ON (master, spftree->t_spf, isis_run_spf6_l1, area,
@@ -1479,6 +1812,19 @@ isis_spf_schedule6 (struct isis_area *area, int level)
 
   return retval;
 }
+
+int
+isis_spf_schedule6 (struct isis_area *area, int level)
+{
+  area->spftree6[level - 1]->full = 1;
+  return isis_spf_schedule6_run (area, level);
+}
+
+int
+isis_prc_schedule6 (struct isis_area *area, int level)
+{
+  return isis_spf_schedule6_run (area, level);
+}
 #endif
 
 static void
@@ -1686,14 +2032,93 @@ DEFUN (show_isis_topology_l2,
   return CMD_SUCCESS;
 }
 
+static void
+isis_print_spf_log (struct vty *vty, struct isis_spftree *spftree)
+{
+  struct isis_spf_log *log;
+  time_t now = time (NULL);
+  long ago;
+  char buf[32];
+  unsigned int i;
+
+  vty_out (vty, "      %u runs: %u full SPF (%u shared), %u partial%s",
+           spftree->runcount, spftree->runcount - spftree->prc_runcount,
+           spftree->shared_runcount, spftree->prc_runcount, VTY_NEWLINE);
+  vty_out (vty, "      %-12s %-8s %12s %8s%s", "Ago", "Type", "Duration",
+           "Triggers", VTY_NEWLINE);
+
+  /* Most recent first */
+  for (i = 1; i <= ISIS_SPF_LOG_SIZE; i++)
+    {
+      log = &spftree->log[(spftree->log_next + ISIS_SPF_LOG_SIZE - i)
+                          % ISIS_SPF_LOG_SIZE];
+      if (log->timestamp == 0)
+        break;
+      ago = now - log->timestamp;
+      if (ago < 24 * 3600)
+        snprintf (buf, sizeof (buf), "%02ld:%02ld:%02ld", ago / 3600,
+                  (ago / 60) % 60, ago % 60);
+      else
+        snprintf (buf, sizeof (buf), "%ldd%02ldh", ago / (24 * 3600),
+                  (ago / 3600) % 24);
+      vty_out (vty, "      %-12s %-8s %7lu usec %8u%s", buf,
+               log->partial ? "PRC" : (log->shared ? "SHARED" : "FULL"),
+               log->duration, log->triggers, VTY_NEWLINE);
+    }
+}
+
+DEFUN (show_isis_spf_log,
+       show_isis_spf_log_cmd,
+       "show isis spf-log",
+       SHOW_STR
+       "IS-IS information\n"
+       "IS-IS route calculation log\n")
+{
+  struct listnode *node;
+  struct isis_area *area;
+  int level;
+
+  if (!isis->area_list || isis->area_list->count == 0)
+    return CMD_SUCCESS;
+
+  for (ALL_LIST_ELEMENTS_RO (isis->area_list, node, area))
+    {
+      vty_out (vty, "Area %s:%s", area->area_tag ? area->area_tag : "null",
+	       VTY_NEWLINE);
+
+      for (level = 0; level < ISIS_LEVELS; level++)
+	{
+	  if ((area->is_type & (level + 1)) == 0)
+	    continue;
+	  if (area->spftree[level])
+	    {
+	      vty_out (vty, "  Level-%d IPv4:%s", level + 1, VTY_NEWLINE);
+	      isis_print_spf_log (vty, area->spftree[level]);
+	    }
+#ifdef HAVE_IPV6
+	  if (area->spftree6[level])
+	    {
+	      vty_out (vty, "  Level-%d IPv6:%s", level + 1, VTY_NEWLINE);
+	      isis_print_spf_log (vty, area->spftree6[level]);
+	    }
+#endif /* HAVE_IPV6 */
+	}
+      vty_out (vty, "%s", VTY_NEWLINE);
+    }
+
+  return CMD_SUCCESS;
+}
+
 void
 isis_spf_cmds_init ()
 {
   install_element (VIEW_NODE, &show_isis_topology_cmd);
   install_element (VIEW_NODE, &show_isis_topology_l1_cmd);
   install_element (VIEW_NODE, &show_isis_topology_l2_cmd);
+  install_element (VIEW_NODE, &show_isis_spf_log_cmd);
 
   install_element (ENABLE_NODE, &show_isis_topology_cmd);
   install_element (ENABLE_NODE, &show_isis_topology_l1_cmd);
   install_element (ENABLE_NODE, &show_isis_topology_l2_cmd);
+  install_element (ENABLE_NODE, &show_isis_spf_log_cmd);
 }
@@ -61,6 +61,18 @@ struct isis_vertex
   struct list *children;        /* list of children used for tree dump */
 };
 
+/* Runs kept for "show isis spf-log" */
+#define ISIS_SPF_LOG_SIZE 16
+
+struct isis_spf_log
+{
+  time_t timestamp;		/* when the run ended */
+  unsigned long duration;	/* in usec */
+  unsigned int triggers;	/* schedule requests served by the run */
+  int partial;			/* partial route calculation */
+  int shared;			/* on the other family's topology */
+};
+
 struct isis_spftree
 {
   struct thread *t_spf;		/* spf threads */
@@ -68,9 +80,16 @@ struct isis_spftree
   struct list *tents;		/* TENT */
   struct isis_area *area;       /* back pointer to area */
   int pending;			/* already scheduled */
+  int full;			/* the topology changed, not only prefixes */
+  int split;			/* the families' topologies differ */
+  unsigned int triggers;	/* schedule requests since the last run */
   unsigned int runcount;        /* number of runs since uptime */
+  unsigned int prc_runcount;    /* of which partial route calculations */
+  unsigned int shared_runcount; /* and full ones on a copied topology */
   time_t last_run_timestamp;    /* last run timestamp for scheduling */
   time_t last_run_duration;     /* last run duration in msec */
+  struct isis_spf_log log[ISIS_SPF_LOG_SIZE];
+  unsigned int log_next;	/* next log entry to fill */
 };
 
 struct isis_spftree * isis_spftree_new (struct isis_area *area);
@@ -81,9 +100,20 @@ void spftree_area_init (struct isis_area *area);
 void spftree_area_del (struct isis_area *area);
 void spftree_area_adj_del (struct isis_area *area,
                            struct isis_adjacency *adj);
+/* Address families of isis_run_spf_families() */
+#define ISIS_SPF_IPV4		0x01
+#define ISIS_SPF_IPV6		0x02
+
+int isis_run_spf (struct isis_area *area, int level, int family,
+                  u_char *sysid);
+int isis_spf_run_all (struct isis_area *area);
+int isis_run_spf_families (struct isis_area *area, int level, int families,
+                           u_char *sysid);
 int isis_spf_schedule (struct isis_area *area, int level);
+int isis_prc_schedule (struct isis_area *area, int level);
 void isis_spf_cmds_init (void);
 #ifdef HAVE_IPV6
 int isis_spf_schedule6 (struct isis_area *area, int level);
+int isis_prc_schedule6 (struct isis_area *area, int level);
 #endif
 #endif /* _ZEBRA_ISIS_SPF_H */
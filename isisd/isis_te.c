@@ -41,8 +41,10 @@
 #include "md5.h"
 #include "sockunion.h"
 #include "network.h"
+#include "zclient.h"
+#include "ted.h"
 
-#include "isisd/dict.h"
+#include "isisd/isis_lspdb.h"
 #include "isisd/isis_constants.h"
 #include "isisd/isis_common.h"
 #include "isisd/isis_flags.h"
@@ -57,6 +59,9 @@
 #include "isisd/isis_adjacency.h"
 #include "isisd/isis_spf.h"
 #include "isisd/isis_te.h"
+#include "isisd/isis_ted.h"
+#include "isisd/isis_route.h"
+#include "isisd/isis_zebra.h"
 
 /* Global varial for MPLS TE management */
 struct isis_mpls_te isisMplsTE;
@@ -100,6 +105,184 @@ mpls_te_circuit_new()
 
 }
 
+/*------------------------------------------------------------------------*
+ * Followings are RFC7810 flooding dampening functions.
+ *------------------------------------------------------------------------*/
+
+/* Is the change from the advertised value significant for threshold (%) ? */
+static int
+te_value_significant (float adv, float cur, u_int32_t threshold)
+{
+  if (adv == cur)
+    return 0;
+  if (adv == 0)
+    return 1;
+  return fabsf (cur - adv) * 100 >= fabsf (adv) * threshold;
+}
+
+static int
+te_delay_significant (u_int32_t adv, u_int32_t cur, u_int32_t threshold)
+{
+  adv = ntohl (adv);
+  cur = ntohl (cur);
+
+  /* A change of the Anomalous bit is always significant */
+  if ((adv & TE_EXT_ANORMAL) != (cur & TE_EXT_ANORMAL))
+    return 1;
+  return te_value_significant ((float) (adv & TE_EXT_MASK),
+                               (float) (cur & TE_EXT_MASK), threshold);
+}
+
+static int
+te_bw_significant (float adv, float cur, u_int32_t threshold)
+{
+  return te_value_significant (ntohf (adv), ntohf (cur), threshold);
+}
+
+/* Check if RFC7810 metrics of the circuit differ significantly from the
+   ones carried by the last generated LSP. */
+static int
+mpls_te_adv_significant (struct mpls_te_circuit *mtc)
+{
+  struct mpls_te_circuit_adv *adv = &mtc->adv;
+  u_int32_t *th = isisMplsTE.threshold;
+
+  /* Sub-TLVs which appear or disappear */
+  if (SUBTLV_TYPE(adv->av_delay) != SUBTLV_TYPE(mtc->av_delay)
+      || SUBTLV_TYPE(adv->mm_delay) != SUBTLV_TYPE(mtc->mm_delay)
+      || SUBTLV_TYPE(adv->delay_var) != SUBTLV_TYPE(mtc->delay_var)
+      || SUBTLV_TYPE(adv->pkt_loss) != SUBTLV_TYPE(mtc->pkt_loss)
+      || SUBTLV_TYPE(adv->res_bw) != SUBTLV_TYPE(mtc->res_bw)
+      || SUBTLV_TYPE(adv->ava_bw) != SUBTLV_TYPE(mtc->ava_bw)
+      || SUBTLV_TYPE(adv->use_bw) != SUBTLV_TYPE(mtc->use_bw))
+    return 1;
+
+  if (SUBTLV_TYPE(mtc->av_delay) != 0
+      && te_delay_significant (adv->av_delay.value, mtc->av_delay.value,
+                               th[TE_DAMP_DELAY]))
+    return 1;
+  if (SUBTLV_TYPE(mtc->mm_delay) != 0
+      && (te_delay_significant (adv->mm_delay.low, mtc->mm_delay.low,
+                                th[TE_DAMP_DELAY])
+          || te_delay_significant (adv->mm_delay.high, mtc->mm_delay.high,
+                                   th[TE_DAMP_DELAY])))
+    return 1;
+  if (SUBTLV_TYPE(mtc->delay_var) != 0
+      && te_delay_significant (adv->delay_var.value, mtc->delay_var.value,
+                               th[TE_DAMP_DELAY]))
+    return 1;
+  if (SUBTLV_TYPE(mtc->pkt_loss) != 0
+      && te_delay_significant (adv->pkt_loss.value, mtc->pkt_loss.value,
+                               th[TE_DAMP_LOSS]))
+    return 1;
+  if (SUBTLV_TYPE(mtc->res_bw) != 0
+      && te_bw_significant (adv->res_bw.value, mtc->res_bw.value,
+                            th[TE_DAMP_BW]))
+    return 1;
+  if (SUBTLV_TYPE(mtc->ava_bw) != 0
+      && te_bw_significant (adv->ava_bw.value, mtc->ava_bw.value,
+                            th[TE_DAMP_BW]))
+    return 1;
+  if (SUBTLV_TYPE(mtc->use_bw) != 0
+      && te_bw_significant (adv->use_bw.value, mtc->use_bw.value,
+                            th[TE_DAMP_BW]))
+    return 1;
+
+  return 0;
+}
+
+/* Check if Sub-TLVs other than the RFC7810 ones have been modified */
+static int
+mpls_te_static_changed (struct mpls_te_circuit *old,
+                        struct mpls_te_circuit *mtc)
+{
+  return (old->status != mtc->status || old->type != mtc->type
+          || memcmp (&old->admin_grp, &mtc->admin_grp,
+                     sizeof (mtc->admin_grp))
+          || memcmp (&old->local_ipaddr, &mtc->local_ipaddr,
+                     sizeof (mtc->local_ipaddr))
+          || memcmp (&old->rmt_ipaddr, &mtc->rmt_ipaddr,
+                     sizeof (mtc->rmt_ipaddr))
+          || memcmp (&old->max_bw, &mtc->max_bw, sizeof (mtc->max_bw))
+          || memcmp (&old->max_rsv_bw, &mtc->max_rsv_bw,
+                     sizeof (mtc->max_rsv_bw))
+          || memcmp (&old->unrsv_bw, &mtc->unrsv_bw, sizeof (mtc->unrsv_bw))
+          || memcmp (&old->te_metric, &mtc->te_metric,
+                     sizeof (mtc->te_metric))
+          || memcmp (&old->ras, &mtc->ras, sizeof (mtc->ras))
+          || memcmp (&old->rip, &mtc->rip, sizeof (mtc->rip)));
+}
+
+/* Keep track of what has been advertised for this circuit */
+static void
+mpls_te_adv_set (struct mpls_te_circuit *mtc)
+{
+  mtc->adv.av_delay = mtc->av_delay;
+  mtc->adv.mm_delay = mtc->mm_delay;
+  mtc->adv.delay_var = mtc->delay_var;
+  mtc->adv.pkt_loss = mtc->pkt_loss;
+  mtc->adv.res_bw = mtc->res_bw;
+  mtc->adv.ava_bw = mtc->ava_bw;
+  mtc->adv.use_bw = mtc->use_bw;
+  mtc->last_sent = recent_relative_time ().tv_sec;
+  mtc->sent++;
+  THREAD_OFF (mtc->t_hold);
+}
+
+static int
+mpls_te_hold_timer (struct thread *thread)
+{
+  struct isis_circuit *circuit = THREAD_ARG (thread);
+  struct mpls_te_circuit *mtc = circuit->mtc;
+
+  mtc->t_hold = NULL;
+
+  if (!IS_MPLS_TE(isisMplsTE) || circuit->area == NULL)
+    return 0;
+
+  /* Metrics may have come back close to the advertised ones meanwhile */
+  if (mpls_te_adv_significant (mtc))
+    lsp_regenerate_schedule (circuit->area, circuit->is_type, 0);
+  else
+    mtc->suppressed++;
+
+  return 0;
+}
+
+/* Regenerate the LSP for a circuit whose RFC7810 metrics only have
+   changed: insignificant changes are not advertised and significant ones
+   are aggregated so that at most one LSP is generated per hold-down. */
+static void
+mpls_te_dynamic_update (struct isis_circuit *circuit)
+{
+  struct mpls_te_circuit *mtc = circuit->mtc;
+  time_t elapsed;
+
+  if (!mpls_te_adv_significant (mtc))
+    {
+      mtc->suppressed++;
+      return;
+    }
+
+  /* A regeneration is already pending */
+  if (mtc->t_hold != NULL)
+    {
+      mtc->deferred++;
+      return;
+    }
+
+  elapsed = recent_relative_time ().tv_sec - mtc->last_sent;
+  if (elapsed >= (time_t) isisMplsTE.hold_down)
+    {
+      lsp_regenerate_schedule (circuit->area, circuit->is_type, 0);
+      return;
+    }
+
+  mtc->deferred++;
+  mtc->t_hold = thread_add_timer (master, mpls_te_hold_timer, circuit,
+                                  isisMplsTE.hold_down - elapsed);
+}
+
 /* Copy SUB TLVs parameters into a buffer - No space verification are performed */
 /* Caller must verify before that there is enough free space in the buffer */
 u_char
@@ -244,6 +427,7 @@ add_te_subtlvs(u_char *buf, struct mpls_te_circuit *mtc)
 
   /* Update SubTLVs length */
   mtc->length = subtlvs_len(mtc);
+  mpls_te_adv_set (mtc);
 
   zlog_debug("ISIS MPLS-TE: Add %d bytes length SubTLVs", mtc->length);
 
@@ -657,6 +841,7 @@ void
 isis_mpls_te_update (struct interface *ifp)
 {
   struct isis_circuit *circuit;
+  struct mpls_te_circuit old;
 
   /* Sanity Check */
   if (ifp == NULL)
@@ -667,15 +852,265 @@ isis_mpls_te_update (struct interface *ifp)
     return;
 
   /* Update TE TLVs ... */
+  if (circuit->mtc != NULL)
+    memcpy (&old, circuit->mtc, sizeof (struct mpls_te_circuit));
+  else
+    memset (&old, 0, sizeof (struct mpls_te_circuit));
   isis_link_params_update(circuit, ifp);
 
-  /* ... and LSP */
+  /* ... and LSP, dampening changes of dynamic metrics */
   if (IS_MPLS_TE(isisMplsTE) && circuit->area)
-     lsp_regenerate_schedule (circuit->area, circuit->is_type, 0);
+    {
+      if (circuit->mtc->sent == 0 || mpls_te_static_changed (&old, circuit->mtc))
+        lsp_regenerate_schedule (circuit->area, circuit->is_type, 0);
+      else
+        mpls_te_dynamic_update (circuit);
+    }
 
   return;
 }
 
+/*------------------------------------------------------------------------*
+ * Followings are export functions to the zebra TED.
+ *------------------------------------------------------------------------*/
+
+/* Changes exported to zebra */
+static struct ted_batch *isis_ted_export = NULL;
+
+/* Node identifier in the zebra TED: System ID << 16 | Pseudo ID << 8 | level */
+u_int64_t
+isis_te_node_id (u_char *id, int level)
+{
+  u_int64_t nid = 0;
+  int i;
+
+  for (i = 0; i < ISIS_SYS_ID_LEN + 1; i++)
+    nid = (nid << 8) | id[i];
+
+  return (nid << 8) | level;
+}
+
+static void
+isis_te_export (struct te_msg *msg)
+{
+  if (isis_ted_export == NULL)
+    isis_ted_export = ted_batch_new (zclient, master);
+  ted_batch_add (isis_ted_export, msg);
+}
+
+/* Convert Sub-TLVs of an Extended IS Reachability into TED attributes */
+void
+isis_te_parse_subtlvs (struct te_is_neigh *te, struct te_link *link)
+{
+  struct te_attr *attr = &link->attr;
+  struct subtlv_header *tlvh;
+  u_int16_t sum;
+  int i;
+
+  for (sum = 0; sum + SUBTLV_HDR_SIZE <= te->sub_tlvs_length;
+       sum += SUBTLV_SIZE (tlvh))
+    {
+      tlvh = (struct subtlv_header *) (te->sub_tlvs + sum);
+      if (sum + SUBTLV_SIZE (tlvh) > te->sub_tlvs_length)
+        break;
+
+      switch (tlvh->type)
+        {
+        case TE_SUBTLV_ADMIN_GRP:
+          attr->admin_grp =
+            ntohl (((struct te_subtlv_admin_grp *) tlvh)->value);
+          SET_FLAG (attr->flags, TED_ATTR_ADM_GRP);
+          break;
+        case TE_SUBTLV_LLRI:
+          if (!CHECK_FLAG (attr->flags, TED_ATTR_LOCAL_ADDR))
+            link->local_id = ntohl (((struct te_subtlv_llri *) tlvh)->local);
+          break;
+        case TE_SUBTLV_LOCAL_IPADDR:
+          attr->local = ((struct te_subtlv_local_ipaddr *) tlvh)->value;
+          link->local_id = ntohl (attr->local.s_addr);
+          SET_FLAG (attr->flags, TED_ATTR_LOCAL_ADDR);
+          break;
+        case TE_SUBTLV_RMT_IPADDR:
+          attr->remote = ((struct te_subtlv_rmt_ipaddr *) tlvh)->value;
+          SET_FLAG (attr->flags, TED_ATTR_REMOTE_ADDR);
+          break;
+        case TE_SUBTLV_MAX_BW:
+          attr->max_bw = ntohf (((struct te_subtlv_max_bw *) tlvh)->value);
+          SET_FLAG (attr->flags, TED_ATTR_MAX_BW);
+          break;
+        case TE_SUBTLV_MAX_RSV_BW:
+          attr->max_rsv_bw =
+            ntohf (((struct te_subtlv_max_rsv_bw *) tlvh)->value);
+          SET_FLAG (attr->flags, TED_ATTR_MAX_RSV_BW);
+          break;
+        case TE_SUBTLV_UNRSV_BW:
+          for (i = 0; i < MAX_CLASS_TYPE; i++)
+            attr->unrsv_bw[i] =
+              ntohf (((struct te_subtlv_unrsv_bw *) tlvh)->value[i]);
+          SET_FLAG (attr->flags, TED_ATTR_UNRSV_BW);
+          break;
+        case TE_SUBTLV_TE_METRIC:
+          {
+            u_char *m = ((struct te_subtlv_te_metric *) tlvh)->value;
+            attr->te_metric = (m[0] << 16) | (m[1] << 8) | m[2];
+            SET_FLAG (attr->flags, TED_ATTR_TE_METRIC);
+          }
+          break;
+        case TE_SUBTLV_RAS:
+          attr->rmt_as = ntohl (((struct te_subtlv_ras *) tlvh)->value);
+          SET_FLAG (attr->flags, TED_ATTR_RMT_AS);
+          break;
+        case TE_SUBTLV_RIP:
+          attr->rmt_ip = ((struct te_subtlv_rip *) tlvh)->value;
+          SET_FLAG (attr->flags, TED_ATTR_RMT_IP);
+          break;
+        case TE_SUBTLV_AV_DELAY:
+          attr->av_delay = ntohl (((struct te_subtlv_av_delay *) tlvh)->value)
+                           & TE_EXT_MASK;
+          SET_FLAG (attr->flags, TED_ATTR_AV_DELAY);
+          break;
+        case TE_SUBTLV_MM_DELAY:
+          attr->min_delay = ntohl (((struct te_subtlv_mm_delay *) tlvh)->low)
+                            & TE_EXT_MASK;
+          attr->max_delay = ntohl (((struct te_subtlv_mm_delay *) tlvh)->high)
+                            & TE_EXT_MASK;
+          SET_FLAG (attr->flags, TED_ATTR_MM_DELAY);
+          break;
+        case TE_SUBTLV_DELAY_VAR:
+          attr->delay_var = ntohl (((struct te_subtlv_delay_var *) tlvh)->value)
+                            & TE_EXT_MASK;
+          SET_FLAG (attr->flags, TED_ATTR_DELAY_VAR);
+          break;
+        case TE_SUBTLV_PKT_LOSS:
+          attr->pkt_loss = ntohl (((struct te_subtlv_pkt_loss *) tlvh)->value)
+                           & TE_EXT_MASK;
+          SET_FLAG (attr->flags, TED_ATTR_PKT_LOSS);
+          break;
+        case TE_SUBTLV_RES_BW:
+          attr->res_bw = ntohf (((struct te_subtlv_res_bw *) tlvh)->value);
+          SET_FLAG (attr->flags, TED_ATTR_RES_BW);
+          break;
+        case TE_SUBTLV_AVA_BW:
+          attr->ava_bw = ntohf (((struct te_subtlv_ava_bw *) tlvh)->value);
+          SET_FLAG (attr->flags, TED_ATTR_AVA_BW);
+          break;
+        case TE_SUBTLV_USE_BW:
+          attr->use_bw = ntohf (((struct te_subtlv_use_bw *) tlvh)->value);
+          SET_FLAG (attr->flags, TED_ATTR_USE_BW);
+          break;
+        default:
+          break;
+        }
+    }
+}
+
+/*
+ * Export the TE content of an LSP (fragment) to the local TE topology
+ * and to zebra: the node itself
+ * from fragment zero, links from the Extended IS Reachability TLVs and
+ * prefixes from the Extended IP Reachability TLVs. Called with
+ * TED_EVENT_DELETE before the LSP content is released and with
+ * TED_EVENT_UPDATE once the new content is in place.
+ */
+void
+isis_te_lsp_export (struct isis_lsp *lsp, u_char event)
+{
+  struct te_msg msg;
+  struct te_is_neigh *te;
+  struct te_ipv4_reachability *reach;
+  struct tlv_iter iter;
+  u_char *lsp_id;
+  u_int64_t nid;
+
+  if (lsp->lsp_header == NULL || lsp->area == NULL)
+    return;
+
+  /* The local TE topology used by CSPF follows the same changes */
+  if (event == TED_EVENT_DELETE)
+    isis_ted_lsp_delete (lsp);
+  else
+    isis_ted_lsp_update (lsp);
+
+  if (zclient == NULL)
+    return;
+
+  /* Purged LSP have nothing to advertise */
+  if (event == TED_EVENT_UPDATE && lsp->lsp_header->rem_lifetime == 0)
+    return;
+
+  lsp_id = lsp->lsp_header->lsp_id;
+  nid = isis_te_node_id (lsp_id, lsp->level);
+
+  if (LSP_FRAGMENT (lsp_id) == 0)
+    {
+      memset (&msg, 0, sizeof (struct te_msg));
+      msg.event = event;
+      msg.type = TED_TYPE_NODE;
+      msg.u.node.proto = ZEBRA_ROUTE_ISIS;
+      msg.u.node.id = nid;
+      if (LSP_PSEUDO_ID (lsp_id) != 0)
+        msg.u.node.flags = TED_NODE_PSEUDO;
+      if (lsp->tlv_data.router_id)
+        msg.u.node.router_id = lsp->tlv_data.router_id->id;
+      isis_te_export (&msg);
+    }
+
+  if (!lsp->area->newmetric)
+    return;
+
+  LSP_TLV_FOREACH (lsp, TE_IS_NEIGHBOURS, iter, te)
+    {
+      memset (&msg, 0, sizeof (struct te_msg));
+      msg.event = event;
+      msg.type = TED_TYPE_LINK;
+      msg.u.link.proto = ZEBRA_ROUTE_ISIS;
+      msg.u.link.src = nid;
+      msg.u.link.dst = isis_te_node_id (te->neigh_id, lsp->level);
+      msg.u.link.attr.metric = GET_TE_METRIC (te);
+      SET_FLAG (msg.u.link.attr.flags, TED_ATTR_METRIC);
+      isis_te_parse_subtlvs (te, &msg.u.link);
+      isis_te_export (&msg);
+    }
+
+  LSP_TLV_FOREACH (lsp, TE_IPV4_REACHABILITY, iter, reach)
+    {
+      memset (&msg, 0, sizeof (struct te_msg));
+      msg.event = event;
+      msg.type = TED_TYPE_PREFIX;
+      msg.u.prefix.proto = ZEBRA_ROUTE_ISIS;
+      msg.u.prefix.node = nid;
+      msg.u.prefix.p.family = AF_INET;
+      msg.u.prefix.p.prefixlen = reach->control & 0x3F;
+      msg.u.prefix.p.u.prefix4 = newprefix2inaddr (&reach->prefix_start,
+                                                   reach->control);
+      msg.u.prefix.metric = ntohl (reach->te_metric);
+      isis_te_export (&msg);
+    }
+}
+
+/* (Re)connection to zebra: export all LSP databases. */
+void
+isis_te_zebra_sync (void)
+{
+  struct listnode *node;
+  struct isis_area *area;
+  struct lspdb_cursor cur;
+  struct isis_lsp *lsp;
+  int level;
+
+  if (isis == NULL)
+    return;
+
+  for (ALL_LIST_ELEMENTS_RO (isis->area_list, node, area))
+    for (level = 0; level < ISIS_LEVELS; level++)
+      {
+        if (area->lspdb[level] == NULL)
+          continue;
+        LSPDB_FOREACH (area->lspdb[level], cur, lsp)
+          isis_te_lsp_export (lsp, TED_EVENT_UPDATE);
+      }
+}
+
 /*------------------------------------------------------------------------*
  * Followings are vty session control functions.
  *------------------------------------------------------------------------*/
@@ -1073,6 +1508,19 @@ isis_mpls_te_config_write_router (struct vty *vty)
                inet_ntoa (isisMplsTE.router_id), VTY_NEWLINE);
     }
 
+  if (isisMplsTE.threshold[TE_DAMP_DELAY] != TE_DAMP_DEFAULT_THRESHOLD)
+    vty_out (vty, "  mpls-te dampening threshold delay %u%s",
+             isisMplsTE.threshold[TE_DAMP_DELAY], VTY_NEWLINE);
+  if (isisMplsTE.threshold[TE_DAMP_LOSS] != TE_DAMP_DEFAULT_THRESHOLD)
+    vty_out (vty, "  mpls-te dampening threshold loss %u%s",
+             isisMplsTE.threshold[TE_DAMP_LOSS], VTY_NEWLINE);
+  if (isisMplsTE.threshold[TE_DAMP_BW] != TE_DAMP_DEFAULT_THRESHOLD)
+    vty_out (vty, "  mpls-te dampening threshold bandwidth %u%s",
+             isisMplsTE.threshold[TE_DAMP_BW], VTY_NEWLINE);
+  if (isisMplsTE.hold_down != TE_DAMP_DEFAULT_HOLDDOWN)
+    vty_out (vty, "  mpls-te dampening hold-down %u%s",
+             isisMplsTE.hold_down, VTY_NEWLINE);
+
   return;
 }
 
@@ -1215,6 +1663,98 @@ DEFUN (no_isis_mpls_te_inter_as,
   return CMD_SUCCESS;
 }
 
+static int
+te_damp_class (const char *name)
+{
+  if (strncmp (name, "d", 1) == 0)
+    return TE_DAMP_DELAY;
+  if (strncmp (name, "l", 1) == 0)
+    return TE_DAMP_LOSS;
+  return TE_DAMP_BW;
+}
+
+DEFUN (isis_mpls_te_damp_threshold,
+       isis_mpls_te_damp_threshold_cmd,
+       "mpls-te dampening threshold (delay|loss|bandwidth) <0-100>",
+       MPLS_TE_STR
+       "Configure RFC7810 metrics advertisement dampening\n"
+       "Minimum relative change to advertise\n"
+       "Average, Min/Max delay and delay variation\n"
+       "Packet loss\n"
+       "Residual, Available and Utilized bandwidth\n"
+       "Percentage of the advertised value\n")
+{
+  u_int32_t threshold;
+
+  VTY_GET_INTEGER_RANGE ("threshold", threshold, argv[1], 0, 100);
+  isisMplsTE.threshold[te_damp_class (argv[0])] = threshold;
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (no_isis_mpls_te_damp_threshold,
+       no_isis_mpls_te_damp_threshold_cmd,
+       "no mpls-te dampening threshold (delay|loss|bandwidth)",
+       NO_STR
+       MPLS_TE_STR
+       "Configure RFC7810 metrics advertisement dampening\n"
+       "Minimum relative change to advertise\n"
+       "Average, Min/Max delay and delay variation\n"
+       "Packet loss\n"
+       "Residual, Available and Utilized bandwidth\n")
+{
+  isisMplsTE.threshold[te_damp_class (argv[0])] = TE_DAMP_DEFAULT_THRESHOLD;
+
+  return CMD_SUCCESS;
+}
+
+ALIAS (no_isis_mpls_te_damp_threshold,
+       no_isis_mpls_te_damp_threshold_val_cmd,
+       "no mpls-te dampening threshold (delay|loss|bandwidth) <0-100>",
+       NO_STR
+       MPLS_TE_STR
+       "Configure RFC7810 metrics advertisement dampening\n"
+       "Minimum relative change to advertise\n"
+       "Average, Min/Max delay and delay variation\n"
+       "Packet loss\n"
+       "Residual, Available and Utilized bandwidth\n"
+       "Percentage of the advertised value\n")
+
+DEFUN (isis_mpls_te_damp_hold_down,
+       isis_mpls_te_damp_hold_down_cmd,
+       "mpls-te dampening hold-down <0-3600>",
+       MPLS_TE_STR
+       "Configure RFC7810 metrics advertisement dampening\n"
+       "Minimum interval between two advertisements of a circuit\n"
+       "Seconds\n")
+{
+  VTY_GET_INTEGER_RANGE ("hold-down", isisMplsTE.hold_down, argv[0], 0, 3600);
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (no_isis_mpls_te_damp_hold_down,
+       no_isis_mpls_te_damp_hold_down_cmd,
+       "no mpls-te dampening hold-down",
+       NO_STR
+       MPLS_TE_STR
+       "Configure RFC7810 metrics advertisement dampening\n"
+       "Minimum interval between two advertisements of a circuit\n")
+{
+  isisMplsTE.hold_down = TE_DAMP_DEFAULT_HOLDDOWN;
+
+  return CMD_SUCCESS;
+}
+
+ALIAS (no_isis_mpls_te_damp_hold_down,
+       no_isis_mpls_te_damp_hold_down_val_cmd,
+       "no mpls-te dampening hold-down <0-3600>",
+       NO_STR
+       MPLS_TE_STR
+       "Configure RFC7810 metrics advertisement dampening\n"
+       "Minimum interval between two advertisements of a circuit\n"
+       "Seconds\n")
+
 DEFUN (show_isis_mpls_te_router,
        show_isis_mpls_te_router_cmd,
        "show isis mpls-te router",
@@ -1233,6 +1773,12 @@ DEFUN (show_isis_mpls_te_router,
             vty_out (vty, "  Router-Address: %s%s", inet_ntoa (isisMplsTE.router_id), VTY_NEWLINE);
           else
             vty_out (vty, "  N/A%s", VTY_NEWLINE);
+          vty_out (vty, "  Dampening thresholds: delay %u%%, loss %u%%, "
+                   "bandwidth %u%%, hold-down %u sec%s",
+                   isisMplsTE.threshold[TE_DAMP_DELAY],
+                   isisMplsTE.threshold[TE_DAMP_LOSS],
+                   isisMplsTE.threshold[TE_DAMP_BW],
+                   isisMplsTE.hold_down, VTY_NEWLINE);
         }
     }
   else
@@ -1299,6 +1845,9 @@ show_mpls_te_sub (struct vty *vty, struct interface *ifp)
       show_vty_subtlv_res_bw (vty, &mtc->res_bw);
       show_vty_subtlv_ava_bw (vty, &mtc->ava_bw);
       show_vty_subtlv_use_bw (vty, &mtc->use_bw);
+      vty_out (vty, "  Advertisement: %u LSP sent, %u changes suppressed, "
+               "%u deferred%s%s", mtc->sent, mtc->suppressed, mtc->deferred,
+               mtc->t_hold ? " (regeneration pending)" : "", VTY_NEWLINE);
       vty_out (vty, "---------------%s%s", VTY_NEWLINE, VTY_NEWLINE);
     }
   else
@@ -1354,6 +1903,10 @@ isis_mpls_te_init (void)
   isisMplsTE.interas_areaid.s_addr = 0;
   isisMplsTE.cir_list = list_new();
   isisMplsTE.router_id.s_addr = 0;
+  isisMplsTE.threshold[TE_DAMP_DELAY] = TE_DAMP_DEFAULT_THRESHOLD;
+  isisMplsTE.threshold[TE_DAMP_LOSS] = TE_DAMP_DEFAULT_THRESHOLD;
+  isisMplsTE.threshold[TE_DAMP_BW] = TE_DAMP_DEFAULT_THRESHOLD;
+  isisMplsTE.hold_down = TE_DAMP_DEFAULT_HOLDDOWN;
   
   /* Register new VTY commands */
   install_element (VIEW_NODE, &show_isis_mpls_te_router_cmd);
@@ -1366,6 +1919,12 @@ isis_mpls_te_init (void)
   install_element (ISIS_NODE, &isis_mpls_te_router_addr_cmd);
   install_element (ISIS_NODE, &isis_mpls_te_inter_as_cmd);
   install_element (ISIS_NODE, &no_isis_mpls_te_inter_as_cmd);
+  install_element (ISIS_NODE, &isis_mpls_te_damp_threshold_cmd);
+  install_element (ISIS_NODE, &no_isis_mpls_te_damp_threshold_cmd);
+  install_element (ISIS_NODE, &no_isis_mpls_te_damp_threshold_val_cmd);
+  install_element (ISIS_NODE, &isis_mpls_te_damp_hold_down_cmd);
+  install_element (ISIS_NODE, &no_isis_mpls_te_damp_hold_down_cmd);
+  install_element (ISIS_NODE, &no_isis_mpls_te_damp_hold_down_val_cmd);
 
   return;
 }
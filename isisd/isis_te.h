@@ -256,6 +256,20 @@ typedef enum _interas_mode_t { off, region, as, emulate } interas_mode_t;
 #define IS_MPLS_TE(m)    (m.status == enable)
 #define IS_CIRCUIT_TE(c) (c->status == enable)
 
+/*
+ * Flooding dampening of the RFC7810 dynamic metrics (RFC7810 section 5):
+ * a change is advertised only if it exceeds the threshold of its class,
+ * relatively to the last advertised value, and at most once per hold-down
+ * interval.
+ */
+#define TE_DAMP_DELAY		0	/* Av, Min/Max delay, Delay variation */
+#define TE_DAMP_LOSS		1	/* Packet loss */
+#define TE_DAMP_BW		2	/* Residual, Available, Utilized bw */
+#define TE_DAMP_MAX		3
+
+#define TE_DAMP_DEFAULT_THRESHOLD	10	/* percent */
+#define TE_DAMP_DEFAULT_HOLDDOWN	30	/* seconds */
+
 /* Following structure are internal use only. */
 struct isis_mpls_te
 {
@@ -274,10 +288,26 @@ struct isis_mpls_te
 
   /* MPLS_TE router ID */
   struct in_addr router_id;
+
+  /* RFC7810 flooding dampening */
+  u_int32_t threshold[TE_DAMP_MAX];
+  u_int32_t hold_down;
 };
 
 extern struct isis_mpls_te isisMplsTE;
 
+/* RFC7810 Sub-TLVs carried by the last generated LSP */
+struct mpls_te_circuit_adv
+{
+  struct te_subtlv_av_delay av_delay;
+  struct te_subtlv_mm_delay mm_delay;
+  struct te_subtlv_delay_var delay_var;
+  struct te_subtlv_pkt_loss pkt_loss;
+  struct te_subtlv_res_bw res_bw;
+  struct te_subtlv_ava_bw ava_bw;
+  struct te_subtlv_use_bw use_bw;
+};
+
 struct mpls_te_circuit
 {
 
@@ -313,8 +343,22 @@ struct mpls_te_circuit
   struct te_subtlv_res_bw res_bw;
   struct te_subtlv_ava_bw ava_bw;
   struct te_subtlv_use_bw use_bw;
+
+  /* RFC7810 flooding dampening */
+  struct mpls_te_circuit_adv adv;
+  struct thread *t_hold;
+  time_t last_sent;
+
+  /* Statistics */
+  u_int32_t sent;
+  u_int32_t suppressed;
+  u_int32_t deferred;
 };
 
+struct isis_lsp;
+struct te_is_neigh;
+struct te_link;
+
 /* Prototypes. */
 void isis_mpls_te_init (void);
 struct mpls_te_circuit *mpls_te_circuit_new(void);
@@ -327,5 +371,9 @@ u_char build_te_subtlvs(u_char *, struct isis_circuit *);
 void isis_link_params_update(struct isis_circuit *, struct interface *);
 void isis_mpls_te_update(struct interface *);
 void isis_mpls_te_config_write_router (struct vty *);
+u_int64_t isis_te_node_id (u_char *, int);
+void isis_te_parse_subtlvs (struct te_is_neigh *, struct te_link *);
+void isis_te_lsp_export (struct isis_lsp *, u_char);
+void isis_te_zebra_sync (void);
 
 #endif /* _ZEBRA_ISIS_MPLS_TE_H */
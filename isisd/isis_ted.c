@@ -0,0 +1,352 @@
+/*
+ * IS-IS Rout(e)ing protocol - isis_ted.c
+ *                             TE topology built from the LSP databases
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "linklist.h"
+#include "memory.h"
+#include "prefix.h"
+#include "vty.h"
+#include "log.h"
+#include "if.h"
+#include "hash.h"
+#include "jhash.h"
+#include "vector.h"
+#include "stream.h"
+#include "ted.h"
+
+#include "isisd/isis_lspdb.h"
+#include "isisd/isis_constants.h"
+#include "isisd/isis_common.h"
+#include "isisd/isis_flags.h"
+#include "isisd/isis_circuit.h"
+#include "isisd/isisd.h"
+#include "isisd/isis_tlv.h"
+#include "isisd/isis_lsp.h"
+#include "isisd/isis_pdu.h"
+#include "isisd/isis_misc.h"
+#include "isisd/isis_te.h"
+#include "isisd/isis_ted.h"
+
+/* TE topology of all areas and levels */
+struct isis_ted IsisTED;
+
+static unsigned int
+isis_ted_node_hash_key (void *data)
+{
+  struct isis_ted_node *node = data;
+
+  return jhash_2words (node->key >> 32, node->key, 0);
+}
+
+static int
+isis_ted_node_hash_cmp (const void *d1, const void *d2)
+{
+  const struct isis_ted_node *n1 = d1, *n2 = d2;
+
+  return n1->key == n2->key;
+}
+
+static unsigned int
+isis_ted_router_hash_key (void *data)
+{
+  struct isis_ted_node *node = data;
+
+  return jhash_2words (node->router_id.s_addr, node->level, 0);
+}
+
+static int
+isis_ted_router_hash_cmp (const void *d1, const void *d2)
+{
+  const struct isis_ted_node *n1 = d1, *n2 = d2;
+
+  return (n1->router_id.s_addr == n2->router_id.s_addr
+          && n1->level == n2->level);
+}
+
+struct isis_ted_node *
+isis_ted_node_lookup (u_char *id, int level)
+{
+  struct isis_ted_node key;
+
+  if (IsisTED.nodes == NULL)
+    return NULL;
+
+  key.key = isis_te_node_id (id, level);
+  return hash_lookup (IsisTED.nodes, &key);
+}
+
+struct isis_ted_node *
+isis_ted_router_lookup (struct in_addr router_id, int level)
+{
+  struct isis_ted_node key;
+
+  if (IsisTED.routers == NULL)
+    return NULL;
+
+  key.router_id = router_id;
+  key.level = level;
+  return hash_lookup (IsisTED.routers, &key);
+}
+
+static struct isis_ted_node *
+isis_ted_node_get (u_char *id, int level)
+{
+  struct isis_ted_node *node;
+
+  if ((node = isis_ted_node_lookup (id, level)) != NULL)
+    return node;
+
+  node = XCALLOC (MTYPE_ISIS_TED, sizeof (struct isis_ted_node));
+  node->key = isis_te_node_id (id, level);
+  memcpy (node->id, id, ISIS_SYS_ID_LEN + 1);
+  node->level = level;
+  node->links = list_new ();
+  node->index = vector_set (IsisTED.vertices, node);
+  hash_get (IsisTED.nodes, node, hash_alloc_intern);
+
+  if (IS_DEBUG_ISIS (DEBUG_TE))
+    zlog_debug ("ISIS-TED (L%d): Add node %s.%02x [%d]", level,
+                sysid_print (id), id[ISIS_SYS_ID_LEN], node->index);
+
+  return node;
+}
+
+static void
+isis_ted_node_set_router_id (struct isis_ted_node *node, struct in_addr id)
+{
+  if (node->router_id.s_addr == id.s_addr)
+    return;
+
+  if (node->hashed)
+    {
+      hash_release (IsisTED.routers, node);
+      node->hashed = 0;
+    }
+
+  node->router_id = id;
+
+  /* On duplicate Router IDs, the first node keeps the entry */
+  if (id.s_addr != INADDR_ANY
+      && hash_get (IsisTED.routers, node, hash_alloc_intern) == node)
+    node->hashed = 1;
+}
+
+/* Remove node once neither an LSP nor a link refers to it. */
+static void
+isis_ted_node_release (struct isis_ted_node *node)
+{
+  if (listcount (node->links) != 0 || node->in_count != 0
+      || node->router_id.s_addr != INADDR_ANY)
+    return;
+
+  if (IS_DEBUG_ISIS (DEBUG_TE))
+    zlog_debug ("ISIS-TED (L%d): Remove node %s.%02x [%d]", node->level,
+                sysid_print (node->id), node->id[ISIS_SYS_ID_LEN],
+                node->index);
+
+  hash_release (IsisTED.nodes, node);
+  vector_unset (IsisTED.vertices, node->index);
+  list_delete (node->links);
+  XFREE (MTYPE_ISIS_TED, node);
+}
+
+/* Link in the opposite direction, for the two-way connectivity check. */
+struct isis_ted_link *
+isis_ted_link_reverse (struct isis_ted_link *link)
+{
+  struct listnode *node;
+  struct isis_ted_link *rev;
+
+  for (ALL_LIST_ELEMENTS_RO (link->dst->links, node, rev))
+    if (rev->dst == link->src)
+      return rev;
+
+  return NULL;
+}
+
+/* TE metric, falling back to the IGP metric when not advertised. */
+u_int32_t
+isis_ted_link_metric (struct isis_ted_link *link)
+{
+  if (CHECK_FLAG (link->te.attr.flags, TED_ATTR_TE_METRIC))
+    return link->te.attr.te_metric;
+  return link->te.attr.metric;
+}
+
+/* Minimum link delay in micro-seconds, 0 if not advertised. */
+u_int32_t
+isis_ted_link_delay (struct isis_ted_link *link)
+{
+  if (CHECK_FLAG (link->te.attr.flags, TED_ATTR_MM_DELAY))
+    return link->te.attr.min_delay;
+  if (CHECK_FLAG (link->te.attr.flags, TED_ATTR_AV_DELAY))
+    return link->te.attr.av_delay;
+  return 0;
+}
+
+/* Remove the links advertised by a fragment, and its node attributes. */
+static void
+isis_ted_withdraw (u_char *lsp_id, int level)
+{
+  struct isis_ted_node *node, *dst;
+  struct isis_ted_link *link;
+  struct listnode *ln, *nn;
+  u_char frag = LSP_FRAGMENT (lsp_id);
+  struct in_addr none;
+
+  if ((node = isis_ted_node_lookup (lsp_id, level)) == NULL)
+    return;
+
+  for (ALL_LIST_ELEMENTS (node->links, ln, nn, link))
+    {
+      if (link->frag != frag)
+        continue;
+
+      list_delete_node (node->links, ln);
+      dst = link->dst;
+      dst->in_count--;
+      XFREE (MTYPE_ISIS_TED, link);
+      IsisTED.links--;
+      isis_ted_node_release (dst);
+    }
+
+  if (frag == 0)
+    {
+      none.s_addr = INADDR_ANY;
+      isis_ted_node_set_router_id (node, none);
+      node->overload = 0;
+    }
+
+  isis_ted_node_release (node);
+}
+
+/*
+ * Replace the content of an LSP fragment in the topology. Called on
+ * each new instance of the LSP, before the SPF runs on it.
+ */
+void
+isis_ted_lsp_update (struct isis_lsp *lsp)
+{
+  struct isis_ted_node *node;
+  struct isis_ted_link *link;
+  struct te_is_neigh *te;
+  struct tlv_iter iter;
+  u_char *lsp_id;
+
+  if (IsisTED.nodes == NULL)
+    return;
+
+  lsp_id = lsp->lsp_header->lsp_id;
+  isis_ted_withdraw (lsp_id, lsp->level);
+  IsisTED.lsp_update++;
+
+  /* Purged LSP have nothing to advertise */
+  if (lsp->lsp_header->rem_lifetime == 0)
+    return;
+
+  node = isis_ted_node_get (lsp_id, lsp->level);
+
+  if (LSP_FRAGMENT (lsp_id) == 0)
+    {
+      node->overload = ISIS_MASK_LSP_OL_BIT (lsp->lsp_header->lsp_bits);
+      if (lsp->tlv_data.router_id)
+        isis_ted_node_set_router_id (node, lsp->tlv_data.router_id->id);
+    }
+
+  if (lsp->area->newmetric)
+    LSP_TLV_FOREACH (lsp, TE_IS_NEIGHBOURS, iter, te)
+      {
+        /* Ignore loops, which are useless for the path computation */
+        if (memcmp (te->neigh_id, lsp_id, ISIS_SYS_ID_LEN + 1) == 0)
+          continue;
+
+        link = XCALLOC (MTYPE_ISIS_TED, sizeof (struct isis_ted_link));
+        link->src = node;
+        link->dst = isis_ted_node_get (te->neigh_id, lsp->level);
+        link->frag = LSP_FRAGMENT (lsp_id);
+        link->te.attr.metric = GET_TE_METRIC (te);
+        SET_FLAG (link->te.attr.flags, TED_ATTR_METRIC);
+        isis_te_parse_subtlvs (te, &link->te);
+
+        listnode_add (node->links, link);
+        link->dst->in_count++;
+        IsisTED.links++;
+      }
+
+  isis_ted_node_release (node);
+}
+
+void
+isis_ted_lsp_delete (struct isis_lsp *lsp)
+{
+  if (IsisTED.nodes == NULL)
+    return;
+
+  isis_ted_withdraw (lsp->lsp_header->lsp_id, lsp->level);
+  IsisTED.lsp_delete++;
+}
+
+void
+isis_ted_init (void)
+{
+  memset (&IsisTED, 0, sizeof (struct isis_ted));
+  IsisTED.nodes = hash_create (isis_ted_node_hash_key,
+                               isis_ted_node_hash_cmp);
+  IsisTED.routers = hash_create (isis_ted_router_hash_key,
+                                 isis_ted_router_hash_cmp);
+  IsisTED.vertices = vector_init (VECTOR_MIN_SIZE);
+}
+
+static void
+isis_ted_node_free (void *data)
+{
+  struct isis_ted_node *node = data;
+
+  list_delete_all_node (node->links);
+  list_delete (node->links);
+  XFREE (MTYPE_ISIS_TED, node);
+}
+
+void
+isis_ted_term (void)
+{
+  struct isis_ted_node *node;
+  struct isis_ted_link *link;
+  struct listnode *ln;
+  unsigned int i;
+
+  if (IsisTED.nodes == NULL)
+    return;
+
+  for (i = 0; i < vector_active (IsisTED.vertices); i++)
+    if ((node = vector_slot (IsisTED.vertices, i)) != NULL)
+      for (ALL_LIST_ELEMENTS_RO (node->links, ln, link))
+        XFREE (MTYPE_ISIS_TED, link);
+
+  hash_clean (IsisTED.routers, NULL);
+  hash_free (IsisTED.routers);
+  hash_clean (IsisTED.nodes, isis_ted_node_free);
+  hash_free (IsisTED.nodes);
+  vector_free (IsisTED.vertices);
+  memset (&IsisTED, 0, sizeof (struct isis_ted));
+}
@@ -0,0 +1,98 @@
+/*
+ * IS-IS Rout(e)ing protocol - isis_ted.h
+ *                             TE topology built from the LSP databases
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _ZEBRA_ISIS_TED_H
+#define _ZEBRA_ISIS_TED_H
+
+/*
+ * The TE topology is a directed graph made of the Extended IS
+ * Reachability TLVs (RFC5305) of all LSPs, one per level. Each link is
+ * tagged with the LSP number of the fragment which advertises it, so
+ * that the update of a fragment only replaces its own links. A
+ * pseudonode is a node of its own which reaches the attached systems
+ * through the links of its LSP.
+ */
+struct isis_ted_node
+{
+  /* Key: System ID, Pseudonode ID and level, see isis_te_node_id() */
+  u_int64_t key;
+  u_char id[ISIS_SYS_ID_LEN + 1];
+  int level;
+
+  /* TE Router ID and overload bit from fragment zero */
+  struct in_addr router_id;
+  u_char overload;
+  u_char hashed;		/* present in the router ID hash */
+
+  /* Outgoing links, from all fragments */
+  struct list *links;
+
+  /* Number of links pointing to this node */
+  u_int32_t in_count;
+
+  /* Slot in the node vector, used to index the CSPF work arrays */
+  int index;
+};
+
+struct isis_ted_link
+{
+  struct isis_ted_node *src;
+  struct isis_ted_node *dst;
+
+  /* LSP number of the advertising fragment */
+  u_char frag;
+
+  /* IGP metric and Sub-TLVs, as exported to zebra */
+  struct te_link te;
+};
+
+struct isis_ted
+{
+  /* Nodes hashed by key, and by (TE Router ID, level) */
+  struct hash *nodes;
+  struct hash *routers;
+
+  /* Nodes indexed by isis_ted_node->index */
+  vector vertices;
+
+  /* Statistics */
+  u_int32_t links;
+  u_int32_t lsp_update;
+  u_int32_t lsp_delete;
+};
+
+extern struct isis_ted IsisTED;
+
+struct isis_lsp;
+
+/* Prototypes. */
+extern void isis_ted_init (void);
+extern void isis_ted_term (void);
+extern void isis_ted_lsp_update (struct isis_lsp *);
+extern void isis_ted_lsp_delete (struct isis_lsp *);
+extern struct isis_ted_node *isis_ted_node_lookup (u_char *, int);
+extern struct isis_ted_node *isis_ted_router_lookup (struct in_addr, int);
+extern struct isis_ted_link *isis_ted_link_reverse (struct isis_ted_link *);
+extern u_int32_t isis_ted_link_metric (struct isis_ted_link *);
+extern u_int32_t isis_ted_link_delay (struct isis_ted_link *);
+
+#endif /* _ZEBRA_ISIS_TED_H */
@@ -31,7 +31,7 @@
 #include "vty.h"
 #include "if.h"
 
-#include "isisd/dict.h"
+#include "isisd/isis_lspdb.h"
 #include "isisd/isis_constants.h"
 #include "isisd/isis_common.h"
 #include "isisd/isis_flags.h"
@@ -744,9 +744,16 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
 	   * +---------------------------------------------------------------+
 	   */
 	  *found |= TLVFLAG_GRACEFUL_RESTART;
-	  if (*expected & TLVFLAG_GRACEFUL_RESTART)
+	  if ((*expected & TLVFLAG_GRACEFUL_RESTART) && length >= 1)
 	    {
-	      /* FIXME: make this work */
+	      tlvs->restart.flags = *pnt;
+	      if (length >= 3)
+		tlvs->restart.remaining_time = (pnt[1] << 8) | pnt[2];
+	      if (length >= 3 + ISIS_SYS_ID_LEN)
+		{
+		  memcpy (tlvs->restart.neighbor_id, pnt + 3, ISIS_SYS_ID_LEN);
+		  tlvs->restart.neighbor_known = 1;
+		}
 	    }
 	  pnt += length;
 	  break;
@@ -763,6 +770,97 @@ parse_tlvs (char *areatag, u_char * stream, int size, u_int32_t * expected,
   return retval;
 }
 
+/* Length of the TLV entry at pnt, -1 if it is malformed. */
+static int
+tlv_entry_len (u_char type, u_char *pnt, int room)
+{
+  int len;
+
+  switch (type)
+    {
+    case IS_NEIGHBOURS:
+      return 4 + ISIS_SYS_ID_LEN + 1;
+    case TE_IS_NEIGHBOURS:
+      if (room < IS_NEIGHBOURS_LEN)
+        return -1;
+      return IS_NEIGHBOURS_LEN + pnt[IS_NEIGHBOURS_LEN - 1];
+    case IPV4_INT_REACHABILITY:
+    case IPV4_EXT_REACHABILITY:
+      return IPV4_REACH_LEN;
+    case TE_IPV4_REACHABILITY:
+      if (room < 5 || (pnt[4] & 0x3F) > IPV4_MAX_BITLEN)
+        return -1;
+      len = 5 + PSIZE (pnt[4] & 0x3F);
+      /* sub-TLVs */
+      if (pnt[4] & 0x40)
+        len += (len < room) ? 1 + pnt[len] : 1;
+      return len;
+#ifdef HAVE_IPV6
+    case IPV6_REACHABILITY:
+      if (room < 6 || pnt[5] > IPV6_MAX_BITLEN)
+        return -1;
+      len = 6 + PSIZE (pnt[5]);
+      if (pnt[4] & CTRL_INFO_SUBTLVS)
+        len += (len < room) ? 1 + pnt[len] : 1;
+      return len;
+#endif /* HAVE_IPV6 */
+    case LSP_ENTRIES:
+      return LSP_ENTRIES_LEN;
+    default:
+      return room;
+    }
+}
+
+void *
+tlv_iter_next (struct tlv_iter *iter)
+{
+  u_char *entry;
+  int len;
+
+  for (;;)
+    {
+      if (iter->entry < iter->tlv_end)
+        {
+          entry = iter->entry;
+          len = tlv_entry_len (iter->type, entry, iter->tlv_end - entry);
+          if (len > 0 && len <= iter->tlv_end - entry)
+            {
+              iter->entry += len;
+              return entry;
+            }
+        }
+
+      /* Next TLV of the type */
+      while (iter->pnt + 2 <= iter->end
+             && (iter->pnt[0] != iter->type
+                 || iter->pnt + 2 + iter->pnt[1] > iter->end))
+        iter->pnt += 2 + iter->pnt[1];
+      if (iter->pnt + 2 > iter->end)
+        return NULL;
+
+      iter->entry = iter->pnt + 2;
+      iter->tlv_end = iter->entry + iter->pnt[1];
+      iter->pnt = iter->tlv_end;
+      /* Virtual flag */
+      if (iter->type == IS_NEIGHBOURS)
+        iter->entry++;
+    }
+}
+
+/*
+ * First entry of the TLVs of the given type found in the variable length
+ * part of a PDU, NULL if there is none.
+ */
+void *
+tlv_iter_first (struct tlv_iter *iter, u_char type, u_char *tlvs, int size)
+{
+  iter->type = type;
+  iter->pnt = tlvs;
+  iter->end = tlvs + (size > 0 ? size : 0);
+  iter->entry = iter->tlv_end = NULL;
+  return tlv_iter_next (iter);
+}
+
 int
 add_tlv (u_char tag, u_char len, u_char * value, struct stream *stream)
 {
@@ -832,7 +930,10 @@ tlv_add_is_neighs (struct list *is_neighs, struct stream *stream)
 	  retval = add_tlv (IS_NEIGHBOURS, pos - value, value, stream);
 	  if (retval != ISIS_OK)
 	    return retval;
+	  /* each TLV starts with the virtual flag */
 	  pos = value;
+	  *pos = 0;
+	  pos++;
 	}
       *pos = is_neigh->metrics.metric_default;
       pos++;
@@ -1000,6 +1101,7 @@ tlv_add_lsp_entries (struct list *lsps, struct stream *stream)
 	    return retval;
 	  pos = value;
 	}
+      lsp_set_time (lsp);
       *((u_int16_t *) pos) = lsp->lsp_header->rem_lifetime;
       pos += 2;
       memcpy (pos, lsp->lsp_header->lsp_id, ISIS_SYS_ID_LEN + 2);
@@ -1154,6 +1256,24 @@ tlv_add_ipv6_reachs (struct list *ipv6_reachs, struct stream *stream)
 }
 #endif /* HAVE_IPV6 */
 
+int
+tlv_add_restart (struct restart_tlv *restart, struct stream *stream)
+{
+  u_char value[3 + ISIS_SYS_ID_LEN];
+  u_char *pos = value;
+
+  *pos++ = restart->flags;
+  *pos++ = restart->remaining_time >> 8;
+  *pos++ = restart->remaining_time & 0xff;
+  if (restart->neighbor_known)
+    {
+      memcpy (pos, restart->neighbor_id, ISIS_SYS_ID_LEN);
+      pos += ISIS_SYS_ID_LEN;
+    }
+
+  return add_tlv (GRACEFUL_RESTART, pos - value, value, stream);
+}
+
 int
 tlv_add_padding (struct stream *stream)
 {
@@ -215,6 +215,19 @@ struct te_router_id
   struct in_addr id;
 };
 
+/* restart signalling, RFC 5306 */
+#define RESTART_RR                0x01	/* restart request */
+#define RESTART_RA                0x02	/* restart acknowledgement */
+#define RESTART_SA                0x04	/* suppress adjacency advertisement */
+
+struct restart_tlv
+{
+  u_char flags;
+  u_int16_t remaining_time;	/* seconds, host byte order */
+  u_char neighbor_known;	/* whether neighbor_id is set */
+  u_char neighbor_id[ISIS_SYS_ID_LEN];
+};
+
 /* te ipv4 reachability */
 struct te_ipv4_reachability
 {
@@ -277,6 +290,7 @@ struct tlvs
   struct list *ipv6_reachs;
 #endif
   struct isis_passwd auth_info;
+  struct restart_tlv restart;
 };
 
 /*
@@ -306,6 +320,20 @@ struct tlvs
 #define TLVFLAG_CHECKSUM                  (1<<20)
 #define TLVFLAG_GRACEFUL_RESTART          (1<<21)
 
+/*
+ * Iterator over the entries of the TLVs of one type, read in place from
+ * the PDU rather than copied into lists by parse_tlvs(). Malformed
+ * entries end the TLV they are found in.
+ */
+struct tlv_iter
+{
+  u_char type;
+  u_char *pnt;			/* next TLV */
+  u_char *end;			/* end of the TLVs */
+  u_char *entry;		/* next entry of the current TLV */
+  u_char *tlv_end;		/* end of the current TLV */
+};
+
 void init_tlvs (struct tlvs *tlvs, uint32_t expected);
 void free_tlvs (struct tlvs *tlvs);
 int parse_tlvs (char *areatag, u_char * stream, int size,
@@ -313,6 +341,9 @@ int parse_tlvs (char *areatag, u_char * stream, int size,
                 u_int32_t * auth_tlv_offset);
 int add_tlv (u_char, u_char, u_char *, struct stream *);
 void free_tlv (void *val);
+void *tlv_iter_first (struct tlv_iter *iter, u_char type, u_char *tlvs,
+                      int size);
+void *tlv_iter_next (struct tlv_iter *iter);
 
 int tlv_add_area_addrs (struct list *area_addrs, struct stream *stream);
 int tlv_add_is_neighs (struct list *is_neighs, struct stream *stream);
@@ -335,6 +366,7 @@ int tlv_add_ipv6_addrs (struct list *ipv6_addrs, struct stream *stream);
 int tlv_add_ipv6_reachs (struct list *ipv6_reachs, struct stream *stream);
 #endif /* HAVE_IPV6 */
 
+int tlv_add_restart (struct restart_tlv *restart, struct stream *stream);
 int tlv_add_padding (struct stream *stream);
 
 #endif /* _ZEBRA_ISIS_TLV_H */
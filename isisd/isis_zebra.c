@@ -35,7 +35,7 @@
 #include "linklist.h"
 #include "vrf.h"
 
-#include "isisd/dict.h"
+#include "isisd/isis_lspdb.h"
 #include "isisd/isis_constants.h"
 #include "isisd/isis_common.h"
 #include "isisd/isis_flags.h"
@@ -688,6 +688,7 @@ static void
 isis_zebra_connected (struct zclient *zclient)
 {
   zclient_send_requests (zclient, VRF_DEFAULT);
+  isis_te_zebra_sync ();
 }
 
 void
@@ -34,8 +34,9 @@
 #include "stream.h"
 #include "prefix.h"
 #include "table.h"
+#include "pqueue.h"
 
-#include "isisd/dict.h"
+#include "isisd/isis_lspdb.h"
 #include "isisd/include-netbsd/iso.h"
 #include "isisd/isis_constants.h"
 #include "isisd/isis_common.h"
@@ -55,6 +56,8 @@
 #include "isisd/isis_zebra.h"
 #include "isisd/isis_events.h"
 #include "isisd/isis_te.h"
+#include "isisd/isis_flood.h"
+#include "isisd/isis_gr.h"
 
 #ifdef TOPOLOGY_GENERATE
 #include "spgrid.h"
@@ -121,6 +124,7 @@ isis_area_create (const char *area_tag)
   /*
    * intialize the databases
    */
+  area->lsp_aging = lsp_aging_init ();
   if (area->is_type & IS_LEVEL_1)
     {
       area->lspdb[0] = lsp_db_init ();
@@ -142,7 +146,6 @@ isis_area_create (const char *area_tag)
 
   area->circuit_list = list_new ();
   area->area_addrs = list_new ();
-  THREAD_TIMER_ON (master, area->t_tick, lsp_tick, area, 1);
   flags_initialize (&area->flags);
 
   /*
@@ -169,6 +172,8 @@ isis_area_create (const char *area_tag)
   listnode_add (isis->area_list, area);
   area->isis = isis;
 
+  isis_gr_restart_init (area);
+
   return area;
 }
 
@@ -252,8 +257,13 @@ isis_area_destroy (struct vty *vty, const char *area_tag)
       lsp_db_destroy (area->lspdb[1]);
       area->lspdb[1] = NULL;
     }
+  isis_csnp_cache_flush (area, IS_LEVEL_1);
+  isis_csnp_cache_flush (area, IS_LEVEL_2);
+  pqueue_delete (area->lsp_aging);
+  area->lsp_aging = NULL;
 
   spftree_area_del (area);
+  isis_gr_area_del (area);
 
   /* invalidate and validate would delete all routes from zebra */
   isis_route_invalidate (area);
@@ -1334,6 +1344,15 @@ DEFUN (show_isis_summary,
         continue;
 
       vty_out (vty, "  Level-%d:%s", level, VTY_NEWLINE);
+      vty_out (vty, "    LSPs received     : %u (%u redundant)%s",
+               area->lsp_rxed[level - 1], area->lsp_redundant[level - 1],
+               VTY_NEWLINE);
+      if (area->flood_reduction)
+        vty_out (vty, "    Flooding topology : %u point-to-point "
+                 "circuits%s", area->flood_circuits[level - 1], VTY_NEWLINE);
+      vty_out (vty, "    CSNP fragments    : %u built, %u reused%s",
+               area->csnp_built[level - 1], area->csnp_reused[level - 1],
+               VTY_NEWLINE);
       spftree = area->spftree[level - 1];
       if (spftree->pending)
         vty_out (vty, "    IPv4 SPF: (pending)%s", VTY_NEWLINE);
@@ -1350,8 +1369,9 @@ DEFUN (show_isis_summary,
       vty_out (vty, "      last run duration : %u usec%s",
                (u_int32_t)spftree->last_run_duration, VTY_NEWLINE);
 
-      vty_out (vty, "      run count         : %d%s",
-          spftree->runcount, VTY_NEWLINE);
+      vty_out (vty, "      run count         : %d (%u partial, %u shared)%s",
+          spftree->runcount, spftree->prc_runcount, spftree->shared_runcount,
+          VTY_NEWLINE);
 
 #ifdef HAVE_IPV6
       spftree = area->spftree6[level - 1];
@@ -1370,8 +1390,9 @@ DEFUN (show_isis_summary,
       vty_out (vty, "      last run duration : %llu msec%s",
                (unsigned long long)spftree->last_run_duration, VTY_NEWLINE);
 
-      vty_out (vty, "      run count         : %d%s",
-          spftree->runcount, VTY_NEWLINE);
+      vty_out (vty, "      run count         : %d (%u partial, %u shared)%s",
+          spftree->runcount, spftree->prc_runcount, spftree->shared_runcount,
+          VTY_NEWLINE);
 #endif
     }
   }
@@ -1452,7 +1473,7 @@ show_isis_database (struct vty *vty, const char *argv, int ui_level)
 
       for (level = 0; level < ISIS_LEVELS; level++)
         {
-          if (area->lspdb[level] && dict_count (area->lspdb[level]) > 0)
+          if (area->lspdb[level] && lspdb_count (area->lspdb[level]) > 0)
             {
               lsp = NULL;
               if (argv != NULL)
@@ -1713,6 +1734,7 @@ DEFUN (area_passwd_md5,
   area->area_passwd.len = (u_char) len;
   area->area_passwd.type = ISIS_PASSWD_TYPE_HMAC_MD5;
   strncpy ((char *)area->area_passwd.passwd, argv[0], 255);
+  hmac_md5_init (&area->area_passwd.hmac, area->area_passwd.passwd, len);
 
   if (argc > 1)
     {
@@ -1851,6 +1873,7 @@ DEFUN (domain_passwd_md5,
   area->domain_passwd.len = (u_char) len;
   area->domain_passwd.type = ISIS_PASSWD_TYPE_HMAC_MD5;
   strncpy ((char *)area->domain_passwd.passwd, argv[0], 255);
+  hmac_md5_init (&area->domain_passwd.hmac, area->domain_passwd.passwd, len);
 
   if (argc > 1)
     {
@@ -2858,6 +2881,44 @@ DEFUN (no_log_adj_changes,
   return CMD_SUCCESS;
 }
 
+DEFUN (flooding_reduction,
+       flooding_reduction_cmd,
+       "flooding-reduction",
+       "Flood LSPs on the flooding topology only\n")
+{
+  struct isis_area *area;
+  int level;
+
+  area = vty->index;
+  assert (area);
+
+  if (area->flood_reduction)
+    return CMD_SUCCESS;
+
+  area->flood_reduction = 1;
+  for (level = ISIS_LEVEL1; level <= ISIS_LEVELS; level++)
+    if (area->is_type & level)
+      isis_flood_update (area, level);
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (no_flooding_reduction,
+       no_flooding_reduction_cmd,
+       "no flooding-reduction",
+       NO_STR
+       "Flood LSPs on the flooding topology only\n")
+{
+  struct isis_area *area;
+
+  area = vty->index;
+  assert (area);
+
+  area->flood_reduction = 0;
+
+  return CMD_SUCCESS;
+}
+
 #ifdef TOPOLOGY_GENERATE
 
 DEFUN (topology_generate_grid,
@@ -3229,6 +3290,14 @@ isis_config_write (struct vty *vty)
 	    write++;
 	  }
 
+	if (area->flood_reduction)
+	  {
+	    vty_out (vty, " flooding-reduction%s", VTY_NEWLINE);
+	    write++;
+	  }
+
+	write += isis_gr_config_write (vty, area);
+
 #ifdef TOPOLOGY_GENERATE
 	if (memcmp (area->topology_baseis, DEFAULT_TOPOLOGY_BASEIS,
 		    ISIS_SYS_ID_LEN))
@@ -3451,6 +3520,9 @@ isis_init ()
   install_element (ISIS_NODE, &log_adj_changes_cmd);
   install_element (ISIS_NODE, &no_log_adj_changes_cmd);
 
+  install_element (ISIS_NODE, &flooding_reduction_cmd);
+  install_element (ISIS_NODE, &no_flooding_reduction_cmd);
+
 #ifdef TOPOLOGY_GENERATE
   install_element (ISIS_NODE, &topology_generate_grid_cmd);
   install_element (ISIS_NODE, &topology_baseis_cmd);
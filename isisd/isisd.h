@@ -57,7 +57,8 @@ extern struct isis *isis;
 struct isis_area
 {
   struct isis *isis;				  /* back pointer */
-  dict_t *lspdb[ISIS_LEVELS];			  /* link-state dbs */
+  struct lspdb *lspdb[ISIS_LEVELS];		  /* link-state dbs */
+  struct list *csnp_cache[ISIS_LEVELS];		  /* see isis_pdu.h */
   struct isis_spftree *spftree[ISIS_LEVELS];	  /* The v4 SPTs */
   struct route_table *route_table[ISIS_LEVELS];	  /* IPv4 routes */
 #ifdef HAVE_IPV6
@@ -68,7 +69,8 @@ struct isis_area
   unsigned int lsp_mtu;				  /* Size of LSPs to generate */
   struct list *circuit_list;	/* IS-IS circuits */
   struct flags flags;
-  struct thread *t_tick;	/* LSP walker */
+  struct pqueue *lsp_aging;	/* LSPs of both levels, by expiry */
+  struct thread *t_tick;	/* LSP aging, for the earliest expiry */
   struct thread *t_lsp_refresh[ISIS_LEVELS];
   /* t_lsp_refresh is used in two ways:
    * a) regular refresh of LSPs
@@ -113,11 +115,27 @@ struct isis_area
   int ip_circuits;
   /* logging adjacency changes? */
   u_char log_adj_changes;
+  /* flood on the flooding topology only, see isis_flood.h */
+  u_char flood_reduction;
+  /* graceful restart, see isis_gr.h */
+  u_int16_t gr_grace_period;	/* 0 if disabled */
+  u_char gr_helper_disable;
+  u_char gr_prepared;
+  u_char gr_restarting;
+  u_char gr_synced[ISIS_LEVELS];
+  struct thread *t_gr_grace;	/* T3 */
+  struct thread *t_gr_sync[ISIS_LEVELS];	/* T2 */
+  struct thread *t_gr_check;
 #ifdef HAVE_IPV6
   int ipv6_circuits;
 #endif				/* HAVE_IPV6 */
   /* Counters */
   u_int32_t circuit_state_changes;
+  u_int32_t lsp_rxed[ISIS_LEVELS];
+  u_int32_t lsp_redundant[ISIS_LEVELS];
+  u_int32_t flood_circuits[ISIS_LEVELS];
+  u_int32_t csnp_built[ISIS_LEVELS];
+  u_int32_t csnp_reused[ISIS_LEVELS];
   struct isis_redist redist_settings[REDIST_PROTOCOL_COUNT]
                                     [ZEBRA_ROUTE_MAX + 1][ISIS_LEVELS];
   struct route_table *ext_reach[REDIST_PROTOCOL_COUNT][ISIS_LEVELS];
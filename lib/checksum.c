@@ -49,6 +49,306 @@ in_cksum(void *parg, int nbytes)
 /* Fletcher Checksum -- Refer to RFC1008. */
 #define MODX                 4102   /* 5802 should be fine */
 
+/*
+ * The running sums of the Fletcher checksum over a buffer:
+ *   c0 = sum of the bytes, c1 = sum of the successive values of c0,
+ * both modulo 255. This is where the time goes for large LSAs and
+ * LSPs, so beside the byte loop there are a word-at-a-time version and,
+ * on x86, SSSE3 and AVX2 versions. The best SIMD version the CPU
+ * supports is selected on first use, else the byte loop: the word
+ * version is no faster than the byte loop with current compilers, and
+ * is only used when selected by name. All of them give the exact same
+ * sums.
+ */
+typedef void (*fletcher_sum_t) (const u_char *, size_t,
+                                u_int32_t *, u_int32_t *);
+
+static void
+fletcher_sum_generic (const u_char *p, size_t len,
+                      u_int32_t *c0p, u_int32_t *c1p)
+{
+  u_int32_t c0 = *c0p, c1 = *c1p;
+  size_t partial_len, i;
+
+  while (len != 0)
+    {
+      partial_len = MIN(len, MODX);
+
+      for (i = 0; i < partial_len; i++)
+	{
+	  c0 = c0 + *(p++);
+	  c1 += c0;
+	}
+
+      c0 = c0 % 255;
+      c1 = c1 % 255;
+
+      len -= partial_len;
+    }
+
+  *c0p = c0;
+  *c1p = c1;
+}
+
+/*
+ * Word at a time: each 64 bits word is split in four words holding
+ * two bytes each in 32 bits lanes, and for each lane l we keep
+ *   S[l] = sum of its bytes, T[l] = sum of the successive values of S[l]
+ * over a block of FLETCHER_WORDS words. For a block of n bytes, the byte
+ * at offset i weighs (n - i) in c1, that is 8 * (words left) - (i % 8),
+ * hence c1 += n * c0 + 8 * sum (T) - sum ((i % 8) * S).
+ */
+#define FLETCHER_WORDS		2048	/* T[l] < 2^32 */
+#define FLETCHER_LANES		0x000000ff000000ffULL
+
+static void
+fletcher_sum_word (const u_char *p, size_t len,
+                   u_int32_t *c0p, u_int32_t *c1p)
+{
+  u_int64_t c0 = *c0p, c1 = *c1p;
+  u_int64_t w, s[4], t[4], sum_s, sum_t, sum_is;
+  size_t n, words;
+  int l;
+
+  while (len >= sizeof (u_int64_t))
+    {
+      words = MIN(len / sizeof (u_int64_t), FLETCHER_WORDS);
+      n = words * sizeof (u_int64_t);
+
+      for (l = 0; l < 4; l++)
+        s[l] = t[l] = 0;
+
+      while (words-- > 0)
+        {
+          memcpy (&w, p, sizeof (w));
+          p += sizeof (w);
+
+          s[0] += w & FLETCHER_LANES;
+          s[1] += (w >> 8) & FLETCHER_LANES;
+          s[2] += (w >> 16) & FLETCHER_LANES;
+          s[3] += (w >> 24) & FLETCHER_LANES;
+          t[0] += s[0];
+          t[1] += s[1];
+          t[2] += s[2];
+          t[3] += s[3];
+        }
+
+      sum_s = sum_t = sum_is = 0;
+      for (l = 0; l < 4; l++)
+        {
+          u_int64_t lo_s = s[l] & 0xffffffff, hi_s = s[l] >> 32;
+
+          sum_s += lo_s + hi_s;
+          sum_t += (t[l] & 0xffffffff) + (t[l] >> 32);
+#if BYTE_ORDER == BIG_ENDIAN
+          /* low lane is byte 7 - l, high lane is byte 3 - l */
+          sum_is += (7 - l) * lo_s + (3 - l) * hi_s;
+#else
+          /* low lane is byte l, high lane is byte l + 4 */
+          sum_is += l * lo_s + (l + 4) * hi_s;
+#endif
+        }
+
+      c1 = (c1 + n * c0 + 8 * sum_t - sum_is) % 255;
+      c0 = (c0 + sum_s) % 255;
+      len -= n;
+    }
+
+  *c0p = c0;
+  *c1p = c1;
+  if (len)
+    fletcher_sum_generic (p, len, c0p, c1p);
+}
+
+#if defined(__x86_64__) \
+    && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define HAVE_FLETCHER_X86
+#include <immintrin.h>
+
+/*
+ * Same principle with vectors of 16 or 32 bytes: psadbw adds the bytes
+ * for c0, pmaddubsw weighs them by their distance to the end of the
+ * vector for c1, and each vector also adds 16 or 32 times the previous
+ * c0 to c1. The sums are reduced every FLETCHER_VBLOCK bytes, so that
+ * c1 < 255 * n * (n + 1) / 2 + 255 * n + 255 fits in 32 bits.
+ */
+#define FLETCHER_VBLOCK		4096
+
+static inline u_int32_t
+fletcher_hsum128 (__m128i v)
+{
+  v = _mm_add_epi32 (v, _mm_shuffle_epi32 (v, _MM_SHUFFLE (1, 0, 3, 2)));
+  v = _mm_add_epi32 (v, _mm_shuffle_epi32 (v, _MM_SHUFFLE (2, 3, 0, 1)));
+  return _mm_cvtsi128_si32 (v);
+}
+
+__attribute__ ((target ("ssse3")))
+static void
+fletcher_sum_ssse3 (const u_char *p, size_t len,
+                    u_int32_t *c0p, u_int32_t *c1p)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i ones = _mm_set1_epi16 (1);
+  const __m128i weights = _mm_setr_epi8 (16, 15, 14, 13, 12, 11, 10, 9,
+                                         8, 7, 6, 5, 4, 3, 2, 1);
+  u_int32_t c0 = *c0p, c1 = *c1p;
+  size_t n;
+
+  while (len >= 16)
+    {
+      __m128i v_c0, v_c1, v_prev, bytes;
+
+      n = MIN(len, FLETCHER_VBLOCK) & ~(size_t) 15;
+      len -= n;
+
+      v_c0 = zero;
+      v_c1 = _mm_cvtsi32_si128 (c1);
+      v_prev = _mm_cvtsi32_si128 (c0 * (n / 16));
+      for (; n > 0; n -= 16, p += 16)
+        {
+          bytes = _mm_loadu_si128 ((const __m128i *) p);
+          v_prev = _mm_add_epi32 (v_prev, v_c0);
+          v_c0 = _mm_add_epi32 (v_c0, _mm_sad_epu8 (bytes, zero));
+          v_c1 = _mm_add_epi32 (v_c1, _mm_madd_epi16 (
+                                  _mm_maddubs_epi16 (bytes, weights), ones));
+        }
+      v_c1 = _mm_add_epi32 (v_c1, _mm_slli_epi32 (v_prev, 4));
+
+      c0 = (c0 + fletcher_hsum128 (v_c0)) % 255;
+      c1 = fletcher_hsum128 (v_c1) % 255;
+    }
+
+  *c0p = c0;
+  *c1p = c1;
+  if (len)
+    fletcher_sum_generic (p, len, c0p, c1p);
+}
+
+__attribute__ ((target ("avx2")))
+static void
+fletcher_sum_avx2 (const u_char *p, size_t len,
+                   u_int32_t *c0p, u_int32_t *c1p)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i ones = _mm256_set1_epi16 (1);
+  const __m256i weights = _mm256_setr_epi8 (32, 31, 30, 29, 28, 27, 26, 25,
+                                            24, 23, 22, 21, 20, 19, 18, 17,
+                                            16, 15, 14, 13, 12, 11, 10, 9,
+                                            8, 7, 6, 5, 4, 3, 2, 1);
+  u_int32_t c0 = *c0p, c1 = *c1p;
+  size_t n;
+
+  while (len >= 32)
+    {
+      __m256i v_c0, v_c1, v_prev, bytes;
+
+      n = MIN(len, FLETCHER_VBLOCK) & ~(size_t) 31;
+      len -= n;
+
+      v_c0 = zero;
+      v_c1 = _mm256_setr_epi32 (c1, 0, 0, 0, 0, 0, 0, 0);
+      v_prev = _mm256_setr_epi32 (c0 * (n / 32), 0, 0, 0,
+                                  0, 0, 0, 0);
+      for (; n > 0; n -= 32, p += 32)
+        {
+          bytes = _mm256_loadu_si256 ((const __m256i *) p);
+          v_prev = _mm256_add_epi32 (v_prev, v_c0);
+          v_c0 = _mm256_add_epi32 (v_c0, _mm256_sad_epu8 (bytes, zero));
+          v_c1 = _mm256_add_epi32 (v_c1, _mm256_madd_epi16 (
+                                     _mm256_maddubs_epi16 (bytes, weights),
+                                     ones));
+        }
+      v_c1 = _mm256_add_epi32 (v_c1, _mm256_slli_epi32 (v_prev, 5));
+
+      c0 = (c0 + fletcher_hsum128 (
+                   _mm_add_epi32 (_mm256_castsi256_si128 (v_c0),
+                                  _mm256_extracti128_si256 (v_c0, 1)))) % 255;
+      c1 = fletcher_hsum128 (
+             _mm_add_epi32 (_mm256_castsi256_si128 (v_c1),
+                            _mm256_extracti128_si256 (v_c1, 1))) % 255;
+    }
+
+  *c0p = c0;
+  *c1p = c1;
+  /* Not the SSSE3 version, which would pay an AVX to SSE transition */
+  if (len)
+    fletcher_sum_generic (p, len, c0p, c1p);
+}
+
+static int
+fletcher_cpu_ssse3 (void)
+{
+  __builtin_cpu_init ();
+  return __builtin_cpu_supports ("ssse3");
+}
+
+static int
+fletcher_cpu_avx2 (void)
+{
+  __builtin_cpu_init ();
+  return __builtin_cpu_supports ("avx2");
+}
+#endif /* HAVE_FLETCHER_X86 */
+
+/* Implementations, best last. Only those with a CPU check are selected
+   on first use. */
+static const struct
+{
+  const char *name;
+  fletcher_sum_t sum;
+  int (*supported) (void);
+} fletcher_impls[] =
+{
+  { "generic",	fletcher_sum_generic,	NULL },
+  { "word",	fletcher_sum_word,	NULL },
+#ifdef HAVE_FLETCHER_X86
+  { "ssse3",	fletcher_sum_ssse3,	fletcher_cpu_ssse3 },
+  { "avx2",	fletcher_sum_avx2,	fletcher_cpu_avx2 },
+#endif /* HAVE_FLETCHER_X86 */
+};
+
+#define FLETCHER_IMPLS	(sizeof (fletcher_impls) / sizeof (fletcher_impls[0]))
+
+static int fletcher_impl = -1;
+
+static void
+fletcher_impl_init (void)
+{
+  int i;
+
+  for (i = (int) FLETCHER_IMPLS - 1; i > 0; i--)
+    if (fletcher_impls[i].supported && fletcher_impls[i].supported ())
+      break;
+  fletcher_impl = i;
+}
+
+/* Force the implementation used by fletcher_checksum(), e.g. to compare
+   them. Returns -1 if unknown or not supported by this CPU. */
+int
+fletcher_checksum_select (const char *name)
+{
+  unsigned int i;
+
+  for (i = 0; i < FLETCHER_IMPLS; i++)
+    if (strcmp (fletcher_impls[i].name, name) == 0)
+      {
+        if (fletcher_impls[i].supported && !fletcher_impls[i].supported ())
+          return -1;
+        fletcher_impl = i;
+        return 0;
+      }
+
+  return -1;
+}
+
+const char *
+fletcher_checksum_impl (void)
+{
+  if (fletcher_impl < 0)
+    fletcher_impl_init ();
+  return fletcher_impls[fletcher_impl].name;
+}
+
 /* To be consistent, offset is 0-based index, rather than the 1-based 
    index required in the specification ISO 8473, Annex C.1 */
 /* calling with offset == FLETCHER_CHECKSUM_VALIDATE will validate the checksum
@@ -56,11 +356,10 @@ in_cksum(void *parg, int nbytes)
 u_int16_t
 fletcher_checksum(u_char * buffer, const size_t len, const uint16_t offset)
 {
-  u_int8_t *p;
   int x, y, c0, c1;
+  u_int32_t sum0, sum1;
   u_int16_t checksum;
   u_int16_t *csum;
-  size_t partial_len, i, left = len;
   
   checksum = 0;
 
@@ -73,25 +372,13 @@ fletcher_checksum(u_char * buffer, const size_t len, const uint16_t offset)
       *(csum) = 0;
     }
 
-  p = buffer;
-  c0 = 0;
-  c1 = 0;
+  if (fletcher_impl < 0)
+    fletcher_impl_init ();
 
-  while (left != 0)
-    {
-      partial_len = MIN(left, MODX);
-
-      for (i = 0; i < partial_len; i++)
-	{
-	  c0 = c0 + *(p++);
-	  c1 += c0;
-	}
-
-      c0 = c0 % 255;
-      c1 = c1 % 255;
-
-      left -= partial_len;
-    }
+  sum0 = sum1 = 0;
+  fletcher_impls[fletcher_impl].sum (buffer, len, &sum0, &sum1);
+  c0 = sum0;
+  c1 = sum1;
 
   /* The cast is important, to ensure the mod is taken as a signed value. */
   x = (int)((len - offset - 1) * c0 - c1) % 255;
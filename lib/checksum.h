@@ -1,3 +1,5 @@
 extern int in_cksum(void *, int);
 #define FLETCHER_CHECKSUM_VALIDATE 0xffff
 extern u_int16_t fletcher_checksum(u_char *, const size_t len, const uint16_t offset);
+extern int fletcher_checksum_select (const char *);
+extern const char *fletcher_checksum_impl (void);
@@ -895,6 +895,13 @@ static const struct zebra_desc_table command_types[] = {
   DESC_ENTRY	(ZEBRA_ROUTER_ID_DELETE),
   DESC_ENTRY	(ZEBRA_ROUTER_ID_UPDATE),
   DESC_ENTRY	(ZEBRA_HELLO),
+  DESC_ENTRY	(ZEBRA_TED_UPDATE),
+  DESC_ENTRY	(ZEBRA_TED_SUBSCRIBE),
+  DESC_ENTRY	(ZEBRA_TED_SYNC_DONE),
+  DESC_ENTRY	(ZEBRA_ROUTE_PRESERVE),
+  DESC_ENTRY	(ZEBRA_ROUTE_SWEEP),
+  DESC_ENTRY	(ZEBRA_PATHLIST_ADD),
+  DESC_ENTRY	(ZEBRA_PATHLIST_DELETE),
 };
 #undef DESC_ENTRY
 
@@ -309,7 +309,16 @@ int             key_len;		/* length of authentication key */
 uint8_t *       digest;			/* caller digest to be filled in */
 
 {
-    MD5_CTX context;
+    struct hmac_md5_ctx ctx;
+
+    hmac_md5_init(&ctx, key, key_len);
+    hmac_md5_digest(&ctx, text, text_len, digest);
+}
+
+/* Hash the key pads once. */
+void
+hmac_md5_init(struct hmac_md5_ctx *ctx, const unsigned char *key, int key_len)
+{
     unsigned char k_ipad[65];    /* inner padding -
 				 * key XORd with ipad
 				 */
@@ -353,20 +362,29 @@ uint8_t *       digest;			/* caller digest to be filled in */
        k_ipad[i] ^= 0x36;
        k_opad[i] ^= 0x5c;
     }
+
+    MD5Init(&ctx->inner);
+    MD5Update(&ctx->inner, k_ipad, 64);	/* start with inner pad */
+    MD5Init(&ctx->outer);
+    MD5Update(&ctx->outer, k_opad, 64);	/* start with outer pad */
+}
+
+void
+hmac_md5_digest(const struct hmac_md5_ctx *ctx, const unsigned char *text,
+                int text_len, uint8_t *digest)
+{
+    MD5_CTX context;
+
     /*
      * perform inner MD5
      */
-    MD5Init(&context);			/* init context for 1st
-					 * pass */
-    MD5Update(&context, k_ipad, 64);	/* start with inner pad */
+    context = ctx->inner;
     MD5Update(&context, text, text_len); /* then text of datagram */
     MD5Final(digest, &context);	/* finish up 1st pass */
     /*
      * perform outer MD5
      */
-    MD5Init(&context);			/* init context for 2nd
-					 * pass */
-    MD5Update(&context, k_opad, 64);	/* start with outer pad */
+    context = ctx->outer;
     MD5Update(&context, digest, 16);	/* then results of 1st
 					 * hash */
     MD5Final(digest, &context);	/* finish up 2nd pass */
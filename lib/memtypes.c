@@ -73,6 +73,11 @@ struct memory_list memory_list_lib[] =
   { MTYPE_VRF_NAME,		"VRF name"			},
   { MTYPE_VRF_BITMAP,		"VRF bit-map"			},
   { MTYPE_IF_LINK_PARAMS,	"Informational Link Parameters" },
+  { MTYPE_TED,			"TE database"			},
+  { MTYPE_TED_NODE,		"TE database node"		},
+  { MTYPE_TED_LINK,		"TE database link"		},
+  { MTYPE_TED_PREFIX,		"TE database prefix"		},
+  { MTYPE_TED_MSG,		"TE database message"		},
   { -1, NULL },
 };
 
@@ -87,6 +92,7 @@ struct memory_list memory_list_zebra[] =
   { MTYPE_RIB_DEST,		"RIB destination"		},
   { MTYPE_RIB_TABLE_INFO,	"RIB table info"		},
   { MTYPE_NETLINK_NAME,	"Netlink name"			},
+  { MTYPE_PATHLIST,		"Path-list"			},
   { -1, NULL },
 };
 
@@ -118,6 +124,8 @@ struct memory_list memory_list_bgp[] =
   { MTYPE_BGP_ADJ_IN,		"BGP adj in"			},
   { MTYPE_BGP_ADJ_OUT,		"BGP adj out"			},
   { MTYPE_BGP_MPATH_INFO,	"BGP multipath info"		},
+  { MTYPE_BGP_PATHLIST,		"BGP path-list"			},
+  { MTYPE_BGP_ANNOUNCE,		"BGP table announcement"	},
   { 0, NULL },
   { MTYPE_AS_LIST,		"BGP AS list"			},
   { MTYPE_AS_FILTER,		"BGP AS filter"			},
@@ -142,6 +150,10 @@ struct memory_list memory_list_bgp[] =
   { 0, NULL },
   { MTYPE_BGP_PROCESS_QUEUE,	"BGP Process queue"		},
   { MTYPE_BGP_CLEAR_NODE_QUEUE, "BGP node clear queue"		},
+  { MTYPE_BGP_PEER_INDEX,	"BGP peer index"		},
+  { MTYPE_BGP_PEER_INDEX_NODE,	"BGP peer index nodes"		},
+  { MTYPE_BGP_RSVIEW_NODE,	"BGP route server view deltas"	},
+  { MTYPE_BGP_RSVIEW_DELTA,	"BGP route server client deltas" },
   { 0, NULL },
   { MTYPE_TRANSIT,		"BGP transit attr"		},
   { MTYPE_TRANSIT_VAL,		"BGP transit val"		},
@@ -217,6 +229,8 @@ struct memory_list memory_list_ospf[] =
   { MTYPE_OSPF_MESSAGE,		"OSPF message"			},
   { MTYPE_OSPF_MPLS_TE,       "OSPF MPLS parameters"            },
   { MTYPE_OSPF_PCE_PARAMS,    "OSPF PCE parameters"             },
+  { MTYPE_OSPF_TED,           "OSPF TE database"                },
+  { MTYPE_OSPF_CSPF,          "OSPF CSPF"                       },
   { -1, NULL },
 };
 
@@ -256,9 +270,11 @@ struct memory_list memory_list_isis[] =
   { MTYPE_ISIS_ROUTE_INFO,    "ISIS route info"			},
   { MTYPE_ISIS_NEXTHOP,       "ISIS nexthop"			},
   { MTYPE_ISIS_NEXTHOP6,      "ISIS nexthop6"			},
-  { MTYPE_ISIS_DICT,          "ISIS dictionary"			},
-  { MTYPE_ISIS_DICT_NODE,     "ISIS dictionary node"		},
+  { MTYPE_ISIS_LSPDB,         "ISIS LSP database"		},
   { MTYPE_ISIS_MPLS_TE,       "ISIS MPLS_TE parameters"         },
+  { MTYPE_ISIS_TED,           "ISIS TE topology"		},
+  { MTYPE_ISIS_CSPF,          "ISIS CSPF"			},
+  { MTYPE_ISIS_CSNP,          "ISIS CSNP cache"		},
   { -1, NULL },
 };
 
@@ -864,6 +864,41 @@ route_map_apply (struct route_map *map, struct prefix *prefix,
   return RMAP_DENYMATCH;
 }
 
+static int
+route_map_match_find_depth (struct route_map *map, const char *match_name,
+                            int (*func) (void *, void *), void *arg,
+                            int depth)
+{
+  struct route_map_index *index;
+  struct route_map_rule *match;
+
+  if (map == NULL || depth > RMAP_RECURSION_LIMIT)
+    return 0;
+
+  for (index = map->head; index; index = index->next)
+    {
+      for (match = index->match_list.head; match; match = match->next)
+        if (strcmp (match->cmd->str, match_name) == 0
+            && (*func) (match->value, arg))
+          return 1;
+      if (index->nextrm
+          && route_map_match_find_depth (route_map_lookup_by_name
+                                           (index->nextrm),
+                                         match_name, func, arg, depth + 1))
+        return 1;
+    }
+  return 0;
+}
+
+/* Whether the route map, or one it calls, has a match rule of the
+   command for whose compiled value func returns non-zero. */
+int
+route_map_match_find (struct route_map *map, const char *match_name,
+                      int (*func) (void *value, void *arg), void *arg)
+{
+  return route_map_match_find_depth (map, match_name, func, arg, 0);
+}
+
 void
 route_map_add_hook (void (*func) (const char *))
 {
@@ -192,6 +192,12 @@ extern route_map_result_t route_map_apply (struct route_map *map,
                                            route_map_object_t object_type,
                                            void *object);
 
+/* Look for a match rule in the route map. */
+extern int route_map_match_find (struct route_map *map,
+                                 const char *match_name,
+                                 int (*func) (void *value, void *arg),
+                                 void *arg);
+
 extern void route_map_add_hook (void (*func) (const char *));
 extern void route_map_delete_hook (void (*func) (const char *));
 extern void route_map_event_hook (void (*func) (route_map_event_t, const char *));
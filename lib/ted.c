@@ -0,0 +1,851 @@
+/*
+ * Traffic Engineering Database (TED) shared between daemons.
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "memory.h"
+#include "hash.h"
+#include "linklist.h"
+#include "jhash.h"
+#include "stream.h"
+#include "thread.h"
+#include "prefix.h"
+#include "log.h"
+#include "zclient.h"
+#include "ted.h"
+
+/* Hash and compare functions of the TED objects */
+static unsigned int
+ted_id_hash (u_char proto, u_int64_t id, u_int32_t initval)
+{
+  return jhash_3words ((u_int32_t) (id >> 32), (u_int32_t) id, proto,
+                       initval);
+}
+
+static unsigned int
+te_node_hash (void *arg)
+{
+  struct te_node *node = arg;
+
+  return ted_id_hash (node->proto, node->id, 0);
+}
+
+static int
+te_node_cmp (const void *arg1, const void *arg2)
+{
+  const struct te_node *n1 = arg1;
+  const struct te_node *n2 = arg2;
+
+  return n1->proto == n2->proto && n1->id == n2->id;
+}
+
+static unsigned int
+te_link_hash (void *arg)
+{
+  struct te_link *link = arg;
+
+  return jhash_1word (link->local_id,
+                      ted_id_hash (link->proto, link->src,
+                                   ted_id_hash (0, link->dst, 0)));
+}
+
+static int
+te_link_cmp (const void *arg1, const void *arg2)
+{
+  const struct te_link *l1 = arg1;
+  const struct te_link *l2 = arg2;
+
+  return (l1->proto == l2->proto && l1->src == l2->src
+          && l1->dst == l2->dst && l1->local_id == l2->local_id);
+}
+
+static unsigned int
+te_prefix_hash (void *arg)
+{
+  struct te_prefix *pref = arg;
+
+  return jhash (&pref->p.u.prefix, PSIZE (pref->p.prefixlen),
+                ted_id_hash (pref->proto, pref->node,
+                             pref->p.family << 8 | pref->p.prefixlen));
+}
+
+static int
+te_prefix_cmp (const void *arg1, const void *arg2)
+{
+  const struct te_prefix *p1 = arg1;
+  const struct te_prefix *p2 = arg2;
+
+  return (p1->proto == p2->proto && p1->node == p2->node
+          && prefix_same (&p1->p, &p2->p));
+}
+
+struct ted *
+ted_new (void)
+{
+  struct ted *ted;
+
+  ted = XCALLOC (MTYPE_TED, sizeof (struct ted));
+  ted->nodes = hash_create (te_node_hash, te_node_cmp);
+  ted->links = hash_create (te_link_hash, te_link_cmp);
+  ted->prefixes = hash_create (te_prefix_hash, te_prefix_cmp);
+
+  return ted;
+}
+
+static void
+te_node_free (void *node)
+{
+  XFREE (MTYPE_TED_NODE, node);
+}
+
+static void
+te_link_free (void *link)
+{
+  XFREE (MTYPE_TED_LINK, link);
+}
+
+static void
+te_prefix_free (void *pref)
+{
+  XFREE (MTYPE_TED_PREFIX, pref);
+}
+
+void
+ted_clear (struct ted *ted)
+{
+  hash_clean (ted->prefixes, te_prefix_free);
+  hash_clean (ted->links, te_link_free);
+  hash_clean (ted->nodes, te_node_free);
+}
+
+void
+ted_free (struct ted *ted)
+{
+  ted_clear (ted);
+  hash_free (ted->prefixes);
+  hash_free (ted->links);
+  hash_free (ted->nodes);
+  XFREE (MTYPE_TED, ted);
+}
+
+struct te_node *
+te_node_lookup (struct ted *ted, u_char proto, u_int64_t id)
+{
+  struct te_node key;
+
+  key.proto = proto;
+  key.id = id;
+  return hash_lookup (ted->nodes, &key);
+}
+
+static void *
+te_node_alloc (void *arg)
+{
+  struct te_node *node;
+
+  node = XMALLOC (MTYPE_TED_NODE, sizeof (struct te_node));
+  *node = *(struct te_node *) arg;
+  return node;
+}
+
+static void *
+te_link_alloc (void *arg)
+{
+  struct te_link *link;
+
+  link = XMALLOC (MTYPE_TED_LINK, sizeof (struct te_link));
+  *link = *(struct te_link *) arg;
+  return link;
+}
+
+static void *
+te_prefix_alloc (void *arg)
+{
+  struct te_prefix *pref;
+
+  pref = XMALLOC (MTYPE_TED_PREFIX, sizeof (struct te_prefix));
+  *pref = *(struct te_prefix *) arg;
+  return pref;
+}
+
+static int
+ted_apply_node (struct ted *ted, struct te_msg *msg)
+{
+  struct te_node *node = &msg->u.node;
+  struct te_node *old;
+
+  old = hash_lookup (ted->nodes, node);
+
+  if (msg->event == TED_EVENT_DELETE)
+    {
+      if (old == NULL)
+        return 0;
+      /* Report the last known content */
+      *node = *old;
+      hash_release (ted->nodes, old);
+      te_node_free (old);
+      return TED_EVENT_DELETE;
+    }
+
+  if (old == NULL)
+    {
+      hash_get (ted->nodes, node, te_node_alloc);
+      return TED_EVENT_ADD;
+    }
+  if (old->flags == node->flags
+      && old->router_id.s_addr == node->router_id.s_addr)
+    return 0;
+  *old = *node;
+  return TED_EVENT_UPDATE;
+}
+
+static int
+ted_apply_link (struct ted *ted, struct te_msg *msg)
+{
+  struct te_link *link = &msg->u.link;
+  struct te_link *old;
+
+  old = hash_lookup (ted->links, link);
+
+  if (msg->event == TED_EVENT_DELETE)
+    {
+      if (old == NULL)
+        return 0;
+      *link = *old;
+      hash_release (ted->links, old);
+      te_link_free (old);
+      return TED_EVENT_DELETE;
+    }
+
+  if (old == NULL)
+    {
+      hash_get (ted->links, link, te_link_alloc);
+      return TED_EVENT_ADD;
+    }
+  /* struct te_attr has no padding and is always fully initialized */
+  if (memcmp (&old->attr, &link->attr, sizeof (struct te_attr)) == 0)
+    return 0;
+  old->attr = link->attr;
+  return TED_EVENT_UPDATE;
+}
+
+static int
+ted_apply_prefix (struct ted *ted, struct te_msg *msg)
+{
+  struct te_prefix *pref = &msg->u.prefix;
+  struct te_prefix *old;
+
+  old = hash_lookup (ted->prefixes, pref);
+
+  if (msg->event == TED_EVENT_DELETE)
+    {
+      if (old == NULL)
+        return 0;
+      *pref = *old;
+      hash_release (ted->prefixes, old);
+      te_prefix_free (old);
+      return TED_EVENT_DELETE;
+    }
+
+  if (old == NULL)
+    {
+      hash_get (ted->prefixes, pref, te_prefix_alloc);
+      return TED_EVENT_ADD;
+    }
+  if (old->metric == pref->metric && old->flags == pref->flags)
+    return 0;
+  old->metric = pref->metric;
+  old->flags = pref->flags;
+  return TED_EVENT_UPDATE;
+}
+
+/*
+ * Apply one change to the TED. Returns the resulting event, which is
+ * TED_EVENT_ADD for an update of an unknown object, or 0 if the TED
+ * has not been modified. On success, msg->event is set accordingly
+ * and the notify callback, if any, is invoked.
+ */
+int
+ted_apply (struct ted *ted, struct te_msg *msg)
+{
+  int event;
+
+  switch (msg->type)
+    {
+    case TED_TYPE_NODE:
+      event = ted_apply_node (ted, msg);
+      break;
+    case TED_TYPE_LINK:
+      event = ted_apply_link (ted, msg);
+      break;
+    case TED_TYPE_PREFIX:
+      event = ted_apply_prefix (ted, msg);
+      break;
+    default:
+      return 0;
+    }
+
+  if (event == 0)
+    return 0;
+
+  msg->event = event;
+  if (ted->notify)
+    (*ted->notify) (ted, msg);
+
+  return event;
+}
+
+/* Walk the TED: nodes first, then links and prefixes. */
+struct ted_walk_arg
+{
+  struct ted *ted;
+  u_char type;
+  void (*func) (struct ted *, struct te_msg *, void *);
+  void *arg;
+};
+
+static void
+ted_walk_object (struct hash_backet *backet, void *arg)
+{
+  struct ted_walk_arg *wa = arg;
+  struct te_msg msg;
+
+  memset (&msg, 0, sizeof (struct te_msg));
+  msg.event = TED_EVENT_ADD;
+  msg.type = wa->type;
+  switch (wa->type)
+    {
+    case TED_TYPE_NODE:
+      msg.u.node = *(struct te_node *) backet->data;
+      break;
+    case TED_TYPE_LINK:
+      msg.u.link = *(struct te_link *) backet->data;
+      break;
+    case TED_TYPE_PREFIX:
+      msg.u.prefix = *(struct te_prefix *) backet->data;
+      break;
+    }
+
+  (*wa->func) (wa->ted, &msg, wa->arg);
+}
+
+void
+ted_walk (struct ted *ted,
+          void (*func) (struct ted *, struct te_msg *, void *), void *arg)
+{
+  struct ted_walk_arg wa;
+
+  wa.ted = ted;
+  wa.func = func;
+  wa.arg = arg;
+
+  wa.type = TED_TYPE_NODE;
+  hash_iterate (ted->nodes, ted_walk_object, &wa);
+  wa.type = TED_TYPE_LINK;
+  hash_iterate (ted->links, ted_walk_object, &wa);
+  wa.type = TED_TYPE_PREFIX;
+  hash_iterate (ted->prefixes, ted_walk_object, &wa);
+}
+
+/* Remove all objects of a protocol, e.g. when its daemon goes away. */
+struct ted_flush_arg
+{
+  u_char proto;
+  struct list *list;
+};
+
+static void
+ted_flush_collect (struct ted *ted, struct te_msg *msg, void *arg)
+{
+  struct ted_flush_arg *fa = arg;
+  struct te_msg *copy;
+  u_char proto;
+
+  switch (msg->type)
+    {
+    case TED_TYPE_NODE:
+      proto = msg->u.node.proto;
+      break;
+    case TED_TYPE_LINK:
+      proto = msg->u.link.proto;
+      break;
+    default:
+      proto = msg->u.prefix.proto;
+      break;
+    }
+  if (proto != fa->proto)
+    return;
+
+  copy = XMALLOC (MTYPE_TMP, sizeof (struct te_msg));
+  *copy = *msg;
+  copy->event = TED_EVENT_DELETE;
+  listnode_add (fa->list, copy);
+}
+
+void
+ted_flush_proto (struct ted *ted, u_char proto)
+{
+  struct ted_flush_arg fa;
+  struct listnode *node, *nnode;
+  struct te_msg *msg;
+
+  fa.proto = proto;
+  fa.list = list_new ();
+
+  /* Objects can not be released while walking the hash tables */
+  ted_walk (ted, ted_flush_collect, &fa);
+
+  /* Remove prefixes and links before their nodes */
+  for (ALL_LIST_ELEMENTS (fa.list, node, nnode, msg))
+    if (msg->type != TED_TYPE_NODE)
+      {
+        ted_apply (ted, msg);
+        XFREE (MTYPE_TMP, msg);
+        list_delete_node (fa.list, node);
+      }
+  for (ALL_LIST_ELEMENTS_RO (fa.list, node, msg))
+    {
+      ted_apply (ted, msg);
+      XFREE (MTYPE_TMP, msg);
+    }
+
+  list_delete (fa.list);
+}
+
+/*
+ * Encoding of one TED message entry:
+ *
+ *  event (1) | type (1) | length (2) | body (length)
+ *
+ * For deletions, the body only carries the object key.
+ */
+static void
+ted_attr_encode (struct stream *s, struct te_attr *attr)
+{
+  int i;
+
+  stream_putl (s, attr->flags);
+  stream_putl (s, attr->metric);
+  stream_putl (s, attr->te_metric);
+  stream_putf (s, attr->max_bw);
+  stream_putf (s, attr->max_rsv_bw);
+  for (i = 0; i < MAX_CLASS_TYPE; i++)
+    stream_putf (s, attr->unrsv_bw[i]);
+  stream_putl (s, attr->admin_grp);
+  stream_put_in_addr (s, &attr->local);
+  stream_put_in_addr (s, &attr->remote);
+  stream_putl (s, attr->av_delay);
+  stream_putl (s, attr->min_delay);
+  stream_putl (s, attr->max_delay);
+  stream_putl (s, attr->delay_var);
+  stream_putl (s, attr->pkt_loss);
+  stream_putf (s, attr->res_bw);
+  stream_putf (s, attr->ava_bw);
+  stream_putf (s, attr->use_bw);
+  stream_putl (s, attr->rmt_as);
+  stream_put_in_addr (s, &attr->rmt_ip);
+}
+
+static void
+ted_attr_decode (struct stream *s, struct te_attr *attr)
+{
+  int i;
+
+  attr->flags = stream_getl (s);
+  attr->metric = stream_getl (s);
+  attr->te_metric = stream_getl (s);
+  attr->max_bw = stream_getf (s);
+  attr->max_rsv_bw = stream_getf (s);
+  for (i = 0; i < MAX_CLASS_TYPE; i++)
+    attr->unrsv_bw[i] = stream_getf (s);
+  attr->admin_grp = stream_getl (s);
+  attr->local.s_addr = stream_get_ipv4 (s);
+  attr->remote.s_addr = stream_get_ipv4 (s);
+  attr->av_delay = stream_getl (s);
+  attr->min_delay = stream_getl (s);
+  attr->max_delay = stream_getl (s);
+  attr->delay_var = stream_getl (s);
+  attr->pkt_loss = stream_getl (s);
+  attr->res_bw = stream_getf (s);
+  attr->ava_bw = stream_getf (s);
+  attr->use_bw = stream_getf (s);
+  attr->rmt_as = stream_getl (s);
+  attr->rmt_ip.s_addr = stream_get_ipv4 (s);
+}
+
+/* Returns the number of bytes written, 0 if there is not enough room. */
+int
+ted_msg_encode (struct stream *s, struct te_msg *msg)
+{
+  size_t start, lenp;
+
+  if (STREAM_WRITEABLE (s) < TED_MSG_ENTRY_MAX)
+    return 0;
+
+  start = stream_get_endp (s);
+  stream_putc (s, msg->event);
+  stream_putc (s, msg->type);
+  lenp = stream_get_endp (s);
+  stream_putw (s, 0);
+
+  switch (msg->type)
+    {
+    case TED_TYPE_NODE:
+      stream_putc (s, msg->u.node.proto);
+      stream_putq (s, msg->u.node.id);
+      if (msg->event == TED_EVENT_DELETE)
+        break;
+      stream_putc (s, msg->u.node.flags);
+      stream_put_in_addr (s, &msg->u.node.router_id);
+      break;
+    case TED_TYPE_LINK:
+      stream_putc (s, msg->u.link.proto);
+      stream_putq (s, msg->u.link.src);
+      stream_putq (s, msg->u.link.dst);
+      stream_putl (s, msg->u.link.local_id);
+      if (msg->event == TED_EVENT_DELETE)
+        break;
+      ted_attr_encode (s, &msg->u.link.attr);
+      break;
+    case TED_TYPE_PREFIX:
+      stream_putc (s, msg->u.prefix.proto);
+      stream_putq (s, msg->u.prefix.node);
+      stream_putc (s, msg->u.prefix.p.family);
+      stream_putc (s, msg->u.prefix.p.prefixlen);
+      stream_put (s, &msg->u.prefix.p.u.prefix,
+                  PSIZE (msg->u.prefix.p.prefixlen));
+      if (msg->event == TED_EVENT_DELETE)
+        break;
+      stream_putl (s, msg->u.prefix.metric);
+      stream_putc (s, msg->u.prefix.flags);
+      break;
+    default:
+      stream_set_endp (s, start);
+      return 0;
+    }
+
+  stream_putw_at (s, lenp, stream_get_endp (s) - lenp - 2);
+  return stream_get_endp (s) - start;
+}
+
+/* Returns 0 on success, -1 if the entry is malformed. */
+int
+ted_msg_decode (struct stream *s, struct te_msg *msg)
+{
+  u_int16_t length;
+  size_t start;
+  u_char plen;
+
+  memset (msg, 0, sizeof (struct te_msg));
+
+  if (STREAM_READABLE (s) < 4)
+    return -1;
+
+  msg->event = stream_getc (s);
+  msg->type = stream_getc (s);
+  length = stream_getw (s);
+  if (length > STREAM_READABLE (s))
+    return -1;
+  start = stream_get_getp (s);
+
+  switch (msg->type)
+    {
+    case TED_TYPE_NODE:
+      if (length < 9)
+        return -1;
+      msg->u.node.proto = stream_getc (s);
+      msg->u.node.id = stream_getq (s);
+      if (msg->event == TED_EVENT_DELETE)
+        break;
+      if (length < 14)
+        return -1;
+      msg->u.node.flags = stream_getc (s);
+      msg->u.node.router_id.s_addr = stream_get_ipv4 (s);
+      break;
+    case TED_TYPE_LINK:
+      if (length < 21)
+        return -1;
+      msg->u.link.proto = stream_getc (s);
+      msg->u.link.src = stream_getq (s);
+      msg->u.link.dst = stream_getq (s);
+      msg->u.link.local_id = stream_getl (s);
+      if (msg->event == TED_EVENT_DELETE)
+        break;
+      if (length < 21 + 72 + 4 * MAX_CLASS_TYPE)
+        return -1;
+      ted_attr_decode (s, &msg->u.link.attr);
+      break;
+    case TED_TYPE_PREFIX:
+      if (length < 11)
+        return -1;
+      msg->u.prefix.proto = stream_getc (s);
+      msg->u.prefix.node = stream_getq (s);
+      msg->u.prefix.p.family = stream_getc (s);
+      plen = stream_getc (s);
+      if (plen > prefix_blen (&msg->u.prefix.p) * 8
+          || length < 11 + PSIZE (plen))
+        return -1;
+      msg->u.prefix.p.prefixlen = plen;
+      stream_get (&msg->u.prefix.p.u.prefix, s, PSIZE (plen));
+      if (msg->event == TED_EVENT_DELETE)
+        break;
+      if (length < 16 + PSIZE (plen))
+        return -1;
+      msg->u.prefix.metric = stream_getl (s);
+      msg->u.prefix.flags = stream_getc (s);
+      break;
+    default:
+      /* Skip unknown types for forward compatibility */
+      break;
+    }
+
+  stream_set_getp (s, start + length);
+  return 0;
+}
+
+const char *
+ted_type2str (u_char type)
+{
+  switch (type)
+    {
+    case TED_TYPE_NODE:
+      return "Node";
+    case TED_TYPE_LINK:
+      return "Link";
+    case TED_TYPE_PREFIX:
+      return "Prefix";
+    default:
+      return "Unknown";
+    }
+}
+
+const char *
+ted_event2str (u_char event)
+{
+  switch (event)
+    {
+    case TED_EVENT_UPDATE:
+      return "Update";
+    case TED_EVENT_DELETE:
+      return "Delete";
+    case TED_EVENT_ADD:
+      return "Add";
+    default:
+      return "Unknown";
+    }
+}
+
+const char *
+ted_id2str (u_char proto, u_int64_t id, char *buf, size_t size)
+{
+  struct in_addr addr;
+
+  switch (proto)
+    {
+    case ZEBRA_ROUTE_OSPF:
+      addr.s_addr = htonl ((u_int32_t) (id >> 32));
+      snprintf (buf, size, "%s%s", inet_ntoa (addr),
+                (id & TED_NODE_PSEUDO) ? "(net)" : "");
+      break;
+    case ZEBRA_ROUTE_ISIS:
+      snprintf (buf, size, "%04x.%04x.%04x.%02x/L%u",
+                (u_int16_t) (id >> 48), (u_int16_t) (id >> 32),
+                (u_int16_t) (id >> 16), (u_char) (id >> 8), (u_char) id);
+      break;
+    default:
+      snprintf (buf, size, "%016llx", (unsigned long long) id);
+      break;
+    }
+  return buf;
+}
+
+/*
+ * Daemon side batch of changes.
+ */
+static unsigned int
+ted_batch_key (void *arg)
+{
+  struct te_msg *msg = arg;
+
+  switch (msg->type)
+    {
+    case TED_TYPE_NODE:
+      return te_node_hash (&msg->u.node);
+    case TED_TYPE_LINK:
+      return te_link_hash (&msg->u.link);
+    default:
+      return te_prefix_hash (&msg->u.prefix);
+    }
+}
+
+static int
+ted_batch_cmp (const void *arg1, const void *arg2)
+{
+  const struct te_msg *m1 = arg1;
+  const struct te_msg *m2 = arg2;
+
+  if (m1->type != m2->type)
+    return 0;
+  switch (m1->type)
+    {
+    case TED_TYPE_NODE:
+      return te_node_cmp (&m1->u.node, &m2->u.node);
+    case TED_TYPE_LINK:
+      return te_link_cmp (&m1->u.link, &m2->u.link);
+    default:
+      return te_prefix_cmp (&m1->u.prefix, &m2->u.prefix);
+    }
+}
+
+static void *
+ted_batch_msg_alloc (void *arg)
+{
+  struct te_msg *msg;
+
+  msg = XMALLOC (MTYPE_TED_MSG, sizeof (struct te_msg));
+  *msg = *(struct te_msg *) arg;
+  return msg;
+}
+
+static void
+ted_batch_msg_free (void *msg)
+{
+  XFREE (MTYPE_TED_MSG, msg);
+}
+
+static void
+ted_batch_reset (struct ted_batch *batch)
+{
+  stream_reset (batch->s);
+  zclient_create_header (batch->s, ZEBRA_TED_UPDATE, VRF_DEFAULT);
+  stream_putw (batch->s, 0);
+  batch->count = 0;
+}
+
+struct ted_batch *
+ted_batch_new (struct zclient *zclient, struct thread_master *master)
+{
+  struct ted_batch *batch;
+
+  batch = XCALLOC (MTYPE_TED, sizeof (struct ted_batch));
+  batch->zclient = zclient;
+  batch->master = master;
+  batch->s = stream_new (ZEBRA_MAX_PACKET_SIZ);
+  batch->deletes = hash_create (ted_batch_key, ted_batch_cmp);
+  ted_batch_reset (batch);
+
+  return batch;
+}
+
+void
+ted_batch_free (struct ted_batch *batch)
+{
+  THREAD_OFF (batch->t_flush);
+  hash_clean (batch->deletes, ted_batch_msg_free);
+  hash_free (batch->deletes);
+  stream_free (batch->s);
+  XFREE (MTYPE_TED, batch);
+}
+
+/* Send the pending message, if any, to zebra */
+static void
+ted_batch_send (struct ted_batch *batch)
+{
+  struct zclient *zclient = batch->zclient;
+  struct stream *s;
+
+  if (batch->count == 0)
+    return;
+
+  if (zclient != NULL && zclient->sock >= 0)
+    {
+      stream_putw_at (batch->s, 0, stream_get_endp (batch->s));
+      stream_putw_at (batch->s, ZEBRA_HEADER_SIZE, batch->count);
+
+      s = zclient->obuf;
+      stream_reset (s);
+      stream_put (s, STREAM_DATA (batch->s), stream_get_endp (batch->s));
+      zclient_send_message (zclient);
+
+      batch->msgs++;
+      batch->objects += batch->count;
+    }
+
+  ted_batch_reset (batch);
+}
+
+static void
+ted_batch_put (struct ted_batch *batch, struct te_msg *msg)
+{
+  if (ted_msg_encode (batch->s, msg) == 0)
+    {
+      ted_batch_send (batch);
+      ted_msg_encode (batch->s, msg);
+    }
+  batch->count++;
+}
+
+static void
+ted_batch_put_delete (struct hash_backet *backet, void *arg)
+{
+  ted_batch_put ((struct ted_batch *) arg, (struct te_msg *) backet->data);
+}
+
+void
+ted_batch_flush (struct ted_batch *batch)
+{
+  THREAD_OFF (batch->t_flush);
+
+  hash_iterate (batch->deletes, ted_batch_put_delete, batch);
+  hash_clean (batch->deletes, ted_batch_msg_free);
+
+  ted_batch_send (batch);
+}
+
+static int
+ted_batch_timer (struct thread *thread)
+{
+  struct ted_batch *batch = THREAD_ARG (thread);
+
+  batch->t_flush = NULL;
+  ted_batch_flush (batch);
+  return 0;
+}
+
+void
+ted_batch_add (struct ted_batch *batch, struct te_msg *msg)
+{
+  struct te_msg *pending;
+
+  if (msg->event == TED_EVENT_DELETE)
+    hash_get (batch->deletes, msg, ted_batch_msg_alloc);
+  else
+    {
+      /* The update supersedes a deletion not sent yet */
+      if ((pending = hash_release (batch->deletes, msg)) != NULL)
+        ted_batch_msg_free (pending);
+      ted_batch_put (batch, msg);
+    }
+
+  if (batch->t_flush == NULL)
+    batch->t_flush = thread_add_event (batch->master, ted_batch_timer,
+                                       batch, 0);
+}
@@ -0,0 +1,209 @@
+/*
+ * Traffic Engineering Database (TED) shared between daemons.
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _ZEBRA_TED_H
+#define _ZEBRA_TED_H
+
+#include "prefix.h"
+#include "if.h"
+
+/*
+ * The IGPs (ospfd, isisd) export the topology they learn to zebra as a
+ * stream of node, link and prefix changes, carried in ZEBRA_TED_UPDATE
+ * messages. Zebra merges them in one TED and forwards the changes that
+ * actually modify it to the subscribed clients. A client subscribing
+ * with ZEBRA_TED_SUBSCRIBE first receives the whole TED as a series of
+ * ZEBRA_TED_UPDATE messages, each packing as many objects as fit in
+ * one ZAPI message, then ZEBRA_TED_SYNC_DONE.
+ *
+ * Objects are identified by the originating protocol (ZEBRA_ROUTE_xxx)
+ * and a 64 bits node identifier built by the IGP:
+ *  - OSPF:  Router ID (or DR interface address) << 32 | pseudo flag
+ *  - IS-IS: System ID << 16 | pseudonode ID << 8 | level
+ */
+
+/* Object events */
+#define TED_EVENT_UPDATE	1	/* add or modify */
+#define TED_EVENT_DELETE	2
+#define TED_EVENT_ADD		3	/* only sent by zebra to subscribers */
+
+/* Object types */
+#define TED_TYPE_NODE		1
+#define TED_TYPE_LINK		2
+#define TED_TYPE_PREFIX		3
+
+/* Flags to indicate which link attributes are set */
+#define TED_ATTR_TE_METRIC	0x00000001
+#define TED_ATTR_MAX_BW		0x00000002
+#define TED_ATTR_MAX_RSV_BW	0x00000004
+#define TED_ATTR_UNRSV_BW	0x00000008
+#define TED_ATTR_ADM_GRP	0x00000010
+#define TED_ATTR_LOCAL_ADDR	0x00000020
+#define TED_ATTR_REMOTE_ADDR	0x00000040
+#define TED_ATTR_AV_DELAY	0x00000080
+#define TED_ATTR_MM_DELAY	0x00000100
+#define TED_ATTR_DELAY_VAR	0x00000200
+#define TED_ATTR_PKT_LOSS	0x00000400
+#define TED_ATTR_RES_BW		0x00000800
+#define TED_ATTR_AVA_BW		0x00001000
+#define TED_ATTR_USE_BW		0x00002000
+#define TED_ATTR_RMT_AS		0x00004000
+#define TED_ATTR_RMT_IP		0x00008000
+#define TED_ATTR_METRIC		0x00010000
+
+/* Link attributes, host byte order */
+struct te_attr
+{
+  u_int32_t flags;
+
+  u_int32_t metric;		/* IGP metric */
+  u_int32_t te_metric;
+  float max_bw;
+  float max_rsv_bw;
+  float unrsv_bw[MAX_CLASS_TYPE];
+  u_int32_t admin_grp;
+  struct in_addr local;
+  struct in_addr remote;
+  u_int32_t av_delay;
+  u_int32_t min_delay;
+  u_int32_t max_delay;
+  u_int32_t delay_var;
+  u_int32_t pkt_loss;
+  float res_bw;
+  float ava_bw;
+  float use_bw;
+  u_int32_t rmt_as;
+  struct in_addr rmt_ip;
+};
+
+#define TED_NODE_PSEUDO		0x01
+
+struct te_node
+{
+  /* Key */
+  u_char proto;
+  u_int64_t id;
+
+  u_char flags;
+  struct in_addr router_id;	/* TE Router ID */
+};
+
+struct te_link
+{
+  /* Key: a link is unique for its source, destination and local id */
+  u_char proto;
+  u_int64_t src;
+  u_int64_t dst;
+  u_int32_t local_id;		/* OSPF TE LSA ID, IS-IS interface id */
+
+  struct te_attr attr;
+};
+
+struct te_prefix
+{
+  /* Key */
+  u_char proto;
+  u_int64_t node;
+  struct prefix p;
+
+  u_int32_t metric;
+  u_char flags;
+};
+
+/* One decoded TED message entry */
+struct te_msg
+{
+  u_char event;
+  u_char type;
+  union
+  {
+    struct te_node node;
+    struct te_link link;
+    struct te_prefix prefix;
+  } u;
+};
+
+struct ted
+{
+  struct hash *nodes;
+  struct hash *links;
+  struct hash *prefixes;
+
+  /* Called for each change actually applied to the TED */
+  void (*notify) (struct ted *, struct te_msg *);
+  void *info;
+};
+
+/*
+ * Daemon side batching of TED changes. Changes are packed in one
+ * ZEBRA_TED_UPDATE message which is sent when full, or at the latest
+ * from an event thread, so that a burst of LSDB changes goes out in a
+ * few messages. Deletions are held until the message is sent, so a
+ * delete immediately followed by the update of the same object (an
+ * LSA replaced in the LSDB) is sent as a single update.
+ */
+struct ted_batch
+{
+  struct zclient *zclient;
+  struct thread_master *master;
+
+  struct stream *s;
+  u_int16_t count;
+  struct hash *deletes;
+  struct thread *t_flush;
+
+  /* Statistics */
+  u_int32_t msgs;
+  u_int32_t objects;
+};
+
+/* Size of the ZEBRA_TED_UPDATE entry count */
+#define TED_MSG_HEADER_SIZE	2
+
+/* Largest encoded entry */
+#define TED_MSG_ENTRY_MAX	160
+
+/* Prototypes. */
+extern struct ted *ted_new (void);
+extern void ted_free (struct ted *);
+extern void ted_clear (struct ted *);
+
+extern int ted_apply (struct ted *, struct te_msg *);
+extern void ted_flush_proto (struct ted *, u_char);
+
+extern struct te_node *te_node_lookup (struct ted *, u_char, u_int64_t);
+extern void ted_walk (struct ted *, void (*) (struct ted *, struct te_msg *,
+                                              void *), void *);
+
+extern int ted_msg_encode (struct stream *, struct te_msg *);
+extern int ted_msg_decode (struct stream *, struct te_msg *);
+
+extern const char *ted_type2str (u_char);
+extern const char *ted_event2str (u_char);
+extern const char *ted_id2str (u_char, u_int64_t, char *, size_t);
+
+extern struct ted_batch *ted_batch_new (struct zclient *,
+                                        struct thread_master *);
+extern void ted_batch_free (struct ted_batch *);
+extern void ted_batch_add (struct ted_batch *, struct te_msg *);
+extern void ted_batch_flush (struct ted_batch *);
+
+#endif /* _ZEBRA_TED_H */
@@ -145,7 +145,9 @@ work_queue_add (struct work_queue *wq, void *data)
   item->data = data;
   listnode_add (wq->items, item);
   
-  work_queue_schedule (wq, wq->spec.hold);
+  /* items added by the run itself go right after it, not after the hold */
+  if (!CHECK_FLAG (wq->flags, WQ_RUNNING))
+    work_queue_schedule (wq, wq->spec.hold);
   
   return;
 }
@@ -259,6 +261,8 @@ work_queue_run (struct thread *thread)
 
   assert (wq && wq->items);
 
+  SET_FLAG (wq->flags, WQ_RUNNING);
+
   /* calculate cycle granularity:
    * list iteration == 1 cycle
    * granularity == # cycles between checks whether we should yield.
@@ -377,6 +381,8 @@ stats:
   wq->runs++;
   wq->cycles.total += cycles;
 
+  UNSET_FLAG (wq->flags, WQ_RUNNING);
+
 #if 0
   printf ("%s: cycles %d, new: best %d, worst %d\n",
             __func__, cycles, wq->cycles.best, wq->cycles.granularity);
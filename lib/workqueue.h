@@ -48,6 +48,7 @@ struct work_queue_item
 };
 
 #define WQ_UNPLUGGED	(1 << 0) /* available for draining */
+#define WQ_RUNNING	(1 << 1) /* items being run, rescheduled at the end */
 
 struct work_queue
 {
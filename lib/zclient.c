@@ -574,6 +574,8 @@ zapi_ipv4_route (u_char cmd, struct zclient *zclient, struct prefix_ipv4 *p,
     stream_putl (s, api->metric);
   if (CHECK_FLAG (api->message, ZAPI_MESSAGE_MTU))
     stream_putl (s, api->mtu);
+  if (CHECK_FLAG (api->message, ZAPI_MESSAGE_PATHLIST))
+    stream_putl (s, api->pathlist);
 
   /* Put length at the first point of the stream. */
   stream_putw_at (s, 0, stream_get_endp (s));
@@ -630,6 +632,8 @@ zapi_ipv6_route (u_char cmd, struct zclient *zclient, struct prefix_ipv6 *p,
     stream_putl (s, api->metric);
   if (CHECK_FLAG (api->message, ZAPI_MESSAGE_MTU))
     stream_putl (s, api->mtu);
+  if (CHECK_FLAG (api->message, ZAPI_MESSAGE_PATHLIST))
+    stream_putl (s, api->pathlist);
 
   /* Put length at the first point of the stream. */
   stream_putw_at (s, 0, stream_get_endp (s));
@@ -661,6 +665,111 @@ zebra_redistribute_send (int command, struct zclient *zclient, int type,
   return zclient_send_message(zclient);
 }
 
+/* Subscribe to (or unsubscribe from) the TE database of zebra. Upon
+   subscription, zebra sends the whole TED followed by
+   ZEBRA_TED_SYNC_DONE, then the incremental changes. */
+int
+zebra_ted_subscribe_send (struct zclient *zclient, int subscribe)
+{
+  struct stream *s;
+
+  s = zclient->obuf;
+  stream_reset(s);
+
+  zclient_create_header (s, ZEBRA_TED_SUBSCRIBE, VRF_DEFAULT);
+  stream_putc (s, subscribe ? 1 : 0);
+
+  stream_putw_at (s, 0, stream_get_endp (s));
+
+  return zclient_send_message(zclient);
+}
+
+/* Ask zebra to keep the routes of this type for stale_time seconds
+   when the connection of the client closes, for a graceful restart. A
+   stale_time of 0 cancels the request. */
+int
+zebra_route_preserve_send (struct zclient *zclient, u_char type,
+                           u_int32_t stale_time)
+{
+  struct stream *s;
+
+  s = zclient->obuf;
+  stream_reset(s);
+
+  zclient_create_header (s, ZEBRA_ROUTE_PRESERVE, VRF_DEFAULT);
+  stream_putc (s, type);
+  stream_putl (s, stale_time);
+
+  stream_putw_at (s, 0, stream_get_endp (s));
+
+  return zclient_send_message(zclient);
+}
+
+/* The restarted client has sent all its routes again: remove those
+   of this type zebra kept, and which were not refreshed. */
+int
+zebra_route_sweep_send (struct zclient *zclient, u_char type)
+{
+  struct stream *s;
+
+  s = zclient->obuf;
+  stream_reset(s);
+
+  zclient_create_header (s, ZEBRA_ROUTE_SWEEP, VRF_DEFAULT);
+  stream_putc (s, type);
+
+  stream_putw_at (s, 0, stream_get_endp (s));
+
+  return zclient_send_message(zclient);
+}
+
+/* Add or replace (ZEBRA_PATHLIST_ADD), or delete (ZEBRA_PATHLIST_DELETE)
+   a path-list. The routes which reference it follow its nexthops. */
+int
+zapi_pathlist (u_char cmd, struct zclient *zclient,
+               struct zapi_pathlist *api)
+{
+  int i;
+  struct stream *s;
+
+  s = zclient->obuf;
+  stream_reset (s);
+
+  zclient_create_header (s, cmd, VRF_DEFAULT);
+  stream_putc (s, api->type);
+  stream_putl (s, api->id);
+
+  if (cmd == ZEBRA_PATHLIST_ADD)
+    {
+      stream_putc (s, api->nexthop_num);
+      for (i = 0; i < api->nexthop_num; i++)
+        {
+          if (api->nexthop[i].family == AF_INET)
+            {
+              stream_putc (s, ZEBRA_NEXTHOP_IPV4);
+              stream_put_in_addr (s, &api->nexthop[i].u.prefix4);
+            }
+#ifdef HAVE_IPV6
+          else if (api->ifindex[i])
+            {
+              stream_putc (s, ZEBRA_NEXTHOP_IPV6_IFINDEX);
+              stream_write (s, (u_char *) &api->nexthop[i].u.prefix6, 16);
+              stream_putl (s, api->ifindex[i]);
+            }
+          else
+            {
+              stream_putc (s, ZEBRA_NEXTHOP_IPV6);
+              stream_write (s, (u_char *) &api->nexthop[i].u.prefix6, 16);
+            }
+#endif /* HAVE_IPV6 */
+        }
+    }
+
+  stream_putw_at (s, 0, stream_get_endp (s));
+
+  return zclient_send_message(zclient);
+}
+
 /* Get prefix in ZServ format; family should be filled in on prefix */
 static void
 zclient_stream_get_prefix (struct stream *s, struct prefix *p)
@@ -1167,6 +1276,11 @@ zclient_read (struct thread *thread)
       if (zclient->interface_link_params)
         (*zclient->interface_link_params) (command, zclient, length);
       break;
+    case ZEBRA_TED_UPDATE:
+    case ZEBRA_TED_SYNC_DONE:
+      if (zclient->ted_update)
+	(*zclient->ted_update) (command, zclient, length, vrf_id);
+      break;
     default:
       break;
     }
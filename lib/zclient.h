@@ -90,6 +90,7 @@ struct zclient
   int (*ipv4_route_delete) (int, struct zclient *, uint16_t, vrf_id_t);
   int (*ipv6_route_add) (int, struct zclient *, uint16_t, vrf_id_t);
   int (*ipv6_route_delete) (int, struct zclient *, uint16_t, vrf_id_t);
+  int (*ted_update) (int, struct zclient *, uint16_t, vrf_id_t);
 };
 
 /* Zebra API message flag. */
@@ -98,6 +99,7 @@ struct zclient
 #define ZAPI_MESSAGE_DISTANCE 0x04
 #define ZAPI_MESSAGE_METRIC   0x08
 #define ZAPI_MESSAGE_MTU      0x10
+#define ZAPI_MESSAGE_PATHLIST 0x20
 
 /* Zserv protocol message header */
 struct zserv_header
@@ -135,9 +137,26 @@ struct zapi_ipv4
 
   u_int32_t mtu;
 
+  u_int32_t pathlist;
+
   vrf_id_t vrf_id;
 };
 
+/* Path-list shared by the routes which reference its id (prefix
+   independent convergence): changing its nexthops moves all of them. */
+struct zapi_pathlist
+{
+  u_char type;
+
+  u_int32_t id;
+
+  /* Host prefixes, IPv4 or IPv6, with the interface of each nexthop
+     or 0. */
+  u_char nexthop_num;
+  struct prefix *nexthop;
+  ifindex_t *ifindex;
+};
+
 /* Prototypes of zebra client service functions. */
 extern struct zclient *zclient_new (struct thread_master *);
 extern void zclient_init (struct zclient *, int);
@@ -156,6 +175,14 @@ extern void zclient_send_requests (struct zclient *, vrf_id_t);
 extern int zebra_redistribute_send (int command, struct zclient *, int type,
     vrf_id_t vrf_id);
 
+/* Send TED subscription request to zebra daemon. */
+extern int zebra_ted_subscribe_send (struct zclient *, int subscribe);
+extern int zebra_route_preserve_send (struct zclient *, u_char type,
+                                      u_int32_t stale_time);
+extern int zebra_route_sweep_send (struct zclient *, u_char type);
+extern int zapi_pathlist (u_char cmd, struct zclient *,
+                          struct zapi_pathlist *);
+
 /* If state has changed, update state and call zebra_redistribute_send. */
 extern void zclient_redistribute (int command, struct zclient *, int type,
     vrf_id_t vrf_id);
@@ -213,6 +240,8 @@ struct zapi_ipv6
 
   u_int32_t mtu;
 
+  u_int32_t pathlist;
+
   vrf_id_t vrf_id;
 };
 
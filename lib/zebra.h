@@ -416,7 +416,14 @@ struct in_pktinfo
 #define ZEBRA_IPV4_NEXTHOP_LOOKUP_MRIB    24
 #define ZEBRA_VRF_UNREGISTER              25
 #define ZEBRA_INTERFACE_LINK_PARAMS       26
-#define ZEBRA_MESSAGE_MAX                 27
+#define ZEBRA_TED_UPDATE                  27
+#define ZEBRA_TED_SUBSCRIBE               28
+#define ZEBRA_TED_SYNC_DONE               29
+#define ZEBRA_ROUTE_PRESERVE              30
+#define ZEBRA_ROUTE_SWEEP                 31
+#define ZEBRA_PATHLIST_ADD                32
+#define ZEBRA_PATHLIST_DELETE             33
+#define ZEBRA_MESSAGE_MAX                 34
 
 /* Marker value used in new Zserv, in the byte location corresponding
  * the command value in the old zserv header. To allow old and new
@@ -499,6 +499,47 @@ ospf_apiclient_lsa_delete (struct ospf_apiclient *oclient,
   return rc;
 }
 
+/*
+ * Request a constrained path computation. The request is given in
+ * network byte order. On success, the reply and its hops are copied
+ * into "reply" up to "size" bytes and left in network byte order.
+ */
+int
+ospf_apiclient_cspf_request (struct ospf_apiclient *oclient,
+			     struct msg_cspf_request *req,
+			     struct msg_cspf_reply *reply, size_t size)
+{
+  struct msg *msg;
+  u_int32_t reqseq;
+  size_t len;
+  int rc;
+
+  msg = new_msg_cspf_request (ospf_apiclient_get_seqnr (), req);
+  reqseq = ntohl (msg->hdr.msgseq);
+
+  rc = msg_write (oclient->fd_sync, msg);
+  msg_free (msg);
+  if (rc < 0)
+    return -1;
+
+  /* CSPF reply carries the path, so it is not a plain MSG_REPLY */
+  msg = msg_read (oclient->fd_sync);
+  if (!msg)
+    return -1;
+
+  assert (msg->hdr.msgtype == MSG_CSPF_REPLY);
+  assert (ntohl (msg->hdr.msgseq) == reqseq);
+
+  len = ntohs (msg->hdr.msglen);
+  if (len > size)
+    len = size;
+  memcpy (reply, STREAM_DATA (msg->s), len);
+  rc = reply->errcode;
+  msg_free (msg);
+
+  return rc;
+}
+
 /* -----------------------------------------------------------
  * Followings are handlers for messages from OSPF daemon
  * -----------------------------------------------------------
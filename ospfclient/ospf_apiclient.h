@@ -129,6 +129,11 @@ int ospf_apiclient_lsa_delete (struct ospf_apiclient *oclient,
 			       struct in_addr area_id, u_char lsa_type,
 			       u_char opaque_type, u_int32_t opaque_id);
 
+/* Compute a constrained path over the TE database of OSPFd */
+int ospf_apiclient_cspf_request (struct ospf_apiclient *oclient,
+				 struct msg_cspf_request *req,
+				 struct msg_cspf_reply *reply, size_t size);
+
 /* Fetch async message and handle it  */
 int ospf_apiclient_handle_async (struct ospf_apiclient *oclient);
 
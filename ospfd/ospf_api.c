@@ -142,6 +142,7 @@ ospf_api_typename (int msgtype)
     { MSG_SYNC_LSDB,             "Sync LSDB",              },
     { MSG_ORIGINATE_REQUEST,     "Originate request",      },
     { MSG_DELETE_REQUEST,        "Delete request",         },
+    { MSG_CSPF_REQUEST,          "CSPF request",           },
     { MSG_REPLY,                 "Reply",                  },
     { MSG_READY_NOTIFY,          "Ready notify",           },
     { MSG_LSA_UPDATE_NOTIFY,     "LSA update notify",      },
@@ -150,6 +151,7 @@ ospf_api_typename (int msgtype)
     { MSG_DEL_IF,                "Del interface",          },
     { MSG_ISM_CHANGE,            "ISM change",             },
     { MSG_NSM_CHANGE,            "NSM change",             },
+    { MSG_CSPF_REPLY,            "CSPF reply",             },
   };
 
   int i, n = array_size(NameTab);
@@ -182,6 +184,8 @@ ospf_api_errname (int errcode)
     { OSPF_API_NOMEMORY,                "No memory",                  },
     { OSPF_API_ERROR,                   "Other error",                },
     { OSPF_API_UNDEF,                   "Undefined",                  },
+    { OSPF_API_NOSUCHNODE,              "No such node in TED",        },
+    { OSPF_API_NOPATH,                  "No path found",              },
   };
 
   int i, n = array_size(NameTab);
@@ -533,6 +537,15 @@ new_msg_delete_request (u_int32_t seqnum,
 		  sizeof (struct msg_delete_request));
 }
 
+struct msg *
+new_msg_cspf_request (u_int32_t seqnum, struct msg_cspf_request *req)
+{
+  memset (&req->pad, 0, sizeof (req->pad));
+
+  return msg_new (MSG_CSPF_REQUEST, req, seqnum,
+		  sizeof (struct msg_cspf_request));
+}
+
 
 struct msg *
 new_msg_reply (u_int32_t seqnr, u_char rc)
@@ -646,4 +659,17 @@ new_msg_lsa_change_notify (u_char msgtype,
   return msg_new (msgtype, nmsg, seqnum, len);
 }
 
+/* Reply is in network byte order, followed by its hops. */
+struct msg *
+new_msg_cspf_reply (u_int32_t seqnum, struct msg_cspf_reply *reply)
+{
+  size_t len;
+
+  reply->pad = 0;
+  len = sizeof (struct msg_cspf_reply)
+    + ntohs (reply->hop_count) * sizeof (struct msg_cspf_hop);
+
+  return msg_new (MSG_CSPF_REPLY, reply, seqnum, len);
+}
+
 #endif /* SUPPORT_OSPF_API */
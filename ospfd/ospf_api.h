@@ -116,6 +116,7 @@ extern void msg_fifo_free (struct msg_fifo *fifo);
 #define MSG_SYNC_LSDB             4
 #define MSG_ORIGINATE_REQUEST     5
 #define MSG_DELETE_REQUEST        6
+#define MSG_CSPF_REQUEST          7
 
 /* Messages from OSPF daemon. */
 #define MSG_REPLY                10
@@ -126,6 +127,7 @@ extern void msg_fifo_free (struct msg_fifo *fifo);
 #define MSG_DEL_IF               15
 #define MSG_ISM_CHANGE           16
 #define MSG_NSM_CHANGE           17
+#define MSG_CSPF_REPLY           18
 
 struct msg_register_opaque_type
 {
@@ -217,6 +219,8 @@ struct msg_reply
 #define OSPF_API_NOMEMORY                 (-8)
 #define OSPF_API_ERROR                    (-9)
 #define OSPF_API_UNDEF                   (-10)
+#define OSPF_API_NOSUCHNODE              (-11)
+#define OSPF_API_NOPATH                  (-12)
   u_char pad[3];		/* padding to four byte alignment */
 };
 
@@ -274,6 +278,40 @@ struct msg_nsm_change
   u_char pad[3];
 };
 
+/* Constrained path computation over the TE database. All fields are
+   in network byte order, bandwidth included (see htonf()). */
+struct msg_cspf_request
+{
+  struct in_addr source;	/* Router ID, 0.0.0.0 for this router */
+  struct in_addr destination;	/* Router ID or TE Router Address */
+  float bandwidth;		/* Bytes/sec, 0 for none */
+  u_char priority;		/* 0 - 7 */
+  u_char metric;		/* 0: TE metric, 1: delay */
+  u_char pad[2];
+  u_int32_t include_any;	/* Admin. Group affinities, 0 for none */
+  u_int32_t include_all;
+  u_int32_t exclude_any;
+  u_int32_t max_delay;		/* micro-seconds, 0 for none */
+};
+
+struct msg_cspf_hop
+{
+  struct in_addr router_id;
+  struct in_addr local;		/* outgoing interface address */
+  struct in_addr remote;	/* next router interface address */
+};
+
+/* Dynamic length: hop_count msg_cspf_hop follow the fixed part. */
+struct msg_cspf_reply
+{
+  signed char errcode;		/* OSPF_API_xxx */
+  u_char pad;
+  u_int16_t hop_count;
+  u_int32_t cost;
+  u_int32_t delay;
+  struct msg_cspf_hop hops[0];
+};
+
 /* We make use of a union to define a structure that covers all
    possible API messages. This allows us to find out how much memory
    needs to be reserved for the largest API message. */
@@ -294,6 +332,8 @@ struct apimsg
     struct msg_ism_change ism_change;
     struct msg_nsm_change nsm_change;
     struct msg_lsa_change_notify lsa_change_notify;
+    struct msg_cspf_request cspf_request;
+    struct msg_cspf_reply cspf_reply;
   }
   u;
 };
@@ -324,6 +364,8 @@ extern struct msg *new_msg_delete_request (u_int32_t seqnum,
 					   u_char lsa_type,
 					   u_char opaque_type,
 					   u_int32_t opaque_id);
+extern struct msg *new_msg_cspf_request (u_int32_t seqnum,
+					 struct msg_cspf_request *req);
 
 /* Messages sent by OSPF daemon */
 extern struct msg *new_msg_reply (u_int32_t seqnum, u_char rc);
@@ -354,6 +396,9 @@ extern struct msg *new_msg_lsa_change_notify (u_char msgtype,
 					      u_char is_self_originated,
 					      struct lsa_header *data);
 
+extern struct msg *new_msg_cspf_reply (u_int32_t seqnum,
+				       struct msg_cspf_reply *reply);
+
 /* string printing functions */
 extern const char *ospf_api_errname (int errcode);
 extern const char *ospf_api_typename (int msgtype);
@@ -37,6 +37,7 @@
 #include "hash.h"
 #include "sockunion.h"		/* for inet_aton() */
 #include "buffer.h"
+#include "network.h"
 
 #include <sys/types.h>
 
@@ -55,6 +56,7 @@
 #include "ospfd/ospf_route.h"
 #include "ospfd/ospf_ase.h"
 #include "ospfd/ospf_zebra.h"
+#include "ospfd/ospf_cspf.h"
 
 #include "ospfd/ospf_api.h"
 #include "ospfd/ospf_apiserver.h"
@@ -778,6 +780,7 @@ ospf_apiserver_send_msg (struct ospf_apiserver *apiserv, struct msg *msg)
   switch (msg->hdr.msgtype)
     {
     case MSG_REPLY:
+    case MSG_CSPF_REPLY:
       fifo = apiserv->out_sync_fifo;
       fd = apiserv->fd_sync;
       event = OSPF_APISERVER_SYNC_WRITE;
@@ -866,6 +869,9 @@ ospf_apiserver_handle_msg (struct ospf_apiserver *apiserv, struct msg *msg)
     case MSG_DELETE_REQUEST:
       rc = ospf_apiserver_handle_delete_request (apiserv, msg);
       break;
+    case MSG_CSPF_REQUEST:
+      rc = ospf_apiserver_handle_cspf_request (apiserv, msg);
+      break;
     default:
       zlog_warn ("ospf_apiserver_handle_msg: Unknown message type: %d",
 		 msg->hdr.msgtype);
@@ -1995,6 +2001,89 @@ out:
   return rc;
 }
 
+
+/* -----------------------------------------------------------
+ * Followings are functions for constrained path computation
+ * -----------------------------------------------------------
+ */
+
+int
+ospf_apiserver_handle_cspf_request (struct ospf_apiserver *apiserv,
+				    struct msg *msg)
+{
+  struct msg_cspf_request *cmsg;
+  struct msg_cspf_reply *reply;
+  struct cspf_constraints cst;
+  struct cspf_path path;
+  struct in_addr src;
+  struct ospf *ospf;
+  u_char buf[sizeof (struct msg_cspf_reply)
+	     + CSPF_MAX_HOPS * sizeof (struct msg_cspf_hop)];
+  struct msg *rmsg;
+  int i, rc;
+
+  reply = (struct msg_cspf_reply *) buf;
+  memset (reply, 0, sizeof (struct msg_cspf_reply));
+
+  if (ntohs (msg->hdr.msglen) < sizeof (struct msg_cspf_request))
+    {
+      zlog_warn ("ospf_apiserver_handle_cspf_request: message too short");
+      reply->errcode = OSPF_API_ERROR;
+      goto out;
+    }
+
+  cmsg = (struct msg_cspf_request *) STREAM_DATA (msg->s);
+
+  memset (&cst, 0, sizeof (struct cspf_constraints));
+  cst.bw = ntohf (cmsg->bandwidth);
+  cst.priority = cmsg->priority;
+  cst.metric = cmsg->metric;
+  cst.include_any = ntohl (cmsg->include_any);
+  cst.include_all = ntohl (cmsg->include_all);
+  cst.exclude_any = ntohl (cmsg->exclude_any);
+  cst.max_delay = ntohl (cmsg->max_delay);
+
+  src = cmsg->source;
+  if (src.s_addr == INADDR_ANY && (ospf = ospf_lookup ()) != NULL)
+    src = ospf->router_id;
+
+  switch (ospf_cspf_compute (src, cmsg->destination, &cst, &path))
+    {
+    case CSPF_OK:
+      reply->errcode = OSPF_API_OK;
+      break;
+    case CSPF_NO_SOURCE:
+    case CSPF_NO_DESTINATION:
+      reply->errcode = OSPF_API_NOSUCHNODE;
+      goto out;
+    default:
+      reply->errcode = OSPF_API_NOPATH;
+      goto out;
+    }
+
+  reply->hop_count = htons (path.hop_count);
+  reply->cost = htonl (path.cost);
+  reply->delay = htonl (path.delay);
+  for (i = 0; i < path.hop_count; i++)
+    {
+      reply->hops[i].router_id = path.hops[i].router_id;
+      reply->hops[i].local = path.hops[i].local;
+      reply->hops[i].remote = path.hops[i].remote;
+    }
+
+out:
+  rmsg = new_msg_cspf_reply (ntohl (msg->hdr.msgseq), reply);
+  if (!rmsg)
+    {
+      zlog_warn ("ospf_apiserver_handle_cspf_request: msg_new failed");
+      return -1;
+    }
+
+  rc = ospf_apiserver_send_msg (apiserv, rmsg);
+  msg_free (rmsg);
+  return rc;
+}
+
 /* Flush self-originated opaque LSA */
 static int
 apiserver_flush_opaque_type_callback (struct ospf_lsa *lsa,
@@ -144,6 +144,8 @@ extern int ospf_apiserver_handle_delete_request (struct ospf_apiserver *apiserv,
 					  struct msg *msg);
 extern int ospf_apiserver_handle_sync_lsdb (struct ospf_apiserver *apiserv,
 				     struct msg *msg);
+extern int ospf_apiserver_handle_cspf_request (struct ospf_apiserver *apiserv,
+					       struct msg *msg);
 
 
 /* -----------------------------------------------------------
@@ -45,6 +45,7 @@
 #include "ospfd/ospf_ase.h"
 #include "ospfd/ospf_zebra.h"
 #include "ospfd/ospf_dump.h"
+#include "ospfd/ospf_gr.h"
 
 struct ospf_route *
 ospf_find_asbr_route (struct ospf *ospf,
@@ -683,6 +684,10 @@ ospf_ase_calculate_timer (struct thread *t)
 		 (stop_time.tv_sec - start_time.tv_sec)*1000000LL+
 		 (stop_time.tv_usec - start_time.tv_usec));
     }
+
+  /* All the routes are sent to zebra */
+  ospf_gr_routes_installed (ospf);
+
   return 0;
 }
 
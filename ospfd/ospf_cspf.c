@@ -0,0 +1,581 @@
+/*
+ * OSPF Constrained Shortest Path First (CSPF) over the TE Database
+ *
+ * Copyright (C) 2016 Orange Labs
+ * http://www.orange.com
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "linklist.h"
+#include "prefix.h"
+#include "if.h"
+#include "memory.h"
+#include "command.h"
+#include "vty.h"
+#include "log.h"
+#include "thread.h"
+#include "hash.h"
+#include "vector.h"
+#include "pqueue.h"
+
+#include "ospfd/ospfd.h"
+#include "ospfd/ospf_asbr.h"
+#include "ospfd/ospf_lsa.h"
+#include "ospfd/ospf_dump.h"
+#include "ospfd/ospf_te.h"
+#include "ospfd/ospf_ted.h"
+#include "ospfd/ospf_cspf.h"
+
+/*
+ * Per node working state of the path computation. The array is indexed
+ * by ted_node->index and kept from one computation to the next: entries
+ * are lazily reset by comparing their run number, so that a request
+ * costs nothing proportional to the TED size apart from the visited part.
+ */
+struct cspf_vertex
+{
+  struct ted_node *node;
+  u_int32_t run;
+
+  u_int32_t cost;
+  u_int32_t delay;
+  u_int16_t hops;
+
+  /* Previous vertex and link used to reach this vertex */
+  struct cspf_vertex *parent;
+  struct ted_link *link;
+
+  /* Position in the candidate heap, -1 if not queued */
+  int pos;
+  u_char done;
+};
+
+static struct
+{
+  struct cspf_vertex *vertices;
+  unsigned int size;
+  u_int32_t run;
+
+  struct pqueue *candidates;
+
+  /* Statistics */
+  u_int32_t requests;
+  u_int32_t success;
+  unsigned long time;		/* micro-seconds */
+} cspf;
+
+/* Heap related functions, for the management of the candidates. */
+static int
+cspf_cmp (void *node1, void *node2)
+{
+  struct cspf_vertex *v1 = node1;
+  struct cspf_vertex *v2 = node2;
+
+  if (v1->cost != v2->cost)
+    return (v1->cost < v2->cost) ? -1 : 1;
+  /* Prefer shortest hop count on tie for stable paths */
+  return (int) v1->hops - (int) v2->hops;
+}
+
+static void
+cspf_update_pos (void *node, int position)
+{
+  struct cspf_vertex *v = node;
+
+  v->pos = position;
+}
+
+static struct cspf_vertex *
+cspf_vertex_get (struct ted_node *node)
+{
+  struct cspf_vertex *v;
+
+  v = &cspf.vertices[node->index];
+  if (v->run != cspf.run)
+    {
+      memset (v, 0, sizeof (struct cspf_vertex));
+      v->node = node;
+      v->run = cspf.run;
+      v->cost = UINT32_MAX;
+      v->pos = -1;
+    }
+  return v;
+}
+
+/* Make room for all TED nodes and start a new computation run. */
+static void
+cspf_prepare (void)
+{
+  unsigned int size = vector_active (OspfTED.vertices);
+
+  if (size > cspf.size)
+    {
+      XFREE (MTYPE_OSPF_CSPF, cspf.vertices);
+      cspf.size = size * 2;
+      cspf.vertices = XCALLOC (MTYPE_OSPF_CSPF,
+                               cspf.size * sizeof (struct cspf_vertex));
+      cspf.run = 0;
+    }
+
+  /* Run number 0 marks unused entries */
+  if (++cspf.run == 0)
+    {
+      memset (cspf.vertices, 0, cspf.size * sizeof (struct cspf_vertex));
+      cspf.run = 1;
+    }
+
+  cspf.candidates->size = 0;
+}
+
+/* Check link against bandwidth, admin group and delay constraints. */
+static int
+cspf_link_eligible (struct ted_link *link, struct cspf_constraints *cst)
+{
+  u_int32_t grp;
+  float bw;
+
+  if (cst->bw > 0)
+    {
+      if (CHECK_FLAG (link->flags, TED_LINK_UNRSV_BW))
+        bw = link->unrsv_bw[cst->priority];
+      else if (CHECK_FLAG (link->flags, TED_LINK_MAX_RSV_BW))
+        bw = link->max_rsv_bw;
+      else
+        return 0;
+      if (bw < cst->bw)
+        return 0;
+    }
+
+  grp = CHECK_FLAG (link->flags, TED_LINK_ADM_GRP) ? link->admin_grp : 0;
+  if (grp & cst->exclude_any)
+    return 0;
+  if (cst->include_any && !(grp & cst->include_any))
+    return 0;
+  if ((grp & cst->include_all) != cst->include_all)
+    return 0;
+
+  /* Links with unknown delay can not be proven to meet the bound */
+  if ((cst->max_delay || cst->metric == CSPF_METRIC_DELAY)
+      && !CHECK_FLAG (link->flags, TED_LINK_AV_DELAY | TED_LINK_MM_DELAY))
+    return 0;
+
+  return 1;
+}
+
+static void
+cspf_relax (struct cspf_vertex *v, struct ted_node *node,
+            struct ted_link *link, u_int32_t weight, u_int32_t delay,
+            struct cspf_constraints *cst)
+{
+  struct cspf_vertex *w;
+  u_int32_t cost;
+
+  if (weight > UINT32_MAX - v->cost || delay > UINT32_MAX - v->delay)
+    return;
+  cost = v->cost + weight;
+  delay = v->delay + delay;
+  if (cst->max_delay && delay > cst->max_delay)
+    return;
+
+  w = cspf_vertex_get (node);
+  if (w->done)
+    return;
+  if (cost > w->cost || (cost == w->cost && v->hops + 1 >= w->hops))
+    return;
+
+  w->cost = cost;
+  w->delay = delay;
+  w->hops = v->hops + 1;
+  w->parent = v;
+  w->link = link;
+
+  if (w->pos < 0)
+    pqueue_enqueue (w, cspf.candidates);
+  else
+    trickle_up (w->pos, cspf.candidates);
+}
+
+/* Dijkstra over the TED, pruned by the constraints. */
+static struct cspf_vertex *
+cspf_run (struct ted_node *src, struct ted_node *dst,
+          struct cspf_constraints *cst)
+{
+  struct cspf_vertex *v;
+  struct listnode *node;
+  struct ted_link *link;
+  u_int32_t weight;
+
+  cspf_prepare ();
+
+  v = cspf_vertex_get (src);
+  v->cost = 0;
+  pqueue_enqueue (v, cspf.candidates);
+
+  while (cspf.candidates->size > 0)
+    {
+      v = pqueue_dequeue (cspf.candidates);
+      v->pos = -1;
+      v->done = 1;
+
+      if (v->node == dst)
+        return v;
+
+      for (ALL_LIST_ELEMENTS_RO (v->node->links, node, link))
+        {
+          if (v->node->pseudo)
+            {
+              /* Transit network reaches attached routers at no cost */
+              if (link->src != NULL)
+                cspf_relax (v, link->src, link, 0, 0, cst);
+              continue;
+            }
+
+          if (!cspf_link_eligible (link, cst))
+            continue;
+
+          if (cst->metric == CSPF_METRIC_DELAY)
+            weight = ospf_ted_link_delay (link);
+          else
+            weight = link->te_metric;
+
+          cspf_relax (v, link->dst, link, weight,
+                      ospf_ted_link_delay (link), cst);
+        }
+    }
+
+  return NULL;
+}
+
+/* Walk back from destination to source to fill the path hops. */
+static int
+cspf_build_path (struct cspf_vertex *dst, struct cspf_path *path)
+{
+  struct cspf_vertex *v;
+  struct cspf_hop *hop;
+  int n = 0;
+  int i;
+
+  path->cost = dst->cost;
+  path->delay = dst->delay;
+
+  /* Count real links (i.e. not the ones used backward from a network) */
+  for (v = dst; v->parent != NULL; v = v->parent)
+    if (!v->parent->node->pseudo)
+      n++;
+
+  if (n > CSPF_MAX_HOPS)
+    return CSPF_TOO_MANY_HOPS;
+
+  path->hop_count = n;
+  i = n;
+  for (v = dst; v->parent != NULL; v = v->parent)
+    {
+      if (v->parent->node->pseudo)
+        {
+          /* v is reached from a network: its own link gives its address */
+          if (i > 0 && n > 0)
+            path->hops[i - 1].remote = v->link->local;
+          continue;
+        }
+      hop = &path->hops[--i];
+      hop->router_id = v->parent->node->router_id;
+      hop->local = v->link->local;
+      if (hop->remote.s_addr == INADDR_ANY)
+        hop->remote = v->link->remote;
+    }
+
+  return CSPF_OK;
+}
+
+int
+ospf_cspf_compute (struct in_addr src_id, struct in_addr dst_id,
+                   struct cspf_constraints *cst, struct cspf_path *path)
+{
+  struct ted_node *src, *dst;
+  struct cspf_vertex *v;
+  struct cspf_constraints relaxed;
+  struct timeval start, stop;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  memset (path, 0, sizeof (struct cspf_path));
+  cspf.requests++;
+
+  if (cst->priority >= MAX_CLASS_TYPE)
+    cst->priority = MAX_CLASS_TYPE - 1;
+
+  if ((src = ospf_ted_node_lookup (src_id)) == NULL)
+    {
+      path->status = CSPF_NO_SOURCE;
+      goto out;
+    }
+  if ((dst = ospf_ted_node_lookup (dst_id)) == NULL)
+    {
+      path->status = CSPF_NO_DESTINATION;
+      goto out;
+    }
+
+  v = cspf_run (src, dst, cst);
+
+  /*
+   * The shortest TE metric path computed under the delay bound may miss a
+   * feasible path. As the minimum delay path is feasible whenever a path
+   * exists, fall back to it before giving up.
+   */
+  if (v == NULL && cst->max_delay && cst->metric != CSPF_METRIC_DELAY)
+    {
+      relaxed = *cst;
+      relaxed.metric = CSPF_METRIC_DELAY;
+      v = cspf_run (src, dst, &relaxed);
+    }
+
+  if (v == NULL)
+    {
+      path->status = CSPF_NO_PATH;
+      goto out;
+    }
+
+  path->status = cspf_build_path (v, path);
+  if (path->status == CSPF_OK)
+    cspf.success++;
+
+out:
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &stop);
+  cspf.time += timeval_elapsed (stop, start);
+
+  if (IS_DEBUG_OSPF_TE)
+    zlog_debug ("OSPF CSPF: Path from %s to %s: %s",
+                inet_ntoa (src_id), inet_ntoa (dst_id),
+                ospf_cspf_status2str (path->status));
+
+  return path->status;
+}
+
+const char *
+ospf_cspf_status2str (int status)
+{
+  switch (status)
+    {
+    case CSPF_OK:
+      return "Path found";
+    case CSPF_NO_SOURCE:
+      return "Unknown source";
+    case CSPF_NO_DESTINATION:
+      return "Unknown destination";
+    case CSPF_NO_PATH:
+      return "No path satisfies the constraints";
+    case CSPF_TOO_MANY_HOPS:
+      return "Path too long";
+    default:
+      return "Unknown";
+    }
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are vty command functions.
+ *------------------------------------------------------------------------*/
+
+static int
+cspf_parse_constraints (struct vty *vty, int argc, const char **argv,
+                        struct in_addr *src, struct cspf_constraints *cst)
+{
+  int i;
+  unsigned long val;
+  char *endptr;
+
+  for (i = 0; i < argc; i++)
+    {
+      if (strcmp (argv[i], "metric") == 0 && i + 1 < argc)
+        {
+          i++;
+          if (strcmp (argv[i], "te") == 0)
+            cst->metric = CSPF_METRIC_TE;
+          else if (strcmp (argv[i], "delay") == 0)
+            cst->metric = CSPF_METRIC_DELAY;
+          else
+            goto error;
+          continue;
+        }
+
+      if (strcmp (argv[i], "source") == 0 && i + 1 < argc)
+        {
+          if (!inet_aton (argv[++i], src))
+            goto error;
+          continue;
+        }
+
+      if (strcmp (argv[i], "bandwidth") == 0 && i + 1 < argc)
+        {
+          if (sscanf (argv[++i], "%g", &cst->bw) != 1 || cst->bw < 0)
+            goto error;
+          continue;
+        }
+
+      if (i + 1 >= argc)
+        goto error;
+
+      val = strtoul (argv[i + 1], &endptr, 0);
+      if (*endptr != '\0')
+        goto error;
+
+      if (strcmp (argv[i], "priority") == 0 && val < MAX_CLASS_TYPE)
+        cst->priority = val;
+      else if (strcmp (argv[i], "include-any") == 0)
+        cst->include_any = val;
+      else if (strcmp (argv[i], "include-all") == 0)
+        cst->include_all = val;
+      else if (strcmp (argv[i], "exclude-any") == 0)
+        cst->exclude_any = val;
+      else if (strcmp (argv[i], "max-delay") == 0 && val <= TE_EXT_MASK)
+        cst->max_delay = val;
+      else
+        goto error;
+      i++;
+    }
+
+  return 0;
+
+error:
+  vty_out (vty, "Invalid constraint '%s'%s", argv[i], VTY_NEWLINE);
+  return -1;
+}
+
+static void
+show_cspf_path (struct vty *vty, struct cspf_path *path)
+{
+  int i;
+
+  vty_out (vty, "  TE Metric %u, Delay %u (micro-sec), %d hop(s)%s",
+           path->cost, path->delay, path->hop_count, VTY_NEWLINE);
+
+  for (i = 0; i < path->hop_count; i++)
+    {
+      vty_out (vty, "    %2d: Router %-15s", i + 1,
+               inet_ntoa (path->hops[i].router_id));
+      vty_out (vty, " Local %-15s", inet_ntoa (path->hops[i].local));
+      vty_out (vty, " Remote %s%s", inet_ntoa (path->hops[i].remote),
+               VTY_NEWLINE);
+    }
+}
+
+DEFUN (show_ip_ospf_mpls_te_cspf,
+       show_ip_ospf_mpls_te_cspf_cmd,
+       "show ip ospf mpls-te cspf A.B.C.D",
+       SHOW_STR
+       IP_STR
+       OSPF_STR
+       "MPLS-TE information\n"
+       "Compute a Constrained Shortest Path\n"
+       "Destination Router ID or TE Router Address\n")
+{
+  struct ospf *ospf;
+  struct in_addr src, dst;
+  struct cspf_constraints cst;
+  struct cspf_path path;
+
+  if (!inet_aton (argv[0], &dst))
+    {
+      vty_out (vty, "Please specify destination by A.B.C.D%s", VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+
+  memset (&cst, 0, sizeof (struct cspf_constraints));
+  src.s_addr = INADDR_ANY;
+  if ((ospf = ospf_lookup ()) != NULL)
+    src = ospf->router_id;
+
+  if (cspf_parse_constraints (vty, argc - 1, argv + 1, &src, &cst) < 0)
+    return CMD_WARNING;
+
+  vty_out (vty, "--- CSPF from %s", inet_ntoa (src));
+  vty_out (vty, " to %s ---%s", inet_ntoa (dst), VTY_NEWLINE);
+
+  if (ospf_cspf_compute (src, dst, &cst, &path) != CSPF_OK)
+    {
+      vty_out (vty, "  %s%s", ospf_cspf_status2str (path.status),
+               VTY_NEWLINE);
+      return CMD_SUCCESS;
+    }
+
+  show_cspf_path (vty, &path);
+  return CMD_SUCCESS;
+}
+
+ALIAS (show_ip_ospf_mpls_te_cspf,
+       show_ip_ospf_mpls_te_cspf_constraints_cmd,
+       "show ip ospf mpls-te cspf A.B.C.D .LINE",
+       SHOW_STR
+       IP_STR
+       OSPF_STR
+       "MPLS-TE information\n"
+       "Compute a Constrained Shortest Path\n"
+       "Destination Router ID or TE Router Address\n"
+       "Constraints: [source A.B.C.D] [bandwidth BW] [priority <0-7>] "
+       "[include-any MASK] [include-all MASK] [exclude-any MASK] "
+       "[max-delay <0-16777215>] [metric (te|delay)]\n")
+
+DEFUN (show_ip_ospf_mpls_te_cspf_statistics,
+       show_ip_ospf_mpls_te_cspf_statistics_cmd,
+       "show ip ospf mpls-te cspf statistics",
+       SHOW_STR
+       IP_STR
+       OSPF_STR
+       "MPLS-TE information\n"
+       "Constrained Shortest Path First\n"
+       "CSPF statistics\n")
+{
+  vty_out (vty, "--- CSPF statistics ---%s", VTY_NEWLINE);
+  vty_out (vty, "  Requests: %u, Path found: %u%s",
+           cspf.requests, cspf.success, VTY_NEWLINE);
+  vty_out (vty, "  Total computation time: %lu usec", cspf.time);
+  if (cspf.requests)
+    vty_out (vty, ", Average: %lu usec", cspf.time / cspf.requests);
+  vty_out (vty, "%s", VTY_NEWLINE);
+
+  return CMD_SUCCESS;
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are initialize/terminate functions.
+ *------------------------------------------------------------------------*/
+
+void
+ospf_cspf_init (void)
+{
+  memset (&cspf, 0, sizeof (cspf));
+  cspf.candidates = pqueue_create ();
+  cspf.candidates->cmp = cspf_cmp;
+  cspf.candidates->update = cspf_update_pos;
+
+  install_element (VIEW_NODE, &show_ip_ospf_mpls_te_cspf_cmd);
+  install_element (VIEW_NODE, &show_ip_ospf_mpls_te_cspf_constraints_cmd);
+  install_element (VIEW_NODE, &show_ip_ospf_mpls_te_cspf_statistics_cmd);
+  install_element (ENABLE_NODE, &show_ip_ospf_mpls_te_cspf_cmd);
+  install_element (ENABLE_NODE, &show_ip_ospf_mpls_te_cspf_constraints_cmd);
+  install_element (ENABLE_NODE, &show_ip_ospf_mpls_te_cspf_statistics_cmd);
+}
+
+void
+ospf_cspf_term (void)
+{
+  XFREE (MTYPE_OSPF_CSPF, cspf.vertices);
+  pqueue_delete (cspf.candidates);
+  memset (&cspf, 0, sizeof (cspf));
+}
@@ -0,0 +1,87 @@
+/*
+ * OSPF Constrained Shortest Path First (CSPF) over the TE Database
+ *
+ * Copyright (C) 2016 Orange Labs
+ * http://www.orange.com
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _ZEBRA_OSPF_CSPF_H
+#define _ZEBRA_OSPF_CSPF_H
+
+/* Metric to minimize */
+#define CSPF_METRIC_TE		0
+#define CSPF_METRIC_DELAY	1
+
+/* Path computation result */
+#define CSPF_OK			0
+#define CSPF_NO_SOURCE		1
+#define CSPF_NO_DESTINATION	2
+#define CSPF_NO_PATH		3
+#define CSPF_TOO_MANY_HOPS	4
+
+#define CSPF_MAX_HOPS		64
+
+struct cspf_constraints
+{
+  /* Requested bandwidth in Bytes/sec, 0 for none */
+  float bw;
+  /* Priority used to select the Unreserved Bandwidth: 0 (highest) - 7 */
+  u_char priority;
+  /* CSPF_METRIC_TE or CSPF_METRIC_DELAY */
+  u_char metric;
+
+  /* Admin. Group (Resource Class/Color) affinities, 0 for none */
+  u_int32_t include_any;
+  u_int32_t include_all;
+  u_int32_t exclude_any;
+
+  /* Upper bound of the path delay in micro-seconds, 0 for none */
+  u_int32_t max_delay;
+};
+
+struct cspf_hop
+{
+  /* Router at the head of the hop and outgoing interface */
+  struct in_addr router_id;
+  struct in_addr local;
+  /* Interface address of the next router, 0.0.0.0 if unknown */
+  struct in_addr remote;
+};
+
+struct cspf_path
+{
+  int status;
+
+  /* Accumulated TE metric and delay (micro-seconds) along the path */
+  u_int32_t cost;
+  u_int32_t delay;
+
+  u_int16_t hop_count;
+  struct cspf_hop hops[CSPF_MAX_HOPS];
+};
+
+/* Prototypes. */
+extern void ospf_cspf_init (void);
+extern void ospf_cspf_term (void);
+extern int ospf_cspf_compute (struct in_addr, struct in_addr,
+                              struct cspf_constraints *, struct cspf_path *);
+extern const char *ospf_cspf_status2str (int);
+
+#endif /* _ZEBRA_OSPF_CSPF_H */
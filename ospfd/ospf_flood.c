@@ -129,6 +129,14 @@ ospf_process_self_originated_lsa (struct ospf *ospf,
      If yes, we should use this LSA's sequence number and reoriginate
      a new instance.
      if not --- we must flush this LSA from the domain. */
+
+  /* While restarting gracefully, our pre-restart instances are kept:
+     they tell which adjacencies to wait for, RFC 3623 2.2. */
+  if (ospf->gr_restarting
+      && (new->data->type == OSPF_ROUTER_LSA
+          || new->data->type == OSPF_NETWORK_LSA))
+    return;
+
   switch (new->data->type)
     {
     case OSPF_ROUTER_LSA:
@@ -327,7 +335,7 @@ ospf_flood (struct ospf *ospf, struct ospf_neighbor *nbr,
 }
 
 /* OSPF LSA flooding -- RFC2328 Section 13.3. */
-static int
+int
 ospf_flood_through_interface (struct ospf_interface *oi,
 			      struct ospf_neighbor *inbr,
 			      struct ospf_lsa *lsa)
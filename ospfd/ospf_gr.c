@@ -0,0 +1,896 @@
+/*
+ * OSPF Graceful Restart, RFC 3623: restarting router and helper modes.
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "linklist.h"
+#include "prefix.h"
+#include "if.h"
+#include "table.h"
+#include "memory.h"
+#include "command.h"
+#include "vty.h"
+#include "stream.h"
+#include "log.h"
+#include "thread.h"
+#include "zclient.h"
+
+#include "ospfd/ospfd.h"
+#include "ospfd/ospf_interface.h"
+#include "ospfd/ospf_ism.h"
+#include "ospfd/ospf_asbr.h"
+#include "ospfd/ospf_lsa.h"
+#include "ospfd/ospf_lsdb.h"
+#include "ospfd/ospf_neighbor.h"
+#include "ospfd/ospf_nsm.h"
+#include "ospfd/ospf_flood.h"
+#include "ospfd/ospf_packet.h"
+#include "ospfd/ospf_spf.h"
+#include "ospfd/ospf_dump.h"
+#include "ospfd/ospf_opaque.h"
+#include "ospfd/ospf_gr.h"
+
+/* End of the grace period of the restart in progress, wall clock, read
+   from the state file written before the restart. */
+static time_t gr_restart_end;
+static u_int32_t gr_restart_seqnum;
+
+static const struct message ospf_gr_reason_msg[] =
+{
+  { OSPF_GR_REASON_UNKNOWN,	"unknown" },
+  { OSPF_GR_REASON_SW_RESTART,	"software restart" },
+  { OSPF_GR_REASON_SW_UPGRADE,	"software reload/upgrade" },
+  { OSPF_GR_REASON_SWITCHOVER,	"switch to redundant control processor" },
+};
+static const int ospf_gr_reason_msg_max = OSPF_GR_REASON_SWITCHOVER + 1;
+
+static int
+is_grace_lsa (struct ospf_lsa *lsa)
+{
+  return lsa->data->type == OSPF_OPAQUE_LINK_LSA
+         && GET_OPAQUE_TYPE (ntohl (lsa->data->id.s_addr))
+            == OPAQUE_TYPE_GRACE_LSA;
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are grace-LSA construction and parsing functions.
+ *------------------------------------------------------------------------*/
+
+static struct ospf_lsa *
+ospf_gr_lsa_new (struct ospf_interface *oi, u_int32_t period, u_char reason)
+{
+  struct stream *s;
+  struct lsa_header *lsah;
+  struct ospf_lsa *new;
+  struct in_addr lsa_id;
+  u_int16_t length;
+
+  s = stream_new (OSPF_MAX_LSA_SIZE);
+  lsah = (struct lsa_header *) STREAM_DATA (s);
+
+  lsa_id.s_addr = htonl (SET_OPAQUE_LSID (OPAQUE_TYPE_GRACE_LSA, 0));
+  lsa_header_set (s, LSA_OPTIONS_GET (oi->area) | OSPF_OPTION_O,
+                  OSPF_OPAQUE_LINK_LSA, lsa_id, oi->ospf->router_id);
+
+  stream_putw (s, GR_TLV_GRACE_PERIOD);
+  stream_putw (s, sizeof (u_int32_t));
+  stream_putl (s, period);
+
+  stream_putw (s, GR_TLV_REASON);
+  stream_putw (s, sizeof (u_char));
+  stream_putc (s, reason);
+  stream_put (s, NULL, 3);
+
+  /* The helpers on a multi-access network identify us by address */
+  if (oi->type != OSPF_IFTYPE_POINTOPOINT
+      && oi->type != OSPF_IFTYPE_VIRTUALLINK)
+    {
+      stream_putw (s, GR_TLV_IF_ADDRESS);
+      stream_putw (s, sizeof (struct in_addr));
+      stream_put_ipv4 (s, oi->address->u.prefix4.s_addr);
+    }
+
+  length = stream_get_endp (s);
+  lsah->length = htons (length);
+
+  new = ospf_lsa_new ();
+  new->data = ospf_lsa_data_new (length);
+  memcpy (new->data, lsah, length);
+  stream_free (s);
+
+  new->area = oi->area;
+  new->oi = oi;
+  SET_FLAG (new->flags, OSPF_LSA_SELF);
+
+  return new;
+}
+
+/* Send a grace-LSA through an interface, or flush it. The grace-LSA is
+   not installed in our LSDB: it must outlive this instance of ospfd,
+   and the helpers hold it for us until we flush it after the restart. */
+static void
+ospf_gr_lsa_send (struct ospf_interface *oi, u_int32_t period, int flush)
+{
+  struct ospf_lsa *lsa;
+
+  lsa = ospf_gr_lsa_new (oi, period, OSPF_GR_REASON_SW_RESTART);
+  lsa->data->ls_seqnum = htonl (oi->ospf->gr_seqnum);
+  if (flush)
+    lsa->data->ls_age = htons (OSPF_LSA_MAXAGE);
+  ospf_lsa_checksum (lsa->data);
+
+  if (IS_DEBUG_OSPF (lsa, LSA_GENERATE))
+    zlog_debug ("GR: %s grace-LSA on %s", flush ? "flush" : "send",
+                IF_NAME (oi));
+
+  ospf_flood_through_interface (oi, NULL, lsa);
+  ospf_lsa_unlock (&lsa);
+}
+
+static void
+ospf_gr_lsa_parse (struct ospf_lsa *lsa, u_int32_t *period, u_char *reason)
+{
+  struct lsa_header *lsah = lsa->data;
+  struct gr_tlv_header *tlvh;
+  u_int16_t length, sum;
+
+  *period = 0;
+  *reason = OSPF_GR_REASON_UNKNOWN;
+
+  length = ntohs (lsah->length) - OSPF_LSA_HEADER_SIZE;
+  for (tlvh = GR_TLV_HDR_TOP (lsah), sum = 0;
+       sum + GR_TLV_HDR_SIZE <= length && sum + GR_TLV_SIZE (tlvh) <= length;
+       sum += GR_TLV_SIZE (tlvh), tlvh = GR_TLV_HDR_NEXT (tlvh))
+    {
+      switch (ntohs (tlvh->type))
+        {
+        case GR_TLV_GRACE_PERIOD:
+          if (ntohs (tlvh->length) == sizeof (u_int32_t))
+            *period = ntohl (*(u_int32_t *) (tlvh + 1));
+          break;
+        case GR_TLV_REASON:
+          if (ntohs (tlvh->length) == sizeof (u_char))
+            *reason = *(u_char *) (tlvh + 1);
+          break;
+        default:
+          break;
+        }
+    }
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are helper mode functions.
+ *------------------------------------------------------------------------*/
+
+static void
+ospf_gr_helper_exit (struct ospf_neighbor *nbr, const char *why)
+{
+  struct ospf_interface *oi = nbr->oi;
+
+  if (!OSPF_GR_HELPING (nbr))
+    return;
+
+  zlog_notice ("GR: stop helping %s on %s: %s", inet_ntoa (nbr->router_id),
+               IF_NAME (oi), why);
+
+  nbr->gr_helper = 0;
+  oi->ospf->gr_helpers--;
+  OSPF_NSM_TIMER_OFF (nbr->t_gr_helper);
+
+  /* Advertise the adjacency as it is now */
+  if (oi->state == ISM_DROther || oi->state == ISM_Backup
+      || oi->state == ISM_DR)
+    OSPF_ISM_EVENT_SCHEDULE (oi, ISM_NeighborChange);
+
+  ospf_router_lsa_update_area (oi->area);
+
+  if (oi->state == ISM_DR)
+    {
+      if (oi->network_lsa_self && oi->full_nbrs == 0)
+        {
+          ospf_lsa_flush_area (oi->network_lsa_self, oi->area);
+          ospf_lsa_unlock (&oi->network_lsa_self);
+          oi->network_lsa_self = NULL;
+        }
+      else
+        ospf_network_lsa_update (oi);
+    }
+
+  /* The neighbor went silent while we were helping it */
+  if (nbr->state > NSM_Down && nbr->state != NSM_Full
+      && nbr->t_inactivity == NULL)
+    OSPF_NSM_EVENT_SCHEDULE (nbr, NSM_InactivityTimer);
+}
+
+static int
+ospf_gr_helper_timer (struct thread *thread)
+{
+  struct ospf_neighbor *nbr = THREAD_ARG (thread);
+
+  nbr->t_gr_helper = NULL;
+  ospf_gr_helper_exit (nbr, "grace period expired");
+
+  return 0;
+}
+
+/* Exits decided while installing an LSA are deferred out of the LSDB
+   update. The event is cancelled with the neighbor. */
+static int
+ospf_gr_helper_exit_event (struct thread *thread)
+{
+  struct ospf_neighbor *nbr = THREAD_ARG (thread);
+  int why = THREAD_VAL (thread);
+
+  ospf_gr_helper_exit (nbr, why ? "topology change" : "grace-LSA flushed");
+
+  return 0;
+}
+
+static void
+ospf_gr_helper_enter (struct ospf_neighbor *nbr, struct ospf_lsa *lsa)
+{
+  struct ospf *ospf = nbr->oi->ospf;
+  const char *reject = NULL;
+  u_int32_t period;
+  u_char reason;
+  int age = LS_AGE (lsa);
+
+  ospf_gr_lsa_parse (lsa, &period, &reason);
+
+  /* RFC 3623 3.1 */
+  if (ospf->gr_helper_disable)
+    reject = "helper mode disabled";
+  else if (ospf->gr_restarting)
+    reject = "we are restarting";
+  else if (!OSPF_NBR_ADV_FULL (nbr))
+    reject = "adjacency not full";
+  else if (period == 0 || age >= (int) period)
+    reject = "grace period expired";
+  else if (!OSPF_GR_HELPING (nbr) && ospf_ls_retransmit_count (nbr) > 0)
+    reject = "LSDB changed since the restart";
+
+  if (reject)
+    {
+      zlog_info ("GR: not helping %s on %s: %s", inet_ntoa (nbr->router_id),
+                 IF_NAME (nbr->oi), reject);
+      return;
+    }
+
+  if (!OSPF_GR_HELPING (nbr))
+    {
+      zlog_notice ("GR: helping %s on %s, %s, grace period %us",
+                   inet_ntoa (nbr->router_id), IF_NAME (nbr->oi),
+                   LOOKUP (ospf_gr_reason_msg, reason), period);
+      nbr->gr_helper = 1;
+      ospf->gr_helpers++;
+    }
+  nbr->gr_reason = reason;
+
+  OSPF_NSM_TIMER_OFF (nbr->t_gr_helper);
+  nbr->t_gr_helper = thread_add_timer (master, ospf_gr_helper_timer, nbr,
+                                       period - age);
+}
+
+/* Opaque new_lsa_hook: a neighbor's grace-LSA starts or ends helping. */
+static int
+ospf_gr_lsa_install_hook (struct ospf_lsa *lsa)
+{
+  struct ospf_neighbor *nbr;
+
+  if (!is_grace_lsa (lsa) || IS_LSA_SELF (lsa) || lsa->oi == NULL)
+    return 0;
+
+  nbr = ospf_nbr_lookup_by_routerid (lsa->oi->nbrs, &lsa->data->adv_router);
+  if (nbr == NULL)
+    return 0;
+
+  if (IS_LSA_MAXAGE (lsa))
+    {
+      if (OSPF_GR_HELPING (nbr))
+        thread_add_event (master, ospf_gr_helper_exit_event, nbr, 0);
+    }
+  else
+    ospf_gr_helper_enter (nbr, lsa);
+
+  return 0;
+}
+
+static int
+ospf_gr_lsa_delete_hook (struct ospf_lsa *lsa)
+{
+  struct ospf_neighbor *nbr;
+
+  if (!is_grace_lsa (lsa) || lsa->oi == NULL)
+    return 0;
+
+  nbr = ospf_nbr_lookup_by_routerid (lsa->oi->nbrs, &lsa->data->adv_router);
+  if (nbr && OSPF_GR_HELPING (nbr))
+    thread_add_event (master, ospf_gr_helper_exit_event, nbr, 0);
+
+  return 0;
+}
+
+/* An LSA which changed the topology is being installed: the neighbors
+   we help would miss it, RFC 3623 3.2. Opaque-LSAs don't count. */
+void
+ospf_gr_lsa_change (struct ospf *ospf, struct ospf_lsa *lsa)
+{
+  struct ospf_interface *oi;
+  struct ospf_neighbor *nbr;
+  struct route_node *rn;
+  struct listnode *node;
+
+  if (ospf->gr_helpers == 0 || IS_OPAQUE_LSA (lsa->data->type))
+    return;
+
+  for (ALL_LIST_ELEMENTS_RO (ospf->oiflist, node, oi))
+    {
+      if (lsa->data->type != OSPF_AS_EXTERNAL_LSA && lsa->area != oi->area)
+        continue;
+
+      for (rn = route_top (oi->nbrs); rn; rn = route_next (rn))
+        if ((nbr = rn->info) != NULL && OSPF_GR_HELPING (nbr)
+            && !IPV4_ADDR_SAME (&nbr->router_id, &lsa->data->adv_router))
+          thread_add_event (master, ospf_gr_helper_exit_event, nbr, 1);
+    }
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are restarting router functions.
+ *------------------------------------------------------------------------*/
+
+static void
+ospf_gr_state_write (u_int32_t period, u_int32_t seqnum)
+{
+  FILE *fp;
+
+  if ((fp = fopen (PATH_OSPFD_GR_STATE, "w")) == NULL)
+    {
+      zlog_warn ("GR: can't write %s: %s", PATH_OSPFD_GR_STATE,
+                 safe_strerror (errno));
+      return;
+    }
+  fprintf (fp, "%ld %u\n", (long) (quagga_time (NULL) + period), seqnum);
+  fclose (fp);
+}
+
+static void
+ospf_gr_state_read (void)
+{
+  FILE *fp;
+  long end;
+  u_int32_t seqnum;
+
+  if ((fp = fopen (PATH_OSPFD_GR_STATE, "r")) == NULL)
+    return;
+
+  if (fscanf (fp, "%ld %u", &end, &seqnum) == 2 && end > quagga_time (NULL))
+    {
+      gr_restart_end = end;
+      gr_restart_seqnum = seqnum;
+    }
+  fclose (fp);
+
+  /* The state is only valid for the first start after the prepare */
+  unlink (PATH_OSPFD_GR_STATE);
+}
+
+/* Whether the adjacencies our pre-restart router-LSA, received back
+   from the helpers, lists in an area are full again, RFC 3623 2.3. */
+static int
+ospf_gr_area_ready (struct ospf *ospf, struct ospf_area *area)
+{
+  struct ospf_interface *oi;
+  struct ospf_neighbor *nbr;
+  struct ospf_lsa *lsa, *nlsa;
+  struct router_lsa_link *l;
+  struct network_lsa *nl;
+  struct listnode *node;
+  u_char *p, *lim;
+  int i, n;
+
+  lsa = ospf_lsa_lookup_by_id (area, OSPF_ROUTER_LSA, ospf->router_id);
+  if (lsa == NULL)
+    {
+      /* A full neighbor has the whole area LSDB: we had no adjacency
+         in the area before the restart. */
+      if (area->full_nbrs > 0)
+        return 1;
+      for (ALL_LIST_ELEMENTS_RO (area->oiflist, node, oi))
+        if (ospf_nbr_count (oi, 0) > 0)
+          return 0;
+      return 1;
+    }
+
+  p = ((u_char *) lsa->data) + OSPF_LSA_HEADER_SIZE + 4;
+  lim = ((u_char *) lsa->data) + ntohs (lsa->data->length);
+  while (p + OSPF_ROUTER_LSA_LINK_SIZE <= lim)
+    {
+      l = (struct router_lsa_link *) p;
+      p += OSPF_ROUTER_LSA_LINK_SIZE
+           + l->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE;
+
+      switch (l->m[0].type)
+        {
+        case LSA_LINK_TYPE_POINTOPOINT:
+          nbr = NULL;
+          for (ALL_LIST_ELEMENTS_RO (area->oiflist, node, oi))
+            if ((nbr = ospf_nbr_lookup_by_routerid (oi->nbrs, &l->link_id))
+                && nbr->state == NSM_Full)
+              break;
+          if (node == NULL)
+            return 0;
+          break;
+
+        case LSA_LINK_TYPE_TRANSIT:
+          oi = ospf_if_lookup_by_local_addr (ospf, NULL, l->link_data);
+          if (oi == NULL || oi->area != area)
+            break;
+
+          if (!IPV4_ADDR_SAME (&l->link_id, &l->link_data))
+            {
+              /* Adjacency with the DR */
+              nbr = ospf_nbr_lookup_by_addr (oi->nbrs, &l->link_id);
+              if (nbr == NULL || nbr->state != NSM_Full)
+                return 0;
+              break;
+            }
+
+          /* We were the DR: adjacencies with all the attached routers */
+          nlsa = ospf_lsa_lookup (area, OSPF_NETWORK_LSA, l->link_id,
+                                  ospf->router_id);
+          if (nlsa == NULL)
+            break;
+          nl = (struct network_lsa *) nlsa->data;
+          n = (ntohs (nlsa->data->length) - OSPF_LSA_HEADER_SIZE - 4) / 4;
+          for (i = 0; i < n; i++)
+            {
+              if (IPV4_ADDR_SAME (&nl->routers[i], &ospf->router_id))
+                continue;
+              nbr = ospf_nbr_lookup_by_routerid (oi->nbrs, &nl->routers[i]);
+              if (nbr == NULL || nbr->state != NSM_Full)
+                return 0;
+            }
+          break;
+
+        default:
+          break;
+        }
+    }
+
+  return 1;
+}
+
+static void
+ospf_gr_restart_exit (struct ospf *ospf, const char *why)
+{
+  struct ospf_interface *oi;
+  struct ospf_if_params *oip;
+  struct ospf_area *area;
+  struct ospf_lsa *lsa;
+  struct route_node *rn;
+  struct listnode *node, *inode;
+
+  zlog_notice ("GR: restart done: %s", why);
+
+  ospf->gr_restarting = 0;
+  OSPF_TIMER_OFF (ospf->t_gr_grace);
+
+  /* Originate our router-LSAs, and network-LSAs where we are DR,
+     continuing the sequence of the instances the helpers kept. */
+  for (ALL_LIST_ELEMENTS_RO (ospf->areas, node, area))
+    {
+      ospf_router_lsa_update_area (area);
+
+      for (ALL_LIST_ELEMENTS_RO (area->oiflist, inode, oi))
+        if (oi->state == ISM_DR)
+          {
+            lsa = ospf_lsa_lookup (area, OSPF_NETWORK_LSA,
+                                   oi->address->u.prefix4, ospf->router_id);
+            oip = ospf_lookup_if_params (oi->ifp, oi->address->u.prefix4);
+            if (lsa && oip
+                && ntohl (lsa->data->ls_seqnum) > ntohl (oip->network_lsa_seqnum))
+              oip->network_lsa_seqnum = lsa->data->ls_seqnum;
+            ospf_network_lsa_update (oi);
+          }
+
+      /* Flush the network-LSAs of the networks we are no more DR of */
+      LSDB_LOOP (NETWORK_LSDB (area), rn, lsa)
+        if (IPV4_ADDR_SAME (&lsa->data->adv_router, &ospf->router_id)
+            && !IS_LSA_MAXAGE (lsa))
+          {
+            oi = ospf_if_lookup_by_local_addr (ospf, NULL, lsa->data->id);
+            if (oi == NULL || oi->network_lsa_self != lsa)
+              ospf_lsa_flush_area (lsa, area);
+          }
+    }
+
+  /* End helper mode on our neighbors */
+  ospf->gr_seqnum++;
+  for (ALL_LIST_ELEMENTS_RO (ospf->oiflist, node, oi))
+    if (oi->type != OSPF_IFTYPE_VIRTUALLINK && oi->full_nbrs > 0)
+      ospf_gr_lsa_send (oi, 0, 1);
+
+  /* Compute and install the routes, then remove those not refreshed */
+  ospf->gr_sweep = 1;
+  ospf_spf_calculate_schedule (ospf, SPF_FLAG_CONFIG_CHANGE);
+}
+
+static int
+ospf_gr_grace_timer (struct thread *thread)
+{
+  struct ospf *ospf = THREAD_ARG (thread);
+
+  ospf->t_gr_grace = NULL;
+  ospf_gr_restart_exit (ospf, "grace period expired");
+
+  return 0;
+}
+
+static void
+ospf_gr_restart_check (struct ospf *ospf)
+{
+  struct ospf_area *area;
+  struct listnode *node;
+
+  for (ALL_LIST_ELEMENTS_RO (ospf->areas, node, area))
+    if (!ospf_gr_area_ready (ospf, area))
+      return;
+
+  ospf_gr_restart_exit (ospf, "adjacencies restored");
+}
+
+/* Called for the new OSPF instance: restart gracefully if the state
+   file says we are within the grace period. */
+void
+ospf_gr_restart_init (struct ospf *ospf)
+{
+  time_t now = quagga_time (NULL);
+
+  if (gr_restart_end <= now)
+    return;
+
+  ospf->gr_restarting = 1;
+  ospf->gr_seqnum = gr_restart_seqnum;
+  ospf->t_gr_grace = thread_add_timer (master, ospf_gr_grace_timer, ospf,
+                                       gr_restart_end - now);
+  zlog_notice ("GR: restarting, grace period ends in %lds",
+               (long) (gr_restart_end - now));
+  gr_restart_end = 0;
+}
+
+/* A grace-LSA of ours comes back from a helper while we restart: leave
+   it to the helpers, so that they go on helping until we flush it. */
+int
+ospf_gr_lsa_received (struct ospf *ospf, struct ospf_lsa *lsa)
+{
+  if (!ospf->gr_restarting || !is_grace_lsa (lsa))
+    return 0;
+
+  if (ntohl (lsa->data->ls_seqnum) > ospf->gr_seqnum)
+    ospf->gr_seqnum = ntohl (lsa->data->ls_seqnum);
+
+  return 1;
+}
+
+/* The restarting router takes the DR and BDR its neighbors still have
+   rather than electing new ones, RFC 3623 2.2. */
+void
+ospf_gr_hello_received (struct ospf_interface *oi, struct in_addr d_router,
+                        struct in_addr bd_router)
+{
+  if (!oi->ospf->gr_restarting || oi->state != ISM_Waiting
+      || d_router.s_addr == 0)
+    return;
+
+  DR (oi) = d_router;
+  BDR (oi) = bd_router;
+  OSPF_ISM_EVENT_SCHEDULE (oi, ISM_BackupSeen);
+}
+
+/* NSM change hook, for both modes. */
+void
+ospf_gr_nsm_change (struct ospf_neighbor *nbr, int old_state)
+{
+  struct ospf *ospf = nbr->oi->ospf;
+
+  if (ospf->gr_restarting && nbr->state == NSM_Full
+      && old_state != NSM_Full)
+    ospf_gr_restart_check (ospf);
+
+  if (OSPF_GR_HELPING (nbr) && nbr->state == NSM_Down)
+    ospf_gr_helper_exit (nbr, "neighbor down");
+}
+
+/* The routes computed after the restart are sent to zebra: the routes
+   it kept from before the restart and not sent again can go. */
+void
+ospf_gr_routes_installed (struct ospf *ospf)
+{
+  if (!ospf->gr_sweep || ospf->t_spf_calc)
+    return;
+
+  ospf->gr_sweep = 0;
+  zebra_route_sweep_send (zclient, ZEBRA_ROUTE_OSPF);
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are vty command functions.
+ *------------------------------------------------------------------------*/
+
+static void
+ospf_gr_show_info (struct vty *vty, struct ospf_lsa *lsa)
+{
+  u_int32_t period;
+  u_char reason;
+
+  ospf_gr_lsa_parse (lsa, &period, &reason);
+
+  if (vty != NULL)
+    {
+      vty_out (vty, "  Grace period: %u seconds%s", period, VTY_NEWLINE);
+      vty_out (vty, "  Restart reason: %s%s",
+               LOOKUP (ospf_gr_reason_msg, reason), VTY_NEWLINE);
+    }
+  else
+    zlog_debug ("    Grace period %u, restart reason %s", period,
+                LOOKUP (ospf_gr_reason_msg, reason));
+}
+
+static void
+ospf_gr_config_write_router (struct vty *vty)
+{
+  struct ospf *ospf = ospf_lookup ();
+
+  if (ospf == NULL)
+    return;
+
+  if (ospf->gr_grace_period == OSPF_GR_GRACE_PERIOD_DEFAULT)
+    vty_out (vty, " graceful-restart%s", VTY_NEWLINE);
+  else if (ospf->gr_grace_period)
+    vty_out (vty, " graceful-restart grace-period %u%s",
+             ospf->gr_grace_period, VTY_NEWLINE);
+
+  if (ospf->gr_helper_disable)
+    vty_out (vty, " graceful-restart helper-disable%s", VTY_NEWLINE);
+}
+
+DEFUN (ospf_graceful_restart,
+       ospf_graceful_restart_cmd,
+       "graceful-restart",
+       "Graceful restart (RFC 3623)\n")
+{
+  struct ospf *ospf = vty->index;
+
+  ospf->gr_grace_period = OSPF_GR_GRACE_PERIOD_DEFAULT;
+  if (argc == 1)
+    VTY_GET_INTEGER_RANGE ("grace period", ospf->gr_grace_period, argv[0],
+                           1, OSPF_GR_GRACE_PERIOD_MAX);
+
+  return CMD_SUCCESS;
+}
+
+ALIAS (ospf_graceful_restart,
+       ospf_graceful_restart_period_cmd,
+       "graceful-restart grace-period <1-1800>",
+       "Graceful restart (RFC 3623)\n"
+       "Time the neighbors help us restart\n"
+       "Seconds\n")
+
+DEFUN (no_ospf_graceful_restart,
+       no_ospf_graceful_restart_cmd,
+       "no graceful-restart",
+       NO_STR
+       "Graceful restart (RFC 3623)\n")
+{
+  struct ospf *ospf = vty->index;
+
+  ospf->gr_grace_period = 0;
+
+  return CMD_SUCCESS;
+}
+
+ALIAS (no_ospf_graceful_restart,
+       no_ospf_graceful_restart_period_cmd,
+       "no graceful-restart grace-period <1-1800>",
+       NO_STR
+       "Graceful restart (RFC 3623)\n"
+       "Time the neighbors help us restart\n"
+       "Seconds\n")
+
+DEFUN (ospf_graceful_restart_helper_disable,
+       ospf_graceful_restart_helper_disable_cmd,
+       "graceful-restart helper-disable",
+       "Graceful restart (RFC 3623)\n"
+       "Don't help the neighbors restart\n")
+{
+  struct ospf *ospf = vty->index;
+  struct ospf_interface *oi;
+  struct ospf_neighbor *nbr;
+  struct route_node *rn;
+  struct listnode *node;
+
+  ospf->gr_helper_disable = 1;
+
+  for (ALL_LIST_ELEMENTS_RO (ospf->oiflist, node, oi))
+    for (rn = route_top (oi->nbrs); rn; rn = route_next (rn))
+      if ((nbr = rn->info) != NULL)
+        ospf_gr_helper_exit (nbr, "helper mode disabled");
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (no_ospf_graceful_restart_helper_disable,
+       no_ospf_graceful_restart_helper_disable_cmd,
+       "no graceful-restart helper-disable",
+       NO_STR
+       "Graceful restart (RFC 3623)\n"
+       "Don't help the neighbors restart\n")
+{
+  struct ospf *ospf = vty->index;
+
+  ospf->gr_helper_disable = 0;
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (graceful_restart_prepare_ip_ospf,
+       graceful_restart_prepare_ip_ospf_cmd,
+       "graceful-restart prepare ip ospf",
+       "Graceful restart\n"
+       "Prepare a planned restart\n"
+       IP_STR
+       "OSPF information\n")
+{
+  struct ospf *ospf = ospf_lookup ();
+  struct ospf_interface *oi;
+  struct listnode *node;
+
+  if (ospf == NULL)
+    {
+      vty_out (vty, "%% OSPF is not running%s", VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+  if (ospf->gr_grace_period == 0)
+    {
+      vty_out (vty, "%% Graceful restart is not enabled%s", VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+  if (!CHECK_FLAG (ospf->config, OSPF_OPAQUE_CAPABLE))
+    {
+      vty_out (vty, "%% Graceful restart needs the opaque capability%s",
+               VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+  if (ospf->gr_restarting)
+    {
+      vty_out (vty, "%% Restart in progress%s", VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+
+  ospf->gr_seqnum = ospf->gr_seqnum ? ospf->gr_seqnum + 1
+                                    : OSPF_INITIAL_SEQUENCE_NUMBER;
+  for (ALL_LIST_ELEMENTS_RO (ospf->oiflist, node, oi))
+    if (oi->type != OSPF_IFTYPE_VIRTUALLINK && oi->full_nbrs > 0)
+      ospf_gr_lsa_send (oi, ospf->gr_grace_period, 0);
+
+  ospf_gr_state_write (ospf->gr_grace_period, ospf->gr_seqnum);
+  zebra_route_preserve_send (zclient, ZEBRA_ROUTE_OSPF,
+                             ospf->gr_grace_period + OSPF_GR_STALE_SLACK);
+  ospf->gr_prepared = 1;
+
+  vty_out (vty, "Grace-LSAs sent, restart ospfd within %u seconds%s",
+           ospf->gr_grace_period, VTY_NEWLINE);
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (show_ip_ospf_graceful_restart,
+       show_ip_ospf_graceful_restart_cmd,
+       "show ip ospf graceful-restart",
+       SHOW_STR
+       IP_STR
+       "OSPF information\n"
+       "Graceful restart (RFC 3623)\n")
+{
+  struct ospf *ospf = ospf_lookup ();
+  struct ospf_interface *oi;
+  struct ospf_neighbor *nbr;
+  struct route_node *rn;
+  struct listnode *node;
+
+  if (ospf == NULL)
+    {
+      vty_out (vty, " OSPF Routing Process not enabled%s", VTY_NEWLINE);
+      return CMD_SUCCESS;
+    }
+
+  if (ospf->gr_grace_period)
+    vty_out (vty, " Graceful restart enabled, grace period %u seconds%s",
+             ospf->gr_grace_period, VTY_NEWLINE);
+  else
+    vty_out (vty, " Graceful restart disabled%s", VTY_NEWLINE);
+  vty_out (vty, " Helper mode %s%s",
+           ospf->gr_helper_disable ? "disabled" : "enabled", VTY_NEWLINE);
+
+  if (ospf->gr_restarting)
+    vty_out (vty, " Restarting, grace period ends in %lu seconds%s",
+             thread_timer_remain_second (ospf->t_gr_grace), VTY_NEWLINE);
+  else if (ospf->gr_prepared)
+    vty_out (vty, " Prepared to restart%s", VTY_NEWLINE);
+
+  vty_out (vty, " Helping %d neighbor(s)%s", ospf->gr_helpers, VTY_NEWLINE);
+  for (ALL_LIST_ELEMENTS_RO (ospf->oiflist, node, oi))
+    for (rn = route_top (oi->nbrs); rn; rn = route_next (rn))
+      if ((nbr = rn->info) != NULL && OSPF_GR_HELPING (nbr))
+        vty_out (vty, "  %-15s %-16s %s, %lu seconds left%s",
+                 inet_ntoa (nbr->router_id), IF_NAME (oi),
+                 LOOKUP (ospf_gr_reason_msg, nbr->gr_reason),
+                 thread_timer_remain_second (nbr->t_gr_helper), VTY_NEWLINE);
+
+  return CMD_SUCCESS;
+}
+
+int
+ospf_gr_init (void)
+{
+  int rc;
+
+  rc = ospf_register_opaque_functab (OSPF_OPAQUE_LINK_LSA,
+                                     OPAQUE_TYPE_GRACE_LSA,
+                                     NULL,    /* new interface */
+                                     NULL,    /* del interface */
+                                     NULL,    /* ism change */
+                                     NULL,    /* nsm change */
+                                     ospf_gr_config_write_router,
+                                     NULL,    /* Config. write interface */
+                                     NULL,    /* Config. write debug */
+                                     ospf_gr_show_info,
+                                     NULL,    /* originator */
+                                     NULL,    /* refresher */
+                                     ospf_gr_lsa_install_hook,
+                                     ospf_gr_lsa_delete_hook);
+  if (rc != 0)
+    {
+      zlog_warn ("ospf_gr_init: Failed to register functions");
+      return rc;
+    }
+
+  ospf_gr_state_read ();
+
+  install_element (OSPF_NODE, &ospf_graceful_restart_cmd);
+  install_element (OSPF_NODE, &ospf_graceful_restart_period_cmd);
+  install_element (OSPF_NODE, &no_ospf_graceful_restart_cmd);
+  install_element (OSPF_NODE, &no_ospf_graceful_restart_period_cmd);
+  install_element (OSPF_NODE, &ospf_graceful_restart_helper_disable_cmd);
+  install_element (OSPF_NODE, &no_ospf_graceful_restart_helper_disable_cmd);
+  install_element (ENABLE_NODE, &graceful_restart_prepare_ip_ospf_cmd);
+  install_element (VIEW_NODE, &show_ip_ospf_graceful_restart_cmd);
+  install_element (ENABLE_NODE, &show_ip_ospf_graceful_restart_cmd);
+
+  return 0;
+}
+
+void
+ospf_gr_term (void)
+{
+  ospf_delete_opaque_functab (OSPF_OPAQUE_LINK_LSA, OPAQUE_TYPE_GRACE_LSA);
+}
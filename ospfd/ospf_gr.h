@@ -0,0 +1,92 @@
+/*
+ * OSPF Graceful Restart, RFC 3623
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _ZEBRA_OSPF_GR_H
+#define _ZEBRA_OSPF_GR_H
+
+/*
+ * Before a planned restart, the router floods a grace-LSA (link local
+ * Opaque-LSA of type 3) on each interface and asks zebra to keep its
+ * routes in the FIB. Its neighbors enter helper mode: they go on
+ * advertising their adjacency with the restarting router until it has
+ * resynchronised its LSDB, it flushes its grace-LSAs, or the grace
+ * period expires. Meanwhile, the restarting router neither originates
+ * router-LSAs or network-LSAs nor modifies the FIB.
+ *
+ *        24       16        8        0
+ * +--------+--------+--------+--------+ ---
+ * |   LS age        |Options |    9   |  A
+ * +--------+--------+--------+--------+  |
+ * |    3   |            0             |  |
+ * +--------+--------+--------+--------+  |  Standard (Opaque) LSA header;
+ * |        Advertising router         |  |  only type 9 is used.
+ * +--------+--------+--------+--------+  |
+ * |        LS sequence number         |  |
+ * +--------+--------+--------+--------+  |
+ * |   LS checksum   |     Length      |  V
+ * +--------+--------+--------+--------+ ---
+ * |      Type       |     Length      |  A  TLVs: grace period, restart
+ * +--------+--------+--------+--------+  |  reason and, on multi-access
+ * |              Values ...           |  V  networks, interface address.
+ * +--------+--------+--------+--------+ ---
+ */
+
+struct gr_tlv_header
+{
+  u_int16_t type;		/* GR_TLV_XXX (see below) */
+  u_int16_t length;		/* Value portion only, in byte */
+};
+
+#define GR_TLV_HDR_SIZE (sizeof (struct gr_tlv_header))
+#define GR_TLV_BODY_SIZE(tlvh) (ROUNDUP (ntohs ((tlvh)->length), sizeof (u_int32_t)))
+#define GR_TLV_SIZE(tlvh) (GR_TLV_HDR_SIZE + GR_TLV_BODY_SIZE(tlvh))
+#define GR_TLV_HDR_TOP(lsah) (struct gr_tlv_header *)((char *)(lsah) + OSPF_LSA_HEADER_SIZE)
+#define GR_TLV_HDR_NEXT(tlvh) (struct gr_tlv_header *)((char *)(tlvh) + GR_TLV_SIZE(tlvh))
+
+#define GR_TLV_GRACE_PERIOD		1	/* seconds, 4 bytes */
+#define GR_TLV_REASON			2	/* 1 byte */
+#define GR_TLV_IF_ADDRESS		3	/* 4 bytes */
+
+/* Restart reasons */
+#define OSPF_GR_REASON_UNKNOWN		0
+#define OSPF_GR_REASON_SW_RESTART	1
+#define OSPF_GR_REASON_SW_UPGRADE	2
+#define OSPF_GR_REASON_SWITCHOVER	3
+
+/* Grace period, seconds */
+#define OSPF_GR_GRACE_PERIOD_DEFAULT	120
+#define OSPF_GR_GRACE_PERIOD_MAX	1800
+
+/* Extra time zebra keeps the routes, for the last SPF to complete */
+#define OSPF_GR_STALE_SLACK		30
+
+/* Prototypes. */
+extern int ospf_gr_init (void);
+extern void ospf_gr_term (void);
+extern void ospf_gr_restart_init (struct ospf *);
+extern void ospf_gr_nsm_change (struct ospf_neighbor *, int);
+extern void ospf_gr_lsa_change (struct ospf *, struct ospf_lsa *);
+extern int ospf_gr_lsa_received (struct ospf *, struct ospf_lsa *);
+extern void ospf_gr_hello_received (struct ospf_interface *,
+                                    struct in_addr, struct in_addr);
+extern void ospf_gr_routes_installed (struct ospf *);
+
+#endif /* _ZEBRA_OSPF_GR_H */
@@ -49,6 +49,7 @@
 #include "ospfd/ospf_route.h"
 #include "ospfd/ospf_ase.h"
 #include "ospfd/ospf_zebra.h"
+#include "ospfd/ospf_gr.h"
 
 
 u_int32_t
@@ -465,7 +466,7 @@ ospf_nbr_lookup_ptop (struct ospf_interface *oi)
   for (rn = route_top (oi->nbrs); rn; rn = route_next (rn))
     if ((nbr = rn->info))
       if (!IPV4_ADDR_SAME (&nbr->router_id, &oi->ospf->router_id))
-	if (nbr->state == NSM_Full)
+	if (OSPF_NBR_ADV_FULL (nbr))
 	  {
 	    route_unlock_node (rn);
 	    break;
@@ -550,7 +551,7 @@ lsa_link_ptop_set (struct stream *s, struct ospf_interface *oi)
     zlog_debug ("LSA[Type1]: Set link Point-to-Point");
 
   if ((nbr = ospf_nbr_lookup_ptop (oi)))
-    if (nbr->state == NSM_Full)
+    if (OSPF_NBR_ADV_FULL (nbr))
       {
 	/* For unnumbered point-to-point networks, the Link Data field
 	   should specify the interface's MIB-II ifIndex value. */
@@ -590,9 +591,9 @@ lsa_link_broadcast_set (struct stream *s, struct ospf_interface *oi)
 
   dr = ospf_nbr_lookup_by_addr (oi->nbrs, &DR (oi));
   /* Describe Type 2 link. */
-  if (dr && (dr->state == NSM_Full ||
+  if (dr && (OSPF_NBR_ADV_FULL (dr) ||
 	     IPV4_ADDR_SAME (&oi->address->u.prefix4, &DR (oi))) &&
-      ospf_nbr_count (oi, NSM_Full) > 0)
+      ospf_nbr_count_adv_full (oi) > 0)
     {
       if (IS_DEBUG_OSPF (lsa, LSA_GENERATE))
         zlog_debug ("LSA[Type1]: Interface %s has a DR. "
@@ -636,7 +637,7 @@ lsa_link_virtuallink_set (struct stream *s, struct ospf_interface *oi)
 
   if (oi->state == ISM_PointToPoint)
     if ((nbr = ospf_nbr_lookup_ptop (oi)))
-      if (nbr->state == NSM_Full)
+      if (OSPF_NBR_ADV_FULL (nbr))
 	{
 	  return link_info_set (s, nbr->router_id, oi->address->u.prefix4,
 			        LSA_LINK_TYPE_VIRTUALLINK, 0, cost);
@@ -672,7 +673,7 @@ lsa_link_ptomp_set (struct stream *s, struct ospf_interface *oi)
     if ((nbr = rn->info) != NULL)
       /* Ignore myself. */
       if (!IPV4_ADDR_SAME (&nbr->router_id, &oi->ospf->router_id))
-	if (nbr->state == NSM_Full)
+	if (OSPF_NBR_ADV_FULL (nbr))
 
 	  {
 	    links += link_info_set (s, nbr->router_id, oi->address->u.prefix4,
@@ -869,8 +870,12 @@ ospf_router_lsa_new (struct ospf_area *area)
 static struct ospf_lsa *
 ospf_router_lsa_originate (struct ospf_area *area)
 {
-  struct ospf_lsa *new;
+  struct ospf_lsa *new, *old;
   
+  /* The helpers keep our pre-restart router-LSA meanwhile */
+  if (area->ospf->gr_restarting)
+    return NULL;
+
   /* Create new router-LSA instance. */
   if ( (new = ospf_router_lsa_new (area)) == NULL)
     {
@@ -887,6 +892,13 @@ ospf_router_lsa_originate (struct ospf_area *area)
       return NULL;
     }
 
+  /* Supersede an instance learnt back from the neighbors, such as
+     the one kept during a graceful restart. */
+  old = ospf_lsa_lookup (area, OSPF_ROUTER_LSA, new->data->id,
+                         new->data->adv_router);
+  if (old != NULL)
+    new->data->ls_seqnum = lsa_seqnum_increment (old);
+
   /* Install LSA to LSDB. */
   new = ospf_lsa_install (area->ospf, NULL, new);
 
@@ -1036,7 +1048,7 @@ ospf_network_lsa_body_set (struct stream *s, struct ospf_interface *oi)
 
   for (rn = route_top (oi->nbrs); rn; rn = route_next (rn))
     if ((nbr = rn->info) != NULL)
-      if (nbr->state == NSM_Full || nbr == oi->nbr_self)
+      if (OSPF_NBR_ADV_FULL (nbr) || nbr == oi->nbr_self)
 	stream_put_ipv4 (s, nbr->router_id.s_addr);
 }
 
@@ -1051,7 +1063,7 @@ ospf_network_lsa_new (struct ospf_interface *oi)
 
   /* If there are no neighbours on this network (the net is stub),
      the router does not originate network-LSA (see RFC 12.4.2) */
-  if (oi->full_nbrs == 0)
+  if (oi->full_nbrs == 0 && ospf_nbr_count_adv_full (oi) == 0)
     return NULL;
   
   if (IS_DEBUG_OSPF (lsa, LSA_GENERATE))
@@ -1111,6 +1123,10 @@ ospf_network_lsa_update (struct ospf_interface *oi)
 {
   struct ospf_lsa *new;
   
+  /* The helpers keep our pre-restart network-LSA meanwhile */
+  if (oi->ospf->gr_restarting)
+    return;
+
   if (oi->network_lsa_self != NULL)
     {
       ospf_lsa_refresh (oi->ospf, oi->network_lsa_self);
@@ -2671,6 +2687,9 @@ ospf_lsa_install (struct ospf *ospf, struct ospf_interface *oi,
   if (  old == NULL || ospf_lsa_different(old, lsa))
     rt_recalc = 1;
 
+  if (rt_recalc && ospf->gr_helpers > 0)
+    ospf_gr_lsa_change (ospf, lsa);
+
   /*
      Sequence number check (Section 14.1 of rfc 2328)
      "Premature aging is used when it is time for a self-originated
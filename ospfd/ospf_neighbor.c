@@ -138,6 +138,10 @@ ospf_nbr_free (struct ospf_neighbor *nbr)
   OSPF_NSM_TIMER_OFF (nbr->t_db_desc);
   OSPF_NSM_TIMER_OFF (nbr->t_ls_req);
   OSPF_NSM_TIMER_OFF (nbr->t_ls_upd);
+  OSPF_NSM_TIMER_OFF (nbr->t_gr_helper);
+
+  if (OSPF_GR_HELPING (nbr))
+    nbr->oi->ospf->gr_helpers--;
 
   /* Cancel all events. *//* Thread lookup cost would be negligible. */
   thread_cancel_event (master, nbr);
@@ -272,6 +276,24 @@ ospf_nbr_count (struct ospf_interface *oi, int state)
   return count;
 }
 
+/* Neighbors whose adjacency is advertised, including the restarting
+   ones we help. */
+int
+ospf_nbr_count_adv_full (struct ospf_interface *oi)
+{
+  struct ospf_neighbor *nbr;
+  struct route_node *rn;
+  int count = 0;
+
+  for (rn = route_top (oi->nbrs); rn; rn = route_next (rn))
+    if ((nbr = rn->info))
+      if (!IPV4_ADDR_SAME (&nbr->router_id, &oi->ospf->router_id))
+	if (OSPF_NBR_ADV_FULL (nbr))
+	  count++;
+
+  return count;
+}
+
 int
 ospf_nbr_count_opaque_capable (struct ospf_interface *oi)
 {
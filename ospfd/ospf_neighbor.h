@@ -88,12 +88,22 @@ struct ospf_neighbor
   struct timeval ts_last_regress;   /* last regressive NSM change     */
   const char *last_regress_str;     /* Event which last regressed NSM */
   u_int32_t state_change;           /* NSM state change counter       */
+
+  /* RFC3623 graceful restart helper. */
+  u_char gr_helper;			/* Helping this neighbor restart */
+  u_char gr_reason;			/* Reason from its grace-LSA */
+  struct thread *t_gr_helper;		/* Its grace period */
 };
 
 /* Macros. */
 #define NBR_IS_DR(n)	IPV4_ADDR_SAME (&n->address.u.prefix4, &n->d_router)
 #define NBR_IS_BDR(n)   IPV4_ADDR_SAME (&n->address.u.prefix4, &n->bd_router)
 
+/* While helping the neighbor restart, its adjacency is still advertised
+   as full. */
+#define OSPF_GR_HELPING(n)	((n)->gr_helper)
+#define OSPF_NBR_ADV_FULL(n)	((n)->state == NSM_Full || OSPF_GR_HELPING (n))
+
 /* Prototypes. */
 extern struct ospf_neighbor *ospf_nbr_new (struct ospf_interface *);
 extern void ospf_nbr_free (struct ospf_neighbor *);
@@ -103,6 +113,7 @@ extern void ospf_nbr_self_reset (struct ospf_interface *);
 extern void ospf_nbr_add_self (struct ospf_interface *);
 extern int ospf_nbr_count (struct ospf_interface *, int);
 extern int ospf_nbr_count_opaque_capable (struct ospf_interface *);
+extern int ospf_nbr_count_adv_full (struct ospf_interface *);
 extern struct ospf_neighbor *ospf_nbr_get (struct ospf_interface *,
 					   struct ospf_header *,
 					   struct ip *, struct prefix *);
@@ -48,6 +48,7 @@
 #include "ospfd/ospf_flood.h"
 #include "ospfd/ospf_abr.h"
 #include "ospfd/ospf_snmp.h"
+#include "ospfd/ospf_gr.h"
 
 static void nsm_clear_adj (struct ospf_neighbor *);
 
@@ -64,6 +65,10 @@ ospf_inactivity_timer (struct thread *thread)
     zlog (NULL, LOG_DEBUG, "NSM[%s:%s]: Timer (Inactivity timer expire)",
 	  IF_NAME (nbr->oi), inet_ntoa (nbr->router_id));
 
+  /* Silent while restarting: the grace period bounds the wait */
+  if (OSPF_GR_HELPING (nbr))
+    return 0;
+
   OSPF_NSM_EVENT_SCHEDULE (nbr, NSM_InactivityTimer);
 
   return 0;
@@ -696,38 +701,43 @@ nsm_change_state (struct ospf_neighbor *nbr, int state)
 		ospf_schedule_abr_task (oi->ospf);
 	}
 
-      zlog_info ("nsm_change_state(%s, %s -> %s): "
-		 "scheduling new router-LSA origination",
-		 inet_ntoa (nbr->router_id),
-		 LOOKUP(ospf_nsm_state_msg, old_state),
-		 LOOKUP(ospf_nsm_state_msg, state));
+      /* A neighbor we help restart is still advertised as full */
+      if (!OSPF_GR_HELPING (nbr))
+	{
+	  zlog_info ("nsm_change_state(%s, %s -> %s): "
+		     "scheduling new router-LSA origination",
+		     inet_ntoa (nbr->router_id),
+		     LOOKUP(ospf_nsm_state_msg, old_state),
+		     LOOKUP(ospf_nsm_state_msg, state));
 
-      ospf_router_lsa_update_area (oi->area);
+	  ospf_router_lsa_update_area (oi->area);
 
-      if (oi->type == OSPF_IFTYPE_VIRTUALLINK)
-	{
-	  struct ospf_area *vl_area =
-	    ospf_area_lookup_by_area_id (oi->ospf, oi->vl_data->vl_area_id);
-	  
-	  if (vl_area)
-	    ospf_router_lsa_update_area (vl_area);
-	}
+	  if (oi->type == OSPF_IFTYPE_VIRTUALLINK)
+	    {
+	      struct ospf_area *vl_area =
+		ospf_area_lookup_by_area_id (oi->ospf, oi->vl_data->vl_area_id);
 
-      /* Originate network-LSA. */
-      if (oi->state == ISM_DR)
-	{
-	  if (oi->network_lsa_self && oi->full_nbrs == 0)
+	      if (vl_area)
+		ospf_router_lsa_update_area (vl_area);
+	    }
+
+	  /* Originate network-LSA. */
+	  if (oi->state == ISM_DR)
 	    {
-	      ospf_lsa_flush_area (oi->network_lsa_self, oi->area);
-	      ospf_lsa_unlock (&oi->network_lsa_self);
-	      oi->network_lsa_self = NULL;
+	      if (oi->network_lsa_self && oi->full_nbrs == 0)
+		{
+		  ospf_lsa_flush_area (oi->network_lsa_self, oi->area);
+		  ospf_lsa_unlock (&oi->network_lsa_self);
+		  oi->network_lsa_self = NULL;
+		}
+	      else
+		ospf_network_lsa_update (oi);
 	    }
-	  else
-	    ospf_network_lsa_update (oi);
 	}
     }
 
   ospf_opaque_nsm_change (nbr, old_state);
+  ospf_gr_nsm_change (nbr, old_state);
 
   /* State changes from > ExStart to <= ExStart should clear any Exchange
    * or Full/LSA Update related lists and state.
@@ -63,6 +63,7 @@
 
 #include "ospfd/ospf_te.h"
 #include "ospfd/ospf_ri.h"
+#include "ospfd/ospf_gr.h"
 
 #ifdef SUPPORT_OSPF_API
 int ospf_apiserver_init (void);
@@ -91,6 +92,9 @@ ospf_opaque_init (void)
   if (ospf_router_info_init () != 0)
     exit (1);
 
+  if (ospf_gr_init () != 0)
+    exit (1);
+
 #ifdef SUPPORT_OSPF_API
   if ((ospf_apiserver_enable) && (ospf_apiserver_init () != 0))
     exit (1);
@@ -106,6 +110,8 @@ ospf_opaque_term (void)
 
   ospf_router_info_term ();
 
+  ospf_gr_term ();
+
 #ifdef SUPPORT_OSPF_API
   ospf_apiserver_term ();
 #endif /* SUPPORT_OSPF_API */
@@ -48,6 +48,7 @@
 #include "ospfd/ospf_spf.h"
 #include "ospfd/ospf_flood.h"
 #include "ospfd/ospf_dump.h"
+#include "ospfd/ospf_gr.h"
 
 /* Packet Type String. */
 const struct message ospf_packet_type_str[] =
@@ -983,6 +984,10 @@ ospf_hello (struct ip *iph, struct ospf_header *ospfh,
     }
   else
     {
+      /* A restarting neighbor we help forgot us: keep the adjacency */
+      if (OSPF_GR_HELPING (nbr))
+	return;
+
       OSPF_NSM_EVENT_SCHEDULE (nbr, NSM_OneWayReceived);
       /* Set neighbor information. */
       nbr->priority = hello->priority;
@@ -991,6 +996,9 @@ ospf_hello (struct ip *iph, struct ospf_header *ospfh,
       return;
     }
 
+  /* Restarting, take the DR and BDR the neighbors kept */
+  ospf_gr_hello_received (oi, hello->d_router, hello->bd_router);
+
   /* If neighbor itself declares DR and no BDR exists,
      cause event BackupSeen */
   if (IPV4_ADDR_SAME (&nbr->address.u.prefix4, &hello->d_router))
@@ -1874,6 +1882,14 @@ ospf_ls_upd (struct ospf *ospf, struct ip *iph, struct ospf_header *ospfh,
            * until its age reaches to MaxAge.
            */
           /* XXX: We should deal with this for *ALL* LSAs, not just opaque */
+          /* Our grace-LSAs stay with the helpers until we flush them */
+          if (ospf_gr_lsa_received (oi->ospf, lsa))
+            {
+              ospf_ls_ack_send (nbr, lsa);
+              ospf_lsa_discard (lsa);
+              continue;
+            }
+
           if (current == NULL)
             {
               if (IS_DEBUG_OSPF_EVENT)
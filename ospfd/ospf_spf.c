@@ -1437,6 +1437,10 @@ ospf_spf_calculate_schedule (struct ospf *ospf, ospf_spf_reason_t reason)
   if (ospf == NULL)
     return;
   
+  /* Graceful restart: the FIB is frozen until the LSDB is complete */
+  if (ospf->gr_restarting)
+    return;
+
   ospf_spf_set_reason (reason);
   
   /* SPF calculation timer is already scheduled. */
@@ -60,6 +60,8 @@
 #include "ospfd/ospf_ase.h"
 #include "ospfd/ospf_zebra.h"
 #include "ospfd/ospf_te.h"
+#include "ospfd/ospf_ted.h"
+#include "ospfd/ospf_cspf.h"
 #include "ospfd/ospf_vty.h"
 
 /*
@@ -111,8 +113,8 @@ ospf_mpls_te_init (void)
                 ospf_mpls_te_show_info,
                 ospf_mpls_te_lsa_originate_area,
                 ospf_mpls_te_lsa_refresh,
-		NULL,/* ospf_mpls_te_new_lsa_hook */
-		NULL /* ospf_mpls_te_del_lsa_hook */);
+		ospf_ted_lsa_update,
+		ospf_ted_lsa_delete);
   if (rc != 0)
     {
       zlog_warn ("ospf_mpls_te_init: Failed to register Traffic Engineering functions");
@@ -124,9 +126,16 @@ ospf_mpls_te_init (void)
   OspfMplsTE.inter_as = Disable;
   OspfMplsTE.iflist = list_new ();
   OspfMplsTE.iflist->del = del_mpls_te_link;
+  OspfMplsTE.threshold[TE_DAMP_DELAY] = TE_DAMP_DEFAULT_THRESHOLD;
+  OspfMplsTE.threshold[TE_DAMP_LOSS] = TE_DAMP_DEFAULT_THRESHOLD;
+  OspfMplsTE.threshold[TE_DAMP_BW] = TE_DAMP_DEFAULT_THRESHOLD;
+  OspfMplsTE.hold_down = TE_DAMP_DEFAULT_HOLDDOWN;
 
   ospf_mpls_te_register_vty ();
 
+  ospf_ted_init ();
+  ospf_cspf_init ();
+
 out:
   return rc;
 }
@@ -200,6 +209,9 @@ ospf_mpls_te_term (void)
   ospf_mpls_te_unregister ();
   OspfMplsTE.inter_as = Disable;
 
+  ospf_cspf_term ();
+  ospf_ted_term ();
+
   return;
 }
 
@@ -210,6 +222,9 @@ ospf_mpls_te_term (void)
 static void
 del_mpls_te_link (void *val)
 {
+  struct mpls_te_link *lp = val;
+
+  THREAD_OFF (lp->t_hold);
   XFREE (MTYPE_OSPF_MPLS_TE, val);
   return;
 }
@@ -964,6 +979,7 @@ ospf_mpls_te_del_if (struct interface *ifp)
       if (listcount (iflist) == 0)
         iflist->head = iflist->tail = NULL;
 
+      THREAD_OFF (lp->t_hold);
       XFREE (MTYPE_OSPF_MPLS_TE, lp);
     }
 
@@ -974,13 +990,184 @@ ospf_mpls_te_del_if (struct interface *ifp)
   return rc;
 }
 
+/*------------------------------------------------------------------------*
+ * Followings are RFC7471 flooding dampening functions.
+ *------------------------------------------------------------------------*/
+
+/* Is the change from the advertised value significant for threshold (%) ? */
+static int
+te_value_significant (float adv, float cur, u_int32_t threshold)
+{
+  if (adv == cur)
+    return 0;
+  if (adv == 0)
+    return 1;
+  return fabsf (cur - adv) * 100 >= fabsf (adv) * threshold;
+}
+
+static int
+te_delay_significant (u_int32_t adv, u_int32_t cur, u_int32_t threshold)
+{
+  adv = ntohl (adv);
+  cur = ntohl (cur);
+
+  /* A change of the Anomalous bit is always significant */
+  if ((adv & TE_EXT_ANORMAL) != (cur & TE_EXT_ANORMAL))
+    return 1;
+  return te_value_significant ((float) (adv & TE_EXT_MASK),
+                               (float) (cur & TE_EXT_MASK), threshold);
+}
+
+static int
+te_bw_significant (float adv, float cur, u_int32_t threshold)
+{
+  return te_value_significant (ntohf (adv), ntohf (cur), threshold);
+}
+
+/* Check if RFC7471 metrics of the link differ significantly from the ones
+   carried by the last originated LSA. */
+static int
+ospf_mpls_te_adv_significant (struct mpls_te_link *lp)
+{
+  struct mpls_te_link_adv *adv = &lp->adv;
+  u_int32_t *th = OspfMplsTE.threshold;
+
+  /* Sub-TLVs which appear or disappear */
+  if (TLV_TYPE(adv->av_delay) != TLV_TYPE(lp->av_delay)
+      || TLV_TYPE(adv->mm_delay) != TLV_TYPE(lp->mm_delay)
+      || TLV_TYPE(adv->delay_var) != TLV_TYPE(lp->delay_var)
+      || TLV_TYPE(adv->pkt_loss) != TLV_TYPE(lp->pkt_loss)
+      || TLV_TYPE(adv->res_bw) != TLV_TYPE(lp->res_bw)
+      || TLV_TYPE(adv->ava_bw) != TLV_TYPE(lp->ava_bw)
+      || TLV_TYPE(adv->use_bw) != TLV_TYPE(lp->use_bw))
+    return 1;
+
+  if (TLV_TYPE(lp->av_delay) != 0
+      && te_delay_significant (adv->av_delay.value, lp->av_delay.value,
+                               th[TE_DAMP_DELAY]))
+    return 1;
+  if (TLV_TYPE(lp->mm_delay) != 0
+      && (te_delay_significant (adv->mm_delay.low, lp->mm_delay.low,
+                                th[TE_DAMP_DELAY])
+          || te_delay_significant (adv->mm_delay.high, lp->mm_delay.high,
+                                   th[TE_DAMP_DELAY])))
+    return 1;
+  if (TLV_TYPE(lp->delay_var) != 0
+      && te_delay_significant (adv->delay_var.value, lp->delay_var.value,
+                               th[TE_DAMP_DELAY]))
+    return 1;
+  if (TLV_TYPE(lp->pkt_loss) != 0
+      && te_delay_significant (adv->pkt_loss.value, lp->pkt_loss.value,
+                               th[TE_DAMP_LOSS]))
+    return 1;
+  if (TLV_TYPE(lp->res_bw) != 0
+      && te_bw_significant (adv->res_bw.value, lp->res_bw.value,
+                            th[TE_DAMP_BW]))
+    return 1;
+  if (TLV_TYPE(lp->ava_bw) != 0
+      && te_bw_significant (adv->ava_bw.value, lp->ava_bw.value,
+                            th[TE_DAMP_BW]))
+    return 1;
+  if (TLV_TYPE(lp->use_bw) != 0
+      && te_bw_significant (adv->use_bw.value, lp->use_bw.value,
+                            th[TE_DAMP_BW]))
+    return 1;
+
+  return 0;
+}
+
+/* Check if Sub-TLVs other than the RFC7471 ones have been modified */
+static int
+ospf_mpls_te_static_changed (struct mpls_te_link *old, struct mpls_te_link *lp)
+{
+  return (old->flags != lp->flags || old->type != lp->type
+          || memcmp (&old->te_metric, &lp->te_metric, sizeof (lp->te_metric))
+          || memcmp (&old->max_bw, &lp->max_bw, sizeof (lp->max_bw))
+          || memcmp (&old->max_rsv_bw, &lp->max_rsv_bw,
+                     sizeof (lp->max_rsv_bw))
+          || memcmp (&old->unrsv_bw, &lp->unrsv_bw, sizeof (lp->unrsv_bw))
+          || memcmp (&old->rsc_clsclr, &lp->rsc_clsclr,
+                     sizeof (lp->rsc_clsclr))
+          || memcmp (&old->ras, &lp->ras, sizeof (lp->ras))
+          || memcmp (&old->rip, &lp->rip, sizeof (lp->rip)));
+}
+
+/* Keep track of what has been advertised for this link */
+static void
+ospf_mpls_te_adv_set (struct mpls_te_link *lp)
+{
+  lp->adv.av_delay = lp->av_delay;
+  lp->adv.mm_delay = lp->mm_delay;
+  lp->adv.delay_var = lp->delay_var;
+  lp->adv.pkt_loss = lp->pkt_loss;
+  lp->adv.res_bw = lp->res_bw;
+  lp->adv.ava_bw = lp->ava_bw;
+  lp->adv.use_bw = lp->use_bw;
+  lp->last_sent = recent_relative_time ().tv_sec;
+  lp->sent++;
+  THREAD_OFF (lp->t_hold);
+}
+
+static int
+ospf_mpls_te_hold_timer (struct thread *thread)
+{
+  struct mpls_te_link *lp = THREAD_ARG (thread);
+
+  lp->t_hold = NULL;
+
+  if (OspfMplsTE.status != enabled
+      || !CHECK_FLAG (lp->flags, LPFLG_LSA_ENGAGED))
+    return 0;
+
+  /* Metrics may have come back close to the advertised ones meanwhile */
+  if (ospf_mpls_te_adv_significant (lp))
+    ospf_mpls_te_lsa_schedule (lp, REFRESH_THIS_LSA);
+  else
+    lp->suppressed++;
+
+  return 0;
+}
+
+/* Refresh the LSA of a link whose RFC7471 metrics only have changed:
+   insignificant changes are not advertised and significant ones are
+   aggregated so that at most one LSA is originated per hold-down. */
+static void
+ospf_mpls_te_dynamic_update (struct mpls_te_link *lp)
+{
+  time_t elapsed;
+
+  if (!ospf_mpls_te_adv_significant (lp))
+    {
+      lp->suppressed++;
+      return;
+    }
+
+  /* A refresh is already pending */
+  if (lp->t_hold != NULL)
+    {
+      lp->deferred++;
+      return;
+    }
+
+  elapsed = recent_relative_time ().tv_sec - lp->last_sent;
+  if (elapsed >= (time_t) OspfMplsTE.hold_down)
+    {
+      ospf_mpls_te_lsa_schedule (lp, REFRESH_THIS_LSA);
+      return;
+    }
+
+  lp->deferred++;
+  lp->t_hold = thread_add_timer (master, ospf_mpls_te_hold_timer, lp,
+                                 OspfMplsTE.hold_down - elapsed);
+}
+
 /* Main initialization / update function of the MPLS TE Link context */
 
 /* Call when interface TE Link parameters are modified */
 void
 ospf_mpls_te_update_if (struct interface *ifp)
 {
-  struct mpls_te_link *lp;
+  struct mpls_te_link *lp, old;
 
   if (IS_DEBUG_OSPF_TE)
     zlog_debug ("OSPF MPLS-TE: Update LSA parameters for interface %s [%s]",
@@ -999,16 +1186,19 @@ ospf_mpls_te_update_if (struct interface *ifp)
       SET_FLAG (lp->flags, LPFLG_LSA_ACTIVE);
 
       /* Update TE parameters */
+      memcpy (&old, lp, sizeof (struct mpls_te_link));
       update_linkparams(lp);
 
       /* Finally Re-Originate or Refresh Opaque LSA if MPLS_TE is enabled */
       if (OspfMplsTE.status == enabled)
         if (lp->area != NULL)
           {
-            if CHECK_FLAG (lp->flags, LPFLG_LSA_ENGAGED)
+            if (!CHECK_FLAG (lp->flags, LPFLG_LSA_ENGAGED))
+                ospf_mpls_te_lsa_schedule (lp, REORIGINATE_THIS_LSA);
+            else if (ospf_mpls_te_static_changed (&old, lp))
                 ospf_mpls_te_lsa_schedule (lp, REFRESH_THIS_LSA);
             else
-                ospf_mpls_te_lsa_schedule (lp, REORIGINATE_THIS_LSA);
+                ospf_mpls_te_dynamic_update (lp);
           }
     }
   else
@@ -1198,6 +1388,7 @@ ospf_mpls_te_lsa_body_set (struct stream *s, struct mpls_te_link *lp)
    * granularity changes in topology.
    */
   build_link_tlv (s, lp);
+  ospf_mpls_te_adv_set (lp);
   return;
 }
 
@@ -2248,6 +2439,19 @@ ospf_mpls_te_config_write_router (struct vty *vty)
     vty_out (vty, "  mpls-te inter-as area %s %s",
              inet_ntoa (OspfMplsTE.interas_areaid), VTY_NEWLINE);
 
+  if (OspfMplsTE.threshold[TE_DAMP_DELAY] != TE_DAMP_DEFAULT_THRESHOLD)
+    vty_out (vty, "  mpls-te dampening threshold delay %u%s",
+             OspfMplsTE.threshold[TE_DAMP_DELAY], VTY_NEWLINE);
+  if (OspfMplsTE.threshold[TE_DAMP_LOSS] != TE_DAMP_DEFAULT_THRESHOLD)
+    vty_out (vty, "  mpls-te dampening threshold loss %u%s",
+             OspfMplsTE.threshold[TE_DAMP_LOSS], VTY_NEWLINE);
+  if (OspfMplsTE.threshold[TE_DAMP_BW] != TE_DAMP_DEFAULT_THRESHOLD)
+    vty_out (vty, "  mpls-te dampening threshold bandwidth %u%s",
+             OspfMplsTE.threshold[TE_DAMP_BW], VTY_NEWLINE);
+  if (OspfMplsTE.hold_down != TE_DAMP_DEFAULT_HOLDDOWN)
+    vty_out (vty, "  mpls-te dampening hold-down %u%s",
+             OspfMplsTE.hold_down, VTY_NEWLINE);
+
   return;
 }
 
@@ -2490,6 +2694,98 @@ DEFUN (no_ospf_mpls_te_inter_as,
   return CMD_SUCCESS;
 }
 
+static int
+te_damp_class (const char *name)
+{
+  if (strncmp (name, "d", 1) == 0)
+    return TE_DAMP_DELAY;
+  if (strncmp (name, "l", 1) == 0)
+    return TE_DAMP_LOSS;
+  return TE_DAMP_BW;
+}
+
+DEFUN (ospf_mpls_te_damp_threshold,
+       ospf_mpls_te_damp_threshold_cmd,
+       "mpls-te dampening threshold (delay|loss|bandwidth) <0-100>",
+       MPLS_TE_STR
+       "Configure RFC7471 metrics advertisement dampening\n"
+       "Minimum relative change to advertise\n"
+       "Average, Min/Max delay and delay variation\n"
+       "Packet loss\n"
+       "Residual, Available and Utilized bandwidth\n"
+       "Percentage of the advertised value\n")
+{
+  u_int32_t threshold;
+
+  VTY_GET_INTEGER_RANGE ("threshold", threshold, argv[1], 0, 100);
+  OspfMplsTE.threshold[te_damp_class (argv[0])] = threshold;
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (no_ospf_mpls_te_damp_threshold,
+       no_ospf_mpls_te_damp_threshold_cmd,
+       "no mpls-te dampening threshold (delay|loss|bandwidth)",
+       NO_STR
+       MPLS_TE_STR
+       "Configure RFC7471 metrics advertisement dampening\n"
+       "Minimum relative change to advertise\n"
+       "Average, Min/Max delay and delay variation\n"
+       "Packet loss\n"
+       "Residual, Available and Utilized bandwidth\n")
+{
+  OspfMplsTE.threshold[te_damp_class (argv[0])] = TE_DAMP_DEFAULT_THRESHOLD;
+
+  return CMD_SUCCESS;
+}
+
+ALIAS (no_ospf_mpls_te_damp_threshold,
+       no_ospf_mpls_te_damp_threshold_val_cmd,
+       "no mpls-te dampening threshold (delay|loss|bandwidth) <0-100>",
+       NO_STR
+       MPLS_TE_STR
+       "Configure RFC7471 metrics advertisement dampening\n"
+       "Minimum relative change to advertise\n"
+       "Average, Min/Max delay and delay variation\n"
+       "Packet loss\n"
+       "Residual, Available and Utilized bandwidth\n"
+       "Percentage of the advertised value\n")
+
+DEFUN (ospf_mpls_te_damp_hold_down,
+       ospf_mpls_te_damp_hold_down_cmd,
+       "mpls-te dampening hold-down <0-3600>",
+       MPLS_TE_STR
+       "Configure RFC7471 metrics advertisement dampening\n"
+       "Minimum interval between two advertisements of a link\n"
+       "Seconds\n")
+{
+  VTY_GET_INTEGER_RANGE ("hold-down", OspfMplsTE.hold_down, argv[0], 0, 3600);
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (no_ospf_mpls_te_damp_hold_down,
+       no_ospf_mpls_te_damp_hold_down_cmd,
+       "no mpls-te dampening hold-down",
+       NO_STR
+       MPLS_TE_STR
+       "Configure RFC7471 metrics advertisement dampening\n"
+       "Minimum interval between two advertisements of a link\n")
+{
+  OspfMplsTE.hold_down = TE_DAMP_DEFAULT_HOLDDOWN;
+
+  return CMD_SUCCESS;
+}
+
+ALIAS (no_ospf_mpls_te_damp_hold_down,
+       no_ospf_mpls_te_damp_hold_down_val_cmd,
+       "no mpls-te dampening hold-down <0-3600>",
+       NO_STR
+       MPLS_TE_STR
+       "Configure RFC7471 metrics advertisement dampening\n"
+       "Minimum interval between two advertisements of a link\n"
+       "Seconds\n")
+
 DEFUN (show_ip_ospf_mpls_te_router,
        show_ip_ospf_mpls_te_router_cmd,
        "show ip ospf mpls-te router",
@@ -2507,6 +2803,13 @@ DEFUN (show_ip_ospf_mpls_te_router,
         show_vty_router_addr (vty, &OspfMplsTE.router_addr.header);
       else if (vty != NULL)
         vty_out (vty, "  N/A%s", VTY_NEWLINE);
+
+      vty_out (vty, "  Dampening thresholds: delay %u%%, loss %u%%, "
+               "bandwidth %u%%, hold-down %u sec%s",
+               OspfMplsTE.threshold[TE_DAMP_DELAY],
+               OspfMplsTE.threshold[TE_DAMP_LOSS],
+               OspfMplsTE.threshold[TE_DAMP_BW],
+               OspfMplsTE.hold_down, VTY_NEWLINE);
     }
   return CMD_SUCCESS;
 }
@@ -2581,6 +2884,9 @@ show_mpls_te_link_sub (struct vty *vty, struct interface *ifp)
         show_vty_link_subtlv_ava_bw (vty, &lp->ava_bw.header);
       if (TLV_TYPE(lp->use_bw) != 0)
         show_vty_link_subtlv_use_bw (vty, &lp->use_bw.header);
+      vty_out (vty, "  Advertisement: %u LSA sent, %u changes suppressed, "
+               "%u deferred%s%s", lp->sent, lp->suppressed, lp->deferred,
+               lp->t_hold ? " (refresh pending)" : "", VTY_NEWLINE);
       vty_out (vty, "---------------%s%s", VTY_NEWLINE, VTY_NEWLINE);
     }
   else
@@ -2637,6 +2943,12 @@ ospf_mpls_te_register_vty (void)
   install_element (OSPF_NODE, &ospf_mpls_te_inter_as_cmd);
   install_element (OSPF_NODE, &ospf_mpls_te_inter_as_area_cmd);
   install_element (OSPF_NODE, &no_ospf_mpls_te_inter_as_cmd);
+  install_element (OSPF_NODE, &ospf_mpls_te_damp_threshold_cmd);
+  install_element (OSPF_NODE, &no_ospf_mpls_te_damp_threshold_cmd);
+  install_element (OSPF_NODE, &no_ospf_mpls_te_damp_threshold_val_cmd);
+  install_element (OSPF_NODE, &ospf_mpls_te_damp_hold_down_cmd);
+  install_element (OSPF_NODE, &no_ospf_mpls_te_damp_hold_down_cmd);
+  install_element (OSPF_NODE, &no_ospf_mpls_te_damp_hold_down_val_cmd);
 
   return;
 }
@@ -383,6 +383,19 @@ struct te_link_subtlv
   } value;
 };
 
+/*
+ * Flooding dampening of the RFC7471 dynamic metrics (section 5): a change
+ * is advertised only if it exceeds the threshold of its class, relatively
+ * to the last advertised value, and at most once per hold-down interval.
+ */
+#define TE_DAMP_DELAY		0	/* Av, Min/Max delay, Delay variation */
+#define TE_DAMP_LOSS		1	/* Packet loss */
+#define TE_DAMP_BW		2	/* Residual, Available, Utilized bw */
+#define TE_DAMP_MAX		3
+
+#define TE_DAMP_DEFAULT_THRESHOLD	10	/* percent */
+#define TE_DAMP_DEFAULT_HOLDDOWN	30	/* seconds */
+
 /* Following structure are internal use only. */
 struct ospf_mpls_te
 {
@@ -398,6 +411,22 @@ struct ospf_mpls_te
 
   /* Store Router-TLV in network byte order. */
   struct te_tlv_router_addr router_addr;
+
+  /* RFC7471 flooding dampening */
+  u_int32_t threshold[TE_DAMP_MAX];
+  u_int32_t hold_down;
+};
+
+/* RFC7471 Sub-TLVs carried by the last originated LSA */
+struct mpls_te_link_adv
+{
+  struct te_link_subtlv_av_delay av_delay;
+  struct te_link_subtlv_mm_delay mm_delay;
+  struct te_link_subtlv_delay_var delay_var;
+  struct te_link_subtlv_pkt_loss pkt_loss;
+  struct te_link_subtlv_res_bw res_bw;
+  struct te_link_subtlv_ava_bw ava_bw;
+  struct te_link_subtlv_use_bw use_bw;
 };
 
 struct mpls_te_link
@@ -451,6 +480,16 @@ struct mpls_te_link
 
   struct in_addr adv_router;
   struct in_addr id;
+
+  /* RFC7471 flooding dampening */
+  struct mpls_te_link_adv adv;
+  struct thread *t_hold;
+  time_t last_sent;
+
+  /* Statistics */
+  u_int32_t sent;
+  u_int32_t suppressed;
+  u_int32_t deferred;
 };
 
 /* Prototypes. */
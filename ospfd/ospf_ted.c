@@ -0,0 +1,915 @@
+/*
+ * OSPF Traffic Engineering Database (TED)
+ * Built from the Traffic Engineering Opaque LSAs (RFC3630, RFC7471)
+ * received in the area LSDB.
+ *
+ * Copyright (C) 2016 Orange Labs
+ * http://www.orange.com
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "linklist.h"
+#include "prefix.h"
+#include "if.h"
+#include "table.h"
+#include "memory.h"
+#include "command.h"
+#include "vty.h"
+#include "stream.h"
+#include "log.h"
+#include "thread.h"
+#include "hash.h"
+#include "jhash.h"
+#include "vector.h"
+#include "network.h"
+#include "zclient.h"
+#include "ted.h"
+
+#include "ospfd/ospfd.h"
+#include "ospfd/ospf_asbr.h"
+#include "ospfd/ospf_lsa.h"
+#include "ospfd/ospf_lsdb.h"
+#include "ospfd/ospf_dump.h"
+#include "ospfd/ospf_opaque.h"
+#include "ospfd/ospf_te.h"
+#include "ospfd/ospf_ted.h"
+
+/* Global TE Database of this OSPF instance. */
+struct ospf_ted OspfTED;
+
+/*------------------------------------------------------------------------*
+ * Followings are export functions to the zebra TED.
+ *------------------------------------------------------------------------*/
+
+/* Node identifier in the zebra TED: Router ID << 32 | pseudo flag */
+static u_int64_t
+ted_export_id (struct in_addr id, u_char pseudo)
+{
+  return ((u_int64_t) ntohl (id.s_addr) << 32) | (pseudo ? TED_NODE_PSEUDO : 0);
+}
+
+static void
+ted_export (struct te_msg *msg)
+{
+  if (zclient == NULL)
+    return;
+
+  if (OspfTED.export == NULL)
+    OspfTED.export = ted_batch_new (zclient, master);
+  ted_batch_add (OspfTED.export, msg);
+}
+
+static void
+ted_export_node (struct ted_node *node, u_char event)
+{
+  struct te_msg msg;
+
+  memset (&msg, 0, sizeof (struct te_msg));
+  msg.event = event;
+  msg.type = TED_TYPE_NODE;
+  msg.u.node.proto = ZEBRA_ROUTE_OSPF;
+  msg.u.node.id = ted_export_id (node->router_id, node->pseudo);
+  msg.u.node.flags = node->pseudo ? TED_NODE_PSEUDO : 0;
+  msg.u.node.router_id = node->pseudo ? node->router_id : node->router_addr;
+
+  ted_export (&msg);
+}
+
+static void
+ted_export_link (struct ted_link *link, u_char event)
+{
+  struct te_msg msg;
+  struct te_attr *attr = &msg.u.link.attr;
+
+  memset (&msg, 0, sizeof (struct te_msg));
+  msg.event = event;
+  msg.type = TED_TYPE_LINK;
+  msg.u.link.proto = ZEBRA_ROUTE_OSPF;
+  msg.u.link.src = ted_export_id (link->adv_router, 0);
+  msg.u.link.dst = ted_export_id (link->link_id,
+                                  link->type == LINK_TYPE_SUBTLV_VALUE_MA);
+  msg.u.link.local_id = ntohl (link->lsa_id.s_addr);
+
+  /* TED_LINK_xxx flags have the same values as TED_ATTR_xxx ones */
+  attr->flags = link->flags;
+  attr->te_metric = link->te_metric;
+  attr->max_bw = link->max_bw;
+  attr->max_rsv_bw = link->max_rsv_bw;
+  memcpy (attr->unrsv_bw, link->unrsv_bw, sizeof (attr->unrsv_bw));
+  attr->admin_grp = link->admin_grp;
+  attr->local = link->local;
+  attr->remote = link->remote;
+  attr->av_delay = link->av_delay;
+  attr->min_delay = link->min_delay;
+  attr->max_delay = link->max_delay;
+  attr->delay_var = link->delay_var;
+  attr->pkt_loss = link->pkt_loss;
+  attr->res_bw = link->res_bw;
+  attr->ava_bw = link->ava_bw;
+  attr->use_bw = link->use_bw;
+  attr->rmt_as = link->rmt_as;
+  attr->rmt_ip = link->rmt_ip;
+
+  ted_export (&msg);
+}
+
+static void
+ted_export_node_all (struct hash_backet *backet, void *arg)
+{
+  ted_export_node ((struct ted_node *) backet->data, TED_EVENT_UPDATE);
+}
+
+static void
+ted_export_link_all (struct hash_backet *backet, void *arg)
+{
+  ted_export_link ((struct ted_link *) backet->data, TED_EVENT_UPDATE);
+}
+
+/* (Re)connection to zebra: export the whole TED. */
+void
+ospf_ted_zebra_sync (void)
+{
+  if (OspfTED.nodes == NULL)
+    return;
+
+  hash_iterate (OspfTED.nodes, ted_export_node_all, NULL);
+  hash_iterate (OspfTED.links, ted_export_link_all, NULL);
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are node and link management functions.
+ *------------------------------------------------------------------------*/
+
+static unsigned int
+ted_node_hash_key (void *data)
+{
+  struct ted_node *node = data;
+
+  return jhash_2words (node->router_id.s_addr, node->pseudo, 0);
+}
+
+static int
+ted_node_hash_cmp (const void *d1, const void *d2)
+{
+  const struct ted_node *n1 = d1, *n2 = d2;
+
+  return (n1->router_id.s_addr == n2->router_id.s_addr
+          && n1->pseudo == n2->pseudo);
+}
+
+static unsigned int
+ted_link_hash_key (void *data)
+{
+  struct ted_link *link = data;
+
+  return jhash_2words (link->adv_router.s_addr, link->lsa_id.s_addr, 0);
+}
+
+static int
+ted_link_hash_cmp (const void *d1, const void *d2)
+{
+  const struct ted_link *l1 = d1, *l2 = d2;
+
+  return (l1->adv_router.s_addr == l2->adv_router.s_addr
+          && l1->lsa_id.s_addr == l2->lsa_id.s_addr);
+}
+
+static struct ted_node *
+ted_node_lookup (struct in_addr id, u_char pseudo)
+{
+  struct ted_node key;
+
+  key.router_id = id;
+  key.pseudo = pseudo;
+  return hash_lookup (OspfTED.nodes, &key);
+}
+
+static struct ted_node *
+ted_node_get (struct in_addr id, u_char pseudo)
+{
+  struct ted_node *node;
+
+  if ((node = ted_node_lookup (id, pseudo)) != NULL)
+    return node;
+
+  node = XCALLOC (MTYPE_OSPF_TED, sizeof (struct ted_node));
+  node->router_id = id;
+  node->pseudo = pseudo;
+  node->links = list_new ();
+  node->index = vector_set (OspfTED.vertices, node);
+  hash_get (OspfTED.nodes, node, hash_alloc_intern);
+  ted_export_node (node, TED_EVENT_UPDATE);
+
+  if (IS_DEBUG_OSPF_TE)
+    zlog_debug ("OSPF TED: Add %s node %s [%d]",
+                pseudo ? "pseudo" : "router", inet_ntoa (id), node->index);
+
+  return node;
+}
+
+/* Remove node from the TED when no more link, nor its Router Address
+   LSA, refers to it. */
+static void
+ted_node_release (struct ted_node *node)
+{
+  if (listcount (node->links) != 0 || node->in_count != 0 || node->addr_lsa)
+    return;
+
+  if (IS_DEBUG_OSPF_TE)
+    zlog_debug ("OSPF TED: Remove %s node %s [%d]",
+                node->pseudo ? "pseudo" : "router",
+                inet_ntoa (node->router_id), node->index);
+
+  ted_export_node (node, TED_EVENT_DELETE);
+  hash_release (OspfTED.nodes, node);
+  vector_unset (OspfTED.vertices, node->index);
+  list_delete (node->links);
+  XFREE (MTYPE_OSPF_TED, node);
+}
+
+/* Connect link to its source and destination nodes. */
+static void
+ted_link_attach (struct ted_link *link)
+{
+  struct ted_node *src, *dst;
+
+  src = ted_node_get (link->adv_router, 0);
+  if (link->type == LINK_TYPE_SUBTLV_VALUE_MA)
+    dst = ted_node_get (link->link_id, 1);
+  else
+    dst = ted_node_get (link->link_id, 0);
+
+  link->src = src;
+  link->dst = dst;
+  listnode_add (src->links, link);
+  /* Pseudo node reaches back its attached routers through their links */
+  if (dst->pseudo)
+    listnode_add (dst->links, link);
+  dst->in_count++;
+}
+
+static void
+ted_link_detach (struct ted_link *link)
+{
+  struct ted_node *src = link->src;
+  struct ted_node *dst = link->dst;
+
+  listnode_delete (src->links, link);
+  if (dst->pseudo)
+    listnode_delete (dst->links, link);
+  dst->in_count--;
+  link->src = link->dst = NULL;
+
+  ted_node_release (src);
+  if (dst != src)
+    ted_node_release (dst);
+}
+
+/* Return the link delay in micro-seconds, 0 if not advertised. */
+u_int32_t
+ospf_ted_link_delay (struct ted_link *link)
+{
+  if (CHECK_FLAG (link->flags, TED_LINK_AV_DELAY))
+    return link->av_delay;
+  if (CHECK_FLAG (link->flags, TED_LINK_MM_DELAY))
+    return link->min_delay;
+  return 0;
+}
+
+struct ted_node *
+ospf_ted_node_lookup (struct in_addr id)
+{
+  struct ted_node *node;
+  unsigned int i;
+
+  if ((node = ted_node_lookup (id, 0)) != NULL)
+    return node;
+
+  /* Fall back to the TE Router Address */
+  for (i = 0; i < vector_active (OspfTED.vertices); i++)
+    if ((node = vector_slot (OspfTED.vertices, i)) != NULL)
+      if (!node->pseudo && node->router_addr.s_addr == id.s_addr)
+        return node;
+
+  return NULL;
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are TE LSA parsing functions.
+ *------------------------------------------------------------------------*/
+
+static int
+ted_is_te_lsa (struct ospf_lsa *lsa)
+{
+  if (lsa->data->type != OSPF_OPAQUE_AREA_LSA)
+    return 0;
+  if (GET_OPAQUE_TYPE (ntohl (lsa->data->id.s_addr))
+      != OPAQUE_TYPE_TRAFFIC_ENGINEERING_LSA)
+    return 0;
+  return 1;
+}
+
+static void
+ted_parse_link_subtlv (struct ted_link *link, struct te_tlv_header *tlvh)
+{
+  struct te_link_subtlv *sub = (struct te_link_subtlv *) tlvh;
+  u_int16_t len = ntohs (tlvh->length);
+  int i;
+
+  switch (ntohs (tlvh->type))
+    {
+    case TE_LINK_SUBTLV_LINK_TYPE:
+      if (len >= TE_LINK_SUBTLV_TYPE_SIZE)
+        link->type = ((struct te_link_subtlv_link_type *) tlvh)->link_type.value;
+      break;
+    case TE_LINK_SUBTLV_LINK_ID:
+      if (len < TE_LINK_SUBTLV_DEF_SIZE)
+        break;
+      link->link_id = sub->value.link_id;
+      break;
+    case TE_LINK_SUBTLV_LCLIF_IPADDR:
+      if (len < TE_LINK_SUBTLV_DEF_SIZE)
+        break;
+      link->local = sub->value.lclif;
+      SET_FLAG (link->flags, TED_LINK_LCLIF);
+      break;
+    case TE_LINK_SUBTLV_RMTIF_IPADDR:
+      if (len < TE_LINK_SUBTLV_DEF_SIZE)
+        break;
+      link->remote = sub->value.rmtif;
+      SET_FLAG (link->flags, TED_LINK_RMTIF);
+      break;
+    case TE_LINK_SUBTLV_TE_METRIC:
+      if (len < TE_LINK_SUBTLV_DEF_SIZE)
+        break;
+      link->te_metric = ntohl (sub->value.te_metric);
+      SET_FLAG (link->flags, TED_LINK_TE_METRIC);
+      break;
+    case TE_LINK_SUBTLV_MAX_BW:
+      if (len < TE_LINK_SUBTLV_DEF_SIZE)
+        break;
+      link->max_bw = ntohf (sub->value.max_bw);
+      SET_FLAG (link->flags, TED_LINK_MAX_BW);
+      break;
+    case TE_LINK_SUBTLV_MAX_RSV_BW:
+      if (len < TE_LINK_SUBTLV_DEF_SIZE)
+        break;
+      link->max_rsv_bw = ntohf (sub->value.max_rsv_bw);
+      SET_FLAG (link->flags, TED_LINK_MAX_RSV_BW);
+      break;
+    case TE_LINK_SUBTLV_UNRSV_BW:
+      if (len < TE_LINK_SUBTLV_UNRSV_SIZE)
+        break;
+      for (i = 0; i < MAX_CLASS_TYPE; i++)
+        link->unrsv_bw[i] = ntohf (sub->value.unrsv[i]);
+      SET_FLAG (link->flags, TED_LINK_UNRSV_BW);
+      break;
+    case TE_LINK_SUBTLV_RSC_CLSCLR:
+      if (len < TE_LINK_SUBTLV_DEF_SIZE)
+        break;
+      link->admin_grp = ntohl (sub->value.rsc_clsclr);
+      SET_FLAG (link->flags, TED_LINK_ADM_GRP);
+      break;
+    case TE_LINK_SUBTLV_RAS:
+      if (len < TE_LINK_SUBTLV_DEF_SIZE)
+        break;
+      link->rmt_as = ntohl (sub->value.ras);
+      SET_FLAG (link->flags, TED_LINK_RMT_AS);
+      break;
+    case TE_LINK_SUBTLV_RIP:
+      if (len < TE_LINK_SUBTLV_DEF_SIZE)
+        break;
+      link->rmt_ip = sub->value.rip;
+      SET_FLAG (link->flags, TED_LINK_RMT_IP);
+      break;
+    case TE_LINK_SUBTLV_AV_DELAY:
+      if (len < TE_LINK_SUBTLV_DEF_SIZE)
+        break;
+      link->av_delay = ntohl (sub->value.av_delay) & TE_EXT_MASK;
+      SET_FLAG (link->flags, TED_LINK_AV_DELAY);
+      break;
+    case TE_LINK_SUBTLV_MM_DELAY:
+      if (len < TE_LINK_SUBTLV_MM_DELAY_SIZE)
+        break;
+      link->min_delay = ntohl (((struct te_link_subtlv_mm_delay *) tlvh)->low)
+                        & TE_EXT_MASK;
+      link->max_delay = ntohl (((struct te_link_subtlv_mm_delay *) tlvh)->high)
+                        & TE_EXT_MASK;
+      SET_FLAG (link->flags, TED_LINK_MM_DELAY);
+      break;
+    case TE_LINK_SUBTLV_DELAY_VAR:
+      if (len < TE_LINK_SUBTLV_DEF_SIZE)
+        break;
+      link->delay_var = ntohl (sub->value.delay_var) & TE_EXT_MASK;
+      SET_FLAG (link->flags, TED_LINK_DELAY_VAR);
+      break;
+    case TE_LINK_SUBTLV_PKT_LOSS:
+      if (len < TE_LINK_SUBTLV_DEF_SIZE)
+        break;
+      link->pkt_loss = ntohl (sub->value.pkt_loss) & TE_EXT_MASK;
+      SET_FLAG (link->flags, TED_LINK_PKT_LOSS);
+      break;
+    case TE_LINK_SUBTLV_RES_BW:
+      if (len < TE_LINK_SUBTLV_DEF_SIZE)
+        break;
+      link->res_bw = ntohf (sub->value.res_bw);
+      SET_FLAG (link->flags, TED_LINK_RES_BW);
+      break;
+    case TE_LINK_SUBTLV_AVA_BW:
+      if (len < TE_LINK_SUBTLV_DEF_SIZE)
+        break;
+      link->ava_bw = ntohf (sub->value.ava_bw);
+      SET_FLAG (link->flags, TED_LINK_AVA_BW);
+      break;
+    case TE_LINK_SUBTLV_USE_BW:
+      if (len < TE_LINK_SUBTLV_DEF_SIZE)
+        break;
+      link->use_bw = ntohf (sub->value.use_bw);
+      SET_FLAG (link->flags, TED_LINK_USE_BW);
+      break;
+    default:
+      break;
+    }
+}
+
+/*
+ * Fill link (and router address) from the TE LSA body.
+ * Return 1 if a valid Link TLV has been found, 0 otherwise.
+ */
+static int
+ted_parse_lsa (struct ospf_lsa *lsa, struct ted_link *link,
+               struct in_addr *router_addr)
+{
+  struct lsa_header *lsah = lsa->data;
+  struct te_tlv_header *tlvh, *sub;
+  u_int16_t sum, total, len, subsum;
+  int found = 0;
+
+  total = ntohs (lsah->length) - OSPF_LSA_HEADER_SIZE;
+  router_addr->s_addr = INADDR_ANY;
+
+  for (sum = 0, tlvh = TLV_HDR_TOP (lsah);
+       sum + TLV_HDR_SIZE <= total;
+       sum += TLV_SIZE (tlvh), tlvh = TLV_HDR_NEXT (tlvh))
+    {
+      if (sum + TLV_SIZE (tlvh) > total)
+        break;
+
+      switch (ntohs (tlvh->type))
+        {
+        case TE_TLV_ROUTER_ADDR:
+          if (ntohs (tlvh->length) >= TE_LINK_SUBTLV_DEF_SIZE)
+            *router_addr = ((struct te_tlv_router_addr *) tlvh)->value;
+          break;
+        case TE_TLV_LINK:
+          len = ntohs (tlvh->length);
+          for (subsum = 0, sub = TLV_HDR_SUBTLV (tlvh);
+               subsum + TLV_HDR_SIZE <= len;
+               subsum += TLV_SIZE (sub), sub = TLV_HDR_NEXT (sub))
+            {
+              if (subsum + TLV_SIZE (sub) > len)
+                break;
+              ted_parse_link_subtlv (link, sub);
+            }
+          found = 1;
+          break;
+        default:
+          break;
+        }
+    }
+
+  /* Link Type and Link ID are mandatory (RFC3630 section 2.5) */
+  if (found && link->type != LINK_TYPE_SUBTLV_VALUE_PTP
+      && link->type != LINK_TYPE_SUBTLV_VALUE_MA)
+    found = 0;
+
+  return found;
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are TED update functions called on LSDB change.
+ *------------------------------------------------------------------------*/
+
+static void
+ted_link_free (struct ted_link *link)
+{
+  if (link->stale)
+    listnode_delete (OspfTED.stale_links, link);
+  ted_export_link (link, TED_EVENT_DELETE);
+  hash_release (OspfTED.links, link);
+  if (link->src != NULL)
+    ted_link_detach (link);
+  XFREE (MTYPE_OSPF_TED, link);
+}
+
+/* The LSA carries the Router Address TLV alone, as other implementations
+   advertise it: keep it on the node of the advertising router. */
+static void
+ted_router_addr_set (struct ospf_lsa *lsa, struct in_addr router_addr)
+{
+  struct ted_node *node;
+
+  node = ted_node_get (lsa->data->adv_router, 0);
+  node->addr_lsa = 1;
+  node->addr_lsa_id = lsa->data->id;
+  if (node->addr_stale)
+    {
+      node->addr_stale = 0;
+      listnode_delete (OspfTED.stale_nodes, node);
+    }
+  if (node->router_addr.s_addr == router_addr.s_addr)
+    return;
+
+  if (IS_DEBUG_OSPF_TE)
+    zlog_debug ("OSPF TED: Router %s has TE Router Address %s",
+                inet_ntoa (node->router_id), inet_ntoa (router_addr));
+
+  node->router_addr = router_addr;
+  ted_export_node (node, TED_EVENT_UPDATE);
+  OspfTED.version++;
+}
+
+static void
+ted_router_addr_clear (struct ted_node *node)
+{
+  if (node->addr_stale)
+    {
+      node->addr_stale = 0;
+      listnode_delete (OspfTED.stale_nodes, node);
+    }
+  node->addr_lsa = 0;
+  node->router_addr.s_addr = INADDR_ANY;
+  ted_export_node (node, TED_EVENT_UPDATE);
+  OspfTED.version++;
+  ted_node_release (node);
+}
+
+static void
+ted_router_addr_unset (struct ospf_lsa *lsa)
+{
+  struct ted_node *node;
+
+  node = ted_node_lookup (lsa->data->adv_router, 0);
+  if (node == NULL || !node->addr_lsa
+      || node->addr_lsa_id.s_addr != lsa->data->id.s_addr)
+    return;
+
+  ted_router_addr_clear (node);
+}
+
+static void
+ted_link_remove (struct ted_link *link)
+{
+  if (IS_DEBUG_OSPF_TE)
+    zlog_debug ("OSPF TED: Remove link %s from router %s",
+                inet_ntoa (link->lsa_id), inet_ntoa (link->adv_router));
+
+  ted_link_free (link);
+  OspfTED.lsa_delete++;
+  OspfTED.version++;
+}
+
+static int
+ted_link_lsa_delete (struct ospf_lsa *lsa)
+{
+  struct ted_link key, *link;
+
+  key.adv_router = lsa->data->adv_router;
+  key.lsa_id = lsa->data->id;
+  if ((link = hash_lookup (OspfTED.links, &key)) != NULL)
+    ted_link_remove (link);
+
+  return 0;
+}
+
+static int
+ted_lsa_remove (struct ospf_lsa *lsa)
+{
+  ted_router_addr_unset (lsa);
+  return ted_link_lsa_delete (lsa);
+}
+
+/* Remove what the deleted LSAs left stale. */
+static int
+ted_stale_flush (struct thread *thread)
+{
+  struct ted_link *link;
+  struct ted_node *node;
+
+  OspfTED.t_stale = NULL;
+
+  while ((link = listnode_head (OspfTED.stale_links)) != NULL)
+    ted_link_remove (link);
+
+  while ((node = listnode_head (OspfTED.stale_nodes)) != NULL)
+    ted_router_addr_clear (node);
+
+  return 0;
+}
+
+/*
+ * Del LSA hook.  ospf_lsdb_add() deletes the instance an LSA replaces
+ * before installing the new one, so the link and Router Address of the
+ * deleted LSA are only marked stale here: the update of a new instance
+ * finds them in place, and what is left is removed once back in the
+ * event loop.
+ */
+int
+ospf_ted_lsa_delete (struct ospf_lsa *lsa)
+{
+  struct ted_link key, *link;
+  struct ted_node *node;
+
+  if (!ted_is_te_lsa (lsa))
+    return 0;
+
+  node = ted_node_lookup (lsa->data->adv_router, 0);
+  if (node != NULL && node->addr_lsa && !node->addr_stale
+      && node->addr_lsa_id.s_addr == lsa->data->id.s_addr)
+    {
+      node->addr_stale = 1;
+      listnode_add (OspfTED.stale_nodes, node);
+    }
+
+  key.adv_router = lsa->data->adv_router;
+  key.lsa_id = lsa->data->id;
+  link = hash_lookup (OspfTED.links, &key);
+  if (link != NULL && !link->stale)
+    {
+      link->stale = 1;
+      listnode_add (OspfTED.stale_links, link);
+    }
+
+  if (OspfTED.t_stale == NULL)
+    OspfTED.t_stale = thread_add_event (master, ted_stale_flush, NULL, 0);
+  return 0;
+}
+
+int
+ospf_ted_lsa_update (struct ospf_lsa *lsa)
+{
+  struct ted_link new, *link;
+  struct in_addr router_addr;
+
+  if (!ted_is_te_lsa (lsa))
+    return 0;
+
+  /* A MaxAge LSA is a flush: withdraw corresponding link from the TED */
+  if (IS_LSA_MAXAGE (lsa))
+    return ted_lsa_remove (lsa);
+
+  memset (&new, 0, sizeof (struct ted_link));
+  new.adv_router = lsa->data->adv_router;
+  new.lsa_id = lsa->data->id;
+  if (lsa->area)
+    new.area_id = lsa->area->area_id;
+
+  if (!ted_parse_lsa (lsa, &new, &router_addr))
+    {
+      /* No link usable any more in this LSA, maybe a Router Address */
+      ted_link_lsa_delete (lsa);
+      if (router_addr.s_addr != INADDR_ANY)
+        ted_router_addr_set (lsa, router_addr);
+      else
+        ted_router_addr_unset (lsa);
+      return 0;
+    }
+
+  if (!CHECK_FLAG (new.flags, TED_LINK_TE_METRIC))
+    new.te_metric = TED_DEFAULT_TE_METRIC;
+
+  link = hash_lookup (OspfTED.links, &new);
+  if (link != NULL && link->stale)
+    {
+      /* New instance of the LSA just deleted */
+      link->stale = 0;
+      listnode_delete (OspfTED.stale_links, link);
+    }
+
+  if (link == NULL)
+    {
+      link = XCALLOC (MTYPE_OSPF_TED, sizeof (struct ted_link));
+      memcpy (link, &new, sizeof (struct ted_link));
+      hash_get (OspfTED.links, link, hash_alloc_intern);
+      ted_link_attach (link);
+    }
+  else if (link->type != new.type
+           || link->link_id.s_addr != new.link_id.s_addr)
+    {
+      /* Topology has changed: move the link to its new destination */
+      ted_export_link (link, TED_EVENT_DELETE);
+      ted_link_detach (link);
+      memcpy (link, &new, sizeof (struct ted_link));
+      ted_link_attach (link);
+    }
+  else
+    {
+      /* Only link attributes have changed: update them in place */
+      new.src = link->src;
+      new.dst = link->dst;
+      memcpy (link, &new, sizeof (struct ted_link));
+    }
+
+  if (router_addr.s_addr != INADDR_ANY
+      && link->src->router_addr.s_addr != router_addr.s_addr)
+    {
+      link->src->router_addr = router_addr;
+      ted_export_node (link->src, TED_EVENT_UPDATE);
+    }
+  ted_export_link (link, TED_EVENT_UPDATE);
+
+  if (IS_DEBUG_OSPF_TE)
+    zlog_debug ("OSPF TED: Update link %s from router %s to %s %s",
+                inet_ntoa (link->lsa_id), inet_ntoa (link->adv_router),
+                link->dst->pseudo ? "network" : "router",
+                inet_ntoa (link->link_id));
+
+  OspfTED.lsa_update++;
+  OspfTED.version++;
+
+  return 0;
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are vty session control functions.
+ *------------------------------------------------------------------------*/
+
+static void
+show_ted_link (struct vty *vty, struct ted_link *link)
+{
+  vty_out (vty, "    -> %s %-15s",
+           link->dst->pseudo ? "Network" : "Router ",
+           inet_ntoa (link->link_id));
+  vty_out (vty, " Local %-15s", inet_ntoa (link->local));
+  vty_out (vty, " Metric %u%s", link->te_metric, VTY_NEWLINE);
+
+  if (CHECK_FLAG (link->flags, TED_LINK_MAX_BW))
+    vty_out (vty, "       Max BW %g", link->max_bw);
+  if (CHECK_FLAG (link->flags, TED_LINK_MAX_RSV_BW))
+    vty_out (vty, " Max Rsv BW %g", link->max_rsv_bw);
+  if (CHECK_FLAG (link->flags, TED_LINK_UNRSV_BW))
+    vty_out (vty, " Unrsv BW[0] %g", link->unrsv_bw[0]);
+  if (CHECK_FLAG (link->flags, TED_LINK_MAX_BW | TED_LINK_MAX_RSV_BW
+                  | TED_LINK_UNRSV_BW))
+    vty_out (vty, " (Bytes/sec)%s", VTY_NEWLINE);
+
+  if (CHECK_FLAG (link->flags, TED_LINK_ADM_GRP))
+    vty_out (vty, "       Admin Group 0x%x%s", link->admin_grp, VTY_NEWLINE);
+  if (CHECK_FLAG (link->flags, TED_LINK_AV_DELAY | TED_LINK_MM_DELAY))
+    vty_out (vty, "       Delay %u (micro-sec)%s",
+             ospf_ted_link_delay (link), VTY_NEWLINE);
+  if (CHECK_FLAG (link->flags, TED_LINK_PKT_LOSS))
+    vty_out (vty, "       Loss %g (%%)%s",
+             (float) (link->pkt_loss * LOSS_PRECISION), VTY_NEWLINE);
+}
+
+static void
+show_ted_node (struct vty *vty, struct ted_node *node)
+{
+  struct listnode *lnode;
+  struct ted_link *link;
+
+  if (node->pseudo)
+    {
+      vty_out (vty, "  Network %s: %d attached router(s)%s",
+               inet_ntoa (node->router_id), listcount (node->links),
+               VTY_NEWLINE);
+      return;
+    }
+
+  vty_out (vty, "  Router %s", inet_ntoa (node->router_id));
+  if (node->router_addr.s_addr != INADDR_ANY)
+    vty_out (vty, " (TE Router Address %s)", inet_ntoa (node->router_addr));
+  vty_out (vty, ": %d link(s)%s", listcount (node->links), VTY_NEWLINE);
+
+  for (ALL_LIST_ELEMENTS_RO (node->links, lnode, link))
+    show_ted_link (vty, link);
+}
+
+DEFUN (show_ip_ospf_mpls_te_database,
+       show_ip_ospf_mpls_te_database_cmd,
+       "show ip ospf mpls-te database",
+       SHOW_STR
+       IP_STR
+       OSPF_STR
+       "MPLS-TE information\n"
+       "Traffic Engineering Database\n")
+{
+  struct ted_node *node;
+  unsigned int i;
+
+  vty_out (vty, "--- MPLS-TE Database ---%s", VTY_NEWLINE);
+  vty_out (vty, "  %lu node(s), %lu link(s), version %u%s",
+           OspfTED.nodes->count, OspfTED.links->count, OspfTED.version,
+           VTY_NEWLINE);
+  vty_out (vty, "  %u LSA update(s), %u LSA delete(s)%s%s",
+           OspfTED.lsa_update, OspfTED.lsa_delete, VTY_NEWLINE, VTY_NEWLINE);
+
+  for (i = 0; i < vector_active (OspfTED.vertices); i++)
+    if ((node = vector_slot (OspfTED.vertices, i)) != NULL)
+      show_ted_node (vty, node);
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (show_ip_ospf_mpls_te_database_router,
+       show_ip_ospf_mpls_te_database_router_cmd,
+       "show ip ospf mpls-te database router A.B.C.D",
+       SHOW_STR
+       IP_STR
+       OSPF_STR
+       "MPLS-TE information\n"
+       "Traffic Engineering Database\n"
+       "Router node\n"
+       "Router ID or TE Router Address\n")
+{
+  struct in_addr id;
+  struct ted_node *node;
+
+  if (!inet_aton (argv[0], &id))
+    {
+      vty_out (vty, "Please specify Router ID by A.B.C.D%s", VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+
+  if ((node = ospf_ted_node_lookup (id)) == NULL)
+    {
+      vty_out (vty, "No such router in MPLS-TE Database%s", VTY_NEWLINE);
+      return CMD_SUCCESS;
+    }
+
+  show_ted_node (vty, node);
+  return CMD_SUCCESS;
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are initialize/terminate functions.
+ *------------------------------------------------------------------------*/
+
+void
+ospf_ted_init (void)
+{
+  memset (&OspfTED, 0, sizeof (struct ospf_ted));
+  OspfTED.nodes = hash_create (ted_node_hash_key, ted_node_hash_cmp);
+  OspfTED.links = hash_create (ted_link_hash_key, ted_link_hash_cmp);
+  OspfTED.vertices = vector_init (VECTOR_MIN_SIZE);
+  OspfTED.stale_links = list_new ();
+  OspfTED.stale_nodes = list_new ();
+
+  install_element (VIEW_NODE, &show_ip_ospf_mpls_te_database_cmd);
+  install_element (VIEW_NODE, &show_ip_ospf_mpls_te_database_router_cmd);
+  install_element (ENABLE_NODE, &show_ip_ospf_mpls_te_database_cmd);
+  install_element (ENABLE_NODE, &show_ip_ospf_mpls_te_database_router_cmd);
+}
+
+static void
+ted_link_clean (void *data)
+{
+  struct ted_link *link = data;
+
+  link->src = link->dst = NULL;
+  XFREE (MTYPE_OSPF_TED, link);
+}
+
+static void
+ted_node_clean (void *data)
+{
+  struct ted_node *node = data;
+
+  list_delete (node->links);
+  XFREE (MTYPE_OSPF_TED, node);
+}
+
+void
+ospf_ted_term (void)
+{
+  THREAD_OFF (OspfTED.t_stale);
+  list_delete (OspfTED.stale_links);
+  list_delete (OspfTED.stale_nodes);
+  hash_clean (OspfTED.links, ted_link_clean);
+  hash_free (OspfTED.links);
+  hash_clean (OspfTED.nodes, ted_node_clean);
+  hash_free (OspfTED.nodes);
+  vector_free (OspfTED.vertices);
+  if (OspfTED.export)
+    ted_batch_free (OspfTED.export);
+  memset (&OspfTED, 0, sizeof (struct ospf_ted));
+}
@@ -0,0 +1,172 @@
+/*
+ * OSPF Traffic Engineering Database (TED)
+ * Built from the Traffic Engineering Opaque LSAs (RFC3630, RFC7471)
+ * received in the area LSDB.
+ *
+ * Copyright (C) 2016 Orange Labs
+ * http://www.orange.com
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _ZEBRA_OSPF_TED_H
+#define _ZEBRA_OSPF_TED_H
+
+/*
+ * The TED is a directed graph. Each Traffic Engineering LSA carries
+ * exactly one Link TLV, so each TE LSA is mapped to one ted_link whose
+ * source is the advertising router. For Point-to-Point links, the
+ * destination is the neighbour Router ID given by the Link ID sub-TLV.
+ * For Multi-Access links, the Link ID is the DR interface address and
+ * the destination is a pseudo node standing for the transit network;
+ * the pseudo node reaches all its attached routers at zero cost.
+ *
+ * All values are stored in host byte order.
+ */
+
+/* Flags to indicate which link attributes have been advertised */
+#define TED_LINK_TE_METRIC	0x00000001
+#define TED_LINK_MAX_BW		0x00000002
+#define TED_LINK_MAX_RSV_BW	0x00000004
+#define TED_LINK_UNRSV_BW	0x00000008
+#define TED_LINK_ADM_GRP	0x00000010
+#define TED_LINK_LCLIF		0x00000020
+#define TED_LINK_RMTIF		0x00000040
+#define TED_LINK_AV_DELAY	0x00000080
+#define TED_LINK_MM_DELAY	0x00000100
+#define TED_LINK_DELAY_VAR	0x00000200
+#define TED_LINK_PKT_LOSS	0x00000400
+#define TED_LINK_RES_BW		0x00000800
+#define TED_LINK_AVA_BW		0x00001000
+#define TED_LINK_USE_BW		0x00002000
+#define TED_LINK_RMT_AS		0x00004000
+#define TED_LINK_RMT_IP		0x00008000
+
+/* Default TE metric when the TE Metric sub-TLV is not advertised */
+#define TED_DEFAULT_TE_METRIC	1
+
+struct ted_node
+{
+  /* Router ID for routers, DR interface address for pseudo nodes */
+  struct in_addr router_id;
+  u_char pseudo;
+
+  /* TE Router Address TLV (0.0.0.0 if not yet known) */
+  struct in_addr router_addr;
+
+  /* ID of the TE LSA carrying the Router Address TLV without a Link
+     TLV, if addr_lsa is set */
+  struct in_addr addr_lsa_id;
+  u_char addr_lsa;
+
+  /* The Router Address LSA was deleted, see ospf_ted_lsa_delete() */
+  u_char addr_stale;
+
+  /*
+   * Outgoing links for routers. For a pseudo node, this list holds
+   * the links of the attached routers pointing to it.
+   */
+  struct list *links;
+
+  /* Number of links pointing to this node from other routers */
+  u_int32_t in_count;
+
+  /* Slot in the TED node vector, used to index the CSPF work arrays */
+  int index;
+};
+
+struct ted_link
+{
+  /* Key: advertising router and LSA ID of the TE LSA */
+  struct in_addr adv_router;
+  struct in_addr lsa_id;
+
+  struct in_addr area_id;
+
+  /* The LSA was deleted, see ospf_ted_lsa_delete() */
+  u_char stale;
+
+  struct ted_node *src;
+  struct ted_node *dst;
+
+  /* Link Type (LINK_TYPE_SUBTLV_VALUE_PTP or _MA) and Link ID */
+  u_char type;
+  struct in_addr link_id;
+
+  /* Bit mask of TED_LINK_XXX flags */
+  u_int32_t flags;
+
+  struct in_addr local;
+  struct in_addr remote;
+  u_int32_t te_metric;
+  float max_bw;
+  float max_rsv_bw;
+  float unrsv_bw[MAX_CLASS_TYPE];
+  u_int32_t admin_grp;
+  u_int32_t av_delay;
+  u_int32_t min_delay;
+  u_int32_t max_delay;
+  u_int32_t delay_var;
+  u_int32_t pkt_loss;
+  float res_bw;
+  float ava_bw;
+  float use_bw;
+  u_int32_t rmt_as;
+  struct in_addr rmt_ip;
+};
+
+struct ospf_ted
+{
+  /* Nodes hashed by (router_id, pseudo) */
+  struct hash *nodes;
+
+  /* Links hashed by (adv_router, lsa_id) */
+  struct hash *links;
+
+  /* Nodes indexed by ted_node->index */
+  vector vertices;
+
+  /* Bumped on each TED modification */
+  u_int32_t version;
+
+  /* Changes exported to zebra */
+  struct ted_batch *export;
+
+  /* Links and Router Address nodes of the deleted LSAs, removed unless
+     the LSAs are installed again before t_stale runs */
+  struct list *stale_links;
+  struct list *stale_nodes;
+  struct thread *t_stale;
+
+  /* Statistics */
+  u_int32_t lsa_update;
+  u_int32_t lsa_delete;
+};
+
+extern struct ospf_ted OspfTED;
+
+/* Prototypes. */
+extern void ospf_ted_init (void);
+extern void ospf_ted_term (void);
+extern int ospf_ted_lsa_update (struct ospf_lsa *);
+extern int ospf_ted_lsa_delete (struct ospf_lsa *);
+extern struct ted_node *ospf_ted_node_lookup (struct in_addr);
+extern u_int32_t ospf_ted_link_delay (struct ted_link *);
+extern void ospf_ted_zebra_sync (void);
+
+#endif /* _ZEBRA_OSPF_TED_H */
@@ -49,6 +49,7 @@
 #include "ospfd/ospf_snmp.h"
 #endif /* HAVE_SNMP */
 #include "ospfd/ospf_te.h"
+#include "ospfd/ospf_ted.h"
 
 /* Zebra structure to hold current status. */
 struct zclient *zclient = NULL;
@@ -1322,6 +1323,7 @@ static void
 ospf_zebra_connected (struct zclient *zclient)
 {
   zclient_send_requests (zclient, VRF_DEFAULT);
+  ospf_ted_zebra_sync ();
 }
 
 void
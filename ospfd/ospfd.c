@@ -52,6 +52,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "ospfd/ospf_flood.h"
 #include "ospfd/ospf_route.h"
 #include "ospfd/ospf_ase.h"
+#include "ospfd/ospf_gr.h"
 
 
 
@@ -246,6 +247,8 @@ ospf_new (void)
   new->t_read = thread_add_read (master, ospf_read, new, new->fd);
   new->oi_write_q = list_new ();
   
+  ospf_gr_restart_init (new);
+
   return new;
 }
 
@@ -351,8 +354,10 @@ ospf_deferred_shutdown_check (struct ospf *ospf)
   if (ospf->t_deferred_shutdown)
     return;
   
-  /* Should we try push out max-metric LSAs? */
-  if (ospf->stub_router_shutdown_time != OSPF_STUB_ROUTER_UNCONFIGURED)
+  /* Should we try push out max-metric LSAs? Not when the neighbors
+     are to help us restart. */
+  if (ospf->stub_router_shutdown_time != OSPF_STUB_ROUTER_UNCONFIGURED
+      && !ospf->gr_prepared)
     {
       for (ALL_LIST_ELEMENTS_RO (ospf->areas, ln, area))
         {
@@ -425,7 +430,10 @@ ospf_finish_final (struct ospf *ospf)
   struct ospf_area *area;
   struct ospf_vl_data *vl_data;
   struct listnode *node, *nnode;
-  int i;
+  int i, gr;
+
+  /* Restarting gracefully: leave our LSAs and routes in place */
+  gr = ospf->gr_prepared && CHECK_FLAG (om->options, OSPF_MASTER_SHUTDOWN);
 
   ospf_opaque_type11_lsa_term (ospf);
   
@@ -433,9 +441,12 @@ ospf_finish_final (struct ospf *ospf)
   /*ospf_flush_self_originated_lsas_now (ospf);*/
   
   /* Unregister redistribution */
-  for (i = 0; i < ZEBRA_ROUTE_MAX; i++)
-    ospf_redistribute_unset (ospf, i);
-  ospf_redistribute_default_unset (ospf);
+  if (!gr)
+    {
+      for (i = 0; i < ZEBRA_ROUTE_MAX; i++)
+        ospf_redistribute_unset (ospf, i);
+      ospf_redistribute_default_unset (ospf);
+    }
 
   for (ALL_LIST_ELEMENTS (ospf->areas, node, nnode, area))
     ospf_remove_vls_through_area (ospf, area);
@@ -504,6 +515,7 @@ ospf_finish_final (struct ospf *ospf)
   OSPF_TIMER_OFF (ospf->t_read);
   OSPF_TIMER_OFF (ospf->t_write);
   OSPF_TIMER_OFF (ospf->t_opaque_lsa_self);
+  OSPF_TIMER_OFF (ospf->t_gr_grace);
 
   close (ospf->fd);
   stream_free(ospf->ibuf);
@@ -533,7 +545,8 @@ ospf_finish_final (struct ospf *ospf)
     ospf_route_table_free (ospf->old_table);
   if (ospf->new_table)
     {
-      ospf_route_delete (ospf->new_table);
+      if (!gr)
+        ospf_route_delete (ospf->new_table);
       ospf_route_table_free (ospf->new_table);
     }
   if (ospf->old_rtrs)
@@ -542,12 +555,14 @@ ospf_finish_final (struct ospf *ospf)
     ospf_rtrs_free (ospf->new_rtrs);
   if (ospf->new_external_route)
     {
-      ospf_route_delete (ospf->new_external_route);
+      if (!gr)
+        ospf_route_delete (ospf->new_external_route);
       ospf_route_table_free (ospf->new_external_route);
     }
   if (ospf->old_external_route)
     {
-      ospf_route_delete (ospf->old_external_route);
+      if (!gr)
+        ospf_route_delete (ospf->old_external_route);
       ospf_route_table_free (ospf->old_external_route);
     }
   if (ospf->external_lsas)
@@ -146,6 +146,16 @@ struct ospf
 
 #define OSPF_STUB_MAX_METRIC_SUMMARY_COST	0x00ff0000
 
+  /* RFC3623 graceful restart. */
+  u_int32_t gr_grace_period;		/* seconds, 0 if disabled */
+  u_char gr_helper_disable;		/* Don't help neighbors restart */
+  u_char gr_prepared;			/* Grace-LSAs sent, FIB preserved */
+  u_char gr_restarting;			/* Restarting within grace period */
+  u_char gr_sweep;			/* Stale routes to remove from zebra */
+  u_int32_t gr_seqnum;			/* Grace-LSA sequence number */
+  int gr_helpers;			/* Neighbors we are helping */
+  struct thread *t_gr_grace;		/* Grace period of our restart */
+
   /* LSA timers */
   unsigned int min_ls_interval; /* minimum delay between LSAs (in msec) */
   unsigned int min_ls_arrival; /* minimum interarrival time between LSAs (in msec) */
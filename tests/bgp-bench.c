@@ -0,0 +1,240 @@
+/*
+ * Common parts of the BGP tests and benchmarks.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+#include <sys/resource.h>
+
+#include "command.h"
+#include "vty.h"
+#include "privs.h"
+#include "linklist.h"
+#include "memory.h"
+#include "thread.h"
+#include "workqueue.h"
+#include "zclient.h"
+#include "filter.h"
+#include "sockunion.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_nexthop.h"
+#include "bgpd/bgp_pathlist.h"
+#include "bgpd/bgp_fsm.h"
+#include "bgp-bench.h"
+
+/* need these to link in libbgp */
+struct thread_master *master = NULL;
+struct zclient *zclient;
+struct zebra_privs_t bgpd_privs =
+{
+  .user = NULL,
+  .group = NULL,
+  .vty_group = NULL,
+};
+
+/* Lookup of nexthops through zebra, left unconnected, as is zebra */
+extern struct zclient *zlookup;
+
+static const char *bench_progname;
+static const struct bench_option *bench_opts;
+
+void
+bench_usage (void)
+{
+  const struct bench_option *o;
+
+  fprintf (stderr, "usage: %s", bench_progname);
+  for (o = bench_opts; o && o->letter; o++)
+    fprintf (stderr, " [-%c %s]", o->letter, o->name);
+  fprintf (stderr, "\n");
+  exit (1);
+}
+
+/* Parse the options of the table, ended by a null letter, or exit with
+ * the usage */
+void
+bench_options (int argc, char **argv, const struct bench_option *options)
+{
+  const struct bench_option *o;
+  char optstring[64];
+  size_t len = 0;
+  int opt;
+
+  bench_progname = argv[0];
+  bench_opts = options;
+  for (o = options; o->letter && len + 3 <= sizeof (optstring); o++)
+    {
+      optstring[len++] = o->letter;
+      optstring[len++] = ':';
+    }
+  optstring[len] = '\0';
+
+  while ((opt = getopt (argc, argv, optstring)) != -1)
+    {
+      for (o = options; o->letter; o++)
+        if (o->letter == opt)
+          break;
+      if (! o->letter)
+        bench_usage ();
+      *o->value = strtoul (optarg, NULL, 10);
+    }
+}
+
+/* bgpd without connections to peers or to zebra */
+void
+bench_init (void)
+{
+  cmd_init (1);
+  bgp_master_init ();
+  master = bm->master;
+  bgp_option_set (BGP_OPT_NO_LISTEN);
+  bgp_attr_init ();
+  bgp_address_init ();
+  bgp_pathlist_init ();
+  zlookup = zclient_new (bm->master);
+  zlookup->sock = -1;
+  zclient = zclient_new (bm->master);
+}
+
+/* Peer in state Established, without a connection */
+struct peer *
+bench_peer_new (struct bgp *bgp, const char *addr, as_t as)
+{
+  union sockunion su;
+  struct peer *peer;
+
+  str2sockunion (addr, &su);
+  peer_remote_as (bgp, &su, &as, AFI_IP, SAFI_UNICAST);
+  peer = peer_lookup (bgp, &su);
+  BGP_TIMER_OFF (peer->t_start);
+  BGP_EVENT_FLUSH (peer);
+  peer->status = Established;
+  peer->afc_nego[AFI_IP][SAFI_UNICAST] = 1;
+  /* No connected routes to check the nexthop against */
+  SET_FLAG (peer->af_flags[AFI_IP][SAFI_UNICAST], PEER_FLAG_NEXTHOP_SELF);
+  return peer;
+}
+
+/* Work left for the RIB: nodes to process, input to take in, a table to
+ * announce, or a peer being cleared */
+static int
+bench_busy (struct bgp *bgp)
+{
+  struct listnode *node;
+  struct peer *peer;
+
+  if ((bm->process_main_queue
+       && work_queue_is_scheduled (bm->process_main_queue))
+      || (bm->process_rsclient_queue
+          && work_queue_is_scheduled (bm->process_rsclient_queue))
+      || ! list_isempty (bm->input_peers) || bm->t_input)
+    return 1;
+  if (! bgp)
+    return 0;
+  if (bgp->announce[AFI_IP][SAFI_UNICAST])
+    return 1;
+  for (ALL_LIST_ELEMENTS_RO (bgp->peer, node, peer))
+    if (peer->status == Clearing
+        || (peer->clear_node_queue
+            && work_queue_is_scheduled (peer->clear_node_queue)))
+      return 1;
+  return 0;
+}
+
+/* Run the threads until the RIB is settled and busy, if given, returns
+ * 0.  busy is called before each slice, and may start more work.
+ * Returns the longest slice. */
+unsigned long
+bench_run (struct bgp *bgp, int (*busy) (void *), void *arg)
+{
+  struct thread thread;
+  struct timeval start;
+  unsigned long usec, slice = 0;
+
+  while ((busy && busy (arg)) || bench_busy (bgp))
+    {
+      if (! thread_fetch (bm->master, &thread))
+        break;
+      quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+      thread_call (&thread);
+      usec = bench_usec_since (&start);
+      if (usec > slice)
+        slice = usec;
+    }
+  return slice;
+}
+
+unsigned long
+bench_usec_since (struct timeval *start)
+{
+  struct timeval now;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) * 1000000
+         + now.tv_usec - start->tv_usec;
+}
+
+/* Objects allocated through the memory types */
+long
+bench_allocations (void)
+{
+  struct mlist *ml;
+  struct memory_list *m;
+  long count = 0;
+
+  for (ml = mlists; ml->list; ml++)
+    for (m = ml->list; m->index >= 0; m++)
+      if (m->index)
+        count += mtype_stats_alloc (m->index);
+  return count;
+}
+
+long
+bench_peak_kbytes (void)
+{
+  struct rusage ru;
+
+  getrusage (RUSAGE_SELF, &ru);
+  return ru.ru_maxrss;
+}
+
+/* Time a phase took, followed by what format adds */
+void
+bench_report (const char *phase, unsigned long usec, const char *format, ...)
+{
+  va_list args;
+
+  printf ("%-36s %8lu.%03lu ms", phase, usec / 1000, usec % 1000);
+  va_start (args, format);
+  vprintf (format, args);
+  va_end (args);
+  printf ("\n");
+}
+
+/* Result line of the test, and its exit status */
+int
+bench_done (int errors)
+{
+  printf ("errors: %d\n%s\n", errors, errors ? "failed" : "OK");
+  return errors != 0;
+}
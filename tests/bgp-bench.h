@@ -0,0 +1,50 @@
+/*
+ * Common parts of the BGP tests and benchmarks: a bgpd without
+ * connections, peers in state Established, running the RIB until it is
+ * settled, options and reports.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+#ifndef _BGP_BENCH_H
+#define _BGP_BENCH_H
+
+/* Numeric command line option, e.g. { 'n', "prefixes", &prefixes } */
+struct bench_option
+{
+  int letter;
+  const char *name;
+  unsigned int *value;
+};
+
+extern void bench_options (int argc, char **argv,
+                           const struct bench_option *options);
+extern void bench_usage (void);
+
+extern void bench_init (void);
+extern struct peer *bench_peer_new (struct bgp *, const char *addr, as_t);
+extern unsigned long bench_run (struct bgp *, int (*busy) (void *),
+                                void *arg);
+
+extern unsigned long bench_usec_since (struct timeval *start);
+extern long bench_allocations (void);
+extern long bench_peak_kbytes (void);
+extern void bench_report (const char *phase, unsigned long usec,
+                          const char *format, ...) PRINTF_ATTRIBUTE(3, 4);
+extern int bench_done (int errors);
+
+#endif /* _BGP_BENCH_H */
@@ -107,6 +107,8 @@ bgp_create_fake (as_t *as, const char *name)
   bgp->rsclient = list_new ();
   //bgp->rsclient->cmp = (int (*)(void*, void*)) peer_cmp;
 
+  bgp->rsview = list_new ();
+
   for (afi = AFI_IP; afi < AFI_MAX; afi++)
     for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
       {
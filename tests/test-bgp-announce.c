@@ -0,0 +1,276 @@
+/*
+ * BGP table announcement benchmark: load the RIB with routes from a few
+ * peers, bring up simulated peers and time the announcement of the
+ * table to them, one peer after the other, all at once, and joining
+ * one by one while the table is being walked.  Reports the time, the
+ * allocations and the longest slice of each phase, and fails when a
+ * peer is not sent the whole table, or a peer deactivated during the
+ * walk is still sent the table once stopped.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "vty.h"
+#include "stream.h"
+#include "linklist.h"
+#include "memory.h"
+#include "thread.h"
+#include "filter.h"
+#include "prng.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_aspath.h"
+#include "bgpd/bgp_advertise.h"
+#include "bgpd/bgp_fsm.h"
+#include "bgp-bench.h"
+
+#define LOCAL_AS	65000
+#define SOURCES		4
+
+static struct prng *prng;
+
+static struct peer **
+bench_peers_new (struct bgp *bgp, unsigned int count, unsigned int net)
+{
+  struct peer **peers;
+  char addr[INET_ADDRSTRLEN];
+  unsigned int i;
+
+  peers = calloc (count, sizeof (struct peer *));
+  for (i = 0; i < count; i++)
+    {
+      snprintf (addr, sizeof (addr), "10.%u.%u.%u", net, (i >> 8) & 0xff,
+                (i & 0xff) + 1);
+      peers[i] = bench_peer_new (bgp, addr, LOCAL_AS + 100 * net + i);
+    }
+  return peers;
+}
+
+/* Selected routes of the source peers, 10.0.0.0/24, 10.0.1.0/24... */
+static void
+bench_table_fill (struct bgp *bgp, struct peer **sources, unsigned int prefixes)
+{
+  struct aspath *aspath;
+  struct bgp_node *rn;
+  struct bgp_info *ri;
+  struct attr attr;
+  struct prefix p;
+  char str[64];
+  unsigned int i;
+
+  memset (&p, 0, sizeof (p));
+  p.family = AF_INET;
+  p.prefixlen = 24;
+  for (i = 0; i < prefixes; i++)
+    {
+      ri = XCALLOC (MTYPE_BGP_ROUTE, sizeof (struct bgp_info));
+      ri->type = ZEBRA_ROUTE_BGP;
+      ri->sub_type = BGP_ROUTE_NORMAL;
+      ri->peer = sources[i % SOURCES];
+
+      snprintf (str, sizeof (str), "%u %u %u", ri->peer->as,
+                64512 + prng_rand (prng) % 16, 3356);
+      aspath = aspath_intern (aspath_str2aspath (str));
+      bgp_attr_default_set (&attr, prng_rand (prng) % 8
+                            ? BGP_ORIGIN_IGP : BGP_ORIGIN_INCOMPLETE);
+      attr.aspath = aspath;
+      attr.med = prng_rand (prng) % 16;
+      attr.flag |= ATTR_FLAG_BIT (BGP_ATTR_MULTI_EXIT_DISC);
+      attr.nexthop = ri->peer->su.sin.sin_addr;
+      ri->attr = bgp_attr_intern (&attr);
+      bgp_attr_extra_free (&attr);
+      aspath_unintern (&aspath);
+
+      SET_FLAG (ri->flags, BGP_INFO_VALID | BGP_INFO_SELECTED);
+      p.u.prefix4.s_addr = htonl (0x0a000000 + (i << 8));
+      rn = bgp_node_get (bgp->rib[AFI_IP][SAFI_UNICAST], &p);
+      bgp_info_add (rn, ri);
+      bgp_unlock_node (rn);
+    }
+}
+
+/* Peers left to come up, one at each slice */
+struct joining
+{
+  struct peer **peers;
+  unsigned int count;
+};
+
+static int
+bench_join (void *arg)
+{
+  struct joining *joining = arg;
+
+  if (! joining->count)
+    return 0;
+  bgp_announce_route (*joining->peers++, AFI_IP, SAFI_UNICAST);
+  joining->count--;
+  return 1;
+}
+
+static unsigned int
+bench_updates (struct peer *peer)
+{
+  struct bgp_synchronize *sync = peer->sync[AFI_IP][SAFI_UNICAST];
+  struct fifo *f;
+  unsigned int updates = 0;
+
+  for (f = sync->update.next; f != &sync->update; f = f->next)
+    updates++;
+  return updates;
+}
+
+static int
+bench_check (struct peer **peers, unsigned int count, unsigned int prefixes)
+{
+  unsigned int i, updates;
+  int errors = 0;
+
+  for (i = 0; i < count; i++)
+    {
+      updates = bench_updates (peers[i]);
+      if (updates != prefixes
+          || CHECK_FLAG (peers[i]->af_sflags[AFI_IP][SAFI_UNICAST],
+                         PEER_STATUS_ANNOUNCE))
+        {
+          printf ("%s: %u updates queued, %u expected%s\n", peers[i]->host,
+                  updates, prefixes,
+                  CHECK_FLAG (peers[i]->af_sflags[AFI_IP][SAFI_UNICAST],
+                              PEER_STATUS_ANNOUNCE) ? ", still announcing" : "");
+          errors++;
+        }
+    }
+  return errors;
+}
+
+static void
+report (const char *phase, unsigned long usec, unsigned long slice,
+        long allocs)
+{
+  bench_report (phase, usec, " %6lu.%03lu ms slice %+10ld allocations "
+                "%8ld KB peak", slice / 1000, slice % 1000, allocs,
+                bench_peak_kbytes ());
+}
+
+int
+main (int argc, char **argv)
+{
+  struct bgp *bgp;
+  struct peer **sources, **peers;
+  struct joining joining;
+  struct timeval start;
+  unsigned long usec, slice, worst;
+  unsigned int prefixes = 20000, count = 8, seed = 0, updates, i;
+  as_t as = LOCAL_AS;
+  int errors = 0;
+  long allocs;
+  const struct bench_option options[] =
+  {
+    { 'n', "prefixes", &prefixes },
+    { 'p', "peers", &count },
+    { 's', "seed", &seed },
+    { 0, NULL, NULL }
+  };
+
+  bench_options (argc, argv, options);
+  if (prefixes == 0 || prefixes > 0xffffff || count == 0 || count > 0xffff)
+    bench_usage ();
+
+  bench_init ();
+  prng = prng_new (seed);
+  bgp_get (&bgp, &as, NULL);
+
+  sources = bench_peers_new (bgp, SOURCES, 1);
+  bench_table_fill (bgp, sources, prefixes);
+  printf ("%u prefixes, %u peers per phase\n", prefixes, count);
+
+  /* One walk per peer, as when the peers come up one after the other */
+  peers = bench_peers_new (bgp, count, 2);
+  allocs = bench_allocations ();
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  worst = 0;
+  for (i = 0; i < count; i++)
+    {
+      bgp_announce_route (peers[i], AFI_IP, SAFI_UNICAST);
+      slice = bench_run (bgp, NULL, NULL);
+      if (slice > worst)
+        worst = slice;
+    }
+  usec = bench_usec_since (&start);
+  report ("one walk per peer", usec, worst, bench_allocations () - allocs);
+  errors += bench_check (peers, count, prefixes);
+  free (peers);
+
+  /* All the peers up at once, sharing a walk */
+  peers = bench_peers_new (bgp, count, 3);
+  allocs = bench_allocations ();
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < count; i++)
+    bgp_announce_route (peers[i], AFI_IP, SAFI_UNICAST);
+  slice = bench_run (bgp, NULL, NULL);
+  usec = bench_usec_since (&start);
+  report ("shared walk", usec, slice, bench_allocations () - allocs);
+  errors += bench_check (peers, count, prefixes);
+  free (peers);
+
+  /* A peer coming up at each slice, joining the walk and wrapping
+   * around the table */
+  peers = bench_peers_new (bgp, count, 4);
+  allocs = bench_allocations ();
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  joining.peers = peers;
+  joining.count = count;
+  slice = bench_run (bgp, bench_join, &joining);
+  usec = bench_usec_since (&start);
+  report ("joining walk", usec, slice, bench_allocations () - allocs);
+  errors += bench_check (peers, count, prefixes);
+  free (peers);
+
+  /* A peer deactivated while the walk runs, which clears its flags
+   * before it is stopped: it leaves the walk, the others are sent the
+   * table */
+  peers = bench_peers_new (bgp, count + 1, 5);
+  allocs = bench_allocations ();
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i <= count; i++)
+    bgp_announce_route (peers[i], AFI_IP, SAFI_UNICAST);
+  peer_deactivate (peers[0], AFI_IP, SAFI_UNICAST);
+  slice = bench_run (bgp, NULL, NULL);
+  BGP_TIMER_OFF (peers[0]->t_start);
+  usec = bench_usec_since (&start);
+  report ("walk with a peer deactivated", usec, slice,
+          bench_allocations () - allocs);
+  errors += bench_check (peers + 1, count, prefixes);
+  if ((updates = bench_updates (peers[0])) != 0)
+    {
+      printf ("%s: %u updates queued once deactivated\n", peers[0]->host,
+              updates);
+      errors++;
+    }
+  free (peers);
+
+  free (sources);
+  prng_free (prng);
+
+  return bench_done (errors);
+}
@@ -0,0 +1,350 @@
+/*
+ * BGP best path benchmark: give each prefix of a table paths from
+ * several peers, with attributes drawn to tie on the first steps of the
+ * decision process, then time the best path selection of all the
+ * prefixes, with and without deterministic-med. Fails when the selected
+ * path of a prefix does not win against each of its other paths.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "vty.h"
+#include "stream.h"
+#include "linklist.h"
+#include "memory.h"
+#include "filter.h"
+#include "prng.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_aspath.h"
+#include "bgpd/bgp_mpath.h"
+#include "bgp-bench.h"
+
+#define LOCAL_AS	65000
+
+/* AS paths of the routes, most of them of the same length */
+static const char *aspaths[] =
+{
+  "65001 174 3356",
+  "65002 174 3356",
+  "65003 1299 3356",
+  "65004 2914 3356",
+  "65001 6939 3356",
+  "65002 3356",
+  "65003 1299 2914 3356",
+  "65004 174 1299 3356",
+};
+#define ASPATH_COUNT	(sizeof (aspaths) / sizeof (aspaths[0]))
+
+static struct prng *prng;
+static struct aspath *aspath_interned[ASPATH_COUNT];
+
+static struct bgp *
+bench_bgp_new (void)
+{
+  struct bgp *bgp;
+
+  bgp = XCALLOC (MTYPE_BGP, sizeof (struct bgp));
+  bgp_lock (bgp);
+  bgp->peer = list_new ();
+  bgp->group = list_new ();
+  bgp->rsclient = list_new ();
+  bgp->rib[AFI_IP][SAFI_UNICAST] = bgp_table_init (AFI_IP, SAFI_UNICAST);
+  bgp->maxpaths[AFI_IP][SAFI_UNICAST].maxpaths_ebgp = BGP_DEFAULT_MAXPATHS;
+  bgp->maxpaths[AFI_IP][SAFI_UNICAST].maxpaths_ibgp = BGP_DEFAULT_MAXPATHS;
+  bgp->default_local_pref = BGP_DEFAULT_LOCAL_PREF;
+  bgp->as = LOCAL_AS;
+  return bgp;
+}
+
+/* Peers in a few neighbouring ASes, a quarter of them internal */
+static struct peer *
+bench_peers_new (struct bgp *bgp, unsigned int count)
+{
+  struct peer *peers;
+  char buf[INET_ADDRSTRLEN];
+  unsigned int i;
+
+  peers = calloc (count, sizeof (struct peer));
+  for (i = 0; i < count; i++)
+    {
+      struct peer *peer = &peers[i];
+
+      snprintf (buf, sizeof (buf), "10.%u.%u.%u", (i >> 16) & 0xff,
+                (i >> 8) & 0xff, (i & 0xff) + 1);
+      peer->bgp = bgp;
+      peer->host = strdup (buf);
+      peer->local_as = LOCAL_AS;
+      if (i % 4 == 3)
+        {
+          peer->as = LOCAL_AS;
+          peer->sort = BGP_PEER_IBGP;
+        }
+      else
+        {
+          peer->as = 65001 + i % 4;
+          peer->sort = BGP_PEER_EBGP;
+        }
+      peer->status = Established;
+      inet_pton (AF_INET, buf, &peer->remote_id);
+      peer->su_remote = sockunion_str2su (buf);
+    }
+  return peers;
+}
+
+static struct attr *
+bench_attr_new (void)
+{
+  struct attr attr;
+  struct attr *new;
+
+  bgp_attr_default_set (&attr, BGP_ORIGIN_IGP);
+  if (prng_rand (prng) % 8 == 0)
+    attr.origin = BGP_ORIGIN_INCOMPLETE;
+  if (prng_rand (prng) % 16 == 0)
+    attr.local_pref = 200;
+  attr.flag |= ATTR_FLAG_BIT (BGP_ATTR_LOCAL_PREF);
+  attr.med = prng_rand (prng) % 4;
+  attr.flag |= ATTR_FLAG_BIT (BGP_ATTR_MULTI_EXIT_DISC);
+  attr.aspath = aspath_interned[prng_rand (prng) % ASPATH_COUNT];
+  attr.nexthop.s_addr = htonl (0x0a000001 + prng_rand (prng) % 64);
+
+  new = bgp_attr_intern (&attr);
+  bgp_attr_extra_free (&attr);
+  return new;
+}
+
+/* Paths of distinct peers for each prefix 10.0.0.0/24, 10.0.1.0/24... */
+static void
+bench_table_fill (struct bgp *bgp, struct peer *peers, unsigned int peer_count,
+                  unsigned int prefixes, unsigned int paths)
+{
+  struct bgp_node *rn;
+  struct bgp_info *ri;
+  struct prefix p;
+  unsigned int i, j, first;
+
+  memset (&p, 0, sizeof (p));
+  p.family = AF_INET;
+  p.prefixlen = 24;
+  for (i = 0; i < prefixes; i++)
+    {
+      p.u.prefix4.s_addr = htonl (0x0a000000 + (i << 8));
+      rn = bgp_node_get (bgp->rib[AFI_IP][SAFI_UNICAST], &p);
+      first = prng_rand (prng) % peer_count;
+      for (j = 0; j < paths; j++)
+        {
+          ri = XCALLOC (MTYPE_BGP_ROUTE, sizeof (struct bgp_info));
+          ri->type = ZEBRA_ROUTE_BGP;
+          ri->sub_type = BGP_ROUTE_NORMAL;
+          ri->peer = &peers[(first + j) % peer_count];
+          ri->attr = bench_attr_new ();
+          SET_FLAG (ri->flags, BGP_INFO_VALID);
+          bgp_info_add (rn, ri);
+        }
+      bgp_unlock_node (rn);
+    }
+}
+
+/* Select the best path of every prefix, and mark it like
+ * bgp_process_main does */
+static void
+bench_select (struct bgp *bgp)
+{
+  struct bgp_node *rn;
+  struct bgp_info_pair old_and_new;
+
+  for (rn = bgp_table_top (bgp->rib[AFI_IP][SAFI_UNICAST]); rn;
+       rn = bgp_route_next (rn))
+    {
+      if (rn->info == NULL)
+        continue;
+      bgp_best_selection (bgp, rn, &old_and_new, AFI_IP, SAFI_UNICAST);
+      if (old_and_new.old == old_and_new.new)
+        continue;
+      if (old_and_new.old)
+        bgp_info_unset_flag (rn, old_and_new.old, BGP_INFO_SELECTED);
+      if (old_and_new.new)
+        bgp_info_set_flag (rn, old_and_new.new, BGP_INFO_SELECTED);
+    }
+}
+
+/* The selected path must be preferred to any other, and have the best
+ * local preference, AS path length and origin, in that order */
+static int
+bench_check (struct bgp *bgp)
+{
+  struct bgp_node *rn;
+  struct bgp_info *ri, *sel;
+  char buf[PREFIX_STRLEN];
+  int errors = 0;
+
+  for (rn = bgp_table_top (bgp->rib[AFI_IP][SAFI_UNICAST]); rn;
+       rn = bgp_route_next (rn))
+    {
+      if (rn->info == NULL)
+        continue;
+      for (sel = rn->info; sel; sel = sel->next)
+        if (CHECK_FLAG (sel->flags, BGP_INFO_SELECTED))
+          break;
+      prefix2str (&rn->p, buf, sizeof (buf));
+      if (sel == NULL)
+        {
+          printf ("%s: no path selected\n", buf);
+          errors++;
+          continue;
+        }
+      for (ri = rn->info; ri; ri = ri->next)
+        {
+          int lp, len, origin;
+
+          if (ri == sel)
+            continue;
+          if (bgp_info_cmp (bgp, sel, ri, AFI_IP, SAFI_UNICAST) != -1)
+            {
+              printf ("%s: path from %s preferred to selected path from %s\n",
+                      buf, ri->peer->host, sel->peer->host);
+              errors++;
+            }
+          lp = (int) ri->attr->local_pref - (int) sel->attr->local_pref;
+          len = aspath_count_hops (sel->attr->aspath)
+                - aspath_count_hops (ri->attr->aspath);
+          origin = sel->attr->origin - ri->attr->origin;
+          if (lp > 0 || (lp == 0 && (len > 0 || (len == 0 && origin > 0))))
+            {
+              printf ("%s: path from %s has better attributes than selected"
+                      " path from %s\n", buf, ri->peer->host, sel->peer->host);
+              errors++;
+            }
+        }
+    }
+  return errors;
+}
+
+static void
+bench_deselect (struct bgp *bgp)
+{
+  struct bgp_node *rn;
+  struct bgp_info *ri;
+
+  for (rn = bgp_table_top (bgp->rib[AFI_IP][SAFI_UNICAST]); rn;
+       rn = bgp_route_next (rn))
+    for (ri = rn->info; ri; ri = ri->next)
+      bgp_info_unset_flag (rn, ri, BGP_INFO_SELECTED);
+}
+
+static void
+report (const char *phase, unsigned long usec, long allocs,
+        unsigned int prefixes)
+{
+  bench_report (phase, usec, " %6lu ns/prefix %+10ld allocations %8ld KB peak",
+                usec * 1000 / prefixes, allocs, bench_peak_kbytes ());
+}
+
+int
+main (int argc, char **argv)
+{
+  struct bgp *bgp;
+  struct peer *peers;
+  struct timeval start;
+  unsigned long usec, total;
+  unsigned int prefixes = 10000, paths = 30, peer_count = 64;
+  unsigned int runs = 10, seed = 0, i, r;
+  int dmed, errors = 0;
+  long allocs;
+  char phase[64];
+  const struct bench_option options[] =
+  {
+    { 'n', "prefixes", &prefixes },
+    { 'p', "paths", &paths },
+    { 'P', "peers", &peer_count },
+    { 'r', "runs", &runs },
+    { 's', "seed", &seed },
+    { 0, NULL, NULL }
+  };
+
+  bench_options (argc, argv, options);
+  if (prefixes == 0 || prefixes > 0xffffff || paths == 0
+      || peer_count < paths || runs == 0)
+    bench_usage ();
+
+  bench_init ();
+  prng = prng_new (seed);
+  for (i = 0; i < ASPATH_COUNT; i++)
+    aspath_interned[i] = aspath_intern (aspath_str2aspath (aspaths[i]));
+
+  bgp = bench_bgp_new ();
+  /* MED is compared between all paths, so that the selected path is
+   * the best of all of them whatever the order of the comparisons */
+  bgp_flag_set (bgp, BGP_FLAG_ALWAYS_COMPARE_MED);
+  peers = bench_peers_new (bgp, peer_count);
+  printf ("%u prefixes, %u paths per prefix, %u peers\n",
+          prefixes, paths, peer_count);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  allocs = bench_allocations ();
+  bench_table_fill (bgp, peers, peer_count, prefixes, paths);
+  report ("table", bench_usec_since (&start), bench_allocations () - allocs,
+          prefixes);
+
+  for (dmed = 0; dmed <= 1; dmed++)
+    {
+      if (dmed)
+        bgp_flag_set (bgp, BGP_FLAG_DETERMINISTIC_MED);
+
+      /* First selection, then the same paths again */
+      bench_deselect (bgp);
+      snprintf (phase, sizeof (phase), "%s first selection",
+                dmed ? "deterministic-med" : "best path");
+      allocs = bench_allocations ();
+      quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+      bench_select (bgp);
+      report (phase, bench_usec_since (&start),
+              bench_allocations () - allocs, prefixes);
+      errors += bench_check (bgp);
+
+      total = 0;
+      allocs = bench_allocations ();
+      for (r = 0; r < runs; r++)
+        {
+          quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+          bench_select (bgp);
+          usec = bench_usec_since (&start);
+          total += usec;
+        }
+      snprintf (phase, sizeof (phase), "%s reselection",
+                dmed ? "deterministic-med" : "best path");
+      report (phase, total / runs, bench_allocations () - allocs, prefixes);
+      errors += bench_check (bgp);
+    }
+
+  for (i = 0; i < peer_count; i++)
+    {
+      free (peers[i].host);
+      sockunion_free (peers[i].su_remote);
+    }
+  free (peers);
+  prng_free (prng);
+
+  return bench_done (errors);
+}
@@ -0,0 +1,272 @@
+/*
+ * BGP peer teardown benchmark: load the RIB with a full table from a
+ * peer with soft reconfiguration, and a part of it from another peer,
+ * announce it to a third, then bring the sessions down and time how
+ * long the RIB takes to drop the routes of the peer, and what was
+ * advertised to it.  Reports the time to leave state Clearing, the time
+ * until the RIB is settled and the longest slice, and fails when
+ * anything of the peer is left in the RIB.  Last, a peer restarting
+ * gracefully goes down and comes back with part of its routes, and the
+ * sweep of the stale routes it did not send again is timed.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "vty.h"
+#include "stream.h"
+#include "linklist.h"
+#include "memory.h"
+#include "thread.h"
+#include "filter.h"
+#include "prng.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_aspath.h"
+#include "bgpd/bgp_advertise.h"
+#include "bgpd/bgp_fsm.h"
+#include "bgp-bench.h"
+
+#define LOCAL_AS	65000
+#define ANY		ULONG_MAX
+
+static struct bgp *bgp;
+static struct prng *prng;
+
+/* Session going down, and the time it left state Clearing */
+struct teardown
+{
+  struct peer *peer;
+  struct timeval start;
+  unsigned long cleared;
+};
+
+static int
+bench_down (void *arg)
+{
+  struct teardown *down = arg;
+  struct peer *peer = down->peer;
+
+  if (peer->status == Established)
+    return 1;
+  if (peer->status != Clearing && ! down->cleared)
+    {
+      down->cleared = bench_usec_since (&down->start);
+      /* No connection to start */
+      BGP_TIMER_OFF (peer->t_start);
+    }
+  return 0;
+}
+
+/* Routes 10.0.0.0/24, 10.0.1.0/24... received from the peer, every
+ * step-th of them */
+static void
+bench_receive (struct peer *peer, unsigned int prefixes, unsigned int step)
+{
+  struct aspath *aspath;
+  struct attr attr;
+  struct prefix p;
+  char str[64];
+  unsigned int i;
+
+  memset (&p, 0, sizeof (p));
+  p.family = AF_INET;
+  p.prefixlen = 24;
+  for (i = 0; i < prefixes; i += step)
+    {
+      snprintf (str, sizeof (str), "%u %u %u", peer->as,
+                64512 + prng_rand (prng) % 16, 3356);
+      aspath = aspath_intern (aspath_str2aspath (str));
+      bgp_attr_default_set (&attr, BGP_ORIGIN_IGP);
+      attr.aspath = aspath;
+      attr.nexthop = peer->su.sin.sin_addr;
+
+      p.u.prefix4.s_addr = htonl (0x0a000000 + (i << 8));
+      bgp_update (peer, &p, &attr, AFI_IP, SAFI_UNICAST, ZEBRA_ROUTE_BGP,
+                  BGP_ROUTE_NORMAL, NULL, NULL, 0);
+      bgp_attr_extra_free (&attr);
+      aspath_unintern (&aspath);
+    }
+}
+
+/* What the RIB holds of the peer */
+static void
+bench_count (struct peer *peer, unsigned long *routes, unsigned long *adj_in,
+             unsigned long *adj_out)
+{
+  struct bgp_node *rn;
+  struct bgp_info *ri;
+  struct bgp_adj_in *ain;
+  struct bgp_adj_out *aout;
+
+  *routes = *adj_in = *adj_out = 0;
+  for (rn = bgp_table_top (bgp->rib[AFI_IP][SAFI_UNICAST]); rn;
+       rn = bgp_route_next (rn))
+    {
+      for (ri = rn->info; ri; ri = ri->next)
+        if (ri->peer == peer)
+          (*routes)++;
+      for (ain = rn->adj_in; ain; ain = ain->next)
+        if (ain->peer == peer)
+          (*adj_in)++;
+      for (aout = rn->adj_out; aout; aout = aout->next)
+        if (aout->peer == peer)
+          (*adj_out)++;
+    }
+}
+
+static int
+bench_check (struct peer *peer, unsigned long routes, unsigned long adj_in,
+             unsigned long adj_out)
+{
+  unsigned long r, ai, ao;
+
+  bench_count (peer, &r, &ai, &ao);
+  if (r == routes && ai == adj_in && (adj_out == ANY || ao == adj_out)
+      && peer->pcount[AFI_IP][SAFI_UNICAST] == routes)
+    return 0;
+
+  printf ("%s: %lu routes, %lu adj-in, %lu adj-out, %lu counted, "
+          "expected %lu, %lu, %lu\n", peer->host, r, ai, ao,
+          peer->pcount[AFI_IP][SAFI_UNICAST], routes, adj_in, adj_out);
+  return 1;
+}
+
+static void
+report (const char *phase, const char *what, unsigned long usec,
+        unsigned long slice)
+{
+  char str[64];
+
+  snprintf (str, sizeof (str), "%s, %s", phase, what);
+  bench_report (str, usec, " %6lu.%03lu ms slice", slice / 1000,
+                slice % 1000);
+}
+
+/* Bring the session with the peer down, and time the teardown */
+static void
+bench_teardown (const char *phase, struct peer *peer)
+{
+  struct teardown down;
+  unsigned long slice;
+
+  down.peer = peer;
+  down.cleared = 0;
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &down.start);
+  BGP_EVENT_ADD (peer, BGP_Stop);
+  slice = bench_run (bgp, bench_down, &down);
+  report (phase, "cleared", down.cleared, slice);
+  report (phase, "settled", bench_usec_since (&down.start), slice);
+}
+
+int
+main (int argc, char **argv)
+{
+  struct peer *full, *part, *receiver, *restarting;
+  struct timeval start;
+  unsigned int prefixes = 100000, seed = 0;
+  unsigned long slice, partial, kept, refreshed;
+  as_t as = LOCAL_AS;
+  int errors = 0;
+  const struct bench_option options[] =
+  {
+    { 'n', "prefixes", &prefixes },
+    { 's', "seed", &seed },
+    { 0, NULL, NULL }
+  };
+
+  bench_options (argc, argv, options);
+  if (prefixes == 0 || prefixes > 0xffffff)
+    bench_usage ();
+
+  bench_init ();
+  prng = prng_new (seed);
+  bgp_get (&bgp, &as, NULL);
+
+  full = bench_peer_new (bgp, "10.1.0.1", LOCAL_AS + 1);
+  SET_FLAG (full->af_flags[AFI_IP][SAFI_UNICAST], PEER_FLAG_SOFT_RECONFIG);
+  part = bench_peer_new (bgp, "10.1.0.2", LOCAL_AS + 2);
+  receiver = bench_peer_new (bgp, "10.2.0.1", LOCAL_AS + 3);
+  printf ("%u prefixes\n", prefixes);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  bench_receive (full, prefixes, 1);
+  bench_receive (part, prefixes, 4);
+  bgp_announce_route (receiver, AFI_IP, SAFI_UNICAST);
+  slice = bench_run (bgp, NULL, NULL);
+  report ("load", "settled", bench_usec_since (&start), slice);
+
+  partial = (prefixes + 3) / 4;
+  errors += bench_check (full, prefixes, prefixes, ANY);
+  errors += bench_check (part, partial, 0, ANY);
+  errors += bench_check (receiver, 0, 0, prefixes);
+
+  /* The peer with the full table goes down: its routes and adj-in go,
+   * and the prefixes only it had are withdrawn from the receiver */
+  bench_teardown ("full table peer down", full);
+  errors += bench_check (full, 0, 0, 0);
+  errors += bench_check (part, partial, 0, ANY);
+
+  /* The receiver goes down: all that was advertised to it goes */
+  bench_teardown ("receiver down", receiver);
+  errors += bench_check (receiver, 0, 0, 0);
+  errors += bench_check (part, partial, 0, ANY);
+
+  /* A peer sending a few routes and sent the table restarts gracefully:
+   * its routes are kept as stale while it is down */
+  restarting = bench_peer_new (bgp, "10.1.0.3", LOCAL_AS + 4);
+  bench_receive (restarting, prefixes, 8);
+  bgp_announce_route (restarting, AFI_IP, SAFI_UNICAST);
+  bench_run (bgp, NULL, NULL);
+  kept = (prefixes + 7) / 8;
+  errors += bench_check (restarting, kept, 0, ANY);
+
+  restarting->nsf[AFI_IP][SAFI_UNICAST] = 1;
+  restarting->v_gr_restart = 120;
+  SET_FLAG (restarting->sflags, PEER_STATUS_NSF_MODE | PEER_STATUS_NSF_WAIT);
+  bench_teardown ("restarting peer down", restarting);
+  errors += bench_check (restarting, kept, 0, 0);
+
+  /* It comes back, is sent the table again and refreshes half of its
+   * routes before End-of-RIB, which sweeps the others */
+  BGP_TIMER_OFF (restarting->t_gr_restart);
+  BGP_TIMER_OFF (restarting->t_gr_stale);
+  UNSET_FLAG (restarting->sflags, PEER_STATUS_NSF_WAIT);
+  restarting->status = Established;
+  bgp_announce_route (restarting, AFI_IP, SAFI_UNICAST);
+  bench_receive (restarting, prefixes, 16);
+  bench_run (bgp, NULL, NULL);
+  errors += bench_check (restarting, kept, 0, ANY);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  bgp_clear_stale_route (restarting, AFI_IP, SAFI_UNICAST);
+  slice = bench_usec_since (&start);
+  bench_run (bgp, NULL, NULL);
+  report ("stale routes swept", "swept", slice, slice);
+  report ("stale routes swept", "settled", bench_usec_since (&start), slice);
+  refreshed = (prefixes + 15) / 16;
+  errors += bench_check (restarting, refreshed, 0, ANY);
+
+  prng_free (prng);
+
+  return bench_done (errors);
+}
@@ -0,0 +1,296 @@
+/*
+ * BGP communities test and benchmark: parse and intern sets of random
+ * communities, match them against community-list entries and add
+ * communities to them, checking every result against a plain
+ * implementation, then time interning, matching and the additive set
+ * of a route-map on routes with many communities.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "vty.h"
+#include "memory.h"
+#include "hash.h"
+#include "thread.h"
+#include "filter.h"
+#include "prng.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_community.h"
+#include "bgp-bench.h"
+
+#define ENTRIES		8
+
+static struct prng *prng;
+
+/* Random value, from a few ASes so that sets overlap, or well-known */
+static u_int32_t
+random_val (void)
+{
+  if (prng_rand (prng) % 64 == 0)
+    return COMMUNITY_NO_EXPORT + prng_rand (prng) % 3;
+  return ((64512 + prng_rand (prng) % 32) << 16) | (prng_rand (prng) % 1024);
+}
+
+/* Random values in network byte order, with duplicates */
+static void
+random_vals (u_int32_t *vals, unsigned int size)
+{
+  unsigned int i;
+
+  for (i = 0; i < size; i++)
+    if (i && prng_rand (prng) % 8 == 0)
+      vals[i] = vals[prng_rand (prng) % i];
+    else
+      vals[i] = htonl (random_val ());
+}
+
+/* Plain implementations, on the values in any order */
+static int
+ref_include (const struct community *com, u_int32_t val)
+{
+  int i;
+
+  for (i = 0; i < com->size; i++)
+    if (community_val_get ((struct community *) com, i) == val)
+      return 1;
+  return 0;
+}
+
+static int
+ref_match (const struct community *com1, const struct community *com2)
+{
+  int j;
+
+  for (j = 0; j < com2->size; j++)
+    if (! ref_include (com1, community_val_get ((struct community *) com2, j)))
+      return 0;
+  return 1;
+}
+
+static int
+ref_sorted (const struct community *com)
+{
+  int i;
+
+  for (i = 1; i < com->size; i++)
+    if (community_val_get ((struct community *) com, i - 1)
+        >= community_val_get ((struct community *) com, i))
+      return 0;
+  return 1;
+}
+
+static int
+check (int ok, const char *what, unsigned int round)
+{
+  if (! ok)
+    printf ("round %u: %s\n", round, what);
+  return ! ok;
+}
+
+static int
+verify (unsigned int rounds, unsigned int size)
+{
+  u_int32_t *vals, *shuffled, tmp;
+  struct community *com, *com2, *entry, *sum;
+  unsigned int round, i, j, k;
+  u_int32_t val;
+  int errors = 0;
+
+  vals = calloc (size + 1, sizeof (u_int32_t));
+  shuffled = calloc (size + 1, sizeof (u_int32_t));
+
+  for (round = 0; round < rounds; round++)
+    {
+      k = 1 + prng_rand (prng) % size;
+      random_vals (vals, k);
+      com = community_parse (vals, k * 4);
+
+      errors += check (ref_sorted (com), "not sorted", round);
+      errors += check (ref_match (com, com) && com->size <= (int) k,
+                       "values lost", round);
+      for (i = 0; i < k; i++)
+        errors += check (ref_include (com, ntohl (vals[i])), "value lost",
+                         round);
+
+      /* Same values in another order: same interned community */
+      memcpy (shuffled, vals, k * 4);
+      for (i = k - 1; i > 0; i--)
+        {
+          j = prng_rand (prng) % (i + 1);
+          tmp = shuffled[i];
+          shuffled[i] = shuffled[j];
+          shuffled[j] = tmp;
+        }
+      com2 = community_parse (shuffled, k * 4);
+      errors += check (com2 == com, "not interned once", round);
+      community_unintern (&com2);
+
+      for (i = 0; i < 16; i++)
+        {
+          val = i % 2 ? random_val () : ntohl (vals[prng_rand (prng) % k]);
+          errors += check (community_include (com, val)
+                           == ref_include (com, val), "include", round);
+        }
+
+      /* List entries from the values of the route, and others */
+      for (i = 0; i < ENTRIES; i++)
+        {
+          k = 1 + prng_rand (prng) % 3;
+          for (j = 0; j < k; j++)
+            vals[j] = i % 2 ? htonl (random_val ())
+                            : com->val[prng_rand (prng) % com->size];
+          entry = community_parse (vals, k * 4);
+          errors += check (community_match (com, entry)
+                           == ref_match (com, entry), "match", round);
+          errors += check (community_match (entry, com)
+                           == ref_match (entry, com), "match", round);
+
+          sum = community_union (com, entry);
+          errors += check (ref_sorted (sum) && ref_match (sum, com)
+                           && ref_match (sum, entry)
+                           && sum->size <= com->size + entry->size,
+                           "union", round);
+          com2 = community_parse (sum->val, sum->size * 4);
+          errors += check (community_cmp (sum, com2)
+                           && community_hash_make (sum)
+                              == community_hash_make (com2),
+                           "union fingerprint", round);
+          errors += check (community_cmp (sum, com) == (sum->size == com->size),
+                           "cmp", round);
+          community_unintern (&com2);
+          community_free (sum);
+          community_unintern (&entry);
+        }
+      community_unintern (&com);
+    }
+
+  free (vals);
+  free (shuffled);
+  return errors;
+}
+
+static void
+report (const char *what, unsigned long usec, unsigned long ops)
+{
+  bench_report (what, usec, " %8lu ns/op", usec * 1000 / ops);
+}
+
+static void
+bench (unsigned int routes, unsigned int size)
+{
+  struct community **coms, *entries[ENTRIES], *new;
+  u_int32_t **vals, evals[2];
+  struct timeval start;
+  unsigned int i, j, matches = 0;
+
+  coms = calloc (routes, sizeof (struct community *));
+  vals = calloc (routes, sizeof (u_int32_t *));
+  for (i = 0; i < routes; i++)
+    {
+      vals[i] = calloc (size, sizeof (u_int32_t));
+      random_vals (vals[i], size);
+    }
+  for (i = 0; i < ENTRIES; i++)
+    {
+      evals[0] = htonl (random_val ());
+      evals[1] = htonl (random_val ());
+      entries[i] = community_parse (evals, (i % 2 + 1) * 4);
+    }
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < routes; i++)
+    coms[i] = community_parse (vals[i], size * 4);
+  report ("parse, new", bench_usec_since (&start), routes);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < routes; i++)
+    {
+      new = community_parse (vals[i], size * 4);
+      community_unintern (&new);
+    }
+  report ("parse, interned", bench_usec_since (&start), routes);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < routes; i++)
+    for (j = 0; j < ENTRIES; j++)
+      matches += community_match (coms[i], entries[j]);
+  report ("match", bench_usec_since (&start), routes * ENTRIES);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < routes; i++)
+    matches += community_include (coms[i], COMMUNITY_NO_EXPORT);
+  report ("include no-export", bench_usec_since (&start), routes);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < routes; i++)
+    {
+      new = community_intern (community_union (coms[i], entries[i % ENTRIES]));
+      community_unintern (&new);
+    }
+  report ("additive, interned", bench_usec_since (&start), routes);
+
+  printf ("%u matches\n", matches);
+
+  for (i = 0; i < routes; i++)
+    {
+      community_unintern (&coms[i]);
+      free (vals[i]);
+    }
+  for (i = 0; i < ENTRIES; i++)
+    community_unintern (&entries[i]);
+  free (coms);
+  free (vals);
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned int routes = 10000, size = 100, seed = 0;
+  int errors;
+  const struct bench_option options[] =
+  {
+    { 'n', "routes", &routes },
+    { 'c', "communities", &size },
+    { 's', "seed", &seed },
+    { 0, NULL, NULL }
+  };
+
+  bench_options (argc, argv, options);
+  if (routes == 0 || size == 0 || size > 4096)
+    bench_usage ();
+
+  prng = prng_new (seed);
+  community_init ();
+
+  errors = verify (2000, size);
+  printf ("%u routes, %u communities\n", routes, size);
+  bench (routes, size);
+
+  if (community_count ())
+    {
+      printf ("%lu communities left interned\n", community_count ());
+      errors++;
+    }
+  community_finish ();
+  prng_free (prng);
+
+  return bench_done (errors);
+}
@@ -0,0 +1,356 @@
+/*
+ * BGP route flap dampening test and benchmark: flap many prefixes,
+ * check that every dampening information is queued for its exact reuse
+ * or release time and that the peer statistics add up, then let time
+ * pass until the suppressed routes are reused and all the information
+ * released.  Reports the time each phase takes.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "vty.h"
+#include "stream.h"
+#include "linklist.h"
+#include "memory.h"
+#include "thread.h"
+#include "filter.h"
+#include "prng.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_damp.h"
+#include "bgp-bench.h"
+
+#define LOCAL_AS	65000
+#define SOURCES		4
+
+extern struct bgp_damp_config bgp_damp_cfg;
+static struct bgp_damp_config *damp = &bgp_damp_cfg;
+
+static struct prng *prng;
+
+/* Routes 10.0.0.0/24, 10.0.1.0/24... from the source peers */
+static struct bgp_info **
+bench_table_fill (struct bgp *bgp, struct peer **sources, unsigned int prefixes,
+                  struct bgp_node ***nodes)
+{
+  struct bgp_info **routes;
+  struct bgp_node *rn;
+  struct bgp_info *ri;
+  struct prefix p;
+  unsigned int i;
+
+  routes = calloc (prefixes, sizeof (struct bgp_info *));
+  *nodes = calloc (prefixes, sizeof (struct bgp_node *));
+  memset (&p, 0, sizeof (p));
+  p.family = AF_INET;
+  p.prefixlen = 24;
+  for (i = 0; i < prefixes; i++)
+    {
+      ri = XCALLOC (MTYPE_BGP_ROUTE, sizeof (struct bgp_info));
+      ri->type = ZEBRA_ROUTE_BGP;
+      ri->sub_type = BGP_ROUTE_NORMAL;
+      ri->peer = sources[i % SOURCES];
+      ri->attr = bgp_attr_default_intern (BGP_ORIGIN_IGP);
+      SET_FLAG (ri->flags, BGP_INFO_VALID);
+
+      p.u.prefix4.s_addr = htonl (0x0a000000 + (i << 8));
+      rn = bgp_node_get (bgp->rib[AFI_IP][SAFI_UNICAST], &p);
+      bgp_info_add (rn, ri);
+      bgp_unlock_node (rn);
+      routes[i] = ri;
+      (*nodes)[i] = rn;
+    }
+  return routes;
+}
+
+/* Every dampening information is in the calendar bucket of its next
+ * event, which is the exact time the route can be reused, or the
+ * information released.  Returns the number of errors, and the number
+ * of suppressed routes and of entries in *suppressed and *entries. */
+static int
+damp_check (unsigned long *suppressed, unsigned long *entries)
+{
+  struct bgp_damp_info *bdi;
+  unsigned int i;
+  unsigned int limit;
+  time_t d, t_max;
+  int decayed, before;
+  int errors = 0;
+
+  *suppressed = *entries = 0;
+  for (i = 0; i < damp->calendar_size; i++)
+    for (bdi = damp->calendar[i]; bdi; bdi = bdi->next)
+      {
+        (*entries)++;
+        if ((bdi->t_event & (damp->calendar_size - 1)) != i
+            || (bdi->next && bdi->next->prev != bdi)
+            || bdi->binfo->extra->damp_info != bdi)
+          {
+            printf ("entry misqueued\n");
+            errors++;
+            continue;
+          }
+
+        d = bdi->t_event - bdi->t_updated;
+        decayed = bgp_damp_decay (d, bdi->penalty);
+        before = d >= DELTA_T ? bgp_damp_decay (d - DELTA_T, bdi->penalty)
+                              : INT_MAX;
+        if (CHECK_FLAG (bdi->binfo->flags, BGP_INFO_DAMPED))
+          {
+            (*suppressed)++;
+            limit = damp->reuse_limit;
+            t_max = bdi->suppress_time + damp->max_suppress_time;
+            if (bdi->t_event > t_max
+                || (bdi->t_event < t_max
+                    && ((unsigned int) decayed >= limit
+                        || (unsigned int) before < limit)))
+              {
+                printf ("reuse at %+ld s, penalty %u: %d then %d\n",
+                        (long) d, bdi->penalty, before, decayed);
+                errors++;
+              }
+          }
+        else if (decayed > damp->reuse_limit / 2.0
+                 || before <= damp->reuse_limit / 2.0)
+          {
+            printf ("release at %+ld s, penalty %u: %d then %d\n",
+                    (long) d, bdi->penalty, before, decayed);
+            errors++;
+          }
+      }
+
+  if (*entries != damp->count)
+    {
+      printf ("%lu entries queued, %lu counted\n", *entries, damp->count);
+      errors++;
+    }
+  return errors;
+}
+
+/* Move the dampening information back in time, as if t seconds had
+ * passed, and run the reuse timer */
+static void
+damp_time_pass (time_t t)
+{
+  struct bgp_damp_info *bdi, *next, *all = NULL;
+  struct thread *thread, dummy;
+  int (*func) (struct thread *);
+  unsigned int i;
+
+  for (i = 0; i < damp->calendar_size; i++)
+    {
+      for (bdi = damp->calendar[i]; bdi; bdi = next)
+        {
+          next = bdi->next;
+          bdi->next = all;
+          all = bdi;
+        }
+      damp->calendar[i] = NULL;
+    }
+  for (bdi = all; bdi; bdi = next)
+    {
+      next = bdi->next;
+      bdi->start_time -= t;
+      bdi->t_updated -= t;
+      if (bdi->suppress_time)
+        bdi->suppress_time -= t;
+      bdi->t_event -= t;
+
+      i = bdi->t_event & (damp->calendar_size - 1);
+      bdi->prev = NULL;
+      bdi->next = damp->calendar[i];
+      if (bdi->next)
+        bdi->next->prev = bdi;
+      damp->calendar[i] = bdi;
+    }
+  damp->calendar_time -= t;
+
+  thread = damp->t_reuse;
+  if (! thread)
+    return;
+  func = thread->func;
+  thread_cancel (thread);
+  damp->t_reuse = NULL;
+  memset (&dummy, 0, sizeof (dummy));
+  func (&dummy);
+}
+
+/* Time to the last event, of the suppressed routes only or of all */
+static time_t
+damp_horizon (int damped)
+{
+  struct bgp_damp_info *bdi;
+  time_t t_now = bgp_clock (), t = 0;
+  unsigned int i;
+
+  for (i = 0; i < damp->calendar_size; i++)
+    for (bdi = damp->calendar[i]; bdi; bdi = bdi->next)
+      if (bdi->t_event - t_now > t
+          && (! damped || CHECK_FLAG (bdi->binfo->flags, BGP_INFO_DAMPED)))
+        t = bdi->t_event - t_now;
+  return t;
+}
+
+static void
+stats_sum (struct peer **sources, struct peer_damp_stats *sum)
+{
+  struct peer_damp_stats *stats;
+  unsigned int i;
+
+  memset (sum, 0, sizeof (*sum));
+  for (i = 0; i < SOURCES; i++)
+    {
+      stats = &sources[i]->damp[AFI_IP][SAFI_UNICAST];
+      sum->flaps += stats->flaps;
+      sum->suppressed += stats->suppressed;
+      sum->suppress += stats->suppress;
+      sum->reuse += stats->reuse;
+    }
+}
+
+static void
+report (const char *phase, unsigned long usec, unsigned long ops)
+{
+  bench_report (phase, usec, " %8lu ns/path", ops ? usec * 1000 / ops : 0);
+}
+
+int
+main (int argc, char **argv)
+{
+  struct bgp *bgp;
+  struct peer *sources[SOURCES];
+  struct bgp_info **routes;
+  struct bgp_node **nodes, *rn;
+  struct peer_damp_stats sum;
+  struct timeval start;
+  char addr[INET_ADDRSTRLEN];
+  unsigned long suppressed, entries, flaps = 0;
+  unsigned int prefixes = 100000, maxflaps = 4, seed = 0, i, f, n;
+  as_t as = LOCAL_AS;
+  int errors = 0;
+  const struct bench_option options[] =
+  {
+    { 'n', "prefixes", &prefixes },
+    { 'f', "flaps", &maxflaps },
+    { 's', "seed", &seed },
+    { 0, NULL, NULL }
+  };
+
+  bench_options (argc, argv, options);
+  if (prefixes == 0 || prefixes > 0xffffff || maxflaps == 0)
+    bench_usage ();
+
+  bench_init ();
+  prng = prng_new (seed);
+  bgp_get (&bgp, &as, NULL);
+
+  for (i = 0; i < SOURCES; i++)
+    {
+      snprintf (addr, sizeof (addr), "10.1.0.%u", i + 1);
+      sources[i] = bench_peer_new (bgp, addr, LOCAL_AS + 1 + i);
+    }
+  routes = bench_table_fill (bgp, sources, prefixes, &nodes);
+  bgp_damp_enable (bgp, AFI_IP, SAFI_UNICAST, DEFAULT_HALF_LIFE * 60,
+                   DEFAULT_REUSE, DEFAULT_SUPPRESS, 4 * DEFAULT_HALF_LIFE * 60);
+  printf ("%u prefixes, up to %u flaps\n", prefixes, maxflaps);
+
+  /* Withdraw and update each route a few times, leaving some withdrawn */
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < prefixes; i++)
+    {
+      rn = nodes[i];
+      n = 1 + prng_rand (prng) % maxflaps;
+      for (f = 0; f < n; f++)
+        {
+          bgp_damp_withdraw (routes[i], rn, AFI_IP, SAFI_UNICAST, 0);
+          flaps++;
+          if (f < n - 1 || i % 2)
+            bgp_damp_update (routes[i], rn, AFI_IP, SAFI_UNICAST);
+        }
+    }
+  report ("flap storm", bench_usec_since (&start), flaps);
+
+  errors += damp_check (&suppressed, &entries);
+  stats_sum (sources, &sum);
+  if (sum.flaps != flaps || sum.suppressed != suppressed
+      || sum.suppress != suppressed || entries != prefixes)
+    {
+      printf ("%u flaps, %u suppressed, %u in total for %lu flaps, "
+              "%lu suppressed, %lu entries\n", sum.flaps, sum.suppressed,
+              sum.suppress, flaps, suppressed, entries);
+      errors++;
+    }
+  printf ("%lu routes suppressed\n", suppressed);
+
+  /* Up to the last reuse: no route is left suppressed */
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  damp_time_pass (damp_horizon (1));
+  report ("reuse", bench_usec_since (&start), suppressed);
+
+  errors += damp_check (&suppressed, &entries);
+  stats_sum (sources, &sum);
+  if (suppressed || sum.suppressed || sum.reuse != sum.suppress)
+    {
+      printf ("%lu routes still suppressed, %u reused of %u\n",
+              suppressed, sum.reuse, sum.suppress);
+      errors++;
+    }
+  /* The withdrawn routes are kept as history until released */
+  for (i = 0; i < prefixes; i++)
+    if (i % 2 ? CHECK_FLAG (routes[i]->flags, BGP_INFO_HISTORY)
+              : ! CHECK_FLAG (routes[i]->flags,
+                              BGP_INFO_HISTORY | BGP_INFO_REMOVED))
+      {
+        printf ("route %u %s history\n", i, i % 2 ? "still" : "not");
+        errors++;
+        break;
+      }
+
+  /* Up to the last release: all the information is released, and the
+   * withdrawn routes with it */
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  damp_time_pass (damp_horizon (0));
+  report ("release", bench_usec_since (&start), entries);
+
+  errors += damp_check (&suppressed, &entries);
+  if (entries || mtype_stats_alloc (MTYPE_BGP_DAMP_INFO))
+    {
+      printf ("%lu entries left\n", entries);
+      errors++;
+    }
+  for (i = 0; i < prefixes; i++)
+    if ((CHECK_FLAG (routes[i]->flags, BGP_INFO_REMOVED) ? 1 : 0) != (i % 2 == 0)
+        || CHECK_FLAG (routes[i]->flags, BGP_INFO_HISTORY))
+      {
+        printf ("route %u not released\n", i);
+        errors++;
+        break;
+      }
+
+  bgp_damp_disable (bgp, AFI_IP, SAFI_UNICAST);
+  free (routes);
+  free (nodes);
+  prng_free (prng);
+
+  return bench_done (errors);
+}
@@ -0,0 +1,190 @@
+/*
+ * BGP input queue test: a peer sends more than its budget of changes
+ * while the process queue is filled with changes of no peer, e.g. local
+ * routes or the scanner, and is held.  Fails when the changes of the
+ * peer are left in its input queue once the process queue is done, and
+ * reading from it is never resumed.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "vty.h"
+#include "stream.h"
+#include "linklist.h"
+#include "memory.h"
+#include "thread.h"
+#include "workqueue.h"
+#include "filter.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_aspath.h"
+#include "bgp-bench.h"
+
+#define LOCAL_AS	65000
+
+static struct bgp *bgp;
+
+/* Local routes 172.16.0.0/24, 172.16.1.0/24..., each queued for
+ * processing with no peer */
+static void
+bench_local (unsigned int count)
+{
+  struct bgp_node *rn;
+  struct bgp_info *ri;
+  struct prefix p;
+  unsigned int i;
+
+  memset (&p, 0, sizeof (p));
+  p.family = AF_INET;
+  p.prefixlen = 24;
+  for (i = 0; i < count; i++)
+    {
+      ri = XCALLOC (MTYPE_BGP_ROUTE, sizeof (struct bgp_info));
+      ri->type = ZEBRA_ROUTE_BGP;
+      ri->sub_type = BGP_ROUTE_STATIC;
+      ri->peer = bgp->peer_self;
+      ri->attr = bgp_attr_default_intern (BGP_ORIGIN_IGP);
+      SET_FLAG (ri->flags, BGP_INFO_VALID);
+
+      p.u.prefix4.s_addr = htonl (0xac100000 + (i << 8));
+      rn = bgp_node_get (bgp->rib[AFI_IP][SAFI_UNICAST], &p);
+      bgp_info_add (rn, ri);
+      bgp_process (bgp, rn, AFI_IP, SAFI_UNICAST);
+      bgp_unlock_node (rn);
+    }
+}
+
+/* Routes 10.0.0.0/24, 10.0.1.0/24... received from the peer */
+static void
+bench_receive (struct peer *peer, unsigned int prefixes)
+{
+  struct aspath *aspath;
+  struct attr attr;
+  struct prefix p;
+  char str[64];
+  unsigned int i;
+
+  snprintf (str, sizeof (str), "%u %u", peer->as, 3356);
+  aspath = aspath_intern (aspath_str2aspath (str));
+  memset (&p, 0, sizeof (p));
+  p.family = AF_INET;
+  p.prefixlen = 24;
+  for (i = 0; i < prefixes; i++)
+    {
+      bgp_attr_default_set (&attr, BGP_ORIGIN_IGP);
+      attr.aspath = aspath;
+      attr.nexthop = peer->su.sin.sin_addr;
+
+      p.u.prefix4.s_addr = htonl (0x0a000000 + (i << 8));
+      bgp_update (peer, &p, &attr, AFI_IP, SAFI_UNICAST, ZEBRA_ROUTE_BGP,
+                  BGP_ROUTE_NORMAL, NULL, NULL, 0);
+      bgp_attr_extra_free (&attr);
+    }
+  aspath_unintern (&aspath);
+}
+
+/* Run the process queue and the input dispatch until neither has work
+ * scheduled.  Unlike bench_run, this does not wait for the input queues
+ * to drain, which they would never do if nothing refilled the process
+ * queue. */
+static unsigned long
+bench_drain (void)
+{
+  struct thread thread;
+  struct timeval start;
+  unsigned long usec, slice = 0;
+
+  while ((work_queue_is_scheduled (bm->process_main_queue) || bm->t_input)
+         && thread_fetch (bm->master, &thread))
+    {
+      quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+      thread_call (&thread);
+      usec = bench_usec_since (&start);
+      if (usec > slice)
+        slice = usec;
+    }
+  return slice;
+}
+
+int
+main (int argc, char **argv)
+{
+  struct peer *peer;
+  struct timeval start;
+  unsigned long slice;
+  unsigned int prefixes = BGP_INPUT_BUDGET + BGP_INPUT_BATCH;
+  unsigned int local = 4 * BGP_INPUT_BATCH;
+  as_t as = LOCAL_AS;
+  int errors = 0;
+  const struct bench_option options[] =
+  {
+    { 'n', "prefixes", &prefixes },
+    { 'l', "local", &local },
+    { 0, NULL, NULL }
+  };
+
+  bench_options (argc, argv, options);
+  if (prefixes <= BGP_INPUT_BUDGET || prefixes > 0xffff
+      || local < BGP_INPUT_BATCH || local > 0xffff)
+    bench_usage ();
+
+  bench_init ();
+  bgp_get (&bgp, &as, NULL);
+  peer = bench_peer_new (bgp, "10.1.0.1", LOCAL_AS + 1);
+  printf ("%u prefixes from the peer, %u local\n", prefixes, local);
+
+  /* The process queue is full of local changes when the peer's come in
+   * over its budget */
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  bench_local (local);
+  bench_receive (peer, prefixes);
+  bgp_input_throttle (peer);
+  if (! CHECK_FLAG (peer->sflags, PEER_STATUS_INPUT_HOLD))
+    {
+      printf ("%s: not held with %lu nodes pending\n", peer->host,
+              peer->input_pending);
+      errors++;
+    }
+
+  slice = bench_drain ();
+  bench_report ("local and peer changes", bench_usec_since (&start),
+                " %6lu.%03lu ms slice", slice / 1000, slice % 1000);
+
+  if (peer->input_pending || ! list_isempty (bm->input_peers)
+      || CHECK_FLAG (peer->sflags, PEER_STATUS_INPUT_HOLD))
+    {
+      printf ("%s: %lu nodes pending, %u peers waiting for dispatch%s\n",
+              peer->host, peer->input_pending, listcount (bm->input_peers),
+              CHECK_FLAG (peer->sflags, PEER_STATUS_INPUT_HOLD)
+              ? ", still held" : "");
+      errors++;
+    }
+  if (peer->pcount[AFI_IP][SAFI_UNICAST] != prefixes)
+    {
+      printf ("%s: %lu routes, %u expected\n", peer->host,
+              peer->pcount[AFI_IP][SAFI_UNICAST], prefixes);
+      errors++;
+    }
+
+  return bench_done (errors);
+}
@@ -0,0 +1,449 @@
+/*
+ * BGP route server benchmark: route server clients each announce a
+ * part of the prefixes, some with the AS of another client in their
+ * path, and are sent the best path for them.  This is done with a table
+ * for each client, and with the clients sharing a table, "bgp
+ * route-server shared-rib".  Reports the time to settle and the memory
+ * of the tables for both, and fails when a client is not sent the same
+ * path with both, anything of the clients is left once they are gone,
+ * or a client named by "match peer" in an export route-map shares a
+ * table.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "command.h"
+#include "vty.h"
+#include "stream.h"
+#include "linklist.h"
+#include "memory.h"
+#include "thread.h"
+#include "workqueue.h"
+#include "filter.h"
+#include "hash.h"
+#include "prng.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_aspath.h"
+#include "bgpd/bgp_advertise.h"
+#include "bgpd/bgp_fsm.h"
+#include "bgpd/bgp_rsview.h"
+#include "bgp-bench.h"
+
+#define LOCAL_AS	65000
+#define CLIENT_AS	64512
+
+/* Clients announcing each prefix */
+#define ANNOUNCERS	3
+
+static struct bgp *bgp;
+static struct prng *prng;
+
+static unsigned int nclients = 16;
+static unsigned int prefixes = 2000;
+static struct peer **clients;
+
+/* First AS of the path sent to each client for each prefix, with a
+ * table for each client and with shared tables */
+static as_t *sent[2];
+
+/* Route server client in state Established, without a connection */
+static struct peer *
+bench_client_new (unsigned int i)
+{
+  struct peer *peer;
+  char addr[32];
+
+  snprintf (addr, sizeof (addr), "10.1.%u.%u", i / 256, i % 256 + 1);
+  peer = bench_peer_new (bgp, addr, CLIENT_AS + i);
+  peer_lock (peer); /* bench reference */
+
+  /* As "neighbor route-server-client" does */
+  SET_FLAG (peer->af_flags[AFI_IP][SAFI_UNICAST], PEER_FLAG_RSERVER_CLIENT);
+  bgp_rsview_attach (peer, AFI_IP, SAFI_UNICAST);
+  return peer;
+}
+
+/* Besides the RIB, wait for the client going down, if any, to be down
+ * and for the clients, deleted ones too, to be cleared */
+static int
+bench_busy (void *arg)
+{
+  struct peer *down = arg;
+  unsigned int i;
+
+  if (down && down->status == Established)
+    return 1;
+  for (i = 0; i < nclients; i++)
+    if (clients[i] && (clients[i]->status == Clearing
+                       || (clients[i]->clear_node_queue
+                           && work_queue_is_scheduled
+                                (clients[i]->clear_node_queue))))
+      return 1;
+  return 0;
+}
+
+/* Routes 10.0.0.0/24, 10.0.1.0/24... each received from a few clients,
+ * one in four with the AS of another client in the path */
+static void
+bench_receive (void)
+{
+  struct aspath *aspath;
+  struct attr attr;
+  struct prefix p;
+  struct peer *peer;
+  unsigned int from[ANNOUNCERS];
+  char str[64];
+  unsigned int i, j, k;
+
+  memset (&p, 0, sizeof (p));
+  p.family = AF_INET;
+  p.prefixlen = 24;
+  for (i = 0; i < prefixes; i++)
+    for (j = 0; j < ANNOUNCERS; j++)
+      {
+        do
+          {
+            from[j] = prng_rand (prng) % nclients;
+            for (k = 0; k < j; k++)
+              if (from[k] == from[j])
+                break;
+          }
+        while (k < j);
+        peer = clients[from[j]];
+
+        if (prng_rand (prng) % 4 == 0)
+          snprintf (str, sizeof (str), "%u %u %u", peer->as,
+                    CLIENT_AS + prng_rand (prng) % nclients, 3356);
+        else
+          snprintf (str, sizeof (str), "%u %u", peer->as,
+                    64000 + prng_rand (prng) % 16);
+        aspath = aspath_intern (aspath_str2aspath (str));
+        bgp_attr_default_set (&attr, BGP_ORIGIN_IGP);
+        attr.aspath = aspath;
+        attr.nexthop = peer->su.sin.sin_addr;
+
+        p.u.prefix4.s_addr = htonl (0x0a000000 + (i << 8));
+        bgp_update (peer, &p, &attr, AFI_IP, SAFI_UNICAST, ZEBRA_ROUTE_BGP,
+                    BGP_ROUTE_NORMAL, NULL, NULL, 0);
+        bgp_attr_extra_free (&attr);
+        aspath_unintern (&aspath);
+      }
+}
+
+/* What was sent to each client, pending or not */
+static void
+bench_record (as_t *record)
+{
+  struct bgp_node *rn;
+  struct bgp_adj_out *adj;
+  struct attr *attr;
+  unsigned int i, n;
+
+  memset (record, 0, sizeof (as_t) * nclients * prefixes);
+  for (i = 0; i < nclients; i++)
+    for (rn = bgp_table_top (clients[i]->rib[AFI_IP][SAFI_UNICAST]); rn;
+         rn = bgp_route_next (rn))
+      for (adj = rn->adj_out; adj; adj = adj->next)
+        if (adj->peer == clients[i])
+          {
+            n = (ntohl (rn->p.u.prefix4.s_addr) - 0x0a000000) >> 8;
+            attr = adj->adv ? (adj->adv->baa ? adj->adv->baa->attr : NULL)
+                            : adj->attr;
+            if (attr && n < prefixes)
+              record[i * prefixes + n] = aspath_leftmost (attr->aspath);
+          }
+}
+
+/* Sent the path of another client, or nothing, when the two are
+ * different */
+static int
+bench_compare (void)
+{
+  unsigned int i, n, diffs = 0;
+
+  for (i = 0; i < nclients; i++)
+    for (n = 0; n < prefixes; n++)
+      if (sent[0][i * prefixes + n] != sent[1][i * prefixes + n])
+        {
+          if (diffs++ < 8)
+            printf ("client %u, prefix %u: sent the path from AS %u with a "
+                    "table each, AS %u shared\n", i, n,
+                    sent[0][i * prefixes + n], sent[1][i * prefixes + n]);
+        }
+  if (diffs)
+    printf ("%u paths sent differ\n", diffs);
+  return diffs != 0;
+}
+
+/* Memory of the tables of the clients, and of their deltas */
+static unsigned long
+bench_memory (const char *phase)
+{
+  struct bgp_node *rn;
+  struct bgp_info *ri;
+  struct peer *owner;
+  struct listnode *node;
+  unsigned long tables = 0, nodes = 0, paths = 0, deltas = 0, bytes;
+  unsigned int i;
+
+  for (ALL_LIST_ELEMENTS_RO (bgp->rsclient, node, owner))
+    {
+      tables++;
+      for (rn = bgp_table_top (owner->rib[AFI_IP][SAFI_UNICAST]); rn;
+           rn = bgp_route_next (rn))
+        {
+          nodes++;
+          for (ri = rn->info; ri; ri = ri->next)
+            paths++;
+        }
+      if (owner->group && owner->group->rsdelta)
+        deltas += owner->group->rsdelta->count;
+    }
+
+  bytes = nodes * sizeof (struct bgp_node) + paths * sizeof (struct bgp_info)
+          + deltas * sizeof (struct bgp_rsview_node);
+  for (i = 0; i < nclients; i++)
+    bytes += clients[i]->rsview_deltas[AFI_IP][SAFI_UNICAST]
+             * sizeof (struct bgp_rsview_delta);
+
+  printf ("%-36s %3lu tables %8lu nodes %8lu paths %6lu deltas "
+          "%8lu bytes/client\n", phase, tables, nodes, paths, deltas,
+          bytes / nclients);
+  return bytes;
+}
+
+static void
+report (const char *phase, unsigned long usec, unsigned long slice)
+{
+  bench_report (phase, usec, " %6lu.%03lu ms slice", slice / 1000,
+                slice % 1000);
+}
+
+/* Nothing of the client left in its table */
+static int
+bench_check_gone (struct peer *peer, struct bgp_table *table)
+{
+  struct bgp_node *rn;
+  struct bgp_info *ri;
+  struct bgp_adj_out *adj;
+  unsigned long routes = 0, adj_out = 0;
+
+  for (rn = bgp_table_top (table); rn; rn = bgp_route_next (rn))
+    {
+      for (ri = rn->info; ri; ri = ri->next)
+        if (ri->peer == peer)
+          routes++;
+      for (adj = rn->adj_out; adj; adj = adj->next)
+        if (adj->peer == peer)
+          adj_out++;
+    }
+  if (routes == 0 && adj_out == 0
+      && peer->rsview_deltas[AFI_IP][SAFI_UNICAST] == 0)
+    return 0;
+
+  printf ("%s: %lu routes, %lu adj-out, %lu deltas left\n", peer->host,
+          routes, adj_out, peer->rsview_deltas[AFI_IP][SAFI_UNICAST]);
+  return 1;
+}
+
+/* Load the clients, with a table each or shared, record what they are
+ * sent, take one down, and delete them all */
+static int
+bench_mode (const char *mode, int shared, unsigned int seed,
+            unsigned long *bytes)
+{
+  struct bgp_table *table;
+  struct timeval start;
+  unsigned long slice;
+  char phase[64];
+  unsigned int i;
+  int errors = 0;
+
+  if (shared)
+    bgp_flag_set (bgp, BGP_FLAG_RSERVER_SHARED);
+  else
+    bgp_flag_unset (bgp, BGP_FLAG_RSERVER_SHARED);
+
+  prng = prng_new (seed);
+  for (i = 0; i < nclients; i++)
+    clients[i] = bench_client_new (i);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  bench_receive ();
+  slice = bench_run (bgp, bench_busy, NULL);
+  snprintf (phase, sizeof (phase), "load, %s", mode);
+  report (phase, bench_usec_since (&start), slice);
+  *bytes = bench_memory (phase);
+  bench_record (sent[shared]);
+
+  /* A client goes down: its routes go from all the tables, and what was
+   * sent to it from its table */
+  table = clients[0]->rib[AFI_IP][SAFI_UNICAST];
+  bgp_table_lock (table);
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  BGP_EVENT_ADD (clients[0], BGP_Stop);
+  slice = bench_run (bgp, bench_busy, clients[0]);
+  BGP_TIMER_OFF (clients[0]->t_start);
+  snprintf (phase, sizeof (phase), "client down, %s", mode);
+  report (phase, bench_usec_since (&start), slice);
+  errors += bench_check_gone (clients[0], table);
+  errors += bench_check_gone (clients[0], bgp->rib[AFI_IP][SAFI_UNICAST]);
+  bgp_table_unlock (table);
+
+  /* All of them are deleted, with the tables */
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < nclients; i++)
+    peer_delete (clients[i]);
+  slice = bench_run (bgp, bench_busy, NULL);
+  snprintf (phase, sizeof (phase), "clients deleted, %s", mode);
+  report (phase, bench_usec_since (&start), slice);
+
+  for (i = 0; i < nclients; i++)
+    {
+      errors += bench_check_gone (clients[i], bgp->rib[AFI_IP][SAFI_UNICAST]);
+      peer_unlock (clients[i]); /* bench reference */
+      clients[i] = NULL;
+    }
+  if (! list_isempty (bgp->rsclient) || ! list_isempty (bgp->rsview)
+      || mtype_stats_alloc (MTYPE_BGP_RSVIEW_NODE))
+    {
+      printf ("%s: %u route server tables, %u views, %lu delta nodes left\n",
+              mode, listcount (bgp->rsclient), listcount (bgp->rsview),
+              mtype_stats_alloc (MTYPE_BGP_RSVIEW_NODE));
+      errors++;
+    }
+
+  prng_free (prng);
+  return errors;
+}
+
+/* Configuration line, as typed in the vty */
+static void
+bench_config (struct vty *vty, const char *line)
+{
+  vector vline = cmd_make_strvec (line);
+
+  if (cmd_execute_command (vline, vty, NULL, 0) != CMD_SUCCESS)
+    {
+      fprintf (stderr, "%s: failed\n", line);
+      exit (1);
+    }
+  cmd_free_strvec (vline);
+}
+
+/* Whether the client is on a shared view as expected */
+static int
+bench_check_view (const char *phase, struct peer *peer, int shared)
+{
+  if (! peer->rsview[AFI_IP][SAFI_UNICAST] == ! shared)
+    return 0;
+
+  printf ("%s: %s %s\n", phase, peer->host,
+          shared ? "has a table of its own" : "shares a table");
+  return 1;
+}
+
+/* The export route-map of a client names another with "match peer",
+ * which is moved to a table of its own while it does */
+static int
+bench_match_peer (void)
+{
+  struct vty *vty;
+  unsigned int i;
+  int errors = 0;
+
+  bgp_flag_set (bgp, BGP_FLAG_RSERVER_SHARED);
+  for (i = 0; i < ANNOUNCERS; i++)
+    clients[i] = bench_client_new (i);
+
+  /* Set before the route-map exists, which is then added to */
+  peer_route_map_set (clients[0], AFI_IP, SAFI_UNICAST, RMAP_EXPORT,
+                      "EXPORT");
+  vty_init_vtysh ();
+  vty = vty_new ();
+  vty->type = VTY_TERM;
+  vty->node = CONFIG_NODE;
+  bench_config (vty, "route-map EXPORT permit 10");
+  bench_config (vty, "match peer 10.1.0.2");
+  bench_run (bgp, bench_busy, NULL);
+  errors += bench_check_view ("match peer", clients[1], 0);
+  errors += bench_check_view ("match peer", clients[2], 1);
+
+  peer_route_map_unset (clients[0], AFI_IP, SAFI_UNICAST, RMAP_EXPORT);
+  bench_run (bgp, bench_busy, NULL);
+  errors += bench_check_view ("no match peer", clients[1], 1);
+  vty_close (vty);
+
+  for (i = 0; i < ANNOUNCERS; i++)
+    {
+      peer_delete (clients[i]);
+      peer_unlock (clients[i]); /* bench reference */
+      clients[i] = NULL;
+    }
+  bench_run (bgp, bench_busy, NULL);
+  return errors;
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned int seed = 0;
+  unsigned long own, shared;
+  as_t as = LOCAL_AS;
+  int errors = 0;
+  const struct bench_option options[] =
+  {
+    { 'c', "clients", &nclients },
+    { 'n', "prefixes", &prefixes },
+    { 's', "seed", &seed },
+    { 0, NULL, NULL }
+  };
+
+  bench_options (argc, argv, options);
+  if (nclients < ANNOUNCERS || nclients > 1000
+      || prefixes == 0 || prefixes > 0xffff)
+    bench_usage ();
+
+  bench_init ();
+  bgp_route_map_init ();
+  bgp_get (&bgp, &as, NULL);
+
+  clients = XCALLOC (MTYPE_TMP, sizeof (struct peer *) * nclients);
+  sent[0] = XCALLOC (MTYPE_TMP, sizeof (as_t) * nclients * prefixes);
+  sent[1] = XCALLOC (MTYPE_TMP, sizeof (as_t) * nclients * prefixes);
+  printf ("%u clients, %u prefixes\n", nclients, prefixes);
+
+  errors += bench_mode ("own tables", 0, seed, &own);
+  errors += bench_mode ("shared", 1, seed, &shared);
+  errors += bench_compare ();
+  errors += bench_match_peer ();
+  printf ("shared tables use %lu%% of the memory of a table each\n",
+          own ? shared * 100 / own : 0);
+
+  XFREE (MTYPE_TMP, sent[0]);
+  XFREE (MTYPE_TMP, sent[1]);
+  XFREE (MTYPE_TMP, clients);
+
+  return bench_done (errors);
+}
@@ -469,19 +469,98 @@ in_cksum_rfc(void *parg, int count)
 }
 
 
+#define MAXDATALEN_BENCH 60000
+
+/* Implementations of the lib Fletcher checksum */
+static const char *impls[] = { "generic", "word", "ssse3", "avx2", NULL };
+
+/* Each implementation must give the same checksum as the original
+ * ospfd one, whatever the length and alignment. */
+static int
+check_impls (u_char *buffer, testsz_t len, testoff_t off, u_int16_t ref)
+{
+  u_int16_t lib;
+  int i, ret = 0;
+
+  for (i = 0; impls[i] != NULL; i++)
+    {
+      if (fletcher_checksum_select (impls[i]) < 0)
+        continue;
+      lib = fletcher_checksum (buffer, len, off);
+      if (lib != ref || verify (buffer, len))
+        {
+          printf ("%s: mismatch at size %u, align %u: 0x%04x, expected "
+                  "0x%04x\n", impls[i], (unsigned) len,
+                  (unsigned) ((unsigned long) buffer % 32), lib, ref);
+          ret = 1;
+        }
+      if (fletcher_checksum (buffer, len, FLETCHER_CHECKSUM_VALIDATE) != 0)
+        {
+          printf ("%s: validation failed at size %u\n", impls[i],
+                  (unsigned) len);
+          ret = 1;
+        }
+    }
+  return ret;
+}
+
+/* Throughput on LSA / LSP sized buffers and on a large one */
+static void
+throughput (u_char *buffer)
+{
+  static const testsz_t sizes[] = { 64, 1492, MAXDATALEN_BENCH };
+  struct timeval start, end;
+  unsigned long usec, bytes;
+  unsigned int i, s, n;
+
+  for (i = 0; impls[i] != NULL; i++)
+    {
+      if (fletcher_checksum_select (impls[i]) < 0)
+        {
+          printf ("%-8s not supported\n", impls[i]);
+          continue;
+        }
+      printf ("%-8s", impls[i]);
+      for (s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+        {
+          bytes = 0;
+          gettimeofday (&start, NULL);
+          for (n = 0; bytes < 256 * 1024 * 1024; n++)
+            {
+              fletcher_checksum (buffer, sizes[s], FLETCHER_CHECKSUM_VALIDATE);
+              bytes += sizes[s];
+            }
+          gettimeofday (&end, NULL);
+          usec = (end.tv_sec - start.tv_sec) * 1000000
+                 + end.tv_usec - start.tv_usec;
+          printf (" %6u bytes: %6lu MB/s", (unsigned) sizes[s],
+                  usec ? bytes / usec : 0);
+        }
+      printf ("\n");
+    }
+}
+
+/* With an iteration count, also compare the implementations of the lib
+ * checksum on misaligned buffers, then report their throughput. Without,
+ * run until a mismatch. */
 int
 main(int argc, char **argv)
 {
 /* 60017 65629 702179 */
 #define MAXDATALEN 60017
 #define BUFSIZE MAXDATALEN + sizeof(u_int16_t)
-  u_char buffer[BUFSIZE];
+  u_char buffer[BUFSIZE + 32];
   int exercise = 0;
+  long iterations = 0, iter = 0;
+  int errors = 0;
 #define EXERCISESTEP 257
   
+  if (argc > 1)
+    iterations = atol (argv[1]);
+
   srandom (time (NULL));
   
-  while (1) {
+  while (iterations == 0 || iter++ < iterations) {
     u_int16_t ospfd, isisd, lib, in_csum, in_csum_res, in_csum_rfc;
     int i,j;
 
@@ -512,6 +591,16 @@ main(int argc, char **argv)
     lib = fletcher_checksum (buffer, exercise + sizeof(u_int16_t), exercise);
     if (verify (buffer, exercise + sizeof(u_int16_t)))
       printf ("verify: lib failed\n");
+
+    if (iterations)
+      {
+        int align = iter % 32;
+
+        memmove (buffer + align, buffer, exercise + sizeof(u_int16_t));
+        errors += check_impls (buffer + align, exercise + sizeof(u_int16_t),
+                               exercise, ospfd);
+        memmove (buffer, buffer + align, exercise + sizeof(u_int16_t));
+      }
     
     if (ospfd != lib) {
       printf ("Mismatch in values at size %u\n"
@@ -547,4 +636,8 @@ main(int argc, char **argv)
       exit (1);
     }
   }
+
+  throughput (buffer);
+  printf ("%s\n", errors ? "failed" : "OK");
+  return errors != 0;
 }
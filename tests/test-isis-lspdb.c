@@ -0,0 +1,249 @@
+/*
+ * IS-IS LSP database test: check the B+tree against a sorted array of
+ * LSP IDs through insertions and deletions, and time the walk which
+ * builds the CSNPs describing a 50000 fragment database.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "stream.h"
+#include "thread.h"
+#include "prng.h"
+
+#include "isisd/isis_constants.h"
+#include "isisd/isis_lspdb.h"
+
+struct thread_master *master;
+
+#define SYSTEMS		2000
+#define FRAGMENTS	25	/* 50000 LSPs */
+#define CSNP_ROUNDS	100
+
+/* LSP entries fitting in a CSNP on a 1497 byte MTU circuit */
+#define CSNP_ENTRIES	90
+
+/* The LSPDB only handles pointers, an LSP ID is enough here */
+struct isis_lsp
+{
+  u_char lsp_id[ISIS_SYS_ID_LEN + 2];
+  u_int16_t rem_lifetime;
+  u_int32_t seq_num;
+  u_int16_t checksum;
+};
+
+static struct isis_lsp lsps[SYSTEMS * FRAGMENTS];
+static int present[SYSTEMS * FRAGMENTS];
+static int errors;
+
+static int
+lsp_cmp (const void *a, const void *b)
+{
+  return memcmp (((const struct isis_lsp *) a)->lsp_id,
+                 ((const struct isis_lsp *) b)->lsp_id, ISIS_SYS_ID_LEN + 2);
+}
+
+/* Walk the database and compare it with the present LSPs, in order. */
+static void
+check (struct lspdb *db, const char *what)
+{
+  struct lspdb_cursor cur;
+  struct isis_lsp *lsp;
+  unsigned long count = 0;
+  int i = 0;
+
+  LSPDB_FOREACH (db, cur, lsp)
+    {
+      while (i < SYSTEMS * FRAGMENTS && !present[i])
+        i++;
+      if (lsp != &lsps[i++])
+        {
+          printf ("%s: walk out of order\n", what);
+          errors++;
+          return;
+        }
+      count++;
+    }
+
+  for (i = 0; i < SYSTEMS * FRAGMENTS; i++)
+    if ((lspdb_lookup (db, lsps[i].lsp_id) == &lsps[i]) != present[i])
+      {
+        printf ("%s: lookup failed\n", what);
+        errors++;
+        return;
+      }
+
+  if (count != lspdb_count (db))
+    {
+      printf ("%s: %lu LSPs walked, %lu counted\n", what, count,
+              lspdb_count (db));
+      errors++;
+    }
+}
+
+/* Describe the whole database in CSNPs, as build_csnp() does. */
+static unsigned long
+build_csnps (struct lspdb *db, struct stream *s)
+{
+  struct lspdb_cursor cur;
+  struct isis_lsp *lsp;
+  u_char start[ISIS_SYS_ID_LEN + 2];
+  unsigned long csnps = 0;
+  int count, i;
+
+  memset (start, 0x00, ISIS_SYS_ID_LEN + 2);
+  for (;;)
+    {
+      stream_reset (s);
+      count = 0;
+      for (lsp = lspdb_seek (db, start, &cur);
+           lsp && count < CSNP_ENTRIES; lsp = lspdb_next (&cur))
+        {
+          stream_putw (s, lsp->rem_lifetime);
+          stream_put (s, lsp->lsp_id, ISIS_SYS_ID_LEN + 2);
+          stream_putl (s, lsp->seq_num);
+          stream_putw (s, lsp->checksum);
+          count++;
+        }
+      csnps++;
+      if (lsp == NULL)
+        break;
+
+      /* The next CSNP starts right after the last LSP ID described */
+      memcpy (start, s->data + stream_get_endp (s) - 14,
+              ISIS_SYS_ID_LEN + 2);
+      for (i = ISIS_SYS_ID_LEN + 1; i >= 0 && ++start[i] == 0; i--)
+        ;
+    }
+  return csnps;
+}
+
+int
+main (void)
+{
+  struct prng *prng;
+  struct lspdb *db;
+  struct stream *s;
+  struct timeval start, lap, end;
+  unsigned long usec, csnps = 0;
+  int i, j, n;
+
+  prng = prng_new (0);
+  s = stream_new (CSNP_ENTRIES * 16);
+
+  n = 0;
+  for (i = 0; i < SYSTEMS; i++)
+    {
+      u_int32_t sysid = prng_rand (prng);
+
+      for (j = 0; j < FRAGMENTS; j++, n++)
+        {
+          memcpy (&lsps[n].lsp_id[0], &sysid, sizeof (sysid));
+          lsps[n].lsp_id[4] = i >> 8;
+          lsps[n].lsp_id[5] = i;
+          lsps[n].lsp_id[ISIS_SYS_ID_LEN] = j % 5 ? 0 : j;
+          lsps[n].lsp_id[ISIS_SYS_ID_LEN + 1] = j;
+          lsps[n].rem_lifetime = htons (1200);
+          lsps[n].seq_num = htonl (prng_rand (prng));
+          lsps[n].checksum = prng_rand (prng);
+        }
+    }
+  qsort (lsps, n, sizeof (lsps[0]), lsp_cmp);
+
+  db = lspdb_new ();
+
+  /* Insert in random order */
+  gettimeofday (&start, NULL);
+  for (i = 0; i < n; i++)
+    {
+      j = prng_rand (prng) % n;
+      if (!present[j])
+        {
+          lspdb_insert (db, lsps[j].lsp_id, &lsps[j]);
+          present[j] = 1;
+        }
+    }
+  for (i = 0; i < n; i++)
+    if (!present[i])
+      {
+        lspdb_insert (db, lsps[i].lsp_id, &lsps[i]);
+        present[i] = 1;
+      }
+  gettimeofday (&lap, NULL);
+  usec = (lap.tv_sec - start.tv_sec) * 1000000 + lap.tv_usec - start.tv_usec;
+  check (db, "insert");
+  printf ("inserted %lu LSPs\n", lspdb_count (db));
+  fprintf (stderr, "insertion: %lu usec\n", usec);
+
+  /* CSNPs */
+  gettimeofday (&start, NULL);
+  for (i = 0; i < CSNP_ROUNDS; i++)
+    csnps = build_csnps (db, s);
+  gettimeofday (&end, NULL);
+  usec = (end.tv_sec - start.tv_sec) * 1000000 + end.tv_usec - start.tv_usec;
+  if (csnps != (unsigned long) (n + CSNP_ENTRIES - 1) / CSNP_ENTRIES)
+    {
+      printf ("%lu CSNPs built\n", csnps);
+      errors++;
+    }
+  printf ("%lu CSNPs per round\n", csnps);
+  fprintf (stderr, "%d rounds of CSNPs: %lu usec, %lu usec per round\n",
+           CSNP_ROUNDS, usec, usec / CSNP_ROUNDS);
+
+  /* Delete LSPs while walking, then a random half of the rest */
+  {
+    struct lspdb_cursor cur;
+    struct isis_lsp *lsp;
+
+    LSPDB_FOREACH (db, cur, lsp)
+      if (lsp->lsp_id[ISIS_SYS_ID_LEN + 1] % 3 == 0)
+        {
+          lspdb_delete (db, lsp->lsp_id);
+          present[lsp - lsps] = 0;
+        }
+  }
+  check (db, "walk and delete");
+  for (i = 0; i < n; i++)
+    if (present[i] && prng_rand (prng) % 2)
+      {
+        if (lspdb_delete (db, lsps[i].lsp_id) != &lsps[i])
+          errors++;
+        present[i] = 0;
+      }
+  check (db, "delete");
+  printf ("%lu LSPs left\n", lspdb_count (db));
+
+  /* Empty the database */
+  for (i = 0; i < n; i++)
+    if (present[i])
+      {
+        lspdb_delete (db, lsps[i].lsp_id);
+        present[i] = 0;
+      }
+  check (db, "empty");
+  if (lspdb_count (db) != 0 || build_csnps (db, s) != 1)
+    errors++;
+
+  lspdb_free (db);
+  stream_free (s);
+  prng_free (prng);
+
+  printf ("errors: %d\n%s\n", errors, errors ? "failed" : "OK");
+  return errors != 0;
+}
@@ -0,0 +1,802 @@
+/*
+ * IS-IS SPF benchmark: generate a grid, Clos or random power-law
+ * topology, receive the LSPs of all its systems in both levels of an
+ * area, then time the SPF and route calculation of both levels and
+ * address families from one of the systems. Reports the time, the
+ * allocations and the peak memory of each phase, and fails when a
+ * prefix of the topology is not reached.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+#include <sys/resource.h>
+
+#include "memory.h"
+#include "thread.h"
+#include "linklist.h"
+#include "stream.h"
+#include "prefix.h"
+#include "table.h"
+#include "if.h"
+#include "vty.h"
+#include "hash.h"
+#include "checksum.h"
+#include "privs.h"
+#include "zclient.h"
+#include "vector.h"
+#include "ted.h"
+#include "prng.h"
+
+#include "isisd/isis_lspdb.h"
+#include "isisd/isis_constants.h"
+#include "isisd/isis_common.h"
+#include "isisd/isis_flags.h"
+#include "isisd/isis_circuit.h"
+#include "isisd/isis_csm.h"
+#include "isisd/isisd.h"
+#include "isisd/isis_tlv.h"
+#include "isisd/isis_lsp.h"
+#include "isisd/isis_pdu.h"
+#include "isisd/isis_adjacency.h"
+#include "isisd/isis_misc.h"
+#include "isisd/isis_spf.h"
+#include "isisd/isis_route.h"
+#include "isisd/isis_network.h"
+#include "isisd/isis_ted.h"
+#include "isisd/isis_zebra.h"
+
+struct thread_master *master;
+struct zebra_privs_t isisd_privs;
+
+/* No PDU is sent nor received, the circuits only hold adjacencies */
+u_char ALL_L1_ISYSTEMS[6] = { 0x01, 0x80, 0xC2, 0x00, 0x00, 0x14 };
+u_char ALL_L2_ISYSTEMS[6] = { 0x01, 0x80, 0xC2, 0x00, 0x00, 0x15 };
+
+int
+isis_sock_init (struct isis_circuit *circuit)
+{
+  return ISIS_OK;
+}
+
+int
+isis_recv_pdu_bcast (struct isis_circuit *circuit, u_char * ssnpa)
+{
+  return ISIS_WARNING;
+}
+
+int
+isis_recv_pdu_p2p (struct isis_circuit *circuit, u_char * ssnpa)
+{
+  return ISIS_WARNING;
+}
+
+int
+isis_send_pdu_bcast (struct isis_circuit *circuit, int level)
+{
+  return ISIS_OK;
+}
+
+int
+isis_send_pdu_p2p (struct isis_circuit *circuit, int level)
+{
+  return ISIS_OK;
+}
+
+#define TOPO_GRID	0
+#define TOPO_CLOS	1
+#define TOPO_POWERLAW	2
+
+static const char *topo_names[] = { "grid", "clos", "powerlaw" };
+
+/* Clos: pods of leaves and spines, under planes of super spines */
+#define POD_LEAVES	16
+#define POD_SPINES	4
+#define SUPER_SPINES	16
+
+/* Power-law: links of each new system, by preferential attachment */
+#define POWERLAW_LINKS	2
+
+struct node
+{
+  u_int32_t *nbrs;
+  u_int32_t *metrics;
+  unsigned int count, size;
+};
+
+static struct node *nodes;
+static unsigned int node_count;
+static unsigned int link_count;
+static struct prng *prng;
+
+static void
+link_add1 (u_int32_t a, u_int32_t b, u_int32_t metric)
+{
+  struct node *n = &nodes[a];
+
+  if (n->count == n->size)
+    {
+      n->size = n->size ? n->size * 2 : 4;
+      n->nbrs = realloc (n->nbrs, n->size * sizeof (u_int32_t));
+      n->metrics = realloc (n->metrics, n->size * sizeof (u_int32_t));
+    }
+  n->nbrs[n->count] = b;
+  n->metrics[n->count++] = metric;
+}
+
+static void
+link_add (u_int32_t a, u_int32_t b, u_int32_t metric)
+{
+  link_add1 (a, b, metric);
+  link_add1 (b, a, metric);
+  link_count++;
+}
+
+static void
+topo_grid (void)
+{
+  unsigned int side, i;
+
+  for (side = 1; side * side < node_count; side++)
+    ;
+  for (i = 0; i < node_count; i++)
+    {
+      if ((i % side) + 1 < side && i + 1 < node_count)
+        link_add (i, i + 1, 10);
+      if (i + side < node_count)
+        link_add (i, i + side, 10);
+    }
+}
+
+/*
+ * Leaves come first, so that the system computing is one of them. The
+ * spine j of each pod links to the super spines of plane j.
+ */
+static int
+topo_clos (void)
+{
+  unsigned int pods, leaves, spines, supers, pod, i, j, s;
+
+  if (node_count < POD_LEAVES + POD_SPINES + POD_SPINES)
+    return -1;
+
+  pods = (node_count - SUPER_SPINES) / (POD_LEAVES + POD_SPINES);
+  if (pods == 0)
+    pods = 1;
+  leaves = pods * POD_LEAVES;
+  spines = pods * POD_SPINES;
+  supers = node_count - leaves - spines;
+
+  for (pod = 0; pod < pods; pod++)
+    for (i = 0; i < POD_LEAVES; i++)
+      for (j = 0; j < POD_SPINES; j++)
+        link_add (pod * POD_LEAVES + i, leaves + pod * POD_SPINES + j, 10);
+
+  for (pod = 0; pod < pods; pod++)
+    for (j = 0; j < POD_SPINES; j++)
+      for (s = j; s < supers; s += POD_SPINES)
+        link_add (leaves + pod * POD_SPINES + j, leaves + spines + s, 10);
+
+  return 0;
+}
+
+/* Barabasi-Albert: pick the ends of existing links, so by degree */
+static void
+topo_powerlaw (void)
+{
+  u_int32_t *ends, a;
+  unsigned int n_ends = 0, i, j, k;
+
+  ends = calloc (2 * POWERLAW_LINKS * node_count + 2, sizeof (u_int32_t));
+
+  for (i = 1; i < node_count && i <= POWERLAW_LINKS; i++)
+    for (j = 0; j < i; j++)
+      {
+        link_add (i, j, 1 + prng_rand (prng) % 63);
+        ends[n_ends++] = i;
+        ends[n_ends++] = j;
+      }
+
+  for (; i < node_count; i++)
+    for (k = 0; k < POWERLAW_LINKS; k++)
+      {
+        a = ends[prng_rand (prng) % n_ends];
+        for (j = 0; j < nodes[i].count; j++)
+          if (nodes[i].nbrs[j] == a)
+            break;
+        if (j < nodes[i].count)
+          continue;
+        link_add (i, a, 1 + prng_rand (prng) % 63);
+        ends[n_ends++] = a;
+        ends[n_ends++] = i;
+      }
+
+  free (ends);
+}
+
+/*
+ * LSP generation: the TLVs of a system go into fragments of the area
+ * LSP MTU, as isisd would build them.
+ */
+struct gen_lsp
+{
+  struct isis_area *area;
+  int level;
+  u_int32_t node;
+  int frags;
+  struct stream *s;
+  size_t tlv;			/* offset of the TLV being filled, or 0 */
+};
+
+static struct stream **pdus[ISIS_LEVELS];
+static unsigned int pdu_count[ISIS_LEVELS];
+static unsigned int pdu_size[ISIS_LEVELS];
+
+static void
+node_sysid (u_int32_t node, u_char *sysid)
+{
+  sysid[0] = 0x19;
+  sysid[1] = 0x21;
+  sysid[2] = 0x68;
+  sysid[3] = node >> 16;
+  sysid[4] = node >> 8;
+  sysid[5] = node;
+}
+
+static void
+gen_frag_new (struct gen_lsp *g)
+{
+  struct isis_fixed_hdr hdr;
+  struct stream *s;
+  u_char lsp_id[ISIS_SYS_ID_LEN + 2];
+  int l = g->level - 1;
+
+  s = stream_new (g->area->lsp_mtu);
+  fill_fixed_hdr (&hdr, g->level == IS_LEVEL_1 ? L1_LINK_STATE
+                                               : L2_LINK_STATE);
+  stream_put (s, &hdr, ISIS_FIXED_HDR_LEN);
+
+  node_sysid (g->node, lsp_id);
+  LSP_PSEUDO_ID (lsp_id) = 0;
+  LSP_FRAGMENT (lsp_id) = g->frags++;
+  stream_putw (s, 0);		/* PDU length, when complete */
+  stream_putw (s, MAX_AGE - 1);
+  stream_put (s, lsp_id, ISIS_SYS_ID_LEN + 2);
+  stream_putl (s, 1);
+  stream_putw (s, 0);		/* checksum */
+  stream_putc (s, IS_LEVEL_1_AND_2);
+
+  if (pdu_count[l] == pdu_size[l])
+    {
+      pdu_size[l] = pdu_size[l] ? pdu_size[l] * 2 : 1024;
+      pdus[l] = realloc (pdus[l], pdu_size[l] * sizeof (struct stream *));
+    }
+  pdus[l][pdu_count[l]++] = s;
+  g->s = s;
+  g->tlv = 0;
+}
+
+/* Append an entry to a TLV of type, in a new TLV or fragment if full */
+static void
+gen_put (struct gen_lsp *g, u_char type, const void *entry, size_t len)
+{
+  struct stream *s = g->s;
+
+  if (g->tlv == 0 || stream_getc_from (s, g->tlv) != type
+      || stream_getc_from (s, g->tlv + 1) + len > 255
+      || STREAM_WRITEABLE (s) < len)
+    {
+      if (STREAM_WRITEABLE (s) < len + 2)
+        {
+          gen_frag_new (g);
+          s = g->s;
+        }
+      g->tlv = stream_get_endp (s);
+      stream_putc (s, type);
+      stream_putc (s, 0);
+    }
+
+  stream_put (s, entry, len);
+  stream_putc_at (s, g->tlv + 1, stream_getc_from (s, g->tlv + 1) + len);
+}
+
+static void
+gen_lsp (struct isis_area *area, int level, u_int32_t node,
+         unsigned int prefixes)
+{
+  struct gen_lsp g;
+  struct node *n = &nodes[node];
+  unsigned int first = pdu_count[level - 1], i;
+  u_char buf[32];
+  char name[32];
+  u_int32_t addr;
+  struct stream *s;
+
+  memset (&g, 0, sizeof (struct gen_lsp));
+  g.area = area;
+  g.level = level;
+  g.node = node;
+  gen_frag_new (&g);
+
+  /* Area 49.0001 */
+  buf[0] = 3;
+  buf[1] = 0x49;
+  buf[2] = 0x00;
+  buf[3] = 0x01;
+  gen_put (&g, AREA_ADDRESSES, buf, 4);
+  buf[0] = NLPID_IP;
+  buf[1] = NLPID_IPV6;
+  gen_put (&g, PROTOCOLS_SUPPORTED, buf, 2);
+  snprintf (name, sizeof (name), "node%u", node);
+  gen_put (&g, DYNAMIC_HOSTNAME, name, strlen (name));
+
+  /* Loopback 10.0.0.0/8 + node, also the TE Router ID */
+  addr = htonl (0x0a000000 | node);
+  gen_put (&g, TE_ROUTER_ID, &addr, 4);
+  gen_put (&g, IPV4_ADDR, &addr, 4);
+
+  for (i = 0; i < n->count; i++)
+    {
+      node_sysid (n->nbrs[i], buf);
+      buf[ISIS_SYS_ID_LEN] = 0;
+      buf[ISIS_SYS_ID_LEN + 1] = n->metrics[i] >> 16;
+      buf[ISIS_SYS_ID_LEN + 2] = n->metrics[i] >> 8;
+      buf[ISIS_SYS_ID_LEN + 3] = n->metrics[i];
+      buf[ISIS_SYS_ID_LEN + 4] = 0;	/* no sub-TLV */
+      gen_put (&g, TE_IS_NEIGHBOURS, buf, ISIS_SYS_ID_LEN + 5);
+    }
+
+  /* The loopback, then /24s from 11.0.0.0 */
+  for (i = 0; i <= prefixes; i++)
+    {
+      u_int32_t metric = htonl (i ? 10 : 0);
+
+      memcpy (buf, &metric, 4);
+      if (i == 0)
+        {
+          buf[4] = 32;
+          memcpy (buf + 5, &addr, 4);
+          gen_put (&g, TE_IPV4_REACHABILITY, buf, 9);
+        }
+      else
+        {
+          u_int32_t p = 0x0b000000 + ((node * prefixes + i - 1) << 8);
+
+          buf[4] = 24;
+          buf[5] = p >> 24;
+          buf[6] = p >> 16;
+          buf[7] = p >> 8;
+          gen_put (&g, TE_IPV4_REACHABILITY, buf, 8);
+        }
+    }
+
+  /* 2001:db8::node/128, then 2001:db8:nnnn:nni::/64 */
+  for (i = 0; i <= prefixes; i++)
+    {
+      u_int32_t metric = htonl (i ? 10 : 0);
+
+      memcpy (buf, &metric, 4);
+      buf[4] = 0;
+      memset (buf + 6, 0, 16);
+      buf[6] = 0x20;
+      buf[7] = 0x01;
+      buf[8] = 0x0d;
+      buf[9] = 0xb8;
+      if (i == 0)
+        {
+          buf[5] = 128;
+          buf[18] = node >> 24;
+          buf[19] = node >> 16;
+          buf[20] = node >> 8;
+          buf[21] = node;
+          gen_put (&g, IPV6_REACHABILITY, buf, 22);
+        }
+      else
+        {
+          buf[5] = 64;
+          buf[10] = node >> 16;
+          buf[11] = node >> 8;
+          buf[12] = node;
+          buf[13] = i;
+          gen_put (&g, IPV6_REACHABILITY, buf, 14);
+        }
+    }
+
+  for (i = first; i < pdu_count[level - 1]; i++)
+    {
+      s = pdus[level - 1][i];
+      stream_putw_at (s, ISIS_FIXED_HDR_LEN, stream_get_endp (s));
+      fletcher_checksum (STREAM_DATA (s) + 12, stream_get_endp (s) - 12, 12);
+    }
+}
+
+/* As process_lsp() does for an LSP new to the database */
+static int
+receive_lsps (struct isis_area *area, int level)
+{
+  struct isis_link_state_hdr *hdr;
+  struct isis_lsp *lsp, *lsp0 = NULL;
+  struct stream *s;
+  unsigned int i;
+
+  for (i = 0; i < pdu_count[level - 1]; i++)
+    {
+      s = pdus[level - 1][i];
+      hdr = (struct isis_link_state_hdr *) (STREAM_DATA (s)
+                                            + ISIS_FIXED_HDR_LEN);
+      /* Not iso_csum_verify (), which wants the address of the packed
+         checksum field */
+      if (fletcher_checksum (STREAM_DATA (s) + 12, ntohs (hdr->pdu_len) - 12,
+                             FLETCHER_CHECKSUM_VALIDATE) != 0)
+        {
+          printf ("LSP %s: bad checksum\n", rawlspid_print (hdr->lsp_id));
+          return -1;
+        }
+      if (LSP_FRAGMENT (hdr->lsp_id) == 0)
+        lsp0 = NULL;
+      lsp = lsp_new_from_stream_ptr (s, ntohs (hdr->pdu_len), lsp0, area,
+                                     level);
+      lsp_insert (lsp, area->lspdb[level - 1]);
+      if (lsp0 == NULL)
+        lsp0 = lsp;
+    }
+  return 0;
+}
+
+/* Point-to-point circuits to the neighbours of the computing system */
+static void
+local_circuits (struct isis_area *area)
+{
+  struct node *n = &nodes[0];
+  struct isis_circuit *circuit;
+  struct isis_adjacency *adj;
+  struct interface *ifp;
+  struct prefix_ipv4 *ipv4;
+  struct in_addr *nh;
+  struct in6_addr *nh6;
+  u_char sysid[ISIS_SYS_ID_LEN];
+  unsigned int i;
+
+  for (i = 0; i < n->count; i++)
+    {
+      ifp = XCALLOC (MTYPE_TMP, sizeof (struct interface));
+      snprintf (ifp->name, sizeof (ifp->name), "bench%u", i);
+      ifp->ifindex = i + 1;
+      ifp->mtu = 1500;
+
+      circuit = isis_circuit_new ();
+      circuit->interface = ifp;
+      circuit->area = area;
+      circuit->state = C_STATE_UP;
+      circuit->circ_type = CIRCUIT_T_P2P;
+      circuit->circuit_id = i + 1;
+      circuit->te_metric[0] = circuit->te_metric[1] = n->metrics[i];
+      circuit->ip_router = 1;
+      circuit->ipv6_router = 1;
+      circuit->ip_addrs = list_new ();
+      circuit->ipv6_link = list_new ();
+      circuit->ipv6_non_link = list_new ();
+
+      /* 198.18.0.0/15, a /31 per circuit */
+      ipv4 = prefix_ipv4_new ();
+      ipv4->prefix.s_addr = htonl (0xc6120000 | (i << 1));
+      ipv4->prefixlen = 31;
+      listnode_add (circuit->ip_addrs, ipv4);
+
+      node_sysid (n->nbrs[i], sysid);
+      adj = isis_new_adj (sysid, NULL, IS_LEVEL_1_AND_2, circuit);
+      adj->adj_state = ISIS_ADJ_UP;
+      adj->sys_type = ISIS_SYSTYPE_L2_IS;
+      adj->nlpids.count = 2;
+      adj->nlpids.nlpids[0] = NLPID_IP;
+      adj->nlpids.nlpids[1] = NLPID_IPV6;
+      adj->ipv4_addrs = list_new ();
+      nh = XCALLOC (MTYPE_ISIS_TMP, sizeof (struct in_addr));
+      nh->s_addr = htonl (0xc6120000 | (i << 1) | 1);
+      listnode_add (adj->ipv4_addrs, nh);
+      adj->ipv6_addrs = list_new ();
+      nh6 = XCALLOC (MTYPE_ISIS_TMP, sizeof (struct in6_addr));
+      nh6->s6_addr[0] = 0xfe;
+      nh6->s6_addr[1] = 0x80;
+      nh6->s6_addr[14] = i >> 8;
+      nh6->s6_addr[15] = i;
+      listnode_add (adj->ipv6_addrs, nh6);
+      circuit->u.p2p.neighbor = adj;
+
+      listnode_add (area->circuit_list, circuit);
+      area->ip_circuits++;
+      area->ipv6_circuits++;
+    }
+}
+
+static unsigned long
+active_routes (struct route_table *table)
+{
+  struct route_node *rn;
+  struct isis_route_info *rinfo;
+  unsigned long count = 0;
+
+  for (rn = route_top (table); rn; rn = route_next (rn))
+    if ((rinfo = rn->info) != NULL
+        && CHECK_FLAG (rinfo->flag, ISIS_ROUTE_FLAG_ACTIVE))
+      count++;
+  return count;
+}
+
+static int
+check_routes (struct isis_area *area, int level, int family,
+              unsigned long expected)
+{
+  struct route_table *table;
+  unsigned long routes;
+
+  if (family == AF_INET)
+    table = area->route_table[level - 1];
+  else
+    table = area->route_table6[level - 1];
+
+  routes = active_routes (table);
+  if (routes == expected)
+    return 0;
+
+  printf ("L%d %s: %lu routes, %lu expected\n", level,
+          family == AF_INET ? "IPv4" : "IPv6", routes, expected);
+  return 1;
+}
+
+/* Objects allocated through the memory types */
+static long
+allocations (void)
+{
+  struct mlist *ml;
+  struct memory_list *m;
+  long count = 0;
+
+  for (ml = mlists; ml->list; ml++)
+    for (m = ml->list; m->index >= 0; m++)
+      if (m->index)
+        count += mtype_stats_alloc (m->index);
+  return count;
+}
+
+static long
+peak_kbytes (void)
+{
+  struct rusage ru;
+
+  getrusage (RUSAGE_SELF, &ru);
+  return ru.ru_maxrss;
+}
+
+static unsigned long
+usec_since (struct timeval *start)
+{
+  struct timeval now;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) * 1000000
+         + now.tv_usec - start->tv_usec;
+}
+
+static void
+report (const char *phase, unsigned long usec, long allocs)
+{
+  printf ("%-32s %8lu.%03lu ms %+10ld allocations %8ld KB peak\n", phase,
+          usec / 1000, usec % 1000, allocs, peak_kbytes ());
+}
+
+static void
+usage (const char *progname)
+{
+  fprintf (stderr, "usage: %s [-t grid|clos|powerlaw] [-n systems] "
+           "[-p prefixes] [-r runs] [-s seed]\n", progname);
+  exit (1);
+}
+
+int
+main (int argc, char **argv)
+{
+  struct isis_area *area;
+  struct isis_spftree *spftree;
+  struct timeval start;
+  unsigned long usec, full, prc, worst, expected;
+  unsigned int prefixes = 4, runs = 10, seed = 0, i;
+  int topo = TOPO_GRID, level, family, errors = 0, opt;
+  long allocs;
+  char phase[64];
+
+  node_count = 1000;
+  while ((opt = getopt (argc, argv, "t:n:p:r:s:")) != -1)
+    switch (opt)
+      {
+      case 't':
+        for (topo = 0; topo <= TOPO_POWERLAW; topo++)
+          if (strcmp (optarg, topo_names[topo]) == 0)
+            break;
+        if (topo > TOPO_POWERLAW)
+          usage (argv[0]);
+        break;
+      case 'n':
+        node_count = strtoul (optarg, NULL, 10);
+        break;
+      case 'p':
+        prefixes = strtoul (optarg, NULL, 10);
+        break;
+      case 'r':
+        runs = strtoul (optarg, NULL, 10);
+        break;
+      case 's':
+        seed = strtoul (optarg, NULL, 10);
+        break;
+      default:
+        usage (argv[0]);
+      }
+  if (node_count < 2 || node_count > 0xffffff || runs == 0
+      || prefixes > 0xff)
+    usage (argv[0]);
+
+  master = thread_master_create ();
+  prng = prng_new (seed);
+  zclient = zclient_new (master);
+  zclient->sock = -1;
+  isis_new (0);
+  isis_ted_init ();
+
+  /* Topology */
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  nodes = calloc (node_count, sizeof (struct node));
+  if (topo == TOPO_GRID)
+    topo_grid ();
+  else if (topo == TOPO_CLOS && topo_clos () < 0)
+    {
+      fprintf (stderr, "clos needs %d systems at least\n",
+               POD_LEAVES + POD_SPINES + POD_SPINES);
+      return 1;
+    }
+  else if (topo == TOPO_POWERLAW)
+    topo_powerlaw ();
+  printf ("%s topology: %u systems, %u links, %u prefixes per system\n",
+          topo_names[topo], node_count, link_count, prefixes);
+
+  node_sysid (0, isis->sysid);
+  isis->sysid_set = 1;
+  area = isis_area_create ("bench");
+  local_circuits (area);
+
+  allocs = allocations ();
+  for (level = IS_LEVEL_1; level <= IS_LEVEL_2; level++)
+    for (i = 0; i < node_count; i++)
+      gen_lsp (area, level, i, prefixes);
+  report ("LSP generation", usec_since (&start), allocations () - allocs);
+
+  /* LSP reception, the SPF runs being held as they would be scheduled */
+  for (level = 0; level < ISIS_LEVELS; level++)
+    {
+      area->spftree[level]->pending = 1;
+      area->spftree6[level]->pending = 1;
+    }
+  for (level = IS_LEVEL_1; level <= IS_LEVEL_2; level++)
+    {
+      allocs = allocations ();
+      quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+      if (receive_lsps (area, level) < 0)
+        return 1;
+      usec = usec_since (&start);
+      snprintf (phase, sizeof (phase), "L%d receive %u LSPs", level,
+                pdu_count[level - 1]);
+      report (phase, usec, allocations () - allocs);
+    }
+
+  /* SPF and routes, the first run allocating the tree and routes */
+  expected = (node_count - 1) * (prefixes + 1);
+  for (level = IS_LEVEL_1; level <= IS_LEVEL_2; level++)
+    {
+      for (family = AF_INET; family;
+           family = (family == AF_INET ? AF_INET6 : 0))
+        {
+          if (family == AF_INET)
+            spftree = area->spftree[level - 1];
+          else
+            spftree = area->spftree6[level - 1];
+          spftree->pending = 0;
+
+          allocs = allocations ();
+          quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+          spftree->full = 1;
+          isis_run_spf (area, level, family, isis->sysid);
+          usec = usec_since (&start);
+          snprintf (phase, sizeof (phase), "L%d %s first SPF", level,
+                    family == AF_INET ? "IPv4" : "IPv6");
+          report (phase, usec, allocations () - allocs);
+
+          allocs = allocations ();
+          full = worst = 0;
+          for (i = 0; i < runs; i++)
+            {
+              quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+              spftree->full = 1;
+              isis_run_spf (area, level, family, isis->sysid);
+              usec = usec_since (&start);
+              full += usec;
+              if (usec > worst)
+                worst = usec;
+            }
+          snprintf (phase, sizeof (phase), "L%d %s SPF (max %lu.%03lu)",
+                    level, family == AF_INET ? "IPv4" : "IPv6",
+                    worst / 1000, worst % 1000);
+          report (phase, full / runs, allocations () - allocs);
+
+          allocs = allocations ();
+          prc = 0;
+          for (i = 0; i < runs; i++)
+            {
+              quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+              isis_run_spf (area, level, family, isis->sysid);
+              prc += usec_since (&start);
+            }
+          snprintf (phase, sizeof (phase), "L%d %s partial route calc.",
+                    level, family == AF_INET ? "IPv4" : "IPv6");
+          report (phase, prc / runs, allocations () - allocs);
+
+          errors += check_routes (area, level, family, expected);
+        }
+
+      /* Both families, the topology being computed once */
+      allocs = allocations ();
+      full = worst = 0;
+      for (i = 0; i < runs; i++)
+        {
+          quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+          area->spftree[level - 1]->full = 1;
+          area->spftree6[level - 1]->full = 1;
+          isis_run_spf_families (area, level, ISIS_SPF_IPV4 | ISIS_SPF_IPV6,
+                                 isis->sysid);
+          usec = usec_since (&start);
+          full += usec;
+          if (usec > worst)
+            worst = usec;
+        }
+      snprintf (phase, sizeof (phase), "L%d IPv4+IPv6 SPF (max %lu.%03lu)",
+                level, worst / 1000, worst % 1000);
+      report (phase, full / runs, allocations () - allocs);
+      if (area->spftree6[level - 1]->shared_runcount < runs)
+        {
+          printf ("L%d: IPv6 SPF did not share the IPv4 topology\n", level);
+          errors++;
+        }
+      errors += check_routes (area, level, AF_INET, expected);
+      errors += check_routes (area, level, AF_INET6, expected);
+    }
+
+  for (level = 0; level < ISIS_LEVELS; level++)
+    {
+      for (i = 0; i < pdu_count[level]; i++)
+        stream_free (pdus[level][i]);
+      free (pdus[level]);
+    }
+  for (i = 0; i < node_count; i++)
+    {
+      free (nodes[i].nbrs);
+      free (nodes[i].metrics);
+    }
+  free (nodes);
+  prng_free (prng);
+
+  printf ("errors: %d\n%s\n", errors, errors ? "failed" : "OK");
+  return errors != 0;
+}
@@ -0,0 +1,249 @@
+/* Traffic Engineering Database test: apply changes to a TED, carry
+ * them in ZEBRA_TED_UPDATE sized messages and check the mirror TED
+ * built from these messages is identical.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "stream.h"
+#include "thread.h"
+#include "prefix.h"
+#include "zclient.h"
+#include "ted.h"
+
+struct thread_master *master;
+
+#define NODES		2500
+#define LINKS		10000
+#define PREFIXES	2500
+
+static struct ted *ted, *mirror;
+static struct stream *msg_s;
+static u_int16_t msg_count;
+static unsigned int msgs, objects, errors;
+
+/* Decode a message into the mirror TED, as a subscriber would. */
+static void
+msg_send (void)
+{
+  struct te_msg msg;
+  u_int16_t count;
+
+  if (msg_count == 0)
+    return;
+
+  stream_putw_at (msg_s, 0, stream_get_endp (msg_s));
+  stream_putw_at (msg_s, ZEBRA_HEADER_SIZE, msg_count);
+  if (stream_get_endp (msg_s) > ZEBRA_MAX_PACKET_SIZ)
+    errors++;
+
+  stream_set_getp (msg_s, ZEBRA_HEADER_SIZE);
+  count = stream_getw (msg_s);
+  while (count-- > 0)
+    {
+      if (ted_msg_decode (msg_s, &msg) < 0)
+        {
+          errors++;
+          break;
+        }
+      ted_apply (mirror, &msg);
+    }
+  msgs++;
+
+  stream_reset (msg_s);
+  zclient_create_header (msg_s, ZEBRA_TED_UPDATE, VRF_DEFAULT);
+  stream_putw (msg_s, 0);
+  msg_count = 0;
+}
+
+static void
+msg_notify (struct ted *t, struct te_msg *msg)
+{
+  if (ted_msg_encode (msg_s, msg) == 0)
+    {
+      msg_send ();
+      ted_msg_encode (msg_s, msg);
+    }
+  msg_count++;
+  objects++;
+}
+
+static u_int64_t
+node_id (int i)
+{
+  return ((u_int64_t) (0x0a000000 + i) << 32) | (i % 7 == 0);
+}
+
+static void
+link_msg (struct te_msg *msg, u_char event, int i)
+{
+  int j;
+
+  memset (msg, 0, sizeof (struct te_msg));
+  msg->event = event;
+  msg->type = TED_TYPE_LINK;
+  msg->u.link.proto = ZEBRA_ROUTE_OSPF;
+  msg->u.link.src = node_id (i % NODES);
+  msg->u.link.dst = node_id ((i * 7 + 1) % NODES);
+  msg->u.link.local_id = i;
+  msg->u.link.attr.flags = TED_ATTR_TE_METRIC | TED_ATTR_MAX_BW
+                           | TED_ATTR_UNRSV_BW | TED_ATTR_AV_DELAY;
+  msg->u.link.attr.te_metric = 10 + i % 100;
+  msg->u.link.attr.max_bw = 1.25e9;
+  for (j = 0; j < MAX_CLASS_TYPE; j++)
+    msg->u.link.attr.unrsv_bw[j] = 1.25e9 - j * 1000;
+  msg->u.link.attr.local.s_addr = htonl (0xc0a80000 + i);
+  msg->u.link.attr.av_delay = i % 1000;
+}
+
+/* Each object of the mirror must be found unchanged in the source. */
+static int mismatch;
+
+static void
+mirror_check (struct ted *t, struct te_msg *msg, void *arg)
+{
+  msg->event = TED_EVENT_UPDATE;
+  if (ted_apply (ted, msg) != 0)
+    mismatch++;
+}
+
+static void
+mirror_count (struct ted *t, struct te_msg *msg, void *arg)
+{
+  (*(int *) arg)++;
+}
+
+static int
+compare (void)
+{
+  int n1 = 0, n2 = 0;
+  void (*notify) (struct ted *, struct te_msg *) = ted->notify;
+
+  ted_walk (ted, mirror_count, &n1);
+  ted_walk (mirror, mirror_count, &n2);
+
+  mismatch = 0;
+  ted->notify = NULL;
+  ted_walk (mirror, mirror_check, NULL);
+  ted->notify = notify;
+
+  return n1 == n2 && mismatch == 0;
+}
+
+int
+main (void)
+{
+  struct te_msg msg;
+  struct timeval start, end;
+  unsigned long usec;
+  int i, ok = 1;
+
+  ted = ted_new ();
+  mirror = ted_new ();
+  ted->notify = msg_notify;
+  msg_s = stream_new (ZEBRA_MAX_PACKET_SIZ);
+  stream_reset (msg_s);
+  zclient_create_header (msg_s, ZEBRA_TED_UPDATE, VRF_DEFAULT);
+  stream_putw (msg_s, 0);
+
+  gettimeofday (&start, NULL);
+
+  /* Initial topology */
+  for (i = 0; i < NODES; i++)
+    {
+      memset (&msg, 0, sizeof (struct te_msg));
+      msg.event = TED_EVENT_UPDATE;
+      msg.type = TED_TYPE_NODE;
+      msg.u.node.proto = ZEBRA_ROUTE_OSPF;
+      msg.u.node.id = node_id (i);
+      msg.u.node.router_id.s_addr = htonl (0x0a000000 + i);
+      ted_apply (ted, &msg);
+    }
+  for (i = 0; i < LINKS; i++)
+    {
+      link_msg (&msg, TED_EVENT_UPDATE, i);
+      ted_apply (ted, &msg);
+    }
+  for (i = 0; i < PREFIXES; i++)
+    {
+      memset (&msg, 0, sizeof (struct te_msg));
+      msg.event = TED_EVENT_UPDATE;
+      msg.type = TED_TYPE_PREFIX;
+      msg.u.prefix.proto = ZEBRA_ROUTE_ISIS;
+      msg.u.prefix.node = node_id (i);
+      msg.u.prefix.p.family = AF_INET;
+      msg.u.prefix.p.prefixlen = 24 + i % 9;
+      msg.u.prefix.p.u.prefix4.s_addr = htonl (0xac100000 + (i << 8));
+      msg.u.prefix.metric = i;
+      ted_apply (ted, &msg);
+    }
+  msg_send ();
+  printf ("initial: %u objects, mirror %s\n", objects,
+          compare () ? "identical" : "differs");
+
+  /* Unchanged updates are absorbed */
+  objects = 0;
+  for (i = 0; i < LINKS; i++)
+    {
+      link_msg (&msg, TED_EVENT_UPDATE, i);
+      ted_apply (ted, &msg);
+    }
+  msg_send ();
+  printf ("refresh: %u objects\n", objects);
+
+  /* Metric changes and deletions */
+  objects = 0;
+  for (i = 0; i < LINKS; i += 10)
+    {
+      link_msg (&msg, TED_EVENT_UPDATE, i);
+      msg.u.link.attr.te_metric++;
+      ted_apply (ted, &msg);
+    }
+  for (i = 5; i < LINKS; i += 10)
+    {
+      link_msg (&msg, TED_EVENT_DELETE, i);
+      ted_apply (ted, &msg);
+    }
+  msg_send ();
+  printf ("changes: %u objects, mirror %s\n", objects,
+          compare () ? "identical" : "differs");
+
+  /* A daemon going away */
+  objects = 0;
+  ted_flush_proto (ted, ZEBRA_ROUTE_OSPF);
+  msg_send ();
+  printf ("flush: %u objects, mirror %s\n", objects,
+          compare () ? "identical" : "differs");
+
+  gettimeofday (&end, NULL);
+  usec = (end.tv_sec - start.tv_sec) * 1000000 + end.tv_usec - start.tv_usec;
+
+  printf ("errors: %u\n", errors);
+  fprintf (stderr, "%u messages in %lu usec\n", msgs, usec);
+  if (errors)
+    ok = 0;
+
+  ted_free (ted);
+  ted_free (mirror);
+  stream_free (msg_s);
+
+  printf ("%s\n", ok ? "OK" : "failed");
+  return !ok;
+}
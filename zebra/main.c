@@ -41,6 +41,8 @@
 #include "zebra/irdp.h"
 #include "zebra/rtadv.h"
 #include "zebra/zebra_fpm.h"
+#include "zebra/zebra_ted.h"
+#include "zebra/zebra_pathlist.h"
 
 /* Zebra instance */
 struct zebra_t zebrad =
@@ -403,6 +405,8 @@ main (int argc, char **argv)
   zebra_debug_init ();
   router_id_cmd_init ();
   zebra_vty_init ();
+  zebra_ted_init ();
+  zebra_pathlist_init ();
   access_list_init ();
   prefix_list_init ();
 #if defined (HAVE_RTADV)
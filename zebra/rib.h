@@ -84,11 +84,17 @@ struct rib
 #define RIB_ENTRY_REMOVED	(1 << 0)
 #define RIB_ENTRY_CHANGED	(1 << 1)
 #define RIB_ENTRY_SELECTED_FIB	(1 << 2)
+#define RIB_ENTRY_STALE		(1 << 3)
 
   /* Nexthop information. */
   u_char nexthop_num;
   u_char nexthop_active_num;
   u_char nexthop_fib_num;
+
+  /* Path-list whose nexthops the route follows, and its entry in the
+     routes of the path-list. */
+  struct zebra_pathlist *pathlist;
+  struct listnode *pathlist_node;
 };
 
 /* meta-queue structure:
@@ -449,6 +455,9 @@ extern int rib_lookup_ipv4_route (struct prefix_ipv4 *, union sockunion *,
 #define ZEBRA_RIB_NOTFOUND 3
 
 extern struct nexthop *nexthop_ipv6_add (struct rib *, struct in6_addr *);
+extern struct nexthop *nexthop_ipv6_ifindex_add (struct rib *,
+                                                 struct in6_addr *,
+                                                 ifindex_t);
 
 extern struct zebra_vrf *zebra_vrf_alloc (vrf_id_t);
 extern struct route_table *zebra_vrf_table (afi_t, safi_t, vrf_id_t);
@@ -484,6 +493,9 @@ extern void rib_close_table (struct route_table *);
 extern void rib_close (void);
 extern void rib_init (void);
 extern unsigned long rib_score_proto (u_char proto);
+extern unsigned long rib_mark_stale_proto (u_char proto);
+extern unsigned long rib_sweep_stale_proto (u_char proto);
+extern void rib_replace (struct route_node *, struct rib *, struct rib *);
 
 extern int
 static_add_ipv4_safi (safi_t safi, struct prefix *p, struct in_addr *gate,
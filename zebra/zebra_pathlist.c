@@ -0,0 +1,413 @@
+/*
+ * Zebra path-lists: nexthops shared by the routes of a client, for
+ * prefix independent convergence.
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "command.h"
+#include "hash.h"
+#include "if.h"
+#include "jhash.h"
+#include "linklist.h"
+#include "log.h"
+#include "memory.h"
+#include "prefix.h"
+#include "stream.h"
+#include "table.h"
+#include "vty.h"
+
+#include "zebra/rib.h"
+#include "zebra/zserv.h"
+#include "zebra/debug.h"
+#include "zebra/zebra_pathlist.h"
+
+static struct hash *zpl_hash;
+
+static unsigned int
+zpl_hash_key (void *arg)
+{
+  struct zebra_pathlist *pl = arg;
+
+  return jhash_2words (pl->type, pl->id, 0);
+}
+
+static int
+zpl_hash_cmp (const void *arg1, const void *arg2)
+{
+  const struct zebra_pathlist *pl1 = arg1;
+  const struct zebra_pathlist *pl2 = arg2;
+
+  return pl1->type == pl2->type && pl1->id == pl2->id;
+}
+
+static void *
+zpl_alloc (void *arg)
+{
+  struct zebra_pathlist *key = arg;
+  struct zebra_pathlist *pl;
+
+  pl = XCALLOC (MTYPE_PATHLIST, sizeof (struct zebra_pathlist));
+  pl->type = key->type;
+  pl->id = key->id;
+  pl->routes = list_new ();
+
+  return pl;
+}
+
+/* RIB entry of a route node which follows the path-list through the
+   given list node. */
+static struct rib *
+zpl_route_rib (struct route_node *rn, struct listnode *node)
+{
+  struct rib *rib;
+
+  RNODE_FOREACH_RIB (rn, rib)
+    if (rib->pathlist_node == node)
+      return rib;
+
+  return NULL;
+}
+
+static void
+zpl_free (struct zebra_pathlist *pl)
+{
+  struct listnode *node;
+  struct route_node *rn;
+  struct rib *rib;
+
+  for (ALL_LIST_ELEMENTS_RO (pl->routes, node, rn))
+    {
+      if ((rib = zpl_route_rib (rn, node)) != NULL)
+        {
+          rib->pathlist = NULL;
+          rib->pathlist_node = NULL;
+        }
+      route_unlock_node (rn);
+    }
+  list_delete (pl->routes);
+
+  if (pl->nexthop)
+    XFREE (MTYPE_PATHLIST, pl->nexthop);
+  if (pl->ifindex)
+    XFREE (MTYPE_PATHLIST, pl->ifindex);
+  XFREE (MTYPE_PATHLIST, pl);
+}
+
+static void
+zpl_nexthops_add (struct zebra_pathlist *pl, struct rib *rib)
+{
+  int i;
+
+  for (i = 0; i < pl->nexthop_num; i++)
+    {
+      if (pl->nexthop[i].family == AF_INET)
+        nexthop_ipv4_add (rib, &pl->nexthop[i].u.prefix4, NULL);
+#ifdef HAVE_IPV6
+      else if (pl->ifindex[i])
+        nexthop_ipv6_ifindex_add (rib, &pl->nexthop[i].u.prefix6,
+                                  pl->ifindex[i]);
+      else
+        nexthop_ipv6_add (rib, &pl->nexthop[i].u.prefix6);
+#endif /* HAVE_IPV6 */
+    }
+}
+
+/* Move the routes which follow the path-list onto its new nexthops.
+   Each one is replaced by a copy using them, which is then processed
+   like any other route change. */
+static void
+zpl_routes_update (struct zebra_pathlist *pl)
+{
+  struct listnode *node;
+  struct route_node *rn;
+  struct rib *rib;
+  struct rib *new;
+
+  for (ALL_LIST_ELEMENTS_RO (pl->routes, node, rn))
+    {
+      rib = zpl_route_rib (rn, node);
+      if (! rib || CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+        continue;
+
+      new = XCALLOC (MTYPE_RIB, sizeof (struct rib));
+      new->type = rib->type;
+      new->flags = rib->flags & ~ZEBRA_FLAG_SELECTED;
+      new->distance = rib->distance;
+      new->metric = rib->metric;
+      new->mtu = rib->mtu;
+      new->table = rib->table;
+      new->vrf_id = rib->vrf_id;
+      new->uptime = time (NULL);
+      zpl_nexthops_add (pl, new);
+
+      /* The new entry takes over the list node. */
+      new->pathlist = pl;
+      new->pathlist_node = node;
+      rib->pathlist = NULL;
+      rib->pathlist_node = NULL;
+
+      rib_replace (rn, rib, new);
+      pl->moved++;
+    }
+}
+
+/* Add or replace a path-list. */
+void
+zebra_pathlist_add (struct zserv *client, u_short length)
+{
+  struct stream *s = client->ibuf;
+  struct zebra_pathlist key;
+  struct zebra_pathlist *pl;
+  struct prefix *nexthop;
+  ifindex_t *ifindex;
+  u_char nexthop_num;
+  u_char nexthop_type;
+  int i, n;
+
+  if (length < 6)
+    return;
+
+  key.type = stream_getc (s);
+  key.id = stream_getl (s);
+  nexthop_num = stream_getc (s);
+  if (key.type >= ZEBRA_ROUTE_MAX)
+    return;
+
+  nexthop = XCALLOC (MTYPE_PATHLIST,
+                     sizeof (struct prefix) * (nexthop_num + 1));
+  ifindex = XCALLOC (MTYPE_PATHLIST,
+                     sizeof (ifindex_t) * (nexthop_num + 1));
+
+  for (i = 0, n = 0; i < nexthop_num && STREAM_READABLE (s) > 0; i++)
+    {
+      nexthop_type = stream_getc (s);
+
+      switch (nexthop_type)
+        {
+        case ZEBRA_NEXTHOP_IPV4:
+          if (STREAM_READABLE (s) < IPV4_MAX_BYTELEN)
+            goto truncated;
+          nexthop[n].family = AF_INET;
+          nexthop[n].prefixlen = IPV4_MAX_BITLEN;
+          stream_get (&nexthop[n].u.prefix4, s, IPV4_MAX_BYTELEN);
+          n++;
+          break;
+#ifdef HAVE_IPV6
+        case ZEBRA_NEXTHOP_IPV6:
+        case ZEBRA_NEXTHOP_IPV6_IFINDEX:
+          if (STREAM_READABLE (s) < IPV6_MAX_BYTELEN
+              + (nexthop_type == ZEBRA_NEXTHOP_IPV6_IFINDEX ? 4 : 0))
+            goto truncated;
+          nexthop[n].family = AF_INET6;
+          nexthop[n].prefixlen = IPV6_MAX_BITLEN;
+          stream_get (&nexthop[n].u.prefix6, s, IPV6_MAX_BYTELEN);
+          if (nexthop_type == ZEBRA_NEXTHOP_IPV6_IFINDEX)
+            ifindex[n] = stream_getl (s);
+          n++;
+          break;
+#endif /* HAVE_IPV6 */
+        default:
+          goto truncated;
+        }
+    }
+
+  pl = hash_get (zpl_hash, &key, zpl_alloc);
+  pl->client = client;
+
+  if (pl->nexthop)
+    XFREE (MTYPE_PATHLIST, pl->nexthop);
+  if (pl->ifindex)
+    XFREE (MTYPE_PATHLIST, pl->ifindex);
+  pl->nexthop_num = n;
+  pl->nexthop = nexthop;
+  pl->ifindex = ifindex;
+  pl->updates++;
+
+  if (IS_ZEBRA_DEBUG_RIB)
+    zlog_debug ("%s path-list %u: %d nexthops, %d routes",
+                zebra_route_string (pl->type), pl->id, n,
+                listcount (pl->routes));
+
+  /* Routes keep their nexthops when no path is left: the client will
+     withdraw them. */
+  if (n)
+    zpl_routes_update (pl);
+  return;
+
+ truncated:
+  zlog_warn ("%s path-list %u: malformed nexthop %d",
+             zebra_route_string (key.type), key.id, i);
+  XFREE (MTYPE_PATHLIST, nexthop);
+  XFREE (MTYPE_PATHLIST, ifindex);
+}
+
+void
+zebra_pathlist_delete (struct zserv *client, u_short length)
+{
+  struct stream *s = client->ibuf;
+  struct zebra_pathlist key;
+  struct zebra_pathlist *pl;
+
+  if (length < 5)
+    return;
+
+  key.type = stream_getc (s);
+  key.id = stream_getl (s);
+
+  pl = hash_lookup (zpl_hash, &key);
+  if (pl && pl->client == client)
+    {
+      hash_release (zpl_hash, pl);
+      zpl_free (pl);
+    }
+}
+
+/* The route of this type just added for the prefix follows the
+   path-list. */
+void
+zebra_pathlist_attach (struct zserv *client, u_char type, u_int32_t id,
+                       afi_t afi, safi_t safi, vrf_id_t vrf_id,
+                       struct prefix *p)
+{
+  struct zebra_pathlist key;
+  struct zebra_pathlist *pl;
+  struct route_table *table;
+  struct route_node *rn;
+  struct rib *rib;
+  struct prefix pm;
+
+  key.type = type;
+  key.id = id;
+  pl = hash_lookup (zpl_hash, &key);
+  if (! pl || pl->client != client)
+    {
+      zlog_warn ("%s route references unknown path-list %u",
+                 zebra_route_string (type), id);
+      return;
+    }
+
+  table = zebra_vrf_table (afi, safi, vrf_id);
+  if (! table)
+    return;
+
+  prefix_copy (&pm, p);
+  apply_mask (&pm);
+  rn = route_node_lookup (table, &pm);
+  if (! rn)
+    return;
+
+  RNODE_FOREACH_RIB (rn, rib)
+    if (rib->type == type && ! CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+      break;
+
+  if (! rib || rib->pathlist)
+    {
+      route_unlock_node (rn);
+      return;
+    }
+
+  /* The list keeps the lock taken by the lookup. */
+  listnode_add (pl->routes, rn);
+  rib->pathlist = pl;
+  rib->pathlist_node = listtail (pl->routes);
+}
+
+/* The RIB entry is about to be freed. */
+void
+zebra_pathlist_detach (struct rib *rib)
+{
+  struct zebra_pathlist *pl = rib->pathlist;
+  struct route_node *rn;
+
+  if (! pl)
+    return;
+
+  rn = listgetdata (rib->pathlist_node);
+  list_delete_node (pl->routes, rib->pathlist_node);
+  rib->pathlist = NULL;
+  rib->pathlist_node = NULL;
+  route_unlock_node (rn);
+}
+
+static void
+zpl_client_close (struct hash_backet *backet, void *arg)
+{
+  struct zebra_pathlist *pl = backet->data;
+
+  if (pl->client == arg)
+    {
+      hash_release (zpl_hash, pl);
+      zpl_free (pl);
+    }
+}
+
+void
+zebra_pathlist_client_close (struct zserv *client)
+{
+  hash_iterate (zpl_hash, zpl_client_close, client);
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are vty command functions.
+ *------------------------------------------------------------------------*/
+
+static void
+zpl_show (struct hash_backet *backet, void *arg)
+{
+  struct zebra_pathlist *pl = backet->data;
+  struct vty *vty = arg;
+  char buf[INET6_ADDRSTRLEN];
+  int i;
+
+  vty_out (vty, "Path-list %u, %s, %d routes, %u updates, %u routes moved%s",
+           pl->id, zebra_route_string (pl->type), listcount (pl->routes),
+           pl->updates, pl->moved, VTY_NEWLINE);
+
+  for (i = 0; i < pl->nexthop_num; i++)
+    {
+      inet_ntop (pl->nexthop[i].family, &pl->nexthop[i].u.prefix,
+                 buf, sizeof (buf));
+      if (pl->ifindex[i])
+        vty_out (vty, "  via %s, %s%s", buf, ifindex2ifname (pl->ifindex[i]),
+                 VTY_NEWLINE);
+      else
+        vty_out (vty, "  via %s%s", buf, VTY_NEWLINE);
+    }
+}
+
+DEFUN (show_path_list,
+       show_path_list_cmd,
+       "show path-list",
+       SHOW_STR
+       "Path-lists shared by routes\n")
+{
+  hash_iterate (zpl_hash, zpl_show, vty);
+  return CMD_SUCCESS;
+}
+
+void
+zebra_pathlist_init (void)
+{
+  zpl_hash = hash_create (zpl_hash_key, zpl_hash_cmp);
+
+  install_element (VIEW_NODE, &show_path_list_cmd);
+  install_element (ENABLE_NODE, &show_path_list_cmd);
+}
@@ -0,0 +1,62 @@
+/*
+ * Zebra path-lists: nexthops shared by the routes of a client, for
+ * prefix independent convergence.
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _ZEBRA_ZEBRA_PATHLIST_H
+#define _ZEBRA_ZEBRA_PATHLIST_H
+
+#include "zebra/zserv.h"
+#include "zebra/rib.h"
+
+/* A client installs a path-list, then routes which reference it. When
+ * it replaces the nexthops of the path-list, for instance with the
+ * backup paths after a peer went down, zebra moves all these routes at
+ * once, without waiting for the client to send them again one by one.
+ */
+struct zebra_pathlist
+{
+  /* Route type and client which installed it. */
+  u_char type;
+  u_int32_t id;
+  struct zserv *client;
+
+  /* Current nexthops. */
+  u_char nexthop_num;
+  struct prefix *nexthop;
+  ifindex_t *ifindex;
+
+  /* Route nodes of the RIB entries which follow it. */
+  struct list *routes;
+
+  /* Statistics. */
+  u_int32_t updates;
+  u_int32_t moved;
+};
+
+extern void zebra_pathlist_init (void);
+extern void zebra_pathlist_add (struct zserv *, u_short);
+extern void zebra_pathlist_delete (struct zserv *, u_short);
+extern void zebra_pathlist_attach (struct zserv *, u_char, u_int32_t,
+                                   afi_t, safi_t, vrf_id_t, struct prefix *);
+extern void zebra_pathlist_detach (struct rib *);
+extern void zebra_pathlist_client_close (struct zserv *);
+
+#endif /* _ZEBRA_ZEBRA_PATHLIST_H */
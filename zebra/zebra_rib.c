@@ -42,6 +42,7 @@
 #include "zebra/redistribute.h"
 #include "zebra/debug.h"
 #include "zebra/zebra_fpm.h"
+#include "zebra/zebra_pathlist.h"
 
 /* Default rtm_table for all clients */
 extern struct zebra_t zebrad;
@@ -289,7 +290,7 @@ nexthop_ipv6_ifname_add (struct rib *rib, struct in6_addr *ipv6,
   return nexthop;
 }
 
-static struct nexthop *
+struct nexthop *
 nexthop_ipv6_ifindex_add (struct rib *rib, struct in6_addr *ipv6,
 			  ifindex_t ifindex)
 {
@@ -1719,6 +1720,8 @@ rib_unlink (struct route_node *rn, struct rib *rib)
       dest->routes = rib->next;
     }
 
+  zebra_pathlist_detach (rib);
+
   /* free RIB and nexthops */
   nexthops_free(rib->nexthop);
   XFREE (MTYPE_RIB, rib);
@@ -1734,6 +1737,15 @@ rib_delnode (struct route_node *rn, struct rib *rib)
   rib_queue_add (&zebrad, rn);
 }
 
+/* Replace a route by a new RIB entry of the same type, e.g. with
+   other nexthops. */
+void
+rib_replace (struct route_node *rn, struct rib *old, struct rib *new)
+{
+  rib_addnode (rn, new);
+  rib_delnode (rn, old);
+}
+
 int
 rib_add_ipv4 (int type, int flags, struct prefix_ipv4 *p, 
 	      struct in_addr *gate, struct in_addr *src,
@@ -3085,6 +3097,73 @@ rib_score_proto (u_char proto)
   return cnt;
 }
 
+/* Mark the routes of a protocol in 'table' as stale, or remove those
+   still stale. */
+static unsigned long
+rib_stale_proto_table (u_char proto, struct route_table *table, int sweep)
+{
+  struct route_node *rn;
+  struct rib *rib;
+  struct rib *next;
+  unsigned long n = 0;
+
+  if (table)
+    for (rn = route_top (table); rn; rn = route_next (rn))
+      RNODE_FOREACH_RIB_SAFE (rn, rib, next)
+        {
+          if (CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+            continue;
+          if (rib->type != proto)
+            continue;
+          if (! sweep)
+            {
+              SET_FLAG (rib->status, RIB_ENTRY_STALE);
+              n++;
+            }
+          else if (CHECK_FLAG (rib->status, RIB_ENTRY_STALE))
+            {
+              rib_delnode (rn, rib);
+              n++;
+            }
+        }
+
+  return n;
+}
+
+/* Keep the routes of a restarting protocol in the RIB and the FIB,
+   flagged stale until the protocol sends them again. A route sent
+   again replaces the stale one as an implicit withdraw. */
+unsigned long
+rib_mark_stale_proto (u_char proto)
+{
+  vrf_iter_t iter;
+  struct zebra_vrf *zvrf;
+  unsigned long cnt = 0;
+
+  for (iter = vrf_first (); iter != VRF_ITER_INVALID; iter = vrf_next (iter))
+    if ((zvrf = vrf_iter2info (iter)) != NULL)
+      cnt += rib_stale_proto_table (proto, zvrf->table[AFI_IP][SAFI_UNICAST], 0)
+            +rib_stale_proto_table (proto, zvrf->table[AFI_IP6][SAFI_UNICAST], 0);
+
+  return cnt;
+}
+
+/* Remove the routes of a protocol not refreshed since its restart. */
+unsigned long
+rib_sweep_stale_proto (u_char proto)
+{
+  vrf_iter_t iter;
+  struct zebra_vrf *zvrf;
+  unsigned long cnt = 0;
+
+  for (iter = vrf_first (); iter != VRF_ITER_INVALID; iter = vrf_next (iter))
+    if ((zvrf = vrf_iter2info (iter)) != NULL)
+      cnt += rib_stale_proto_table (proto, zvrf->table[AFI_IP][SAFI_UNICAST], 1)
+            +rib_stale_proto_table (proto, zvrf->table[AFI_IP6][SAFI_UNICAST], 1);
+
+  return cnt;
+}
+
 /* Close RIB and clean up kernel routes. */
 void
 rib_close_table (struct route_table *table)
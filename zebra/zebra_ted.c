@@ -0,0 +1,389 @@
+/*
+ * Zebra Traffic Engineering Database, fed by the IGPs and exported to
+ * the subscribed clients.
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "command.h"
+#include "hash.h"
+#include "linklist.h"
+#include "log.h"
+#include "memory.h"
+#include "prefix.h"
+#include "stream.h"
+#include "vty.h"
+#include "zclient.h"
+#include "ted.h"
+
+#include "zebra/zserv.h"
+#include "zebra/debug.h"
+#include "zebra/zebra_ted.h"
+
+extern struct zebra_t zebrad;
+
+static struct
+{
+  struct ted *ted;
+
+  /* Client which feeds the objects of each protocol */
+  struct zserv *owner[ZEBRA_ROUTE_MAX];
+
+  /* Changes to forward to the subscribers */
+  struct stream *out;
+  u_int16_t count;
+
+  /* Statistics */
+  u_int32_t rcv_msgs;
+  u_int32_t rcv_objects;
+  u_int32_t rcv_errors;
+  u_int32_t fwd_msgs;
+  u_int32_t sync_msgs;
+} zted;
+
+static void
+zted_stream_reset (struct stream *s)
+{
+  stream_reset (s);
+  zclient_create_header (s, ZEBRA_TED_UPDATE, VRF_DEFAULT);
+  stream_putw (s, 0);
+}
+
+static void
+zted_stream_finish (struct stream *s, u_int16_t count)
+{
+  stream_putw_at (s, 0, stream_get_endp (s));
+  stream_putw_at (s, ZEBRA_HEADER_SIZE, count);
+}
+
+/* Send the pending changes to all subscribers. */
+static void
+zted_forward (void)
+{
+  struct listnode *node;
+  struct zserv *client;
+
+  if (zted.count == 0)
+    return;
+
+  zted_stream_finish (zted.out, zted.count);
+  for (ALL_LIST_ELEMENTS_RO (zebrad.client_list, node, client))
+    if (client->ted_subscribed)
+      {
+        zsend_ted_message (client, zted.out);
+        zted.fwd_msgs++;
+      }
+
+  zted_stream_reset (zted.out);
+  zted.count = 0;
+}
+
+/* TED notify callback: queue the change for the subscribers. */
+static void
+zted_notify (struct ted *ted, struct te_msg *msg)
+{
+  char buf[32];
+
+  if (IS_ZEBRA_DEBUG_EVENT)
+    zlog_debug ("TED: %s %s %s", ted_event2str (msg->event),
+                ted_type2str (msg->type),
+                msg->type == TED_TYPE_NODE ?
+                  ted_id2str (msg->u.node.proto, msg->u.node.id,
+                              buf, sizeof (buf)) : "");
+
+  if (ted_msg_encode (zted.out, msg) == 0)
+    {
+      zted_forward ();
+      ted_msg_encode (zted.out, msg);
+    }
+  zted.count++;
+}
+
+static u_char
+zted_msg_proto (struct te_msg *msg)
+{
+  switch (msg->type)
+    {
+    case TED_TYPE_NODE:
+      return msg->u.node.proto;
+    case TED_TYPE_LINK:
+      return msg->u.link.proto;
+    default:
+      return msg->u.prefix.proto;
+    }
+}
+
+/* ZEBRA_TED_UPDATE from an IGP: apply a batch of changes. */
+void
+zebra_ted_update (struct zserv *client, u_short length)
+{
+  struct stream *s = client->ibuf;
+  struct te_msg msg;
+  u_int16_t count;
+  u_char proto;
+  size_t end;
+
+  end = stream_get_getp (s) + length;
+  if (length < TED_MSG_HEADER_SIZE)
+    goto error;
+
+  zted.rcv_msgs++;
+  count = stream_getw (s);
+  while (count-- > 0)
+    {
+      if (stream_get_getp (s) >= end || ted_msg_decode (s, &msg) < 0
+          || stream_get_getp (s) > end)
+        goto error;
+
+      proto = zted_msg_proto (&msg);
+      if (proto >= ZEBRA_ROUTE_MAX
+          || (msg.event != TED_EVENT_UPDATE && msg.event != TED_EVENT_DELETE))
+        {
+          zted.rcv_errors++;
+          continue;
+        }
+
+      /* Objects of a protocol are removed when its daemon goes away */
+      if (zted.owner[proto] != client)
+        {
+          if (zted.owner[proto] != NULL)
+            zlog_warn ("TED: sender of %s objects changed",
+                       zebra_route_string (proto));
+          zted.owner[proto] = client;
+        }
+
+      zted.rcv_objects++;
+      ted_apply (zted.ted, &msg);
+    }
+
+  zted_forward ();
+  return;
+
+error:
+  zlog_warn ("TED: malformed update from client %d", client->sock);
+  zted.rcv_errors++;
+  zted_forward ();
+}
+
+/* Initial synchronisation of a subscriber, packing objects in as few
+   messages as possible. */
+struct zted_sync
+{
+  struct zserv *client;
+  struct stream *s;
+  u_int16_t count;
+};
+
+static void
+zted_sync_send (struct zted_sync *sync)
+{
+  if (sync->count == 0)
+    return;
+
+  zted_stream_finish (sync->s, sync->count);
+  zsend_ted_message (sync->client, sync->s);
+  zted.sync_msgs++;
+
+  zted_stream_reset (sync->s);
+  sync->count = 0;
+}
+
+static void
+zted_sync_object (struct ted *ted, struct te_msg *msg, void *arg)
+{
+  struct zted_sync *sync = arg;
+
+  if (ted_msg_encode (sync->s, msg) == 0)
+    {
+      zted_sync_send (sync);
+      ted_msg_encode (sync->s, msg);
+    }
+  sync->count++;
+}
+
+/* ZEBRA_TED_SUBSCRIBE from a client. */
+void
+zebra_ted_subscribe (struct zserv *client, u_short length)
+{
+  struct zted_sync sync;
+  struct stream *s;
+
+  if (length < 1)
+    return;
+
+  client->ted_subscribed = stream_getc (client->ibuf);
+  if (!client->ted_subscribed)
+    return;
+
+  sync.client = client;
+  sync.s = stream_new (ZEBRA_MAX_PACKET_SIZ);
+  sync.count = 0;
+  zted_stream_reset (sync.s);
+
+  ted_walk (zted.ted, zted_sync_object, &sync);
+  zted_sync_send (&sync);
+
+  /* End of the initial synchronisation */
+  s = sync.s;
+  stream_reset (s);
+  zclient_create_header (s, ZEBRA_TED_SYNC_DONE, VRF_DEFAULT);
+  stream_putw_at (s, 0, stream_get_endp (s));
+  zsend_ted_message (client, s);
+
+  stream_free (sync.s);
+}
+
+void
+zebra_ted_client_close (struct zserv *client)
+{
+  int proto;
+
+  client->ted_subscribed = 0;
+
+  for (proto = 0; proto < ZEBRA_ROUTE_MAX; proto++)
+    if (zted.owner[proto] == client)
+      {
+        zted.owner[proto] = NULL;
+        ted_flush_proto (zted.ted, proto);
+        zlog_notice ("client %d disconnected. %s TE objects removed",
+                     client->sock, zebra_route_string (proto));
+      }
+
+  zted_forward ();
+}
+
+/*------------------------------------------------------------------------*
+ * Followings are vty command functions.
+ *------------------------------------------------------------------------*/
+
+struct zted_count
+{
+  u_int32_t objects[ZEBRA_ROUTE_MAX][TED_TYPE_PREFIX + 1];
+};
+
+static void
+zted_count_object (struct ted *ted, struct te_msg *msg, void *arg)
+{
+  struct zted_count *cnt = arg;
+  u_char proto = zted_msg_proto (msg);
+
+  if (proto < ZEBRA_ROUTE_MAX)
+    cnt->objects[proto][msg->type]++;
+}
+
+DEFUN (show_ted,
+       show_ted_cmd,
+       "show ted",
+       SHOW_STR
+       "Traffic Engineering Database\n")
+{
+  struct zted_count cnt;
+  struct listnode *node;
+  struct zserv *client;
+  int proto, subscribers = 0;
+
+  memset (&cnt, 0, sizeof (struct zted_count));
+  ted_walk (zted.ted, zted_count_object, &cnt);
+
+  vty_out (vty, "%-10s %8s %8s %8s%s", "Protocol", "Nodes", "Links",
+           "Prefixes", VTY_NEWLINE);
+  for (proto = 0; proto < ZEBRA_ROUTE_MAX; proto++)
+    if (zted.owner[proto] != NULL || cnt.objects[proto][TED_TYPE_NODE]
+        || cnt.objects[proto][TED_TYPE_LINK]
+        || cnt.objects[proto][TED_TYPE_PREFIX])
+      vty_out (vty, "%-10s %8u %8u %8u%s", zebra_route_string (proto),
+               cnt.objects[proto][TED_TYPE_NODE],
+               cnt.objects[proto][TED_TYPE_LINK],
+               cnt.objects[proto][TED_TYPE_PREFIX], VTY_NEWLINE);
+
+  for (ALL_LIST_ELEMENTS_RO (zebrad.client_list, node, client))
+    if (client->ted_subscribed)
+      subscribers++;
+
+  vty_out (vty, "%sSubscribers: %d%s", VTY_NEWLINE, subscribers,
+           VTY_NEWLINE);
+  vty_out (vty, "Received: %u messages, %u objects, %u errors%s",
+           zted.rcv_msgs, zted.rcv_objects, zted.rcv_errors, VTY_NEWLINE);
+  vty_out (vty, "Sent: %u update messages, %u synchronisation messages%s",
+           zted.fwd_msgs, zted.sync_msgs, VTY_NEWLINE);
+
+  return CMD_SUCCESS;
+}
+
+static void
+zted_show_object (struct ted *ted, struct te_msg *msg, void *arg)
+{
+  struct vty *vty = arg;
+  char src[32], dst[32], buf[64];
+
+  switch (msg->type)
+    {
+    case TED_TYPE_NODE:
+      vty_out (vty, "  Node   %-6s %-24s Router ID %s%s",
+               zebra_route_string (msg->u.node.proto),
+               ted_id2str (msg->u.node.proto, msg->u.node.id,
+                           src, sizeof (src)),
+               inet_ntoa (msg->u.node.router_id), VTY_NEWLINE);
+      break;
+    case TED_TYPE_LINK:
+      vty_out (vty, "  Link   %-6s %-24s -> %-24s TE metric %u%s",
+               zebra_route_string (msg->u.link.proto),
+               ted_id2str (msg->u.link.proto, msg->u.link.src,
+                           src, sizeof (src)),
+               ted_id2str (msg->u.link.proto, msg->u.link.dst,
+                           dst, sizeof (dst)),
+               msg->u.link.attr.te_metric, VTY_NEWLINE);
+      break;
+    case TED_TYPE_PREFIX:
+      prefix2str (&msg->u.prefix.p, buf, sizeof (buf));
+      vty_out (vty, "  Prefix %-6s %-24s %-18s metric %u%s",
+               zebra_route_string (msg->u.prefix.proto),
+               ted_id2str (msg->u.prefix.proto, msg->u.prefix.node,
+                           src, sizeof (src)),
+               buf, msg->u.prefix.metric, VTY_NEWLINE);
+      break;
+    }
+}
+
+DEFUN (show_ted_database,
+       show_ted_database_cmd,
+       "show ted database",
+       SHOW_STR
+       "Traffic Engineering Database\n"
+       "Database content\n")
+{
+  ted_walk (zted.ted, zted_show_object, vty);
+  return CMD_SUCCESS;
+}
+
+void
+zebra_ted_init (void)
+{
+  memset (&zted, 0, sizeof (zted));
+  zted.ted = ted_new ();
+  zted.ted->notify = zted_notify;
+  zted.out = stream_new (ZEBRA_MAX_PACKET_SIZ);
+  zted_stream_reset (zted.out);
+
+  install_element (VIEW_NODE, &show_ted_cmd);
+  install_element (VIEW_NODE, &show_ted_database_cmd);
+  install_element (ENABLE_NODE, &show_ted_cmd);
+  install_element (ENABLE_NODE, &show_ted_database_cmd);
+}
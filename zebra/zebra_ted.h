@@ -0,0 +1,33 @@
+/*
+ * Zebra Traffic Engineering Database, fed by the IGPs and exported to
+ * the subscribed clients.
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _ZEBRA_ZEBRA_TED_H
+#define _ZEBRA_ZEBRA_TED_H
+
+#include "zebra/zserv.h"
+
+extern void zebra_ted_init (void);
+extern void zebra_ted_update (struct zserv *, u_short);
+extern void zebra_ted_subscribe (struct zserv *, u_short);
+extern void zebra_ted_client_close (struct zserv *);
+
+#endif /* _ZEBRA_ZEBRA_TED_H */
@@ -30,6 +30,7 @@
 #include "vrf.h"
 
 #include "zebra/zserv.h"
+#include "zebra/zebra_pathlist.h"
 
 static int do_show_ip_route(struct vty *vty, safi_t safi, vrf_id_t vrf_id);
 static void vty_show_ip_route_detail (struct vty *vty, struct route_node *rn,
@@ -1305,6 +1306,8 @@ vty_show_ip_route_detail (struct vty *vty, struct route_node *rn, int mcast)
        vty_out (vty, ", blackhole");
       if (CHECK_FLAG (rib->flags, ZEBRA_FLAG_REJECT))
        vty_out (vty, ", reject");
+      if (rib->pathlist)
+        vty_out (vty, ", path-list %u", rib->pathlist->id);
       vty_out (vty, "%s", VTY_NEWLINE);
 
 #define ONE_DAY_SECOND 60*60*24
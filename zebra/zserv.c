@@ -43,6 +43,8 @@
 #include "zebra/redistribute.h"
 #include "zebra/debug.h"
 #include "zebra/ipforward.h"
+#include "zebra/zebra_ted.h"
+#include "zebra/zebra_pathlist.h"
 
 /* Event list of zebra. */
 enum event { ZEBRA_SERV, ZEBRA_READ, ZEBRA_WRITE };
@@ -250,6 +252,19 @@ zsend_interface_link_params (struct zserv *client, struct interface *ifp)
   return zebra_server_send_message (client);
 }
 
+/* Send an already built TED message (see zebra_ted.c) to a client. */
+int
+zsend_ted_message (struct zserv *client, struct stream *msg)
+{
+  struct stream *s;
+
+  s = client->obuf;
+  stream_reset (s);
+  stream_put (s, STREAM_DATA (msg), stream_get_endp (msg));
+
+  return zebra_server_send_message (client);
+}
+
 /* Interface address is added/deleted. Send ZEBRA_INTERFACE_ADDRESS_ADD or
  * ZEBRA_INTERFACE_ADDRESS_DELETE to the client. 
  *
@@ -869,6 +884,7 @@ zread_ipv4_add (struct zserv *client, u_short length, vrf_id_t vrf_id)
   ifindex_t ifindex;
   u_char ifname_len;
   safi_t safi;	
+  u_int32_t pathlist = 0;
 
 
   /* Get input stream.  */
@@ -942,9 +958,16 @@ zread_ipv4_add (struct zserv *client, u_short length, vrf_id_t vrf_id)
   if (CHECK_FLAG (message, ZAPI_MESSAGE_MTU))
     rib->mtu = stream_getl (s);
 
+  if (CHECK_FLAG (message, ZAPI_MESSAGE_PATHLIST))
+    pathlist = stream_getl (s);
+
   /* Table */
   rib->table=zebrad.rtm_table_default;
   rib_add_ipv4_multipath (&p, rib, safi);
+
+  if (pathlist)
+    zebra_pathlist_attach (client, rib->type, pathlist, AFI_IP, safi, vrf_id,
+                           (struct prefix *) &p);
   return 0;
 }
 
@@ -1136,6 +1159,11 @@ zread_ipv6_add (struct zserv *client, u_short length, vrf_id_t vrf_id)
     api.mtu = stream_getl (s);
   else
     api.mtu = 0;
+
+  if (CHECK_FLAG (api.message, ZAPI_MESSAGE_PATHLIST))
+    api.pathlist = stream_getl (s);
+  else
+    api.pathlist = 0;
     
   if (IN6_IS_ADDR_UNSPECIFIED (&nexthop))
     rib_add_ipv6 (api.type, api.flags, &p, NULL, ifindex,
@@ -1145,6 +1173,10 @@ zread_ipv6_add (struct zserv *client, u_short length, vrf_id_t vrf_id)
     rib_add_ipv6 (api.type, api.flags, &p, &nexthop, ifindex,
                   vrf_id, zebrad.rtm_table_default, api.metric,
                   api.mtu, api.distance, api.safi);
+
+  if (api.pathlist)
+    zebra_pathlist_attach (client, api.type, api.pathlist, AFI_IP6,
+                           api.safi, vrf_id, (struct prefix *) &p);
   return 0;
 }
 
@@ -1293,19 +1325,100 @@ zread_vrf_unregister (struct zserv *client, u_short length, vrf_id_t vrf_id)
   return 0;
 }
 
+/* Routes kept for a restarting protocol */
+static struct zebra_stale
+{
+  u_char proto;
+  struct thread *t_sweep;
+} route_stale[ZEBRA_ROUTE_MAX];
+
+static void
+zebra_stale_sweep (u_char proto, const char *reason)
+{
+  if (route_stale[proto].t_sweep)
+    {
+      thread_cancel (route_stale[proto].t_sweep);
+      route_stale[proto].t_sweep = NULL;
+    }
+  zlog_notice ("%s. %lu stale %s routes removed from the rib", reason,
+               rib_sweep_stale_proto (proto), zebra_route_string (proto));
+}
+
+static int
+zebra_stale_timer (struct thread *thread)
+{
+  struct zebra_stale *stale = THREAD_ARG (thread);
+
+  stale->t_sweep = NULL;
+  zebra_stale_sweep (stale->proto, "graceful restart timed out");
+  return 0;
+}
+
+/* A client about to restart asks for its routes to be kept. */
+static void
+zread_route_preserve (struct zserv *client, u_short length)
+{
+  u_char proto;
+
+  if (length < 5)
+    return;
+
+  proto = stream_getc (client->ibuf);
+  client->stale_time = stream_getl (client->ibuf);
+  if (proto >= ZEBRA_ROUTE_MAX || route_type_oaths[proto] != client->sock)
+    {
+      zlog_warn ("client %d can't preserve %s routes it doesn't own",
+                 client->sock, zebra_route_string (proto));
+      client->stale_time = 0;
+    }
+}
+
+/* The restarted client sent all its routes again. */
+static void
+zread_route_sweep (struct zserv *client, u_short length)
+{
+  u_char proto;
+
+  if (length < 1)
+    return;
+
+  proto = stream_getc (client->ibuf);
+  if (proto >= ZEBRA_ROUTE_MAX || route_type_oaths[proto] != client->sock)
+    {
+      zlog_warn ("client %d can't sweep %s routes it doesn't own",
+                 client->sock, zebra_route_string (proto));
+      return;
+    }
+  zebra_stale_sweep (proto, "graceful restart done");
+}
+
 /* If client sent routes of specific type, zebra removes it
- * and returns number of deleted routes.
+ * and returns number of deleted routes. A client which asked
+ * for it keeps them stale in the rib until it restarts.
  */
 static void
-zebra_score_rib (int client_sock)
+zebra_score_rib (struct zserv *client)
 {
   int i;
 
   for (i = ZEBRA_ROUTE_RIP; i < ZEBRA_ROUTE_MAX; i++)
-    if (client_sock == route_type_oaths[i])
+    if (client->sock == route_type_oaths[i])
       {
-        zlog_notice ("client %d disconnected. %lu %s routes removed from the rib",
-                      client_sock, rib_score_proto (i), zebra_route_string (i));
+        if (client->stale_time)
+          {
+            zlog_notice ("client %d disconnected. %lu %s routes kept in the rib for %u seconds",
+                         client->sock, rib_mark_stale_proto (i),
+                         zebra_route_string (i), client->stale_time);
+            route_stale[i].proto = i;
+            if (route_stale[i].t_sweep)
+              thread_cancel (route_stale[i].t_sweep);
+            route_stale[i].t_sweep =
+              thread_add_timer (zebrad.master, zebra_stale_timer,
+                                &route_stale[i], client->stale_time);
+          }
+        else
+          zlog_notice ("client %d disconnected. %lu %s routes removed from the rib",
+                        client->sock, rib_score_proto (i), zebra_route_string (i));
         route_type_oaths[i] = 0;
         break;
       }
@@ -1315,11 +1428,15 @@ zebra_score_rib (int client_sock)
 static void
 zebra_client_close (struct zserv *client)
 {
+  /* Remove the TE objects this client fed, if any. */
+  zebra_ted_client_close (client);
+  zebra_pathlist_client_close (client);
+
   /* Close file descriptor. */
   if (client->sock)
     {
       close (client->sock);
-      zebra_score_rib (client->sock);
+      zebra_score_rib (client);
       client->sock = -1;
     }
 
@@ -1543,6 +1660,24 @@ zebra_client_read (struct thread *thread)
     case ZEBRA_VRF_UNREGISTER:
       zread_vrf_unregister (client, length, vrf_id);
       break;
+    case ZEBRA_TED_UPDATE:
+      zebra_ted_update (client, length);
+      break;
+    case ZEBRA_TED_SUBSCRIBE:
+      zebra_ted_subscribe (client, length);
+      break;
+    case ZEBRA_ROUTE_PRESERVE:
+      zread_route_preserve (client, length);
+      break;
+    case ZEBRA_ROUTE_SWEEP:
+      zread_route_sweep (client, length);
+      break;
+    case ZEBRA_PATHLIST_ADD:
+      zebra_pathlist_add (client, length);
+      break;
+    case ZEBRA_PATHLIST_DELETE:
+      zebra_pathlist_delete (client, length);
+      break;
     default:
       zlog_info ("Zebra received unknown command %d", command);
       break;
@@ -67,6 +67,13 @@ struct zserv
 
   /* Router-id information. */
   vrf_bitmap_t ridinfo;
+
+  /* Subscribed to the TE database. */
+  u_char ted_subscribed;
+
+  /* Seconds the routes of this client are kept after it goes away,
+     for a graceful restart. */
+  u_int32_t stale_time;
 };
 
 /* Zebra instance */
@@ -112,6 +119,7 @@ extern int zsend_router_id_update (struct zserv *, struct prefix *,
                                    vrf_id_t);
 
 extern int zsend_interface_link_params (struct zserv *, struct interface *);
+extern int zsend_ted_message (struct zserv *, struct stream *);
 
 extern pid_t pid;
 